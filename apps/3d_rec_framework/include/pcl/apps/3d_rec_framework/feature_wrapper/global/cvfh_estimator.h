@@ -47,7 +47,9 @@ namespace pcl
         }
 
         pcl::PointCloud<pcl::Normal>::Ptr normals (new pcl::PointCloud<pcl::Normal>);
-        normal_estimator_->estimate (in, processed, normals);
+        // the mesh resolution is kept local, views may be estimated in parallel
+        float mesh_resolution = 0.f;
+        normal_estimator_->estimate (in, processed, normals, mesh_resolution);
 
         typedef typename pcl::CVFHEstimation<PointInT, pcl::Normal, FeatureT> CVFHEstimation;
         pcl::PointCloud<FeatureT> cvfh_signatures;
@@ -67,8 +69,8 @@ namespace pcl
 
         if (normal_estimator_->compute_mesh_resolution_)
         {
-          radius = normal_estimator_->mesh_resolution_ * normal_estimator_->factor_normals_;
-          cluster_tolerance_radius = normal_estimator_->mesh_resolution_ * 3.f;
+          radius = mesh_resolution * normal_estimator_->factor_normals_;
+          cluster_tolerance_radius = mesh_resolution * 3.f;
 
           if (normal_estimator_->do_voxel_grid_)
           {
@@ -23,11 +23,56 @@ namespace pcl
 
         typename boost::shared_ptr<PreProcessorAndNormalEstimator<PointInT, pcl::Normal> > normal_estimator_;
 
+        /** \brief Number of threads used by estimateViews () */
+        unsigned int threads_;
+
       public:
+        GlobalEstimator () : computed_normals_ (false), normal_estimator_ (), threads_ (1)
+        {
+        }
+
+        virtual
+        ~GlobalEstimator ()
+        {
+        }
+
         virtual void
         estimate (PointInTPtr & in, PointInTPtr & processed, std::vector<pcl::PointCloud<FeatureT>, Eigen::aligned_allocator<
             pcl::PointCloud<FeatureT> > > & signatures, std::vector<Eigen::Vector3f> & centroids)=0;
 
+        /**
+         * \brief Computes the signatures of many views (or segmented clusters) in parallel, each view as estimate () does
+         */
+        virtual void
+        estimateViews (std::vector<PointInTPtr> & in, std::vector<PointInTPtr> & processed,
+                       std::vector<typename pcl::PointCloud<FeatureT>::CloudVectorType> & signatures,
+                       std::vector<std::vector<Eigen::Vector3f> > & centroids)
+        {
+          processed.resize (in.size ());
+          signatures.resize (in.size ());
+          centroids.resize (in.size ());
+
+          const int nr_views = static_cast<int> (in.size ());
+          const int threads = static_cast<int> (threads_);
+#pragma omp parallel for schedule (dynamic, 1) num_threads (threads)
+          for (int v = 0; v < nr_views; ++v)
+          {
+            processed[v].reset (new pcl::PointCloud<PointInT>);
+            signatures[v].clear ();
+            centroids[v].clear ();
+            estimate (in[v], processed[v], signatures[v], centroids[v]);
+          }
+        }
+
+        /**
+         * \brief Sets the number of threads used by estimateViews ()
+         */
+        void
+        setNumberOfThreads (unsigned int nr_threads)
+        {
+          threads_ = (nr_threads == 0) ? 1 : nr_threads;
+        }
+
         virtual bool computedNormals() = 0;
 
         void setNormalEstimator(boost::shared_ptr<PreProcessorAndNormalEstimator<PointInT, pcl::Normal> > & ne) {
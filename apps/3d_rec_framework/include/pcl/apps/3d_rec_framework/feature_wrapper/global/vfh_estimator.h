@@ -37,7 +37,9 @@ namespace pcl
           }
 
           pcl::PointCloud<pcl::Normal>::Ptr normals (new pcl::PointCloud<pcl::Normal>);
-          normal_estimator_->estimate (in, processed, normals);
+          // the mesh resolution is kept local, views may be estimated in parallel
+          float mesh_resolution = 0.f;
+          normal_estimator_->estimate (in, processed, normals, mesh_resolution);
 
           typedef typename pcl::VFHEstimation<PointInT, pcl::Normal, FeatureT> VFHEstimation;
           pcl::PointCloud<FeatureT> vfh_signature;
@@ -109,10 +109,20 @@ namespace pcl
 
         void
         estimate (PointInTPtr & in, PointInTPtr & out, pcl::PointCloud<pcl::Normal>::Ptr & normals)
+        {
+          estimate (in, out, normals, mesh_resolution_);
+        }
+
+        /**
+         * \brief Same as above, but the mesh resolution of the input is returned instead of being stored, so
+         * that several views can be processed at the same time
+         */
+        void
+        estimate (PointInTPtr & in, PointInTPtr & out, pcl::PointCloud<pcl::Normal>::Ptr & normals, float & mesh_resolution)
         {
           if (compute_mesh_resolution_)
           {
-            mesh_resolution_ = computeMeshResolution (in);
+            mesh_resolution = computeMeshResolution (in);
           }
 
           if (do_voxel_grid_)
@@ -120,7 +130,7 @@ namespace pcl
             float voxel_grid_size = grid_resolution_;
             if (compute_mesh_resolution_)
             {
-              voxel_grid_size = mesh_resolution_ * factor_voxel_grid_;
+              voxel_grid_size = mesh_resolution * factor_voxel_grid_;
             }
 
             pcl::VoxelGrid<PointInT> grid_;
@@ -145,7 +155,7 @@ namespace pcl
             float radius= normal_radius_;
             if (compute_mesh_resolution_)
             {
-              radius = mesh_resolution_ * factor_normals_;
+              radius = mesh_resolution * factor_normals_;
               if (do_voxel_grid_)
                 radius *= factor_voxel_grid_;
             }
@@ -171,7 +181,7 @@ namespace pcl
           float radius = normal_radius_;
           if (compute_mesh_resolution_)
           {
-            radius = mesh_resolution_ * factor_normals_;
+            radius = mesh_resolution * factor_normals_;
             if (do_voxel_grid_)
               radius *= factor_voxel_grid_;
           }
@@ -107,6 +107,10 @@ namespace pcl
         nearestKSearch (flann::Index<DistT> * index, const flann_model &model, int k, flann::Matrix<int> &indices, flann::Matrix<float> &distances);
 
         int NN_;
+
+        /** \brief Number of threads used to compute the signatures of the training views */
+        unsigned int threads_;
+
         std::vector<std::string> categories_;
         std::vector<float> confidences_;
 
@@ -117,6 +121,7 @@ namespace pcl
         GlobalNNPipeline ()
         {
           NN_ = 1;
+          threads_ = 1;
         }
 
         ~GlobalNNPipeline ()
@@ -129,6 +134,15 @@ namespace pcl
           NN_ = nn;
         }
 
+        /**
+         * \brief Sets the number of threads used by initialize () to compute the signatures of the training views
+         */
+        void
+        setNumberOfThreads (unsigned int nr_threads)
+        {
+          threads_ = (nr_threads == 0) ? 1 : nr_threads;
+        }
+
         void
         getCategory (std::vector<std::string> & categories)
         {
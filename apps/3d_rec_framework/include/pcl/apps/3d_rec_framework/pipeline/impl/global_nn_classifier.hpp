@@ -182,13 +182,18 @@ template<template<class > class Distance, typename PointInT, typename FeatureT>
     {
       if (!source_->modelAlreadyTrained (models->at (i), training_dir_, descr_name_))
       {
+        //compute the signatures of all the views at once, in parallel
+        std::vector<PointInTPtr> processed_views;
+        std::vector<typename pcl::PointCloud<FeatureT>::CloudVectorType> view_signatures;
+        std::vector < std::vector<Eigen::Vector3f> > view_centroids;
+        estimator_->setNumberOfThreads (threads_);
+        estimator_->estimateViews (*models->at (i).views_, processed_views, view_signatures, view_centroids);
+
         for (size_t v = 0; v < models->at (i).views_->size (); v++)
         {
-          PointInTPtr processed (new pcl::PointCloud<PointInT>);
-          //pro view, compute signatures
-          typename pcl::PointCloud<FeatureT>::CloudVectorType signatures;
-          std::vector < Eigen::Vector3f > centroids;
-          estimator_->estimate (models->at (i).views_->at (v), processed, signatures, centroids);
+          PointInTPtr & processed = processed_views[v];
+          typename pcl::PointCloud<FeatureT>::CloudVectorType & signatures = view_signatures[v];
+          std::vector < Eigen::Vector3f > & centroids = view_centroids[v];
 
           //source_->makeModelPersistent (models->at (i), training_dir_, descr_name_, static_cast<int> (v));
           std::string path = source_->getModelDescriptorDir (models->at (i), training_dir_, descr_name_);
@@ -130,7 +130,7 @@ segmentAndClassify (typename pcl::rec_3d_framework::GlobalNNPipeline<DistT, Poin
   }
 }
 
-//bin/pcl_global_classification -models_dir /home/aitor/data/3d-net_one_class/ -descriptor_name esf -training_dir /home/aitor/data/3d-net_one_class_trained_level_1 -nn 10
+//bin/pcl_global_classification -models_dir /home/aitor/data/3d-net_one_class/ -descriptor_name esf -training_dir /home/aitor/data/3d-net_one_class_trained_level_1 -nn 10 -threads 4
 
 int
 main (int argc, char ** argv)
@@ -140,11 +140,13 @@ main (int argc, char ** argv)
   std::string desc_name = "esf";
   std::string training_dir = "trained_models/";
   int NN = 1;
+  unsigned int threads = 1;
 
   pcl::console::parse_argument (argc, argv, "-models_dir", path);
   pcl::console::parse_argument (argc, argv, "-training_dir", training_dir);
   pcl::console::parse_argument (argc, argv, "-descriptor_name", desc_name);
   pcl::console::parse_argument (argc, argv, "-nn", NN);
+  pcl::console::parse_argument (argc, argv, "-threads", threads);
 
   //pcl::console::parse_argument (argc, argv, "-z_dist", chop_at_z_);
   //pcl::console::parse_argument (argc, argv, "-tesselation_level", views_level_);
@@ -182,6 +184,7 @@ main (int argc, char ** argv)
     global.setTrainingDir (training_dir);
     global.setDescriptorName (desc_name);
     global.setNN (NN);
+    global.setNumberOfThreads (threads);
     global.setFeatureEstimator (cast_estimator);
     global.initialize (true);
 
@@ -203,6 +206,7 @@ main (int argc, char ** argv)
     global.setDescriptorName (desc_name);
     global.setFeatureEstimator (cast_estimator);
     global.setNN (NN);
+    global.setNumberOfThreads (threads);
     global.initialize (false);
 
     segmentAndClassify<Metrics::HistIntersectionUnionDistance, pcl::PointXYZ, pcl::VFHSignature308> (global);
@@ -222,6 +226,7 @@ main (int argc, char ** argv)
     global.setDescriptorName (desc_name);
     global.setFeatureEstimator (cast_estimator);
     global.setNN (NN);
+    global.setNumberOfThreads (threads);
     global.initialize (false);
 
     segmentAndClassify<flann::L1, pcl::PointXYZ, pcl::ESFSignature640> (global);
@@ -57,7 +57,11 @@ class OpenNIChangeViewer
     OpenNIChangeViewer (double resolution, int mode, int noise_filter)
       : viewer ("PCL OpenNI Viewer")
     {
-      octree = new pcl::octree::OctreePointCloudChangeDetector<pcl::PointXYZRGBA>(resolution);
+      // memory for a VGA frame is allocated once - no allocations during streaming
+      octree = new pcl::octree::OctreePointCloudStreamingChangeDetector<pcl::PointXYZRGBA>(resolution, 640*480, 640*480);
+      octree->setNumberOfThreads (boost::thread::hardware_concurrency ());
+      newPointIdxVector.reset (new std::vector<int>);
+      newPointIdxVector->reserve (640*480);
       mode_ = mode;
       noise_filter_ = noise_filter;
     }
@@ -73,8 +77,7 @@ class OpenNIChangeViewer
       // add points from cloud to octree
       octree->addPointsFromInputCloud ();
 
-      std::cerr << octree->getLeafCount() << " -- ";
-      boost::shared_ptr<std::vector<int> > newPointIdxVector (new std::vector<int>);
+      std::cerr << octree->getVoxelCount() << " -- ";
 
       // get a vector of new points, which did not exist in previous buffer
       octree->getPointIndicesFromNewVoxels (*newPointIdxVector, noise_filter_);
@@ -134,7 +137,8 @@ class OpenNIChangeViewer
       interface->stop ();
     }
 
-    pcl::octree::OctreePointCloudChangeDetector<pcl::PointXYZRGBA> *octree;
+    pcl::octree::OctreePointCloudStreamingChangeDetector<pcl::PointXYZRGBA> *octree;
+    boost::shared_ptr<std::vector<int> > newPointIdxVector;
     pcl::visualization::CloudViewer viewer;
 
     int mode_;
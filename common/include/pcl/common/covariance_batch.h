@@ -0,0 +1,161 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_COMMON_COVARIANCE_BATCH_H_
+#define PCL_COMMON_COVARIANCE_BATCH_H_
+
+#include <pcl/pcl_macros.h>
+#include <pcl/point_cloud.h>
+#include <Eigen/StdVector>
+
+#include <vector>
+
+namespace pcl
+{
+  /** \brief A batch of symmetric positive semi definite 3x3 matrices, such as the covariance matrices of the
+    * neighborhoods of many points, whose eigenvalues and eigenvectors are computed together.
+    *
+    * The matrices are stored as a structure of arrays in groups of four. With SSE, solve () decomposes a whole
+    * group in the lanes of the vector registers: the eigenvalues are found with a fixed number of approximate
+    * Jacobi sweeps, which need no branches and no divisions, the requested eigenvector from the cross products of
+    * the rows of the shifted matrix, as in eigen33 (), and its eigenvalue is refined with the Rayleigh quotient.
+    * Without SSE every matrix is decomposed with eigen33 ().
+    * \ingroup common
+    */
+  class PCL_EXPORTS CovarianceMatrixBatch
+  {
+    public:
+      /** \brief Empty constructor. */
+      CovarianceMatrixBatch () : size_ (0), matrices_ (), eigenvalues_ (), eigenvectors_ () {}
+
+      /** \brief Remove all matrices, keeping the allocated memory for the next batch. */
+      inline void
+      clear () { size_ = 0; }
+
+      /** \brief Get the number of matrices in the batch. */
+      inline size_t
+      size () const { return (size_); }
+
+      /** \brief Add a matrix to the batch. Only its upper triangle is used.
+        * \param[in] matrix the symmetric matrix
+        */
+      void
+      push_back (const Eigen::Matrix3f &matrix);
+
+      /** \brief Compute the covariance matrix of a neighborhood of points and add it to the batch, unless the
+        * neighborhood does not contain a finite point.
+        * \param[in] cloud the input point cloud
+        * \param[in] indices the indices of the neighborhood in the cloud
+        * \return the number of valid points used, the matrix is added only if it is not 0
+        */
+      template <typename PointT> unsigned int
+      addNeighborhood (const pcl::PointCloud<PointT> &cloud, const std::vector<int> &indices);
+
+      /** \brief Compute the eigenvalues of all matrices and one of their eigenvectors.
+        * \param[in] eigenvector the eigenvector to compute: 0 for the smallest eigenvalue, 1 for the middle one and
+        * 2 for the largest one
+        */
+      void
+      solve (int eigenvector = 0);
+
+      /** \brief Get the eigenvalues of a matrix in ascending order, after solve ().
+        * \param[in] index the index of the matrix in the batch
+        */
+      inline Eigen::Vector3f
+      getEigenValues (size_t index) const
+      {
+        const float *values = &eigenvalues_[(index / 4) * 12 + index % 4];
+        return (Eigen::Vector3f (values[0], values[4], values[8]));
+      }
+
+      /** \brief Get the eigenvector of a matrix selected in solve ().
+        * \param[in] index the index of the matrix in the batch
+        */
+      inline Eigen::Vector3f
+      getEigenVector (size_t index) const
+      {
+        const float *vector = &eigenvectors_[(index / 4) * 12 + index % 4];
+        return (Eigen::Vector3f (vector[0], vector[4], vector[8]));
+      }
+
+      /** \brief Get the normal of the plane fitted to a neighborhood and the surface curvature, as
+        * solvePlaneParameters () does, after solve (0).
+        * \param[in] index the index of the matrix in the batch
+        * \param[out] nx the resultant X component of the plane normal
+        * \param[out] ny the resultant Y component of the plane normal
+        * \param[out] nz the resultant Z component of the plane normal
+        * \param[out] curvature the estimated surface curvature as a measure of
+        * \f[
+        * \lambda_0 / (\lambda_0 + \lambda_1 + \lambda_2)
+        * \f]
+        */
+      inline void
+      getPlaneParameters (size_t index, float &nx, float &ny, float &nz, float &curvature) const
+      {
+        const size_t offset = (index / 4) * 12 + index % 4;
+        nx = eigenvectors_[offset];
+        ny = eigenvectors_[offset + 4];
+        nz = eigenvectors_[offset + 8];
+
+        const float *matrix = &matrices_[(index / 4) * 24 + index % 4];
+        const float eig_sum = matrix[0] + matrix[12] + matrix[20];
+        if (eig_sum != 0)
+          curvature = fabsf (eigenvalues_[offset] / eig_sum);
+        else
+          curvature = 0;
+      }
+
+    private:
+      /** \brief The number of matrices in the batch. */
+      size_t size_;
+
+      /** \brief The coefficients xx, xy, xz, yy, yz and zz of the matrices, for groups of 4 matrices. */
+      std::vector<float, Eigen::aligned_allocator<float> > matrices_;
+
+      /** \brief The eigenvalues of the matrices in ascending order, for groups of 4 matrices. */
+      std::vector<float, Eigen::aligned_allocator<float> > eigenvalues_;
+
+      /** \brief The x, y and z components of the computed eigenvector of the matrices, for groups of 4 matrices. */
+      std::vector<float, Eigen::aligned_allocator<float> > eigenvectors_;
+  };
+}
+
+#include <pcl/common/impl/covariance_batch.hpp>
+
+#endif  //#ifndef PCL_COMMON_COVARIANCE_BATCH_H_
@@ -0,0 +1,210 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_COMMON_MORTON_IMPL_H_
+#define PCL_COMMON_MORTON_IMPL_H_
+
+#include <pcl/common/morton.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Compute Morton or Hilbert keys of all points of a cloud.
+      * \param[in] cloud the input point cloud
+      * \param[out] keys the resultant keys
+      * \param[in] hilbert compute Hilbert indices if true, Morton codes otherwise
+      * \param[in] nr_threads the number of threads to use
+      */
+    template <typename PointT> void
+    computeCurveKeys (const pcl::PointCloud<PointT> &cloud, std::vector<uint64_t> &keys,
+                      bool hilbert, unsigned int nr_threads)
+    {
+      const int nr_points = static_cast<int> (cloud.points.size ());
+      const int threads = static_cast<int> (std::max (nr_threads, 1u));
+      const uint64_t invalid_key = std::numeric_limits<uint64_t>::max ();
+
+      keys.resize (nr_points);
+
+      // bounding box of the finite points - reduced over contiguous blocks
+      std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f> > block_min (threads), block_max (threads);
+
+#pragma omp parallel for schedule (static, 1) num_threads (threads)
+      for (int b = 0; b < threads; ++b)
+      {
+        Eigen::Vector3f min_pt = Eigen::Vector3f::Constant (std::numeric_limits<float>::max ());
+        Eigen::Vector3f max_pt = Eigen::Vector3f::Constant (-std::numeric_limits<float>::max ());
+
+        const int end = static_cast<int> ((static_cast<int64_t> (nr_points) * (b + 1)) / threads);
+        for (int i = static_cast<int> ((static_cast<int64_t> (nr_points) * b) / threads); i < end; ++i)
+        {
+          const PointT &p = cloud.points[i];
+          if (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z))
+            continue;
+          min_pt = min_pt.cwiseMin (p.getVector3fMap ());
+          max_pt = max_pt.cwiseMax (p.getVector3fMap ());
+        }
+        block_min[b] = min_pt;
+        block_max[b] = max_pt;
+      }
+
+      Eigen::Vector3f min_pt = block_min[0], max_pt = block_max[0];
+      for (int b = 1; b < threads; ++b)
+      {
+        min_pt = min_pt.cwiseMin (block_min[b]);
+        max_pt = max_pt.cwiseMax (block_max[b]);
+      }
+
+      // quantize the largest extent to 21 bits, keeping the aspect ratio of the cells
+      const double max_cell = static_cast<double> ((1u << 21) - 1);
+      const double extent = (min_pt.x () <= max_pt.x ()) ? (max_pt - min_pt).maxCoeff () : 0.0;
+      const double scale = (extent > 0.0) ? max_cell / extent : 0.0;
+
+#pragma omp parallel for num_threads (threads)
+      for (int i = 0; i < nr_points; ++i)
+      {
+        const PointT &p = cloud.points[i];
+        if (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z))
+        {
+          keys[i] = invalid_key;
+          continue;
+        }
+
+        const uint32_t x = static_cast<uint32_t> (std::min ((p.x - min_pt.x ()) * scale, max_cell));
+        const uint32_t y = static_cast<uint32_t> (std::min ((p.y - min_pt.y ()) * scale, max_cell));
+        const uint32_t z = static_cast<uint32_t> (std::min ((p.z - min_pt.z ()) * scale, max_cell));
+
+        keys[i] = hilbert ? pcl::encodeHilbert3D (x, y, z) : pcl::encodeMorton3D (x, y, z);
+      }
+    }
+
+    /** \brief Sort the points of a cloud by their keys.
+      * \param[in] cloud_in the input point cloud
+      * \param[in,out] keys the keys of the points, sorted on return
+      * \param[out] cloud_out the reordered point cloud
+      * \param[out] indices_map the permutation
+      * \param[in] nr_threads the number of threads to use
+      */
+    template <typename PointT> void
+    reorderByKeys (const pcl::PointCloud<PointT> &cloud_in, std::vector<uint64_t> &keys,
+                   pcl::PointCloud<PointT> &cloud_out, std::vector<int> &indices_map, unsigned int nr_threads)
+    {
+      const int nr_points = static_cast<int> (cloud_in.points.size ());
+
+      indices_map.resize (nr_points);
+      for (int i = 0; i < nr_points; ++i)
+        indices_map[i] = i;
+
+      pcl::radixSortKeys (keys, indices_map, nr_threads);
+
+      typename pcl::PointCloud<PointT>::VectorType points (nr_points);
+
+#pragma omp parallel for num_threads (std::max (nr_threads, 1u))
+      for (int i = 0; i < nr_points; ++i)
+        points[i] = cloud_in.points[indices_map[i]];
+
+      cloud_out.header              = cloud_in.header;
+      cloud_out.is_dense            = cloud_in.is_dense;
+      cloud_out.sensor_origin_      = cloud_in.sensor_origin_;
+      cloud_out.sensor_orientation_ = cloud_in.sensor_orientation_;
+      cloud_out.points.swap (points);
+      cloud_out.width  = static_cast<uint32_t> (nr_points);
+      cloud_out.height = 1;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::computeMortonKeys (const pcl::PointCloud<PointT> &cloud, std::vector<uint64_t> &keys,
+                        unsigned int nr_threads)
+{
+  pcl::detail::computeCurveKeys (cloud, keys, false, nr_threads);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::computeHilbertKeys (const pcl::PointCloud<PointT> &cloud, std::vector<uint64_t> &keys,
+                         unsigned int nr_threads)
+{
+  pcl::detail::computeCurveKeys (cloud, keys, true, nr_threads);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::reorderMorton (const pcl::PointCloud<PointT> &cloud_in, pcl::PointCloud<PointT> &cloud_out,
+                    std::vector<int> &indices_map, unsigned int nr_threads)
+{
+  std::vector<uint64_t> keys;
+  pcl::detail::computeCurveKeys (cloud_in, keys, false, nr_threads);
+  pcl::detail::reorderByKeys (cloud_in, keys, cloud_out, indices_map, nr_threads);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::reorderHilbert (const pcl::PointCloud<PointT> &cloud_in, pcl::PointCloud<PointT> &cloud_out,
+                     std::vector<int> &indices_map, unsigned int nr_threads)
+{
+  std::vector<uint64_t> keys;
+  pcl::detail::computeCurveKeys (cloud_in, keys, true, nr_threads);
+  pcl::detail::reorderByKeys (cloud_in, keys, cloud_out, indices_map, nr_threads);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::restoreOriginalOrder (const pcl::PointCloud<PointT> &cloud_in, const std::vector<int> &indices_map,
+                           pcl::PointCloud<PointT> &cloud_out)
+{
+  assert (cloud_in.points.size () == indices_map.size ());
+
+  typename pcl::PointCloud<PointT>::VectorType points (indices_map.size ());
+  for (size_t i = 0; i < indices_map.size (); ++i)
+    points[indices_map[i]] = cloud_in.points[i];
+
+  cloud_out.header   = cloud_in.header;
+  cloud_out.is_dense = cloud_in.is_dense;
+  cloud_out.points.swap (points);
+  cloud_out.width    = static_cast<uint32_t> (cloud_out.points.size ());
+  cloud_out.height   = 1;
+}
+
+#endif  //#ifndef PCL_COMMON_MORTON_IMPL_H_
@@ -0,0 +1,146 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_COMMON_MORTON_H_
+#define PCL_COMMON_MORTON_H_
+
+#include <pcl/pcl_macros.h>
+#include <pcl/point_cloud.h>
+
+#include <vector>
+
+namespace pcl
+{
+  /** \brief Compute the 63 bit Morton (Z-order) code of a quantized 3D coordinate. The lower 21 bits of every
+    * coordinate are interleaved, x being the most significant axis.
+    * \param[in] x quantized x coordinate
+    * \param[in] y quantized y coordinate
+    * \param[in] z quantized z coordinate
+    * \return Morton code
+    * \ingroup common
+    */
+  PCL_EXPORTS uint64_t
+  encodeMorton3D (uint32_t x, uint32_t y, uint32_t z);
+
+  /** \brief Compute the 63 bit Hilbert curve index of a quantized 3D coordinate (21 bits per axis). Cells with
+    * consecutive Hilbert indices are face-adjacent.
+    * \param[in] x quantized x coordinate
+    * \param[in] y quantized y coordinate
+    * \param[in] z quantized z coordinate
+    * \return Hilbert index
+    * \ingroup common
+    */
+  PCL_EXPORTS uint64_t
+  encodeHilbert3D (uint32_t x, uint32_t y, uint32_t z);
+
+  /** \brief Sort a vector of 64 bit keys together with a vector of indices using a stable LSD radix sort. Every
+    * pass builds per-thread histograms of contiguous blocks and scatters the blocks in parallel. Passes over digits
+    * which are equal for all keys are skipped.
+    * \param[in,out] keys the keys to sort
+    * \param[in,out] indices the indices to permute together with the keys (same size as keys)
+    * \param[in] nr_threads the number of threads to use
+    * \ingroup common
+    */
+  PCL_EXPORTS void
+  radixSortKeys (std::vector<uint64_t> &keys, std::vector<int> &indices, unsigned int nr_threads = 1);
+
+  /** \brief Compute the Morton codes of all points of a cloud. Point coordinates are quantized to 21 bits per axis
+    * within the bounding box of the finite points. Points with non-finite coordinates get the largest possible key.
+    * \param[in] cloud the input point cloud
+    * \param[out] keys the resultant Morton codes, one per point
+    * \param[in] nr_threads the number of threads to use
+    * \ingroup common
+    */
+  template <typename PointT> void
+  computeMortonKeys (const pcl::PointCloud<PointT> &cloud, std::vector<uint64_t> &keys,
+                     unsigned int nr_threads = 1);
+
+  /** \brief Compute the Hilbert curve indices of all points of a cloud. Point coordinates are quantized to 21 bits
+    * per axis within the bounding box of the finite points. Points with non-finite coordinates get the largest
+    * possible key.
+    * \param[in] cloud the input point cloud
+    * \param[out] keys the resultant Hilbert indices, one per point
+    * \param[in] nr_threads the number of threads to use
+    * \ingroup common
+    */
+  template <typename PointT> void
+  computeHilbertKeys (const pcl::PointCloud<PointT> &cloud, std::vector<uint64_t> &keys,
+                      unsigned int nr_threads = 1);
+
+  /** \brief Reorder the points of a cloud along the Morton (Z-order) curve, so that points which are close in space
+    * are close in memory. This improves the cache locality of neighbor queries on clouds in scan order.
+    * \param[in] cloud_in the input point cloud
+    * \param[out] cloud_out the reordered point cloud (unorganized, non-finite points are moved to the end)
+    * \param[out] indices_map the permutation: cloud_out.points[i] == cloud_in.points[indices_map[i]]
+    * \param[in] nr_threads the number of threads to use
+    * \note Can be used with cloud_in equal to cloud_out
+    * \ingroup common
+    */
+  template <typename PointT> void
+  reorderMorton (const pcl::PointCloud<PointT> &cloud_in, pcl::PointCloud<PointT> &cloud_out,
+                 std::vector<int> &indices_map, unsigned int nr_threads = 1);
+
+  /** \brief Reorder the points of a cloud along the Hilbert curve. Compared to reorderMorton, the Hilbert curve
+    * has no jumps between distant cells, at the cost of a more expensive key computation.
+    * \param[in] cloud_in the input point cloud
+    * \param[out] cloud_out the reordered point cloud (unorganized, non-finite points are moved to the end)
+    * \param[out] indices_map the permutation: cloud_out.points[i] == cloud_in.points[indices_map[i]]
+    * \param[in] nr_threads the number of threads to use
+    * \note Can be used with cloud_in equal to cloud_out
+    * \ingroup common
+    */
+  template <typename PointT> void
+  reorderHilbert (const pcl::PointCloud<PointT> &cloud_in, pcl::PointCloud<PointT> &cloud_out,
+                  std::vector<int> &indices_map, unsigned int nr_threads = 1);
+
+  /** \brief Map a cloud computed on a reordered cloud (e.g., normals or features) back to the original point order.
+    * \param[in] cloud_in the cloud in reordered point order
+    * \param[in] indices_map the permutation returned by reorderMorton or reorderHilbert
+    * \param[out] cloud_out the cloud in original point order
+    * \note The organization (width, height) of the original cloud is not restored.
+    * \ingroup common
+    */
+  template <typename PointT> void
+  restoreOriginalOrder (const pcl::PointCloud<PointT> &cloud_in, const std::vector<int> &indices_map,
+                        pcl::PointCloud<PointT> &cloud_out);
+}
+
+#include <pcl/common/impl/morton.hpp>
+
+#endif  //#ifndef PCL_COMMON_MORTON_H_
@@ -945,14 +945,19 @@ RangeImage::getNormalForClosestNeighbors (int x, int y, Eigen::Vector3f& normal,
   return getNormalForClosestNeighbors (x, y, radius, getPoint (x,y).getVector3fMap (), no_of_nearest_neighbors, normal);
 }
 
-namespace 
-{  // Anonymous namespace, so that this is only accessible in this file
-  struct NeighborWithDistance 
-  {  // local struct to help us with sorting
-    float distance;
-    const PointWithRange* neighbor;
-    bool operator < (const NeighborWithDistance& other) const { return distance<other.distance;}
-  };
+/////////////////////////////////////////////////////////////////////////
+bool 
+RangeImage::getSurfaceInformation (int x, int y, int radius, const Eigen::Vector3f& point, int no_of_closest_neighbors, int step_size,
+                                   float& max_closest_neighbor_distance_squared,
+                                   Eigen::Vector3f& normal, Eigen::Vector3f& mean, Eigen::Vector3f& eigen_values,
+                                   Eigen::Vector3f* normal_all_neighbors, Eigen::Vector3f* mean_all_neighbors,
+                                   Eigen::Vector3f* eigen_values_all_neighbors) const
+{
+  std::vector<NeighborWithDistance> ordered_neighbors;
+  return (getSurfaceInformation (x, y, radius, point, no_of_closest_neighbors, step_size,
+                                 max_closest_neighbor_distance_squared, normal, mean, eigen_values,
+                                 normal_all_neighbors, mean_all_neighbors, eigen_values_all_neighbors,
+                                 ordered_neighbors));
 }
 
 /////////////////////////////////////////////////////////////////////////
@@ -961,7 +966,8 @@ RangeImage::getSurfaceInformation (int x, int y, int radius, const Eigen::Vector
                                    float& max_closest_neighbor_distance_squared,
                                    Eigen::Vector3f& normal, Eigen::Vector3f& mean, Eigen::Vector3f& eigen_values,
                                    Eigen::Vector3f* normal_all_neighbors, Eigen::Vector3f* mean_all_neighbors,
-                                   Eigen::Vector3f* eigen_values_all_neighbors) const
+                                   Eigen::Vector3f* eigen_values_all_neighbors,
+                                   std::vector<NeighborWithDistance>& ordered_neighbors) const
 {
   max_closest_neighbor_distance_squared=0.0f;
   normal.setZero (); mean.setZero (); eigen_values.setZero ();
@@ -977,7 +983,8 @@ RangeImage::getSurfaceInformation (int x, int y, int radius, const Eigen::Vector
   PointWithRange given_point;
   given_point.x=point[0];  given_point.y=point[1];  given_point.z=point[2];
   
-  std::vector<NeighborWithDistance> ordered_neighbors (blocksize);
+  if (static_cast<int> (ordered_neighbors.size ()) < blocksize)
+    ordered_neighbors.resize (blocksize);
   int neighbor_counter = 0;
   for (int y2=y-radius; y2<=y+radius; y2+=step_size)
   {
@@ -67,6 +67,14 @@ namespace pcl
         LASER_FRAME  = 1
       };
 
+      // =====PUBLIC STRUCTS=====
+      //! A neighbor of a point in the image together with its squared distance, used to sort neighborhoods
+      struct NeighborWithDistance
+      {
+        float distance;
+        const PointWithRange* neighbor;
+        bool operator < (const NeighborWithDistance& other) const { return distance<other.distance;}
+      };
       
       // =====CONSTRUCTOR & DESTRUCTOR=====
       /** Constructor */
@@ -554,6 +562,18 @@ namespace pcl
                              Eigen::Vector3f* mean_all_neighbors=NULL,
                              Eigen::Vector3f* eigen_values_all_neighbors=NULL) const;
       
+      /** Same as above, but sorts the neighbors in the given buffer instead of allocating one for every call, so
+       * that loops over the whole image can keep one buffer per thread */
+      inline bool
+      getSurfaceInformation (int x, int y, int radius, const Eigen::Vector3f& point,
+                             int no_of_closest_neighbors, int step_size,
+                             float& max_closest_neighbor_distance_squared,
+                             Eigen::Vector3f& normal, Eigen::Vector3f& mean, Eigen::Vector3f& eigen_values,
+                             Eigen::Vector3f* normal_all_neighbors,
+                             Eigen::Vector3f* mean_all_neighbors,
+                             Eigen::Vector3f* eigen_values_all_neighbors,
+                             std::vector<NeighborWithDistance>& ordered_neighbors) const;
+      
       // Return the squared distance to the n-th neighbors of the point at x,y
       inline float
       getSquaredDistanceOfNthNeighbor (int x, int y, int radius, int n, int step_size) const;
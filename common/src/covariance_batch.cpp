@@ -0,0 +1,293 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <pcl/common/covariance_batch.h>
+#include <pcl/common/eigen.h>
+#include <limits>
+#ifdef __SSE__
+#include <xmmintrin.h>
+
+namespace
+{
+  /** \brief Compute an eigenvector for a repeated eigenvalue. The rows of the shifted matrix are (nearly) parallel
+    * then, and any vector orthogonal to them is an eigenvector.
+    * \param[in] coefficients the coefficients of the matrix in a group of the batch, see CovarianceMatrixBatch
+    * \param[in] eigenvalue the eigenvalue
+    */
+  Eigen::Vector3f
+  computeRepeatedEigenVector (const float *coefficients, float eigenvalue)
+  {
+    Eigen::Matrix3f shifted;
+    shifted << coefficients[0], coefficients[4], coefficients[8],
+               coefficients[4], coefficients[12], coefficients[16],
+               coefficients[8], coefficients[16], coefficients[20];
+    shifted.diagonal ().array () -= eigenvalue;
+    int row;
+    if (shifted.rowwise ().squaredNorm ().maxCoeff (&row) > 0)
+      return (shifted.row (row).transpose ().unitOrthogonal ());
+    return (Eigen::Vector3f::UnitX ());
+  }
+
+  /** \brief Select the lanes of a where the mask is set and the lanes of b elsewhere. */
+  inline __m128
+  select (__m128 mask, __m128 a, __m128 b)
+  {
+    return (_mm_or_ps (_mm_and_ps (mask, a), _mm_andnot_ps (mask, b)));
+  }
+
+  /** \brief Apply an approximate Jacobi rotation to 4 symmetric matrices, reducing their coefficients a_pq. The
+    * rotation angle is derived from the tangent of a quarter of the angle which zeroes a_pq, which needs a single
+    * reciprocal square root and no division (McAdams et al., Computing the Singular Value Decomposition of 3x3
+    * matrices with minimal branching and elementary floating point operations, 2011).
+    * \param[in,out] app the diagonal coefficients p
+    * \param[in,out] aqq the diagonal coefficients q
+    * \param[in,out] apq the coefficients to reduce
+    * \param[in,out] arp the coefficients between the third row r and p
+    * \param[in,out] arq the coefficients between the third row r and q
+    */
+  inline void
+  rotate (__m128 &app, __m128 &aqq, __m128 &apq, __m128 &arp, __m128 &arq)
+  {
+    const __m128 sign_mask = _mm_set1_ps (-0.0f);
+    const __m128 half = _mm_set1_ps (0.5f);
+    const __m128 three_halves = _mm_set1_ps (1.5f);
+    // (1 + sqrt (2))^2, and the cosine and sine of pi / 8
+    const __m128 gamma = _mm_set1_ps (5.828427124f);
+    const __m128 cos_pi_8 = _mm_set1_ps (0.9238795325f);
+    const __m128 sin_pi_8 = _mm_set1_ps (0.3826834324f);
+
+    // Half angle cosine and sine, up to a common factor
+    __m128 ch = _mm_sub_ps (app, aqq);
+    ch = _mm_add_ps (ch, ch);
+    __m128 sh = apq;
+    const __m128 norm = _mm_add_ps (_mm_mul_ps (ch, ch), _mm_mul_ps (sh, sh));
+    __m128 w = _mm_rsqrt_ps (norm);
+    w = _mm_mul_ps (w, _mm_sub_ps (three_halves, _mm_mul_ps (_mm_mul_ps (half, norm), _mm_mul_ps (w, w))));
+
+    // Angles larger than pi / 4 are clamped, keeping the direction of the rotation
+    const __m128 accurate = _mm_cmplt_ps (_mm_mul_ps (gamma, _mm_mul_ps (sh, sh)), _mm_mul_ps (ch, ch));
+    const __m128 sign = _mm_and_ps (sign_mask, _mm_xor_ps (ch, sh));
+    ch = select (accurate, _mm_mul_ps (w, ch), cos_pi_8);
+    sh = select (accurate, _mm_mul_ps (w, sh), _mm_or_ps (sin_pi_8, sign));
+
+    const __m128 c = _mm_sub_ps (_mm_mul_ps (ch, ch), _mm_mul_ps (sh, sh));
+    const __m128 s = _mm_mul_ps (_mm_add_ps (ch, ch), sh);
+    const __m128 cc = _mm_mul_ps (c, c);
+    const __m128 ss = _mm_mul_ps (s, s);
+    const __m128 cs = _mm_mul_ps (c, s);
+    const __m128 two_cs_apq = _mm_mul_ps (_mm_add_ps (cs, cs), apq);
+
+    const __m128 pp = app;
+    app = _mm_add_ps (_mm_add_ps (_mm_mul_ps (cc, pp), two_cs_apq), _mm_mul_ps (ss, aqq));
+    apq = _mm_add_ps (_mm_mul_ps (cs, _mm_sub_ps (aqq, pp)), _mm_mul_ps (_mm_sub_ps (cc, ss), apq));
+    aqq = _mm_add_ps (_mm_sub_ps (_mm_mul_ps (ss, pp), two_cs_apq), _mm_mul_ps (cc, aqq));
+    const __m128 rp = arp;
+    arp = _mm_add_ps (_mm_mul_ps (c, rp), _mm_mul_ps (s, arq));
+    arq = _mm_sub_ps (_mm_mul_ps (c, arq), _mm_mul_ps (s, rp));
+  }
+
+  /** \brief Compute the cross product of two vectors of 4 lanes. */
+  inline void
+  cross (const __m128 a[3], const __m128 b[3], __m128 result[3])
+  {
+    result[0] = _mm_sub_ps (_mm_mul_ps (a[1], b[2]), _mm_mul_ps (a[2], b[1]));
+    result[1] = _mm_sub_ps (_mm_mul_ps (a[2], b[0]), _mm_mul_ps (a[0], b[2]));
+    result[2] = _mm_sub_ps (_mm_mul_ps (a[0], b[1]), _mm_mul_ps (a[1], b[0]));
+  }
+
+  /** \brief Compute the squared norm of a vector of 4 lanes. */
+  inline __m128
+  squaredNorm (const __m128 v[3])
+  {
+    return (_mm_add_ps (_mm_add_ps (_mm_mul_ps (v[0], v[0]), _mm_mul_ps (v[1], v[1])), _mm_mul_ps (v[2], v[2])));
+  }
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::CovarianceMatrixBatch::push_back (const Eigen::Matrix3f &matrix)
+{
+  const size_t group = size_ / 4;
+  const size_t lane = size_ % 4;
+  if (matrices_.size () < (group + 1) * 24)
+  {
+    matrices_.resize ((group + 1) * 24, 0.0f);
+    eigenvalues_.resize ((group + 1) * 12, 0.0f);
+    eigenvectors_.resize ((group + 1) * 12, 0.0f);
+  }
+
+  float *coefficients = &matrices_[group * 24 + lane];
+  coefficients[0] = matrix.coeff (0, 0);
+  coefficients[4] = matrix.coeff (0, 1);
+  coefficients[8] = matrix.coeff (0, 2);
+  coefficients[12] = matrix.coeff (1, 1);
+  coefficients[16] = matrix.coeff (1, 2);
+  coefficients[20] = matrix.coeff (2, 2);
+  ++size_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::CovarianceMatrixBatch::solve (int eigenvector)
+{
+#ifdef __SSE__
+  const size_t nr_groups = (size_ + 3) / 4;
+  const __m128 sign_mask = _mm_set1_ps (-0.0f);
+  const __m128 one = _mm_set1_ps (1.0f);
+  const __m128 min_scale = _mm_set1_ps (std::numeric_limits<float>::min ());
+
+  // The off diagonal coefficients become tiny during the Jacobi sweeps, avoid slow denormal arithmetic
+  const unsigned int flush_zero_mode = _MM_GET_FLUSH_ZERO_MODE ();
+  _MM_SET_FLUSH_ZERO_MODE (_MM_FLUSH_ZERO_ON);
+
+  for (size_t group = 0; group < nr_groups; ++group)
+  {
+    const float *coefficients = &matrices_[group * 24];
+    __m128 m00 = _mm_load_ps (coefficients);
+    __m128 m01 = _mm_load_ps (coefficients + 4);
+    __m128 m02 = _mm_load_ps (coefficients + 8);
+    __m128 m11 = _mm_load_ps (coefficients + 12);
+    __m128 m12 = _mm_load_ps (coefficients + 16);
+    __m128 m22 = _mm_load_ps (coefficients + 20);
+
+    // Scale the matrices so their entries are in [-1,1], as eigen33 () does
+    __m128 scale = _mm_max_ps (_mm_max_ps (_mm_andnot_ps (sign_mask, m00), _mm_andnot_ps (sign_mask, m01)),
+                               _mm_max_ps (_mm_andnot_ps (sign_mask, m02), _mm_andnot_ps (sign_mask, m11)));
+    scale = _mm_max_ps (scale, _mm_max_ps (_mm_andnot_ps (sign_mask, m12), _mm_andnot_ps (sign_mask, m22)));
+    scale = select (_mm_cmple_ps (scale, min_scale), one, scale);
+    const __m128 inverse_scale = _mm_div_ps (one, scale);
+    m00 = _mm_mul_ps (m00, inverse_scale);
+    m01 = _mm_mul_ps (m01, inverse_scale);
+    m02 = _mm_mul_ps (m02, inverse_scale);
+    m11 = _mm_mul_ps (m11, inverse_scale);
+    m12 = _mm_mul_ps (m12, inverse_scale);
+    m22 = _mm_mul_ps (m22, inverse_scale);
+
+    // Diagonalize a copy of the matrices with four cyclic sweeps of approximate Jacobi rotations
+    __m128 d0 = m00, d1 = m11, d2 = m22, o01 = m01, o02 = m02, o12 = m12;
+    for (int sweep = 0; sweep < 4; ++sweep)
+    {
+      rotate (d0, d1, o01, o02, o12);
+      rotate (d0, d2, o02, o01, o12);
+      rotate (d1, d2, o12, o01, o02);
+    }
+
+    // Sort the eigenvalues in ascending order
+    const __m128 low01 = _mm_min_ps (d0, d1);
+    const __m128 high01 = _mm_max_ps (d0, d1);
+    const __m128 lowest = _mm_min_ps (low01, d2);
+    const __m128 other = _mm_max_ps (low01, d2);
+    const __m128 middle = _mm_min_ps (high01, other);
+    const __m128 highest = _mm_max_ps (high01, other);
+    float *values = &eigenvalues_[group * 12];
+    _mm_store_ps (values, _mm_mul_ps (lowest, scale));
+    _mm_store_ps (values + 4, _mm_mul_ps (middle, scale));
+    _mm_store_ps (values + 8, _mm_mul_ps (highest, scale));
+
+    // The eigenvector is orthogonal to the rows of the matrix minus the eigenvalue times the identity
+    const __m128 eigenvalue = (eigenvector == 0 ? lowest : (eigenvector == 1 ? middle : highest));
+    const __m128 row0[3] = { _mm_sub_ps (m00, eigenvalue), m01, m02 };
+    const __m128 row1[3] = { m01, _mm_sub_ps (m11, eigenvalue), m12 };
+    const __m128 row2[3] = { m02, m12, _mm_sub_ps (m22, eigenvalue) };
+    __m128 vec1[3], vec2[3], vec3[3];
+    cross (row0, row1, vec1);
+    cross (row0, row2, vec2);
+    cross (row1, row2, vec3);
+    const __m128 len1 = squaredNorm (vec1);
+    const __m128 len2 = squaredNorm (vec2);
+    const __m128 len3 = squaredNorm (vec3);
+
+    const __m128 use1 = _mm_and_ps (_mm_cmpge_ps (len1, len2), _mm_cmpge_ps (len1, len3));
+    const __m128 use2 = _mm_andnot_ps (use1, _mm_cmpge_ps (len2, len3));
+    const __m128 squared_length = select (use1, len1, select (use2, len2, len3));
+    const __m128 length = _mm_sqrt_ps (squared_length);
+    float *vector = &eigenvectors_[group * 12];
+    for (int d = 0; d < 3; ++d)
+      _mm_store_ps (vector + 4 * d, _mm_div_ps (select (use1, vec1[d], select (use2, vec2[d], vec3[d])), length));
+
+    // If the eigenvalue is (nearly) repeated, the rows of the shifted matrix are (nearly) parallel and their cross
+    // products are dominated by rounding errors: any vector orthogonal to the rows is an eigenvector then
+    const __m128 row_norm = _mm_max_ps (_mm_max_ps (squaredNorm (row0), squaredNorm (row1)), squaredNorm (row2));
+    const int degenerate = _mm_movemask_ps (_mm_cmple_ps (squared_length,
+                                                          _mm_mul_ps (_mm_mul_ps (row_norm, row_norm), _mm_set1_ps (1e-8f))));
+    for (int lane = 0; lane < 4; ++lane)
+    {
+      if (!(degenerate & (1 << lane)))
+        continue;
+      const Eigen::Vector3f orthogonal = computeRepeatedEigenVector (coefficients + lane, values[4 * eigenvector + lane]);
+      for (int d = 0; d < 3; ++d)
+        vector[4 * d + lane] = orthogonal[d];
+    }
+
+    // The Rayleigh quotient of the eigenvector refines its eigenvalue
+    const __m128 x = _mm_load_ps (vector);
+    const __m128 y = _mm_load_ps (vector + 4);
+    const __m128 z = _mm_load_ps (vector + 8);
+    const __m128 off_diagonal = _mm_add_ps (_mm_add_ps (_mm_mul_ps (m01, _mm_mul_ps (x, y)),
+                                                        _mm_mul_ps (m02, _mm_mul_ps (x, z))),
+                                            _mm_mul_ps (m12, _mm_mul_ps (y, z)));
+    const __m128 diagonal = _mm_add_ps (_mm_add_ps (_mm_mul_ps (m00, _mm_mul_ps (x, x)), _mm_mul_ps (m11, _mm_mul_ps (y, y))),
+                                        _mm_mul_ps (m22, _mm_mul_ps (z, z)));
+    _mm_store_ps (values + 4 * eigenvector,
+                  _mm_mul_ps (_mm_add_ps (diagonal, _mm_add_ps (off_diagonal, off_diagonal)), scale));
+  }
+  _MM_SET_FLUSH_ZERO_MODE (flush_zero_mode);
+#else
+  for (size_t index = 0; index < size_; ++index)
+  {
+    const size_t group = index / 4;
+    const size_t lane = index % 4;
+    const float *coefficients = &matrices_[group * 24 + lane];
+    Eigen::Matrix3f matrix;
+    matrix << coefficients[0], coefficients[4], coefficients[8],
+              coefficients[4], coefficients[12], coefficients[16],
+              coefficients[8], coefficients[16], coefficients[20];
+
+    Eigen::Matrix3f evecs;
+    Eigen::Vector3f evals;
+    pcl::eigen33 (matrix, evecs, evals);
+    for (int d = 0; d < 3; ++d)
+    {
+      eigenvalues_[group * 12 + 4 * d + lane] = evals[d];
+      eigenvectors_[group * 12 + 4 * d + lane] = evecs (d, eigenvector);
+    }
+  }
+#endif
+}
@@ -0,0 +1,181 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <pcl/common/morton.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+  /** \brief Spread the lower 21 bits of a value to every third bit. */
+  inline pcl::uint64_t
+  spreadBits (pcl::uint64_t value)
+  {
+    pcl::uint64_t x = value & 0x1FFFFFULL;
+    x = (x | (x << 32)) & 0x1F00000000FFFFULL;
+    x = (x | (x << 16)) & 0x1F0000FF0000FFULL;
+    x = (x | (x << 8))  & 0x100F00F00F00F00FULL;
+    x = (x | (x << 4))  & 0x10C30C30C30C30C3ULL;
+    x = (x | (x << 2))  & 0x1249249249249249ULL;
+    return (x);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::uint64_t
+pcl::encodeMorton3D (uint32_t x, uint32_t y, uint32_t z)
+{
+  return ((spreadBits (x) << 2) | (spreadBits (y) << 1) | spreadBits (z));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::uint64_t
+pcl::encodeHilbert3D (uint32_t x, uint32_t y, uint32_t z)
+{
+  // J. Skilling, "Programming the Hilbert curve", AIP Conf. Proc. 707, 2004:
+  // transform the coordinates to the transposed Hilbert index and interleave its bits
+  const uint32_t bits = 21;
+  const uint32_t mask = (1u << bits) - 1;
+  uint32_t X[3] = {x & mask, y & mask, z & mask};
+
+  // inverse undo excess work
+  for (uint32_t Q = 1u << (bits - 1); Q > 1; Q >>= 1)
+  {
+    const uint32_t P = Q - 1;
+    for (int i = 0; i < 3; ++i)
+    {
+      if (X[i] & Q)
+        X[0] ^= P;
+      else
+      {
+        const uint32_t t = (X[0] ^ X[i]) & P;
+        X[0] ^= t;
+        X[i] ^= t;
+      }
+    }
+  }
+
+  // gray encode
+  X[1] ^= X[0];
+  X[2] ^= X[1];
+
+  uint32_t t = 0;
+  for (uint32_t Q = 1u << (bits - 1); Q > 1; Q >>= 1)
+    if (X[2] & Q)
+      t ^= Q - 1;
+
+  for (int i = 0; i < 3; ++i)
+    X[i] ^= t;
+
+  return (encodeMorton3D (X[0], X[1], X[2]));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::radixSortKeys (std::vector<uint64_t> &keys, std::vector<int> &indices, unsigned int nr_threads)
+{
+  assert (keys.size () == indices.size ());
+
+  const int nr_keys = static_cast<int> (keys.size ());
+  if (nr_keys < 2)
+    return;
+
+  // do not split small inputs into many blocks
+  const int min_block_size = 16384;
+  const int threads = std::max (1, std::min (static_cast<int> (nr_threads), nr_keys / min_block_size));
+
+  std::vector<int> block_begin (threads + 1);
+  for (int b = 0; b <= threads; ++b)
+    block_begin[b] = static_cast<int> ((static_cast<int64_t> (nr_keys) * b) / threads);
+
+  std::vector<uint64_t> keys_tmp (nr_keys);
+  std::vector<int> indices_tmp (nr_keys);
+  std::vector<int> histograms (threads * 256);
+
+  for (int shift = 0; shift < 64; shift += 8)
+  {
+    // count the digits of every block
+#pragma omp parallel for schedule (static, 1) num_threads (threads)
+    for (int b = 0; b < threads; ++b)
+    {
+      int *histogram = &histograms[b * 256];
+      std::fill (histogram, histogram + 256, 0);
+      for (int i = block_begin[b]; i < block_begin[b + 1]; ++i)
+        ++histogram[(keys[i] >> shift) & 0xFF];
+    }
+
+    // skip passes in which all keys share the same digit
+    const int first_digit = static_cast<int> ((keys[0] >> shift) & 0xFF);
+    int digit_count = 0;
+    for (int b = 0; b < threads; ++b)
+      digit_count += histograms[b * 256 + first_digit];
+    if (digit_count == nr_keys)
+      continue;
+
+    // exclusive prefix sum, digit-major and block-minor to keep the sort stable
+    int offset = 0;
+    for (int d = 0; d < 256; ++d)
+    {
+      for (int b = 0; b < threads; ++b)
+      {
+        const int count = histograms[b * 256 + d];
+        histograms[b * 256 + d] = offset;
+        offset += count;
+      }
+    }
+
+    // scatter every block to its output positions
+#pragma omp parallel for schedule (static, 1) num_threads (threads)
+    for (int b = 0; b < threads; ++b)
+    {
+      int *positions = &histograms[b * 256];
+      for (int i = block_begin[b]; i < block_begin[b + 1]; ++i)
+      {
+        const int pos = positions[(keys[i] >> shift) & 0xFF]++;
+        keys_tmp[pos] = keys[i];
+        indices_tmp[pos] = indices[i];
+      }
+    }
+
+    keys.swap (keys_tmp);
+    indices.swap (indices_tmp);
+  }
+}
+
@@ -46,6 +46,7 @@
 #include <pcl/point_cloud.h>
 
 #include <pcl/common/centroid.h>
+#include <pcl/common/morton.h>
 
 using namespace pcl;
 
@@ -962,6 +963,141 @@ TEST (PCL, SetIfFieldExists)
 //  pcl::for_each_type<pcl::traits::fieldList<pcl::PFHSignature125>::type> (pcl::SetIfFieldExists<pcl::PFHSignature125, float*> (p2, "intensity", 3.0));
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, SpaceFillingCurveKeys)
+{
+  // Morton codes interleave the coordinate bits, x being the most significant axis
+  EXPECT_EQ (encodeMorton3D (0, 0, 0), static_cast<uint64_t> (0));
+  EXPECT_EQ (encodeMorton3D (1, 0, 0), static_cast<uint64_t> (4));
+  EXPECT_EQ (encodeMorton3D (0, 1, 0), static_cast<uint64_t> (2));
+  EXPECT_EQ (encodeMorton3D (0, 0, 1), static_cast<uint64_t> (1));
+  EXPECT_EQ (encodeMorton3D (3, 3, 3), static_cast<uint64_t> (63));
+  EXPECT_EQ (encodeMorton3D (0x1FFFFF, 0x1FFFFF, 0x1FFFFF), (static_cast<uint64_t> (1) << 63) - 1);
+
+  // Hilbert indices of a 16^3 grid form a permutation, consecutive cells are face-adjacent
+  const uint32_t shift = 21 - 4;
+  std::vector<std::pair<uint64_t, uint32_t> > cells;
+  for (uint32_t x = 0; x < 16; ++x)
+    for (uint32_t y = 0; y < 16; ++y)
+      for (uint32_t z = 0; z < 16; ++z)
+        cells.push_back (std::make_pair (encodeHilbert3D (x << shift, y << shift, z << shift) >> (3 * shift),
+                                         (x << 8) | (y << 4) | z));
+  std::sort (cells.begin (), cells.end ());
+  for (size_t i = 0; i < cells.size (); ++i)
+  {
+    EXPECT_EQ (cells[i].first, static_cast<uint64_t> (i));
+    if (i == 0)
+      continue;
+    const uint32_t a = cells[i - 1].second, b = cells[i].second;
+    const int dist = abs (static_cast<int> (a >> 8) - static_cast<int> (b >> 8)) +
+                     abs (static_cast<int> ((a >> 4) & 15) - static_cast<int> ((b >> 4) & 15)) +
+                     abs (static_cast<int> (a & 15) - static_cast<int> (b & 15));
+    EXPECT_EQ (dist, 1);
+  }
+
+  // radix sort equals a stable comparison sort, independent of the number of threads
+  std::vector<uint64_t> keys (100000);
+  std::vector<std::pair<uint64_t, int> > reference (keys.size ());
+  srand (42);
+  for (size_t i = 0; i < keys.size (); ++i)
+  {
+    keys[i] = (static_cast<uint64_t> (rand ()) << 40) ^ (static_cast<uint64_t> (rand () % 64) << 20);
+    reference[i] = std::make_pair (keys[i], static_cast<int> (i));
+  }
+  std::stable_sort (reference.begin (), reference.end ());
+
+  for (unsigned int threads = 1; threads <= 4; threads *= 4)
+  {
+    std::vector<uint64_t> sorted_keys = keys;
+    std::vector<int> indices (keys.size ());
+    for (size_t i = 0; i < indices.size (); ++i)
+      indices[i] = static_cast<int> (i);
+
+    radixSortKeys (sorted_keys, indices, threads);
+    for (size_t i = 0; i < keys.size (); ++i)
+    {
+      EXPECT_EQ (sorted_keys[i], reference[i].first);
+      EXPECT_EQ (indices[i], reference[i].second);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, reorderMorton)
+{
+  PointCloud<PointXYZ> cloud;
+  cloud.width = 64;
+  cloud.height = 48;
+  cloud.is_dense = false;
+  for (uint32_t v = 0; v < cloud.height; ++v)
+    for (uint32_t u = 0; u < cloud.width; ++u)
+      cloud.points.push_back (PointXYZ (static_cast<float> (u) * 0.01f,
+                                        static_cast<float> (v) * 0.01f,
+                                        1.0f + 0.1f * static_cast<float> (rand ()) / static_cast<float> (RAND_MAX)));
+  cloud.points[10].x = std::numeric_limits<float>::quiet_NaN ();
+
+  for (int curve = 0; curve < 2; ++curve)
+  {
+    PointCloud<PointXYZ> reordered;
+    std::vector<int> indices_map;
+    if (curve == 0)
+      reorderMorton (cloud, reordered, indices_map, 2);
+    else
+      reorderHilbert (cloud, reordered, indices_map, 2);
+
+    ASSERT_EQ (reordered.points.size (), cloud.points.size ());
+    ASSERT_EQ (indices_map.size (), cloud.points.size ());
+    EXPECT_EQ (reordered.height, 1u);
+    EXPECT_EQ (reordered.width, cloud.points.size ());
+
+    // the permutation maps the reordered points to the input points
+    std::vector<int> histogram (cloud.points.size (), 0);
+    for (size_t i = 0; i < indices_map.size (); ++i)
+    {
+      ++histogram[indices_map[i]];
+      if (indices_map[i] != 10)
+      {
+        EXPECT_EQ (reordered.points[i].x, cloud.points[indices_map[i]].x);
+        EXPECT_EQ (reordered.points[i].y, cloud.points[indices_map[i]].y);
+        EXPECT_EQ (reordered.points[i].z, cloud.points[indices_map[i]].z);
+      }
+    }
+    for (size_t i = 0; i < histogram.size (); ++i)
+      EXPECT_EQ (histogram[i], 1);
+
+    // the non-finite point is moved to the end
+    EXPECT_EQ (indices_map.back (), 10);
+
+    // keys of the reordered cloud are sorted
+    std::vector<uint64_t> keys;
+    if (curve == 0)
+      computeMortonKeys (reordered, keys);
+    else
+      computeHilbertKeys (reordered, keys);
+    for (size_t i = 1; i < keys.size (); ++i)
+      EXPECT_LE (keys[i - 1], keys[i]);
+
+    // restore the original order
+    PointCloud<PointXYZ> restored;
+    restoreOriginalOrder (reordered, indices_map, restored);
+    ASSERT_EQ (restored.points.size (), cloud.points.size ());
+    for (size_t i = 0; i < cloud.points.size (); ++i)
+    {
+      if (i == 10)
+        continue;
+      EXPECT_EQ (restored.points[i].x, cloud.points[i].x);
+      EXPECT_EQ (restored.points[i].z, cloud.points[i].z);
+    }
+  }
+
+  // in-place reordering
+  PointCloud<PointXYZ> inplace = cloud;
+  std::vector<int> indices_map;
+  reorderMorton (inplace, inplace, indices_map);
+  ASSERT_EQ (inplace.points.size (), cloud.points.size ());
+  EXPECT_EQ (inplace.points[0].y, cloud.points[indices_map[0]].y);
+}
+
 //* ---[ */
 int
 main (int argc, char** argv)
@@ -42,6 +42,7 @@
 #include <boost/random/variate_generator.hpp>
 #include <pcl/point_types.h>
 #include <pcl/common/eigen.h>
+#include <pcl/common/covariance_batch.h>
 
 using namespace pcl;
 using namespace std;
@@ -800,6 +801,57 @@ TEST (PCL, eigen33f)
   EXPECT_LE (float(r_fail_count) / float(iterations), 0.01);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// the batched solver is checked like eigen33f: some matrices are bad conditioned in float, so only the failure rate
+// is checked
+TEST (PCL, CovarianceMatrixBatch)
+{
+  const float epsilon = 1e-3f;
+  const unsigned iterations = 100003;
+
+  std::vector<Eigen::Matrix3f, Eigen::aligned_allocator<Eigen::Matrix3f> > matrices (iterations);
+  CovarianceMatrixBatch batch;
+  for (unsigned idx = 0; idx < iterations; ++idx)
+  {
+    generateSymPosMatrix3x3 (matrices[idx]);
+    batch.push_back (matrices[idx]);
+  }
+  EXPECT_EQ (batch.size (), iterations);
+
+  for (int k = 0; k < 3; k += 2)
+  {
+    batch.solve (k);
+
+    unsigned fail_count = 0;
+    for (unsigned idx = 0; idx < iterations; ++idx)
+    {
+      Eigen::Vector3d eigenvalues;
+      pcl::eigen33 (Eigen::Matrix3d (matrices[idx].cast<double> ()), eigenvalues);
+      const Eigen::Vector3f vector = batch.getEigenVector (idx);
+
+      // the eigenvalues match the ones in double precision, and the eigenvector is a unit eigenvector
+      bool failed = ((batch.getEigenValues (idx).cast<double> () - eigenvalues).cwiseAbs ().sum () > epsilon);
+      failed |= ((matrices[idx] * vector - batch.getEigenValues (idx)[k] * vector).cwiseAbs ().sum () > epsilon);
+      failed |= (fabs (vector.norm () - 1.0f) > epsilon);
+      if (failed)
+        ++fail_count;
+    }
+    EXPECT_LE (float (fail_count) / float (iterations), 0.01);
+  }
+
+  // the plane parameters are the smallest eigenvector and the curvature
+  batch.clear ();
+  Eigen::Matrix3f covariance_matrix = Eigen::Vector3f (1.0f, 0.25f, 0.01f).asDiagonal ();
+  batch.push_back (covariance_matrix);
+  batch.solve (0);
+  float nx, ny, nz, curvature;
+  batch.getPlaneParameters (0, nx, ny, nz, curvature);
+  EXPECT_NEAR (fabs (nz), 1.0f, 1e-5);
+  EXPECT_NEAR (nx, 0.0f, 1e-5);
+  EXPECT_NEAR (ny, 0.0f, 1e-5);
+  EXPECT_NEAR (curvature, 0.01f / 1.26f, 1e-6);
+}
+
 /* ---[ */
 int
 main (int argc, char** argv)
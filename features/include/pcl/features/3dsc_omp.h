@@ -0,0 +1,132 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FEATURES_3DSC_OMP_H_
+#define PCL_FEATURES_3DSC_OMP_H_
+
+#include <pcl/point_types.h>
+#include <pcl/features/3dsc.h>
+#include <pcl/features/shape_context_binning.h>
+
+namespace pcl
+{
+  /** \brief ShapeContext3DEstimationOMP estimates the 3D shape context descriptor of a point cloud in parallel,
+    * using the OpenMP standard. See ShapeContext3DEstimation for the descriptor and its conventions.
+    *
+    * The neighborhoods of the query points are searched once, in parallel, and the local point density of every
+    * surface point they contain is counted once, instead of once per neighborhood the point belongs to. The
+    * neighbors are then binned by ShapeContextBinning, without calling acos or atan2 per neighbor. The random X
+    * axes are drawn in the order of the query points before the threads start, so the descriptors equal those of
+    * ShapeContext3DEstimation with the same seed, up to float rounding on the bin boundaries.
+    *
+    * \author Alessandro Franchi, Samuele Salti, Federico Tombari (original code)
+    * \ingroup features
+    */
+  template <typename PointInT, typename PointNT, typename PointOutT = pcl::ShapeContext>
+  class ShapeContext3DEstimationOMP : public ShapeContext3DEstimation<PointInT, PointNT, PointOutT>
+  {
+    public:
+      using Feature<PointInT, PointOutT>::feature_name_;
+      using Feature<PointInT, PointOutT>::getClassName;
+      using Feature<PointInT, PointOutT>::indices_;
+      using Feature<PointInT, PointOutT>::search_radius_;
+      using Feature<PointInT, PointOutT>::surface_;
+      using Feature<PointInT, PointOutT>::input_;
+      using FeatureFromNormals<PointInT, PointNT, PointOutT>::normals_;
+      using ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::radii_interval_;
+      using ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::theta_divisions_;
+      using ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::phi_divisions_;
+      using ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::volume_lut_;
+      using ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::azimuth_bins_;
+      using ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::elevation_bins_;
+      using ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::radius_bins_;
+      using ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::point_density_radius_;
+      using ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::descriptor_length_;
+      using ShapeContext3DEstimation<PointInT, PointNT, PointOutT>::rnd;
+
+      typedef typename Feature<PointInT, PointOutT>::PointCloudOut PointCloudOut;
+      typedef typename Feature<PointInT, PointOutT>::PointCloudIn PointCloudIn;
+
+      /** \brief Constructor.
+        * \param[in] random If true the random seed is set to current time, else it is
+        * set to 12345 prior to computing the descriptor (used to select X axis)
+        * \param[in] nr_threads the number of hardware threads to use
+        */
+      ShapeContext3DEstimationOMP (bool random = false, unsigned int nr_threads = 1) :
+        ShapeContext3DEstimation<PointInT, PointNT, PointOutT> (random),
+        threads_ (1), binning_ ()
+      {
+        feature_name_ = "ShapeContext3DEstimationOMP";
+        setNumberOfThreads (nr_threads);
+      }
+
+      /** \brief Set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        if (nr_threads == 0)
+          nr_threads = 1;
+        threads_ = nr_threads;
+      }
+
+    protected:
+      /** \brief Estimate the 3D shape context descriptors of all the query points.
+        * \param[out] output the resultant feature
+        */
+      void
+      computeFeature (PointCloudOut &output);
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
+      /** \brief Bins the neighbors, with the tables filled from the intervals computed by initCompute (). */
+      ShapeContextBinning binning_;
+
+    private:
+      /** \brief Make the computeFeature (&Eigen::MatrixXf); inaccessible from outside the class
+        * \param[out] output the output point cloud
+        */
+      void
+      computeFeatureEigen (pcl::PointCloud<Eigen::MatrixXf> &) {}
+  };
+}
+
+#endif  //#ifndef PCL_FEATURES_3DSC_OMP_H_
@@ -74,7 +74,7 @@ namespace pcl
 
       /** \brief Constructor. */
       CRHEstimation () :
-        vpx_ (0), vpy_ (0), vpz_ (0), nbins_ (90)
+        vpx_ (0), vpy_ (0), vpz_ (0), nbins_ (90), centroid_ (Eigen::Vector4f::Zero ()), use_given_centroid_ (false)
       {
         k_ = 1;
         feature_name_ = "CRHEstimation";
@@ -107,10 +107,15 @@ namespace pcl
         vpz = vpz_;
       }
 
+      /** \brief Set the centroid the roll angle is measured around. If no centroid is given, the centroid of the
+       * input points is used, so the same estimator can describe many clusters.
+       * \param[in] centroid the centroid
+       */
       inline void
       setCentroid (Eigen::Vector4f & centroid)
       {
         centroid_ = centroid;
+        use_given_centroid_ = true;
       }
 
     private:
@@ -125,6 +130,9 @@ namespace pcl
       /** \brief Centroid to be used */
       Eigen::Vector4f centroid_;
 
+      /** \brief Use centroid_ instead of the centroid of the input points. */
+      bool use_given_centroid_;
+
       /** \brief Estimate the CRH histogram at
        * a set of points given by <setInputCloud (), setIndices ()> using the surface in
        * setSearchSurface ()
@@ -42,7 +42,6 @@
 #include <pcl/features/feature.h>
 #define GRIDSIZE 64
 #define GRIDSIZE_H GRIDSIZE/2
-//#include <boost/multi_array.hpp>
 #include <vector>
 
 namespace pcl
@@ -71,21 +70,29 @@ namespace pcl
       typedef typename Feature<PointInT, PointOutT>::PointCloudOut PointCloudOut;
 
       /** \brief Empty constructor. */
-      ESFEstimation () : lut_ (), local_cloud_ ()
+      ESFEstimation () : lut_ (GRIDSIZE * GRIDSIZE * GRIDSIZE, 0), local_cloud_ (), seed_ (0), threads_ (1)
       {
         feature_name_ = "ESFEstimation";
-        lut_.resize (GRIDSIZE);
-        for (int i = 0; i < GRIDSIZE; ++i)
-        {
-          lut_[i].resize (GRIDSIZE);
-          for (int j = 0; j < GRIDSIZE; ++j)
-            lut_[i][j].resize (GRIDSIZE);
-        }
-        //lut_.resize (boost::extents[GRIDSIZE][GRIDSIZE][GRIDSIZE]);
         search_radius_ = 0;
         k_ = 5;
       }
 
+      /** \brief Set the seed of the random sampling of the point triples. The same seed gives the same descriptor
+        * for the same cloud, whatever the number of threads.
+        * \param[in] seed the seed (default: 0)
+        */
+      inline void
+      setRandomSeed (unsigned int seed) { seed_ = seed; }
+
+      /** \brief Initialize the scheduler and set the number of threads used to evaluate the samples.
+        * \param[in] nr_threads the number of hardware threads to use
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        threads_ = (nr_threads == 0) ? 1 : nr_threads;
+      }
+
       /** \brief Estimate the Ensebmel of Shape Function (ESF) descriptors at a set of points given by
         * <setInputCloud (),
         * \param output the resultant point cloud model histogram that contains the ESF feature estimates
@@ -99,7 +106,7 @@ namespace pcl
       int
       lci (const int x1, const int y1, const int z1, 
            const int x2, const int y2, const int z2, 
-           float &ratio, int &incnt, int &pointcount);
+           float &ratio, int &incnt, int &pointcount) const;
      
       /** \brief ... */
       void
@@ -117,15 +124,51 @@ namespace pcl
       void
       scale_points_unit_sphere (const pcl::PointCloud<PointInT> &pc, float scalefactor, Eigen::Vector4f& centroid);
 
+      /** \brief Get the voxel of a coordinate of a point scaled by scale_points_unit_sphere ().
+        * \param[in] value the coordinate
+        */
+      static inline int
+      toGrid (float value)
+      {
+        return (value < 0.0f ? static_cast<int> (floor (value) + GRIDSIZE_H) : static_cast<int> (ceil (value) + GRIDSIZE_H - 1));
+      }
+
+      /** \brief Get the position of a voxel in lut_. */
+      static inline int
+      lutIndex (int x, int y, int z)
+      {
+        return ((x * GRIDSIZE + y) * GRIDSIZE + z);
+      }
+
+      /** \brief Draw a point index. The random numbers are a hash of the seed and of the number of the draw, so
+        * every sample draws the same points whichever thread evaluates it, and in whatever order.
+        * \param[in] counter the number of the draw
+        * \param[in] max_index the number of points
+        */
+      inline int
+      randomIndex (uint64_t counter, int max_index) const
+      {
+        uint64_t hash = (static_cast<uint64_t> (seed_) << 32) + (counter + 1) * 0x9E3779B97F4A7C15ULL;
+        hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+        hash ^= hash >> 31;
+        return (static_cast<int> (((hash >> 32) * static_cast<uint64_t> (max_index)) >> 32));
+      }
+
     private:
 
-      /** \brief ... */
-      //boost::multi_array<int, 3> lut_;
-      std::vector<std::vector<std::vector<int> > > lut_;
+      /** \brief The occupancy of the GRIDSIZE^3 voxels, see lutIndex (). */
+      std::vector<unsigned char> lut_;
       
       /** \brief ... */
       PointCloudIn local_cloud_;
 
+      /** \brief The seed of the random sampling. */
+      unsigned int seed_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
       /** \brief Make the computeFeature (&Eigen::MatrixXf); inaccessible from outside the class
         * \param[out] output the output point cloud
         */
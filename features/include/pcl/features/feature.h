@@ -295,6 +295,22 @@ namespace pcl
         return (search_method_surface_ (cloud, index, parameter, indices, distances));
       }
 
+      /** \brief Search the neighborhoods of all the query points in parallel, once, and store them in a compressed
+        * row buffer: the neighbors of the query point idx are at nn_offsets[idx] .. nn_offsets[idx + 1] - 1 in
+        * \a nn_indices and \a nn_dists. Query points which are not finite, have no neighbors or are excluded by
+        * \a skip_queries get an empty neighborhood.
+        * \param[in] parameter the search parameter (either k or radius)
+        * \param[in] nr_threads the number of threads to use
+        * \param[out] nn_offsets the first neighbor of every query point, followed by the total number of neighbors
+        * \param[out] nn_indices the indices of the neighbors in the surface
+        * \param[out] nn_dists the squared distances of the neighbors to their query point
+        * \param[in] skip_queries if not empty, the query points to leave out are nonzero
+        */
+      void
+      searchForNeighborhoods (double parameter, unsigned int nr_threads, std::vector<int> &nn_offsets,
+                              std::vector<int> &nn_indices, std::vector<float> &nn_dists,
+                              const std::vector<unsigned char> &skip_queries = std::vector<unsigned char> ()) const;
+
     private:
       /** \brief Abstract feature estimation method.
         * \param[out] output the resultant features
@@ -456,7 +472,7 @@ namespace pcl
       typedef typename PointCloudLRF::ConstPtr PointCloudLRFConstPtr;
 
       /** \brief Empty constructor. */
-      FeatureWithLocalReferenceFrames () : frames_ (), frames_never_defined_ (true) {}
+      FeatureWithLocalReferenceFrames () : frames_ (), frames_never_defined_ (true), default_frames_checksum_ (0) {}
 
        /** \brief Empty destructor. */
       virtual ~FeatureWithLocalReferenceFrames () {}
@@ -465,6 +481,13 @@ namespace pcl
         * reference frames of the XYZ dataset.
         * In case of search surface is set to be different from the input cloud,
         * local reference frames should correspond to the input cloud, not the search surface!
+        *
+        * The frames computed by one estimator can be shared with the others which use the same
+        * kind of frames on the same keypoints, e.g. SHOT, USC and BOARD-based pipelines:
+        * \code
+        * shot.compute (*descriptors);
+        * usc.setInputReferenceFrames (shot.getInputReferenceFrames ());
+        * \endcode
         * \param[in] frames the const boost shared pointer to a PointCloud of reference frames.
         */
       inline void
@@ -474,7 +497,9 @@ namespace pcl
         frames_never_defined_ = false;
       }
 
-      /** \brief Get a pointer to the local reference frames. */
+      /** \brief Get a pointer to the local reference frames, either the ones given by the user or the
+        * ones estimated by default during the last call to compute ().
+        */
       inline PointCloudLRFConstPtr
       getInputReferenceFrames () const
       {
@@ -486,8 +511,12 @@ namespace pcl
       PointCloudLRFConstPtr frames_;
       /** \brief The user has never set the frames. */
       bool frames_never_defined_;
+      /** \brief Checksum of the data from which the default frames in frames_ were estimated, or 0. */
+      uint64_t default_frames_checksum_;
 
       /** \brief Check if frames_ has been correctly initialized and compute it if needed.
+        * Frames estimated by default are kept as long as the input cloud, the indices, the search
+        * surface and the search parameters of the estimator stay the same.
         * \param input the subclass' input cloud dataset.
         * \param lrf_estimation a pointer to a local reference frame estimation class to be used as default.
         * \return true if frames_ has been correctly initialized.
@@ -496,6 +525,13 @@ namespace pcl
       virtual bool
       initLocalReferenceFrames (const size_t& indices_size,
                                 const LRFEstimationPtr& lrf_estimation = LRFEstimationPtr());
+
+      /** \brief Compute a checksum of the points, the indices, the search surface and the search
+        * parameters of a local reference frame estimator, to check whether its output changed.
+        * \param[in] lrf_estimation the local reference frame estimator
+        */
+      static uint64_t
+      computeFramesChecksum (const LRFEstimationPtr& lrf_estimation);
   };
 }
 
@@ -0,0 +1,348 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FEATURE_PIPELINE_H_
+#define PCL_FEATURE_PIPELINE_H_
+
+#include <pcl/features/feature.h>
+#include <pcl/features/feature_stage.h>
+
+namespace pcl
+{
+  /** \brief NeighborhoodCache answers the radius searches around the points of a cloud from neighborhoods
+    * computed once, for the largest radius needed, by keeping the neighbors which lie within the requested
+    * radius. All other searches are forwarded to the search method the neighborhoods were computed with.
+    *
+    * Alternatively, the cache can hold a k nearest neighbor graph computed elsewhere, e.g. the one saved by
+    * StatisticalOutlierRemoval::setSaveNeighbors (). It then answers the k nearest neighbor searches around the
+    * points of the graph for any k up to the length of their neighbor lists, so that normal estimation with
+    * Feature::setKSearch () reuses the graph instead of searching again:
+    * \code
+    * sor.setSaveNeighbors (true);
+    * sor.filter (*filtered);
+    * typename pcl::NeighborhoodCache<PointT>::Ptr cache (new pcl::NeighborhoodCache<PointT> (tree));
+    * cache->setNeighborhoods (cloud, *indices, *sor.getNeighbors (), *sor.getNeighborSqrDistances ());
+    * ne.setSearchMethod (cache);
+    * ne.setKSearch (sor.getMeanK ());
+    * \endcode
+    *
+    * The cache is read-only once computed, so it may be queried by several threads at once.
+    * \ingroup features
+    */
+  template <typename PointT>
+  class NeighborhoodCache : public pcl::search::Search<PointT>
+  {
+    public:
+      typedef pcl::search::Search<PointT> Search;
+      typedef typename Search::Ptr SearchPtr;
+      typedef typename Search::PointCloud PointCloud;
+      typedef typename Search::PointCloudConstPtr PointCloudConstPtr;
+      typedef typename Search::IndicesConstPtr IndicesConstPtr;
+
+      typedef boost::shared_ptr<NeighborhoodCache<PointT> > Ptr;
+      typedef boost::shared_ptr<const NeighborhoodCache<PointT> > ConstPtr;
+
+      /** \brief Constructor.
+        * \param[in] search the search method used to compute the neighborhoods and to answer other searches
+        */
+      NeighborhoodCache (const SearchPtr &search)
+        : pcl::search::Search<PointT> ("NeighborhoodCache")
+        , search_ (search), cloud_ (), radius_ (0), nearest_ (false), slots_ (), neighbors_ (), distances_ ()
+      {
+      }
+
+      /** \brief Search the neighborhoods of a set of query points, in parallel, and store them.
+        * \param[in] cloud the cloud of the query points
+        * \param[in] indices the indices of the query points in \a cloud
+        * \param[in] radius the radius of the neighborhoods
+        * \param[in] nr_threads the number of threads to use
+        */
+      void
+      compute (const PointCloudConstPtr &cloud, const std::vector<int> &indices, double radius,
+               unsigned int nr_threads = 1);
+
+      /** \brief Store a precomputed k nearest neighbor graph. The search method gets \a cloud as its input, and
+        * answers the searches around the other points and the k nearest neighbor searches with a larger k.
+        * \param[in] cloud the cloud of the query points and of their neighbors
+        * \param[in] indices the indices of the query points in \a cloud
+        * \param[in] neighbors the indices of the neighbors of every query point, in the order of \a indices, as
+        * returned by nearestKSearch (): sorted by distance, starting with the point itself
+        * \param[in] sqr_distances the squared distances to the neighbors of every query point
+        */
+      void
+      setNeighborhoods (const PointCloudConstPtr &cloud, const std::vector<int> &indices,
+                        const std::vector<std::vector<int> > &neighbors,
+                        const std::vector<std::vector<float> > &sqr_distances);
+
+      /** \brief Remove all stored neighborhoods. */
+      void
+      clear ();
+
+      /** \brief Get the radius of the stored neighborhoods. */
+      inline double
+      getRadius () const { return (radius_); }
+
+      /** \brief Get the search method the neighborhoods were computed with. */
+      inline SearchPtr
+      getSearchMethod () const { return (search_); }
+
+      /** \brief Pass the input dataset of the search method. The stored neighborhoods are removed if it changes.
+        * \param[in] cloud a const pointer to the PointCloud data
+        * \param[in] indices the point indices subset that is to be used from the cloud
+        */
+      void
+      setInputCloud (const PointCloudConstPtr &cloud, const IndicesConstPtr &indices = IndicesConstPtr ());
+
+      /** \brief Get a pointer to the input point cloud dataset of the search method. */
+      inline PointCloudConstPtr
+      getInputCloud () const { return (search_->getInputCloud ()); }
+
+      /** \brief Get a pointer to the vector of indices used by the search method. */
+      inline IndicesConstPtr
+      getIndices () const { return (search_->getIndices ()); }
+
+      /** \brief Set whether the search method sorts its results. The stored neighborhoods keep their order.
+        * \param[in] sorted whether the results should be sorted by ascending distance
+        */
+      inline void
+      setSortedResults (bool sorted) { search_->setSortedResults (sorted); }
+
+      /** \brief Search for the k-nearest neighbors of a query point with the search method.
+        * \param[in] point the given query point
+        * \param[in] k the number of neighbors to search for
+        * \param[out] k_indices the resultant indices of the neighboring points
+        * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+        * \return number of neighbors found
+        */
+      inline int
+      nearestKSearch (const PointT &point, int k, std::vector<int> &k_indices,
+                      std::vector<float> &k_sqr_distances) const
+      {
+        return (search_->nearestKSearch (point, k, k_indices, k_sqr_distances));
+      }
+
+      /** \brief Search for the k-nearest neighbors of a point of a cloud. The stored neighbor graph is used if the
+        * point was a query point of setNeighborhoods () and it has at least \a k neighbors.
+        * \param[in] cloud the point cloud data
+        * \param[in] index a \a valid index in \a cloud representing a \a valid (i.e., finite) query point
+        * \param[in] k the number of neighbors to search for
+        * \param[out] k_indices the resultant indices of the neighboring points
+        * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+        * \return number of neighbors found
+        */
+      int
+      nearestKSearch (const PointCloud &cloud, int index, int k,
+                      std::vector<int> &k_indices, std::vector<float> &k_sqr_distances) const;
+
+      /** \brief Search for all the neighbors of a query point in a given radius with the search method.
+        * \param[in] point the given query point
+        * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+        * \param[out] k_indices the resultant indices of the neighboring points
+        * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+        * \param[in] max_nn if given, bounds the maximum returned neighbors to this value
+        * \return number of neighbors found in radius
+        */
+      inline int
+      radiusSearch (const PointT &point, double radius, std::vector<int> &k_indices,
+                    std::vector<float> &k_sqr_distances, unsigned int max_nn = 0) const
+      {
+        return (search_->radiusSearch (point, radius, k_indices, k_sqr_distances, max_nn));
+      }
+
+      /** \brief Search for all the neighbors of a point of a cloud in a given radius. The stored neighborhood is
+        * used if the point was a query point of compute () and the radius is not larger than the stored one.
+        * \param[in] cloud the point cloud data
+        * \param[in] index a \a valid index in \a cloud representing a \a valid (i.e., finite) query point
+        * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+        * \param[out] k_indices the resultant indices of the neighboring points
+        * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+        * \param[in] max_nn if given, bounds the maximum returned neighbors to this value
+        * \return number of neighbors found in radius
+        */
+      int
+      radiusSearch (const PointCloud &cloud, int index, double radius,
+                    std::vector<int> &k_indices, std::vector<float> &k_sqr_distances,
+                    unsigned int max_nn = 0) const;
+
+    private:
+      /** \brief The search method which computes the neighborhoods. */
+      SearchPtr search_;
+
+      /** \brief The cloud of the query points of the stored neighborhoods. */
+      PointCloudConstPtr cloud_;
+
+      /** \brief The radius of the stored neighborhoods. */
+      double radius_;
+
+      /** \brief True if the stored neighborhoods are k nearest neighbor lists rather than radius neighborhoods. */
+      bool nearest_;
+
+      /** \brief The position in neighbors_ of the neighborhood of every point of cloud_, or -1. */
+      std::vector<int> slots_;
+
+      /** \brief The indices of the neighbors of every query point. */
+      std::vector<std::vector<int> > neighbors_;
+
+      /** \brief The squared distances to the neighbors of every query point. */
+      std::vector<std::vector<float> > distances_;
+  };
+
+  /** \brief FeaturePipeline computes several features of the same points with a single neighborhood search per
+    * point.
+    *
+    * Every registered estimator is run in turn on the input cloud, indices and search surface of the pipeline,
+    * each filling its own output cloud, but their radius searches around the input points are answered from
+    * neighborhoods searched once, in parallel, for the largest radius of all estimators. An estimator with a
+    * smaller radius gets the neighbors within its radius, in the same order, so its output is the same as if it
+    * ran alone. Other searches, such as the k-nearest neighbor searches or the searches around the neighbors
+    * of FPFHEstimation, go to the search method of the pipeline.
+    *
+    * The estimators run in the order they were added, so an estimator may use the output of a previous one,
+    * e.g. as its input normals. Their own search methods are restored after compute ().
+    *
+    * Example:
+    * \code
+    * typedef pcl::NormalEstimationOMP<pcl::PointXYZ, pcl::Normal> NormalEstimation;
+    * typedef pcl::FPFHEstimationOMP<pcl::PointXYZ, pcl::Normal, pcl::FPFHSignature33> FPFHEstimation;
+    * boost::shared_ptr<NormalEstimation> ne (new NormalEstimation);
+    * ne->setRadiusSearch (0.02);
+    * boost::shared_ptr<FPFHEstimation> fpfh (new FPFHEstimation);
+    * fpfh->setRadiusSearch (0.05);
+    * fpfh->setInputNormals (normals);
+    *
+    * pcl::FeaturePipeline<pcl::PointXYZ> pipeline;
+    * pipeline.setInputCloud (cloud);
+    * pipeline.addFeature (ne, normals);
+    * pipeline.addFeature (fpfh, descriptors);
+    * pipeline.setNumberOfThreads (4);
+    * pipeline.compute ();
+    * \endcode
+    * \ingroup features
+    */
+  template <typename PointInT>
+  class FeaturePipeline : public PCLBase<PointInT>
+  {
+    public:
+      using PCLBase<PointInT>::indices_;
+      using PCLBase<PointInT>::input_;
+
+      typedef pcl::PointCloud<PointInT> PointCloudIn;
+      typedef typename PointCloudIn::ConstPtr PointCloudInConstPtr;
+
+      typedef pcl::search::Search<PointInT> KdTree;
+      typedef typename KdTree::Ptr KdTreePtr;
+
+      typedef typename FeatureStage<PointInT>::Ptr FeatureStagePtr;
+
+      typedef boost::shared_ptr<FeaturePipeline<PointInT> > Ptr;
+      typedef boost::shared_ptr<const FeaturePipeline<PointInT> > ConstPtr;
+
+      /** \brief Empty constructor. */
+      FeaturePipeline () : surface_ (), tree_ (), stages_ (), threads_ (1) {}
+
+      /** \brief Provide a pointer to a dataset to add additional information to estimate the features for every
+        * point in the input dataset, as Feature::setSearchSurface () does for every estimator.
+        * \param[in] cloud a pointer to a PointCloud message
+        */
+      inline void
+      setSearchSurface (const PointCloudInConstPtr &cloud) { surface_ = cloud; }
+
+      /** \brief Get a pointer to the surface point cloud dataset. */
+      inline PointCloudInConstPtr
+      getSearchSurface () const { return (surface_); }
+
+      /** \brief Provide a pointer to the search object which computes the neighborhoods.
+        * \param[in] tree a pointer to the spatial search object.
+        */
+      inline void
+      setSearchMethod (const KdTreePtr &tree) { tree_ = tree; }
+
+      /** \brief Get a pointer to the search method used. */
+      inline KdTreePtr
+      getSearchMethod () const { return (tree_); }
+
+      /** \brief Initialize the scheduler and set the number of threads used to search the neighborhoods.
+        * \param[in] nr_threads the number of hardware threads to use
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        threads_ = (nr_threads == 0) ? 1 : nr_threads;
+      }
+
+      /** \brief Add an estimator to the pipeline. Its search parameters are read in compute (); its input cloud,
+        * indices, search surface and search method are set by the pipeline.
+        * \param[in] feature the estimator, a pcl::Feature with the point type of the pipeline
+        * \param[out] output the cloud that receives the features of the estimator
+        */
+      template <typename FeatureT, typename PointOutT> inline void
+      addFeature (const boost::shared_ptr<FeatureT> &feature,
+                  const boost::shared_ptr<pcl::PointCloud<PointOutT> > &output)
+      {
+        stages_.push_back (FeatureStagePtr (new FeatureStageImpl<PointInT, PointOutT> (feature, output)));
+      }
+
+      /** \brief Remove all estimators. */
+      inline void
+      clearFeatures () { stages_.clear (); }
+
+      /** \brief Get the number of estimators in the pipeline. */
+      inline size_t
+      getNumberOfFeatures () const { return (stages_.size ()); }
+
+      /** \brief Search the neighborhoods of the input points once and run all estimators on them. */
+      void
+      compute ();
+
+    private:
+      /** \brief The search surface, or an empty pointer to search the input cloud. */
+      PointCloudInConstPtr surface_;
+
+      /** \brief The search method which computes the neighborhoods. */
+      KdTreePtr tree_;
+
+      /** \brief The estimators, in the order they were added. */
+      std::vector<FeatureStagePtr> stages_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+  };
+}
+
+#endif  //#ifndef PCL_FEATURE_PIPELINE_H_
@@ -0,0 +1,212 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FEATURE_STAGE_H_
+#define PCL_FEATURE_STAGE_H_
+
+#include <pcl/features/feature.h>
+
+namespace pcl
+{
+  /** \brief FeatureStage runs a feature estimator whose type is not known, for the classes which drive the
+    * estimators given by the user, such as FeaturePipeline. It only depends on the input point type, so that
+    * estimators with different output types can be kept together; the features are written to the output cloud
+    * of the stage. See FeatureStageImpl.
+    * \ingroup features
+    */
+  template <typename PointInT>
+  class FeatureStage
+  {
+    public:
+      typedef pcl::PointCloud<PointInT> PointCloudIn;
+      typedef typename PointCloudIn::ConstPtr PointCloudInConstPtr;
+      typedef typename pcl::search::Search<PointInT>::Ptr KdTreePtr;
+
+      typedef boost::shared_ptr<FeatureStage<PointInT> > Ptr;
+      typedef boost::shared_ptr<const FeatureStage<PointInT> > ConstPtr;
+
+      /** \brief Empty destructor. */
+      virtual ~FeatureStage () {}
+
+      /** \brief Copy the estimator, e.g. to run it in another thread. The copy has an output cloud of its own,
+        * but shares the indices, search surface and search method of the estimator until they are set again.
+        */
+      virtual Ptr
+      clone () const = 0;
+
+      /** \brief Get the search radius of the estimator, or 0 if it searches the k nearest neighbors. */
+      virtual double
+      getRadiusSearch () const = 0;
+
+      /** \brief Get the search method of the estimator. */
+      virtual KdTreePtr
+      getSearchMethod () const = 0;
+
+      /** \brief Run the estimator and write the features to the output cloud of the stage. The search method of
+        * the estimator is restored afterwards.
+        * \param[in] input the input cloud
+        * \param[in] indices the indices of the points to estimate the features of, or an empty pointer for all
+        * \param[in] surface the search surface, or an empty pointer to search the input cloud
+        * \param[in] search the search method
+        */
+      virtual void
+      compute (const PointCloudInConstPtr &input, const IndicesPtr &indices,
+               const PointCloudInConstPtr &surface, const KdTreePtr &search) = 0;
+  };
+
+  /** \brief FeatureStageImpl holds an estimator with a given output type through its pcl::Feature base class.
+    * Only the copy in clone () needs the type of the estimator, which is given to the constructor.
+    *
+    * Example:
+    * \code
+    * boost::shared_ptr<pcl::FPFHEstimation<pcl::PointXYZ, pcl::Normal, pcl::FPFHSignature33> > fpfh (...);
+    * pcl::FeatureStage<pcl::PointXYZ>::Ptr stage (
+    *     new pcl::FeatureStageImpl<pcl::PointXYZ, pcl::FPFHSignature33> (fpfh, fpfhs));
+    * stage->compute (cloud, indices, pcl::PointCloud<pcl::PointXYZ>::ConstPtr (), tree);
+    * \endcode
+    * \ingroup features
+    */
+  template <typename PointInT, typename PointOutT>
+  class FeatureStageImpl : public FeatureStage<PointInT>
+  {
+    public:
+      typedef typename FeatureStage<PointInT>::Ptr StagePtr;
+      typedef typename FeatureStage<PointInT>::PointCloudInConstPtr PointCloudInConstPtr;
+      typedef typename FeatureStage<PointInT>::KdTreePtr KdTreePtr;
+
+      typedef pcl::Feature<PointInT, PointOutT> FeatureBase;
+      typedef boost::shared_ptr<FeatureBase> FeatureBasePtr;
+
+      typedef pcl::PointCloud<PointOutT> PointCloudOut;
+      typedef typename PointCloudOut::Ptr PointCloudOutPtr;
+
+      typedef boost::shared_ptr<FeatureStageImpl<PointInT, PointOutT> > Ptr;
+      typedef boost::shared_ptr<const FeatureStageImpl<PointInT, PointOutT> > ConstPtr;
+
+      /** \brief Constructor.
+        * \param[in] feature the estimator, a pcl::Feature with the given input and output point types
+        * \param[in] output the cloud that receives the features of the estimator
+        */
+      template <typename FeatureT>
+      FeatureStageImpl (const boost::shared_ptr<FeatureT> &feature,
+                        const PointCloudOutPtr &output = PointCloudOutPtr (new PointCloudOut))
+        : feature_ (feature), output_ (output), copy_ (&copyFeature<FeatureT>)
+      {
+      }
+
+      StagePtr
+      clone () const
+      {
+        return (StagePtr (new FeatureStageImpl<PointInT, PointOutT> (copy_ (*feature_), copy_)));
+      }
+
+      double
+      getRadiusSearch () const { return (feature_->getRadiusSearch ()); }
+
+      KdTreePtr
+      getSearchMethod () const { return (feature_->getSearchMethod ()); }
+
+      void
+      compute (const PointCloudInConstPtr &input, const IndicesPtr &indices,
+               const PointCloudInConstPtr &surface, const KdTreePtr &search)
+      {
+        compute (input, indices, surface, search, *output_);
+      }
+
+      /** \brief Run the estimator and write the features to a given cloud. The search method of the estimator is
+        * restored afterwards.
+        * \param[in] input the input cloud
+        * \param[in] indices the indices of the points to estimate the features of, or an empty pointer for all
+        * \param[in] surface the search surface, or an empty pointer to search the input cloud
+        * \param[in] search the search method
+        * \param[out] output the features of the points
+        */
+      void
+      compute (const PointCloudInConstPtr &input, const IndicesPtr &indices,
+               const PointCloudInConstPtr &surface, const KdTreePtr &search, PointCloudOut &output)
+      {
+        const KdTreePtr tree = feature_->getSearchMethod ();
+        feature_->setInputCloud (input);
+        feature_->setIndices (indices);
+        feature_->setSearchSurface (surface);
+        feature_->setSearchMethod (search);
+        feature_->compute (output);
+        feature_->setSearchMethod (tree);
+      }
+
+      /** \brief Get the estimator, e.g. to set the parameters only some estimators have. */
+      inline FeatureBase&
+      getFeature () const { return (*feature_); }
+
+      /** \brief Get the output cloud of the stage. */
+      inline const PointCloudOutPtr&
+      getOutput () const { return (output_); }
+
+    private:
+      /** \brief Copies an estimator of the type given to the constructor. */
+      typedef FeatureBasePtr (*CopyFunction) (const FeatureBase &);
+
+      /** \brief Constructor of the copies of clone ().
+        * \param[in] feature the copy of the estimator
+        * \param[in] copy the function which copies it
+        */
+      FeatureStageImpl (const FeatureBasePtr &feature, CopyFunction copy)
+        : feature_ (feature), output_ (new PointCloudOut), copy_ (copy)
+      {
+      }
+
+      /** \brief Copy an estimator of a given type. */
+      template <typename FeatureT> static FeatureBasePtr
+      copyFeature (const FeatureBase &feature)
+      {
+        return (FeatureBasePtr (new FeatureT (static_cast<const FeatureT&> (feature))));
+      }
+
+      /** \brief The estimator. */
+      FeatureBasePtr feature_;
+
+      /** \brief The cloud that receives the features of the estimator. */
+      PointCloudOutPtr output_;
+
+      /** \brief The function which copies the estimator. */
+      CopyFunction copy_;
+  };
+}
+
+#endif  //#ifndef PCL_FEATURE_STAGE_H_
@@ -65,6 +65,12 @@ namespace pcl
     *     doesn't have finite 3D coordinates. Therefore, any point that contains
     *     NaN data on x, y, or z, will have its FPFH feature property set to NaN.
     *
+    * The estimation runs in two parallel passes. The first one searches the neighborhood of every query point
+    * once, stores all of them in a single compressed row buffer, and computes the SPFH signature of every point
+    * of these neighborhoods into a table of aligned rows. The second one weights the SPFH rows of the stored
+    * neighborhoods, without searching again. When the input is also the search surface, the SPFH signatures of
+    * the query points reuse their stored neighborhoods too.
+    *
     * \author Radu B. Rusu
     * \ingroup features
     */
@@ -80,15 +86,16 @@ namespace pcl
       using Feature<PointInT, PointOutT>::input_;
       using Feature<PointInT, PointOutT>::surface_;
       using FeatureFromNormals<PointInT, PointNT, PointOutT>::normals_;
-      using FPFHEstimation<PointInT, PointNT, PointOutT>::hist_f1_;
-      using FPFHEstimation<PointInT, PointNT, PointOutT>::hist_f2_;
-      using FPFHEstimation<PointInT, PointNT, PointOutT>::hist_f3_;
-      using FPFHEstimation<PointInT, PointNT, PointOutT>::weightPointSPFHSignature;
+      using FPFHEstimation<PointInT, PointNT, PointOutT>::nr_bins_f1_;
+      using FPFHEstimation<PointInT, PointNT, PointOutT>::nr_bins_f2_;
+      using FPFHEstimation<PointInT, PointNT, PointOutT>::nr_bins_f3_;
+      using FPFHEstimation<PointInT, PointNT, PointOutT>::d_pi_;
+      using FPFHEstimation<PointInT, PointNT, PointOutT>::computePairFeatures;
 
       typedef typename Feature<PointInT, PointOutT>::PointCloudOut PointCloudOut;
 
       /** \brief Empty constructor. */
-      FPFHEstimationOMP () : nr_bins_f1_ (11), nr_bins_f2_ (11), nr_bins_f3_ (11), threads_ (1) 
+      FPFHEstimationOMP () : threads_ (1) 
       {
         feature_name_ = "FPFHEstimationOMP";
       };
@@ -96,8 +103,9 @@ namespace pcl
       /** \brief Initialize the scheduler and set the number of threads to use.
         * \param[in] nr_threads the number of hardware threads to use (-1 sets the value back to automatic)
         */
-      FPFHEstimationOMP (unsigned int nr_threads) : nr_bins_f1_ (11), nr_bins_f2_ (11), nr_bins_f3_ (11), threads_ (0)
+      FPFHEstimationOMP (unsigned int nr_threads) : threads_ (0)
       {
+        feature_name_ = "FPFHEstimationOMP";
         setNumberOfThreads (nr_threads);
       }
 
@@ -121,10 +129,16 @@ namespace pcl
       void 
       computeFeature (PointCloudOut &output);
 
-    public:
-      /** \brief The number of subdivisions for each angular feature interval. */
-      int nr_bins_f1_, nr_bins_f2_, nr_bins_f3_;
-    private:
+      /** \brief Estimate the SPFH signature of a point of the surface into a row of the SPFH table, as
+        * computePointSPFHSignature () does.
+        * \param[in] p_idx the index of the query point in the surface
+        * \param[in] indices the indices of the neighbors of the query point in the surface
+        * \param[in] nr_indices the number of neighbors
+        * \param[out] spfh the f1, f2 and f3 histograms of the row, one after the other
+        */
+      void
+      computeSPFHRow (int p_idx, const int *indices, int nr_indices, float *spfh) const;
+
       /** \brief The number of threads the scheduler should use. */
       unsigned int threads_;
 
@@ -0,0 +1,220 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_GLOBAL_FEATURE_BATCH_H_
+#define PCL_GLOBAL_FEATURE_BATCH_H_
+
+#include <pcl/features/feature.h>
+#include <pcl/features/feature_stage.h>
+#include <pcl/features/cvfh.h>
+#include <pcl/search/brute_force.h>
+#include <pcl/PointIndices.h>
+
+namespace pcl
+{
+  /** \brief GlobalFeatureBatch describes many clusters with the same global estimator, in parallel.
+    *
+    * The clusters are either given as indices into one segmented cloud, with setInputCloud () and setClusters (),
+    * or as one cloud per view, with setInputClouds (). Every thread describes whole clusters with its own copy of
+    * the estimator, so any global estimator can be batched: VFHEstimation, CVFHEstimation, ESFEstimation,
+    * CRHEstimation... Each cluster given by indices is copied into a cloud of its own, so that the estimator only
+    * sees the points of the cluster. The indices and search surface of the estimator are not used.
+    *
+    * Global estimators do not search the neighborhoods of the input points, so the copies are given a brute
+    * force search method, which costs nothing to build for every cluster.
+    *
+    * Along with the descriptors of every cluster, compute () gives their centroids: the centroids of the
+    * dominant regions for CVFHEstimation, the centroid of the cluster for the other estimators.
+    *
+    * Example:
+    * \code
+    * typedef pcl::VFHEstimation<pcl::PointXYZ, pcl::Normal, pcl::VFHSignature308> VFHEstimation;
+    * boost::shared_ptr<VFHEstimation> vfh (new VFHEstimation);
+    * vfh->setNormalizeBins (true);
+    *
+    * pcl::GlobalFeatureBatch<pcl::PointXYZ, pcl::VFHSignature308> batch;
+    * batch.setFeatureEstimator (vfh);
+    * batch.setInputCloud (scene);
+    * batch.setInputNormals (scene_normals);
+    * batch.setClusters (clusters);
+    * batch.setNumberOfThreads (4);
+    * pcl::PointCloud<pcl::VFHSignature308>::CloudVectorType descriptors;
+    * batch.compute (descriptors);
+    * \endcode
+    * \ingroup features
+    */
+  template <typename PointInT, typename PointOutT, typename PointNT = pcl::Normal>
+  class GlobalFeatureBatch
+  {
+    public:
+      typedef pcl::PointCloud<PointInT> PointCloudIn;
+      typedef typename PointCloudIn::ConstPtr PointCloudInConstPtr;
+
+      typedef pcl::PointCloud<PointNT> PointCloudN;
+      typedef typename PointCloudN::ConstPtr PointCloudNConstPtr;
+
+      typedef pcl::PointCloud<PointOutT> PointCloudOut;
+      typedef typename PointCloudOut::CloudVectorType PointCloudOutVector;
+
+      typedef FeatureStageImpl<PointInT, PointOutT> FeatureStage;
+      typedef typename FeatureStage::Ptr FeatureStagePtr;
+
+      typedef boost::shared_ptr<GlobalFeatureBatch<PointInT, PointOutT, PointNT> > Ptr;
+      typedef boost::shared_ptr<const GlobalFeatureBatch<PointInT, PointOutT, PointNT> > ConstPtr;
+
+      /** \brief Empty constructor. */
+      GlobalFeatureBatch ()
+        : feature_ (), input_ (), normals_ (), clusters_ (), clouds_ (), cloud_normals_ (), centroids_ (), threads_ (1)
+      {
+      }
+
+      /** \brief Set the estimator which describes the clusters. Its parameters are read in compute (), where
+        * every thread copies it.
+        * \param[in] feature the estimator, a pcl::Feature which computes the descriptors of all its input points
+        */
+      template <typename FeatureT> inline void
+      setFeatureEstimator (const boost::shared_ptr<FeatureT> &feature)
+      {
+        feature_.reset (new FeatureStage (feature));
+      }
+
+      /** \brief Provide the segmented cloud the clusters of setClusters () are taken from.
+        * \param[in] cloud the segmented cloud
+        */
+      inline void
+      setInputCloud (const PointCloudInConstPtr &cloud)
+      {
+        input_ = cloud;
+        clouds_.clear ();
+        cloud_normals_.clear ();
+      }
+
+      /** \brief Provide the normals of the segmented cloud, for the estimators which need them.
+        * \param[in] normals the normals of every point of the cloud of setInputCloud ()
+        */
+      inline void
+      setInputNormals (const PointCloudNConstPtr &normals) { normals_ = normals; }
+
+      /** \brief Set the clusters of the segmented cloud to describe.
+        * \param[in] clusters the indices of the points of every cluster
+        */
+      inline void
+      setClusters (const std::vector<pcl::PointIndices> &clusters) { clusters_ = clusters; }
+
+      /** \brief Provide the clouds to describe, one per view or segmented cluster, instead of a segmented cloud.
+        * \param[in] clouds the clouds
+        */
+      inline void
+      setInputClouds (const std::vector<PointCloudInConstPtr> &clouds)
+      {
+        clouds_ = clouds;
+        input_.reset ();
+        normals_.reset ();
+        clusters_.clear ();
+      }
+
+      /** \brief Provide the normals of the clouds of setInputClouds (), for the estimators which need them.
+        * \param[in] normals the normals of every cloud
+        */
+      inline void
+      setInputNormals (const std::vector<PointCloudNConstPtr> &normals) { cloud_normals_ = normals; }
+
+      /** \brief Get the number of clusters to describe. */
+      inline size_t
+      getNumberOfClusters () const { return (input_ ? clusters_.size () : clouds_.size ()); }
+
+      /** \brief Initialize the scheduler and set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        threads_ = (nr_threads == 0) ? 1 : nr_threads;
+      }
+
+      /** \brief Describe all the clusters.
+        * \param[out] output the descriptors of every cluster, as computed by the estimator. The output of a
+        * cluster the estimator fails to describe is empty.
+        */
+      void
+      compute (PointCloudOutVector &output);
+
+      /** \brief Get the centroids of the descriptors of every cluster described by the last compute (). */
+      inline const std::vector<std::vector<Eigen::Vector3f> >&
+      getCentroids () const { return (centroids_); }
+
+    private:
+      /** \brief Give the normals of a cluster to the estimator, if it needs them. */
+      static void
+      setNormals (pcl::Feature<PointInT, PointOutT> &feature, const PointCloudNConstPtr &normals);
+
+      /** \brief Get the centroids of the descriptors of a cluster: the dominant regions for CVFHEstimation, the
+        * centroid of the cluster for the other estimators.
+        */
+      static void
+      getCentroids (pcl::Feature<PointInT, PointOutT> &feature, const PointCloudIn &cloud,
+                    std::vector<Eigen::Vector3f> &centroids);
+
+      /** \brief The estimator. */
+      FeatureStagePtr feature_;
+
+      /** \brief The segmented cloud. */
+      PointCloudInConstPtr input_;
+
+      /** \brief The normals of the segmented cloud. */
+      PointCloudNConstPtr normals_;
+
+      /** \brief The clusters of the segmented cloud. */
+      std::vector<pcl::PointIndices> clusters_;
+
+      /** \brief The clouds to describe, if no segmented cloud is given. */
+      std::vector<PointCloudInConstPtr> clouds_;
+
+      /** \brief The normals of the clouds to describe. */
+      std::vector<PointCloudNConstPtr> cloud_normals_;
+
+      /** \brief The centroids of the descriptors of every cluster. */
+      std::vector<std::vector<Eigen::Vector3f> > centroids_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+  };
+}
+
+#endif  //#ifndef PCL_GLOBAL_FEATURE_BATCH_H_
@@ -0,0 +1,128 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FEATURES_IMPL_3DSC_OMP_HPP_
+#define PCL_FEATURES_IMPL_3DSC_OMP_HPP_
+
+#include <pcl/features/3dsc_omp.h>
+#include <pcl/common/utils.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::ShapeContext3DEstimationOMP<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut &output)
+{
+  const int threads = static_cast<int> (threads_);
+  const int nr_queries = static_cast<int> (indices_->size ());
+  binning_.computeBinTables (radii_interval_, theta_divisions_, phi_divisions_);
+
+  // First pass: search the neighborhood of every query point once, into a compressed row buffer
+  std::vector<int> nn_offsets, nn_indices;
+  std::vector<float> nn_dists;
+  this->searchForNeighborhoods (search_radius_, threads_, nn_offsets, nn_indices, nn_dists);
+
+  // Count the local point density of every surface point of the neighborhoods once
+  std::vector<float> inv_density;
+  ShapeContextBinning::computeInverseDensities (*this->tree_, *surface_, point_density_radius_, nn_indices, nn_dists,
+                                                threads_, inv_density);
+
+  // The local frames take the normal of the nearest neighbor and a random X axis, drawn here in the order of the
+  // query points as ShapeContext3DEstimation does
+  std::vector<Eigen::Matrix3f> frames (nr_queries);
+  for (int idx = 0; idx < nr_queries; ++idx)
+  {
+    if (nn_offsets[idx + 1] == nn_offsets[idx])
+      continue;
+
+    float min_dist = std::numeric_limits<float>::max ();
+    int min_index = -1;
+    for (int i = nn_offsets[idx]; i < nn_offsets[idx + 1]; ++i)
+    {
+      if (nn_dists[i] < min_dist)
+      {
+        min_dist = nn_dists[i];
+        min_index = nn_indices[i];
+      }
+    }
+    const Eigen::Vector3f normal = normals_->points[min_index].getNormalVector3fMap ();
+
+    Eigen::Vector3f x_axis;
+    x_axis[0] = static_cast<float> (rnd ());
+    x_axis[1] = static_cast<float> (rnd ());
+    x_axis[2] = static_cast<float> (rnd ());
+    if (!pcl::utils::equal (normal[2], 0.0f))
+      x_axis[2] = - (normal[0]*x_axis[0] + normal[1]*x_axis[1]) / normal[2];
+    else if (!pcl::utils::equal (normal[1], 0.0f))
+      x_axis[1] = - (normal[0]*x_axis[0] + normal[2]*x_axis[2]) / normal[1];
+    else if (!pcl::utils::equal (normal[0], 0.0f))
+      x_axis[0] = - (normal[1]*x_axis[1] + normal[2]*x_axis[2]) / normal[0];
+    x_axis.normalize ();
+
+    frames[idx].row (0) = x_axis;
+    frames[idx].row (1) = normal.cross (x_axis);
+    frames[idx].row (2) = normal;
+  }
+
+  // Second pass: bin the stored neighborhoods
+  bool is_dense = true;
+
+#pragma omp parallel for num_threads (threads) schedule (dynamic, 64)
+  for (int idx = 0; idx < nr_queries; ++idx)
+  {
+    // 3DSC does not define a repeatable local RF, we set it to zero to signal it to the user
+    memset (output[idx].rf, 0, sizeof (output[idx].rf[0]) * 9);
+
+    if (nn_offsets[idx + 1] == nn_offsets[idx])
+    {
+      output[idx].descriptor.assign (descriptor_length_, std::numeric_limits<float>::quiet_NaN ());
+      is_dense = false;
+      continue;
+    }
+
+    output[idx].descriptor.assign (descriptor_length_, 0.0f);
+    binning_.computePointDescriptor (*surface_, (*input_)[(*indices_)[idx]].getVector3fMap (), frames[idx],
+                                     &nn_indices[nn_offsets[idx]], &nn_dists[nn_offsets[idx]],
+                                     nn_offsets[idx + 1] - nn_offsets[idx], inv_density, volume_lut_,
+                                     &output[idx].descriptor[0]);
+  }
+  output.is_dense = is_dense;
+}
+
+#define PCL_INSTANTIATE_ShapeContext3DEstimationOMP(T,NT,OutT) template class PCL_EXPORTS pcl::ShapeContext3DEstimationOMP<T,NT,OutT>;
+
+#endif    // PCL_FEATURES_IMPL_3DSC_OMP_HPP_
@@ -67,10 +67,14 @@ pcl::CRHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut
     return;
   }
 
+  Eigen::Vector4f centroid = centroid_;
+  if (!use_given_centroid_)
+    pcl::compute3DCentroid (*surface_, *indices_, centroid);
+
   Eigen::Vector3f plane_normal;
-  plane_normal[0] = -centroid_[0];
-  plane_normal[1] = -centroid_[1];
-  plane_normal[2] = -centroid_[2];
+  plane_normal[0] = -centroid[0];
+  plane_normal[1] = -centroid[1];
+  plane_normal[2] = -centroid[2];
   Eigen::Vector3f z_vector = Eigen::Vector3f::UnitZ ();
   plane_normal.normalize ();
   Eigen::Vector3f axis = plane_normal.cross (z_vector);
@@ -94,7 +98,7 @@ pcl::CRHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut
   pcl::transformPointCloudWithNormals (grid, grid, transformPC);
 
   //fill spatial data vector
-  kiss_fft_scalar * spatial_data = new kiss_fft_scalar[nbins];
+  std::vector<kiss_fft_scalar> spatial_data (nbins, 0);
   float sum_w = 0, w = 0;
   int bin = 0;
   for (size_t i = 0; i < grid.points.size (); ++i)
@@ -108,9 +112,10 @@ pcl::CRHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut
   for (int i = 0; i < nbins; ++i)
     spatial_data[i] /= sum_w;
 
-  kiss_fft_cpx * freq_data = new kiss_fft_cpx[nbins / 2 + 1];
+  std::vector<kiss_fft_cpx> freq_data (nbins / 2 + 1);
   kiss_fftr_cfg mycfg = kiss_fftr_alloc (nbins, 0, NULL, NULL);
-  kiss_fftr (mycfg, spatial_data, freq_data);
+  kiss_fftr (mycfg, &spatial_data[0], &freq_data[0]);
+  kiss_fftr_free (mycfg);
 
   output.points.resize (1);
   output.width = output.height = 1;
@@ -124,10 +129,6 @@ pcl::CRHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut
   }
 
   output.points[0].histogram[nbins - 1] = freq_data[nbins / 2].r / freq_data[0].r; //nyquist
-
-  delete[] spatial_data;
-  delete[] freq_data;
-
 }
 
 #define PCL_INSTANTIATE_CRHEstimation(T,NT,OutT) template class PCL_EXPORTS pcl::CRHEstimation<T,NT,OutT>;
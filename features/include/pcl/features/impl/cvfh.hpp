@@ -69,15 +69,19 @@ pcl::CVFHEstimation<PointInT, PointNT, PointOutT>::extractEuclideanClustersSmoot
   // Create a bool vector of processed point indices, and initialize it to false
   std::vector<bool> processed (cloud.points.size (), false);
 
+  // acos (dot_p) < eps_angle, without an acos per neighbor
+  const double cos_eps_angle = cos (eps_angle);
+
   std::vector<int> nn_indices;
   std::vector<float> nn_distances;
+  std::vector<int> seed_queue;
   // Process all points in the indices vector
   for (int i = 0; i < static_cast<int> (cloud.points.size ()); ++i)
   {
     if (processed[i])
       continue;
 
-    std::vector<unsigned int> seed_queue;
+    seed_queue.clear ();
     int sq_idx = 0;
     seed_queue.push_back (i);
 
@@ -92,19 +96,19 @@ pcl::CVFHEstimation<PointInT, PointNT, PointOutT>::extractEuclideanClustersSmoot
         continue;
       }
 
+      const pcl::PointNormal &seed = normals.points[seed_queue[sq_idx]];
       for (size_t j = 1; j < nn_indices.size (); ++j) // nn_indices[0] should be sq_idx
       {
         if (processed[nn_indices[j]]) // Has this point been processed before ?
           continue;
 
-        //processed[nn_indices[j]] = true;
         // [-1;1]
+        const pcl::PointNormal &neighbor = normals.points[nn_indices[j]];
+        double dot_p = seed.normal[0] * neighbor.normal[0]
+                     + seed.normal[1] * neighbor.normal[1]
+                     + seed.normal[2] * neighbor.normal[2];
 
-        double dot_p = normals.points[seed_queue[sq_idx]].normal[0] * normals.points[nn_indices[j]].normal[0]
-                     + normals.points[seed_queue[sq_idx]].normal[1] * normals.points[nn_indices[j]].normal[1]
-                     + normals.points[seed_queue[sq_idx]].normal[2] * normals.points[nn_indices[j]].normal[2];
-
-        if (fabs (acos (dot_p)) < eps_angle)
+        if (dot_p > cos_eps_angle)
         {
           processed[nn_indices[j]] = true;
           seed_queue.push_back (nn_indices[j]);
@@ -117,16 +121,12 @@ pcl::CVFHEstimation<PointInT, PointNT, PointOutT>::extractEuclideanClustersSmoot
     // If this queue is satisfactory, add to the clusters
     if (seed_queue.size () >= min_pts_per_cluster && seed_queue.size () <= max_pts_per_cluster)
     {
-      pcl::PointIndices r;
-      r.indices.resize (seed_queue.size ());
-      for (size_t j = 0; j < seed_queue.size (); ++j)
-        r.indices[j] = seed_queue[j];
-
+      // Every point is queued once
+      clusters.push_back (pcl::PointIndices ());
+      pcl::PointIndices &r = clusters.back ();
+      r.indices = seed_queue;
       std::sort (r.indices.begin (), r.indices.end ());
-      r.indices.erase (std::unique (r.indices.begin (), r.indices.end ()), r.indices.end ());
-
       r.header = cloud.header;
-      clusters.push_back (r); // We could avoid a copy by working directly in the vector
     }
   }
 }
@@ -185,6 +185,7 @@ pcl::CVFHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut
   }
 
   centroids_dominant_orientations_.clear ();
+  dominant_normals_.clear ();
 
   // ---[ Step 0: remove normals with high curvature
   std::vector<int> indices_out;
@@ -207,19 +208,16 @@ pcl::CVFHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut
 
   if(normals_filtered_cloud->points.size() >= min_points_)
   {
-    //recompute normals and use them for clustering
-    KdTreePtr normals_tree_filtered (new pcl::search::KdTree<pcl::PointNormal> (false));
-    normals_tree_filtered->setInputCloud (normals_filtered_cloud);
+    //recompute normals and use them for clustering; the points do not move, so the same tree serves both
+    KdTreePtr normals_tree (new pcl::search::KdTree<pcl::PointNormal> (false));
+    normals_tree->setInputCloud (normals_filtered_cloud);
 
     NormalEstimator n3d;
     n3d.setRadiusSearch (radius_normals_);
-    n3d.setSearchMethod (normals_tree_filtered);
+    n3d.setSearchMethod (normals_tree);
     n3d.setInputCloud (normals_filtered_cloud);
     n3d.compute (*normals_filtered_cloud);
 
-    KdTreePtr normals_tree (new pcl::search::KdTree<pcl::PointNormal> (false));
-    normals_tree->setInputCloud (normals_filtered_cloud);
-
     extractEuclideanClustersSmooth (*normals_filtered_cloud,
                                     *normals_filtered_cloud,
                                     cluster_tolerance_,
@@ -260,8 +258,6 @@ pcl::CVFHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut
       avg_normal /= static_cast<float> (clusters[i].indices.size ());
       avg_centroid /= static_cast<float> (clusters[i].indices.size ());
 
-      Eigen::Vector4f centroid_test;
-      pcl::compute3DCentroid (*normals_filtered_cloud, centroid_test);
       avg_normal.normalize ();
 
       Eigen::Vector3f avg_norm (avg_normal[0], avg_normal[1], avg_normal[2]);
@@ -43,6 +43,7 @@
 #include <pcl/features/esf.h>
 #include <pcl/common/common.h>
 #include <pcl/common/transforms.h>
+#include <algorithm>
 #include <vector>
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -51,18 +52,14 @@ pcl::ESFEstimation<PointInT, PointOutT>::computeESF (
     PointCloudIn &pc, std::vector<float> &hist)
 {
   const int binsize = 64;
-  unsigned int sample_size = 20000;
-  srand (static_cast<unsigned int> (time (0)));
-  int maxindex = static_cast<int> (pc.points.size ());
-
-  int index1, index2, index3;
-  std::vector<float> d2v, d1v, d3v, wt_d3;
-  std::vector<int> wt_d2;
-  d1v.reserve (sample_size);
-  d2v.reserve (sample_size * 3);
-  d3v.reserve (sample_size);
-  wt_d2.reserve (sample_size * 3);
-  wt_d3.reserve (sample_size);
+  const int sample_size = 20000;
+  const int maxindex = static_cast<int> (pc.points.size ());
+
+  // The D2 distances and line classes of the three sides of every sampled triangle, and its D3 area and class.
+  // A sample whose triangle is degenerate is not used.
+  std::vector<float> d2v (sample_size * 3), d3v (sample_size), wt_d3 (sample_size);
+  std::vector<int> wt_d2 (sample_size * 3);
+  std::vector<unsigned char> valid (sample_size, 0);
 
   float h_in[binsize] = {0};
   float h_out[binsize] = {0};
@@ -72,204 +69,178 @@ pcl::ESFEstimation<PointInT, PointOutT>::computeESF (
   float h_a3_in[binsize] = {0};
   float h_a3_out[binsize] = {0};
   float h_a3_mix[binsize] = {0};
-  float h_d1[binsize] = {0};
 
   float h_d3_in[binsize] = {0};
   float h_d3_out[binsize] = {0};
   float h_d3_mix[binsize] = {0};
 
-  float ratio=0.0;
-  float pih = static_cast<float>(M_PI) / 2.0f;
-  float a,b,c,s;
-  int th1,th2,th3;
-  int vxlcnt = 0;
-  int pcnt1,pcnt2,pcnt3;
-  for (size_t nn_idx = 0; nn_idx < sample_size; ++nn_idx)
+  const float pih = static_cast<float>(M_PI) / 2.0f;
+  const int threads = static_cast<int> (threads_);
+#pragma omp parallel num_threads (threads)
   {
-    // get a new random point
-    index1 = rand()%maxindex;
-    index2 = rand()%maxindex;
-    index3 = rand()%maxindex;
-
-    if (index1==index2 || index1 == index3 || index2 == index3)
+    // The A3 and ratio histograms only sum multiples of 1/32, so adding the per thread histograms is exact
+    float t_mix_ratio[binsize] = {0};
+    float t_a3_in[binsize] = {0};
+    float t_a3_out[binsize] = {0};
+    float t_a3_mix[binsize] = {0};
+
+#pragma omp for schedule (dynamic, 256)
+    for (int nn_idx = 0; nn_idx < sample_size; ++nn_idx)
     {
-      nn_idx--;
-      continue;
-    }
-
-    Eigen::Vector4f p1 = pc.points[index1].getVector4fMap ();
-    Eigen::Vector4f p2 = pc.points[index2].getVector4fMap ();
-    Eigen::Vector4f p3 = pc.points[index3].getVector4fMap ();
-
-    // A3
-    Eigen::Vector4f v21 (p2 - p1);
-    Eigen::Vector4f v31 (p3 - p1);
-    Eigen::Vector4f v23 (p2 - p3);
-    a = v21.norm (); b = v31.norm (); c = v23.norm (); s = (a+b+c) * 0.5f;
-    if (s * (s-a) * (s-b) * (s-c) <= 0.001f)
-      continue;
+      uint64_t counter = static_cast<uint64_t> (nn_idx) << 32;
+      int index1, index2, index3;
+      int th1, th2, th3;
+      float a, b, c, s;
+      bool degenerate = false;
+      for (;;)
+      {
+        // get a new random point
+        index1 = randomIndex (counter++, maxindex);
+        index2 = randomIndex (counter++, maxindex);
+        index3 = randomIndex (counter++, maxindex);
+        if (index1 == index2 || index1 == index3 || index2 == index3)
+          continue;
+
+        const Eigen::Vector4f p1 = pc.points[index1].getVector4fMap ();
+        const Eigen::Vector4f p2 = pc.points[index2].getVector4fMap ();
+        const Eigen::Vector4f p3 = pc.points[index3].getVector4fMap ();
+
+        // A3
+        Eigen::Vector4f v21 (p2 - p1);
+        Eigen::Vector4f v31 (p3 - p1);
+        Eigen::Vector4f v23 (p2 - p3);
+        a = v21.norm (); b = v31.norm (); c = v23.norm (); s = (a+b+c) * 0.5f;
+        if (s * (s-a) * (s-b) * (s-c) <= 0.001f)
+        {
+          degenerate = true;
+          break;
+        }
 
-    v21.normalize ();
-    v31.normalize ();
-    v23.normalize ();
+        v21.normalize ();
+        v31.normalize ();
+        v23.normalize ();
+
+        // Rounding may push the cosines of parallel sides past 1
+        th1 = static_cast<int> (pcl_round (acos ((std::min) (fabs (v21.dot (v31)), 1.0f)) / pih * (binsize-1)));
+        th2 = static_cast<int> (pcl_round (acos ((std::min) (fabs (v23.dot (v31)), 1.0f)) / pih * (binsize-1)));
+        th3 = static_cast<int> (pcl_round (acos ((std::min) (fabs (v23.dot (v21)), 1.0f)) / pih * (binsize-1)));
+        if (th1 < 0 || th1 >= binsize || th2 < 0 || th2 >= binsize || th3 < 0 || th3 >= binsize)
+          continue;
+        break;
+      }
+      if (degenerate)
+        continue;
+
+      // D2
+      d2v[nn_idx * 3 + 0] = pcl::euclideanDistance (pc.points[index1], pc.points[index2]);
+      d2v[nn_idx * 3 + 1] = pcl::euclideanDistance (pc.points[index1], pc.points[index3]);
+      d2v[nn_idx * 3 + 2] = pcl::euclideanDistance (pc.points[index2], pc.points[index3]);
+
+      // IN, OUT, MIXED, Ratio line tracing, index1->index2, index1->index3 and index2->index3
+      const int x1 = toGrid (pc.points[index1].x), y1 = toGrid (pc.points[index1].y), z1 = toGrid (pc.points[index1].z);
+      const int x2 = toGrid (pc.points[index2].x), y2 = toGrid (pc.points[index2].y), z2 = toGrid (pc.points[index2].z);
+      const int x3 = toGrid (pc.points[index3].x), y3 = toGrid (pc.points[index3].y), z3 = toGrid (pc.points[index3].z);
+      float ratio = 0.0f;
+      int vxlcnt, pcnt1, pcnt2, pcnt3;
+      int vxlcnt_sum = 0;
+
+      wt_d2[nn_idx * 3 + 0] = lci (x1, y1, z1, x2, y2, z2, ratio, vxlcnt, pcnt1);
+      if (wt_d2[nn_idx * 3 + 0] == 2)
+        t_mix_ratio[static_cast<int> (pcl_round (ratio * (binsize-1)))]++;
+      vxlcnt_sum += vxlcnt;
 
-    //TODO: .dot gives nan's
-    th1 = static_cast<int> (pcl_round (acos (fabs (v21.dot (v31))) / pih * (binsize-1)));
-    th2 = static_cast<int> (pcl_round (acos (fabs (v23.dot (v31))) / pih * (binsize-1)));
-    th3 = static_cast<int> (pcl_round (acos (fabs (v23.dot (v21))) / pih * (binsize-1)));
-    if (th1 < 0 || th1 >= binsize)
-    {
-      nn_idx--;
-      continue;
-    }
-    if (th2 < 0 || th2 >= binsize)
-    {
-      nn_idx--;
-      continue;
-    }
-    if (th3 < 0 || th3 >= binsize)
-    {
-      nn_idx--;
-      continue;
-    }
+      wt_d2[nn_idx * 3 + 1] = lci (x1, y1, z1, x3, y3, z3, ratio, vxlcnt, pcnt2);
+      if (wt_d2[nn_idx * 3 + 1] == 2)
+        t_mix_ratio[static_cast<int> (pcl_round (ratio * (binsize-1)))]++;
+      vxlcnt_sum += vxlcnt;
 
-    //pcl::PointXYZ cog(((rand()%100)-50.0f) / 100.0f,((rand()%100)-50.0f) / 100.0f,((rand()%100)-50.0f) / 100.0f);
-    // D1
-    //                      d1v.push_back( pcl::euclideanDistance(cog, pc.points[index1]) );
+      wt_d2[nn_idx * 3 + 2] = lci (x2, y2, z2, x3, y3, z3, ratio, vxlcnt, pcnt3);
+      if (wt_d2[nn_idx * 3 + 2] == 2)
+        t_mix_ratio[static_cast<int> (pcl_round (ratio * (binsize-1)))]++;
+      vxlcnt_sum += vxlcnt;
 
-    // D2
-    d2v.push_back (pcl::euclideanDistance (pc.points[index1], pc.points[index2]));
-    d2v.push_back (pcl::euclideanDistance (pc.points[index1], pc.points[index3]));
-    d2v.push_back (pcl::euclideanDistance (pc.points[index2], pc.points[index3]));
+      const int p_cnt = pcnt1 + pcnt2 + pcnt3;
 
-    int vxlcnt_sum = 0;
-    int p_cnt = 0;
-    // IN, OUT, MIXED, Ratio line tracing, index1->index2
-    {
-      const int xs = p1[0] < 0.0? static_cast<int>(floor(p1[0])+GRIDSIZE_H): static_cast<int>(ceil(p1[0])+GRIDSIZE_H-1);
-      const int ys = p1[1] < 0.0? static_cast<int>(floor(p1[1])+GRIDSIZE_H): static_cast<int>(ceil(p1[1])+GRIDSIZE_H-1);
-      const int zs = p1[2] < 0.0? static_cast<int>(floor(p1[2])+GRIDSIZE_H): static_cast<int>(ceil(p1[2])+GRIDSIZE_H-1);
-      const int xt = p2[0] < 0.0? static_cast<int>(floor(p2[0])+GRIDSIZE_H): static_cast<int>(ceil(p2[0])+GRIDSIZE_H-1);
-      const int yt = p2[1] < 0.0? static_cast<int>(floor(p2[1])+GRIDSIZE_H): static_cast<int>(ceil(p2[1])+GRIDSIZE_H-1);
-      const int zt = p2[2] < 0.0? static_cast<int>(floor(p2[2])+GRIDSIZE_H): static_cast<int>(ceil(p2[2])+GRIDSIZE_H-1);
-      wt_d2.push_back (this->lci (xs, ys, zs, xt, yt, zt, ratio, vxlcnt, pcnt1));
-      if (wt_d2.back () == 2)
-        h_mix_ratio[static_cast<int> (pcl_round (ratio * (binsize-1)))]++;
-      vxlcnt_sum += vxlcnt;
-      p_cnt += pcnt1;
-    }
-    // IN, OUT, MIXED, Ratio line tracing, index1->index3
-    {
-      const int xs = p1[0] < 0.0? static_cast<int>(floor(p1[0])+GRIDSIZE_H): static_cast<int>(ceil(p1[0])+GRIDSIZE_H-1);
-      const int ys = p1[1] < 0.0? static_cast<int>(floor(p1[1])+GRIDSIZE_H): static_cast<int>(ceil(p1[1])+GRIDSIZE_H-1);
-      const int zs = p1[2] < 0.0? static_cast<int>(floor(p1[2])+GRIDSIZE_H): static_cast<int>(ceil(p1[2])+GRIDSIZE_H-1);
-      const int xt = p3[0] < 0.0? static_cast<int>(floor(p3[0])+GRIDSIZE_H): static_cast<int>(ceil(p3[0])+GRIDSIZE_H-1);
-      const int yt = p3[1] < 0.0? static_cast<int>(floor(p3[1])+GRIDSIZE_H): static_cast<int>(ceil(p3[1])+GRIDSIZE_H-1);
-      const int zt = p3[2] < 0.0? static_cast<int>(floor(p3[2])+GRIDSIZE_H): static_cast<int>(ceil(p3[2])+GRIDSIZE_H-1);
-      wt_d2.push_back (this->lci (xs, ys, zs, xt, yt, zt, ratio, vxlcnt, pcnt2));
-      if (wt_d2.back () == 2)
-        h_mix_ratio[static_cast<int>(pcl_round (ratio * (binsize-1)))]++;
-      vxlcnt_sum += vxlcnt;
-      p_cnt += pcnt2;
-    }
-    // IN, OUT, MIXED, Ratio line tracing, index2->index3
-    {
-      const int xs = p2[0] < 0.0? static_cast<int>(floor(p2[0])+GRIDSIZE_H): static_cast<int>(ceil(p2[0])+GRIDSIZE_H-1);
-      const int ys = p2[1] < 0.0? static_cast<int>(floor(p2[1])+GRIDSIZE_H): static_cast<int>(ceil(p2[1])+GRIDSIZE_H-1);
-      const int zs = p2[2] < 0.0? static_cast<int>(floor(p2[2])+GRIDSIZE_H): static_cast<int>(ceil(p2[2])+GRIDSIZE_H-1);
-      const int xt = p3[0] < 0.0? static_cast<int>(floor(p3[0])+GRIDSIZE_H): static_cast<int>(ceil(p3[0])+GRIDSIZE_H-1);
-      const int yt = p3[1] < 0.0? static_cast<int>(floor(p3[1])+GRIDSIZE_H): static_cast<int>(ceil(p3[1])+GRIDSIZE_H-1);
-      const int zt = p3[2] < 0.0? static_cast<int>(floor(p3[2])+GRIDSIZE_H): static_cast<int>(ceil(p3[2])+GRIDSIZE_H-1);
-      wt_d2.push_back (this->lci (xs,ys,zs,xt,yt,zt,ratio,vxlcnt,pcnt3));
-      if (wt_d2.back () == 2)
-        h_mix_ratio[static_cast<int>(pcl_round(ratio * (binsize-1)))]++;
-      vxlcnt_sum += vxlcnt;
-      p_cnt += pcnt3;
+      // D3 ( herons formula )
+      d3v[nn_idx] = sqrtf (sqrtf (s * (s-a) * (s-b) * (s-c)));
+      if (vxlcnt_sum <= 21)
+      {
+        wt_d3[nn_idx] = 0;
+        t_a3_out[th1] += static_cast<float> (pcnt3) / 32.0f;
+        t_a3_out[th2] += static_cast<float> (pcnt1) / 32.0f;
+        t_a3_out[th3] += static_cast<float> (pcnt2) / 32.0f;
+      }
+      else
+        if (p_cnt - vxlcnt_sum < 4)
+        {
+          t_a3_in[th1] += static_cast<float> (pcnt3) / 32.0f;
+          t_a3_in[th2] += static_cast<float> (pcnt1) / 32.0f;
+          t_a3_in[th3] += static_cast<float> (pcnt2) / 32.0f;
+          wt_d3[nn_idx] = 1;
+        }
+        else
+        {
+          t_a3_mix[th1] += static_cast<float> (pcnt3) / 32.0f;
+          t_a3_mix[th2] += static_cast<float> (pcnt1) / 32.0f;
+          t_a3_mix[th3] += static_cast<float> (pcnt2) / 32.0f;
+          wt_d3[nn_idx] = static_cast<float> (vxlcnt_sum) / static_cast<float> (p_cnt);
+        }
+      valid[nn_idx] = 1;
     }
 
-    // D3 ( herons formula )
-    d3v.push_back (sqrt (sqrt (s * (s-a) * (s-b) * (s-c))));
-    if (vxlcnt_sum <= 21)
+#pragma omp critical
+    for (int i = 0; i < binsize; ++i)
     {
-      wt_d3.push_back (0);
-      h_a3_out[th1] += static_cast<float> (pcnt3) / 32.0f;
-      h_a3_out[th2] += static_cast<float> (pcnt1) / 32.0f;
-      h_a3_out[th3] += static_cast<float> (pcnt2) / 32.0f;
+      h_mix_ratio[i] += t_mix_ratio[i];
+      h_a3_in[i] += t_a3_in[i];
+      h_a3_out[i] += t_a3_out[i];
+      h_a3_mix[i] += t_a3_mix[i];
     }
-    else
-      if (p_cnt - vxlcnt_sum < 4)
-      {
-        h_a3_in[th1] += static_cast<float> (pcnt3) / 32.0f;
-        h_a3_in[th2] += static_cast<float> (pcnt1) / 32.0f;
-        h_a3_in[th3] += static_cast<float> (pcnt2) / 32.0f;
-        wt_d3.push_back (1);
-      }
-      else
-      {
-        h_a3_mix[th1] += static_cast<float> (pcnt3) / 32.0f;
-        h_a3_mix[th2] += static_cast<float> (pcnt1) / 32.0f;
-        h_a3_mix[th3] += static_cast<float> (pcnt2) / 32.0f;
-        wt_d3.push_back (static_cast<float> (vxlcnt_sum) / static_cast<float> (p_cnt));
-      }
   }
+
   // Normalizing, get max
-  float maxd1 = 0;
   float maxd2 = 0;
   float maxd3 = 0;
-
-  for (size_t nn_idx = 0; nn_idx < sample_size; ++nn_idx)
+  for (int nn_idx = 0; nn_idx < sample_size; ++nn_idx)
   {
-    // get max of Dx
-    if (d1v[nn_idx] > maxd1)
-      maxd1 = d1v[nn_idx];
-    if (d2v[nn_idx] > maxd2)
-      maxd2 = d2v[nn_idx];
-    if (d2v[sample_size + nn_idx] > maxd2)
-      maxd2 = d2v[sample_size + nn_idx];
-    if (d2v[sample_size*2 +nn_idx] > maxd2)
-      maxd2 = d2v[sample_size*2 +nn_idx];
+    if (!valid[nn_idx])
+      continue;
+    for (int k = 0; k < 3; ++k)
+      if (d2v[nn_idx * 3 + k] > maxd2)
+        maxd2 = d2v[nn_idx * 3 + k];
     if (d3v[nn_idx] > maxd3)
       maxd3 = d3v[nn_idx];
   }
 
   // Normalize and create histogram
   int index;
-  for (size_t nn_idx = 0; nn_idx < sample_size; ++nn_idx)
+  for (int nn_idx = 0; nn_idx < sample_size; ++nn_idx)
   {
-    h_d1[static_cast<int>(pcl_round (d1v[nn_idx] / maxd1 * (binsize-1)))]++ ;
+    if (!valid[nn_idx])
+      continue;
 
-    if (wt_d3[nn_idx] >= 0.999) // IN
+    index = static_cast<int>(pcl_round (d3v[nn_idx] / maxd3 * (binsize-1)));
+    if (index >= 0 && index < binsize)
     {
-      index = static_cast<int>(pcl_round (d3v[nn_idx] / maxd3 * (binsize-1)));
-      if (index >= 0 && index < binsize)
+      if (wt_d3[nn_idx] >= 0.999) // IN
         h_d3_in[index]++;
+      else if (wt_d3[nn_idx] <= 0.001) // OUT
+        h_d3_out[index]++;
+      else
+        h_d3_mix[index]++;
     }
-    else
+
+    for (int k = 0; k < 3; ++k)
     {
-      if (wt_d3[nn_idx] <= 0.001) // OUT
-      {
-        index = static_cast<int>(pcl_round (d3v[nn_idx] / maxd3 * (binsize-1)));
-        if (index >= 0 && index < binsize)
-          h_d3_out[index]++ ;
-      }
-      else
-      {
-        index = static_cast<int>(pcl_round (d3v[nn_idx] / maxd3 * (binsize-1)));
-        if (index >= 0 && index < binsize)
-          h_d3_mix[index]++;
-      }
+      index = static_cast<int>(pcl_round (d2v[nn_idx * 3 + k] / maxd2 * (binsize-1)));
+      if (wt_d2[nn_idx * 3 + k] == 0)
+        h_in[index]++;
+      if (wt_d2[nn_idx * 3 + k] == 1)
+        h_out[index]++;
+      if (wt_d2[nn_idx * 3 + k] == 2)
+        h_mix[index]++;
     }
   }
-  //normalize and create histogram
-  for (size_t nn_idx = 0; nn_idx < d2v.size(); ++nn_idx )
-  {
-    if (wt_d2[nn_idx] == 0)
-      h_in[static_cast<int>(pcl_round (d2v[nn_idx] / maxd2 * (binsize-1)))]++ ;
-    if (wt_d2[nn_idx] == 1)
-      h_out[static_cast<int>(pcl_round (d2v[nn_idx] / maxd2 * (binsize-1)))]++;
-    if (wt_d2[nn_idx] == 2)
-      h_mix[static_cast<int>(pcl_round (d2v[nn_idx] / maxd2 * (binsize-1)))]++ ;
-  }
 
   //float weights[10] = {1,  1,  1,  1,  1,  1,  1,  1 , 1 ,  1};
   float weights[10] = {0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 1.0f,  1.0f, 2.0f, 2.0f, 2.0f};
@@ -311,7 +282,7 @@ template <typename PointInT, typename PointOutT> int
 pcl::ESFEstimation<PointInT, PointOutT>::lci (
     const int x1, const int y1, const int z1, 
     const int x2, const int y2, const int z2, 
-    float &ratio, int &incnt, int &pointcount)
+    float &ratio, int &incnt, int &pointcount) const
 {
   int voxelcount = 0;
   int voxel_in = 0;
@@ -348,7 +319,7 @@ pcl::ESFEstimation<PointInT, PointOutT>::lci (
     for (int i = 1; i<l; i++)
     {
       voxelcount++;;
-      voxel_in +=  static_cast<int>(lut_[act_voxel[0]][act_voxel[1]][act_voxel[2]] == 1);
+      voxel_in +=  static_cast<int>(lut_[lutIndex (act_voxel[0], act_voxel[1], act_voxel[2])] == 1);
       if (err_1 > 0)
       {
         act_voxel[1] += y_inc;
@@ -371,7 +342,7 @@ pcl::ESFEstimation<PointInT, PointOutT>::lci (
     for (int i=1; i<m; i++)
     {
       voxelcount++;
-      voxel_in +=  static_cast<int>(lut_[act_voxel[0]][act_voxel[1]][act_voxel[2]] == 1);
+      voxel_in +=  static_cast<int>(lut_[lutIndex (act_voxel[0], act_voxel[1], act_voxel[2])] == 1);
       if (err_1 > 0)
       {
         act_voxel[0] +=  x_inc;
@@ -394,7 +365,7 @@ pcl::ESFEstimation<PointInT, PointOutT>::lci (
     for (int i=1; i<n; i++)
     {
       voxelcount++;
-      voxel_in +=  static_cast<int>(lut_[act_voxel[0]][act_voxel[1]][act_voxel[2]] == 1);
+      voxel_in +=  static_cast<int>(lut_[lutIndex (act_voxel[0], act_voxel[1], act_voxel[2])] == 1);
       if (err_1 > 0)
       {
         act_voxel[1] += y_inc;
@@ -411,7 +382,7 @@ pcl::ESFEstimation<PointInT, PointOutT>::lci (
     }
   }
   voxelcount++;
-  voxel_in +=  static_cast<int>(lut_[act_voxel[0]][act_voxel[1]][act_voxel[2]] == 1);
+  voxel_in +=  static_cast<int>(lut_[lutIndex (act_voxel[0], act_voxel[1], act_voxel[2])] == 1);
   incnt = voxel_in;
   pointcount = voxelcount;
 
@@ -432,9 +403,9 @@ pcl::ESFEstimation<PointInT, PointOutT>::voxelize9 (PointCloudIn &cluster)
   int xi,yi,zi,xx,yy,zz;
   for (size_t i = 0; i < cluster.points.size (); ++i)
   {
-    xx = cluster.points[i].x<0.0? static_cast<int>(floor(cluster.points[i].x)+GRIDSIZE_H) : static_cast<int>(ceil(cluster.points[i].x)+GRIDSIZE_H-1);
-    yy = cluster.points[i].y<0.0? static_cast<int>(floor(cluster.points[i].y)+GRIDSIZE_H) : static_cast<int>(ceil(cluster.points[i].y)+GRIDSIZE_H-1);
-    zz = cluster.points[i].z<0.0? static_cast<int>(floor(cluster.points[i].z)+GRIDSIZE_H) : static_cast<int>(ceil(cluster.points[i].z)+GRIDSIZE_H-1);
+    xx = toGrid (cluster.points[i].x);
+    yy = toGrid (cluster.points[i].y);
+    zz = toGrid (cluster.points[i].z);
 
     for (int x = -1; x < 2; x++)
       for (int y = -1; y < 2; y++)
@@ -449,7 +420,7 @@ pcl::ESFEstimation<PointInT, PointOutT>::voxelize9 (PointCloudIn &cluster)
             ;//ROS_WARN ("[xx][yy][zz] : %d %d %d ",xi,yi,zi);
           }
           else
-            this->lut_[xi][yi][zi] = 1;
+            this->lut_[lutIndex (xi, yi, zi)] = 1;
         }
   }
 }
@@ -461,9 +432,9 @@ pcl::ESFEstimation<PointInT, PointOutT>::cleanup9 (PointCloudIn &cluster)
   int xi,yi,zi,xx,yy,zz;
   for (size_t i = 0; i < cluster.points.size (); ++i)
   {
-    xx = cluster.points[i].x<0.0? static_cast<int>(floor(cluster.points[i].x)+GRIDSIZE_H) : static_cast<int>(ceil(cluster.points[i].x)+GRIDSIZE_H-1);
-    yy = cluster.points[i].y<0.0? static_cast<int>(floor(cluster.points[i].y)+GRIDSIZE_H) : static_cast<int>(ceil(cluster.points[i].y)+GRIDSIZE_H-1);
-    zz = cluster.points[i].z<0.0? static_cast<int>(floor(cluster.points[i].z)+GRIDSIZE_H) : static_cast<int>(ceil(cluster.points[i].z)+GRIDSIZE_H-1);
+    xx = toGrid (cluster.points[i].x);
+    yy = toGrid (cluster.points[i].y);
+    zz = toGrid (cluster.points[i].z);
 
     for (int x = -1; x < 2; x++)
       for (int y = -1; y < 2; y++)
@@ -478,7 +449,7 @@ pcl::ESFEstimation<PointInT, PointOutT>::cleanup9 (PointCloudIn &cluster)
             ;//ROS_WARN ("[xx][yy][zz] : %d %d %d ",xi,yi,zi);
           }
           else
-            this->lut_[xi][yi][zi] = 0;
+            this->lut_[lutIndex (xi, yi, zi)] = 0;
         }
   }
 }
@@ -512,6 +483,14 @@ pcl::ESFEstimation<PointInT, PointOutT>::scale_points_unit_sphere (
 template <typename PointInT, typename PointOutT> void
 pcl::ESFEstimation<PointInT, PointOutT>::computeFeature (PointCloudOut &output)
 {
+  if (surface_->points.size () < 3)
+  {
+    PCL_ERROR ("[pcl::%s::computeFeature] At least 3 points are needed to sample triangles!\n", getClassName ().c_str ());
+    output.width = output.height = 0;
+    output.points.clear ();
+    return;
+  }
+
   Eigen::Vector4f xyz_centroid;
   std::vector<float> hist;
   scale_points_unit_sphere (*surface_, static_cast<float>(GRIDSIZE_H), xyz_centroid);
@@ -257,6 +257,58 @@ pcl::Feature<PointInT, PointOutT>::computeEigen (pcl::PointCloud<Eigen::MatrixXf
   deinitCompute ();
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::Feature<PointInT, PointOutT>::searchForNeighborhoods (double parameter, unsigned int nr_threads,
+                                                           std::vector<int> &nn_offsets, std::vector<int> &nn_indices,
+                                                           std::vector<float> &nn_dists,
+                                                           const std::vector<unsigned char> &skip_queries) const
+{
+  const int threads = static_cast<int> (nr_threads);
+  const int nr_queries = static_cast<int> (indices_->size ());
+
+  // The neighborhoods of a block of queries go to the buffers of that block, which are then concatenated
+  const int block_size = 256;
+  const int nr_blocks = (nr_queries + block_size - 1) / block_size;
+  std::vector<std::vector<int> > block_indices (nr_blocks);
+  std::vector<std::vector<float> > block_dists (nr_blocks);
+  nn_offsets.assign (nr_queries + 1, 0);
+
+#pragma omp parallel num_threads (threads)
+  {
+    std::vector<int> indices;
+    std::vector<float> dists;
+
+#pragma omp for schedule (dynamic, 1)
+    for (int block = 0; block < nr_blocks; ++block)
+    {
+      const int end = std::min (nr_queries, (block + 1) * block_size);
+      for (int idx = block * block_size; idx < end; ++idx)
+      {
+        if ((!skip_queries.empty () && skip_queries[idx]) || !isFinite ((*input_)[(*indices_)[idx]]) ||
+            searchForNeighbors ((*indices_)[idx], parameter, indices, dists) == 0)
+          continue;
+        block_indices[block].insert (block_indices[block].end (), indices.begin (), indices.end ());
+        block_dists[block].insert (block_dists[block].end (), dists.begin (), dists.end ());
+        nn_offsets[idx + 1] = static_cast<int> (indices.size ());
+      }
+    }
+  }
+
+  for (int idx = 0; idx < nr_queries; ++idx)
+    nn_offsets[idx + 1] += nn_offsets[idx];
+  nn_indices.resize (nn_offsets[nr_queries]);
+  nn_dists.resize (nn_offsets[nr_queries]);
+  for (int block = 0; block < nr_blocks; ++block)
+  {
+    const int begin = nn_offsets[block * block_size];
+    std::copy (block_indices[block].begin (), block_indices[block].end (), nn_indices.begin () + begin);
+    std::copy (block_dists[block].begin (), block_dists[block].end (), nn_dists.begin () + begin);
+    std::vector<int> ().swap (block_indices[block]);
+    std::vector<float> ().swap (block_dists[block]);
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -328,8 +380,15 @@ template <typename PointInT, typename PointRFT> bool
 pcl::FeatureWithLocalReferenceFrames<PointInT, PointRFT>::initLocalReferenceFrames (const size_t& indices_size,
                                                                                     const LRFEstimationPtr& lrf_estimation)
 {
+  uint64_t checksum = 0;
   if (frames_never_defined_)
-    frames_.reset ();
+  {
+    // Keep the frames estimated by default in a previous call if they were estimated from the same data
+    if (lrf_estimation)
+      checksum = computeFramesChecksum (lrf_estimation);
+    if (checksum == 0 || checksum != default_frames_checksum_)
+      frames_.reset ();
+  }
 
   // Check if input frames are set
   if (!frames_)
@@ -344,6 +403,7 @@ pcl::FeatureWithLocalReferenceFrames<PointInT, PointRFT>::initLocalReferenceFram
       PointCloudLRFPtr default_frames (new PointCloudLRF());
       lrf_estimation->compute (*default_frames);
       frames_ = default_frames;
+      default_frames_checksum_ = checksum;
     }
   }
 
@@ -360,11 +420,61 @@ pcl::FeatureWithLocalReferenceFrames<PointInT, PointRFT>::initLocalReferenceFram
       PointCloudLRFPtr default_frames (new PointCloudLRF());
       lrf_estimation->compute (*default_frames);
       frames_ = default_frames;
+      default_frames_checksum_ = 0;
     }
   }
 
   return (true);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointRFT> uint64_t
+pcl::FeatureWithLocalReferenceFrames<PointInT, PointRFT>::computeFramesChecksum (const LRFEstimationPtr& lrf_estimation)
+{
+  // FNV-1a over the raw bits of the data the frames depend on, cheap compared to the estimation itself
+  uint64_t checksum = 14695981039346656037ULL;
+  const uint64_t prime = 1099511628211ULL;
+
+  const typename pcl::PointCloud<PointInT>::ConstPtr input = lrf_estimation->getInputCloud ();
+  const typename pcl::PointCloud<PointInT>::ConstPtr surface = lrf_estimation->getSearchSurface ();
+  const pcl::IndicesPtr indices = lrf_estimation->getIndices ();
+  if (!input)
+    return (0);
+
+  const double parameters[2] = {lrf_estimation->getRadiusSearch (), static_cast<double> (lrf_estimation->getKSearch ())};
+  for (int i = 0; i < 2; ++i)
+  {
+    uint64_t bits;
+    memcpy (&bits, &parameters[i], sizeof (bits));
+    checksum = (checksum ^ bits) * prime;
+  }
+
+  for (int c = 0; c < 2; ++c)
+  {
+    const pcl::PointCloud<PointInT> *cloud = (c == 0) ? input.get () : surface.get ();
+    if (!cloud)
+      continue;
+    checksum = (checksum ^ cloud->points.size ()) * prime;
+    for (size_t i = 0; i < cloud->points.size (); ++i)
+    {
+      uint32_t bits[3];
+      memcpy (bits, cloud->points[i].data, sizeof (bits));
+      checksum = (checksum ^ bits[0]) * prime;
+      checksum = (checksum ^ bits[1]) * prime;
+      checksum = (checksum ^ bits[2]) * prime;
+    }
+  }
+
+  if (indices)
+  {
+    checksum = (checksum ^ indices->size ()) * prime;
+    for (size_t i = 0; i < indices->size (); ++i)
+      checksum = (checksum ^ static_cast<uint32_t> ((*indices)[i])) * prime;
+  }
+
+  // 0 marks frames which cannot be reused
+  return (checksum != 0 ? checksum : 1);
+}
+
 #endif  //#ifndef PCL_FEATURES_IMPL_FEATURE_H_
 
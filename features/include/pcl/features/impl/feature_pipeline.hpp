@@ -0,0 +1,209 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FEATURES_IMPL_FEATURE_PIPELINE_H_
+#define PCL_FEATURES_IMPL_FEATURE_PIPELINE_H_
+
+#include <pcl/features/feature_pipeline.h>
+#include <pcl/search/pcl_search.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::NeighborhoodCache<PointT>::compute (const PointCloudConstPtr &cloud, const std::vector<int> &indices,
+                                         double radius, unsigned int nr_threads)
+{
+  clear ();
+  cloud_ = cloud;
+  radius_ = radius;
+  slots_.resize (cloud->points.size (), -1);
+  neighbors_.resize (indices.size ());
+  distances_.resize (indices.size ());
+  // Invalid points have no neighborhood, their searches are forwarded. A point given twice is searched once.
+  for (size_t i = 0; i < indices.size (); ++i)
+    slots_[indices[i]] = (cloud->is_dense || isFinite (cloud->points[indices[i]])) ? static_cast<int> (i) : -1;
+
+  const int nr_queries = static_cast<int> (indices.size ());
+  const int threads = static_cast<int> (nr_threads == 0 ? 1 : nr_threads);
+#pragma omp parallel for schedule (dynamic, 64) num_threads (threads)
+  for (int i = 0; i < nr_queries; ++i)
+  {
+    if (slots_[indices[i]] == i)
+      search_->radiusSearch (*cloud, indices[i], radius, neighbors_[i], distances_[i]);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::NeighborhoodCache<PointT>::setNeighborhoods (const PointCloudConstPtr &cloud, const std::vector<int> &indices,
+                                                  const std::vector<std::vector<int> > &neighbors,
+                                                  const std::vector<std::vector<float> > &sqr_distances)
+{
+  if (neighbors.size () != indices.size () || sqr_distances.size () != indices.size ())
+  {
+    PCL_ERROR ("[pcl::NeighborhoodCache::setNeighborhoods] The neighbor graph does not match the query points!\n");
+    return;
+  }
+  // The graph must stay valid when the estimators set the input cloud of the search method
+  setInputCloud (cloud);
+
+  clear ();
+  cloud_ = cloud;
+  nearest_ = true;
+  slots_.resize (cloud->points.size (), -1);
+  for (size_t i = 0; i < indices.size (); ++i)
+  {
+    if (neighbors[i].size () == sqr_distances[i].size ())
+      slots_[indices[i]] = static_cast<int> (i);
+  }
+  neighbors_ = neighbors;
+  distances_ = sqr_distances;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::NeighborhoodCache<PointT>::clear ()
+{
+  cloud_.reset ();
+  radius_ = 0;
+  nearest_ = false;
+  slots_.clear ();
+  neighbors_.clear ();
+  distances_.clear ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::NeighborhoodCache<PointT>::setInputCloud (const PointCloudConstPtr &cloud, const IndicesConstPtr &indices)
+{
+  if (cloud != search_->getInputCloud () || indices != search_->getIndices ())
+  {
+    clear ();
+    search_->setInputCloud (cloud, indices);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::NeighborhoodCache<PointT>::nearestKSearch (const PointCloud &cloud, int index, int k,
+                                                std::vector<int> &k_indices, std::vector<float> &k_sqr_distances) const
+{
+  const int slot = (nearest_ && &cloud == cloud_.get ()) ? slots_[index] : -1;
+  if (slot == -1 || k <= 0 || static_cast<int> (neighbors_[slot].size ()) < k)
+    return (search_->nearestKSearch (cloud, index, k, k_indices, k_sqr_distances));
+
+  // The lists are sorted, so their first k entries are the k nearest neighbors
+  k_indices.assign (neighbors_[slot].begin (), neighbors_[slot].begin () + k);
+  k_sqr_distances.assign (distances_[slot].begin (), distances_[slot].begin () + k);
+  return (k);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::NeighborhoodCache<PointT>::radiusSearch (const PointCloud &cloud, int index, double radius,
+                                              std::vector<int> &k_indices, std::vector<float> &k_sqr_distances,
+                                              unsigned int max_nn) const
+{
+  const int slot = (!nearest_ && &cloud == cloud_.get () && radius <= radius_) ? slots_[index] : -1;
+  if (slot == -1)
+    return (search_->radiusSearch (cloud, index, radius, k_indices, k_sqr_distances, max_nn));
+
+  const std::vector<int> &neighbors = neighbors_[slot];
+  const std::vector<float> &distances = distances_[slot];
+  if (radius == radius_ && (max_nn == 0 || max_nn >= neighbors.size ()))
+  {
+    k_indices = neighbors;
+    k_sqr_distances = distances;
+    return (static_cast<int> (neighbors.size ()));
+  }
+
+  // Keep the neighbors within the smaller radius, in the same order
+  const float sqr_radius = static_cast<float> (radius * radius);
+  k_indices.clear ();
+  k_sqr_distances.clear ();
+  for (size_t i = 0; i < neighbors.size (); ++i)
+  {
+    if (distances[i] > sqr_radius)
+      continue;
+    k_indices.push_back (neighbors[i]);
+    k_sqr_distances.push_back (distances[i]);
+    if (k_indices.size () == max_nn)
+      break;
+  }
+  return (static_cast<int> (k_indices.size ()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT> void
+pcl::FeaturePipeline<PointInT>::compute ()
+{
+  if (!PCLBase<PointInT>::initCompute ())
+    return;
+
+  const PointCloudInConstPtr surface = surface_ ? surface_ : input_;
+
+  // Check if a space search locator was given
+  if (!tree_)
+  {
+    if (surface->isOrganized () && input_->isOrganized ())
+      tree_.reset (new pcl::search::OrganizedNeighbor<PointInT> ());
+    else
+      tree_.reset (new pcl::search::KdTree<PointInT> (false));
+  }
+  if (tree_->getInputCloud () != surface) // Make sure the tree searches the surface
+    tree_->setInputCloud (surface);
+
+  // Search the neighborhoods once for the largest radius
+  double radius = 0;
+  for (size_t i = 0; i < stages_.size (); ++i)
+    radius = std::max (radius, stages_[i]->getRadiusSearch ());
+
+  typename NeighborhoodCache<PointInT>::Ptr cache (new NeighborhoodCache<PointInT> (tree_));
+  if (radius > 0)
+    cache->compute (input_, *indices_, radius, threads_);
+
+  for (size_t i = 0; i < stages_.size (); ++i)
+    stages_[i]->compute (input_, indices_, surface, cache);
+
+  PCLBase<PointInT>::deinitCompute ();
+}
+
+#define PCL_INSTANTIATE_NeighborhoodCache(T) template class PCL_EXPORTS pcl::NeighborhoodCache<T>;
+#define PCL_INSTANTIATE_FeaturePipeline(T) template class PCL_EXPORTS pcl::FeaturePipeline<T>;
+
+#endif    // PCL_FEATURES_IMPL_FEATURE_PIPELINE_H_
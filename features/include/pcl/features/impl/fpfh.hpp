@@ -47,7 +47,7 @@
 template <typename PointInT, typename PointNT, typename PointOutT> bool
 pcl::FPFHEstimation<PointInT, PointNT, PointOutT>::computePairFeatures (
     const pcl::PointCloud<PointInT> &cloud, const pcl::PointCloud<PointNT> &normals,
-    int p_idx, int q_idx, float &f1, float &f2, float &f3, float &f4)
+    int p_idx, int q_idx, float &f1, float &f2, float &f3, float &f4) const
 {
   pcl::computePairFeatures (cloud.points[p_idx].getVector4fMap (), normals.points[p_idx].getNormalVector4fMap (),
       cloud.points[q_idx].getVector4fMap (), normals.points[q_idx].getNormalVector4fMap (),
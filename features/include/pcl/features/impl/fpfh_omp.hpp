@@ -44,101 +44,151 @@
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointNT, typename PointOutT> void
-pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut &output)
+pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::computeSPFHRow (
+    int p_idx, const int *indices, int nr_indices, float *spfh) const
 {
-  std::vector<int> spfh_indices_vec;
-  std::vector<int> spfh_hist_lookup (surface_->points.size ());
-
-  // Build a list of (unique) indices for which we will need to compute SPFH signatures
-  // (We need an SPFH signature for every point that is a neighbor of any point in input_[indices_])
-  if (surface_ != input_ ||
-      indices_->size () != surface_->points.size ())
-  { 
-    std::vector<int> nn_indices (k_); // \note These resizes are irrelevant for a radiusSearch ().
-    std::vector<float> nn_dists (k_); 
-
-    std::set<int> spfh_indices_set;
-    for (size_t idx = 0; idx < indices_->size (); ++idx)
-    {
-      int p_idx = (*indices_)[idx];
-      if (this->searchForNeighbors (p_idx, search_parameter_, nn_indices, nn_dists) == 0)
-        continue;
-      
-      spfh_indices_set.insert (nn_indices.begin (), nn_indices.end ());
-    }
-    spfh_indices_vec.resize (spfh_indices_set.size ());
-    std::copy (spfh_indices_set.begin (), spfh_indices_set.end (), spfh_indices_vec.begin ());
-  }
-  else
-  {
-    // Special case: When a feature must be computed at every point, there is no need for a neighborhood search
-    spfh_indices_vec.resize (indices_->size ());
-    for (int idx = 0; idx < static_cast<int> (indices_->size ()); ++idx)
-      spfh_indices_vec[idx] = idx;
-  }
+  Eigen::Vector4f pfh_tuple;
+  float *hist_f1 = spfh;
+  float *hist_f2 = hist_f1 + nr_bins_f1_;
+  float *hist_f3 = hist_f2 + nr_bins_f2_;
 
-  // Initialize the arrays that will store the SPFH signatures
-  size_t data_size = spfh_indices_vec.size ();
-  hist_f1_.setZero (data_size, nr_bins_f1_);
-  hist_f2_.setZero (data_size, nr_bins_f2_);
-  hist_f3_.setZero (data_size, nr_bins_f3_);
+  // Factorization constant
+  float hist_incr = 100.0f / static_cast<float>(nr_indices - 1);
 
-  // Compute SPFH signatures for every point that needs them
-  
-#pragma omp parallel for schedule (dynamic, threads_)
-  for (int i = 0; i < static_cast<int> (spfh_indices_vec.size ()); ++i)
+  // Iterate over all the points in the neighborhood
+  for (int idx = 0; idx < nr_indices; ++idx)
   {
-    // Get the next point index
-    int p_idx = spfh_indices_vec[i];
+    // Avoid unnecessary returns
+    if (p_idx == indices[idx])
+      continue;
 
-    // Find the neighborhood around p_idx
-    std::vector<int> nn_indices (k_); // \note These resizes are irrelevant for a radiusSearch ().
-    std::vector<float> nn_dists (k_); 
-    if (this->searchForNeighbors (*surface_, p_idx, search_parameter_, nn_indices, nn_dists) == 0)
+    // Compute the pair P to NNi
+    if (!computePairFeatures (*surface_, *normals_, p_idx, indices[idx], pfh_tuple[0], pfh_tuple[1], pfh_tuple[2], pfh_tuple[3]))
       continue;
 
-    // Estimate the SPFH signature around p_idx
-    this->computePointSPFHSignature (*surface_, *normals_, p_idx, i, nn_indices, hist_f1_, hist_f2_, hist_f3_);
+    // Normalize the f1, f2, f3 features and push them in the histogram
+    int h_index = static_cast<int> (floor (nr_bins_f1_ * ((pfh_tuple[0] + M_PI) * d_pi_)));
+    if (h_index < 0)            h_index = 0;
+    if (h_index >= nr_bins_f1_) h_index = nr_bins_f1_ - 1;
+    hist_f1[h_index] += hist_incr;
+
+    h_index = static_cast<int> (floor (nr_bins_f2_ * ((pfh_tuple[1] + 1.0) * 0.5)));
+    if (h_index < 0)            h_index = 0;
+    if (h_index >= nr_bins_f2_) h_index = nr_bins_f2_ - 1;
+    hist_f2[h_index] += hist_incr;
+
+    h_index = static_cast<int> (floor (nr_bins_f3_ * ((pfh_tuple[2] + 1.0) * 0.5)));
+    if (h_index < 0)            h_index = 0;
+    if (h_index >= nr_bins_f3_) h_index = nr_bins_f3_ - 1;
+    hist_f3[h_index] += hist_incr;
+  }
+}
 
-    // Populate a lookup table for converting a point index to its corresponding row in the spfh_hist_* matrices
-    spfh_hist_lookup[p_idx] = i;
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut &output)
+{
+  const int threads = static_cast<int> (threads_);
+  const int nr_queries = static_cast<int> (indices_->size ());
+  const int nr_bins = nr_bins_f1_ + nr_bins_f2_ + nr_bins_f3_;
+  // Pad the SPFH rows to whole packets, so that they are all aligned and summed without a scalar tail
+  const int row_size = (nr_bins + 3) & ~3;
+
+  // First pass: search the neighborhood of every query point once, into a compressed row buffer
+  std::vector<int> nn_offsets, nn_indices;
+  std::vector<float> nn_dists;
+  this->searchForNeighborhoods (search_parameter_, threads_, nn_offsets, nn_indices, nn_dists);
+
+  // Give a row of the SPFH table to every point of the neighborhoods. If the input is the search surface, a query
+  // point has its neighborhood in the buffer already.
+  std::vector<int> spfh_hist_lookup (surface_->points.size (), -1);
+  std::vector<int> query_lookup;
+  if (surface_ == input_)
+  {
+    query_lookup.resize (surface_->points.size (), -1);
+    for (int idx = 0; idx < nr_queries; ++idx)
+      if (nn_offsets[idx + 1] > nn_offsets[idx])
+        query_lookup[(*indices_)[idx]] = idx;
+  }
+  std::vector<int> spfh_indices;
+  for (size_t i = 0; i < nn_indices.size (); ++i)
+  {
+    if (spfh_hist_lookup[nn_indices[i]] != -1)
+      continue;
+    spfh_hist_lookup[nn_indices[i]] = static_cast<int> (spfh_indices.size ());
+    spfh_indices.push_back (nn_indices[i]);
   }
 
-  // Intialize the array that will store the FPFH signature
-  int nr_bins = nr_bins_f1_ + nr_bins_f2_ + nr_bins_f3_;
+  // Compute the SPFH signatures of all the points of the neighborhoods
+  std::vector<float, Eigen::aligned_allocator<float> > spfh_table (spfh_indices.size () * row_size, 0.0f);
 
-  // Iterate over the entire index vector
-#pragma omp parallel for schedule (dynamic, threads_)
-  for (int idx = 0; idx < static_cast<int> (indices_->size ()); ++idx)
+#pragma omp parallel num_threads (threads)
   {
-    // Find the indices of point idx's neighbors...
-    std::vector<int> nn_indices (k_); // \note These resizes are irrelevant for a radiusSearch ().
-    std::vector<float> nn_dists (k_); 
-    if (!isFinite ((*input_)[(*indices_)[idx]]) ||
-        this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
+    std::vector<int> spfh_nn_indices (k_);
+    std::vector<float> spfh_nn_dists (k_);
+
+#pragma omp for schedule (dynamic, 64)
+    for (int i = 0; i < static_cast<int> (spfh_indices.size ()); ++i)
     {
-      for (int d = 0; d < nr_bins; ++d)
-        output.points[idx].histogram[d] = std::numeric_limits<float>::quiet_NaN ();
-  
-      output.is_dense = false;
-      continue;
+      const int p_idx = spfh_indices[i];
+      float *spfh = &spfh_table[i * row_size];
+      if (!query_lookup.empty () && query_lookup[p_idx] != -1)
+      {
+        const int q = query_lookup[p_idx];
+        computeSPFHRow (p_idx, &nn_indices[nn_offsets[q]], nn_offsets[q + 1] - nn_offsets[q], spfh);
+      }
+      else if (this->searchForNeighbors (*surface_, p_idx, search_parameter_, spfh_nn_indices, spfh_nn_dists) != 0)
+        computeSPFHRow (p_idx, &spfh_nn_indices[0], static_cast<int> (spfh_nn_indices.size ()), spfh);
     }
+  }
 
+  // Second pass: weight the SPFH signatures of the stored neighborhoods
+  bool is_dense = true;
 
-    // ... and remap the nn_indices values so that they represent row indices in the spfh_hist_* matrices 
-    // instead of indices into surface_->points
-    for (size_t i = 0; i < nn_indices.size (); ++i)
-      nn_indices[i] = spfh_hist_lookup[nn_indices[i]];
+#pragma omp parallel num_threads (threads)
+  {
+    std::vector<float, Eigen::aligned_allocator<float> > fpfh (row_size);
+    Eigen::Map<Eigen::VectorXf, Eigen::Aligned> fpfh_histogram (&fpfh[0], row_size);
 
-    // Compute the FPFH signature (i.e. compute a weighted combination of local SPFH signatures) ...
-    Eigen::VectorXf fpfh_histogram = Eigen::VectorXf::Zero (nr_bins);
-    weightPointSPFHSignature (hist_f1_, hist_f2_, hist_f3_, nn_indices, nn_dists, fpfh_histogram);
+#pragma omp for schedule (dynamic, 64)
+    for (int idx = 0; idx < nr_queries; ++idx)
+    {
+      if (nn_offsets[idx + 1] == nn_offsets[idx])
+      {
+        for (int d = 0; d < nr_bins; ++d)
+          output.points[idx].histogram[d] = std::numeric_limits<float>::quiet_NaN ();
 
-    // ...and copy it into the output cloud
-    for (int d = 0; d < nr_bins; ++d)
-      output.points[idx].histogram[d] = fpfh_histogram[d];
+        is_dense = false;
+        continue;
+      }
+
+      fpfh_histogram.setZero ();
+      for (int i = nn_offsets[idx]; i < nn_offsets[idx + 1]; ++i)
+      {
+        // Minus the query point itself
+        if (nn_dists[i] == 0)
+          continue;
+
+        // Standard weighting function used
+        fpfh_histogram += (1.0f / nn_dists[i]) *
+          Eigen::Map<const Eigen::VectorXf, Eigen::Aligned> (&spfh_table[spfh_hist_lookup[nn_indices[i]] * row_size], row_size);
+      }
+
+      // Normalize every histogram so that its values sum up to 100
+      const int offsets[4] = {0, nr_bins_f1_, nr_bins_f1_ + nr_bins_f2_, nr_bins};
+      for (int f = 0; f < 3; ++f)
+      {
+        double sum = 0.0;
+        for (int d = offsets[f]; d < offsets[f + 1]; ++d)
+          sum += fpfh[d];
+        if (sum != 0)
+          sum = 100.0 / sum;
+        for (int d = offsets[f]; d < offsets[f + 1]; ++d)
+          output.points[idx].histogram[d] = fpfh[d] * static_cast<float> (sum);
+      }
+    }
   }
-
+  output.is_dense = is_dense;
 }
 
 #define PCL_INSTANTIATE_FPFHEstimationOMP(T,NT,OutT) template class PCL_EXPORTS pcl::FPFHEstimationOMP<T,NT,OutT>;
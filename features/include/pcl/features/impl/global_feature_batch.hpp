@@ -0,0 +1,146 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FEATURES_IMPL_GLOBAL_FEATURE_BATCH_H_
+#define PCL_FEATURES_IMPL_GLOBAL_FEATURE_BATCH_H_
+
+#include <pcl/features/global_feature_batch.h>
+#include <pcl/common/centroid.h>
+#include <pcl/common/io.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT, typename PointNT> void
+pcl::GlobalFeatureBatch<PointInT, PointOutT, PointNT>::setNormals (
+    pcl::Feature<PointInT, PointOutT> &feature, const PointCloudNConstPtr &normals)
+{
+  pcl::FeatureFromNormals<PointInT, PointNT, PointOutT> *feature_from_normals =
+    dynamic_cast<pcl::FeatureFromNormals<PointInT, PointNT, PointOutT>*> (&feature);
+  if (feature_from_normals)
+    feature_from_normals->setInputNormals (normals);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT, typename PointNT> void
+pcl::GlobalFeatureBatch<PointInT, PointOutT, PointNT>::getCentroids (
+    pcl::Feature<PointInT, PointOutT> &feature, const PointCloudIn &cloud, std::vector<Eigen::Vector3f> &centroids)
+{
+  // Every CVFH descriptor is centered on a dominant region of the cluster
+  pcl::CVFHEstimation<PointInT, PointNT, PointOutT> *cvfh =
+    dynamic_cast<pcl::CVFHEstimation<PointInT, PointNT, PointOutT>*> (&feature);
+  if (cvfh)
+  {
+    cvfh->getCentroidClusters (centroids);
+    return;
+  }
+
+  Eigen::Vector4f centroid;
+  pcl::compute3DCentroid (cloud, centroid);
+  centroids.push_back (Eigen::Vector3f (centroid[0], centroid[1], centroid[2]));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT, typename PointNT> void
+pcl::GlobalFeatureBatch<PointInT, PointOutT, PointNT>::compute (PointCloudOutVector &output)
+{
+  output.clear ();
+  centroids_.clear ();
+  if (!feature_)
+  {
+    PCL_ERROR ("[pcl::GlobalFeatureBatch::compute] No feature estimator given!\n");
+    return;
+  }
+  if (input_ && normals_ && normals_->points.size () != input_->points.size ())
+  {
+    PCL_ERROR ("[pcl::GlobalFeatureBatch::compute] The number of normals (%zu) differs from the number of points (%zu)!\n",
+               normals_->points.size (), input_->points.size ());
+    return;
+  }
+  if (!input_ && !cloud_normals_.empty () && cloud_normals_.size () != clouds_.size ())
+  {
+    PCL_ERROR ("[pcl::GlobalFeatureBatch::compute] The number of normal clouds (%zu) differs from the number of clouds (%zu)!\n",
+               cloud_normals_.size (), clouds_.size ());
+    return;
+  }
+
+  const int nr_clusters = static_cast<int> (getNumberOfClusters ());
+  output.resize (nr_clusters);
+  centroids_.resize (nr_clusters);
+
+  const int threads = static_cast<int> (threads_);
+#pragma omp parallel num_threads (threads)
+  {
+    // Every thread describes whole clusters with its own estimator. The estimators do not search the
+    // neighborhoods of the points, so a brute force search costs nothing to build for every cluster.
+    FeatureStagePtr feature = boost::static_pointer_cast<FeatureStage> (feature_->clone ());
+    const typename pcl::search::Search<PointInT>::Ptr search (new pcl::search::BruteForce<PointInT>);
+
+#pragma omp for schedule (dynamic, 1)
+    for (int i = 0; i < nr_clusters; ++i)
+    {
+      PointCloudInConstPtr cloud;
+      PointCloudNConstPtr normals;
+      if (input_)
+      {
+        typename PointCloudIn::Ptr cluster (new PointCloudIn);
+        pcl::copyPointCloud (*input_, clusters_[i].indices, *cluster);
+        cloud = cluster;
+        if (normals_)
+        {
+          typename PointCloudN::Ptr cluster_normals (new PointCloudN);
+          pcl::copyPointCloud (*normals_, clusters_[i].indices, *cluster_normals);
+          normals = cluster_normals;
+        }
+      }
+      else
+      {
+        cloud = clouds_[i];
+        if (!cloud_normals_.empty ())
+          normals = cloud_normals_[i];
+      }
+      setNormals (feature->getFeature (), normals);
+      feature->compute (cloud, IndicesPtr (), PointCloudInConstPtr (), search, output[i]);
+      if (!output[i].points.empty ())
+        getCentroids (feature->getFeature (), *cloud, centroids_[i]);
+    }
+  }
+}
+
+#define PCL_INSTANTIATE_GlobalFeatureBatch(T,OutT,NT) template class PCL_EXPORTS pcl::GlobalFeatureBatch<T,OutT,NT>;
+
+#endif    // PCL_FEATURES_IMPL_GLOBAL_FEATURE_BATCH_H_
@@ -0,0 +1,200 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FEATURES_IMPL_INCREMENTAL_FEATURE_H_
+#define PCL_FEATURES_IMPL_INCREMENTAL_FEATURE_H_
+
+#include <pcl/features/incremental_feature.h>
+#include <pcl/search/pcl_search.h>
+#include <cstring>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::IncrementalFeatureEstimation<PointInT, PointOutT>::addNeighbors (
+    const KdTreePtr &search, const PointCloudIn &cloud, const std::vector<int> &queries,
+    double radius, std::vector<bool> &affected) const
+{
+  const int nr_queries = static_cast<int> (queries.size ());
+  const int threads = static_cast<int> (threads_);
+#pragma omp parallel num_threads (threads)
+  {
+    std::vector<int> nn_indices, found;
+    std::vector<float> nn_dists;
+
+#pragma omp for schedule (dynamic, 64)
+    for (int i = 0; i < nr_queries; ++i)
+    {
+      if (!isFinite (cloud.points[queries[i]]))
+        continue;
+      search->radiusSearch (cloud.points[queries[i]], radius, nn_indices, nn_dists);
+      found.insert (found.end (), nn_indices.begin (), nn_indices.end ());
+    }
+
+#pragma omp critical
+    for (size_t i = 0; i < found.size (); ++i)
+      affected[found[i]] = true;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::IncrementalFeatureEstimation<PointInT, PointOutT>::compute (PointCloudOut &output)
+{
+  updated_indices_.clear ();
+  output.width = output.height = 0;
+  output.points.clear ();
+
+  if (!input_ || !previous_input_ || !previous_features_ || !stage_)
+  {
+    PCL_ERROR ("[pcl::IncrementalFeatureEstimation::compute] The input cloud, the previous cloud and features, and the feature estimator must be set!\n");
+    return;
+  }
+  if (previous_features_->points.size () != previous_input_->points.size ())
+  {
+    PCL_ERROR ("[pcl::IncrementalFeatureEstimation::compute] The previous cloud has %zu points but %zu features!\n",
+               previous_input_->points.size (), previous_features_->points.size ());
+    return;
+  }
+  const size_t nr_points = input_->points.size ();
+  const size_t nr_previous_points = previous_input_->points.size ();
+  if (previous_indices_.empty () ? (nr_previous_points != nr_points) : (previous_indices_.size () != nr_points))
+  {
+    PCL_ERROR ("[pcl::IncrementalFeatureEstimation::compute] The input cloud has %zu points, but %zu previous points and %zu previous indices!\n",
+               nr_points, nr_previous_points, previous_indices_.size ());
+    return;
+  }
+
+  // Match the points to the previous points. The changed points and the previous points which are not kept are
+  // where the neighborhoods changed.
+  std::vector<int> previous_indices (nr_points, -1);
+  std::vector<bool> kept (nr_previous_points, false);
+  std::vector<int> changed, removed;
+  for (size_t i = 0; i < nr_points; ++i)
+  {
+    const int previous = previous_indices_.empty () ? static_cast<int> (i) : previous_indices_[i];
+    if (previous >= 0 && previous < static_cast<int> (nr_previous_points) &&
+        memcmp (&input_->points[i].x, &previous_input_->points[previous].x, 3 * sizeof (float)) == 0)
+    {
+      previous_indices[i] = previous;
+      kept[previous] = true;
+    }
+    else
+      changed.push_back (static_cast<int> (i));
+  }
+  for (size_t i = 0; i < nr_previous_points; ++i)
+    if (!kept[i])
+      removed.push_back (static_cast<int> (i));
+  for (size_t i = 0; i < changed_indices_.size (); ++i)
+    if (changed_indices_[i] >= 0 && changed_indices_[i] < static_cast<int> (nr_points))
+      changed.push_back (changed_indices_[i]);
+
+  std::vector<bool> affected (nr_points, false);
+  for (size_t i = 0; i < changed.size (); ++i)
+    affected[changed[i]] = true;
+
+  KdTreePtr tree = stage_->getSearchMethod ();
+  const double radius = stage_->getRadiusSearch ();
+  if (radius <= 0)
+  {
+    // The k nearest neighbors may be anywhere, so every feature may have changed
+    if (!changed.empty () || !removed.empty ())
+      affected.assign (nr_points, true);
+  }
+  else if (!changed.empty () || !removed.empty ())
+  {
+    if (!tree)
+    {
+      if (input_->isOrganized ())
+        tree.reset (new pcl::search::OrganizedNeighbor<PointInT> ());
+      else
+        tree.reset (new pcl::search::KdTree<PointInT> (false));
+      stage_->getFeature ().setSearchMethod (tree);
+    }
+    if (tree->getInputCloud () != input_)
+      tree->setInputCloud (input_);
+
+    // The points which have a changed point within their neighborhood, now or before the change
+    addNeighbors (tree, *input_, changed, radius, affected);
+    addNeighbors (tree, *previous_input_, removed, radius, affected);
+
+    // The points which combine the features of these points with their own, e.g. the SPFH in FPFH
+    for (int depth = 1; depth < neighborhood_depth_; ++depth)
+    {
+      std::vector<int> queries;
+      for (size_t i = 0; i < nr_points; ++i)
+        if (affected[i])
+          queries.push_back (static_cast<int> (i));
+      addNeighbors (tree, *input_, queries, radius, affected);
+    }
+  }
+
+  for (size_t i = 0; i < nr_points; ++i)
+    if (affected[i])
+      updated_indices_.push_back (static_cast<int> (i));
+
+  PointCloudOut features;
+  if (!updated_indices_.empty ())
+  {
+    IndicesPtr indices (new std::vector<int> (updated_indices_));
+    stage_->compute (input_, indices, input_, tree, features);
+    if (features.points.size () != updated_indices_.size ())
+    {
+      PCL_ERROR ("[pcl::IncrementalFeatureEstimation::compute] The feature estimator computed %zu features for %zu points!\n",
+                 features.points.size (), updated_indices_.size ());
+      updated_indices_.clear ();
+      return;
+    }
+  }
+
+  // Copy the features of the unaffected points, which are the same as before
+  output.header = input_->header;
+  output.points.resize (nr_points);
+  for (size_t i = 0; i < nr_points; ++i)
+    if (!affected[i])
+      output.points[i] = previous_features_->points[previous_indices[i]];
+  for (size_t i = 0; i < updated_indices_.size (); ++i)
+    output.points[updated_indices_[i]] = features.points[i];
+  output.width = input_->width;
+  output.height = input_->height;
+  output.is_dense = previous_features_->is_dense && (updated_indices_.empty () || features.is_dense);
+}
+
+#define PCL_INSTANTIATE_IncrementalFeatureEstimation(T,OutT) template class PCL_EXPORTS pcl::IncrementalFeatureEstimation<T,OutT>;
+
+#endif    // PCL_FEATURES_IMPL_INCREMENTAL_FEATURE_H_
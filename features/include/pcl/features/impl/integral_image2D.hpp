@@ -40,6 +40,8 @@
 #define PCL_INTEGRAL_IMAGE2D_IMPL_H_
 
 #include <cstddef>
+#include <cstring>
+#include <algorithm>
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename DataType, unsigned Dimension> void
@@ -52,15 +54,13 @@ pcl::IntegralImage2D<DataType, Dimension>::setSecondOrderComputation (bool compu
 template <typename DataType, unsigned Dimension> void
 pcl::IntegralImage2D<DataType, Dimension>::setInput (const DataType * data, unsigned width,unsigned height, unsigned element_stride, unsigned row_stride)
 {
-  if ((width + 1) * (height + 1) > first_order_integral_image_.size () )
-  {
-    width_  = width;
-    height_ = height;
-    first_order_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
-    finite_values_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
-    if (compute_second_order_integral_images_)
-      second_order_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
-  }
+  width_  = width;
+  height_ = height;
+  // The buffers never shrink, so consecutive frames of the same or a smaller size do not allocate
+  first_order_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
+  finite_values_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
+  if (compute_second_order_integral_images_)
+    second_order_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
   computeIntegralImages (data, row_stride, element_stride);
 }
 
@@ -111,84 +111,131 @@ template <typename DataType, unsigned Dimension> void
 pcl::IntegralImage2D<DataType, Dimension>::computeIntegralImages (
     const DataType *data, unsigned row_stride, unsigned element_stride)
 {
-  ElementType* previous_row = &first_order_integral_image_[0];
-  ElementType* current_row  = previous_row + (width_ + 1);
-  memset (previous_row, 0, sizeof (ElementType) * (width_ + 1));
+  memset (&first_order_integral_image_[0], 0, sizeof (ElementType) * (width_ + 1));
+  memset (&finite_values_integral_image_[0], 0, sizeof (unsigned) * (width_ + 1));
+  if (compute_second_order_integral_images_)
+    memset (&second_order_integral_image_[0], 0, sizeof (SecondOrderType) * (width_ + 1));
+
+  // Every thread integrates its own band of rows as if the band started at the top of the image
+  const int nr_bands = static_cast<int> (std::max (1u, std::min (threads_, height_)));
+#pragma omp parallel for num_threads (nr_bands) schedule (static, 1)
+  for (int band = 0; band < nr_bands; ++band)
+  {
+    const unsigned begin = height_ * band / nr_bands;
+    const unsigned end = height_ * (band + 1) / nr_bands;
+    for (unsigned rowIdx = begin; rowIdx < end; ++rowIdx)
+      computeIntegralRow (data + rowIdx * row_stride, element_stride, rowIdx + 1, rowIdx == begin);
+  }
+
+  if (nr_bands == 1)
+    return;
 
-  unsigned* count_previous_row = &finite_values_integral_image_[0];
-  unsigned* count_current_row  = count_previous_row + (width_ + 1);
-  memset (count_previous_row, 0, sizeof (unsigned) * (width_ + 1));
+  // The last row of every band then gets the sums of all bands above it, in order...
+  for (int band = 1; band < nr_bands; ++band)
+    addIntegralRow (height_ * (band + 1) / nr_bands, height_ * band / nr_bands);
+
+  // ...and the other rows of a band the last row of the band above it
+#pragma omp parallel for num_threads (nr_bands) schedule (static, 1)
+  for (int band = 1; band < nr_bands; ++band)
+  {
+    const unsigned begin = height_ * band / nr_bands;
+    const unsigned end = height_ * (band + 1) / nr_bands;
+    for (unsigned rowIdx = begin + 1; rowIdx < end; ++rowIdx)
+      addIntegralRow (rowIdx, begin);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename DataType, unsigned Dimension> void
+pcl::IntegralImage2D<DataType, Dimension>::computeIntegralRow (
+    const DataType *data, unsigned element_stride, unsigned row, bool first_row)
+{
+  // The first row of the integral images is zero, and stands in for the row above the first row of a band
+  const unsigned previous = first_row ? 0 : (row - 1) * (width_ + 1);
+  const ElementType* previous_row = &first_order_integral_image_[previous];
+  const unsigned* count_previous_row = &finite_values_integral_image_[previous];
+  ElementType* current_row = &first_order_integral_image_[row * (width_ + 1)];
+  unsigned* count_current_row = &finite_values_integral_image_[row * (width_ + 1)];
 
+  ElementType row_sum (ElementType::Zero ());
+  unsigned row_count = 0;
+  current_row [0] = row_sum;
+  count_current_row [0] = 0;
   if (!compute_second_order_integral_images_)
   {
-    for (unsigned rowIdx = 0; rowIdx < height_; ++rowIdx, data += row_stride,
-                                                previous_row = current_row, current_row += (width_ + 1),
-                                                count_previous_row = count_current_row, count_current_row += (width_ + 1))
+    for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
     {
-      current_row [0].setZero ();
-      count_current_row [0] = 0;
-      for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
+      const InputType* element = reinterpret_cast <const InputType*> (&data [valIdx]);
+      if (pcl_isfinite (element->sum ()))
       {
-        current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
-        count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
-        const InputType* element = reinterpret_cast <const InputType*> (&data [valIdx]);
-        if (pcl_isfinite (element->sum ()))
-        {
-          current_row [colIdx + 1] += element->template cast<typename IntegralImageTypeTraits<DataType>::IntegralType>();
-          ++(count_current_row [colIdx + 1]);
-        }
+        row_sum += element->template cast<typename IntegralImageTypeTraits<DataType>::IntegralType>();
+        ++row_count;
       }
+      current_row [colIdx + 1] = previous_row [colIdx + 1] + row_sum;
+      count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + row_count;
     }
   }
   else
   {
-    SecondOrderType* so_previous_row = &second_order_integral_image_[0];
-    SecondOrderType* so_current_row  = so_previous_row + (width_ + 1);
-    memset (so_previous_row, 0, sizeof (SecondOrderType) * (width_ + 1));
-
-    SecondOrderType so_element;
-    for (unsigned rowIdx = 0; rowIdx < height_; ++rowIdx, data += row_stride,
-                                                previous_row = current_row, current_row += (width_ + 1),
-                                                count_previous_row = count_current_row, count_current_row += (width_ + 1),
-                                                so_previous_row = so_current_row, so_current_row += (width_ + 1))
+    const SecondOrderType* so_previous_row = &second_order_integral_image_[previous];
+    SecondOrderType* so_current_row = &second_order_integral_image_[row * (width_ + 1)];
+    SecondOrderType so_row_sum (SecondOrderType::Zero ());
+    so_current_row [0] = so_row_sum;
+    for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
     {
-      current_row [0].setZero ();
-      so_current_row [0].setZero ();
-      count_current_row [0] = 0;
-      for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
+      const InputType* element = reinterpret_cast <const InputType*> (&data [valIdx]);
+      if (pcl_isfinite (element->sum ()))
       {
-        current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
-        so_current_row [colIdx + 1] = so_previous_row [colIdx + 1] + so_current_row [colIdx] - so_previous_row [colIdx];
-        count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
-
-        const InputType* element = reinterpret_cast <const InputType*> (&data [valIdx]);
-        if (pcl_isfinite (element->sum ()))
-        {
-          current_row [colIdx + 1] += element->template cast<typename IntegralImageTypeTraits<DataType>::IntegralType>();
-          ++(count_current_row [colIdx + 1]);
-          for (unsigned myIdx = 0, elIdx = 0; myIdx < Dimension; ++myIdx)
-            for (unsigned mxIdx = myIdx; mxIdx < Dimension; ++mxIdx, ++elIdx)
-              so_current_row [colIdx + 1][elIdx] += (*element)[myIdx] * (*element)[mxIdx];
-        }
+        const ElementType value = element->template cast<typename IntegralImageTypeTraits<DataType>::IntegralType>();
+        row_sum += value;
+        ++row_count;
+        // The products are formed in the integral type, so that float input is squared without rounding
+        for (unsigned myIdx = 0, elIdx = 0; myIdx < Dimension; ++myIdx)
+          for (unsigned mxIdx = myIdx; mxIdx < Dimension; ++mxIdx, ++elIdx)
+            so_row_sum [elIdx] += value [myIdx] * value [mxIdx];
       }
+      current_row [colIdx + 1] = previous_row [colIdx + 1] + row_sum;
+      so_current_row [colIdx + 1] = so_previous_row [colIdx + 1] + so_row_sum;
+      count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + row_count;
     }
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename DataType, unsigned Dimension> void
+pcl::IntegralImage2D<DataType, Dimension>::addIntegralRow (unsigned row, unsigned source_row)
+{
+  ElementType* current_row = &first_order_integral_image_[row * (width_ + 1)];
+  const ElementType* added_row = &first_order_integral_image_[source_row * (width_ + 1)];
+  unsigned* count_current_row = &finite_values_integral_image_[row * (width_ + 1)];
+  const unsigned* count_added_row = &finite_values_integral_image_[source_row * (width_ + 1)];
+  for (unsigned colIdx = 1; colIdx <= width_; ++colIdx)
+  {
+    current_row [colIdx] += added_row [colIdx];
+    count_current_row [colIdx] += count_added_row [colIdx];
+  }
+
+  if (compute_second_order_integral_images_)
+  {
+    SecondOrderType* so_current_row = &second_order_integral_image_[row * (width_ + 1)];
+    const SecondOrderType* so_added_row = &second_order_integral_image_[source_row * (width_ + 1)];
+    for (unsigned colIdx = 1; colIdx <= width_; ++colIdx)
+      so_current_row [colIdx] += so_added_row [colIdx];
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 template <typename DataType> void
 pcl::IntegralImage2D<DataType, 1>::setInput (const DataType * data, unsigned width,unsigned height, unsigned element_stride, unsigned row_stride)
 {
-  if ((width + 1) * (height + 1) > first_order_integral_image_.size () )
-  {
-    width_  = width;
-    height_ = height;
-    first_order_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
-    finite_values_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
-    if (compute_second_order_integral_images_)
-      second_order_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
-  }
+  width_  = width;
+  height_ = height;
+  // The buffers never shrink, so consecutive frames of the same or a smaller size do not allocate
+  first_order_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
+  finite_values_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
+  if (compute_second_order_integral_images_)
+    second_order_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
   computeIntegralImages (data, row_stride, element_stride);
 }
 
@@ -239,62 +286,112 @@ template <typename DataType> void
 pcl::IntegralImage2D<DataType, 1>::computeIntegralImages (
     const DataType *data, unsigned row_stride, unsigned element_stride)
 {
-  ElementType* previous_row = &first_order_integral_image_[0];
-  ElementType* current_row  = previous_row + (width_ + 1);
-  memset (previous_row, 0, sizeof (ElementType) * (width_ + 1));
+  memset (&first_order_integral_image_[0], 0, sizeof (ElementType) * (width_ + 1));
+  memset (&finite_values_integral_image_[0], 0, sizeof (unsigned) * (width_ + 1));
+  if (compute_second_order_integral_images_)
+    memset (&second_order_integral_image_[0], 0, sizeof (SecondOrderType) * (width_ + 1));
+
+  // Every thread integrates its own band of rows as if the band started at the top of the image
+  const int nr_bands = static_cast<int> (std::max (1u, std::min (threads_, height_)));
+#pragma omp parallel for num_threads (nr_bands) schedule (static, 1)
+  for (int band = 0; band < nr_bands; ++band)
+  {
+    const unsigned begin = height_ * band / nr_bands;
+    const unsigned end = height_ * (band + 1) / nr_bands;
+    for (unsigned rowIdx = begin; rowIdx < end; ++rowIdx)
+      computeIntegralRow (data + rowIdx * row_stride, element_stride, rowIdx + 1, rowIdx == begin);
+  }
+
+  if (nr_bands == 1)
+    return;
 
-  unsigned* count_previous_row = &finite_values_integral_image_[0];
-  unsigned* count_current_row  = count_previous_row + (width_ + 1);
-  memset (count_previous_row, 0, sizeof (unsigned) * (width_ + 1));
+  // The last row of every band then gets the sums of all bands above it, in order...
+  for (int band = 1; band < nr_bands; ++band)
+    addIntegralRow (height_ * (band + 1) / nr_bands, height_ * band / nr_bands);
+
+  // ...and the other rows of a band the last row of the band above it
+#pragma omp parallel for num_threads (nr_bands) schedule (static, 1)
+  for (int band = 1; band < nr_bands; ++band)
+  {
+    const unsigned begin = height_ * band / nr_bands;
+    const unsigned end = height_ * (band + 1) / nr_bands;
+    for (unsigned rowIdx = begin + 1; rowIdx < end; ++rowIdx)
+      addIntegralRow (rowIdx, begin);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename DataType> void
+pcl::IntegralImage2D<DataType, 1>::computeIntegralRow (
+    const DataType *data, unsigned element_stride, unsigned row, bool first_row)
+{
+  // The first row of the integral images is zero, and stands in for the row above the first row of a band
+  const unsigned previous = first_row ? 0 : (row - 1) * (width_ + 1);
+  const ElementType* previous_row = &first_order_integral_image_[previous];
+  const unsigned* count_previous_row = &finite_values_integral_image_[previous];
+  ElementType* current_row = &first_order_integral_image_[row * (width_ + 1)];
+  unsigned* count_current_row = &finite_values_integral_image_[row * (width_ + 1)];
 
+  ElementType row_sum (0);
+  unsigned row_count = 0;
+  current_row [0] = row_sum;
+  count_current_row [0] = 0;
   if (!compute_second_order_integral_images_)
   {
-    for (unsigned rowIdx = 0; rowIdx < height_; ++rowIdx, data += row_stride,
-                                                previous_row = current_row, current_row += (width_ + 1),
-                                                count_previous_row = count_current_row, count_current_row += (width_ + 1))
+    for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
     {
-      current_row [0] = 0.0;
-      count_current_row [0] = 0;
-      for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
+      if (pcl_isfinite (data [valIdx]))
       {
-        current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
-        count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
-        if (pcl_isfinite (data [valIdx]))
-        {
-          current_row [colIdx + 1] += data [valIdx];
-          ++(count_current_row [colIdx + 1]);
-        }
+        row_sum += data [valIdx];
+        ++row_count;
       }
+      current_row [colIdx + 1] = previous_row [colIdx + 1] + row_sum;
+      count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + row_count;
     }
   }
   else
   {
-    SecondOrderType* so_previous_row = &second_order_integral_image_[0];
-    SecondOrderType* so_current_row  = so_previous_row + (width_ + 1);
-    memset (so_previous_row, 0, sizeof (SecondOrderType) * (width_ + 1));
-
-    for (unsigned rowIdx = 0; rowIdx < height_; ++rowIdx, data += row_stride,
-                                                previous_row = current_row, current_row += (width_ + 1),
-                                                count_previous_row = count_current_row, count_current_row += (width_ + 1),
-                                                so_previous_row = so_current_row, so_current_row += (width_ + 1))
+    const SecondOrderType* so_previous_row = &second_order_integral_image_[previous];
+    SecondOrderType* so_current_row = &second_order_integral_image_[row * (width_ + 1)];
+    SecondOrderType so_row_sum (0);
+    so_current_row [0] = so_row_sum;
+    for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
     {
-      current_row [0] = 0.0;
-      so_current_row [0] = 0.0;
-      count_current_row [0] = 0;
-      for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
+      if (pcl_isfinite (data [valIdx]))
       {
-        current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
-        so_current_row [colIdx + 1] = so_previous_row [colIdx + 1] + so_current_row [colIdx] - so_previous_row [colIdx];
-        count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
-        if (pcl_isfinite (data[valIdx]))
-        {
-          current_row [colIdx + 1] += data[valIdx];
-          so_current_row [colIdx + 1] += data[valIdx] * data[valIdx];
-          ++(count_current_row [colIdx + 1]);
-        }
+        const ElementType value = data [valIdx];
+        row_sum += value;
+        so_row_sum += value * value;
+        ++row_count;
       }
+      current_row [colIdx + 1] = previous_row [colIdx + 1] + row_sum;
+      so_current_row [colIdx + 1] = so_previous_row [colIdx + 1] + so_row_sum;
+      count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + row_count;
     }
   }
 }
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename DataType> void
+pcl::IntegralImage2D<DataType, 1>::addIntegralRow (unsigned row, unsigned source_row)
+{
+  ElementType* current_row = &first_order_integral_image_[row * (width_ + 1)];
+  const ElementType* added_row = &first_order_integral_image_[source_row * (width_ + 1)];
+  unsigned* count_current_row = &finite_values_integral_image_[row * (width_ + 1)];
+  const unsigned* count_added_row = &finite_values_integral_image_[source_row * (width_ + 1)];
+  for (unsigned colIdx = 1; colIdx <= width_; ++colIdx)
+  {
+    current_row [colIdx] += added_row [colIdx];
+    count_current_row [colIdx] += count_added_row [colIdx];
+  }
+
+  if (compute_second_order_integral_images_)
+  {
+    SecondOrderType* so_current_row = &second_order_integral_image_[row * (width_ + 1)];
+    const SecondOrderType* so_added_row = &second_order_integral_image_[source_row * (width_ + 1)];
+    for (unsigned colIdx = 1; colIdx <= width_; ++colIdx)
+      so_current_row [colIdx] += so_added_row [colIdx];
+  }
+}
 #endif    // PCL_INTEGRAL_IMAGE2D_IMPL_H_
 
@@ -43,25 +43,14 @@
 template <typename PointInT, typename PointOutT>
 pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::~IntegralImageNormalEstimation ()
 {
-  if (diff_x_ != NULL) delete diff_x_;
-  if (diff_y_ != NULL) delete diff_y_;
-  if (depth_data_ != NULL) delete depth_data_;
-  if (distance_map_ != NULL) delete distance_map_;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointOutT> void
 pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initData ()
 {
-  // compute derivatives
-  if (diff_x_ != NULL) delete diff_x_;
-  if (diff_y_ != NULL) delete diff_y_;
-  if (depth_data_ != NULL) delete depth_data_;
-  if (distance_map_ != NULL) delete distance_map_;
-  diff_x_ = NULL;
-  diff_y_ = NULL;
-  depth_data_ = NULL;
-  distance_map_ = NULL;
+  // The buffers keep their memory for the next frame
+  distance_map_.clear ();
 
   if (normal_estimation_method_ == COVARIANCE_MATRIX)
     initCovarianceMatrixMethod ();
@@ -73,6 +62,19 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initData ()
     initSimple3DGradientMethod ();
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initNormalEstimationMethod ()
+{
+  if (normal_estimation_method_ == COVARIANCE_MATRIX && !init_covariance_matrix_)
+    initCovarianceMatrixMethod ();
+  else if (normal_estimation_method_ == AVERAGE_3D_GRADIENT && !init_average_3d_gradient_)
+    initAverage3DGradientMethod ();
+  else if (normal_estimation_method_ == AVERAGE_DEPTH_CHANGE && !init_depth_change_)
+    initAverageDepthChangeMethod ();
+  else if (normal_estimation_method_ == SIMPLE_3D_GRADIENT && !init_simple_3d_gradient_)
+    initSimple3DGradientMethod ();
+}
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointOutT> void
@@ -126,47 +128,45 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initCovarianceMatrixMet
 template <typename PointInT, typename PointOutT> void
 pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initAverage3DGradientMethod ()
 {
-  size_t data_size = (input_->points.size () << 2);
-  diff_x_ = new float[data_size];
-  diff_y_ = new float[data_size];
-
-  memset (diff_x_, 0, sizeof(float) * data_size);
-  memset (diff_y_, 0, sizeof(float) * data_size);
+  const int width = static_cast<int> (input_->width);
+  const int height = static_cast<int> (input_->height);
+  const int threads = static_cast<int> (threads_);
+  diff_x_.resize (input_->points.size () << 2);
+  diff_y_.resize (input_->points.size () << 2);
 
   // x u x
   // l x r
   // x d x
-  const PointInT* point_up = &(input_->points [1]);
-  const PointInT* point_dn = point_up + (input_->width << 1);//&(input_->points [1 + (input_->width << 1)]);
-  const PointInT* point_lf = &(input_->points [input_->width]);
-  const PointInT* point_rg = point_lf + 2; //&(input_->points [input_->width + 2]);
-  float* diff_x_ptr = diff_x_ + ((input_->width + 1) << 2);
-  float* diff_y_ptr = diff_y_ + ((input_->width + 1) << 2);
-  unsigned diff_skip = 8; // skip last element in row and the first in the next row
-
-  for (size_t ri = 1; ri < input_->height - 1; ++ri
-                                             , point_up += input_->width
-                                             , point_dn += input_->width
-                                             , point_lf += input_->width
-                                             , point_rg += input_->width
-                                             , diff_x_ptr += diff_skip
-                                             , diff_y_ptr += diff_skip)
+  // Every row is written entirely, so that the borders of a reused buffer are zero again
+#pragma omp parallel for num_threads (threads) schedule (static)
+  for (int ri = 0; ri < height; ++ri)
   {
-    for (size_t ci = 0; ci < input_->width - 2; ++ci, diff_x_ptr += 4, diff_y_ptr += 4)
+    float* diff_x_ptr = &diff_x_[(ri * width) << 2];
+    float* diff_y_ptr = &diff_y_[(ri * width) << 2];
+    memset (diff_x_ptr, 0, sizeof (float) * (width << 2));
+    memset (diff_y_ptr, 0, sizeof (float) * (width << 2));
+    if (ri == 0 || ri == height - 1)
+      continue;
+
+    const PointInT* point_up = &(input_->points [(ri - 1) * width]);
+    const PointInT* point_dn = point_up + (width << 1);
+    const PointInT* point_lf = point_up + width - 1;
+    const PointInT* point_rg = point_lf + 2;
+    for (int ci = 1; ci < width - 1; ++ci)
     {
-      diff_x_ptr[0] = point_rg[ci].x - point_lf[ci].x;
-      diff_x_ptr[1] = point_rg[ci].y - point_lf[ci].y;
-      diff_x_ptr[2] = point_rg[ci].z - point_lf[ci].z;
+      diff_x_ptr[(ci << 2)    ] = point_rg[ci].x - point_lf[ci].x;
+      diff_x_ptr[(ci << 2) + 1] = point_rg[ci].y - point_lf[ci].y;
+      diff_x_ptr[(ci << 2) + 2] = point_rg[ci].z - point_lf[ci].z;
 
-      diff_y_ptr[0] = point_dn[ci].x - point_up[ci].x;
-      diff_y_ptr[1] = point_dn[ci].y - point_up[ci].y;
-      diff_y_ptr[2] = point_dn[ci].z - point_up[ci].z;
+      diff_y_ptr[(ci << 2)    ] = point_dn[ci].x - point_up[ci].x;
+      diff_y_ptr[(ci << 2) + 1] = point_dn[ci].y - point_up[ci].y;
+      diff_y_ptr[(ci << 2) + 2] = point_dn[ci].z - point_up[ci].z;
     }
   }
 
   // Compute integral images
-  integral_image_DX_.setInput (diff_x_, input_->width, input_->height, 4, input_->width << 2);
-  integral_image_DY_.setInput (diff_y_, input_->width, input_->height, 4, input_->width << 2);
+  integral_image_DX_.setInput (&diff_x_[0], input_->width, input_->height, 4, input_->width << 2);
+  integral_image_DY_.setInput (&diff_y_[0], input_->width, input_->height, 4, input_->width << 2);
   init_covariance_matrix_ = init_depth_change_ = init_simple_3d_gradient_ = false;
   init_average_3d_gradient_ = true;
 }
@@ -192,41 +192,66 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initAverageDepthChangeM
 template <typename PointInT, typename PointOutT> void
 pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
     const int pos_x, const int pos_y, const unsigned point_index, PointOutT &normal)
+{
+  initNormalEstimationMethod ();
+  computePointNormal (pos_x, pos_y, point_index, rect_width_, rect_height_, normal);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> unsigned
+pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeCovarianceMatrix (
+    const int pos_x, const int pos_y, const int rect_width, const int rect_height,
+    Eigen::Matrix3f &covariance_matrix) const
+{
+  const int start_x = pos_x - (rect_width >> 1);
+  const int start_y = pos_y - (rect_height >> 1);
+  const unsigned count = integral_image_XYZ_.getFiniteElementsCount (start_x, start_y, rect_width, rect_height);
+
+  // no valid points within the rectangular reagion?
+  if (count == 0)
+    return (0);
+
+  // The sums of the products are large compared to the centered result, so they are only rounded to float after
+  // the center has been subtracted
+  const Eigen::Vector3d center = integral_image_XYZ_.getFirstOrderSum (start_x, start_y, rect_width, rect_height);
+  const typename IntegralImage2D<float, 3>::SecondOrderType so_elements = integral_image_XYZ_.getSecondOrderSum (start_x, start_y, rect_width, rect_height);
+  const Eigen::Vector3d mean = center / static_cast<double> (count);
+
+  covariance_matrix.coeffRef (0) = static_cast<float> (so_elements [0] - center [0] * mean [0]);
+  covariance_matrix.coeffRef (1) = covariance_matrix.coeffRef (3) = static_cast<float> (so_elements [1] - center [0] * mean [1]);
+  covariance_matrix.coeffRef (2) = covariance_matrix.coeffRef (6) = static_cast<float> (so_elements [2] - center [0] * mean [2]);
+  covariance_matrix.coeffRef (4) = static_cast<float> (so_elements [3] - center [1] * mean [1]);
+  covariance_matrix.coeffRef (5) = covariance_matrix.coeffRef (7) = static_cast<float> (so_elements [4] - center [1] * mean [2]);
+  covariance_matrix.coeffRef (8) = static_cast<float> (so_elements [5] - center [2] * mean [2]);
+  return (count);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
+    const int pos_x, const int pos_y, const unsigned point_index,
+    const int rect_width, const int rect_height, PointOutT &normal) const
 {
   float bad_point = std::numeric_limits<float>::quiet_NaN ();
+  const int rect_width_2 = rect_width >> 1;
+  const int rect_width_4 = rect_width >> 2;
+  const int rect_height_2 = rect_height >> 1;
+  const int rect_height_4 = rect_height >> 2;
 
   if (normal_estimation_method_ == COVARIANCE_MATRIX)
   {
-    if (!init_covariance_matrix_)
-      initCovarianceMatrixMethod ();
-
-    unsigned count = integral_image_XYZ_.getFiniteElementsCount (pos_x - (rect_width_2_), pos_y - (rect_height_2_), rect_width_, rect_height_);
-
-    // no valid points within the rectangular reagion?
-    if (count == 0)
+    EIGEN_ALIGN16 Eigen::Matrix3f covariance_matrix;
+    if (computeCovarianceMatrix (pos_x, pos_y, rect_width, rect_height, covariance_matrix) == 0)
     {
       normal.normal_x = normal.normal_y = normal.normal_z = normal.curvature = std::numeric_limits<float>::quiet_NaN ();
       return;
     }
 
-    EIGEN_ALIGN16 Eigen::Matrix3f covariance_matrix;
-    Eigen::Vector3f center;
-    typename IntegralImage2D<float, 3>::SecondOrderType so_elements;
-    center = integral_image_XYZ_.getFirstOrderSum(pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_).cast<float> ();
-    so_elements = integral_image_XYZ_.getSecondOrderSum(pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
-
-    covariance_matrix.coeffRef (0) = static_cast<float> (so_elements [0]);
-    covariance_matrix.coeffRef (1) = covariance_matrix.coeffRef (3) = static_cast<float> (so_elements [1]);
-    covariance_matrix.coeffRef (2) = covariance_matrix.coeffRef (6) = static_cast<float> (so_elements [2]);
-    covariance_matrix.coeffRef (4) = static_cast<float> (so_elements [3]);
-    covariance_matrix.coeffRef (5) = covariance_matrix.coeffRef (7) = static_cast<float> (so_elements [4]);
-    covariance_matrix.coeffRef (8) = static_cast<float> (so_elements [5]);
-    covariance_matrix -= (center * center.transpose ()) / static_cast<float> (count);
     float eigen_value;
     Eigen::Vector3f eigen_vector;
     pcl::eigen33 (covariance_matrix, eigen_value, eigen_vector);
     //pcl::flipNormalTowardsViewpoint (input_->points[point_index], vpx_, vpy_, vpz_, eigen_vector);
-    pcl::flipNormalTowardsViewpoint (input_->points[point_index], vpx_, vpy_, vpz_, eigen_vector[0], eigen_vector[1], eigen_vector[2]);
+    pcl::flipNormalTowardsViewpoint (input_->points[point_index], vpx_, vpy_, vpz_, eigen_vector[0], eigen_vector[1], eigen_vector[2]);
     normal.getNormalVector3fMap () = eigen_vector;
 
     // Compute the curvature surface change
@@ -239,18 +264,15 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
   }
   else if (normal_estimation_method_ == AVERAGE_3D_GRADIENT)
   {
-    if (!init_average_3d_gradient_)
-      initAverage3DGradientMethod ();
-
-    unsigned count_x = integral_image_DX_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
-    unsigned count_y = integral_image_DY_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
+    unsigned count_x = integral_image_DX_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
+    unsigned count_y = integral_image_DY_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
     if (count_x == 0 || count_y == 0)
     {
       normal.normal_x = normal.normal_y = normal.normal_z = normal.curvature = std::numeric_limits<float>::quiet_NaN ();
       return;
     }
-    Eigen::Vector3d gradient_x = integral_image_DX_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
-    Eigen::Vector3d gradient_y = integral_image_DY_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
+    Eigen::Vector3d gradient_x = integral_image_DX_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
+    Eigen::Vector3d gradient_y = integral_image_DY_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
 
     Eigen::Vector3d normal_vector = gradient_y.cross (gradient_x);
     double normal_length = normal_vector.squaredNorm ();
@@ -263,40 +285,37 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
 
     normal_vector /= sqrt (normal_length);
 
-    float nx = static_cast<float> (normal_vector [0]);
-    float ny = static_cast<float> (normal_vector [1]);
-    float nz = static_cast<float> (normal_vector [2]);
-
-    //pcl::flipNormalTowardsViewpoint (input_->points[point_index], vpx_, vpy_, vpz_, normal_vector);
-    pcl::flipNormalTowardsViewpoint (input_->points[point_index], vpx_, vpy_, vpz_, nx, ny, nz);
+    float nx = static_cast<float> (normal_vector [0]);
+    float ny = static_cast<float> (normal_vector [1]);
+    float nz = static_cast<float> (normal_vector [2]);
 
-    normal.normal_x = nx;
-    normal.normal_y = ny;
-    normal.normal_z = nz;
+    //pcl::flipNormalTowardsViewpoint (input_->points[point_index], vpx_, vpy_, vpz_, normal_vector);
+    pcl::flipNormalTowardsViewpoint (input_->points[point_index], vpx_, vpy_, vpz_, nx, ny, nz);
+
+    normal.normal_x = nx;
+    normal.normal_y = ny;
+    normal.normal_z = nz;
     normal.curvature = bad_point;
     return;
   }
   else if (normal_estimation_method_ == AVERAGE_DEPTH_CHANGE)
   {
-    if (!init_depth_change_)
-      initAverageDepthChangeMethod ();
-
-//    unsigned count = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
+//    unsigned count = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
 //    if (count == 0)
 //    {
 //      normal.normal_x = normal.normal_y = normal.normal_z = normal.curvature = std::numeric_limits<float>::quiet_NaN ();
 //      return;
 //    }
-//    const float mean_L_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_ - 1, pos_y - rect_height_2_    , rect_width_ - 1, rect_height_ - 1) / ((rect_width_-1)*(rect_height_-1));
-//    const float mean_R_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_ + 1, pos_y - rect_height_2_    , rect_width_ - 1, rect_height_ - 1) / ((rect_width_-1)*(rect_height_-1));
-//    const float mean_U_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_    , pos_y - rect_height_2_ - 1, rect_width_ - 1, rect_height_ - 1) / ((rect_width_-1)*(rect_height_-1));
-//    const float mean_D_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_    , pos_y - rect_height_2_ + 1, rect_width_ - 1, rect_height_ - 1) / ((rect_width_-1)*(rect_height_-1));
+//    const float mean_L_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2 - 1, pos_y - rect_height_2    , rect_width - 1, rect_height - 1) / ((rect_width-1)*(rect_height-1));
+//    const float mean_R_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2 + 1, pos_y - rect_height_2    , rect_width - 1, rect_height - 1) / ((rect_width-1)*(rect_height-1));
+//    const float mean_U_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2    , pos_y - rect_height_2 - 1, rect_width - 1, rect_height - 1) / ((rect_width-1)*(rect_height-1));
+//    const float mean_D_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2    , pos_y - rect_height_2 + 1, rect_width - 1, rect_height - 1) / ((rect_width-1)*(rect_height-1));
 
     // width and height are at least 3 x 3
-    unsigned count_L_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_4_, rect_width_2_, rect_height_2_);
-    unsigned count_R_z = integral_image_depth_.getFiniteElementsCount (pos_x + 1            , pos_y - rect_height_4_, rect_width_2_, rect_height_2_);
-    unsigned count_U_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4_, pos_y - rect_height_2_, rect_width_2_, rect_height_2_);
-    unsigned count_D_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4_, pos_y + 1             , rect_width_2_, rect_height_2_);
+    unsigned count_L_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_4, rect_width_2, rect_height_2);
+    unsigned count_R_z = integral_image_depth_.getFiniteElementsCount (pos_x + 1            , pos_y - rect_height_4, rect_width_2, rect_height_2);
+    unsigned count_U_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4, pos_y - rect_height_2, rect_width_2, rect_height_2);
+    unsigned count_D_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4, pos_y + 1             , rect_width_2, rect_height_2);
 
     if (count_L_z == 0 || count_R_z == 0 || count_U_z == 0 || count_D_z == 0)
     {
@@ -304,15 +323,15 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
       return;
     }
 
-    float mean_L_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_4_, rect_width_2_, rect_height_2_) / count_L_z);
-    float mean_R_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x + 1            , pos_y - rect_height_4_, rect_width_2_, rect_height_2_) / count_R_z);
-    float mean_U_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4_, pos_y - rect_height_2_, rect_width_2_, rect_height_2_) / count_U_z);
-    float mean_D_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4_, pos_y + 1             , rect_width_2_, rect_height_2_) / count_D_z);
+    float mean_L_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_4, rect_width_2, rect_height_2) / count_L_z);
+    float mean_R_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x + 1            , pos_y - rect_height_4, rect_width_2, rect_height_2) / count_R_z);
+    float mean_U_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4, pos_y - rect_height_2, rect_width_2, rect_height_2) / count_U_z);
+    float mean_D_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4, pos_y + 1             , rect_width_2, rect_height_2) / count_D_z);
 
-    PointInT pointL = input_->points[point_index - rect_width_4_ - 1];
-    PointInT pointR = input_->points[point_index + rect_width_4_ + 1];
-    PointInT pointU = input_->points[point_index - rect_height_4_ * input_->width - 1];
-    PointInT pointD = input_->points[point_index + rect_height_4_ * input_->width + 1];
+    PointInT pointL = input_->points[point_index - rect_width_4 - 1];
+    PointInT pointR = input_->points[point_index + rect_width_4 + 1];
+    PointInT pointU = input_->points[point_index - rect_height_4 * input_->width - 1];
+    PointInT pointD = input_->points[point_index + rect_height_4 * input_->width + 1];
 
     const float mean_x_z = mean_R_z - mean_L_z;
     const float mean_y_z = mean_D_z - mean_U_z;
@@ -348,15 +367,12 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
   }
   else if (normal_estimation_method_ == SIMPLE_3D_GRADIENT)
   {
-    if (!init_simple_3d_gradient_)
-      initSimple3DGradientMethod ();
-
     // this method does not work if lots of NaNs are in the neighborhood of the point
-    Eigen::Vector3d gradient_x = integral_image_XYZ_.getFirstOrderSum (pos_x + rect_width_2_, pos_y - rect_height_2_, 1, rect_height_) -
-                                 integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, 1, rect_height_);
+    Eigen::Vector3d gradient_x = integral_image_XYZ_.getFirstOrderSum (pos_x + rect_width_2, pos_y - rect_height_2, 1, rect_height) -
+                                 integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, 1, rect_height);
 
-    Eigen::Vector3d gradient_y = integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y + rect_height_2_, rect_width_, 1) -
-                                 integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, 1);
+    Eigen::Vector3d gradient_y = integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y + rect_height_2, rect_width, 1) -
+                                 integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, 1);
     Eigen::Vector3d normal_vector = gradient_y.cross (gradient_x);
     double normal_length = normal_vector.squaredNorm ();
     if (normal_length == 0.0f)
@@ -368,12 +384,12 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
 
     normal_vector /= sqrt (normal_length);
 
-    float nx = static_cast<float> (normal_vector [0]);
-    float ny = static_cast<float> (normal_vector [1]);
-    float nz = static_cast<float> (normal_vector [2]);
+    float nx = static_cast<float> (normal_vector [0]);
+    float ny = static_cast<float> (normal_vector [1]);
+    float nz = static_cast<float> (normal_vector [2]);
 
     //pcl::flipNormalTowardsViewpoint (input_->points[point_index], vpx_, vpy_, vpz_, normal_vector);
-    pcl::flipNormalTowardsViewpoint (input_->points[point_index], vpx_, vpy_, vpz_, nx, ny, nz);
+    pcl::flipNormalTowardsViewpoint (input_->points[point_index], vpx_, vpy_, vpz_, nx, ny, nz);
     
     normal.normal_x = nx;
     normal.normal_y = ny;
@@ -396,51 +412,42 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
   
   float bad_point = std::numeric_limits<float>::quiet_NaN ();
 
-  // compute depth-change map
-  unsigned char * depthChangeMap = new unsigned char[input_->points.size ()];
-  memset (depthChangeMap, 255, input_->points.size ());
+  // The integral images are computed once, before the rows are split between the threads
+  initNormalEstimationMethod ();
+
+  const int width = static_cast<int> (input_->width);
+  const int height = static_cast<int> (input_->height);
+  const int threads = static_cast<int> (threads_);
 
-  unsigned index = 0;
-  for (unsigned int ri = 0; ri < input_->height-1; ++ri)
+  // compute depth-change map, where every point checks the edges to its four neighbors so that the rows are
+  // independent of each other
+  depth_change_map_.resize (input_->points.size ());
+#pragma omp parallel for num_threads (threads) schedule (static)
+  for (int ri = 0; ri < height; ++ri)
   {
-    for (unsigned int ci = 0; ci < input_->width-1; ++ci, ++index)
+    for (int ci = 0; ci < width; ++ci)
     {
-      index = ri * input_->width + ci;
-
-//      const float depth  = (*input_)(ci,     ri    ).z;
-//      const float depthR = (*input_)(ci + 1, ri    ).z;
-//      const float depthD = (*input_)(ci,     ri + 1).z;
-
-      const float depth  = input_->points [index].z;
-      const float depthR = input_->points [index + 1].z;
-      const float depthD = input_->points [index + input_->width].z;
-
-      //const float depthDependendDepthChange = (max_depth_change_factor_ * (fabs(depth)+1.0f))/(500.0f*0.001f);
-      const float depthDependendDepthChange = (max_depth_change_factor_ * (fabsf (depth) + 1.0f) * 2.0f);
-
-      if (fabs (depth - depthR) > depthDependendDepthChange
-        || !pcl_isfinite (depth) || !pcl_isfinite (depthR))
+      const int index = ri * width + ci;
+      bool depth_change = false;
+      if (ri < height - 1)
       {
-        depthChangeMap[index] = 0;
-        depthChangeMap[index+1] = 0;
-      }
-      if (fabs (depth - depthD) > depthDependendDepthChange
-        || !pcl_isfinite (depth) || !pcl_isfinite (depthD))
-      {
-        depthChangeMap[index] = 0;
-        depthChangeMap[index + input_->width] = 0;
+        if (ci < width - 1)
+          depth_change = isDepthChange (index, index + 1) || isDepthChange (index, index + width);
+        if (ci > 0)
+          depth_change = depth_change || isDepthChange (index - 1, index);
       }
+      if (ri > 0 && ci < width - 1)
+        depth_change = depth_change || isDepthChange (index - width, index);
+      depth_change_map_[index] = depth_change ? 0 : 255;
     }
   }
 
   // compute distance map
-  //float *distanceMap = new float[input_->points.size ()];
-  if (distance_map_ != NULL) delete distance_map_;
-  distance_map_ = new float[input_->points.size ()];
-  float *distanceMap = distance_map_;
+  distance_map_.resize (input_->points.size ());
+  float *distanceMap = &distance_map_[0];
   for (size_t index = 0; index < input_->points.size (); ++index)
   {
-    if (depthChangeMap[index] == 0)
+    if (depth_change_map_[index] == 0)
       distanceMap[index] = 0.0f;
     else
       distanceMap[index] = static_cast<float> (input_->width + input_->height);
@@ -521,76 +528,77 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
     }
   }
 
-  if (use_depth_dependent_smoothing_)
+  const int first_row = static_cast<int> (border), last_row = height - static_cast<int> (border);
+  const int first_col = static_cast<int> (border), last_col = width - static_cast<int> (border);
+#pragma omp parallel num_threads (threads)
   {
-    index = border + input_->width * border;
-    unsigned skip = (border << 1);
-    for (unsigned ri = border; ri < input_->height - border; ++ri, index += skip)
+    // The covariance matrices of a row are solved together
+    pcl::CovarianceMatrixBatch batch;
+    std::vector<int> batch_indices;
+    EIGEN_ALIGN16 Eigen::Matrix3f covariance_matrix;
+
+#pragma omp for schedule (dynamic, 8)
+    for (int ri = first_row; ri < last_row; ++ri)
     {
-      for (unsigned ci = border; ci < input_->width - border; ++ci, ++index)
+      batch.clear ();
+      batch_indices.clear ();
+      for (int ci = first_col; ci < last_col; ++ci)
       {
-        index = ri * input_->width + ci;
+        const int index = ri * width + ci;
 
         const float depth = input_->points[index].z;
         if (!pcl_isfinite (depth))
         {
-          output[index].getNormalVector4fMap ().setConstant (bad_point);
-          output[index].curvature = bad_point;
+          output [index].getNormalVector4fMap ().setConstant (bad_point);
+          output [index].curvature = bad_point;
           continue;
         }
 
-        float smoothing = (std::min)(distanceMap[index], normal_smoothing_size_ + static_cast<float>(depth)/10.0f);
-
-        if (smoothing > 2.0f)
-        {
-          setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-          computePointNormal (ci, ri, index, output [index]);
-        }
+        float smoothing;
+        if (use_depth_dependent_smoothing_)
+          smoothing = (std::min)(distanceMap[index], normal_smoothing_size_ + static_cast<float>(depth)/10.0f);
         else
-        {
-          output[index].getNormalVector4fMap ().setConstant (bad_point);
-          output[index].curvature = bad_point;
-        }
-      }
-    }
-  }
-  else
-  {
-    float smoothing_constant = normal_smoothing_size_;
+          smoothing = (std::min)(distanceMap[index], normal_smoothing_size_);
 
-    index = border + input_->width * border;
-    unsigned skip = (border << 1);
-    for (unsigned ri = border; ri < input_->height - border; ++ri, index += skip)
-    {
-      for (unsigned ci = border; ci < input_->width - border; ++ci, ++index)
-      {
-        index = ri * input_->width + ci;
-
-        if (!pcl_isfinite (input_->points[index].z))
+        if (smoothing <= 2.0f)
         {
           output [index].getNormalVector4fMap ().setConstant (bad_point);
           output [index].curvature = bad_point;
           continue;
         }
 
-        float smoothing = (std::min)(distanceMap[index], smoothing_constant);
-
-        if (smoothing > 2.0f)
-        {
-          setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-          computePointNormal (ci, ri, index, output [index]);
-        }
+        const int rect_size = static_cast<int> (smoothing);
+        if (normal_estimation_method_ != COVARIANCE_MATRIX)
+          computePointNormal (ci, ri, index, rect_size, rect_size, output [index]);
+        else if (computeCovarianceMatrix (ci, ri, rect_size, rect_size, covariance_matrix) == 0)
+          output [index].normal_x = output [index].normal_y = output [index].normal_z = output [index].curvature = bad_point;
         else
         {
-          output [index].getNormalVector4fMap ().setConstant (bad_point);
-          output [index].curvature = bad_point;
+          batch.push_back (covariance_matrix);
+          batch_indices.push_back (index);
         }
       }
+
+      if (batch_indices.empty ())
+        continue;
+
+      // The normal is the eigenvector of the smallest eigenvalue
+      batch.solve (0);
+      for (size_t i = 0; i < batch_indices.size (); ++i)
+      {
+        const int index = batch_indices[i];
+        float nx, ny, nz, curvature;
+        batch.getPlaneParameters (i, nx, ny, nz, curvature);
+        if (!(batch.getEigenValues (i) [0] > 0.0f))
+          curvature = 0;
+        pcl::flipNormalTowardsViewpoint (input_->points[index], vpx_, vpy_, vpz_, nx, ny, nz);
+        output [index].normal_x = nx;
+        output [index].normal_y = ny;
+        output [index].normal_z = nz;
+        output [index].curvature = curvature;
+      }
     }
   }
-
-  delete[] depthChangeMap;
-  //delete[] distanceMap;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -44,56 +44,59 @@
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointOutT> void
-pcl::NormalEstimation<PointInT, PointOutT>::computeFeature (PointCloudOut &output)
+pcl::NormalEstimation<PointInT, PointOutT>::computeNormalBatch (
+    int begin, int end, pcl::CovarianceMatrixBatch &batch, std::vector<int> &batch_indices) const
 {
   // Allocate enough space to hold the results
   // \note This resize is irrelevant for a radiusSearch ().
   std::vector<int> nn_indices (k_);
   std::vector<float> nn_dists (k_);
 
-  output.is_dense = true;
-  // Save a few cycles by not checking every point for NaN/Inf values if the cloud is set to dense
-  if (input_->is_dense)
+  batch.clear ();
+  batch_indices.clear ();
+  for (int idx = begin; idx < end; ++idx)
   {
-    // Iterating over the entire index vector
-    for (size_t idx = 0; idx < indices_->size (); ++idx)
-    {
-      if (this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
-      {
-        output.points[idx].normal[0] = output.points[idx].normal[1] = output.points[idx].normal[2] = output.points[idx].curvature = std::numeric_limits<float>::quiet_NaN ();
-
-        output.is_dense = false;
-        continue;
-      }
-
-      computePointNormal (*surface_, nn_indices,
-                          output.points[idx].normal[0], output.points[idx].normal[1], output.points[idx].normal[2], output.points[idx].curvature);
+    // Save a few cycles by not checking every point for NaN/Inf values if the cloud is set to dense
+    if ((!input_->is_dense && !isFinite ((*input_)[(*indices_)[idx]])) ||
+        this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0 ||
+        batch.addNeighborhood (*surface_, nn_indices) == 0)
+      continue;
+    batch_indices.push_back (idx);
+  }
+  // The normal is the eigenvector of the smallest eigenvalue
+  batch.solve (0);
+}
 
-      flipNormalTowardsViewpoint (input_->points[(*indices_)[idx]], vpx_, vpy_, vpz_,
-                                  output.points[idx].normal[0], output.points[idx].normal[1], output.points[idx].normal[2]);
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::NormalEstimation<PointInT, PointOutT>::computeFeature (PointCloudOut &output)
+{
+  pcl::CovarianceMatrixBatch batch;
+  std::vector<int> batch_indices;
+  batch_indices.reserve (batch_size_);
 
-    }
-  }
-  else
+  output.is_dense = true;
+  const int nr_points = static_cast<int> (indices_->size ());
+  // Iterating over the entire index vector, one block of points at a time
+  for (int begin = 0; begin < nr_points; begin += batch_size_)
   {
-    // Iterating over the entire index vector
-    for (size_t idx = 0; idx < indices_->size (); ++idx)
+    const int end = std::min (nr_points, begin + batch_size_);
+    computeNormalBatch (begin, end, batch, batch_indices);
+
+    if (static_cast<int> (batch.size ()) != end - begin)
     {
-      if (!isFinite ((*input_)[(*indices_)[idx]]) ||
-          this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
-      {
+      for (int idx = begin; idx < end; ++idx)
         output.points[idx].normal[0] = output.points[idx].normal[1] = output.points[idx].normal[2] = output.points[idx].curvature = std::numeric_limits<float>::quiet_NaN ();
+      output.is_dense = false;
+    }
 
-        output.is_dense = false;
-        continue;
-      }
-
-      computePointNormal (*surface_, nn_indices,
-                          output.points[idx].normal[0], output.points[idx].normal[1], output.points[idx].normal[2], output.points[idx].curvature);
+    for (size_t i = 0; i < batch.size (); ++i)
+    {
+      const int idx = batch_indices[i];
+      batch.getPlaneParameters (i, output.points[idx].normal[0], output.points[idx].normal[1], output.points[idx].normal[2], output.points[idx].curvature);
 
       flipNormalTowardsViewpoint (input_->points[(*indices_)[idx]], vpx_, vpy_, vpz_,
                                   output.points[idx].normal[0], output.points[idx].normal[1], output.points[idx].normal[2]);
-
     }
   }
 }
@@ -105,52 +108,31 @@ pcl::NormalEstimation<PointInT, Eigen::MatrixXf>::computeFeatureEigen (pcl::Poin
   // Resize the output dataset
   output.points.resize (indices_->size (), 4);
 
-  // Allocate enough space to hold the results
-  // \note This resize is irrelevant for a radiusSearch ().
-  std::vector<int> nn_indices (k_);
-  std::vector<float> nn_dists (k_);
+  pcl::CovarianceMatrixBatch batch;
+  std::vector<int> batch_indices;
+  batch_indices.reserve (batch_size_);
 
   output.is_dense = true;
-  // Save a few cycles by not checking every point for NaN/Inf values if the cloud is set to dense
-  if (input_->is_dense)
+  const int nr_points = static_cast<int> (indices_->size ());
+  // Iterating over the entire index vector, one block of points at a time
+  for (int begin = 0; begin < nr_points; begin += batch_size_)
   {
-    // Iterating over the entire index vector
-    for (size_t idx = 0; idx < indices_->size (); ++idx)
-    {
-      if (this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
-      {
-        output.points (idx, 0) = output.points (idx, 1) = output.points (idx, 2) = output.points (idx, 3) = std::numeric_limits<float>::quiet_NaN ();
-        output.is_dense = false;
-        continue;
-      }
-
-      computePointNormal (*surface_, nn_indices,
-                          output.points (idx, 0), output.points (idx, 1), output.points (idx, 2), output.points (idx, 3));
+    const int end = std::min (nr_points, begin + batch_size_);
+    computeNormalBatch (begin, end, batch, batch_indices);
 
-      flipNormalTowardsViewpoint (input_->points[(*indices_)[idx]], vpx_, vpy_, vpz_,
-                                  output.points (idx, 0), output.points (idx, 1), output.points (idx, 2));
-
-    }
-  }
-  else
-  {
-    // Iterating over the entire index vector
-    for (size_t idx = 0; idx < indices_->size (); ++idx)
+    if (static_cast<int> (batch.size ()) != end - begin)
     {
-      if (!isFinite ((*input_)[(*indices_)[idx]]) ||
-          this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
-      {
-        output.points (idx, 0) = output.points (idx, 1) = output.points (idx, 2) = output.points (idx, 3) = std::numeric_limits<float>::quiet_NaN ();
-        output.is_dense = false;
-        continue;
-      }
+      output.points.block (begin, 0, end - begin, 4).setConstant (std::numeric_limits<float>::quiet_NaN ());
+      output.is_dense = false;
+    }
 
-      computePointNormal (*surface_, nn_indices,
-                          output.points (idx, 0), output.points (idx, 1), output.points (idx, 2), output.points (idx, 3));
+    for (size_t i = 0; i < batch.size (); ++i)
+    {
+      const int idx = batch_indices[i];
+      batch.getPlaneParameters (i, output.points (idx, 0), output.points (idx, 1), output.points (idx, 2), output.points (idx, 3));
 
       flipNormalTowardsViewpoint (input_->points[(*indices_)[idx]], vpx_, vpy_, vpz_,
                                   output.points (idx, 0), output.points (idx, 1), output.points (idx, 2));
-
     }
   }
 }
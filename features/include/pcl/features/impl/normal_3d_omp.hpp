@@ -53,42 +53,43 @@ pcl::NormalEstimationOMP<PointInT, Eigen::MatrixXf>::computeFeatureEigen (pcl::P
   // Resize the output dataset
   output.points.resize (indices_->size (), 4);
 
+  const int nr_points = static_cast<int> (indices_->size ());
+  const int nr_blocks = (nr_points + batch_size_ - 1) / batch_size_;
+
   // GCC 4.2.x seems to segfault with "internal compiler error" on MacOS X here
 #if defined(_WIN32) || ((__GNUC__ > 4) && (__GNUC_MINOR__ > 2)) 
-#pragma omp parallel for schedule (dynamic, threads_)
+#pragma omp parallel
 #endif
-  // Iterating over the entire index vector
-  for (int idx = 0; idx < static_cast<int> (indices_->size ()); ++idx)
   {
-    // Allocate enough space to hold the results
-    // \note This resize is irrelevant for a radiusSearch ().
-    std::vector<int> nn_indices (k_);
-    std::vector<float> nn_dists (k_);
+    // Every thread solves its own blocks of points
+    pcl::CovarianceMatrixBatch batch;
+    std::vector<int> batch_indices;
+    batch_indices.reserve (batch_size_);
 
-    if (!isFinite ((*input_)[(*indices_)[idx]]) ||
-        this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
+#if defined(_WIN32) || ((__GNUC__ > 4) && (__GNUC_MINOR__ > 2)) 
+#pragma omp for schedule (dynamic)
+#endif
+    for (int block = 0; block < nr_blocks; ++block)
     {
-      output.points (idx, 0) = output.points (idx, 1) = output.points (idx, 2) = output.points (idx, 3) = std::numeric_limits<float>::quiet_NaN ();
-      output.is_dense = false;
-      continue;
+      const int begin = block * batch_size_;
+      const int end = std::min (nr_points, begin + batch_size_);
+      computeNormalBatch (begin, end, batch, batch_indices);
+
+      if (static_cast<int> (batch.size ()) != end - begin)
+      {
+        output.points.block (begin, 0, end - begin, 4).setConstant (std::numeric_limits<float>::quiet_NaN ());
+        output.is_dense = false;
+      }
+
+      for (size_t i = 0; i < batch.size (); ++i)
+      {
+        const int idx = batch_indices[i];
+        batch.getPlaneParameters (i, output.points (idx, 0), output.points (idx, 1), output.points (idx, 2), output.points (idx, 3));
+
+        flipNormalTowardsViewpoint (input_->points[(*indices_)[idx]], vpx, vpy, vpz,
+                                    output.points (idx, 0), output.points (idx, 1), output.points (idx, 2));
+      }
     }
-
-    // 16-bytes aligned placeholder for the XYZ centroid of a surface patch
-    Eigen::Vector4f xyz_centroid;
-    // Estimate the XYZ centroid
-    compute3DCentroid (*surface_, nn_indices, xyz_centroid);
-
-    // Placeholder for the 3x3 covariance matrix at each surface patch
-    EIGEN_ALIGN16 Eigen::Matrix3f covariance_matrix;
-    // Compute the 3x3 covariance matrix
-    computeCovarianceMatrix (*surface_, nn_indices, xyz_centroid, covariance_matrix);
-
-    // Get the plane normal and surface curvature
-    solvePlaneParameters (covariance_matrix,
-                          output.points (idx, 0), output.points (idx, 1), output.points (idx, 2), output.points (idx, 3));
-
-    flipNormalTowardsViewpoint (input_->points[(*indices_)[idx]], vpx, vpy, vpz,
-                                output.points (idx, 0), output.points (idx, 1), output.points (idx, 2));
   }
 }
 
@@ -100,40 +101,40 @@ pcl::NormalEstimationOMP<PointInT, PointOutT>::computeFeature (PointCloudOut &ou
   getViewPoint (vpx, vpy, vpz);
 
   output.is_dense = true;
-  // Iterating over the entire index vector
-#pragma omp parallel for schedule (dynamic, threads_)
-  for (int idx = 0; idx < static_cast<int> (indices_->size ()); ++idx)
+  const int nr_points = static_cast<int> (indices_->size ());
+  const int nr_blocks = (nr_points + batch_size_ - 1) / batch_size_;
+
+  // Iterating over the entire index vector, one block of points at a time
+#pragma omp parallel
   {
-    // Allocate enough space to hold the results
-    // \note This resize is irrelevant for a radiusSearch ().
-    std::vector<int> nn_indices (k_);
-    std::vector<float> nn_dists (k_);
+    // Every thread solves its own blocks of points
+    pcl::CovarianceMatrixBatch batch;
+    std::vector<int> batch_indices;
+    batch_indices.reserve (batch_size_);
 
-    if (!isFinite ((*input_)[(*indices_)[idx]]) ||
-        this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
+#pragma omp for schedule (dynamic)
+    for (int block = 0; block < nr_blocks; ++block)
     {
-      output.points[idx].normal[0] = output.points[idx].normal[1] = output.points[idx].normal[2] = output.points[idx].curvature = std::numeric_limits<float>::quiet_NaN ();
-  
-      output.is_dense = false;
-      continue;
+      const int begin = block * batch_size_;
+      const int end = std::min (nr_points, begin + batch_size_);
+      computeNormalBatch (begin, end, batch, batch_indices);
+
+      if (static_cast<int> (batch.size ()) != end - begin)
+      {
+        for (int idx = begin; idx < end; ++idx)
+          output.points[idx].normal[0] = output.points[idx].normal[1] = output.points[idx].normal[2] = output.points[idx].curvature = std::numeric_limits<float>::quiet_NaN ();
+        output.is_dense = false;
+      }
+
+      for (size_t i = 0; i < batch.size (); ++i)
+      {
+        const int idx = batch_indices[i];
+        batch.getPlaneParameters (i, output.points[idx].normal[0], output.points[idx].normal[1], output.points[idx].normal[2], output.points[idx].curvature);
+
+        flipNormalTowardsViewpoint (input_->points[(*indices_)[idx]], vpx, vpy, vpz,
+                                    output.points[idx].normal[0], output.points[idx].normal[1], output.points[idx].normal[2]);
+      }
     }
-
-    // 16-bytes aligned placeholder for the XYZ centroid of a surface patch
-    Eigen::Vector4f xyz_centroid;
-    // Estimate the XYZ centroid
-    compute3DCentroid (*surface_, nn_indices, xyz_centroid);
-
-    // Placeholder for the 3x3 covariance matrix at each surface patch
-    EIGEN_ALIGN16 Eigen::Matrix3f covariance_matrix;
-    // Compute the 3x3 covariance matrix
-    computeCovarianceMatrix (*surface_, nn_indices, xyz_centroid, covariance_matrix);
-
-    // Get the plane normal and surface curvature
-    solvePlaneParameters (covariance_matrix,
-                          output.points[idx].normal[0], output.points[idx].normal[1], output.points[idx].normal[2], output.points[idx].curvature);
-
-    flipNormalTowardsViewpoint (input_->points[(*indices_)[idx]], vpx, vpy, vpz,
-                                output.points[idx].normal[0], output.points[idx].normal[1], output.points[idx].normal[2]);
   }
 }
 
@@ -46,7 +46,7 @@
 template <typename PointInT, typename PointNT, typename PointOutT> bool
 pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computePairFeatures (
       const pcl::PointCloud<PointInT> &cloud, const pcl::PointCloud<PointNT> &normals,
-      int p_idx, int q_idx, float &f1, float &f2, float &f3, float &f4)
+      int p_idx, int q_idx, float &f1, float &f2, float &f3, float &f4) const
 {
   pcl::computePairFeatures (cloud.points[p_idx].getVector4fMap (), normals.points[p_idx].getNormalVector4fMap (),
                             cloud.points[q_idx].getVector4fMap (), normals.points[q_idx].getNormalVector4fMap (),
@@ -60,6 +60,20 @@ pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computePointPFHSignature (
       const pcl::PointCloud<PointInT> &cloud, const pcl::PointCloud<PointNT> &normals,
       const std::vector<int> &indices, int nr_split, Eigen::VectorXf &pfh_histogram)
 {
+  if (use_cache_ && feature_cache_.capacity () == 0)
+    feature_cache_.resize (getCacheCapacity ());
+  computePointPFHSignature (cloud, normals, indices, nr_split, pfh_histogram, use_cache_ ? &feature_cache_ : NULL);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computePointPFHSignature (
+      const pcl::PointCloud<PointInT> &cloud, const pcl::PointCloud<PointNT> &normals,
+      const std::vector<int> &indices, int nr_split, Eigen::VectorXf &pfh_histogram,
+      PairFeatureCache *cache) const
+{
+  Eigen::Vector4f pfh_tuple;
+  int f_index[3];
   int h_index, h_p;
 
   // Clear the resultant point histogram
@@ -68,7 +82,6 @@ pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computePointPFHSignature (
   // Factorization constant
   float hist_incr = 100.0f / static_cast<float> (indices.size () * (indices.size () - 1) / 2);
 
-  std::pair<int, int> key;
   // Iterate over all the points in the neighborhood
   for (size_t i_idx = 0; i_idx < indices.size (); ++i_idx)
   {
@@ -78,77 +91,38 @@ pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computePointPFHSignature (
       if (!isFinite (cloud.points[indices[i_idx]]) || !isFinite (cloud.points[indices[j_idx]]))
         continue;
 
-      if (use_cache_)
+      // Check to see if we already estimated this pair, else compute the pair NNi to NNj
+      if (!cache || !cache->find (indices[i_idx], indices[j_idx], pfh_tuple))
       {
-        // In order to create the key, always use the smaller index as the first key pair member
-        int p1, p2;
-  //      if (indices[i_idx] >= indices[j_idx])
-  //      {
-          p1 = indices[i_idx];
-          p2 = indices[j_idx];
-  //      }
-  //      else
-  //      {
-  //        p1 = indices[j_idx];
-  //        p2 = indices[i_idx];
-  //      }
-        key = std::pair<int, int> (p1, p2);
-
-        // Check to see if we already estimated this pair in the global hashmap
-        std::map<std::pair<int, int>, Eigen::Vector4f, std::less<std::pair<int, int> >, Eigen::aligned_allocator<Eigen::Vector4f> >::iterator fm_it = feature_map_.find (key);
-        if (fm_it != feature_map_.end ())
-          pfh_tuple_ = fm_it->second;
-        else
-        {
-          // Compute the pair NNi to NNj
-          if (!computePairFeatures (cloud, normals, indices[i_idx], indices[j_idx],
-                                    pfh_tuple_[0], pfh_tuple_[1], pfh_tuple_[2], pfh_tuple_[3]))
-            continue;
-        }
-      }
-      else
         if (!computePairFeatures (cloud, normals, indices[i_idx], indices[j_idx],
-                                  pfh_tuple_[0], pfh_tuple_[1], pfh_tuple_[2], pfh_tuple_[3]))
+                                  pfh_tuple[0], pfh_tuple[1], pfh_tuple[2], pfh_tuple[3]))
           continue;
+        if (cache)
+          cache->insert (indices[i_idx], indices[j_idx], pfh_tuple);
+      }
 
       // Normalize the f1, f2, f3 features and push them in the histogram
-      f_index_[0] = static_cast<int> (floor (nr_split * ((pfh_tuple_[0] + M_PI) * d_pi_)));
-      if (f_index_[0] < 0)         f_index_[0] = 0;
-      if (f_index_[0] >= nr_split) f_index_[0] = nr_split - 1;
+      f_index[0] = static_cast<int> (floor (nr_split * ((pfh_tuple[0] + M_PI) * d_pi_)));
+      if (f_index[0] < 0)         f_index[0] = 0;
+      if (f_index[0] >= nr_split) f_index[0] = nr_split - 1;
 
-      f_index_[1] = static_cast<int> (floor (nr_split * ((pfh_tuple_[1] + 1.0) * 0.5)));
-      if (f_index_[1] < 0)         f_index_[1] = 0;
-      if (f_index_[1] >= nr_split) f_index_[1] = nr_split - 1;
+      f_index[1] = static_cast<int> (floor (nr_split * ((pfh_tuple[1] + 1.0) * 0.5)));
+      if (f_index[1] < 0)         f_index[1] = 0;
+      if (f_index[1] >= nr_split) f_index[1] = nr_split - 1;
 
-      f_index_[2] = static_cast<int> (floor (nr_split * ((pfh_tuple_[2] + 1.0) * 0.5)));
-      if (f_index_[2] < 0)         f_index_[2] = 0;
-      if (f_index_[2] >= nr_split) f_index_[2] = nr_split - 1;
+      f_index[2] = static_cast<int> (floor (nr_split * ((pfh_tuple[2] + 1.0) * 0.5)));
+      if (f_index[2] < 0)         f_index[2] = 0;
+      if (f_index[2] >= nr_split) f_index[2] = nr_split - 1;
 
       // Copy into the histogram
       h_index = 0;
       h_p     = 1;
       for (int d = 0; d < 3; ++d)
       {
-        h_index += h_p * f_index_[d];
+        h_index += h_p * f_index[d];
         h_p     *= nr_split;
       }
       pfh_histogram[h_index] += hist_incr;
-
-      if (use_cache_)
-      {
-        // Save the value in the hashmap
-        feature_map_[key] = pfh_tuple_;
-
-        // Use a maximum cache so that we don't go overboard on RAM usage
-        key_list_.push (key);
-        // Check to see if we need to remove an element due to exceeding max_size
-        if (key_list_.size () > max_cache_size_)
-        {
-          // Remove the last element.
-          feature_map_.erase (key_list_.back ());
-          key_list_.pop ();
-        }
-      }
     }
   }
 }
@@ -157,10 +131,9 @@ pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computePointPFHSignature (
 template <typename PointInT, typename PointNT, typename PointOutT> void
 pcl::PFHEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut &output)
 {
-  // Clear the feature map
-  feature_map_.clear ();
-  std::queue<std::pair<int, int> > empty;
-  std::swap (key_list_, empty);
+  // Clear the feature cache
+  if (use_cache_)
+    feature_cache_.resize (getCacheCapacity ());
 
   pfh_histogram_.setZero (nr_subdiv_ * nr_subdiv_ * nr_subdiv_);
 
@@ -229,10 +202,9 @@ pcl::PFHEstimation<PointInT, PointNT, Eigen::MatrixXf>::computeFeatureEigen (pcl
   output.channels["pfh"].count    = nr_subdiv_ * nr_subdiv_ * nr_subdiv_;
   output.channels["pfh"].datatype = sensor_msgs::PointField::FLOAT32;
 
-  // Clear the feature map
-  feature_map_.clear ();
-  std::queue<std::pair<int, int> > empty;
-  std::swap (key_list_, empty);
+  // Clear the feature cache
+  if (use_cache_)
+    feature_cache_.resize (getCacheCapacity ());
   pfh_histogram_.setZero (nr_subdiv_ * nr_subdiv_ * nr_subdiv_);
 
   // Allocate enough space to hold the results
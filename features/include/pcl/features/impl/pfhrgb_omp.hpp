@@ -0,0 +1,77 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FEATURES_IMPL_PFHRGB_OMP_H_
+#define PCL_FEATURES_IMPL_PFHRGB_OMP_H_
+
+#include <pcl/features/pfhrgb_omp.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::PFHRGBEstimationOMP<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut &output)
+{
+  /// nr_subdiv^3 for RGB and nr_subdiv^3 for the angular features
+  const int nr_bins = 2 * nr_subdiv_ * nr_subdiv_ * nr_subdiv_;
+  const int threads = static_cast<int> (threads_);
+
+#pragma omp parallel num_threads (threads)
+  {
+    // Every thread has its own neighborhood and histogram
+    std::vector<int> nn_indices (k_);
+    std::vector<float> nn_dists (k_);
+    Eigen::VectorXf pfhrgb_histogram = Eigen::VectorXf::Zero (nr_bins);
+
+#pragma omp for schedule (dynamic, 64)
+    for (int idx = 0; idx < static_cast<int> (indices_->size ()); ++idx)
+    {
+      this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists);
+
+      // Estimate the PFH signature at each patch
+      computePointPFHRGBSignature (*surface_, *normals_, nn_indices, nr_subdiv_, pfhrgb_histogram);
+
+      // Copy into the resultant cloud
+      for (int d = 0; d < nr_bins; ++d)
+        output.points[idx].histogram[d] = pfhrgb_histogram[d];
+    }
+  }
+}
+
+#define PCL_INSTANTIATE_PFHRGBEstimationOMP(T,NT,OutT) template class PCL_EXPORTS pcl::PFHRGBEstimationOMP<T,NT,OutT>;
+
+#endif    // PCL_FEATURES_IMPL_PFHRGB_OMP_H_
@@ -44,9 +44,8 @@
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointNT, typename PointOutT> void
-pcl::PrincipalCurvaturesEstimation<PointInT, PointNT, PointOutT>::computePointPrincipalCurvatures (
-      const pcl::PointCloud<PointNT> &normals, int p_idx, const std::vector<int> &indices,
-      float &pcx, float &pcy, float &pcz, float &pc1, float &pc2)
+pcl::PrincipalCurvaturesEstimation<PointInT, PointNT, PointOutT>::computeProjectedNormalsCovariance (
+      const pcl::PointCloud<PointNT> &normals, int p_idx, const std::vector<int> &indices)
 {
   EIGEN_ALIGN16 Eigen::Matrix3f I = Eigen::Matrix3f::Identity ();
   Eigen::Vector3f n_idx (normals.points[p_idx].normal[0], normals.points[p_idx].normal[1], normals.points[p_idx].normal[2]);
@@ -94,6 +93,15 @@ pcl::PrincipalCurvaturesEstimation<PointInT, PointNT, PointOutT>::computePointPr
     covariance_matrix_(2, 1) += static_cast<float> (demean_yz);
     covariance_matrix_(2, 2) += demean_[2] * demean_[2];
   }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::PrincipalCurvaturesEstimation<PointInT, PointNT, PointOutT>::computePointPrincipalCurvatures (
+      const pcl::PointCloud<PointNT> &normals, int p_idx, const std::vector<int> &indices,
+      float &pcx, float &pcy, float &pcz, float &pc1, float &pc2)
+{
+  computeProjectedNormalsCovariance (normals, p_idx, indices);
 
   // Extract the eigenvalues and eigenvectors
   pcl::eigen33 (covariance_matrix_, eigenvalues_);
@@ -107,58 +115,74 @@ pcl::PrincipalCurvaturesEstimation<PointInT, PointNT, PointOutT>::computePointPr
   pc2 = eigenvalues_ [1] * indices_size;
 }
 
-
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointNT, typename PointOutT> void
-pcl::PrincipalCurvaturesEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut &output)
+pcl::PrincipalCurvaturesEstimation<PointInT, PointNT, PointOutT>::computeCurvatureBatch (
+      int begin, int end, pcl::CovarianceMatrixBatch &batch,
+      std::vector<int> &batch_indices, std::vector<int> &batch_sizes)
 {
   // Allocate enough space to hold the results
   // \note This resize is irrelevant for a radiusSearch ().
   std::vector<int> nn_indices (k_);
   std::vector<float> nn_dists (k_);
 
+  batch.clear ();
+  batch_indices.clear ();
+  batch_sizes.clear ();
+  for (int idx = begin; idx < end; ++idx)
+  {
+    // Save a few cycles by not checking every point for NaN/Inf values if the cloud is set to dense
+    if ((!input_->is_dense && !isFinite ((*input_)[(*indices_)[idx]])) ||
+        this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
+      continue;
+
+    computeProjectedNormalsCovariance (*normals_, (*indices_)[idx], nn_indices);
+    batch.push_back (covariance_matrix_);
+    batch_indices.push_back (idx);
+    batch_sizes.push_back (static_cast<int> (nn_indices.size ()));
+  }
+  // The principal curvature is the eigenvector of the largest eigenvalue
+  batch.solve (2);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::PrincipalCurvaturesEstimation<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut &output)
+{
+  pcl::CovarianceMatrixBatch batch;
+  std::vector<int> batch_indices, batch_sizes;
+
   output.is_dense = true;
-  // Save a few cycles by not checking every point for NaN/Inf values if the cloud is set to dense
-  if (input_->is_dense)
+  const int nr_points = static_cast<int> (indices_->size ());
+  // Iterating over the entire index vector, one block of points at a time
+  for (int begin = 0; begin < nr_points; begin += batch_size_)
   {
-    // Iterating over the entire index vector
-    for (size_t idx = 0; idx < indices_->size (); ++idx)
+    const int end = std::min (nr_points, begin + batch_size_);
+    computeCurvatureBatch (begin, end, batch, batch_indices, batch_sizes);
+
+    if (static_cast<int> (batch.size ()) != end - begin)
     {
-      if (this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
-      {
+      for (int idx = begin; idx < end; ++idx)
         output.points[idx].principal_curvature[0] = output.points[idx].principal_curvature[1] = output.points[idx].principal_curvature[2] =
           output.points[idx].pc1 = output.points[idx].pc2 = std::numeric_limits<float>::quiet_NaN ();
-        output.is_dense = false;
-        continue;
-      }
-
-      // Estimate the principal curvatures at each patch
-      computePointPrincipalCurvatures (*normals_, (*indices_)[idx], nn_indices,
-                                       output.points[idx].principal_curvature[0], output.points[idx].principal_curvature[1], output.points[idx].principal_curvature[2],
-                                       output.points[idx].pc1, output.points[idx].pc2);
+      output.is_dense = false;
     }
-  }
-  else
-  {
-    // Iterating over the entire index vector
-    for (size_t idx = 0; idx < indices_->size (); ++idx)
+
+    for (size_t i = 0; i < batch.size (); ++i)
     {
-      if (!isFinite ((*input_)[(*indices_)[idx]]) ||
-          this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
-      {
-        output.points[idx].principal_curvature[0] = output.points[idx].principal_curvature[1] = output.points[idx].principal_curvature[2] =
-          output.points[idx].pc1 = output.points[idx].pc2 = std::numeric_limits<float>::quiet_NaN ();
-        output.is_dense = false;
-        continue;
-      }
-
-      // Estimate the principal curvatures at each patch
-      computePointPrincipalCurvatures (*normals_, (*indices_)[idx], nn_indices,
-                                       output.points[idx].principal_curvature[0], output.points[idx].principal_curvature[1], output.points[idx].principal_curvature[2],
-                                       output.points[idx].pc1, output.points[idx].pc2);
+      const int idx = batch_indices[i];
+      const Eigen::Vector3f eigenvector = batch.getEigenVector (i);
+      const Eigen::Vector3f eigenvalues = batch.getEigenValues (i);
+      const float indices_size = 1.0f / static_cast<float> (batch_sizes[i]);
+      output.points[idx].principal_curvature[0] = eigenvector[0];
+      output.points[idx].principal_curvature[1] = eigenvector[1];
+      output.points[idx].principal_curvature[2] = eigenvector[2];
+      output.points[idx].pc1 = eigenvalues[2] * indices_size;
+      output.points[idx].pc2 = eigenvalues[1] * indices_size;
     }
   }
 }
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointNT> void
 pcl::PrincipalCurvaturesEstimation<PointInT, PointNT, Eigen::MatrixXf>::computeFeatureEigen (pcl::PointCloud<Eigen::MatrixXf> &output)
@@ -166,48 +190,31 @@ pcl::PrincipalCurvaturesEstimation<PointInT, PointNT, Eigen::MatrixXf>::computeF
   // Resize the output dataset
   output.points.resize (indices_->size (), 5);
 
-  // Allocate enough space to hold the results
-  // \note This resize is irrelevant for a radiusSearch ().
-  std::vector<int> nn_indices (k_);
-  std::vector<float> nn_dists (k_);
+  pcl::CovarianceMatrixBatch batch;
+  std::vector<int> batch_indices, batch_sizes;
 
   output.is_dense = true;
-  // Save a few cycles by not checking every point for NaN/Inf values if the cloud is set to dense
-  if (input_->is_dense)
+  const int nr_points = static_cast<int> (indices_->size ());
+  // Iterating over the entire index vector, one block of points at a time
+  for (int begin = 0; begin < nr_points; begin += batch_size_)
   {
-    // Iterating over the entire index vector
-    for (size_t idx = 0; idx < indices_->size (); ++idx)
+    const int end = std::min (nr_points, begin + batch_size_);
+    computeCurvatureBatch (begin, end, batch, batch_indices, batch_sizes);
+
+    if (static_cast<int> (batch.size ()) != end - begin)
     {
-      if (this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
-      {
-        output.points.row (idx).setConstant (std::numeric_limits<float>::quiet_NaN ());
-        output.is_dense = false;
-        continue;
-      }
-
-      // Estimate the principal curvatures at each patch
-      this->computePointPrincipalCurvatures (*normals_, (*indices_)[idx], nn_indices,
-                                       output.points (idx, 0), output.points (idx, 1), output.points (idx, 2),
-                                       output.points (idx, 3), output.points (idx, 4));
+      output.points.block (begin, 0, end - begin, 5).setConstant (std::numeric_limits<float>::quiet_NaN ());
+      output.is_dense = false;
     }
-  }
-  else
-  {
-    // Iterating over the entire index vector
-    for (size_t idx = 0; idx < indices_->size (); ++idx)
+
+    for (size_t i = 0; i < batch.size (); ++i)
     {
-      if (!isFinite ((*input_)[(*indices_)[idx]]) ||
-          this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
-      {
-        output.points.row (idx).setConstant (std::numeric_limits<float>::quiet_NaN ());
-        output.is_dense = false;
-        continue;
-      }
-
-      // Estimate the principal curvatures at each patch
-      this->computePointPrincipalCurvatures (*normals_, (*indices_)[idx], nn_indices,
-                                       output.points (idx, 0), output.points (idx, 1), output.points (idx, 2),
-                                       output.points (idx, 3), output.points (idx, 4));
+      const int idx = batch_indices[i];
+      const Eigen::Vector3f eigenvalues = batch.getEigenValues (i);
+      const float indices_size = 1.0f / static_cast<float> (batch_sizes[i]);
+      output.points.block (idx, 0, 1, 3) = batch.getEigenVector (i).transpose ();
+      output.points (idx, 3) = eigenvalues[2] * indices_size;
+      output.points (idx, 4) = eigenvalues[1] * indices_size;
     }
   }
 }
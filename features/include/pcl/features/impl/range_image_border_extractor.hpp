@@ -159,7 +159,7 @@ bool RangeImageBorderExtractor::get3dDirection(const BorderDescription& border_d
   return true;
 }
 
-void RangeImageBorderExtractor::calculateBorderDirection(int x, int y)
+void RangeImageBorderExtractor::calculateBorderDirection(int x, int y, Eigen::Vector3f& direction)
 {
   int index = y*range_image_->width + x;
   Eigen::Vector3f*& border_direction = border_directions_[index];
@@ -168,13 +168,10 @@ void RangeImageBorderExtractor::calculateBorderDirection(int x, int y)
   const BorderTraits& border_traits = border_description.traits;
   if (!border_traits[BORDER_TRAIT__OBSTACLE_BORDER])
     return;
-  border_direction = new Eigen::Vector3f(0.0f, 0.0f, 0.0f);
-  if (!get3dDirection(border_description, *border_direction, surface_structure_[index]))
-  {
-    delete border_direction;
-    border_direction = NULL;
+  direction.setZero();
+  if (!get3dDirection(border_description, direction, surface_structure_[index]))
     return;
-  }
+  border_direction = &direction;
 }
 
 bool RangeImageBorderExtractor::changeScoreAccordingToShadowBorderValue(int x, int y, int offset_x, int offset_y, float* border_scores,
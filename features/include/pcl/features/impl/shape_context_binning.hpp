@@ -0,0 +1,131 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FEATURES_IMPL_SHAPE_CONTEXT_BINNING_HPP_
+#define PCL_FEATURES_IMPL_SHAPE_CONTEXT_BINNING_HPP_
+
+#include <pcl/features/shape_context_binning.h>
+#include <pcl/common/utils.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ShapeContextBinning::computeInverseDensities (const pcl::search::Search<PointT> &tree,
+                                                   const pcl::PointCloud<PointT> &surface, double radius,
+                                                   const std::vector<int> &nn_indices,
+                                                   const std::vector<float> &nn_dists,
+                                                   unsigned int nr_threads, std::vector<float> &inv_density)
+{
+  inv_density.assign (surface.points.size (), 0.0f);
+  std::vector<int> density_indices;
+  for (size_t i = 0; i < nn_indices.size (); ++i)
+  {
+    if (inv_density[nn_indices[i]] != 0.0f || pcl::utils::equal (nn_dists[i], 0.0f))
+      continue;
+    inv_density[nn_indices[i]] = -1.0f;
+    density_indices.push_back (nn_indices[i]);
+  }
+
+  const int threads = static_cast<int> (nr_threads);
+#pragma omp parallel num_threads (threads)
+  {
+    std::vector<int> density_nn_indices;
+    std::vector<float> density_nn_dists;
+
+#pragma omp for schedule (dynamic, 64)
+    for (int i = 0; i < static_cast<int> (density_indices.size ()); ++i)
+    {
+      const int p_idx = density_indices[i];
+      // The density is NOT always bigger than 0 (on error, the search returns 0)
+      const int point_density = tree.radiusSearch (surface, p_idx, radius, density_nn_indices, density_nn_dists);
+      inv_density[p_idx] = point_density == 0 ? 0.0f : 1.0f / static_cast<float> (point_density);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ShapeContextBinning::computePointDescriptor (const pcl::PointCloud<PointT> &surface,
+                                                  const Eigen::Vector3f &origin, const Eigen::Matrix3f &frame,
+                                                  const int *nn_indices, const float *nn_dists, int nr_neighbors,
+                                                  const std::vector<float> &inv_density,
+                                                  const std::vector<float> &volume_lut, float *desc) const
+{
+  const int nr_sqr_radii = static_cast<int> (sqr_radii_.size ());
+  const int nr_cos_theta = static_cast<int> (cos_theta_.size ());
+  const int nr_cos_phi = static_cast<int> (cos_phi_.size ());
+
+  for (int ne = 0; ne < nr_neighbors; ++ne)
+  {
+    const float w = inv_density[nn_indices[ne]];
+    if (w == 0.0f || pcl::utils::equal (nn_dists[ne], 0.0f))
+      continue;
+
+    // Coordinates of the neighbor in the local frame
+    const Eigen::Vector3f local = frame * (surface.points[nn_indices[ne]].getVector3fMap () - origin);
+
+    int j = 0;
+    for (int b = 0; b < nr_sqr_radii; ++b)
+      j += nn_dists[ne] > sqr_radii_[b];
+
+    const float cos_theta = local[2] / std::sqrt (nn_dists[ne]);
+    int k = 0;
+    for (int b = 0; b < nr_cos_theta; ++b)
+      k += cos_theta < cos_theta_[b];
+
+    // A neighbor on the normal has no azimuth, its cosine is NaN and it goes to the first bin
+    const float cos_phi = local[0] / std::sqrt (local[0] * local[0] + local[1] * local[1]);
+    int l = 0;
+    if (local[1] >= 0.0f)
+    {
+      for (int b = 0; b < nr_upper_phi_; ++b)
+        l += cos_phi < cos_phi_[b];
+    }
+    else
+    {
+      l = nr_upper_phi_;
+      for (int b = nr_upper_phi_; b < nr_cos_phi; ++b)
+        l += cos_phi > cos_phi_[b];
+    }
+
+    const size_t bin = (l * elevation_bins_ * radius_bins_) + (k * radius_bins_) + j;
+    desc[bin] += w * volume_lut[bin];
+  }
+}
+
+#endif    // PCL_FEATURES_IMPL_SHAPE_CONTEXT_BINNING_HPP_
@@ -99,15 +99,6 @@ pcl::SHOTEstimation<pcl::PointXYZRGBA, PointNT, PointOutT, PointRFT>::RGB2CIELAB
 {
   if (sRGB_LUT[0] < 0)
   {
-    for (int i = 0; i < 256; i++)
-    {
-      float f = static_cast<float> (i) / 255.0f;
-      if (f > 0.04045)
-        sRGB_LUT[i] = powf ((f + 0.055f) / 1.055f, 2.4f);
-      else
-        sRGB_LUT[i] = f / 12.92f;
-    }
-
     for (int i = 0; i < 4000; i++)
     {
       float f = static_cast<float> (i) / 4000.0f;
@@ -116,6 +107,16 @@ pcl::SHOTEstimation<pcl::PointXYZRGBA, PointNT, PointOutT, PointRFT>::RGB2CIELAB
       else
         sXYZ_LUT[i] = static_cast<float>((7.787 * f) + (16.0 / 116.0));
     }
+
+    // sRGB_LUT[0] marks the tables as ready, so it is written last
+    for (int i = 255; i >= 0; i--)
+    {
+      float f = static_cast<float> (i) / 255.0f;
+      if (f > 0.04045)
+        sRGB_LUT[i] = powf ((f + 0.055f) / 1.055f, 2.4f);
+      else
+        sRGB_LUT[i] = f / 12.92f;
+    }
   }
 
   float fr = sRGB_LUT[R];
@@ -152,6 +153,30 @@ pcl::SHOTEstimation<pcl::PointXYZRGBA, PointNT, PointOutT, PointRFT>::RGB2CIELAB
     B2 = -120.0f;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointNT, typename PointOutT, typename PointRFT> void
+pcl::SHOTEstimation<pcl::PointXYZRGBA, PointNT, PointOutT, PointRFT>::computeSurfaceLAB ()
+{
+  surface_lab_.resize (3 * surface_->points.size ());
+
+  // Neighboring points often share their color, convert each distinct color once
+  uint32_t last_rgb = 0;
+  float L = 0.0f, A = 0.0f, B2 = 0.0f;
+  RGB2CIELAB (0, 0, 0, L, A, B2);
+  for (size_t i = 0; i < surface_->points.size (); ++i)
+  {
+    const uint32_t rgb = surface_->points[i].rgba & 0xFFFFFF;
+    if (rgb != last_rgb)
+    {
+      RGB2CIELAB ((rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF, L, A, B2);
+      last_rgb = rgb;
+    }
+    surface_lab_[3 * i] = L / 100.0f;
+    surface_lab_[3 * i + 1] = A / 120.0f;
+    surface_lab_[3 * i + 2] = B2 / 120.0f;
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointNT, typename PointOutT, typename PointRFT> bool
 pcl::SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::initCompute ()
@@ -228,6 +253,21 @@ pcl::SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::normalizeHistog
     shot[j] /= static_cast<float> (acc_norm);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT, typename PointRFT> void
+pcl::SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::getLocalFrame (
+    const int index,
+    Eigen::Vector3f &central_point,
+    Eigen::Matrix3f &rotation) const
+{
+  central_point = (*input_)[(*indices_)[index]].getVector3fMap ();
+  const PointRFT& current_frame = (*frames_)[index];
+
+  rotation.row (0) = current_frame.x_axis.getNormalVector3fMap ();
+  rotation.row (1) = current_frame.y_axis.getNormalVector3fMap ();
+  rotation.row (2) = current_frame.z_axis.getNormalVector3fMap ();
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointNT, typename PointOutT, typename PointRFT> void
 pcl::SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::interpolateSingleChannel (
@@ -238,23 +278,23 @@ pcl::SHOTEstimationBase<PointInT, PointNT, PointOutT, PointRFT>::interpolateSing
     const int nr_bins,
     Eigen::VectorXf &shot)
 {
-  const Eigen::Vector4f& central_point = (*input_)[(*indices_)[index]].getVector4fMap ();
-  const PointRFT& current_frame = (*frames_)[index];
+  Eigen::Vector3f central_point;
+  Eigen::Matrix3f rotation;
+  getLocalFrame (index, central_point, rotation);
 
   for (size_t i_idx = 0; i_idx < indices.size (); ++i_idx)
   {
-    Eigen::Vector4f delta = surface_->points[indices[i_idx]].getVector4fMap () - central_point;
-    delta[3] = 0;
-
     // Compute the Euclidean norm
-   double distance = sqrt (sqr_dists[i_idx]);
+    double distance = sqrt (sqr_dists[i_idx]);
 
     if (areEquals (distance, 0.0))
       continue;
 
-    double xInFeatRef = delta.dot (current_frame.x_axis.getNormalVector4fMap ());
-    double yInFeatRef = delta.dot (current_frame.y_axis.getNormalVector4fMap ());
-    double zInFeatRef = delta.dot (current_frame.z_axis.getNormalVector4fMap ());
+    // Express the neighbor in the local reference frame, with fixed size products which need no allocation
+    const Eigen::Vector3f local_coordinates = rotation * (surface_->points[indices[i_idx]].getVector3fMap () - central_point);
+    double xInFeatRef = local_coordinates[0];
+    double yInFeatRef = local_coordinates[1];
+    double zInFeatRef = local_coordinates[2];
 
     // To avoid numerical problems afterwards
     if (fabs (yInFeatRef) < 1E-30)
@@ -408,25 +448,25 @@ pcl::SHOTEstimation<pcl::PointXYZRGBA, PointNT, PointOutT, PointRFT>::interpolat
   const int nr_bins_color,
   Eigen::VectorXf &shot)
 {
-  const Eigen::Vector4f &central_point = (*input_)[(*indices_)[index]].getVector4fMap ();
-  const PointRFT& current_frame = (*frames_)[index];
+  Eigen::Vector3f central_point;
+  Eigen::Matrix3f rotation;
+  this->getLocalFrame (index, central_point, rotation);
 
   int shapeToColorStride = nr_grid_sector_*(nr_bins_shape+1);
 
   for (size_t i_idx = 0; i_idx < indices.size (); ++i_idx)
   {
-    Eigen::Vector4f delta = surface_->points[indices[i_idx]].getVector4fMap () - central_point;
-    delta[3] = 0;
-
     // Compute the Euclidean norm
     double distance = sqrt (sqr_dists[i_idx]);
 
     if (areEquals (distance, 0.0))
       continue;
 
-    double xInFeatRef = delta.dot (current_frame.x_axis.getNormalVector4fMap ());
-    double yInFeatRef = delta.dot (current_frame.y_axis.getNormalVector4fMap ());
-    double zInFeatRef = delta.dot (current_frame.z_axis.getNormalVector4fMap ());
+    // Express the neighbor in the local reference frame, with fixed size products which need no allocation
+    const Eigen::Vector3f local_coordinates = rotation * (surface_->points[indices[i_idx]].getVector3fMap () - central_point);
+    double xInFeatRef = local_coordinates[0];
+    double yInFeatRef = local_coordinates[1];
+    double zInFeatRef = local_coordinates[2];
 
     // To avoid numerical problems afterwards
     if (fabs (yInFeatRef) < 1E-30)
@@ -668,16 +708,8 @@ pcl::SHOTEstimation<pcl::PointXYZRGBA, PointNT, PointOutT, PointRFT>::computePoi
 
     for (size_t i_idx = 0; i_idx < indices.size (); ++i_idx)
     {
-      unsigned char red = surface_->points[indices[i_idx]].rgba >> 16 & 0xFF;
-      unsigned char green = surface_->points[indices[i_idx]].rgba >> 8 & 0xFF;
-      unsigned char blue = surface_->points[indices[i_idx]].rgba & 0xFF;
-
       float L, a, b;
-
-      RGB2CIELAB (red, green, blue, L, a, b);
-      L /= 100.0f;
-      a /= 120.0f;
-      b /= 120.0f;   //normalized LAB components (0<L<1, -1<a<1, -1<b<1)
+      getSurfaceLAB (indices[i_idx], L, a, b);   //normalized LAB components (0<L<1, -1<a<1, -1<b<1)
 
       double colorDistance = (fabs (LRef - L) + ((fabs (aRef - a) + fabs (bRef - b)) / 2)) /3;
 
@@ -781,6 +813,9 @@ pcl::SHOTEstimation<pcl::PointXYZRGBA, PointNT, PointOutT, PointRFT>::computeFea
 
   shot_.setZero (descLength_);
 
+  if (b_describe_color_)
+    computeSurfaceLAB ();
+
   //if (output.points[0].descriptor.size () != static_cast<size_t> (descLength_))
   for (size_t idx = 0; idx < indices_->size (); ++idx)
     output.points[idx].descriptor.resize (descLength_);
@@ -833,6 +868,8 @@ pcl::SHOTEstimation<pcl::PointXYZRGBA, PointNT, PointOutT, PointRFT>::computeFea
     for (int d = 0; d < 9; ++d)
       output.points[idx].rf[d] = frames_->points[idx].rf[ (4*(d/3) + (d%3)) ];
   }
+
+  surface_lab_.clear ();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -860,6 +897,9 @@ pcl::SHOTEstimation<pcl::PointXYZRGBA, PointNT, Eigen::MatrixXf, PointRFT>::comp
 
   shot_.setZero (descLength_);
 
+  if (b_describe_color_)
+    this->computeSurfaceLAB ();
+
   output.points.resize (indices_->size (), descLength_ + 9);
 
   // Allocate enough space to hold the results
@@ -901,6 +941,8 @@ pcl::SHOTEstimation<pcl::PointXYZRGBA, PointNT, Eigen::MatrixXf, PointRFT>::comp
     for (int d = 0; d < 9; ++d)
       output.points (idx, shot_.size () + d) = frames_->points[idx].rf[ (4*(d/3) + (d%3)) ];
   }
+
+  this->surface_lab_.clear ();
 }
 
 
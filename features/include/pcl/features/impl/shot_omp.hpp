@@ -135,6 +135,10 @@ pcl::SHOTEstimationOMP<pcl::PointXYZRGBA, PointNT, PointOutT, PointRFT>::compute
   for (size_t idx = 0; idx < indices_->size (); ++idx)
     output.points[idx].descriptor.resize (descLength_);
 
+  // Convert the colors before the threads start, RGB2CIELAB builds its lookup tables on first use
+  if (b_describe_color_)
+    this->computeSurfaceLAB ();
+
   int data_size = static_cast<int> (indices_->size ());
   Eigen::VectorXf *shot = new Eigen::VectorXf[threads_];
 
@@ -191,6 +195,7 @@ pcl::SHOTEstimationOMP<pcl::PointXYZRGBA, PointNT, PointOutT, PointRFT>::compute
       output.points[idx].rf[d] = frames_->points[idx].rf[ (4*(d/3) + (d%3)) ];
   }
 
+  this->surface_lab_.clear ();
   delete[] shot;
 }
 
@@ -108,14 +108,30 @@ pcl::SpinImageEstimation<PointInT, PointNT, PointOutT>::computeSiForPoint (int i
       "spin_image.hpp", "computeSiForPoint");
   }
 
+  // Compute the geometry of all the neighbors at once: their distances to the origin point, the dot products of
+  // their directions with the rotation axis and, if needed, the dot products of their normals with the origin normal
+  const bool use_normals = support_angle_cos_ > 0.0 || is_angular_;
+  Eigen::Matrix<float, 3, Eigen::Dynamic> neighbors (3, neighb_cnt);
+  for (int i_neigh = 0; i_neigh < neighb_cnt; ++i_neigh)
+    neighbors.col (i_neigh) = surface_->points[nn_indices[i_neigh]].getVector3fMap () - origin_point;
+  const Eigen::RowVectorXf direction_norms = neighbors.colwise ().norm ();
+  const Eigen::RowVectorXf direction_dots = rotation_axis.transpose () * neighbors;
+  Eigen::RowVectorXf normal_dots;
+  if (use_normals)
+  {
+    for (int i_neigh = 0; i_neigh < neighb_cnt; ++i_neigh)
+      neighbors.col (i_neigh) = input_normals_->points[nn_indices[i_neigh]].getNormalVector3fMap ();
+    normal_dots = origin_normal.transpose () * neighbors;
+  }
+
   // for all neighbor points
   for (int i_neigh = 0; i_neigh < neighb_cnt ; i_neigh++)
   {
     // first, skip the points with distant normals
     double cos_between_normals = -2.0; // should be initialized if used
-    if (support_angle_cos_ > 0.0 || is_angular_) // not bogus
+    if (use_normals) // not bogus
     {
-      cos_between_normals = origin_normal.dot (input_normals_->points[nn_indices[i_neigh]].getNormalVector3fMap ());
+      cos_between_normals = normal_dots[i_neigh];
       if (fabs (cos_between_normals) > (1.0 + 10*std::numeric_limits<float>::epsilon ())) // should be okay for numeric stability
       {      
         PCL_ERROR ("[pcl::%s::computeSiForPoint] Normal for the point %d and/or the point %d are not normalized, dot ptoduct is %f.\n", 
@@ -137,15 +153,13 @@ pcl::SpinImageEstimation<PointInT, PointNT, PointOutT>::computeSiForPoint (int i
     }
     
     // now compute the coordinate in cylindric coordinate system associated with the origin point
-    const Eigen::Vector3f direction (
-      surface_->points[nn_indices[i_neigh]].getVector3fMap () - origin_point);
-    const double direction_norm = direction.norm ();
+    const double direction_norm = direction_norms[i_neigh];
     if (fabs(direction_norm) < 10*std::numeric_limits<double>::epsilon ())  
       continue;  // ignore the point itself; it does not contribute really
     assert (direction_norm > 0.0);
 
     // the angle between the normal vector and the direction to the point
-    double cos_dir_axis = direction.dot(rotation_axis) / direction_norm;
+    double cos_dir_axis = direction_dots[i_neigh] / direction_norm;
     if (fabs(cos_dir_axis) > (1.0 + 10*std::numeric_limits<float>::epsilon())) // should be okay for numeric stability
     {      
       PCL_ERROR ("[pcl::%s::computeSiForPoint] Rotation axis for the point %d are not normalized, dot ptoduct is %f.\n", 
@@ -211,10 +225,11 @@ pcl::SpinImageEstimation<PointInT, PointNT, PointOutT>::computeSiForPoint (int i
 
     if (is_angular_)
     {
-      m_averAngles (alpha_bin, beta_bin) += (1-a) * (1-b) * acos (cos_between_normals); 
-      m_averAngles (alpha_bin+1, beta_bin) += a * (1-b) * acos (cos_between_normals);
-      m_averAngles (alpha_bin, beta_bin+1) += (1-a) * b * acos (cos_between_normals);
-      m_averAngles (alpha_bin+1, beta_bin+1) += a * b * acos (cos_between_normals);
+      const double angle_between_normals = acos (cos_between_normals);
+      m_averAngles (alpha_bin, beta_bin) += (1-a) * (1-b) * angle_between_normals;
+      m_averAngles (alpha_bin+1, beta_bin) += a * (1-b) * angle_between_normals;
+      m_averAngles (alpha_bin, beta_bin+1) += (1-a) * b * angle_between_normals;
+      m_averAngles (alpha_bin+1, beta_bin+1) += a * b * angle_between_normals;
     }
   }
 
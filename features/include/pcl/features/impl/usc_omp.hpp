@@ -0,0 +1,107 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FEATURES_IMPL_USC_OMP_HPP_
+#define PCL_FEATURES_IMPL_USC_OMP_HPP_
+
+#include <pcl/features/usc_omp.h>
+#include <pcl/common/utils.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT, typename PointRFT> void
+pcl::UniqueShapeContextOMP<PointInT, PointOutT, PointRFT>::computeFeature (PointCloudOut &output)
+{
+  const int threads = static_cast<int> (threads_);
+  const int nr_queries = static_cast<int> (indices_->size ());
+  binning_.computeBinTables (radii_interval_, theta_divisions_, phi_divisions_);
+
+  // First pass: search the neighborhood of every query point with a valid frame once, into a compressed row buffer
+  std::vector<unsigned char> invalid_frames (nr_queries);
+  for (int idx = 0; idx < nr_queries; ++idx)
+  {
+    const PointRFT &current_frame = (*frames_)[idx];
+    invalid_frames[idx] = !pcl_isfinite (current_frame.rf[0]) || !pcl_isfinite (current_frame.rf[4]) ||
+                          !pcl_isfinite (current_frame.rf[11]);
+  }
+  std::vector<int> nn_offsets, nn_indices;
+  std::vector<float> nn_dists;
+  this->searchForNeighborhoods (search_radius_, threads_, nn_offsets, nn_indices, nn_dists, invalid_frames);
+
+  // Count the local point density of every surface point of the neighborhoods once
+  std::vector<float> inv_density;
+  ShapeContextBinning::computeInverseDensities (*this->tree_, *surface_, point_density_radius_, nn_indices, nn_dists,
+                                                threads_, inv_density);
+
+  // Second pass: bin the stored neighborhoods
+  bool is_dense = true;
+
+#pragma omp parallel for num_threads (threads) schedule (dynamic, 64)
+  for (int idx = 0; idx < nr_queries; ++idx)
+  {
+    if (nn_offsets[idx + 1] == nn_offsets[idx])
+    {
+      output[idx].descriptor.assign (descriptor_length_, std::numeric_limits<float>::quiet_NaN ());
+      for (int d = 0; d < 9; ++d)
+        output[idx].rf[d] = std::numeric_limits<float>::quiet_NaN ();
+      is_dense = false;
+      continue;
+    }
+
+    const PointRFT &current_frame = (*frames_)[idx];
+    const Eigen::Vector3f x_axis = current_frame.x_axis.getNormalVector3fMap ();
+    const Eigen::Vector3f normal = current_frame.z_axis.getNormalVector3fMap ();
+    Eigen::Matrix3f frame;
+    frame.row (0) = x_axis;
+    frame.row (1) = normal.cross (x_axis);
+    frame.row (2) = normal;
+    for (int d = 0; d < 9; ++d)
+      output[idx].rf[d] = current_frame.rf[(4*(d/3) + (d%3))];
+
+    output[idx].descriptor.assign (descriptor_length_, 0.0f);
+    binning_.computePointDescriptor (*surface_, (*input_)[(*indices_)[idx]].getVector3fMap (), frame,
+                                     &nn_indices[nn_offsets[idx]], &nn_dists[nn_offsets[idx]],
+                                     nn_offsets[idx + 1] - nn_offsets[idx], inv_density, volume_lut_,
+                                     &output[idx].descriptor[0]);
+  }
+  output.is_dense = is_dense;
+}
+
+#define PCL_INSTANTIATE_UniqueShapeContextOMP(T,OutT,RFT) template class PCL_EXPORTS pcl::UniqueShapeContextOMP<T,OutT,RFT>;
+
+#endif    // PCL_FEATURES_IMPL_USC_OMP_HPP_
@@ -0,0 +1,257 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_INCREMENTAL_FEATURE_H_
+#define PCL_INCREMENTAL_FEATURE_H_
+
+#include <pcl/features/feature.h>
+#include <pcl/features/feature_stage.h>
+#include <pcl/features/fpfh.h>
+#include <pcl/features/fpfh_omp.h>
+
+namespace pcl
+{
+  /** \brief IncrementalFeatureTraits tells IncrementalFeatureEstimation how far a change of a point spreads in the
+    * features of an estimator, as the number of neighborhoods between a point and the farthest point that its
+    * feature depends on. It is 1 for the features of a neighborhood, such as the normals, and 2 for FPFH whose
+    * features combine the SPFH of the neighbors. Specialize it for other estimators which combine the features of
+    * their neighbors.
+    * \ingroup features
+    */
+  template <typename FeatureT>
+  struct IncrementalFeatureTraits
+  {
+    static const int neighborhood_depth = 1;
+  };
+
+  template <typename PointInT, typename PointNT, typename PointOutT>
+  struct IncrementalFeatureTraits<FPFHEstimation<PointInT, PointNT, PointOutT> >
+  {
+    static const int neighborhood_depth = 2;
+  };
+
+  template <typename PointInT, typename PointNT, typename PointOutT>
+  struct IncrementalFeatureTraits<FPFHEstimationOMP<PointInT, PointNT, PointOutT> >
+  {
+    static const int neighborhood_depth = 2;
+  };
+
+  /** \brief IncrementalFeatureEstimation updates the features of a cloud which changed in a few places, by
+    * recomputing only the points whose features may differ from the features of the previous cloud.
+    *
+    * The points of the input cloud are matched to the points of the previous cloud by setPreviousIndices ().
+    * A point is changed if it has no previous point or if its coordinates differ from those of its previous point,
+    * and a previous point is removed if no unchanged point matches it. The features are recomputed, with the
+    * estimator given to setFeatureEstimator (), for:
+    *  - the changed points and the points given to setChangedIndices (), e.g. the points with new normals,
+    *  - the points within the search radius of them, or of the previous position of a removed point,
+    *  - for estimators which combine the features of their neighbors, such as FPFH, the points within the search
+    *    radius of all these points (see IncrementalFeatureTraits).
+    * All other features are copied from the previous features, so the output is the same as if the estimator ran
+    * on the whole input cloud, as long as the neighbors are found in the same order, e.g. sorted by distance.
+    *
+    * The features are estimated for all points of the input cloud, which is also the search surface. Estimators
+    * which search the k nearest neighbors have no bounded neighborhood, so all their features are recomputed.
+    *
+    * Example, with the normals and FPFH features of the previous cloud:
+    * \code
+    * boost::shared_ptr<pcl::NormalEstimationOMP<pcl::PointXYZ, pcl::Normal> > ne (...);
+    * pcl::IncrementalFeatureEstimation<pcl::PointXYZ, pcl::Normal> normal_update;
+    * normal_update.setFeatureEstimator (ne);
+    * normal_update.setInputCloud (cloud);
+    * normal_update.setPreviousCloud (previous_cloud);
+    * normal_update.setPreviousFeatures (previous_normals);
+    * normal_update.setPreviousIndices (previous_indices);
+    * normal_update.compute (*normals);
+    *
+    * boost::shared_ptr<pcl::FPFHEstimationOMP<pcl::PointXYZ, pcl::Normal, pcl::FPFHSignature33> > fpfh (...);
+    * fpfh->setInputNormals (normals);
+    * pcl::IncrementalFeatureEstimation<pcl::PointXYZ, pcl::FPFHSignature33> fpfh_update;
+    * fpfh_update.setFeatureEstimator (fpfh);
+    * ... the same clouds and indices, with the previous FPFH features ...
+    * fpfh_update.setChangedIndices (normal_update.getUpdatedIndices ());
+    * fpfh_update.compute (*descriptors);
+    * \endcode
+    * \ingroup features
+    */
+  template <typename PointInT, typename PointOutT>
+  class IncrementalFeatureEstimation
+  {
+    public:
+      typedef pcl::PointCloud<PointInT> PointCloudIn;
+      typedef typename PointCloudIn::ConstPtr PointCloudInConstPtr;
+
+      typedef pcl::PointCloud<PointOutT> PointCloudOut;
+      typedef typename PointCloudOut::ConstPtr PointCloudOutConstPtr;
+
+      typedef pcl::search::Search<PointInT> KdTree;
+      typedef typename KdTree::Ptr KdTreePtr;
+
+      typedef FeatureStageImpl<PointInT, PointOutT> FeatureStage;
+      typedef typename FeatureStage::Ptr FeatureStagePtr;
+
+      typedef boost::shared_ptr<IncrementalFeatureEstimation<PointInT, PointOutT> > Ptr;
+      typedef boost::shared_ptr<const IncrementalFeatureEstimation<PointInT, PointOutT> > ConstPtr;
+
+      /** \brief Empty constructor. */
+      IncrementalFeatureEstimation ()
+        : input_ (), previous_input_ (), previous_features_ (), previous_indices_ (), changed_indices_ ()
+        , updated_indices_ (), stage_ (), neighborhood_depth_ (1), threads_ (1)
+      {
+      }
+
+      /** \brief Set the estimator which recomputes the features. Its search parameters are read in compute ();
+        * its input cloud, indices and search surface are set by compute (), and its search method is reused.
+        * \param[in] feature the estimator, a pcl::Feature with the point types of this class
+        */
+      template <typename FeatureT> inline void
+      setFeatureEstimator (const boost::shared_ptr<FeatureT> &feature)
+      {
+        stage_.reset (new FeatureStage (feature));
+        neighborhood_depth_ = IncrementalFeatureTraits<FeatureT>::neighborhood_depth;
+      }
+
+      /** \brief Provide a pointer to the changed cloud.
+        * \param[in] cloud the const boost shared pointer to a PointCloud message
+        */
+      inline void
+      setInputCloud (const PointCloudInConstPtr &cloud) { input_ = cloud; }
+
+      /** \brief Get a pointer to the changed cloud. */
+      inline PointCloudInConstPtr
+      getInputCloud () const { return (input_); }
+
+      /** \brief Provide a pointer to the cloud the previous features were estimated for.
+        * \param[in] cloud the const boost shared pointer to a PointCloud message
+        */
+      inline void
+      setPreviousCloud (const PointCloudInConstPtr &cloud) { previous_input_ = cloud; }
+
+      /** \brief Get a pointer to the cloud the previous features were estimated for. */
+      inline PointCloudInConstPtr
+      getPreviousCloud () const { return (previous_input_); }
+
+      /** \brief Provide a pointer to the features of all points of the previous cloud.
+        * \param[in] features the const boost shared pointer to the features
+        */
+      inline void
+      setPreviousFeatures (const PointCloudOutConstPtr &features) { previous_features_ = features; }
+
+      /** \brief Get a pointer to the features of the previous cloud. */
+      inline PointCloudOutConstPtr
+      getPreviousFeatures () const { return (previous_features_); }
+
+      /** \brief Set the index in the previous cloud of every point of the input cloud, or -1 for the points which
+        * were added or changed. Without it, the clouds must have the same size and are matched point by point.
+        * \param[in] indices the previous index of every point of the input cloud
+        */
+      inline void
+      setPreviousIndices (const std::vector<int> &indices) { previous_indices_ = indices; }
+
+      /** \brief Set the points of the input cloud whose other input data changed, e.g. their normals, which
+        * are the updated indices of an incremental estimation of these data.
+        * \param[in] indices the indices of the points in the input cloud
+        */
+      inline void
+      setChangedIndices (const std::vector<int> &indices) { changed_indices_ = indices; }
+
+      /** \brief Get the points of the input cloud whose features were recomputed by the last compute (), in
+        * ascending order.
+        */
+      inline const std::vector<int>&
+      getUpdatedIndices () const { return (updated_indices_); }
+
+      /** \brief Set the number of threads which search the points to recompute.
+        * \param[in] nr_threads the number of hardware threads to use
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        threads_ = (nr_threads == 0) ? 1 : nr_threads;
+      }
+
+      /** \brief Recompute the features of the points affected by the changes and copy the others from the
+        * previous features.
+        * \param[out] output the features of all points of the input cloud
+        */
+      void
+      compute (PointCloudOut &output);
+
+    private:
+      /** \brief Add the points within the search radius of a set of points to a set of points to recompute.
+        * \param[in] search the search method of the input cloud
+        * \param[in] cloud the cloud of the query points, the input or the previous cloud
+        * \param[in] queries the indices of the query points in \a cloud
+        * \param[in] radius the search radius
+        * \param[in,out] affected the points of the input cloud to recompute, as a mask
+        */
+      void
+      addNeighbors (const KdTreePtr &search, const PointCloudIn &cloud, const std::vector<int> &queries,
+                    double radius, std::vector<bool> &affected) const;
+
+      /** \brief The changed cloud. */
+      PointCloudInConstPtr input_;
+
+      /** \brief The cloud of the previous features. */
+      PointCloudInConstPtr previous_input_;
+
+      /** \brief The features of the previous cloud. */
+      PointCloudOutConstPtr previous_features_;
+
+      /** \brief The index in the previous cloud of every point of the input cloud, or -1. */
+      std::vector<int> previous_indices_;
+
+      /** \brief The points of the input cloud whose other input data changed. */
+      std::vector<int> changed_indices_;
+
+      /** \brief The points of the input cloud whose features were recomputed. */
+      std::vector<int> updated_indices_;
+
+      /** \brief The estimator. */
+      FeatureStagePtr stage_;
+
+      /** \brief The neighborhood depth of the estimator, see IncrementalFeatureTraits. */
+      int neighborhood_depth_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+  };
+}
+
+#endif  //#ifndef PCL_INCREMENTAL_FEATURE_H_
@@ -119,7 +119,8 @@ namespace pcl
         finite_values_integral_image_ (),
         width_ (1), 
         height_ (1), 
-        compute_second_order_integral_images_ (compute_second_order_integral_images)
+        compute_second_order_integral_images_ (compute_second_order_integral_images),
+        threads_ (1)
       {
       }
 
@@ -133,6 +134,15 @@ namespace pcl
       void 
       setSecondOrderComputation (bool compute_second_order_integral_images);
 
+      /** \brief Set the number of threads which compute the integral images, each on a band of rows.
+        * \param[in] nr_threads the number of threads, 0 is treated as 1
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        threads_ = (nr_threads == 0) ? 1 : nr_threads;
+      }
+
       /** \brief Set the input data to compute the integral image for
         * \param[in] data the input data
         * \param[in] width the width of the data
@@ -181,6 +191,22 @@ namespace pcl
       void
       computeIntegralImages (const DataType * data, unsigned row_stride, unsigned element_stride);
 
+      /** \brief Compute one row of the integral images from the row above it, or from zero.
+        * \param[in] data the input data of the row
+        * \param[in] element_stride the element stride of the data
+        * \param[in] row the row of the integral images, one more than the row of the data
+        * \param[in] first_row true if the row above is not added, e.g. for the first row of a band
+        */
+      void
+      computeIntegralRow (const DataType * data, unsigned element_stride, unsigned row, bool first_row);
+
+      /** \brief Add a row of the integral images to another one.
+        * \param[in] row the row to add to
+        * \param[in] source_row the row to add
+        */
+      void
+      addIntegralRow (unsigned row, unsigned source_row);
+
       std::vector<ElementType, Eigen::aligned_allocator<ElementType> > first_order_integral_image_;
       std::vector<SecondOrderType, Eigen::aligned_allocator<SecondOrderType> > second_order_integral_image_;
       std::vector<unsigned> finite_values_integral_image_;
@@ -192,6 +218,9 @@ namespace pcl
 
       /** \brief Indicates whether second order integral images are available **/
       bool compute_second_order_integral_images_;
+
+      /** \brief The number of threads computing the integral images. */
+      unsigned int threads_;
    };
 
    /**
@@ -213,7 +242,8 @@ namespace pcl
         second_order_integral_image_ (),
         finite_values_integral_image_ (),
         width_ (1), height_ (1), 
-        compute_second_order_integral_images_ (compute_second_order_integral_images)
+        compute_second_order_integral_images_ (compute_second_order_integral_images),
+        threads_ (1)
       {
       }
 
@@ -221,6 +251,15 @@ namespace pcl
       virtual
       ~IntegralImage2D () { }
 
+      /** \brief Set the number of threads which compute the integral images, each on a band of rows.
+        * \param[in] nr_threads the number of threads, 0 is treated as 1
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        threads_ = (nr_threads == 0) ? 1 : nr_threads;
+      }
+
       /** \brief Set the input data to compute the integral image for
         * \param[in] data the input data
         * \param[in] width the width of the data
@@ -269,6 +308,22 @@ namespace pcl
       void
       computeIntegralImages (const DataType * data, unsigned row_stride, unsigned element_stride);
 
+      /** \brief Compute one row of the integral images from the row above it, or from zero.
+        * \param[in] data the input data of the row
+        * \param[in] element_stride the element stride of the data
+        * \param[in] row the row of the integral images, one more than the row of the data
+        * \param[in] first_row true if the row above is not added, e.g. for the first row of a band
+        */
+      void
+      computeIntegralRow (const DataType * data, unsigned element_stride, unsigned row, bool first_row);
+
+      /** \brief Add a row of the integral images to another one.
+        * \param[in] row the row to add to
+        * \param[in] source_row the row to add
+        */
+      void
+      addIntegralRow (unsigned row, unsigned source_row);
+
       std::vector<ElementType, Eigen::aligned_allocator<ElementType> > first_order_integral_image_;
       std::vector<SecondOrderType, Eigen::aligned_allocator<SecondOrderType> > second_order_integral_image_;
       std::vector<unsigned> finite_values_integral_image_;
@@ -280,6 +335,9 @@ namespace pcl
 
       /** \brief Indicates whether second order integral images are available **/
       bool compute_second_order_integral_images_;
+
+      /** \brief The number of threads computing the integral images. */
+      unsigned int threads_;
    };
  }
 
@@ -42,6 +42,7 @@
 #include <pcl/point_types.h>
 #include <pcl/features/feature.h>
 #include <pcl/features/integral_image2D.h>
+#include <pcl/common/covariance_batch.h>
 
 #if defined BUILD_Maintainer && defined __GNUC__ && __GNUC__ == 4 && __GNUC_MINOR__ > 3
 #pragma GCC diagnostic ignored "-Weffc++"
@@ -82,10 +83,10 @@ namespace pcl
         , integral_image_DY_ (false)
         , integral_image_depth_ (false)
         , integral_image_XYZ_ (true)
-        , diff_x_ (NULL)
-        , diff_y_ (NULL)
-        , depth_data_ (NULL)
-        , distance_map_ (NULL)
+        , diff_x_ ()
+        , diff_y_ ()
+        , depth_change_map_ ()
+        , distance_map_ ()
         , use_depth_dependent_smoothing_ (false)
         , max_depth_change_factor_ (20.0f*0.001f)
         , normal_smoothing_size_ (10.0f)
@@ -97,6 +98,7 @@ namespace pcl
         , vpy_ (0.0f)
         , vpz_ (0.0f)
         , use_sensor_origin_ (true)
+        , threads_ (1)
       {
         feature_name_ = "IntegralImagesNormalEstimation";
         tree_.reset ();
@@ -169,6 +171,20 @@ namespace pcl
         use_depth_dependent_smoothing_ = use_depth_dependent_smoothing;
       }
 
+      /** \brief Set the number of threads which compute the integral images and the normals. The rows of the
+        * image are split between the threads.
+        * \param[in] nr_threads the number of threads, 0 is treated as 1
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        threads_ = (nr_threads == 0) ? 1 : nr_threads;
+        integral_image_DX_.setNumberOfThreads (threads_);
+        integral_image_DY_.setNumberOfThreads (threads_);
+        integral_image_depth_.setNumberOfThreads (threads_);
+        integral_image_XYZ_.setNumberOfThreads (threads_);
+      }
+
        /** \brief Provide a pointer to the input dataset (overwrites the PCLBase::setInputCloud method)
          * \param[in] cloud the const boost shared pointer to a PointCloud message
          */
@@ -200,7 +216,7 @@ namespace pcl
       inline float*
       getDistanceMap ()
       {
-        return (distance_map_);
+        return (distance_map_.empty () ? NULL : &distance_map_[0]);
       }
 
       /** \brief Set the viewpoint.
@@ -297,16 +313,16 @@ namespace pcl
       /** integral image xyz */
       IntegralImage2D<float, 3> integral_image_XYZ_;
 
-      /** derivatives in x-direction */
-      float *diff_x_;
-      /** derivatives in y-direction */
-      float *diff_y_;
+      /** derivatives in x-direction, kept between frames */
+      std::vector<float> diff_x_;
+      /** derivatives in y-direction, kept between frames */
+      std::vector<float> diff_y_;
 
-      /** depth data */
-      float *depth_data_;
+      /** depth change map, 0 at depth discontinuities */
+      std::vector<unsigned char> depth_change_map_;
 
       /** distance map */
-      float *distance_map_;
+      std::vector<float> distance_map_;
 
       /** \brief Smooth data based on depth (true/false). */
       bool use_depth_dependent_smoothing_;
@@ -335,6 +351,9 @@ namespace pcl
 
       /** whether the sensor origin of the input cloud or a user given viewpoint should be used.*/
       bool use_sensor_origin_;
+
+      /** \brief The number of threads computing the integral images and the normals. */
+      unsigned int threads_;
       
       /** \brief This method should get called before starting the actual computation. */
       bool
@@ -356,6 +375,49 @@ namespace pcl
       void
       initSimple3DGradientMethod ();
 
+      /** \brief Initialize the data of the chosen normal estimation method, unless it already is. */
+      void
+      initNormalEstimationMethod ();
+
+      /** \brief Computes the normal at the specified position with a given rectangle size, using the data of the
+        * chosen normal estimation method which must be initialized.
+        * \param[in] pos_x x position (pixel)
+        * \param[in] pos_y y position (pixel)
+        * \param[in] point_index the position index of the point
+        * \param[in] rect_width the width of the search rectangle
+        * \param[in] rect_height the height of the search rectangle
+        * \param[out] normal the output estimated normal
+        */
+      void
+      computePointNormal (const int pos_x, const int pos_y, const unsigned point_index,
+                          const int rect_width, const int rect_height, PointOutT &normal) const;
+
+      /** \brief Compute the covariance matrix of the points within a rectangle, which is not normalized by the
+        * number of points. The sums are centered in double precision and only the result is rounded to float.
+        * \param[in] pos_x x position of the center of the rectangle (pixel)
+        * \param[in] pos_y y position of the center of the rectangle (pixel)
+        * \param[in] rect_width the width of the rectangle
+        * \param[in] rect_height the height of the rectangle
+        * \param[out] covariance_matrix the resultant covariance matrix
+        * \return the number of finite points within the rectangle
+        */
+      unsigned
+      computeCovarianceMatrix (const int pos_x, const int pos_y, const int rect_width, const int rect_height,
+                               Eigen::Matrix3f &covariance_matrix) const;
+
+      /** \brief Check whether there is a depth discontinuity between two neighboring points.
+        * \param[in] index the index of the left or upper point
+        * \param[in] neighbor_index the index of its right or lower neighbor
+        */
+      inline bool
+      isDepthChange (unsigned index, unsigned neighbor_index) const
+      {
+        const float depth = input_->points[index].z;
+        const float neighbor_depth = input_->points[neighbor_index].z;
+        return (fabsf (depth - neighbor_depth) > max_depth_change_factor_ * (fabsf (depth) + 1.0f) * 2.0f
+                || !pcl_isfinite (depth) || !pcl_isfinite (neighbor_depth));
+      }
+
     private:
       /** \brief Make the computeFeature (&Eigen::MatrixXf); inaccessible from outside the class
         * \param[out] output the output point cloud
@@ -41,6 +41,7 @@
 #define PCL_NORMAL_3D_H_
 
 #include <pcl/features/feature.h>
+#include <pcl/common/covariance_batch.h>
 
 namespace pcl
 {
@@ -342,6 +343,20 @@ namespace pcl
       void
       computeFeature (PointCloudOut &output);
 
+      /** \brief Search the neighborhoods of a block of points and estimate their normals together with a batched
+        * eigen solver.
+        * \param[in] begin the position in indices_ of the first point of the block
+        * \param[in] end the position in indices_ after the last point of the block
+        * \param[out] batch the solved covariance matrices of the points with a valid neighborhood
+        * \param[out] batch_indices the positions in indices_ of the points of the matrices in \a batch
+        */
+      void
+      computeNormalBatch (int begin, int end,
+                          pcl::CovarianceMatrixBatch &batch, std::vector<int> &batch_indices) const;
+
+      /** \brief The number of points whose normals are estimated together. */
+      static const int batch_size_ = 256;
+
       /** \brief Values describing the viewpoint ("pinhole" camera model assumed). For per point viewpoints, inherit
         * from NormalEstimation and provide your own computeFeature (). By default, the viewpoint is set to 0,0,0. */
       float vpx_, vpy_, vpz_;
@@ -385,6 +400,8 @@ namespace pcl
       using NormalEstimation<PointInT, pcl::Normal>::vpz_;
       using NormalEstimation<PointInT, pcl::Normal>::computePointNormal;
       using NormalEstimation<PointInT, pcl::Normal>::compute;
+      using NormalEstimation<PointInT, pcl::Normal>::computeNormalBatch;
+      using NormalEstimation<PointInT, pcl::Normal>::batch_size_;
 
     private:
       /** \brief Estimate normals for all points given in <setInputCloud (), setIndices ()> using the surface in
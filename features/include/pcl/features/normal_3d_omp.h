@@ -61,6 +61,8 @@ namespace pcl
       using NormalEstimation<PointInT, PointOutT>::search_parameter_;
       using NormalEstimation<PointInT, PointOutT>::surface_;
       using NormalEstimation<PointInT, PointOutT>::getViewPoint;
+      using NormalEstimation<PointInT, PointOutT>::computeNormalBatch;
+      using NormalEstimation<PointInT, PointOutT>::batch_size_;
 
       typedef typename NormalEstimation<PointInT, PointOutT>::PointCloudOut PointCloudOut;
 
@@ -128,6 +130,8 @@ namespace pcl
       using NormalEstimationOMP<PointInT, pcl::Normal>::getViewPoint;
       using NormalEstimationOMP<PointInT, pcl::Normal>::threads_;
       using NormalEstimationOMP<PointInT, pcl::Normal>::compute;
+      using NormalEstimationOMP<PointInT, pcl::Normal>::computeNormalBatch;
+      using NormalEstimationOMP<PointInT, pcl::Normal>::batch_size_;
 
       /** \brief Default constructor.
         */
@@ -42,7 +42,7 @@
 
 #include <pcl/point_types.h>
 #include <pcl/features/feature.h>
-#include <map>
+#include <vector>
 
 namespace pcl
 {
@@ -67,6 +67,130 @@ namespace pcl
                        const Eigen::Vector4f &p2, const Eigen::Vector4f &n2, 
                        float &f1, float &f2, float &f3, float &f4);
 
+  /** \brief Fixed-capacity cache of the pair features of ordered point pairs, which spares PFHEstimation the
+    * features of the pairs shared by overlapping neighborhoods.
+    *
+    * The cache is an open addressing table allocated once: a pair is stored in one of the few slots after its
+    * hash, and replaces one of them in turn when they are all used. Lookups and insertions thus take constant
+    * time, and the memory does not grow with the number of pairs seen.
+    * \ingroup features
+    */
+  class PairFeatureCache
+  {
+    public:
+      /** \brief Empty constructor. The cache holds no pair until resize () is called. */
+      PairFeatureCache () : keys_ (), features_ (), mask_ (0), victim_ (0) {}
+
+      /** \brief Remove all pairs, and allocate the cache if its capacity changes.
+        * \param[in] capacity the maximum number of pairs, rounded down to a power of two. A capacity smaller than
+        * the number of slots a pair may be stored in (4) disables the cache.
+        */
+      inline void
+      resize (size_t capacity)
+      {
+        if (capacity < static_cast<size_t> (window_size_))
+        {
+          keys_.clear ();
+          features_.clear ();
+          mask_ = 0;
+          return;
+        }
+        size_t size = window_size_;
+        while (size * 2 <= capacity)
+          size *= 2;
+        keys_.assign (size, static_cast<uint64_t> (empty_key_));
+        features_.resize (size);
+        mask_ = size - 1;
+      }
+
+      /** \brief Get the maximum number of pairs. */
+      inline size_t
+      capacity () const { return (keys_.size ()); }
+
+      /** \brief Look up the features of a pair.
+        * \param[in] p_idx the index of the first point (source)
+        * \param[in] q_idx the index of the second point (target)
+        * \param[out] features the features of the pair, if it is in the cache
+        * \return true if the pair is in the cache
+        */
+      inline bool
+      find (int p_idx, int q_idx, Eigen::Vector4f &features) const
+      {
+        if (keys_.empty ())
+          return (false);
+        const uint64_t key = makeKey (p_idx, q_idx);
+        size_t slot = hashKey (key);
+        // Slots are never emptied one by one, so the first empty slot ends the search
+        for (int i = 0; i < window_size_ && keys_[slot] != empty_key_; ++i, slot = (slot + 1) & mask_)
+        {
+          if (keys_[slot] == key)
+          {
+            features = features_[slot];
+            return (true);
+          }
+        }
+        return (false);
+      }
+
+      /** \brief Add the features of a pair which is not in the cache.
+        * \param[in] p_idx the index of the first point (source)
+        * \param[in] q_idx the index of the second point (target)
+        * \param[in] features the features of the pair
+        */
+      inline void
+      insert (int p_idx, int q_idx, const Eigen::Vector4f &features)
+      {
+        if (keys_.empty ())
+          return;
+        const uint64_t key = makeKey (p_idx, q_idx);
+        const size_t first = hashKey (key);
+        size_t slot = (first + (victim_++ & (window_size_ - 1))) & mask_;
+        for (int i = 0; i < window_size_; ++i)
+        {
+          if (keys_[(first + i) & mask_] == empty_key_)
+          {
+            slot = (first + i) & mask_;
+            break;
+          }
+        }
+        keys_[slot] = key;
+        features_[slot] = features;
+      }
+
+    private:
+      /** \brief Pack an ordered pair of point indices into a key. */
+      static inline uint64_t
+      makeKey (int p_idx, int q_idx)
+      {
+        return ((static_cast<uint64_t> (static_cast<uint32_t> (p_idx)) << 32) | static_cast<uint32_t> (q_idx));
+      }
+
+      /** \brief Get the first slot of a key. */
+      inline size_t
+      hashKey (uint64_t key) const
+      {
+        return (static_cast<size_t> ((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask_);
+      }
+
+      /** \brief The number of slots a pair may be stored in. */
+      static const int window_size_ = 4;
+
+      /** \brief The key of the empty slots, which no pair of valid indices has. */
+      static const uint64_t empty_key_ = 0xFFFFFFFFFFFFFFFFULL;
+
+      /** \brief The keys of the pairs in every slot. */
+      std::vector<uint64_t> keys_;
+
+      /** \brief The features of the pairs in every slot. */
+      std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f> > features_;
+
+      /** \brief The number of slots minus one. */
+      size_t mask_;
+
+      /** \brief Rotates the slot replaced when all the slots of a pair are used. */
+      unsigned int victim_;
+  };
+
   /** \brief PFHEstimation estimates the Point Feature Histogram (PFH) descriptor for a given point cloud dataset
     * containing points and normals.
     *
@@ -92,7 +216,7 @@ namespace pcl
     *     NaN data on x, y, or z, will have its PFH feature property set to NaN.
     *
     * \note The code is stateful as we do not expect this class to be multicore parallelized. Please look at
-    * \ref FPFHEstimationOMP for examples on parallel implementations of the FPFH (Fast Point Feature Histogram).
+    * \ref PFHEstimationOMP for a parallel implementation.
     *
     * \author Radu B. Rusu
     * \ingroup features
@@ -119,10 +243,8 @@ namespace pcl
       PFHEstimation () : 
         nr_subdiv_ (5), 
         pfh_histogram_ (),
-        pfh_tuple_ (),
         d_pi_ (1.0f / (2.0f * static_cast<float> (M_PI))), 
-        feature_map_ (),
-        key_list_ (),
+        feature_cache_ (),
         // Default 1GB memory size. Need to set it to something more conservative.
         max_cache_size_ ((1ul*1024ul*1024ul*1024ul) / sizeof (std::pair<std::pair<int, int>, Eigen::Vector4f>)),
         use_cache_ (false)
@@ -130,8 +252,9 @@ namespace pcl
         feature_name_ = "PFHEstimation";
       };
 
-      /** \brief Set the maximum internal cache size. Defaults to 2GB worth of entries.
-        * \param[in] cache_size maximum cache size 
+      /** \brief Set the maximum internal cache size. Defaults to 1GB worth of entries. The cache is allocated
+        * at once with at most the given number of pairs, and at most 2^20 of them.
+        * \param[in] cache_size maximum cache size, in pairs
         */
       inline void
       setMaximumCacheSize (unsigned int cache_size)
@@ -186,7 +309,7 @@ namespace pcl
         */
       bool 
       computePairFeatures (const pcl::PointCloud<PointInT> &cloud, const pcl::PointCloud<PointNT> &normals, 
-                           int p_idx, int q_idx, float &f1, float &f2, float &f3, float &f4);
+                           int p_idx, int q_idx, float &f1, float &f2, float &f3, float &f4) const;
 
       /** \brief Estimate the PFH (Point Feature Histograms) individual signatures of the three angular (f1, f2, f3)
         * features for a given point based on its spatial neighborhood of 3D points with normals
@@ -201,6 +324,29 @@ namespace pcl
                                 const std::vector<int> &indices, int nr_split, Eigen::VectorXf &pfh_histogram);
 
     protected:
+      /** \brief Estimate the PFH signature of a point with a given pair feature cache. The estimator itself is
+        * not modified, so several threads may estimate signatures at once with their own caches.
+        * \param[in] cloud the dataset containing the XYZ Cartesian coordinates of the two points
+        * \param[in] normals the dataset containing the surface normals at each point in \a cloud
+        * \param[in] indices the k-neighborhood point indices in the dataset
+        * \param[in] nr_split the number of subdivisions for each angular feature interval
+        * \param[out] pfh_histogram the resultant (combinatorial) PFH histogram representing the feature at the query point
+        * \param[in,out] cache the cache of the pair features, or NULL to compute all of them
+        */
+      void 
+      computePointPFHSignature (const pcl::PointCloud<PointInT> &cloud, const pcl::PointCloud<PointNT> &normals, 
+                                const std::vector<int> &indices, int nr_split, Eigen::VectorXf &pfh_histogram,
+                                PairFeatureCache *cache) const;
+
+      /** \brief Get the number of pairs of the internal cache, given the maximum cache size.
+        * \param[in] nr_caches the number of caches which share the maximum cache size
+        */
+      inline size_t
+      getCacheCapacity (unsigned int nr_caches = 1) const
+      {
+        return (std::min (static_cast<size_t> (max_cache_size_ / nr_caches), static_cast<size_t> (1) << 20));
+      }
+
       /** \brief Estimate the Point Feature Histograms (PFH) descriptors at a set of points given by
         * <setInputCloud (), setIndices ()> using the surface in setSearchSurface () and the spatial locator in
         * setSearchMethod ()
@@ -215,20 +361,11 @@ namespace pcl
       /** \brief Placeholder for a point's PFH signature. */
       Eigen::VectorXf pfh_histogram_;
 
-      /** \brief Placeholder for a PFH 4-tuple. */
-      Eigen::Vector4f pfh_tuple_;
-
-      /** \brief Placeholder for a histogram index. */
-      int f_index_[3];
-
       /** \brief Float constant = 1.0 / (2.0 * M_PI) */
       float d_pi_; 
 
-      /** \brief Internal hashmap, used to optimize efficiency of redundant computations. */
-      std::map<std::pair<int, int>, Eigen::Vector4f, std::less<std::pair<int, int> >, Eigen::aligned_allocator<Eigen::Vector4f> > feature_map_;
-
-      /** \brief Queue of pairs saved, used to constrain memory usage. */
-      std::queue<std::pair<int, int> > key_list_;
+      /** \brief Internal cache of pair features, used to optimize efficiency of redundant computations. */
+      PairFeatureCache feature_cache_;
 
       /** \brief Maximum size of internal cache memory. */
       unsigned int max_cache_size_;
@@ -266,7 +403,7 @@ namespace pcl
     *     NaN data on x, y, or z, will have its PFH feature property set to NaN.
     *
     * \note The code is stateful as we do not expect this class to be multicore parallelized. Please look at
-    * \ref FPFHEstimationOMP for examples on parallel implementations of the FPFH (Fast Point Feature Histogram).
+    * \ref PFHEstimationOMP for a parallel implementation.
     *
     * \author Radu B. Rusu
     * \ingroup features
@@ -285,8 +422,9 @@ namespace pcl
       using PFHEstimation<PointInT, PointNT, pcl::PFHSignature125>::normals_;
       using PFHEstimation<PointInT, PointNT, pcl::PFHSignature125>::computePointPFHSignature;
       using PFHEstimation<PointInT, PointNT, pcl::PFHSignature125>::compute;
-      using PFHEstimation<PointInT, PointNT, pcl::PFHSignature125>::feature_map_;
-      using PFHEstimation<PointInT, PointNT, pcl::PFHSignature125>::key_list_;
+      using PFHEstimation<PointInT, PointNT, pcl::PFHSignature125>::feature_cache_;
+      using PFHEstimation<PointInT, PointNT, pcl::PFHSignature125>::use_cache_;
+      using PFHEstimation<PointInT, PointNT, pcl::PFHSignature125>::getCacheCapacity;
 
     private:
       /** \brief Estimate the Point Feature Histograms (PFH) descriptors at a set of points given by
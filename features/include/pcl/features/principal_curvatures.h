@@ -43,6 +43,7 @@
 #include <Eigen/StdVector>
 #include <Eigen/Sparse>
 #include <pcl/features/feature.h>
+#include <pcl/common/covariance_batch.h>
 
 namespace pcl
 {
@@ -112,6 +113,31 @@ namespace pcl
       void
       computeFeature (PointCloudOut &output);
 
+      /** \brief Compute the covariance matrix of the point normals of a surface patch, projected in the tangent
+        * plane of the given point normal, into covariance_matrix_.
+        * \param[in] normals the point cloud normals
+        * \param[in] p_idx the query point at which the least-squares plane was estimated
+        * \param[in] indices the point cloud indices that need to be used
+        */
+      void
+      computeProjectedNormalsCovariance (const pcl::PointCloud<PointNT> &normals,
+                                         int p_idx, const std::vector<int> &indices);
+
+      /** \brief Search the neighborhoods of a block of points and decompose the covariance matrices of their
+        * projected normals together with a batched eigen solver.
+        * \param[in] begin the position in indices_ of the first point of the block
+        * \param[in] end the position in indices_ after the last point of the block
+        * \param[out] batch the solved covariance matrices of the points with a valid neighborhood
+        * \param[out] batch_indices the positions in indices_ of the points of the matrices in \a batch
+        * \param[out] batch_sizes the number of neighbors of the points of the matrices in \a batch
+        */
+      void
+      computeCurvatureBatch (int begin, int end, pcl::CovarianceMatrixBatch &batch,
+                             std::vector<int> &batch_indices, std::vector<int> &batch_sizes);
+
+      /** \brief The number of points whose principal curvatures are estimated together. */
+      static const int batch_size_ = 256;
+
     private:
       /** \brief A pointer to the input dataset that contains the point normals of the XYZ dataset. */
       std::vector<Eigen::Vector3f> projected_normals_;
@@ -157,6 +183,8 @@ namespace pcl
       using PrincipalCurvaturesEstimation<PointInT, PointNT, pcl::PrincipalCurvatures>::compute;
       using PrincipalCurvaturesEstimation<PointInT, PointNT, pcl::PrincipalCurvatures>::input_;
       using PrincipalCurvaturesEstimation<PointInT, PointNT, pcl::PrincipalCurvatures>::normals_;
+      using PrincipalCurvaturesEstimation<PointInT, PointNT, pcl::PrincipalCurvatures>::computeCurvatureBatch;
+      using PrincipalCurvaturesEstimation<PointInT, PointNT, pcl::PrincipalCurvatures>::batch_size_;
 
     private:
       /** \brief Estimate the principal curvature (eigenvector of the max eigenvalue), along with both the max (pc1)
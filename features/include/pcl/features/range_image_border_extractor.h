@@ -191,6 +191,12 @@ namespace pcl
       float* surface_change_scores_;
       Eigen::Vector3f* surface_change_directions_;
       
+      // Storage of the elements surface_structure_, shadow_border_informations_ and border_directions_ point to,
+      // kept between range images so that the per-pixel data does not have to be allocated again
+      std::vector<LocalSurface> surface_structure_pool_;
+      std::vector<ShadowBorderIndices> shadow_border_indices_pool_;
+      std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f> > border_directions_pool_;
+      
       
       // =====PROTECTED METHODS=====
       /** \brief Calculate a border score based on how distant the neighbor is, compared to the closest neighbors
@@ -302,9 +308,10 @@ namespace pcl
         * the obstacle)
         * \param x the x-coordinate of the input position
         * \param y the y-coordinate of the input position
+        * \param direction the storage for the direction, which border_directions_ points to if it could be calculated
         */
       inline void
-      calculateBorderDirection (int x, int y);
+      calculateBorderDirection (int x, int y, Eigen::Vector3f& direction);
       
       /** \brief Call \a calculateBorderDirection for every point and average the result over 
         * parameters_.pixel_radius_border_direction
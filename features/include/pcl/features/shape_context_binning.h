@@ -0,0 +1,129 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FEATURES_SHAPE_CONTEXT_BINNING_H_
+#define PCL_FEATURES_SHAPE_CONTEXT_BINNING_H_
+
+#include <pcl/pcl_macros.h>
+#include <pcl/point_cloud.h>
+#include <pcl/search/search.h>
+#include <vector>
+
+namespace pcl
+{
+  /** \brief ShapeContextBinning accumulates the shape context descriptors of ShapeContext3DEstimationOMP and
+    * UniqueShapeContextOMP. The neighbors of a query point are expressed in its local frame and binned against
+    * precomputed tables of the squared radii and of the cosines of the elevation and azimuth boundaries, without
+    * calling acos or atan2 per neighbor.
+    * \ingroup features
+    */
+  class PCL_EXPORTS ShapeContextBinning
+  {
+    public:
+      /** \brief Empty constructor. */
+      ShapeContextBinning () :
+        sqr_radii_ (), cos_theta_ (), cos_phi_ (), nr_upper_phi_ (0), elevation_bins_ (0), radius_bins_ (0)
+      {}
+
+      /** \brief Fill the bin boundary tables.
+        * \param[in] radii_interval the boundaries of the radial bins
+        * \param[in] theta_divisions the boundaries of the elevation bins, in degrees
+        * \param[in] phi_divisions the boundaries of the azimuth bins, in degrees
+        */
+      void
+      computeBinTables (const std::vector<float> &radii_interval, const std::vector<float> &theta_divisions,
+                        const std::vector<float> &phi_divisions);
+
+      /** \brief Count the local point density of every surface point of the neighborhoods once, in parallel.
+        * Points which are not in any neighborhood, or only at the query point itself, keep a weight of 0.
+        * \param[in] tree the search object of the surface
+        * \param[in] surface the search surface
+        * \param[in] radius the radius of the density search
+        * \param[in] nn_indices the neighbors of all the query points
+        * \param[in] nn_dists the squared distances of the neighbors to their query point
+        * \param[in] nr_threads the number of threads to use
+        * \param[out] inv_density the inverse of the local point density of every surface point
+        */
+      template <typename PointT> static void
+      computeInverseDensities (const pcl::search::Search<PointT> &tree, const pcl::PointCloud<PointT> &surface,
+                               double radius, const std::vector<int> &nn_indices, const std::vector<float> &nn_dists,
+                               unsigned int nr_threads, std::vector<float> &inv_density);
+
+      /** \brief Accumulate the descriptor of a query point from its neighborhood.
+        * \param[in] surface the search surface
+        * \param[in] origin the query point
+        * \param[in] frame the X axis, Y axis and normal of the local frame, one per row
+        * \param[in] nn_indices the indices of the neighbors in the surface
+        * \param[in] nn_dists the squared distances of the neighbors to the query point
+        * \param[in] nr_neighbors the number of neighbors
+        * \param[in] inv_density the inverse of the local point density of every surface point, or 0 for the points
+        * which do not contribute
+        * \param[in] volume_lut the volume of every bin
+        * \param[out] desc the descriptor, which must be zero on input
+        */
+      template <typename PointT> void
+      computePointDescriptor (const pcl::PointCloud<PointT> &surface, const Eigen::Vector3f &origin,
+                              const Eigen::Matrix3f &frame, const int *nn_indices, const float *nn_dists,
+                              int nr_neighbors, const std::vector<float> &inv_density,
+                              const std::vector<float> &volume_lut, float *desc) const;
+
+    protected:
+      /** \brief The squared inner boundaries of the radial bins. */
+      std::vector<float> sqr_radii_;
+
+      /** \brief The cosines of the inner boundaries of the elevation bins. */
+      std::vector<float> cos_theta_;
+
+      /** \brief The cosines of the inner boundaries of the azimuth bins. */
+      std::vector<float> cos_phi_;
+
+      /** \brief The number of inner azimuth boundaries which are not above 180 degrees. */
+      int nr_upper_phi_;
+
+      /** \brief The number of elevation bins. */
+      size_t elevation_bins_;
+
+      /** \brief The number of radial bins. */
+      size_t radius_bins_;
+  };
+}
+
+#include <pcl/features/impl/shape_context_binning.hpp>
+
+#endif  //#ifndef PCL_FEATURES_SHAPE_CONTEXT_BINNING_H_
@@ -141,6 +141,15 @@ namespace pcl
                                 const int nr_bins,
                                 Eigen::VectorXf &shot);
 
+      /** \brief Get the local reference frame of a point, as the rotation which expresses the offset of a neighbor
+        * from the point in the frame.
+        * \param[in] index the index of the point in indices_
+        * \param[out] central_point the coordinates of the point
+        * \param[out] rotation the frame axes, one per row
+        */
+      void
+      getLocalFrame (const int index, Eigen::Vector3f &central_point, Eigen::Matrix3f &rotation) const;
+
       /** \brief Normalize the SHOT histogram.
         * \param[in,out] shot the SHOT histogram
         * \param[in] desc_length the length of the histogram
@@ -506,6 +515,39 @@ namespace pcl
       static void
       RGB2CIELAB (unsigned char R, unsigned char G, unsigned char B, float &L, float &A, float &B2);
 
+      /** \brief Convert the colors of all the points of the search surface to normalized CIELab components once,
+        * instead of once per neighborhood they belong to. This also builds the lookup tables of RGB2CIELAB,
+        * which can then be used from several threads.
+        */
+      void
+      computeSurfaceLAB ();
+
+      /** \brief Get the normalized CIELab components of a point of the search surface.
+        * \param[in] index the index of the point in surface_
+        * \param[out] L the normalized lightness, in [0, 1]
+        * \param[out] A the normalized first color-opponent dimension, in [-1, 1]
+        * \param[out] B2 the normalized second color-opponent dimension, in [-1, 1]
+        */
+      inline void
+      getSurfaceLAB (int index, float &L, float &A, float &B2) const
+      {
+        if (surface_lab_.size () == 3 * surface_->points.size ())
+        {
+          L = surface_lab_[3 * index];
+          A = surface_lab_[3 * index + 1];
+          B2 = surface_lab_[3 * index + 2];
+          return;
+        }
+        const uint32_t rgba = surface_->points[index].rgba;
+        RGB2CIELAB ((rgba >> 16) & 0xFF, (rgba >> 8) & 0xFF, rgba & 0xFF, L, A, B2);
+        L /= 100.0f;
+        A /= 120.0f;
+        B2 /= 120.0f;
+      }
+
+      /** \brief The normalized CIELab components of the search surface, 3 per point, while computing. */
+      std::vector<float> surface_lab_;
+
       /** \brief Compute shape descriptor. */
       bool b_describe_shape_;
 
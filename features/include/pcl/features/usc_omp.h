@@ -0,0 +1,131 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FEATURES_USC_OMP_H_
+#define PCL_FEATURES_USC_OMP_H_
+
+#include <pcl/point_types.h>
+#include <pcl/features/usc.h>
+#include <pcl/features/shape_context_binning.h>
+
+namespace pcl
+{
+  /** \brief UniqueShapeContextOMP estimates the Unique Shape Context descriptor of a point cloud in parallel, using
+    * the OpenMP standard. See UniqueShapeContext for the descriptor.
+    *
+    * The local reference frames are estimated, or reused, by initCompute () as in UniqueShapeContext, so they can
+    * be shared with SHOT through setInputReferenceFrames (). The neighborhoods of the query points are searched
+    * once, in parallel, and the local point density of every surface point they contain is counted once. The
+    * neighbors are then binned by ShapeContextBinning, without calling acos or atan2 per neighbor.
+    *
+    * As in SHOTEstimationOMP, the descriptor and the frame of a query point which is not finite, has no neighbors
+    * or has an invalid local reference frame are set to NaN.
+    *
+    * \author Alessandro Franchi, Federico Tombari, Samuele Salti (original code)
+    * \ingroup features
+    */
+  template <typename PointInT, typename PointOutT = pcl::SHOT, typename PointRFT = pcl::ReferenceFrame>
+  class UniqueShapeContextOMP : public UniqueShapeContext<PointInT, PointOutT, PointRFT>
+  {
+    public:
+      using Feature<PointInT, PointOutT>::feature_name_;
+      using Feature<PointInT, PointOutT>::getClassName;
+      using Feature<PointInT, PointOutT>::indices_;
+      using Feature<PointInT, PointOutT>::search_radius_;
+      using Feature<PointInT, PointOutT>::surface_;
+      using Feature<PointInT, PointOutT>::input_;
+      using FeatureWithLocalReferenceFrames<PointInT, PointRFT>::frames_;
+      using UniqueShapeContext<PointInT, PointOutT, PointRFT>::radii_interval_;
+      using UniqueShapeContext<PointInT, PointOutT, PointRFT>::theta_divisions_;
+      using UniqueShapeContext<PointInT, PointOutT, PointRFT>::phi_divisions_;
+      using UniqueShapeContext<PointInT, PointOutT, PointRFT>::volume_lut_;
+      using UniqueShapeContext<PointInT, PointOutT, PointRFT>::azimuth_bins_;
+      using UniqueShapeContext<PointInT, PointOutT, PointRFT>::elevation_bins_;
+      using UniqueShapeContext<PointInT, PointOutT, PointRFT>::radius_bins_;
+      using UniqueShapeContext<PointInT, PointOutT, PointRFT>::point_density_radius_;
+      using UniqueShapeContext<PointInT, PointOutT, PointRFT>::descriptor_length_;
+
+      typedef typename Feature<PointInT, PointOutT>::PointCloudOut PointCloudOut;
+      typedef typename Feature<PointInT, PointOutT>::PointCloudIn PointCloudIn;
+
+      /** \brief Constructor.
+        * \param[in] nr_threads the number of hardware threads to use
+        */
+      UniqueShapeContextOMP (unsigned int nr_threads = 1) :
+        UniqueShapeContext<PointInT, PointOutT, PointRFT> (),
+        threads_ (1), binning_ ()
+      {
+        feature_name_ = "UniqueShapeContextOMP";
+        setNumberOfThreads (nr_threads);
+      }
+
+      /** \brief Set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        if (nr_threads == 0)
+          nr_threads = 1;
+        threads_ = nr_threads;
+      }
+
+    protected:
+      /** \brief Estimate the Unique Shape Context descriptors of all the query points.
+        * \param[out] output the resultant features
+        */
+      virtual void
+      computeFeature (PointCloudOut &output);
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
+      /** \brief Bins the neighbors, with the tables filled from the intervals computed by initCompute (). */
+      ShapeContextBinning binning_;
+
+    private:
+      /** \brief Make the computeFeature (&Eigen::MatrixXf); inaccessible from outside the class
+        * \param[out] output the output point cloud
+        */
+      void
+      computeFeatureEigen (pcl::PointCloud<Eigen::MatrixXf> &) {}
+  };
+}
+
+#endif  //#ifndef PCL_FEATURES_USC_OMP_H_
@@ -374,11 +374,17 @@ void
 Narf::extractForInterestPoints (const RangeImage& range_image, const PointCloud<InterestPoint>& interest_points,
                                 int descriptor_size, float support_size, bool rotation_invariant, std::vector<Narf*>& feature_list)
 {
+  // Every interest point gets its own list, so that the threads do not have to synchronize and the features are
+  // added in the order of the interest points
+  int no_of_interest_points = static_cast<int> (interest_points.points.size ());
+  std::vector<std::vector<Narf*> > features_per_interest_point (no_of_interest_points);
+  
   # pragma omp parallel for num_threads(max_no_of_threads) default(shared) schedule(dynamic, 10)
   //!!! nizar 20110408 : for OpenMP sake on MSVC this must be kept signed
-  for (int interest_point_idx = 0; interest_point_idx < int (interest_points.points.size ()); ++interest_point_idx)
+  for (int interest_point_idx = 0; interest_point_idx < no_of_interest_points; ++interest_point_idx)
   {
     Vector3fMapConst point = interest_points.points[interest_point_idx].getVector3fMap ();
+    std::vector<Narf*>& features = features_per_interest_point[interest_point_idx];
     
     Narf* feature = new Narf;
     if (!feature->extractFromRangeImage(range_image, point, descriptor_size, support_size))
@@ -388,10 +394,7 @@ Narf::extractForInterestPoints (const RangeImage& range_image, const PointCloud<
     else {
       if (!rotation_invariant)
       {
-#       pragma omp critical
-        {
-          feature_list.push_back(feature);
-        }
+        features.push_back(feature);
       }
       else {
         vector<float> rotations, strengths;
@@ -409,16 +412,17 @@ Narf::extractForInterestPoints (const RangeImage& range_image, const PointCloud<
               delete feature2;
               continue;
             }
-#           pragma omp critical
-            {
-              feature_list.push_back(feature2);
-            }
+            features.push_back(feature2);
           }
         }
         delete feature;
       }
     }
   }
+  
+  for (int interest_point_idx = 0; interest_point_idx < no_of_interest_points; ++interest_point_idx)
+    feature_list.insert (feature_list.end (), features_per_interest_point[interest_point_idx].begin (),
+                         features_per_interest_point[interest_point_idx].end ());
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -93,28 +93,21 @@ NarfDescriptor::computeFeature(NarfDescriptor::PointCloudOut& output)
     output.points.clear ();
     return;
   }
-  std::vector<Narf*> feature_list;
-  if (indices_)
-  {
-    for (size_t indices_idx=0; indices_idx<indices_->size(); ++indices_idx)
-    {
-      int point_index = (*indices_)[indices_idx];
-      int y=point_index/range_image_->width, x=point_index - y*range_image_->width;
-      Narf::extractFromRangeImageAndAddToList(*range_image_, static_cast<float> (x), static_cast<float> (y), 36, parameters_.support_size,
-                                              parameters_.rotation_invariant, feature_list);
-    }
-  }
-  else
+  // The features of every point are collected in their own list, so that the points can be split over the threads
+  // (up to Narf::max_no_of_threads) and the features still come out in the order of the points
+  int no_of_points = static_cast<int> (indices_ ? indices_->size () : range_image_->points.size ());
+  std::vector<std::vector<Narf*> > features_per_point (no_of_points);
+# pragma omp parallel for num_threads(Narf::max_no_of_threads) default(shared) schedule(dynamic, 10)
+  for (int point_idx=0; point_idx<no_of_points; ++point_idx)
   {
-    for (unsigned int y=0; y<range_image_->height; ++y)
-    {
-      for (unsigned int x=0; x<range_image_->width; ++x)
-      {
-        Narf::extractFromRangeImageAndAddToList(*range_image_, static_cast<float> (x), static_cast<float> (y), 36, parameters_.support_size,
-                                                parameters_.rotation_invariant, feature_list);
-      }
-    }
+    int point_index = (indices_ ? (*indices_)[point_idx] : point_idx);
+    int y=point_index/range_image_->width, x=point_index - y*range_image_->width;
+    Narf::extractFromRangeImageAndAddToList(*range_image_, static_cast<float> (x), static_cast<float> (y), 36, parameters_.support_size,
+                                            parameters_.rotation_invariant, features_per_point[point_idx]);
   }
+  std::vector<Narf*> feature_list;
+  for (int point_idx=0; point_idx<no_of_points; ++point_idx)
+    feature_list.insert (feature_list.end (), features_per_point[point_idx].begin (), features_per_point[point_idx].end ());
   
   // Copy to NARF36 struct
   output.points.resize(feature_list.size());
@@ -83,19 +83,14 @@ RangeImageBorderExtractor::clearData ()
   delete[] border_scores_top_;     border_scores_top_    = NULL;
   delete[] border_scores_bottom_;  border_scores_bottom_ = NULL;
   //cout << PVARC(range_image_size_during_extraction_)<<PVARN((void*)this);
-  for (int i=0; i<range_image_size_during_extraction_; ++i)
-  {
-    if (surface_structure_!=NULL)
-      delete surface_structure_[i];
-    if (shadow_border_informations_!=NULL)
-      delete shadow_border_informations_[i];
-    if (border_directions_!=NULL)
-      delete border_directions_[i];
-  }
+  // The elements of the pointer arrays live in the pools, which keep their memory for the next range image
   delete[] surface_structure_; surface_structure_ = NULL;
+  surface_structure_pool_.clear ();
   delete border_descriptions_; border_descriptions_ = NULL;
   delete[] shadow_border_informations_; shadow_border_informations_ = NULL;
+  shadow_border_indices_pool_.clear ();
   delete[] border_directions_; border_directions_ = NULL;
+  border_directions_pool_.clear ();
   
   delete[] surface_change_scores_;  surface_change_scores_ = NULL;
   delete[] surface_change_directions_;  surface_change_directions_ = NULL;
@@ -119,31 +114,52 @@ RangeImageBorderExtractor::extractLocalSurfaceStructure ()
   //cout << PVARN(step_size);
   int no_of_nearest_neighbors = static_cast<int> (pow (static_cast<double> (parameters_.pixel_radius_plane_extraction/step_size + 1), 2.0));
   
-# pragma omp parallel for num_threads(parameters_.max_no_of_threads) default(shared) schedule(dynamic, 10)
-  for (int y=0; y<height; ++y)
+  // Every valid point gets a slot in the pool, numbered row by row, so that the threads do not have to allocate
+  std::vector<int> pool_offsets (height+1, 0);
+  
+# pragma omp parallel num_threads(parameters_.max_no_of_threads) default(shared)
   {
-    for (int x=0; x<width; ++x)
+#   pragma omp for schedule(dynamic, 10)
+    for (int y=0; y<height; ++y)
     {
-      int index = y*width + x;
-      LocalSurface*& local_surface = surface_structure_[index];
-      local_surface = NULL;
-      if (!range_image_->isValid(index))
-        continue;
-      local_surface = new LocalSurface;
-      Eigen::Vector3f point;
-      range_image_->getPoint(x, y, point);
-      //cout << PVARN(point);
-      if (!range_image_->getSurfaceInformation(x, y, parameters_.pixel_radius_plane_extraction, point,
-                                  no_of_nearest_neighbors, step_size, local_surface->max_neighbor_distance_squared,
-                                  local_surface->normal_no_jumps, local_surface->neighborhood_mean_no_jumps,
-                                  local_surface->eigen_values_no_jumps,  &local_surface->normal,
-                                  &local_surface->neighborhood_mean, &local_surface->eigen_values))
+      int no_of_valid_points = 0;
+      for (int x=0; x<width; ++x)
+        no_of_valid_points += range_image_->isValid(y*width + x);
+      pool_offsets[y+1] = no_of_valid_points;
+    }
+    
+#   pragma omp single
+    {
+      for (int y=0; y<height; ++y)
+        pool_offsets[y+1] += pool_offsets[y];
+      surface_structure_pool_.resize (pool_offsets[height]);
+    }
+    
+    // Buffer for sorting the neighbors in getSurfaceInformation, one per thread
+    std::vector<RangeImage::NeighborWithDistance> ordered_neighbors;
+    
+#   pragma omp for schedule(dynamic, 10)
+    for (int y=0; y<height; ++y)
+    {
+      int pool_idx = pool_offsets[y];
+      for (int x=0; x<width; ++x)
       {
-        delete local_surface;
+        int index = y*width + x;
+        LocalSurface*& local_surface = surface_structure_[index];
         local_surface = NULL;
+        if (!range_image_->isValid(index))
+          continue;
+        LocalSurface& pooled_surface = surface_structure_pool_[pool_idx++];
+        Eigen::Vector3f point;
+        range_image_->getPoint(x, y, point);
+        if (range_image_->getSurfaceInformation(x, y, parameters_.pixel_radius_plane_extraction, point,
+                                    no_of_nearest_neighbors, step_size, pooled_surface.max_neighbor_distance_squared,
+                                    pooled_surface.normal_no_jumps, pooled_surface.neighborhood_mean_no_jumps,
+                                    pooled_surface.eigen_values_no_jumps,  &pooled_surface.normal,
+                                    &pooled_surface.neighborhood_mean, &pooled_surface.eigen_values,
+                                    ordered_neighbors))
+          local_surface = &pooled_surface;
       }
-      
-      //cout << x<<","<<y<<": ("<<local_surface->normal_no_jumps[0]<<","<<local_surface->normal_no_jumps[1]<<","<<local_surface->normal_no_jumps[2]<<")\n";
     }
   }
 }
@@ -192,11 +208,16 @@ RangeImageBorderExtractor::extractBorderScoreImages ()
 float* 
 RangeImageBorderExtractor::updatedScoresAccordingToNeighborValues (const float* border_scores) const
 {
-  float* new_scores = new float[range_image_->width*range_image_->height];
-  float* new_scores_ptr = new_scores;
-  for (int y=0; y < static_cast<int> (range_image_->height); ++y) 
-    for (int x=0; x < static_cast<int> (range_image_->width); ++x) 
+  int width  = range_image_->width,
+      height = range_image_->height;
+  float* new_scores = new float[width*height];
+# pragma omp parallel for num_threads(parameters_.max_no_of_threads) default(shared) schedule(dynamic, 10)
+  for (int y=0; y < height; ++y) 
+  {
+    float* new_scores_ptr = new_scores + y*width;
+    for (int x=0; x < width; ++x) 
       *(new_scores_ptr++) = updatedScoreAccordingToNeighborValues(x, y, border_scores);
+  }
   return (new_scores);
 }
 
@@ -239,34 +260,77 @@ RangeImageBorderExtractor::findAndEvaluateShadowBorders ()
   int width  = range_image_->width,
       height = range_image_->height;
   shadow_border_informations_ = new ShadowBorderIndices*[width*height];
-  for (int y = 0; y < static_cast<int> (height); ++y) 
+  
+  // A score is changed according to the scores of the opposite direction in the neighboring pixels. Going through the
+  // image row by row, the left (top) scores would see the already changed right (bottom) scores of the pixels before
+  // them, while the right (bottom) scores would see the original left (top) scores of the pixels after them. Changing
+  // the right and bottom scores of all pixels first and then the left and top scores gives the same result with the
+  // rows in any order, so both passes can be split over the threads. The indices found in a row are kept in the order
+  // of the pixels and only copied into the pool once their number is known.
+  typedef std::vector<std::pair<int, ShadowBorderIndices> > RowShadowBorders;
+  std::vector<RowShadowBorders> row_shadow_borders (height);
+  std::vector<int> pool_offsets (height+1, 0);
+  
+# pragma omp parallel num_threads(parameters_.max_no_of_threads) default(shared)
   {
-    for (int x = 0; x < static_cast<int> (width); ++x) 
+#   pragma omp for schedule(dynamic, 10)
+    for (int y = 0; y < height; ++y) 
     {
-      int index = y*width+x;
-      ShadowBorderIndices*& shadow_border_indices = shadow_border_informations_[index];
-      shadow_border_indices = NULL;
-      int shadow_border_idx;
-      
-      if (changeScoreAccordingToShadowBorderValue(x, y, -1, 0, border_scores_left_, border_scores_right_, shadow_border_idx))
+      RowShadowBorders& shadow_borders = row_shadow_borders[y];
+      for (int x = 0; x < width; ++x) 
       {
-        shadow_border_indices = (shadow_border_indices==NULL ? new ShadowBorderIndices : shadow_border_indices);
-        shadow_border_indices->left = shadow_border_idx;
+        ShadowBorderIndices shadow_border_indices;
+        changeScoreAccordingToShadowBorderValue(x, y, 1, 0, border_scores_right_, border_scores_left_,
+                                                shadow_border_indices.right);
+        changeScoreAccordingToShadowBorderValue(x, y, 0, 1, border_scores_bottom_, border_scores_top_,
+                                                shadow_border_indices.bottom);
+        if (shadow_border_indices.right >= 0 || shadow_border_indices.bottom >= 0)
+          shadow_borders.push_back(std::make_pair(y*width+x, shadow_border_indices));
       }
-      if (changeScoreAccordingToShadowBorderValue(x, y, 1, 0, border_scores_right_, border_scores_left_, shadow_border_idx))
-      {
-        shadow_border_indices = (shadow_border_indices==NULL ? new ShadowBorderIndices : shadow_border_indices);
-        shadow_border_indices->right = shadow_border_idx;
-      }
-      if (changeScoreAccordingToShadowBorderValue(x, y, 0, -1, border_scores_top_, border_scores_bottom_, shadow_border_idx))
+    }
+    
+    RowShadowBorders merged_shadow_borders;
+#   pragma omp for schedule(dynamic, 10)
+    for (int y = 0; y < height; ++y) 
+    {
+      RowShadowBorders& shadow_borders = row_shadow_borders[y];
+      merged_shadow_borders.clear();
+      size_t first_pass_idx = 0;
+      for (int x = 0; x < width; ++x) 
       {
-        shadow_border_indices = (shadow_border_indices==NULL ? new ShadowBorderIndices : shadow_border_indices);
-        shadow_border_indices->top = shadow_border_idx;
+        int index = y*width+x;
+        shadow_border_informations_[index] = NULL;
+        ShadowBorderIndices shadow_border_indices;
+        if (first_pass_idx < shadow_borders.size() && shadow_borders[first_pass_idx].first == index)
+          shadow_border_indices = shadow_borders[first_pass_idx++].second;
+        changeScoreAccordingToShadowBorderValue(x, y, -1, 0, border_scores_left_, border_scores_right_,
+                                                shadow_border_indices.left);
+        changeScoreAccordingToShadowBorderValue(x, y, 0, -1, border_scores_top_, border_scores_bottom_,
+                                                shadow_border_indices.top);
+        if (shadow_border_indices.left >= 0 || shadow_border_indices.right >= 0 ||
+            shadow_border_indices.top >= 0 || shadow_border_indices.bottom >= 0)
+          merged_shadow_borders.push_back(std::make_pair(index, shadow_border_indices));
       }
-      if (changeScoreAccordingToShadowBorderValue(x, y, 0, 1, border_scores_bottom_, border_scores_top_, shadow_border_idx))
+      shadow_borders.swap(merged_shadow_borders);
+      pool_offsets[y+1] = static_cast<int> (shadow_borders.size());
+    }
+    
+#   pragma omp single
+    {
+      for (int y = 0; y < height; ++y) 
+        pool_offsets[y+1] += pool_offsets[y];
+      shadow_border_indices_pool_.resize (pool_offsets[height]);
+    }
+    
+#   pragma omp for schedule(dynamic, 10)
+    for (int y = 0; y < height; ++y) 
+    {
+      const RowShadowBorders& shadow_borders = row_shadow_borders[y];
+      for (size_t shadow_border_idx = 0; shadow_border_idx < shadow_borders.size(); ++shadow_border_idx)
       {
-        shadow_border_indices = (shadow_border_indices==NULL ? new ShadowBorderIndices : shadow_border_indices);
-        shadow_border_indices->bottom = shadow_border_idx;
+        ShadowBorderIndices& shadow_border_indices = shadow_border_indices_pool_[pool_offsets[y]+shadow_border_idx];
+        shadow_border_indices = shadow_borders[shadow_border_idx].second;
+        shadow_border_informations_[shadow_borders[shadow_border_idx].first] = &shadow_border_indices;
       }
     }
   }
@@ -283,6 +347,7 @@ RangeImageBorderExtractor::getAnglesImageForBorderDirections ()
       array_size = width*height;
   float* angles_image = new float[array_size];
   
+# pragma omp parallel for num_threads(parameters_.max_no_of_threads) default(shared) schedule(dynamic, 10)
   for (int y=0; y<height; ++y)
   {
     for (int x=0; x<width; ++x)
@@ -320,6 +385,7 @@ RangeImageBorderExtractor::getAnglesImageForSurfaceChangeDirections ()
       array_size = width*height;
   float* angles_image = new float[array_size];
   
+# pragma omp parallel for num_threads(parameters_.max_no_of_threads) default(shared) schedule(dynamic, 10)
   for (int y=0; y<height; ++y)
   {
     for (int x=0; x<width; ++x)
@@ -470,70 +536,74 @@ RangeImageBorderExtractor::calculateBorderDirections ()
       height = range_image_->height,
       size   = width*height;
   border_directions_ = new Eigen::Vector3f*[size];
-  for (int y=0; y<height; ++y)
+  Eigen::Vector3f** average_border_directions = new Eigen::Vector3f*[size];
+  
+  // Only obstacle borders can have a direction, so both passes go through a list of them, with one slot per border
+  // point in the direction buffers
+  std::vector<int> border_indices;
+  for (int index=0; index<size; ++index)
   {
-    for (int x=0; x<width; ++x)
-    {
-      calculateBorderDirection(x, y);
-    }
+    border_directions_[index] = average_border_directions[index] = NULL;
+    if (border_descriptions_->points[index].traits[BORDER_TRAIT__OBSTACLE_BORDER])
+      border_indices.push_back(index);
   }
+  int no_of_border_points = static_cast<int> (border_indices.size());
   
-  Eigen::Vector3f** average_border_directions = new Eigen::Vector3f*[size];
+  std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f> > directions (no_of_border_points);
+# pragma omp parallel for num_threads(parameters_.max_no_of_threads) default(shared) schedule(dynamic, 10)
+  for (int border_idx=0; border_idx<no_of_border_points; ++border_idx)
+  {
+    int index = border_indices[border_idx],
+        y = index/width,
+        x = index - y*width;
+    calculateBorderDirection(x, y, directions[border_idx]);
+  }
+  
+  border_directions_pool_.resize(no_of_border_points);
   int radius = parameters_.pixel_radius_border_direction;
   int minimum_weight = radius+1;
   float min_cos_angle=cosf(deg2rad(120.0f));
-  for (int y=0; y<height; ++y)
+# pragma omp parallel for num_threads(parameters_.max_no_of_threads) default(shared) schedule(dynamic, 10)
+  for (int border_idx=0; border_idx<no_of_border_points; ++border_idx)
   {
-    for (int x=0; x<width; ++x)
+    int index = border_indices[border_idx],
+        y = index/width,
+        x = index - y*width;
+    const Eigen::Vector3f* border_direction = border_directions_[index];
+    if (border_direction==NULL)
+      continue;
+    Eigen::Vector3f& average_border_direction = border_directions_pool_[border_idx];
+    average_border_direction = *border_direction;
+    float weight_sum = 1.0f;
+    for (int y2=(std::max)(0, y-radius); y2<=(std::min)(y+radius, height-1); ++y2)
     {
-      int index = y*width + x;
-      Eigen::Vector3f*& average_border_direction = average_border_directions[index];
-      average_border_direction = NULL;
-      const Eigen::Vector3f* border_direction = border_directions_[index];
-      if (border_direction==NULL)
-        continue;
-      average_border_direction = new Eigen::Vector3f(*border_direction);
-      float weight_sum = 1.0f;
-      for (int y2=(std::max)(0, y-radius); y2<=(std::min)(y+radius, height-1); ++y2)
+      for (int x2=(std::max)(0, x-radius); x2<=(std::min)(x+radius, width-1); ++x2)
       {
-        for (int x2=(std::max)(0, x-radius); x2<=(std::min)(x+radius, width-1); ++x2)
-        {
-          int index2 = y2*width + x2;
-          const Eigen::Vector3f* neighbor_border_direction = border_directions_[index2];
-          if (neighbor_border_direction==NULL || index2==index)
-            continue;
-          
-          // Oposite directions?
-          float cos_angle = neighbor_border_direction->dot(*border_direction);
-          if (cos_angle<min_cos_angle)
-          {
-            //cout << "Reject. "<<PVARC(min_cos_angle)<<PVARC(cos_angle)<<PVARAN(acosf(cos_angle));
-            continue;
-          }
-          //else
-            //cout << "No reject\n";
-          
-          // Border in between?
-          float border_between_points_score = getNeighborDistanceChangeScore(*surface_structure_[index], x, y, x2-x,  y2-y, 1);
-          if (fabsf(border_between_points_score) >= 0.95f*parameters_.minimum_border_probability)
-            continue;
-          
-          *average_border_direction += *neighbor_border_direction;
-          weight_sum += 1.0f;
-        }
-      }
-      if (pcl_lrint (weight_sum) < minimum_weight)
-      {
-        delete average_border_direction;
-        average_border_direction=NULL;
+        int index2 = y2*width + x2;
+        const Eigen::Vector3f* neighbor_border_direction = border_directions_[index2];
+        if (neighbor_border_direction==NULL || index2==index)
+          continue;
+        
+        // Oposite directions?
+        float cos_angle = neighbor_border_direction->dot(*border_direction);
+        if (cos_angle<min_cos_angle)
+          continue;
+        
+        // Border in between?
+        float border_between_points_score = getNeighborDistanceChangeScore(*surface_structure_[index], x, y, x2-x,  y2-y, 1);
+        if (fabsf(border_between_points_score) >= 0.95f*parameters_.minimum_border_probability)
+          continue;
+        
+        average_border_direction += *neighbor_border_direction;
+        weight_sum += 1.0f;
       }
-      else
-        average_border_direction->normalize();
     }
+    if (pcl_lrint (weight_sum) < minimum_weight)
+      continue;
+    average_border_direction.normalize();
+    average_border_directions[index] = &average_border_direction;
   }
   
-  for (int i=0; i<size; ++i)
-    delete border_directions_[i];
   delete[] border_directions_;
   border_directions_ = average_border_directions;
 }
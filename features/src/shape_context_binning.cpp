@@ -0,0 +1,73 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <pcl/features/shape_context_binning.h>
+#include <pcl/common/angles.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::ShapeContextBinning::computeBinTables (const std::vector<float> &radii_interval,
+                                            const std::vector<float> &theta_divisions,
+                                            const std::vector<float> &phi_divisions)
+{
+  radius_bins_ = radii_interval.size () - 1;
+  elevation_bins_ = theta_divisions.size () - 1;
+  const size_t azimuth_bins = phi_divisions.size () - 1;
+
+  // A neighbor is in radial bin j if its distance is above the j inner boundaries below it, and likewise for the
+  // elevation, where a larger angle is a smaller cosine
+  sqr_radii_.resize (radius_bins_ - 1);
+  for (size_t j = 1; j < radius_bins_; ++j)
+    sqr_radii_[j - 1] = radii_interval[j] * radii_interval[j];
+
+  cos_theta_.resize (elevation_bins_ - 1);
+  for (size_t k = 1; k < elevation_bins_; ++k)
+    cos_theta_[k - 1] = cosf (pcl::deg2rad (theta_divisions[k]));
+
+  // The azimuth is told apart from its mirror image by the side of the X axis the neighbor lies on: in the upper
+  // half plane a larger azimuth is a smaller cosine, in the lower half plane a larger cosine
+  cos_phi_.resize (azimuth_bins - 1);
+  nr_upper_phi_ = 0;
+  for (size_t l = 1; l < azimuth_bins; ++l)
+  {
+    cos_phi_[l - 1] = cosf (pcl::deg2rad (phi_divisions[l]));
+    if (phi_divisions[l] <= 180.0f)
+      ++nr_upper_phi_;
+  }
+}
@@ -44,6 +44,13 @@
 namespace pcl
 {
   /** \brief A bilateral filter implementation for point cloud data. Uses the intensity data channel.
+    *
+    * By default, the neighbors of every point are found with a radius search through the search object, and their
+    * Gaussian weights are computed exactly. With setApproximate (true), the weights are read from a lookup table,
+    * and the neighbors are found without the search object: in a window of pixels around every point for organized
+    * clouds, and in a uniform grid of cells the size of the search radius for unorganized ones. The weights are
+    * then within 1e-6 of the exact ones, and since the point itself always has a weight of 1, the intensity of
+    * a point with n neighbors is within n * 1e-6 times the intensity range of its neighbors of the exact one.
     * \note For more information please see 
     * <b>C. Tomasi and R. Manduchi. Bilateral Filtering for Gray and Color Images.
     * In Proceedings of the IEEE International Conference on Computer Vision,
@@ -65,7 +72,13 @@ namespace pcl
         */
       BilateralFilter () : sigma_s_ (0), 
                            sigma_r_ (std::numeric_limits<double>::max ()),
-                           tree_ ()
+                           tree_ (),
+                           approximate_ (false),
+                           window_size_ (5),
+                           threads_ (1),
+                           weight_table_ (),
+                           weight_table_scale_ (0),
+                           weight_table_max_ (0)
       {
       }
 
@@ -126,7 +139,80 @@ namespace pcl
         tree_ = tree;
       }
 
+      /** \brief Set to true if the weights should be read from a lookup table, and the neighbors found in a window
+        * of pixels (organized clouds) or a uniform grid (unorganized clouds) instead of the search object.
+        * \param[in] approximate the new value (true/false)
+        */
+      inline void
+      setApproximate (bool approximate)
+      {
+        approximate_ = approximate;
+      }
+
+      /** \brief Returns true if the weights are read from a lookup table. */
+      inline bool
+      getApproximate () const
+      {
+        return (approximate_);
+      }
+
+      /** \brief Set the half size in pixels of the window searched for neighbors in organized clouds, if
+        * approximating. Neighbors within the search radius but outside the window are ignored.
+        * \param[in] window_size the half size of the window, in pixels
+        */
+      inline void
+      setOrganizedWindowSize (int window_size)
+      {
+        window_size_ = window_size;
+      }
+
+      /** \brief Get the half size in pixels of the window searched for neighbors in organized clouds. */
+      inline int
+      getOrganizedWindowSize () const
+      {
+        return (window_size_);
+      }
+
+      /** \brief Initialize the scheduler and set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        threads_ = (nr_threads == 0) ? 1 : nr_threads;
+      }
+
     private:
+      /** \brief Filter the points of an organized cloud with the neighbors in a window of pixels around them.
+        * \param[out] output the resultant point cloud, a copy of the input
+        */
+      void
+      applyFilterOrganized (PointCloud &output);
+
+      /** \brief Filter the points of an unorganized cloud with the neighbors in a uniform grid of cells.
+        * \param[out] output the resultant point cloud, a copy of the input
+        * \return false if the grid is too large to be indexed, true otherwise
+        */
+      bool
+      applyFilterGrid (PointCloud &output);
+
+      /** \brief Fill the lookup table of the weights. */
+      void
+      initWeightTable ();
+
+      /** \brief Get the product of the Gaussian weights of a neighbor from the lookup table.
+        * \param[in] u the sum of the squared distances of the neighbor, in space and in intensity, each divided
+        * by twice the squared standard deviation of its kernel
+        */
+      inline float
+      lookupWeight (float u) const
+      {
+        if (!(u < weight_table_max_))
+          return (0.0f);
+        const float x = u * weight_table_scale_;
+        const int i = static_cast<int> (x);
+        return (weight_table_[i] + (x - static_cast<float> (i)) * (weight_table_[i + 1] - weight_table_[i]));
+      }
 
       /** \brief The bilateral filter Gaussian distance kernel.
         * \param[in] x the spatial distance (distance or intensity)
@@ -145,6 +231,24 @@ namespace pcl
 
       /** \brief A pointer to the spatial search object. */
       KdTreePtr tree_;
+
+      /** \brief Set to true if the weights are read from a lookup table. */
+      bool approximate_;
+
+      /** \brief The half size in pixels of the window searched for neighbors in organized clouds. */
+      int window_size_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
+      /** \brief The values of exp (-u) for u from 0 to \a weight_table_max_, in steps of 1 / \a weight_table_scale_. */
+      std::vector<float> weight_table_;
+
+      /** \brief The number of entries of the lookup table per unit of u. */
+      float weight_table_scale_;
+
+      /** \brief The value of u above which the weights are zero. */
+      float weight_table_max_;
   };
 }
 
@@ -72,7 +72,26 @@ namespace pcl
         */
       int
       compare (const PointT& p, const double& val);
+
+      /** \brief Compare the data of a block of points to a value.
+        * \param[in] cloud the cloud holding the points
+        * \param[in] indices the indices of the points in the block
+        * \param[in] nr_points the number of points in the block
+        * \param[in] val the value to compare the points to
+        * \param[in] accept the results accepted by the comparison operator: bit 0 for p(data) < val,
+        * bit 1 for p(data) == val and bit 2 for p(data) > val
+        * \param[out] mask set to 1 for the points whose comparison result is accepted, 0 otherwise
+        */
+      void
+      compare (const PointCloud<PointT> &cloud, const int *indices, int nr_points,
+               const double &val, unsigned int accept, unsigned char *mask) const;
+
     protected:
+      /** \brief Compare the data of a block of points, read as type T, to a value. */
+      template <typename T> void
+      compare (const PointCloud<PointT> &cloud, const int *indices, int nr_points,
+               const T val, unsigned int accept, unsigned char *mask) const;
+
       /** \brief The type of data. */
       uint8_t datatype_;
 
@@ -108,6 +127,17 @@ namespace pcl
       virtual bool
       evaluate (const PointT &point) const = 0;
 
+      /** \brief Evaluate the comparison on a block of points. The default
+        * implementation calls evaluate () for every point of the block.
+        * \param[in] cloud the cloud holding the points
+        * \param[in] indices the indices of the points in the block
+        * \param[in] nr_points the number of points in the block
+        * \param[out] mask set to 1 for the points that pass the comparison, 0 otherwise
+        */
+      virtual void
+      evaluateBlock (const PointCloud<PointT> &cloud, const int *indices, int nr_points,
+                     unsigned char *mask) const;
+
     protected:
       /** \brief True if capable. */
       bool capable_;
@@ -171,6 +201,17 @@ namespace pcl
       virtual bool
       evaluate (const PointT &point) const;
 
+      /** \brief Determine the result of this comparison for a block of points.
+        * The field type and the comparison operator are resolved once per block.
+        * \param[in] cloud the cloud holding the points
+        * \param[in] indices the indices of the points in the block
+        * \param[in] nr_points the number of points in the block
+        * \param[out] mask set to 1 for the points that pass the comparison, 0 otherwise
+        */
+      virtual void
+      evaluateBlock (const PointCloud<PointT> &cloud, const int *indices, int nr_points,
+                     unsigned char *mask) const;
+
     protected:
       /** \brief All types (that we care about) can be represented as a double. */
       double compare_val_;
@@ -473,7 +514,21 @@ namespace pcl
       virtual bool
       evaluate (const PointT &point) const = 0;
 
+      /** \brief Determine which points of a block meet this condition. The
+        * default implementation calls evaluate () for every point of the block.
+        * \param[in] cloud the cloud holding the points
+        * \param[in] indices the indices of the points in the block
+        * \param[in] nr_points the number of points in the block
+        * \param[out] mask set to 1 for the points that meet this condition, 0 otherwise
+        */
+      virtual void
+      evaluateBlock (const PointCloud<PointT> &cloud, const int *indices, int nr_points,
+                     unsigned char *mask) const;
+
     protected:
+      /** \brief The number of points evaluated at once by the nested comparisons and conditions. */
+      static const int block_size_ = 256;
+
       /** \brief True if capable. */
       bool capable_;
 
@@ -510,6 +565,18 @@ namespace pcl
         */
       virtual bool
       evaluate (const PointT &point) const;
+
+      /** \brief Determine which points of a block meet this condition.
+        * The masks of the comparisons and nested conditions are combined block
+        * by block, and the remaining ones are skipped once no point is left.
+        * \param[in] cloud the cloud holding the points
+        * \param[in] indices the indices of the points in the block
+        * \param[in] nr_points the number of points in the block
+        * \param[out] mask set to 1 for the points that meet this condition, 0 otherwise
+        */
+      virtual void
+      evaluateBlock (const PointCloud<PointT> &cloud, const int *indices, int nr_points,
+                     unsigned char *mask) const;
   };
 
   //////////////////////////////////////////////////////////////////////////////////////////
@@ -538,6 +605,18 @@ namespace pcl
         */
       virtual bool
       evaluate (const PointT &point) const;
+
+      /** \brief Determine which points of a block meet this condition.
+        * The masks of the comparisons and nested conditions are combined block
+        * by block, and the remaining ones are skipped once all points passed.
+        * \param[in] cloud the cloud holding the points
+        * \param[in] indices the indices of the points in the block
+        * \param[in] nr_points the number of points in the block
+        * \param[out] mask set to 1 for the points that meet this condition, 0 otherwise
+        */
+      virtual void
+      evaluateBlock (const PointCloud<PointT> &cloud, const int *indices, int nr_points,
+                     unsigned char *mask) const;
   };
 
   //////////////////////////////////////////////////////////////////////////////////////////
@@ -598,7 +677,7 @@ namespace pcl
         */
       ConditionalRemoval (int extract_removed_indices = false) :
         Filter<PointT>::Filter (extract_removed_indices), capable_ (false), keep_organized_ (false), condition_ (),
-        user_filter_value_ (std::numeric_limits<float>::quiet_NaN ())
+        user_filter_value_ (std::numeric_limits<float>::quiet_NaN ()), threads_ (1)
       {
         filter_name_ = "ConditionalRemoval";
       }
@@ -610,7 +689,7 @@ namespace pcl
         */
       ConditionalRemoval (ConditionBasePtr condition, bool extract_removed_indices = false) :
         Filter<PointT>::Filter (extract_removed_indices), capable_ (false), keep_organized_ (false), condition_ (),
-        user_filter_value_ (std::numeric_limits<float>::quiet_NaN ())
+        user_filter_value_ (std::numeric_limits<float>::quiet_NaN ()), threads_ (1)
       {
         filter_name_ = "ConditionalRemoval";
         setCondition (condition);
@@ -656,6 +735,17 @@ namespace pcl
       void
       setCondition (ConditionBasePtr condition);
 
+      /** \brief Initialize the scheduler and set the number of threads to use.
+        * The condition is evaluated in parallel over blocks of points, so all
+        * its comparisons must be safe to evaluate concurrently.
+        * \param[in] nr_threads the number of hardware threads to use
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        threads_ = (nr_threads == 0) ? 1 : nr_threads;
+      }
+
     protected:
       /** \brief Filter a Point Cloud.
         * \param output the resultant point cloud message
@@ -680,6 +770,9 @@ namespace pcl
         * the correct field type. 
         */
       float user_filter_value_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
   };
 }
 
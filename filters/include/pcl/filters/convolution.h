@@ -45,11 +45,68 @@
 #include <pcl/point_cloud.h>
 #include <pcl/exceptions.h>
 #include <pcl/pcl_base.h>
+#include <pcl/point_types.h>
 
 namespace pcl
 {
   namespace filters
   {
+    /** \brief The float channels of a point type which Convolution can convolve on separate channel planes: the
+      * same fields its point operators convolve, starting with x, y and z. Point types without a specialization
+      * are convolved point by point.
+      * \ingroup filters
+      */
+    template <typename PointT>
+    struct ConvolutionChannels
+    {
+      /// The number of channels, 0 if the point type has no channel planes
+      static const int size = 0;
+      /// Copy the channels of a point to an array
+      static inline void
+      get (const PointT&, float*) {}
+      /// Copy an array to the channels of a point
+      static inline void
+      set (const float*, PointT&) {}
+    };
+
+    template <>
+    struct ConvolutionChannels<pcl::PointXYZ>
+    {
+      static const int size = 3;
+      static inline void
+      get (const pcl::PointXYZ& p, float* c) { c[0] = p.x; c[1] = p.y; c[2] = p.z; }
+      static inline void
+      set (const float* c, pcl::PointXYZ& p) { p.x = c[0]; p.y = c[1]; p.z = c[2]; }
+    };
+
+    template <>
+    struct ConvolutionChannels<pcl::PointXYZI>
+    {
+      static const int size = 4;
+      static inline void
+      get (const pcl::PointXYZI& p, float* c) { c[0] = p.x; c[1] = p.y; c[2] = p.z; c[3] = p.intensity; }
+      static inline void
+      set (const float* c, pcl::PointXYZI& p) { p.x = c[0]; p.y = c[1]; p.z = c[2]; p.intensity = c[3]; }
+    };
+
+    template <>
+    struct ConvolutionChannels<pcl::PointXYZINormal>
+    {
+      static const int size = 8;
+      static inline void
+      get (const pcl::PointXYZINormal& p, float* c)
+      {
+        c[0] = p.x; c[1] = p.y; c[2] = p.z; c[3] = p.intensity;
+        c[4] = p.normal_x; c[5] = p.normal_y; c[6] = p.normal_z; c[7] = p.curvature;
+      }
+      static inline void
+      set (const float* c, pcl::PointXYZINormal& p)
+      {
+        p.x = c[0]; p.y = c[1]; p.z = c[2]; p.intensity = c[3];
+        p.normal_x = c[4]; p.normal_y = c[5]; p.normal_z = c[6]; p.curvature = c[7];
+      }
+    };
+
     /** Convolution is a mathematical operation on two functions f and g,
       * producing a third function that is typically viewed as a modified
       * version of one of the original functions.
@@ -122,6 +179,17 @@ namespace pcl
         /// \return the distance threshold
         inline const float &
         getDistanceThreshold () const { return (distance_threshold_); }
+        /** \brief Set to false to convolve point by point even if the point type has channel planes.
+          * Point types with a ConvolutionChannels specialization are by default converted to one plane of floats
+          * per channel, and convolved with SSE in bands of rows, without a temporary cloud for separate
+          * convolution. The output is the same.
+          * \param[in] use_channel_planes the new value (true/false)
+          */
+        inline void
+        setUseChannelPlanes (bool use_channel_planes) { use_channel_planes_ = use_channel_planes; }
+        /// \return true if point types with channel planes are convolved on them
+        inline bool
+        getUseChannelPlanes () const { return (use_channel_planes_); }
         /** \brief Initialize the scheduler and set the number of threads to use.
           * \param nr_threads the number of hardware threads to use (-1 sets the value back to automatic)
           */
@@ -186,6 +254,45 @@ namespace pcl
           */
         void
         initCompute (PointCloudOut& output);
+        /** \return true if the channel planes of the point type are used for convolving with kernels of the
+          * given sizes
+          */
+        inline bool
+        useChannelPlanes (int h_kernel_size, int v_kernel_size) const
+        {
+          return (use_channel_planes_ &&
+                  ConvolutionChannels<PointIn>::size > 0 &&
+                  ConvolutionChannels<PointIn>::size == ConvolutionChannels<PointOut>::size &&
+                  static_cast<int> (input_->width) >= h_kernel_size &&
+                  static_cast<int> (input_->height) >= v_kernel_size);
+        }
+        /** \brief Convolve the rows and/or the columns of the input on channel planes, in bands of rows.
+          * \param[in] h_kernel kernel for convolving rows
+          * \param[in] v_kernel kernel for convolving columns
+          * \param[in] convolve_rows true if the rows are convolved
+          * \param[in] convolve_cols true if the columns are convolved (after the rows)
+          * \param[out] output the convolved cloud
+          */
+        void
+        convolvePlanes (const Eigen::ArrayXf& h_kernel, const Eigen::ArrayXf& v_kernel,
+                        bool convolve_rows, bool convolve_cols, PointCloudOut& output);
+        /** \brief Convolve consecutive elements of all channel planes.
+          * \param[in] src the first value read for the first element, in the first plane
+          * \param[in] src_plane_size the distance between the planes of \a src
+          * \param[in] step the distance between the values read for an element (1 for rows, the width for columns)
+          * \param[in] reversed_kernel the kernel, last value first
+          * \param[in] kernel_size the size of the kernel
+          * \param[in] defaults the channels of a default constructed output point, the values sums start from
+          * \param[in] dense true if all neighbors are summed, false if only the finite ones within the distance
+          * threshold are, normalized by the sum of their weights
+          * \param[in] nr_elements the number of elements
+          * \param[out] dst the first element, in the first plane
+          * \param[in] dst_plane_size the distance between the planes of \a dst
+          */
+        void
+        convolveSpan (const float* src, size_t src_plane_size, int step,
+                      const float* reversed_kernel, int kernel_size, const float* defaults, bool dense,
+                      int nr_elements, float* dst, size_t dst_plane_size) const;
       private:
         /** \return the result of convolution of point at (\ai, \aj)
           * \note no test on finity is performed
@@ -220,6 +327,10 @@ namespace pcl
         int half_width_;
         /// kernel size - 1
         int kernel_width_;
+        /// Squared threshold distance between adjacent points
+        float squared_distance_threshold_;
+        /// Set to true if point types with channel planes are convolved on them
+        bool use_channel_planes_;
       protected:
         /** \brief The number of threads the scheduler should use. */
         int threads_;
@@ -66,7 +66,8 @@ namespace pcl
         hull_polygons_(),
         hull_cloud_(),
         dim_(3),
-        crop_outside_(true)
+        crop_outside_(true),
+        threads_(1)
       {
         filter_name_ = "CropHull";
       }
@@ -127,6 +128,15 @@ namespace pcl
         crop_outside_ = crop_outside;
       }
 
+      /** \brief Initialize the scheduler and set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        threads_ = (nr_threads == 0) ? 1 : nr_threads;
+      }
+
     protected:
       /** \brief Filter the input points using the 2D or 3D polygon hull.
         * \param[out] output The set of points that passed the filter
@@ -148,57 +158,104 @@ namespace pcl
       Eigen::Vector3f
       getHullCloudRange ();
       
-      /** \brief Apply the two-dimensional hull filter.
-        * All points are assumed to lie in the same plane as the 2D hull, an
-        * axis-aligned 2D coordinate system using the two dimensions specified
-        * (PlaneDim1, PlaneDim2) is used for calculations.
-        * \param[out] output The set of points that pass the 2D polygon filter.
+      /** \brief Polygon edges of a 2D hull, bucketed into slabs along PlaneDim1.
+        * A point can only toggle the crossing parity of the edges whose
+        * PlaneDim1 range contains it, so only the slab of the point is tested.
+        * Inside a slab the edges are grouped by polygon.
         */
-      template<unsigned PlaneDim1, unsigned PlaneDim2> void
-      applyFilter2D (PointCloud &output); 
+      struct EdgeSlabs
+      {
+        /** \brief An edge with its end points sorted along PlaneDim1, i.e. x1 < x2. */
+        struct Edge
+        {
+          double x1, y1, x2, y2;
+          int polygon;
+        };
+
+        /** \brief Return the slab holding the given PlaneDim1 coordinate,
+          * clamped to the valid range.
+          */
+        inline int
+        getSlab (double x) const
+        {
+          const double t = (x - min_x) * inv_width;
+          if (!(t > 0))
+            return (0);
+          if (t >= static_cast<double> (nr_slabs))
+            return (nr_slabs - 1);
+          return (static_cast<int> (t));
+        }
 
-      /** \brief Apply the two-dimensional hull filter.
+        double min_x, inv_width;
+        int nr_slabs;
+        std::vector<int> slab_begin;
+        std::vector<Edge> edges;
+      };
+
+      /** \brief Hull triangles projected onto the plane orthogonal to a test
+        * ray and bucketed into a uniform grid. A ray cast from a point can
+        * only cross the triangles stored in the cell the point projects to.
+        */
+      struct RayGrid
+      {
+        /** \brief Return the grid cell of the given plane coordinate, clamped to the valid range. */
+        inline static int
+        getCell (float x, float min_x, float inv_cell, int size)
+        {
+          const float t = (x - min_x) * inv_cell;
+          if (!(t > 0))
+            return (0);
+          if (t >= static_cast<float> (size))
+            return (size - 1);
+          return (static_cast<int> (t));
+        }
+
+        Eigen::Vector3f ray, axis_u, axis_v;
+        float min_u, max_u, min_v, max_v, inv_cell_u, inv_cell_v;
+        int size_u, size_v;
+        std::vector<int> cell_begin;
+        std::vector<int> polygons;
+      };
+
+      /** \brief Decide for every input index whether it lies inside the hull.
+        * \param[out] inside one flag per input index
+        */
+      void
+      computeInside (std::vector<char> &inside);
+
+      /** \brief Test the input points against the two-dimensional hull.
         * All points are assumed to lie in the same plane as the 2D hull, an
         * axis-aligned 2D coordinate system using the two dimensions specified
-        * (PlaneDim1, PlaneDim2) is used for calculations.
-        * \param[out] indices The indices of the set of points that pass the
-        *                     2D polygon filter.
+        * (PlaneDim1, PlaneDim2) is used for calculations. A point is inside
+        * when it lies inside any of the hull polygons.
+        * \param[out] inside one flag per input index
         */
       template<unsigned PlaneDim1, unsigned PlaneDim2> void
-      applyFilter2D (std::vector<int> &indices);
-
-       /** \brief Apply the three-dimensional hull filter.
-         * Polygon-ray crossings are used for three rays cast from each point
-         * being tested, and a  majority vote of the resulting
-         * polygon-crossings is used to decide  whether the point lies inside
-         * or outside the hull.
-         * \param[out] output The set of points that pass the 3D polygon hull
-         *                    filter.
-         */
-      void
-      applyFilter3D (PointCloud &output);
+      computeInside2D (std::vector<char> &inside);
 
-      /** \brief Apply the three-dimensional hull filter.
-        *  Polygon-ray crossings are used for three rays cast from each point
-        *  being tested, and a  majority vote of the resulting
-        *  polygon-crossings is used to decide  whether the point lies inside
-        *  or outside the hull.
-        * \param[out] indices The indices of the set of points that pass the 3D
-        *                     polygon hull filter.
+      /** \brief Test the input points against the three-dimensional hull.
+        * Polygon-ray crossings are used for three rays cast from each point
+        * being tested, and a majority vote of the resulting
+        * polygon-crossings is used to decide whether the point lies inside
+        * or outside the hull. Only the triangles found in a RayGrid are
+        * tested for every ray.
+        * \param[out] inside one flag per input index
         */
       void
-      applyFilter3D (std::vector<int> &indices);
+      computeInside3D (std::vector<char> &inside);
 
-      /** \brief Test an individual point against a 2D polygon.
-        * PlaneDim1 and PlaneDim2 specify the x/y/z coordinate axes to use.
-        * \param[in] point Point to test against the polygon.
-        * \param[in] verts Vertex indices of polygon.
-        * \param[in] cloud Cloud from which the vertex indices are drawn.
+      /** \brief Build the edge slabs of the 2D hull polygons.
+        * \param[out] slabs the resultant edge slabs
+        */
+      template<unsigned PlaneDim1, unsigned PlaneDim2> void
+      buildEdgeSlabs (EdgeSlabs &slabs) const;
+
+      /** \brief Build the uniform grid of the hull triangles projected along a ray.
+        * \param[in] ray the direction of the ray
+        * \param[out] grid the resultant grid
         */
-      template<unsigned PlaneDim1, unsigned PlaneDim2> inline static bool
-      isPointIn2DPolyWithVertIndices (const PointT& point,
-                                      const Vertices& verts,
-                                      const PointCloud& cloud);
+      void
+      buildRayGrid (const Eigen::Vector3f &ray, RayGrid &grid) const;
 
       /** \brief Does a ray cast from a point intersect with an arbitrary
         * triangle in 3D?
@@ -228,6 +285,9 @@ namespace pcl
        * false, those inside will be removed.
        */
       bool crop_outside_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
   };
 
 } // namespace pcl
@@ -0,0 +1,201 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FILTERS_FILTER_PIPELINE_H_
+#define PCL_FILTERS_FILTER_PIPELINE_H_
+
+#include <pcl/filters/filter.h>
+#include <pcl/filters/passthrough.h>
+#include <pcl/filters/crop_box.h>
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/filters/conditional_removal.h>
+
+namespace pcl
+{
+  /** \brief FilterPipeline runs a chain of filters on a sensor_msgs::PointCloud2 blob in a single pass.
+    *
+    * The pipeline holds a list of predicate filters (PassThrough, CropBox and field comparisons as in
+    * ConditionalRemoval), which all have to keep a point for it to pass, and an optional VoxelGrid reducer for
+    * the points that pass. Instead of running the filters one after the other, each of them allocating a new
+    * blob and walking all its points, every input point is tested against all predicates at once, and is then
+    * either copied to the output or accumulated into its voxel. The output blob is allocated once.
+    *
+    * The parameters of the PassThrough, CropBox and VoxelGrid objects are read when filtering, so they may be
+    * changed after adding them to the pipeline; their input clouds are not used. The output is the same as the
+    * one of the chained filters, up to the rounding of the voxel centroids, which are summed in another order.
+    *
+    * Example:
+    * \code
+    * pcl::FilterPipeline::PassThroughPtr range (new pcl::PassThrough<sensor_msgs::PointCloud2>);
+    * range->setFilterFieldName ("z");
+    * range->setFilterLimits (0.0, 30.0);
+    * pcl::FilterPipeline::VoxelGridPtr grid (new pcl::VoxelGrid<sensor_msgs::PointCloud2>);
+    * grid->setLeafSize (0.1f, 0.1f, 0.1f);
+    *
+    * pcl::FilterPipeline pipeline;
+    * pipeline.addPassThrough (range);
+    * pipeline.addFieldComparison ("intensity", pcl::ComparisonOps::GT, 10.0);
+    * pipeline.setVoxelGrid (grid);
+    * pipeline.setInputCloud (cloud_blob);
+    * pipeline.filter (output_blob);
+    * \endcode
+    * \ingroup filters
+    */
+  class PCL_EXPORTS FilterPipeline : public Filter<sensor_msgs::PointCloud2>
+  {
+    using Filter<sensor_msgs::PointCloud2>::filter_name_;
+    using Filter<sensor_msgs::PointCloud2>::getClassName;
+
+    typedef sensor_msgs::PointCloud2 PointCloud2;
+
+    public:
+      typedef boost::shared_ptr<PassThrough<sensor_msgs::PointCloud2> > PassThroughPtr;
+      typedef boost::shared_ptr<CropBox<sensor_msgs::PointCloud2> > CropBoxPtr;
+      typedef boost::shared_ptr<VoxelGrid<sensor_msgs::PointCloud2> > VoxelGridPtr;
+
+      /** \brief Empty constructor. */
+      FilterPipeline () : predicate_filters_ (), voxel_grid_ (), threads_ (1)
+      {
+        filter_name_ = "FilterPipeline";
+      }
+
+      /** \brief Add a PassThrough predicate. Its organized mode is not supported, points are always removed.
+        * \param[in] pass_through the PassThrough filter whose parameters are used
+        */
+      inline void
+      addPassThrough (const PassThroughPtr &pass_through)
+      {
+        PredicateFilter predicate;
+        predicate.pass_through = pass_through;
+        predicate_filters_.push_back (predicate);
+      }
+
+      /** \brief Add a CropBox predicate.
+        * \param[in] crop_box the CropBox filter whose parameters are used
+        */
+      inline void
+      addCropBox (const CropBoxPtr &crop_box)
+      {
+        PredicateFilter predicate;
+        predicate.crop_box = crop_box;
+        predicate_filters_.push_back (predicate);
+      }
+
+      /** \brief Add a field comparison predicate, with the semantics of pcl::FieldComparison.
+        * \param[in] field_name the name of the field that contains the data we want to compare
+        * \param[in] op the operator to use when making the comparison
+        * \param[in] compare_val the constant value to compare the field value to
+        */
+      inline void
+      addFieldComparison (const std::string &field_name, ComparisonOps::CompareOp op, double compare_val)
+      {
+        PredicateFilter predicate;
+        predicate.field_name = field_name;
+        predicate.op = op;
+        predicate.compare_val = compare_val;
+        predicate_filters_.push_back (predicate);
+      }
+
+      /** \brief Remove all predicates. */
+      inline void
+      clearPredicates ()
+      {
+        predicate_filters_.clear ();
+      }
+
+      /** \brief Set the VoxelGrid that downsamples the points which pass the predicates. Its leaf size, filter
+        * limits and downsampling of all fields are used; the leaf layout is not saved.
+        * \param[in] voxel_grid the VoxelGrid filter whose parameters are used, or an empty pointer to copy the
+        * points which pass instead
+        */
+      inline void
+      setVoxelGrid (const VoxelGridPtr &voxel_grid)
+      {
+        voxel_grid_ = voxel_grid;
+      }
+
+      /** \brief Get the VoxelGrid reducer of the pipeline, if any. */
+      inline VoxelGridPtr
+      getVoxelGrid () const
+      {
+        return (voxel_grid_);
+      }
+
+      /** \brief Initialize the scheduler and set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        threads_ = (nr_threads == 0) ? 1 : nr_threads;
+      }
+
+    protected:
+      /** \brief Filter the input blob with all predicates and the reducer in a single pass.
+        * \param[out] output the resultant point cloud message
+        */
+      void
+      applyFilter (PointCloud2 &output);
+
+    private:
+      /** \brief A predicate filter added to the pipeline: the filter it comes from, or a field comparison. */
+      struct PredicateFilter
+      {
+        PredicateFilter () : pass_through (), crop_box (), field_name (), op (ComparisonOps::EQ), compare_val (0) {}
+
+        PassThroughPtr pass_through;
+        CropBoxPtr crop_box;
+        std::string field_name;
+        ComparisonOps::CompareOp op;
+        double compare_val;
+      };
+
+      /** \brief A predicate resolved against the fields of the input blob, defined in the implementation. */
+      struct Predicate;
+
+      /** \brief The predicate filters, in the order they were added. */
+      std::vector<PredicateFilter> predicate_filters_;
+
+      /** \brief The reducer applied to the points which pass. */
+      VoxelGridPtr voxel_grid_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+  };
+}
+
+#endif  // PCL_FILTERS_FILTER_PIPELINE_H_
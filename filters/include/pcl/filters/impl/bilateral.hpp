@@ -39,6 +39,9 @@
 #define PCL_FILTERS_BILATERAL_IMPL_H_
 
 #include <pcl/filters/bilateral.h>
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/common/common.h>
+#include <algorithm>
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> double
@@ -76,6 +79,20 @@ pcl::BilateralFilter<PointT>::applyFilter (PointCloud &output)
     PCL_ERROR ("[pcl::BilateralFilter::applyFilter] Need a sigma_s value given before continuing.\n");
     return;
   }
+
+  if (approximate_)
+  {
+    initWeightTable ();
+    if (input_->isOrganized ())
+    {
+      applyFilterOrganized (output);
+      return;
+    }
+    if (applyFilterGrid (output))
+      return;
+    PCL_WARN ("[pcl::BilateralFilter::applyFilter] The search radius is too small for the extents of the cloud, using the search object.\n");
+  }
+
   // In case a search method has not been given, initialize it using some defaults
   if (!tree_)
   {
@@ -88,21 +105,209 @@ pcl::BilateralFilter<PointT>::applyFilter (PointCloud &output)
   }
   tree_->setInputCloud (input_);
 
-  std::vector<int> k_indices;
-  std::vector<float> k_distances;
+  // Copy the input data into the output
+  output = *input_;
+
+  const int nr_points = static_cast<int> (indices_->size ());
+#pragma omp parallel num_threads (threads_)
+  {
+    std::vector<int> k_indices;
+    std::vector<float> k_distances;
+
+    // For all the indices given (equal to the entire cloud if none given)
+#pragma omp for schedule (dynamic, 256)
+    for (int i = 0; i < nr_points; ++i)
+    {
+      // Perform a radius search to find the nearest neighbors
+      tree_->radiusSearch ((*indices_)[i], sigma_s_ * 2, k_indices, k_distances);
+
+      // Overwrite the intensity value with the computed average
+      output.points[(*indices_)[i]].intensity = static_cast<float> (computePointWeight ((*indices_)[i], k_indices, k_distances));
+    }
+  }
+}
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::BilateralFilter<PointT>::initWeightTable ()
+{
+  // Linear interpolation in steps of 1/512 is within 5e-7 of exp (-u), and exp (-16) is 1.1e-7
+  const int nr_entries = 8192;
+  weight_table_max_ = 16.0f;
+  weight_table_scale_ = static_cast<float> (nr_entries) / weight_table_max_;
+  // one extra entry for interpolating the last step, and one for u rounding up to weight_table_max_
+  weight_table_.resize (nr_entries + 2);
+  for (int i = 0; i < nr_entries + 2; ++i)
+    weight_table_[i] = static_cast<float> (exp (-static_cast<double> (i) / weight_table_scale_));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::BilateralFilter<PointT>::applyFilterOrganized (PointCloud &output)
+{
   // Copy the input data into the output
   output = *input_;
 
-  // For all the indices given (equal to the entire cloud if none given)
+  const float radius_sqr = static_cast<float> (4 * sigma_s_ * sigma_s_);
+  const float inv_spatial = static_cast<float> (1.0 / (2 * sigma_s_ * sigma_s_));
+  const float inv_range = static_cast<float> (1.0 / (2 * sigma_r_ * sigma_r_));
+  const int width = static_cast<int> (input_->width);
+  const int height = static_cast<int> (input_->height);
+  const int nr_points = static_cast<int> (indices_->size ());
+
+#pragma omp parallel for num_threads (threads_) schedule (dynamic, 256)
+  for (int i = 0; i < nr_points; ++i)
+  {
+    const int pid = (*indices_)[i];
+    const PointT &point = input_->points[pid];
+    if (!isFinite (point))
+      continue;
+
+    const int row = pid / width;
+    const int col = pid % width;
+    const int row_begin = std::max (0, row - window_size_), row_end = std::min (height, row + window_size_ + 1);
+    const int col_begin = std::max (0, col - window_size_), col_end = std::min (width, col + window_size_ + 1);
+
+    double BF = 0, W = 0;
+    for (int r = row_begin; r < row_end; ++r)
+    {
+      for (int c = col_begin; c < col_end; ++c)
+      {
+        const PointT &neighbor = input_->points[r * width + c];
+        const float dx = neighbor.x - point.x, dy = neighbor.y - point.y, dz = neighbor.z - point.z;
+        const float dist_sqr = dx * dx + dy * dy + dz * dz;
+        // also skips the invalid neighbors
+        if (!(dist_sqr <= radius_sqr))
+          continue;
+        const float intensity_dist = neighbor.intensity - point.intensity;
+        const float weight = lookupWeight (dist_sqr * inv_spatial + intensity_dist * intensity_dist * inv_range);
+        BF += weight * neighbor.intensity;
+        W += weight;
+      }
+    }
+    output.points[pid].intensity = static_cast<float> (BF / W);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::BilateralFilter<PointT>::applyFilterGrid (PointCloud &output)
+{
+  // Cells the size of the search radius: all the neighbors of a point are in the 27 cells around it
+  const double radius = 2 * sigma_s_;
+  const double inv_cell = 1.0 / radius;
+  Eigen::Vector4f min_p, max_p;
+  pcl::getMinMax3D (*input_, min_p, max_p);
+  // No valid point: nothing to filter
+  if (!(min_p[0] <= max_p[0]))
+  {
+    output = *input_;
+    return (true);
+  }
+  // The grid is padded by an empty cell on every side, so the cells around a point never wrap around to the other
+  // end of a row or layer, even in clouds less than 3 cells wide
+  const double dx = floor ((static_cast<double> (max_p[0]) - min_p[0]) * inv_cell) + 3;
+  const double dy = floor ((static_cast<double> (max_p[1]) - min_p[1]) * inv_cell) + 3;
+  const double dz = floor ((static_cast<double> (max_p[2]) - min_p[2]) * inv_cell) + 3;
+  if (!(dx * dy * dz < static_cast<double> (1ULL << 62)))
+    return (false);
+  const int64_t div_x = static_cast<int64_t> (dx);
+  const int64_t div_xy = div_x * static_cast<int64_t> (dy);
+
+  // Sort all the points of the input by cell; the invalid ones can't be neighbors
+  const int nr_input = static_cast<int> (input_->points.size ());
+  std::vector<uint64_t> keys (nr_input), layer_keys;
+  std::vector<int> sorted (nr_input), cell_begin;
+#pragma omp parallel for num_threads (threads_) schedule (static)
+  for (int cp = 0; cp < nr_input; ++cp)
+  {
+    const PointT &point = input_->points[cp];
+    sorted[cp] = cp;
+    if (!isFinite (point))
+    {
+      keys[cp] = std::numeric_limits<uint64_t>::max ();
+      continue;
+    }
+    const int64_t ix = static_cast<int64_t> ((static_cast<double> (point.x) - min_p[0]) * inv_cell) + 1;
+    const int64_t iy = static_cast<int64_t> ((static_cast<double> (point.y) - min_p[1]) * inv_cell) + 1;
+    const int64_t iz = static_cast<int64_t> ((static_cast<double> (point.z) - min_p[2]) * inv_cell) + 1;
+    keys[cp] = static_cast<uint64_t> (iz * div_xy + iy * div_x + ix);
+  }
+  pcl::sortVoxelGridKeys (keys, layer_keys, sorted, cell_begin, threads_);
+  const int nr_cells = static_cast<int> (cell_begin.size ()) - 1;
+
+  // Copy the sorted points into contiguous arrays for the inner loops
+  const int nr_valid = cell_begin[nr_cells];
+  std::vector<float> xs (nr_valid), ys (nr_valid), zs (nr_valid), intensities (nr_valid);
+  std::vector<int64_t> cell_keys (nr_cells);
+  for (int i = 0; i < nr_valid; ++i)
+  {
+    const PointT &point = input_->points[sorted[i]];
+    xs[i] = point.x;
+    ys[i] = point.y;
+    zs[i] = point.z;
+    intensities[i] = point.intensity;
+  }
+  for (int cell = 0; cell < nr_cells; ++cell)
+    cell_keys[cell] = static_cast<int64_t> (keys[cell_begin[cell]]);
+
+  // Only filter the points given by the indices
+  std::vector<unsigned char> is_query (nr_input, 0);
   for (size_t i = 0; i < indices_->size (); ++i)
+    is_query[(*indices_)[i]] = 1;
+
+  // Copy the input data into the output
+  output = *input_;
+
+  const float radius_sqr = static_cast<float> (radius * radius);
+  const float inv_spatial = static_cast<float> (1.0 / (2 * sigma_s_ * sigma_s_));
+  const float inv_range = static_cast<float> (1.0 / (2 * sigma_r_ * sigma_r_));
+
+#pragma omp parallel for num_threads (threads_) schedule (dynamic, 64)
+  for (int cell = 0; cell < nr_cells; ++cell)
   {
-    // Perform a radius search to find the nearest neighbors
-    tree_->radiusSearch ((*indices_)[i], sigma_s_ * 2, k_indices, k_distances);
+    // The points of the 3 adjacent cells of every row are contiguous, find them for the 9 rows around the cell.
+    // Thanks to the padding these ranges are disjoint, so no neighbor is summed twice.
+    int range_begin[9], range_end[9];
+    int nr_ranges = 0;
+    for (int64_t oz = -1; oz <= 1; ++oz)
+    {
+      for (int64_t oy = -1; oy <= 1; ++oy)
+      {
+        const int64_t row_key = cell_keys[cell] + oz * div_xy + oy * div_x;
+        const int first = static_cast<int> (std::lower_bound (cell_keys.begin (), cell_keys.end (), row_key - 1) - cell_keys.begin ());
+        const int last = static_cast<int> (std::upper_bound (cell_keys.begin () + first, cell_keys.end (), row_key + 1) - cell_keys.begin ());
+        if (first == last)
+          continue;
+        range_begin[nr_ranges] = cell_begin[first];
+        range_end[nr_ranges] = cell_begin[last];
+        ++nr_ranges;
+      }
+    }
 
-    // Overwrite the intensity value with the computed average
-    output.points[(*indices_)[i]].intensity = computePointWeight ((*indices_)[i], k_indices, k_distances);
+    for (int i = cell_begin[cell]; i < cell_begin[cell + 1]; ++i)
+    {
+      if (!is_query[sorted[i]])
+        continue;
+      const float x = xs[i], y = ys[i], z = zs[i], intensity = intensities[i];
+      double BF = 0, W = 0;
+      for (int range = 0; range < nr_ranges; ++range)
+      {
+        for (int j = range_begin[range]; j < range_end[range]; ++j)
+        {
+          const float dist_sqr = (xs[j] - x) * (xs[j] - x) + (ys[j] - y) * (ys[j] - y) + (zs[j] - z) * (zs[j] - z);
+          if (dist_sqr > radius_sqr)
+            continue;
+          const float intensity_dist = intensities[j] - intensity;
+          const float weight = lookupWeight (dist_sqr * inv_spatial + intensity_dist * intensity_dist * inv_range);
+          BF += weight * intensities[j];
+          W += weight;
+        }
+      }
+      output.points[sorted[i]].intensity = static_cast<float> (BF / W);
+    }
   }
+  return (true);
 }
  
 #define PCL_INSTANTIATE_BilateralFilter(T) template class PCL_EXPORTS pcl::BilateralFilter<T>;
@@ -133,6 +133,32 @@ pcl::FieldComparison<PointT>::evaluate (const PointT &point) const
   }
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::FieldComparison<PointT>::evaluateBlock (const PointCloud<PointT> &cloud, const int *indices, int nr_points,
+                                             unsigned char *mask) const
+{
+  // the compare results accepted by the operator: bit 0 for <, 1 for == and 2 for >
+  unsigned int accept = 0;
+  switch (this->op_)
+  {
+    case pcl::ComparisonOps::GT : accept = 4; break;
+    case pcl::ComparisonOps::GE : accept = 6; break;
+    case pcl::ComparisonOps::LT : accept = 1; break;
+    case pcl::ComparisonOps::LE : accept = 3; break;
+    case pcl::ComparisonOps::EQ : accept = 2; break;
+  }
+
+  if (!this->capable_ || accept == 0)
+  {
+    PCL_WARN ("[pcl::FieldComparison::evaluateBlock] invalid comparison!\n");
+    std::fill (mask, mask + nr_points, static_cast<unsigned char> (0));
+    return;
+  }
+
+  point_data_->compare (cloud, indices, nr_points, compare_val_, accept, mask);
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
@@ -301,55 +327,40 @@ pcl::PackedHSIComparison<PointT>::PackedHSIComparison (
 template <typename PointT> bool
 pcl::PackedHSIComparison<PointT>::evaluate (const PointT &point) const
 {
-  // Since this is a const function, we can't make these data members because we change them here
-  static uint32_t rgb_val_ = 0;
-  static uint8_t r_ = 0;
-  static uint8_t g_ = 0;
-  static uint8_t b_ = 0;
-  static int8_t h_ = 0;
-  static uint8_t s_ = 0;
-  static uint8_t i_ = 0;
-
   // We know that rgb data is 32 bit aligned (verified in the ctor) so...
   const uint8_t* pt_data = reinterpret_cast<const uint8_t*> (&point);
-  const uint32_t* rgb_data = reinterpret_cast<const uint32_t*> (pt_data + rgb_offset_);
-  uint32_t new_rgb_val = *rgb_data;
-
-  if (rgb_val_ != new_rgb_val) 
-  { // avoid having to redo this calc, if possible
-    rgb_val_ = new_rgb_val;
-    // extract r,g,b
-    r_ = static_cast <uint8_t> (rgb_val_ >> 16); 
-    g_ = static_cast <uint8_t> (rgb_val_ >> 8);
-    b_ = static_cast <uint8_t> (rgb_val_);
+  const uint32_t rgb_val = *reinterpret_cast<const uint32_t*> (pt_data + rgb_offset_);
 
-    // definitions taken from http://en.wikipedia.org/wiki/HSL_and_HSI
-    float hx = (2.0f * r_ - g_ - b_) / 4.0f;  // hue x component -127 to 127
-    float hy = static_cast<float> (g_ - b_) * 111.0f / 255.0f; // hue y component -111 to 111
-    h_ = static_cast<int8_t> (atan2(hy, hx) * 128.0f / M_PI);
-
-    int32_t i = (r_+g_+b_)/3; // 0 to 255
-    i_ = static_cast<uint8_t> (i);
-
-    int32_t m;  // min(r,g,b)
-    m = (r_ < g_) ? r_ : g_;
-    m = (m < b_) ? m : b_;
-
-    s_ = static_cast<uint8_t> ((i == 0) ? 0 : 255 - (m * 255) / i); // saturation 0 to 255
-  }
+  // extract r,g,b
+  const uint8_t r = static_cast <uint8_t> (rgb_val >> 16);
+  const uint8_t g = static_cast <uint8_t> (rgb_val >> 8);
+  const uint8_t b = static_cast <uint8_t> (rgb_val);
 
+  // definitions taken from http://en.wikipedia.org/wiki/HSL_and_HSI; only the
+  // requested component is computed, so that the comparison can be evaluated
+  // concurrently
   float my_val = 0;
+  const int32_t i = (r + g + b) / 3; // 0 to 255
 
   switch (component_id_) 
   {
     case H:
-      my_val = static_cast <float> (h_);
+    {
+      float hx = (2.0f * r - g - b) / 4.0f;  // hue x component -127 to 127
+      float hy = static_cast<float> (g - b) * 111.0f / 255.0f; // hue y component -111 to 111
+      my_val = static_cast <float> (static_cast<int8_t> (atan2(hy, hx) * 128.0f / M_PI));
       break;
+    }
     case S:
-      my_val = static_cast <float> (s_);
+    {
+      int32_t m;  // min(r,g,b)
+      m = (r < g) ? r : g;
+      m = (m < b) ? m : b;
+      my_val = static_cast <float> (static_cast<uint8_t> ((i == 0) ? 0 : 255 - (m * 255) / i)); // saturation 0 to 255
       break;
+    }
     case I:
-      my_val = static_cast <float> (i_);
+      my_val = static_cast <float> (static_cast<uint8_t> (i));
       break;
     default:
       assert (false);
@@ -600,8 +611,77 @@ pcl::PointDataAtOffset<PointT>::compare (const PointT& p, const double& val)
   }
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::PointDataAtOffset<PointT>::compare (const PointCloud<PointT> &cloud, const int *indices, int nr_points,
+                                         const double &val, unsigned int accept, unsigned char *mask) const
+{
+  // resolve the datatype once for the whole block; the value is cast to the
+  // type of the data as in the single point version
+  switch (datatype_)
+  {
+    case sensor_msgs::PointField::INT8 :
+      compare<int8_t> (cloud, indices, nr_points, static_cast<int8_t> (val), accept, mask);
+      break;
+    case sensor_msgs::PointField::UINT8 :
+      compare<uint8_t> (cloud, indices, nr_points, static_cast<uint8_t> (val), accept, mask);
+      break;
+    case sensor_msgs::PointField::INT16 :
+      compare<int16_t> (cloud, indices, nr_points, static_cast<int16_t> (val), accept, mask);
+      break;
+    case sensor_msgs::PointField::UINT16 :
+      compare<uint16_t> (cloud, indices, nr_points, static_cast<uint16_t> (val), accept, mask);
+      break;
+    case sensor_msgs::PointField::INT32 :
+      compare<int32_t> (cloud, indices, nr_points, static_cast<int32_t> (val), accept, mask);
+      break;
+    case sensor_msgs::PointField::UINT32 :
+      compare<uint32_t> (cloud, indices, nr_points, static_cast<uint32_t> (val), accept, mask);
+      break;
+    case sensor_msgs::PointField::FLOAT32 :
+      compare<float> (cloud, indices, nr_points, static_cast<float> (val), accept, mask);
+      break;
+    case sensor_msgs::PointField::FLOAT64 :
+      compare<double> (cloud, indices, nr_points, val, accept, mask);
+      break;
+    default :
+      PCL_WARN ("[pcl::pcl::PointDataAtOffset::compare] unknown data_type!\n");
+      // unknown types compare as equal
+      std::fill (mask, mask + nr_points, static_cast<unsigned char> ((accept >> 1) & 1));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> template <typename T> void
+pcl::PointDataAtOffset<PointT>::compare (const PointCloud<PointT> &cloud, const int *indices, int nr_points,
+                                         const T val, unsigned int accept, unsigned char *mask) const
+{
+  for (int i = 0; i < nr_points; ++i)
+  {
+    T pt_val;
+    memcpy (&pt_val, reinterpret_cast<const uint8_t*> (&cloud.points[indices[i]]) + offset_, sizeof (T));
+    // -1, 0 or 1 as in the single point version, used to pick the accept bit
+    const int result = (pt_val > val) - (pt_val < val);
+    mask[i] = static_cast<unsigned char> ((accept >> (result + 1)) & 1);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ComparisonBase<PointT>::evaluateBlock (const PointCloud<PointT> &cloud, const int *indices, int nr_points,
+                                            unsigned char *mask) const
+{
+  for (int i = 0; i < nr_points; ++i)
+    mask[i] = evaluate (cloud.points[indices[i]]);
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> const int pcl::ConditionBase<PointT>::block_size_;
+
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> void 
 pcl::ConditionBase<PointT>::addComparison (ComparisonBaseConstPtr comparison)
@@ -620,6 +700,15 @@ pcl::ConditionBase<PointT>::addCondition (Ptr condition)
   conditions_.push_back (condition);
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionBase<PointT>::evaluateBlock (const PointCloud<PointT> &cloud, const int *indices, int nr_points,
+                                           unsigned char *mask) const
+{
+  for (int i = 0; i < nr_points; ++i)
+    mask[i] = evaluate (cloud.points[indices[i]]);
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
@@ -637,6 +726,36 @@ pcl::ConditionAnd<PointT>::evaluate (const PointT &point) const
   return (true);
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionAnd<PointT>::evaluateBlock (const PointCloud<PointT> &cloud, const int *indices, int nr_points,
+                                          unsigned char *mask) const
+{
+  unsigned char child_mask[ConditionBase<PointT>::block_size_];
+  for (int begin = 0; begin < nr_points; begin += ConditionBase<PointT>::block_size_)
+  {
+    const int size = std::min (nr_points - begin, static_cast<int> (ConditionBase<PointT>::block_size_));
+    unsigned char *block_mask = mask + begin;
+    std::fill (block_mask, block_mask + size, static_cast<unsigned char> (1));
+
+    int nr_passed = size;
+    for (size_t c = 0; c < comparisons_.size () + conditions_.size () && nr_passed > 0; ++c)
+    {
+      if (c < comparisons_.size ())
+        comparisons_[c]->evaluateBlock (cloud, indices + begin, size, child_mask);
+      else
+        conditions_[c - comparisons_.size ()]->evaluateBlock (cloud, indices + begin, size, child_mask);
+
+      nr_passed = 0;
+      for (int i = 0; i < size; ++i)
+      {
+        block_mask[i] &= child_mask[i];
+        nr_passed += block_mask[i];
+      }
+    }
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
@@ -656,6 +775,42 @@ pcl::ConditionOr<PointT>::evaluate (const PointT &point) const
   return (false);
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::ConditionOr<PointT>::evaluateBlock (const PointCloud<PointT> &cloud, const int *indices, int nr_points,
+                                         unsigned char *mask) const
+{
+  if (comparisons_.empty () && conditions_.empty ())
+  {
+    std::fill (mask, mask + nr_points, static_cast<unsigned char> (1));
+    return;
+  }
+
+  unsigned char child_mask[ConditionBase<PointT>::block_size_];
+  for (int begin = 0; begin < nr_points; begin += ConditionBase<PointT>::block_size_)
+  {
+    const int size = std::min (nr_points - begin, static_cast<int> (ConditionBase<PointT>::block_size_));
+    unsigned char *block_mask = mask + begin;
+    std::fill (block_mask, block_mask + size, static_cast<unsigned char> (0));
+
+    int nr_passed = 0;
+    for (size_t c = 0; c < comparisons_.size () + conditions_.size () && nr_passed < size; ++c)
+    {
+      if (c < comparisons_.size ())
+        comparisons_[c]->evaluateBlock (cloud, indices + begin, size, child_mask);
+      else
+        conditions_[c - comparisons_.size ()]->evaluateBlock (cloud, indices + begin, size, child_mask);
+
+      nr_passed = 0;
+      for (int i = 0; i < size; ++i)
+      {
+        block_mask[i] |= child_mask[i];
+        nr_passed += block_mask[i];
+      }
+    }
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
@@ -701,88 +856,97 @@ pcl::ConditionalRemoval<PointT>::applyFilter (PointCloud &output)
     output.width    = this->input_->width;
     output.is_dense = this->input_->is_dense;
   }
-  output.points.resize (input_->points.size ());
-  removed_indices_->resize (input_->points.size ());
+  // in the organized case every input point is visited once, in the order of the cloud
+  std::vector<int> indices;
+  if (keep_organized_)
+  {
+    indices = *Filter<PointT>::indices_;
+    std::sort (indices.begin (), indices.end ());
+    indices.erase (std::unique (indices.begin (), indices.end ()), indices.end ());
+  }
+  const std::vector<int> &points = keep_organized_ ? indices : *Filter<PointT>::indices_;
 
-  int nr_p = 0;
-  int nr_removed_p = 0;
+  // evaluate the condition over blocks of points, in parallel
+  const int block_size = 4096;
+  const int nr_points = static_cast<int> (points.size ());
+  const int nr_blocks = (nr_points + block_size - 1) / block_size;
+  std::vector<unsigned char> mask (nr_points);
+  std::vector<int> block_passed (nr_blocks + 1, 0);
+#pragma omp parallel for num_threads (threads_) schedule (dynamic, 1)
+  for (int block = 0; block < nr_blocks; ++block)
+  {
+    const int begin = block * block_size;
+    const int end = std::min (begin + block_size, nr_points);
+    condition_->evaluateBlock (*input_, &points[begin], end - begin, &mask[begin]);
+
+    int nr_passed = 0;
+    for (int i = begin; i < end; ++i)
+    {
+      // invalid points are removed as well when not keeping the structure organized
+      if (!keep_organized_ &&
+          (!pcl_isfinite (input_->points[points[i]].x) ||
+           !pcl_isfinite (input_->points[points[i]].y) ||
+           !pcl_isfinite (input_->points[points[i]].z)))
+        mask[i] = 0;
+      nr_passed += mask[i];
+    }
+    block_passed[block + 1] = nr_passed;
+  }
+  for (int block = 0; block < nr_blocks; ++block)
+    block_passed[block + 1] += block_passed[block];
+
+  // the points of a block that did not pass are removed
+  const int nr_removed_p = extract_removed_indices_ ? nr_points - block_passed[nr_blocks] : 0;
+  removed_indices_->resize (nr_removed_p);
 
   if (!keep_organized_)
   {
-    for (size_t cp = 0; cp < Filter<PointT>::indices_->size (); ++cp)
-    {
-      // Check if the point is invalid
-      if (!pcl_isfinite (input_->points[(*Filter < PointT > ::indices_)[cp]].x)
-          || !pcl_isfinite (input_->points[(*Filter < PointT > ::indices_)[cp]].y)
-          || !pcl_isfinite (input_->points[(*Filter < PointT > ::indices_)[cp]].z))
-      {
-        if (extract_removed_indices_)
-        {
-          (*removed_indices_)[nr_removed_p] = (*Filter<PointT>::indices_)[cp];
-          nr_removed_p++;
-        }
-        continue;
-      }
+    output.points.resize (block_passed[nr_blocks]);
+    output.width = static_cast<uint32_t> (output.points.size ());
 
-      if (condition_->evaluate (input_->points[(*Filter < PointT > ::indices_)[cp]]))
-      {
-        pcl::for_each_type<FieldList> (
-                                       pcl::NdConcatenateFunctor<PointT, PointT> (
-                                                                                  input_->points[(*Filter < PointT > ::indices_)[cp]],
-                                                                                  output.points[nr_p]));
-        nr_p++;
-      }
-      else
+#pragma omp parallel for num_threads (threads_) schedule (dynamic, 1)
+    for (int block = 0; block < nr_blocks; ++block)
+    {
+      const int begin = block * block_size;
+      const int end = std::min (begin + block_size, nr_points);
+      int nr_p = block_passed[block];
+      int nr_removed = begin - block_passed[block];
+      for (int cp = begin; cp < end; ++cp)
       {
-        if (extract_removed_indices_)
-        {
-          (*removed_indices_)[nr_removed_p] = (*Filter<PointT>::indices_)[cp];
-          nr_removed_p++;
-        }
+        if (mask[cp])
+          output.points[nr_p++] = input_->points[points[cp]];
+        else if (extract_removed_indices_)
+          (*removed_indices_)[nr_removed++] = points[cp];
       }
     }
-
-    output.width = nr_p;
-    output.points.resize (nr_p);
   }
   else
   {
-    std::vector<int> indices = *Filter<PointT>::indices_;
-    std::sort (indices.begin (), indices.end ());   //TODO: is this necessary or can we assume the indices to be sorted?
-    size_t ci = 0;
-    for (size_t cp = 0; cp < input_->points.size (); ++cp)
+    output.points.resize (input_->points.size ());
+
+    // 0 for points that are not in the indices, 1 for those that passed and 2 for the removed ones
+    std::vector<unsigned char> state (input_->points.size (), 0);
+    for (int ci = 0; ci < nr_points; ++ci)
+      state[indices[ci]] = mask[ci] ? 1 : 2;
+
+#pragma omp parallel for num_threads (threads_) schedule (static)
+    for (int cp = 0; cp < static_cast<int> (input_->points.size ()); ++cp)
     {
-      if (cp == static_cast<size_t> (indices[ci]))
-      {
-        if (ci < indices.size ())
-        {
-          ci++;
-          if (cp == static_cast<size_t> (indices[ci]))   //check whether the next index will have the same value. TODO: necessary?
-            continue;
-        }
-
-        // copy all the fields
-        pcl::for_each_type<FieldList> (pcl::NdConcatenateFunctor<PointT, PointT> (input_->points[cp],
-                                                                                  output.points[cp]));
-        if (!condition_->evaluate (input_->points[cp]))
-        {
-          output.points[cp].getVector4fMap ().setConstant (user_filter_value_);
-
-          if (extract_removed_indices_)
-          {
-            (*removed_indices_)[nr_removed_p] = static_cast<int> (cp);
-            nr_removed_p++;
-          }
-        }
-      }
-      else
-      {
+      // copy all the fields, and overwrite the coordinates of the filtered points
+      output.points[cp] = input_->points[cp];
+      if (state[cp] != 1)
         output.points[cp].getVector4fMap ().setConstant (user_filter_value_);
-        //as for !keep_organized_: removed points due to setIndices are not considered as removed_indices_
-      }
+    }
+
+    // as for !keep_organized_: removed points due to setIndices are not considered as removed_indices_
+    if (extract_removed_indices_)
+    {
+      int nr_removed = 0;
+      for (size_t cp = 0; cp < state.size (); ++cp)
+        if (state[cp] == 2)
+          (*removed_indices_)[nr_removed++] = static_cast<int> (cp);
     }
   }
-  removed_indices_->resize (nr_removed_p);
 }
 
 #define PCL_INSTANTIATE_PointDataAtOffset(T) template class PCL_EXPORTS pcl::PointDataAtOffset<T>;
@@ -41,6 +41,9 @@
 #define PCL_FILTERS_CONVOLUTION_IMPL_HPP
 
 #include <pcl/pcl_config.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
 
 template <typename PointIn, typename PointOut>
 pcl::filters::Convolution<PointIn, PointOut>::Convolution ()
@@ -50,6 +53,8 @@ pcl::filters::Convolution<PointIn, PointOut>::Convolution ()
   , kernel_ ()
   , half_width_ ()
   , kernel_width_ ()
+  , squared_distance_threshold_ (std::numeric_limits<float>::infinity ())
+  , use_channel_planes_ (true)
   , threads_ (1)
 {}
 
@@ -66,8 +71,11 @@ pcl::filters::Convolution<PointIn, PointOut>::initCompute (PointCloud<PointOut>&
     PCL_THROW_EXCEPTION (InitFailedException,
                          "[pcl::filters::Convolution::initCompute] convolving element width must be odd.");
 
+  // the distances are compared squared
   if (distance_threshold_ != std::numeric_limits<float>::infinity ())
-    distance_threshold_ *= static_cast<float> (kernel_.size () % 2) * distance_threshold_;
+    squared_distance_threshold_ = distance_threshold_ * distance_threshold_;
+  else
+    squared_distance_threshold_ = std::numeric_limits<float>::infinity ();
 
   half_width_ = static_cast<int> (kernel_.size ()) / 2;
   kernel_width_ = static_cast<int> (kernel_.size () - 1);
@@ -90,11 +98,16 @@ pcl::filters::Convolution<PointIn, PointOut>::convolveRows (PointCloudOut& outpu
   try
   {
     initCompute (output);
+    if (useChannelPlanes (static_cast<int> (kernel_.size ()), 1))
+    {
+      convolvePlanes (kernel_, kernel_, true, false, output);
+      return;
+    }
     switch (borders_policy_)
     {
-      case BORDERS_POLICY_MIRROR : convolve_rows_mirror (output);
-      case BORDERS_POLICY_DUPLICATE : convolve_rows_duplicate (output);
-      case BORDERS_POLICY_IGNORE : convolve_rows (output);
+      case BORDERS_POLICY_MIRROR : convolve_rows_mirror (output); break;
+      case BORDERS_POLICY_DUPLICATE : convolve_rows_duplicate (output); break;
+      case BORDERS_POLICY_IGNORE : convolve_rows (output); break;
     }
   }
   catch (InitFailedException& e)
@@ -110,11 +123,16 @@ pcl::filters::Convolution<PointIn, PointOut>::convolveCols (PointCloudOut& outpu
   try
   {
     initCompute (output);
+    if (useChannelPlanes (1, static_cast<int> (kernel_.size ())))
+    {
+      convolvePlanes (kernel_, kernel_, false, true, output);
+      return;
+    }
     switch (borders_policy_)
     {
-      case BORDERS_POLICY_MIRROR : convolve_cols_mirror (output);
-      case BORDERS_POLICY_DUPLICATE : convolve_cols_duplicate (output);
-      case BORDERS_POLICY_IGNORE : convolve_cols (output);
+      case BORDERS_POLICY_MIRROR : convolve_cols_mirror (output); break;
+      case BORDERS_POLICY_DUPLICATE : convolve_cols_duplicate (output); break;
+      case BORDERS_POLICY_IGNORE : convolve_cols (output); break;
     }
   }
   catch (InitFailedException& e)
@@ -131,6 +149,16 @@ pcl::filters::Convolution<PointIn, PointOut>::convolve (const Eigen::ArrayXf& h_
 {
   try
   {
+    if (useChannelPlanes (static_cast<int> (h_kernel.size ()), static_cast<int> (v_kernel.size ())))
+    {
+      // no temporary cloud: the rows of every band are convolved just before its columns
+      setKernel (h_kernel);
+      initCompute (output);
+      setKernel (v_kernel);
+      initCompute (output);
+      convolvePlanes (h_kernel, v_kernel, true, true, output);
+      return;
+    }
     PointCloudInPtr tmp (new PointCloud<PointIn> ());
     setKernel (h_kernel);
     convolveRows (*tmp);
@@ -150,6 +178,12 @@ pcl::filters::Convolution<PointIn, PointOut>::convolve (PointCloud<PointOut>& ou
 {
   try
   {
+    if (useChannelPlanes (static_cast<int> (kernel_.size ()), static_cast<int> (kernel_.size ())))
+    {
+      initCompute (output);
+      convolvePlanes (kernel_, kernel_, true, true, output);
+      return;
+    }
     PointCloudInPtr tmp (new PointCloud<PointIn> ());
     convolveRows (*tmp);
     setInputCloud (tmp);
@@ -192,7 +226,7 @@ pcl::filters::Convolution<PointIn, PointOut>::convolveOneRowNonDense (int i, int
   {
     if (!isFinite ((*input_) (l,j)))
       continue;
-    if (pcl::squaredEuclideanDistance ((*input_) (i,j), (*input_) (l,j)) < distance_threshold_)
+    if (pcl::squaredEuclideanDistance ((*input_) (i,j), (*input_) (l,j)) < squared_distance_threshold_)
     {
       result+= (*input_) (l,j) * kernel_[k];
       weight += kernel_[k];
@@ -218,7 +252,7 @@ pcl::filters::Convolution<PointIn, PointOut>::convolveOneColNonDense (int i, int
   {
     if (!isFinite ((*input_) (i,l)))
       continue;
-    if (pcl::squaredEuclideanDistance ((*input_) (i,j), (*input_) (i,l)) < distance_threshold_)
+    if (pcl::squaredEuclideanDistance ((*input_) (i,j), (*input_) (i,l)) < squared_distance_threshold_)
     {
       result+= (*input_) (i,l) * kernel_[k];
       weight += kernel_[k];
@@ -288,7 +322,7 @@ namespace pcl
       {
         if (!isFinite ((*input_) (l,j)))
           continue;
-        if (pcl::squaredEuclideanDistance ((*input_) (i,j), (*input_) (l,j)) < distance_threshold_)
+        if (pcl::squaredEuclideanDistance ((*input_) (i,j), (*input_) (l,j)) < squared_distance_threshold_)
         {
           result.x += (*input_) (l,j).x * kernel_[k]; result.y += (*input_) (l,j).y * kernel_[k]; result.z += (*input_) (l,j).z * kernel_[k];
           r+= kernel_[k] * static_cast<float> ((*input_) (l,j).r);
@@ -322,7 +356,7 @@ namespace pcl
       {
         if (!isFinite ((*input_) (i,l)))
           continue;
-        if (pcl::squaredEuclideanDistance ((*input_) (i,j), (*input_) (i,l)) < distance_threshold_)
+        if (pcl::squaredEuclideanDistance ((*input_) (i,j), (*input_) (i,l)) < squared_distance_threshold_)
         {
           result.x += (*input_) (i,l).x * kernel_[k]; result.y += (*input_) (i,l).y * kernel_[k]; result.z += (*input_) (i,l).z * kernel_[k];
           r+= kernel_[k] * static_cast<float> ((*input_) (i,l).r);
@@ -512,7 +546,7 @@ pcl::filters::Convolution<PointIn, PointOut>::convolve_rows_mirror (PointCloudOu
         output (i,j) = output (w-l, j);
 
       for (int i = 0; i < half_width_; ++i)
-        output (i,j) = output (half_width_+1-i, j);
+        output (i,j) = output (2*half_width_-1-i, j);
     }
   }
   else
@@ -529,7 +563,7 @@ pcl::filters::Convolution<PointIn, PointOut>::convolve_rows_mirror (PointCloudOu
         output (i,j) = output (w-l, j);
 
       for (int i = 0; i < half_width_; ++i)
-        output (i,j) = output (half_width_+1-i, j);
+        output (i,j) = output (2*half_width_-1-i, j);
     }
   }
 }
@@ -646,7 +680,7 @@ pcl::filters::Convolution<PointIn, PointOut>::convolve_cols_mirror (PointCloudOu
         output (i,j) = output (i,h-l);
 
       for (int j = 0; j < half_width_; ++j)
-        output (i,j) = output (i, half_width_+1-j);
+        output (i,j) = output (i, 2*half_width_-1-j);
     }
   }
   else
@@ -663,7 +697,263 @@ pcl::filters::Convolution<PointIn, PointOut>::convolve_cols_mirror (PointCloudOu
         output (i,j) = output (i,h-l);
 
       for (int j = 0; j < half_width_; ++j)
-        output (i,j) = output (i,half_width_+1-j);
+        output (i,j) = output (i,2*half_width_-1-j);
+    }
+  }
+}
+
+template <typename PointIn, typename PointOut> void
+pcl::filters::Convolution<PointIn, PointOut>::convolveSpan (const float* src, size_t src_plane_size, int step,
+                                                           const float* reversed_kernel, int kernel_size,
+                                                           const float* defaults, bool dense,
+                                                           int nr_elements, float* dst, size_t dst_plane_size) const
+{
+  const int nr_channels = ConvolutionChannels<PointIn>::size;
+  // the element itself, for the distances to its neighbors
+  const float* center = src + (kernel_size / 2) * step;
+  const float nan = std::numeric_limits<float>::quiet_NaN ();
+  int e = 0;
+#ifdef __SSE__
+  // Four elements at a time, every lane performing the same operations in the same order as the point operators
+  for (; e + 4 <= nr_elements; e += 4)
+  {
+    __m128 sum[8];
+    for (int c = 0; c < nr_channels; ++c)
+      sum[c] = _mm_set1_ps (defaults[c]);
+    if (dense)
+    {
+      for (int k = 0; k < kernel_size; ++k)
+      {
+        const __m128 weight = _mm_set1_ps (reversed_kernel[k]);
+        const float* neighbor = src + e + k * step;
+        for (int c = 0; c < nr_channels; ++c)
+          sum[c] = _mm_add_ps (sum[c], _mm_mul_ps (_mm_loadu_ps (neighbor + c * src_plane_size), weight));
+      }
+    }
+    else
+    {
+      const __m128 threshold = _mm_set1_ps (squared_distance_threshold_);
+      const __m128 cx = _mm_loadu_ps (center + e);
+      const __m128 cy = _mm_loadu_ps (center + e + src_plane_size);
+      const __m128 cz = _mm_loadu_ps (center + e + 2 * src_plane_size);
+      __m128 weights = _mm_setzero_ps ();
+      for (int k = 0; k < kernel_size; ++k)
+      {
+        const float* neighbor = src + e + k * step;
+        const __m128 nx = _mm_loadu_ps (neighbor);
+        const __m128 ny = _mm_loadu_ps (neighbor + src_plane_size);
+        const __m128 nz = _mm_loadu_ps (neighbor + 2 * src_plane_size);
+        const __m128 dx = _mm_sub_ps (nx, cx), dy = _mm_sub_ps (ny, cy), dz = _mm_sub_ps (nz, cz);
+        const __m128 dist = _mm_add_ps (_mm_add_ps (_mm_mul_ps (dx, dx), _mm_mul_ps (dy, dy)), _mm_mul_ps (dz, dz));
+        // false for invalid neighbors too
+        const __m128 mask = _mm_cmplt_ps (dist, threshold);
+        const __m128 weight = _mm_set1_ps (reversed_kernel[k]);
+        weights = _mm_add_ps (weights, _mm_and_ps (mask, weight));
+        sum[0] = _mm_add_ps (sum[0], _mm_and_ps (mask, _mm_mul_ps (nx, weight)));
+        sum[1] = _mm_add_ps (sum[1], _mm_and_ps (mask, _mm_mul_ps (ny, weight)));
+        sum[2] = _mm_add_ps (sum[2], _mm_and_ps (mask, _mm_mul_ps (nz, weight)));
+        for (int c = 3; c < nr_channels; ++c)
+          sum[c] = _mm_add_ps (sum[c], _mm_and_ps (mask, _mm_mul_ps (_mm_loadu_ps (neighbor + c * src_plane_size), weight)));
+      }
+      // normalize by the sum of the weights, or invalidate the coordinates if it is zero
+      const __m128 zero = _mm_cmpeq_ps (weights, _mm_setzero_ps ());
+      const __m128 inverse = _mm_div_ps (_mm_set1_ps (1.f), weights);
+      for (int c = 0; c < nr_channels; ++c)
+      {
+        const __m128 invalid = c < 3 ? _mm_set1_ps (nan) : sum[c];
+        sum[c] = _mm_or_ps (_mm_and_ps (zero, invalid), _mm_andnot_ps (zero, _mm_mul_ps (sum[c], inverse)));
+      }
+    }
+    for (int c = 0; c < nr_channels; ++c)
+      _mm_storeu_ps (dst + e + c * dst_plane_size, sum[c]);
+  }
+#endif
+  for (; e < nr_elements; ++e)
+  {
+    float sum[8];
+    for (int c = 0; c < nr_channels; ++c)
+      sum[c] = defaults[c];
+    if (dense)
+    {
+      for (int k = 0; k < kernel_size; ++k)
+        for (int c = 0; c < nr_channels; ++c)
+          sum[c] += src[e + k * step + c * src_plane_size] * reversed_kernel[k];
+    }
+    else
+    {
+      float weights = 0;
+      for (int k = 0; k < kernel_size; ++k)
+      {
+        const float* neighbor = src + e + k * step;
+        const float dx = neighbor[0] - center[e];
+        const float dy = neighbor[src_plane_size] - center[e + src_plane_size];
+        const float dz = neighbor[2 * src_plane_size] - center[e + 2 * src_plane_size];
+        if (!(dx*dx + dy*dy + dz*dz < squared_distance_threshold_))
+          continue;
+        for (int c = 0; c < nr_channels; ++c)
+          sum[c] += neighbor[c * src_plane_size] * reversed_kernel[k];
+        weights += reversed_kernel[k];
+      }
+      if (weights == 0)
+        sum[0] = sum[1] = sum[2] = nan;
+      else
+      {
+        weights = 1.f/weights;
+        for (int c = 0; c < nr_channels; ++c)
+          sum[c] *= weights;
+      }
+    }
+    for (int c = 0; c < nr_channels; ++c)
+      dst[e + c * dst_plane_size] = sum[c];
+  }
+}
+
+template <typename PointIn, typename PointOut> void
+pcl::filters::Convolution<PointIn, PointOut>::convolvePlanes (const Eigen::ArrayXf& h_kernel,
+                                                             const Eigen::ArrayXf& v_kernel,
+                                                             bool convolve_rows, bool convolve_cols,
+                                                             PointCloudOut& output)
+{
+  const int nr_channels = ConvolutionChannels<PointIn>::size;
+  const int width = input_->width;
+  const int height = input_->height;
+  const int h_half = convolve_rows ? static_cast<int> (h_kernel.size ()) / 2 : 0;
+  const int v_half = convolve_cols ? static_cast<int> (v_kernel.size ()) / 2 : 0;
+  const bool dense = input_->is_dense;
+  // rows are written to the output in bands of this height, each band convolved by one thread
+  const int band_height = 16;
+
+  const int h_size = static_cast<int> (h_kernel.size ());
+  const int v_size = static_cast<int> (v_kernel.size ());
+  std::vector<float> h_reversed (h_size), v_reversed (v_size);
+  for (int k = 0; k < h_size; ++k)
+    h_reversed[k] = h_kernel[h_size - 1 - k];
+  for (int k = 0; k < v_size; ++k)
+    v_reversed[k] = v_kernel[v_size - 1 - k];
+
+  // The sums start from the fields of a default output point, and the borders which are ignored are invalid points
+  float defaults[8], invalid[8];
+  PointOut invalid_point = PointOut ();
+  ConvolutionChannels<PointOut>::get (invalid_point, defaults);
+  makeInfinite (invalid_point);
+  ConvolutionChannels<PointOut>::get (invalid_point, invalid);
+
+  // The rows whose columns are convolved, the other ones are filled according to the borders policy afterwards
+  const int first_row = v_half;
+  const int last_row = height - v_half;
+  const int nr_bands = (last_row - first_row + band_height - 1) / band_height;
+
+#if !defined __APPLE__ && defined HAVE_OPENMP
+#pragma omp parallel num_threads (threads_)
+#endif
+  {
+    // the input rows of a band and of the neighbors of its columns, one plane per channel, and the same rows convolved
+    const int tile_height = band_height + 2 * v_half;
+    const size_t tile_plane_size = static_cast<size_t> (tile_height) * width;
+    std::vector<float> input_tile (nr_channels * tile_plane_size);
+    std::vector<float> tile (convolve_rows ? nr_channels * tile_plane_size : 0);
+    std::vector<float> row (convolve_cols ? nr_channels * width : 0);
+
+#if !defined __APPLE__ && defined HAVE_OPENMP
+#pragma omp for schedule (dynamic, 1)
+#endif
+    for (int band = 0; band < nr_bands; ++band)
+    {
+      const int band_begin = first_row + band * band_height;
+      const int band_end = std::min (last_row, band_begin + band_height);
+      const int source_first_row = band_begin - v_half;
+      const int source_end_row = band_end + v_half;
+
+      // Convert the input rows to channel planes
+      float channels[8];
+      for (int j = source_first_row; j < source_end_row; ++j)
+      {
+        float* dst = &input_tile[(j - source_first_row) * width];
+        for (int i = 0; i < width; ++i)
+        {
+          ConvolutionChannels<PointIn>::get ((*input_) (i,j), channels);
+          for (int c = 0; c < nr_channels; ++c)
+            dst[c * tile_plane_size + i] = channels[c];
+        }
+      }
+
+      // Convolve the rows, then fill their borders
+      const float* source = &input_tile[0];
+      if (convolve_rows)
+      {
+        const int last = width - h_half;
+        for (int j = 0; j < source_end_row - source_first_row; ++j)
+        {
+          float* dst = &tile[j * width];
+          convolveSpan (&input_tile[j * width], tile_plane_size, 1, &h_reversed[0], h_size,
+                        defaults, dense, last - h_half, dst + h_half, tile_plane_size);
+          for (int c = 0; c < nr_channels; ++c)
+          {
+            float* channel = dst + c * tile_plane_size;
+            for (int l = 0; l < h_half; ++l)
+            {
+              switch (borders_policy_)
+              {
+                case BORDERS_POLICY_MIRROR :
+                  channel[last + l] = channel[last - 1 - l];
+                  channel[h_half - 1 - l] = channel[h_half + l];
+                  break;
+                case BORDERS_POLICY_DUPLICATE :
+                  channel[last + l] = channel[last - 1];
+                  channel[h_half - 1 - l] = channel[h_half];
+                  break;
+                default :
+                  channel[last + l] = channel[h_half - 1 - l] = invalid[c];
+              }
+            }
+          }
+        }
+        source = &tile[0];
+      }
+
+      // Convolve the columns of the band, or write the convolved rows
+      for (int j = band_begin; j < band_end; ++j)
+      {
+        const float* values = source + (j - source_first_row) * width;
+        size_t values_plane_size = tile_plane_size;
+        if (convolve_cols)
+        {
+          convolveSpan (source + (j - v_half - source_first_row) * width, tile_plane_size, width,
+                        &v_reversed[0], v_size, defaults, dense, width, &row[0], width);
+          values = &row[0];
+          values_plane_size = width;
+        }
+
+        for (int i = 0; i < width; ++i)
+        {
+          for (int c = 0; c < nr_channels; ++c)
+            channels[c] = values[c * values_plane_size + i];
+          PointOut& point = output (i,j);
+          point = PointOut ();
+          ConvolutionChannels<PointOut>::set (channels, point);
+        }
+      }
+    }
+  }
+
+  // Fill the rows at the borders
+  for (int l = 0; l < v_half; ++l)
+  {
+    for (int i = 0; i < width; ++i)
+    {
+      switch (borders_policy_)
+      {
+        case BORDERS_POLICY_MIRROR :
+          output (i, last_row + l) = output (i, last_row - 1 - l);
+          output (i, v_half - 1 - l) = output (i, v_half + l);
+          break;
+        case BORDERS_POLICY_DUPLICATE :
+          output (i, last_row + l) = output (i, last_row - 1);
+          output (i, v_half - 1 - l) = output (i, v_half);
+          break;
+        default :
+          output (i, last_row + l) = output (i, v_half - 1 - l) = invalid_point;
+      }
     }
   }
 }
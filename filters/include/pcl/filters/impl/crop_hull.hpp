@@ -44,30 +44,41 @@
 template<typename PointT> void
 pcl::CropHull<PointT>::applyFilter (PointCloud &output)
 {
-  if (dim_ == 2)
+  std::vector<char> inside;
+  computeInside (inside);
+
+  output.points.clear ();
+  output.points.reserve (indices_->size ());
+  for (size_t index = 0; index < indices_->size (); index++)
   {
-    // in this case we are assuming all the points lie in the same plane as the
-    // 2D convex hull, so the choice of projection just changes the
-    // conditioning of the problem: choose to squash the XYZ component of the
-    // hull-points that has least variation - this will also give reasonable
-    // results if the points don't lie exactly in the same plane
-    const Eigen::Vector3f range = getHullCloudRange ();
-    if (range[0] <= range[1] && range[0] <= range[2])
-      applyFilter2D<1,2> (output);
-    else if (range[1] <= range[2] && range[1] <= range[0])
-      applyFilter2D<2,0> (output);
-    else
-      applyFilter2D<0,1> (output);
+    // keep the points inside the hull if we're cropping the outside, and
+    // those that haven't been found inside the hull otherwise
+    if ((inside[index] != 0) == crop_outside_)
+      output.points.push_back (input_->points[(*indices_)[index]]);
   }
-  else
+  output.width = static_cast<uint32_t> (output.points.size ());
+  output.height = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::CropHull<PointT>::applyFilter (std::vector<int> &indices)
+{
+  std::vector<char> inside;
+  computeInside (inside);
+
+  indices.clear ();
+  indices.reserve (indices_->size ());
+  for (size_t index = 0; index < indices_->size (); index++)
   {
-    applyFilter3D (output);
+    if ((inside[index] != 0) == crop_outside_)
+      indices.push_back ((*indices_)[index]);
   }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointT> void
-pcl::CropHull<PointT>::applyFilter (std::vector<int> &indices)
+pcl::CropHull<PointT>::computeInside (std::vector<char> &inside)
 {
   if (dim_ == 2)
   {
@@ -78,15 +89,15 @@ pcl::CropHull<PointT>::applyFilter (std::vector<int> &indices)
     // results if the points don't lie exactly in the same plane
     const Eigen::Vector3f range = getHullCloudRange ();
     if (range[0] <= range[1] && range[0] <= range[2])
-      applyFilter2D<1,2> (indices);
+      computeInside2D<1,2> (inside);
     else if (range[1] <= range[2] && range[1] <= range[0])
-      applyFilter2D<2,0> (indices);
+      computeInside2D<2,0> (inside);
     else
-      applyFilter2D<0,1> (indices);
+      computeInside2D<0,1> (inside);
   }
   else
   {
-    applyFilter3D (indices);
+    computeInside3D (inside);
   }
 }
 
@@ -118,161 +129,234 @@ pcl::CropHull<PointT>::getHullCloudRange ()
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-template<typename PointT> template<unsigned PlaneDim1, unsigned PlaneDim2> void 
-pcl::CropHull<PointT>::applyFilter2D (PointCloud &output)
+template<typename PointT> template<unsigned PlaneDim1, unsigned PlaneDim2> void
+pcl::CropHull<PointT>::buildEdgeSlabs (EdgeSlabs &slabs) const
 {
-  for (size_t index = 0; index < indices_->size (); index++)
+  std::vector<typename EdgeSlabs::Edge> edges;
+  for (size_t poly = 0; poly < hull_polygons_.size (); poly++)
   {
-    // iterate over polygons faster than points because we expect this data
-    // to be, in general, more cache-local - the point cloud might be huge
-    size_t poly;
-    for (poly = 0; poly < hull_polygons_.size (); poly++)
+    const std::vector<uint32_t> &verts = hull_polygons_[poly].vertices;
+    if (verts.empty ())
+      continue;
+
+    double xold = (*hull_cloud_)[verts.back ()].getVector3fMap ()[PlaneDim1];
+    double yold = (*hull_cloud_)[verts.back ()].getVector3fMap ()[PlaneDim2];
+    for (size_t i = 0; i < verts.size (); i++)
     {
-      if (isPointIn2DPolyWithVertIndices<PlaneDim1,PlaneDim2> (
-              input_->points[(*indices_)[index]], hull_polygons_[poly], *hull_cloud_
-         ))
+      const double xnew = (*hull_cloud_)[verts[i]].getVector3fMap ()[PlaneDim1];
+      const double ynew = (*hull_cloud_)[verts[i]].getVector3fMap ()[PlaneDim2];
+      // edges parallel to PlaneDim2 never change the crossing parity
+      if (xnew != xold)
       {
-        if (crop_outside_)
-          output.push_back (input_->points[(*indices_)[index]]);
-        // once a point has tested +ve for being inside one polygon, we can
-        // stop checking the others:
-        break;
+        typename EdgeSlabs::Edge edge;
+        edge.x1 = xnew > xold ? xold : xnew;
+        edge.y1 = xnew > xold ? yold : ynew;
+        edge.x2 = xnew > xold ? xnew : xold;
+        edge.y2 = xnew > xold ? ynew : yold;
+        edge.polygon = static_cast<int> (poly);
+        edges.push_back (edge);
       }
+      xold = xnew;
+      yold = ynew;
     }
-    // If we're removing points *inside* the hull, only remove points that
-    // haven't been found inside any polygons
-    if (poly == hull_polygons_.size () && !crop_outside_)
-      output.push_back (input_->points[(*indices_)[index]]);
   }
+
+  slabs.min_x = std::numeric_limits<double>::max ();
+  double max_x = -std::numeric_limits<double>::max ();
+  for (size_t i = 0; i < edges.size (); i++)
+  {
+    slabs.min_x = std::min (slabs.min_x, edges[i].x1);
+    max_x = std::max (max_x, edges[i].x2);
+  }
+  slabs.nr_slabs = static_cast<int> (std::max<size_t> (1, std::min<size_t> (edges.size (), 1 << 16)));
+  slabs.inv_width = (max_x > slabs.min_x) ? static_cast<double> (slabs.nr_slabs) / (max_x - slabs.min_x) : 0.0;
+
+  // bucket the edges into every slab they overlap; edges are visited in
+  // polygon order, so inside a slab they stay grouped by polygon. Since
+  // getSlab is monotonic, a point between the end points of an edge always
+  // falls into one of its slabs
+  slabs.slab_begin.assign (slabs.nr_slabs + 1, 0);
+  for (size_t i = 0; i < edges.size (); i++)
+    for (int s = slabs.getSlab (edges[i].x1); s <= slabs.getSlab (edges[i].x2); s++)
+      slabs.slab_begin[s + 1]++;
+  for (int s = 0; s < slabs.nr_slabs; s++)
+    slabs.slab_begin[s + 1] += slabs.slab_begin[s];
+
+  slabs.edges.resize (slabs.slab_begin.back ());
+  std::vector<int> fill (slabs.slab_begin.begin (), slabs.slab_begin.end () - 1);
+  for (size_t i = 0; i < edges.size (); i++)
+    for (int s = slabs.getSlab (edges[i].x1); s <= slabs.getSlab (edges[i].x2); s++)
+      slabs.edges[fill[s]++] = edges[i];
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointT> template<unsigned PlaneDim1, unsigned PlaneDim2> void 
-pcl::CropHull<PointT>::applyFilter2D (std::vector<int> &indices)
+pcl::CropHull<PointT>::computeInside2D (std::vector<char> &inside)
 {
-  // see comments in (PointCloud& output) overload
-  for (size_t index = 0; index < indices_->size (); index++)
+  EdgeSlabs slabs;
+  buildEdgeSlabs<PlaneDim1, PlaneDim2> (slabs);
+
+  inside.assign (indices_->size (), 0);
+#pragma omp parallel for num_threads (threads_) schedule (dynamic, 1024)
+  for (int index = 0; index < static_cast<int> (indices_->size ()); index++)
   {
-    size_t poly;
-    for (poly = 0; poly < hull_polygons_.size (); poly++)
+    const Eigen::Vector3f pt = input_->points[(*indices_)[index]].getVector3fMap ();
+    const double x = pt[PlaneDim1];
+    const double y = pt[PlaneDim2];
+
+    // crossing-number test against the edges of the slab, one polygon at a
+    // time: once a point has tested +ve for being inside one polygon, we can
+    // stop checking the others
+    const int slab = slabs.getSlab (x);
+    bool in_poly = false;
+    int polygon = -1;
+    for (int e = slabs.slab_begin[slab]; e < slabs.slab_begin[slab + 1]; e++)
     {
-      if (isPointIn2DPolyWithVertIndices<PlaneDim1,PlaneDim2> (
-              input_->points[(*indices_)[index]], hull_polygons_[poly], *hull_cloud_
-         ))
+      const typename EdgeSlabs::Edge &edge = slabs.edges[e];
+      if (edge.polygon != polygon)
       {
-        if (crop_outside_)      
-          indices.push_back ((*indices_)[index]);
-        break;
+        if (in_poly)
+          break;
+        polygon = edge.polygon;
       }
+      if (edge.x1 < x && x <= edge.x2 &&
+          (y - edge.y1) * (edge.x2 - edge.x1) < (edge.y2 - edge.y1) * (x - edge.x1))
+        in_poly = !in_poly;
     }
-    if (poly == hull_polygons_.size () && !crop_outside_)
-      indices.push_back ((*indices_)[index]);
+    inside[index] = in_poly;
   }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-template<typename PointT> void 
-pcl::CropHull<PointT>::applyFilter3D (PointCloud &output)
+template<typename PointT> void
+pcl::CropHull<PointT>::buildRayGrid (const Eigen::Vector3f &ray, RayGrid &grid) const
 {
-  // This algorithm could definitely be sped up using kdtree/octree
-  // information, if that is available!
+  grid.ray = ray;
+  grid.axis_u = ray.unitOrthogonal ();
+  grid.axis_v = ray.cross (grid.axis_u);
 
-  for (size_t index = 0; index < indices_->size (); index++)
+  // bounding boxes of the triangles projected onto the plane orthogonal to the ray
+  std::vector<Eigen::Vector4f> boxes (hull_polygons_.size ());
+  grid.min_u = grid.min_v = std::numeric_limits<float>::max ();
+  grid.max_u = grid.max_v = -std::numeric_limits<float>::max ();
+  for (size_t poly = 0; poly < hull_polygons_.size (); poly++)
   {
-    // test ray-crossings for three random rays, and take vote of crossings
-    // counts to determine if each point is inside the hull: the vote avoids
-    // tricky edge and corner cases when rays might fluke through the edge
-    // between two polygons
-    // 'random' rays are arbitrary - basically anything that is less likely to
-    // hit the edge between polygons than coordinate-axis aligned rays would
-    // be.
-    size_t crossings[3] = {0,0,0};
-    Eigen::Vector3f rays[3] = 
+    assert (hull_polygons_[poly].vertices.size () == 3);
+    Eigen::Vector4f &box = boxes[poly];
+    box << std::numeric_limits<float>::max (), -std::numeric_limits<float>::max (),
+           std::numeric_limits<float>::max (), -std::numeric_limits<float>::max ();
+    for (int i = 0; i < 3; i++)
     {
-      Eigen::Vector3f (0.264882f,  0.688399f, 0.675237f),
-      Eigen::Vector3f (0.0145419f, 0.732901f, 0.68018f),
-      Eigen::Vector3f (0.856514f,  0.508771f, 0.0868081f)
-    };
+      const Eigen::Vector3f vert = (*hull_cloud_)[hull_polygons_[poly].vertices[i]].getVector3fMap ();
+      const float u = vert.dot (grid.axis_u);
+      const float v = vert.dot (grid.axis_v);
+      box[0] = std::min (box[0], u); box[1] = std::max (box[1], u);
+      box[2] = std::min (box[2], v); box[3] = std::max (box[3], v);
+    }
+    grid.min_u = std::min (grid.min_u, box[0]); grid.max_u = std::max (grid.max_u, box[1]);
+    grid.min_v = std::min (grid.min_v, box[2]); grid.max_v = std::max (grid.max_v, box[3]);
+  }
+
+  grid.size_u = grid.size_v = 1;
+  grid.inv_cell_u = grid.inv_cell_v = 0.0f;
+  grid.cell_begin.assign (2, 0);
+  grid.polygons.clear ();
+  if (hull_polygons_.empty ())
+    return;
+
+  // the intersection of the ray with a triangle is computed in 3D, so pad the
+  // boxes to make up for the rounding errors of the projection
+  const float scale = std::max (std::max (grid.max_u - grid.min_u, grid.max_v - grid.min_v),
+                                std::max (std::max (std::fabs (grid.min_u), std::fabs (grid.max_u)),
+                                          std::max (std::fabs (grid.min_v), std::fabs (grid.max_v))));
+  const float pad = 1e-4f * scale;
+  grid.min_u -= pad; grid.max_u += pad;
+  grid.min_v -= pad; grid.max_v += pad;
 
+  // roughly one cell per triangle
+  const int side = std::max (1, std::min (1024, static_cast<int> (std::ceil (std::sqrt (static_cast<double> (hull_polygons_.size ()))))));
+  grid.size_u = grid.size_v = side;
+  grid.inv_cell_u = static_cast<float> (side) / (grid.max_u - grid.min_u);
+  grid.inv_cell_v = static_cast<float> (side) / (grid.max_v - grid.min_v);
+
+  grid.cell_begin.assign (side * side + 1, 0);
+  for (int pass = 0; pass < 2; pass++)
+  {
+    std::vector<int> fill (grid.cell_begin.begin (), grid.cell_begin.end () - 1);
     for (size_t poly = 0; poly < hull_polygons_.size (); poly++)
-      for (size_t ray = 0; ray < 3; ray++)
-        crossings[ray] += rayTriangleIntersect
-          (input_->points[(*indices_)[index]], rays[ray], hull_polygons_[poly], *hull_cloud_);
-
-    if (crop_outside_ && (crossings[0]&1) + (crossings[1]&1) + (crossings[2]&1) > 1)
-      output.push_back (input_->points[(*indices_)[index]]);
-    else if (!crop_outside_)
-      output.push_back (input_->points[(*indices_)[index]]);
+    {
+      const Eigen::Vector4f &box = boxes[poly];
+      const int u0 = RayGrid::getCell (box[0] - pad, grid.min_u, grid.inv_cell_u, side);
+      const int u1 = RayGrid::getCell (box[1] + pad, grid.min_u, grid.inv_cell_u, side);
+      const int v0 = RayGrid::getCell (box[2] - pad, grid.min_v, grid.inv_cell_v, side);
+      const int v1 = RayGrid::getCell (box[3] + pad, grid.min_v, grid.inv_cell_v, side);
+      for (int v = v0; v <= v1; v++)
+        for (int u = u0; u <= u1; u++)
+        {
+          if (pass == 0)
+            grid.cell_begin[v * side + u + 1]++;
+          else
+            grid.polygons[fill[v * side + u]++] = static_cast<int> (poly);
+        }
+    }
+    if (pass == 0)
+    {
+      for (int c = 0; c < side * side; c++)
+        grid.cell_begin[c + 1] += grid.cell_begin[c];
+      grid.polygons.resize (grid.cell_begin.back ());
+    }
   }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointT> void 
-pcl::CropHull<PointT>::applyFilter3D (std::vector<int> &indices)
+pcl::CropHull<PointT>::computeInside3D (std::vector<char> &inside)
 {
-  // see comments in applyFilter3D (PointCloud& output)
-  for (size_t index = 0; index < indices_->size (); index++)
+  // test ray-crossings for three random rays, and take vote of crossings
+  // counts to determine if each point is inside the hull: the vote avoids
+  // tricky edge and corner cases when rays might fluke through the edge
+  // between two polygons
+  // 'random' rays are arbitrary - basically anything that is less likely to
+  // hit the edge between polygons than coordinate-axis aligned rays would
+  // be.
+  const Eigen::Vector3f rays[3] = 
   {
-    size_t crossings[3] = {0,0,0};
-    Eigen::Vector3f rays[3] = 
-    {
-      Eigen::Vector3f(0.264882f,  0.688399f, 0.675237f),
-      Eigen::Vector3f(0.0145419f, 0.732901f, 0.68018f),
-      Eigen::Vector3f(0.856514f,  0.508771f, 0.0868081f)
-    };
+    Eigen::Vector3f (0.264882f,  0.688399f, 0.675237f),
+    Eigen::Vector3f (0.0145419f, 0.732901f, 0.68018f),
+    Eigen::Vector3f (0.856514f,  0.508771f, 0.0868081f)
+  };
 
-    for (size_t poly = 0; poly < hull_polygons_.size (); poly++)
-      for (size_t ray = 0; ray < 3; ray++)
-        crossings[ray] += rayTriangleIntersect
-          (input_->points[(*indices_)[index]], rays[ray], hull_polygons_[poly], *hull_cloud_);
-
-    if (crop_outside_ && (crossings[0]&1) + (crossings[1]&1) + (crossings[2]&1) > 1)
-      indices.push_back ((*indices_)[index]);
-    else if (!crop_outside_)
-      indices.push_back ((*indices_)[index]);
-  }
-}
-
-//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-template<typename PointT> template<unsigned PlaneDim1, unsigned PlaneDim2> bool
-pcl::CropHull<PointT>::isPointIn2DPolyWithVertIndices (
-  const PointT& point, const Vertices& verts, const PointCloud& cloud)
-{
-  bool in_poly = false;
-  double x1, x2, y1, y2;
+  // a ray can only cross the triangles whose projection along the ray
+  // contains the projection of the point it is cast from
+  RayGrid grids[3];
+  for (int ray = 0; ray < 3; ray++)
+    buildRayGrid (rays[ray], grids[ray]);
 
-  const int nr_poly_points = static_cast<const int>(verts.vertices.size ());
-  double xold = cloud[verts.vertices[nr_poly_points - 1]].getVector3fMap ()[PlaneDim1];
-  double yold = cloud[verts.vertices[nr_poly_points - 1]].getVector3fMap ()[PlaneDim2];
-  for (int i = 0; i < nr_poly_points; i++)
+  inside.assign (indices_->size (), 0);
+#pragma omp parallel for num_threads (threads_) schedule (dynamic, 1024)
+  for (int index = 0; index < static_cast<int> (indices_->size ()); index++)
   {
-    const double xnew = cloud[verts.vertices[i]].getVector3fMap ()[PlaneDim1];
-    const double ynew = cloud[verts.vertices[i]].getVector3fMap ()[PlaneDim2];
-    if (xnew > xold)
-    {
-      x1 = xold;
-      x2 = xnew;
-      y1 = yold;
-      y2 = ynew;
-    }
-    else
-    {
-      x1 = xnew;
-      x2 = xold;
-      y1 = ynew;
-      y2 = yold;
-    }
+    const PointT &point = input_->points[(*indices_)[index]];
+    const Eigen::Vector3f p = point.getVector3fMap ();
 
-    if ((xnew < point.getVector3fMap ()[PlaneDim1]) == (point.getVector3fMap ()[PlaneDim1] <= xold) &&
-        (point.getVector3fMap ()[PlaneDim2] - y1) * (x2 - x1) < (y2 - y1) * (point.getVector3fMap ()[PlaneDim1] - x1))
+    int votes = 0;
+    for (int ray = 0; ray < 3; ray++)
     {
-      in_poly = !in_poly;
+      const RayGrid &grid = grids[ray];
+      const float u = p.dot (grid.axis_u);
+      const float v = p.dot (grid.axis_v);
+      if (!(u >= grid.min_u && u <= grid.max_u && v >= grid.min_v && v <= grid.max_v))
+        continue;
+
+      const int cell = RayGrid::getCell (v, grid.min_v, grid.inv_cell_v, grid.size_v) * grid.size_u +
+                       RayGrid::getCell (u, grid.min_u, grid.inv_cell_u, grid.size_u);
+      size_t crossings = 0;
+      for (int i = grid.cell_begin[cell]; i < grid.cell_begin[cell + 1]; i++)
+        crossings += rayTriangleIntersect (point, grid.ray, hull_polygons_[grid.polygons[i]], *hull_cloud_);
+      votes += static_cast<int> (crossings & 1);
     }
-    xold = xnew;
-    yold = ynew;
+    inside[index] = votes > 1;
   }
-
-  return (in_poly);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -59,6 +59,9 @@ pcl::removeNaNFromPointCloud (const pcl::PointCloud<PointT> &cloud_in, pcl::Poin
   if (cloud_in.is_dense)
   {
     cloud_out.points = cloud_in.points;
+    cloud_out.width = cloud_in.width;
+    cloud_out.height = cloud_in.height;
+    cloud_out.is_dense = true;
     for (j = 0; j < cloud_out.points.size (); ++j)
     {
       index[j] = static_cast<int>(j);
@@ -84,6 +87,11 @@ pcl::removeNaNFromPointCloud (const pcl::PointCloud<PointT> &cloud_in, pcl::Poin
       cloud_out.height = 1;
       cloud_out.width  = static_cast<uint32_t>(j);
     }
+    else
+    {
+      cloud_out.width = cloud_in.width;
+      cloud_out.height = cloud_in.height;
+    }
     // Removing bad points => dense (note: 'dense' doesn't mean 'organized')
     cloud_out.is_dense = true;
   }
@@ -40,180 +40,49 @@
 
 #include <pcl/filters/normal_space.h>
 
+#include <algorithm>
 #include <vector>
-#include <list>
 
 ///////////////////////////////////////////////////////////////////////////////
 template<typename PointT, typename NormalT> void
 pcl::NormalSpaceSampling<PointT, NormalT>::applyFilter (PointCloud &output)
 {
-  // If sample size is 0 or if the sample size is greater then input cloud size
-  //   then return entire copy of cloud
-  if (sample_ >= input_->size ())
+  std::vector<int> indices;
+  applyFilter (indices);
+
+  // If all the points are sampled then return entire copy of cloud
+  if (indices.size () == input_->size () && indices.size () == indices_->size ())
   {
     output = *input_;
     return;
   }
 
   // Resize output cloud to sample size
-  output.points.resize (sample_);
-  output.width = sample_;
+  const int nr_samples = static_cast<int> (indices.size ());
+  output.points.resize (nr_samples);
+  output.width = nr_samples;
   output.height = 1;
-  
-  // allocate memory for the histogram of normals.. Normals will then be sampled from each bin..
-  unsigned int n_bins = binsx_ * binsy_ * binsz_;
-  // list<int> holds the indices of points in that bin.. Using list to avoid repeated resizing of vectors.. Helps when the point cloud is
-  // large..
-  std::vector< std::list <int> > normals_hg;
-  normals_hg.reserve (n_bins);
-  for (unsigned int i = 0; i < n_bins; i++) 
-    normals_hg.push_back (std::list<int> ());
-  
-  for (unsigned int i = 0; i < input_normals_->points.size (); i++)
-  {
-    unsigned int bin_number = findBin (input_normals_->points[i].normal, n_bins);
-    normals_hg[bin_number].push_back (i);
-  }
-
-  // Setting up random access for the list created above.. Maintaining the iterators to individual elements of the list in a vector.. Using
-  // vector now as the size of the list is known..
-  std::vector< std::vector <std::list<int>::iterator> > random_access (normals_hg.size ());
-  for (unsigned int i = 0; i < normals_hg.size (); i++)
-  {
-    random_access.push_back (std::vector< std::list<int>::iterator> ());
-    random_access[i].resize (normals_hg[i].size ());
-
-    unsigned int j=0;
-    for (std::list<int>::iterator itr = normals_hg[i].begin (); itr != normals_hg[i].end (); itr++, j++)
-    {
-      random_access[i][j] = itr;
-    }
-  }
-  unsigned int* start_index = new unsigned int[normals_hg.size ()];
-  start_index[0] = 0;
-  unsigned int prev_index = start_index[0];
-  for (unsigned int i = 1; i < normals_hg.size (); i++)
-  {
-    start_index[i] = prev_index + static_cast<unsigned int> (normals_hg[i-1].size ());
-    prev_index = start_index[i];
-  }
-
-  // maintaining flags to check if a point is sampled
-  boost::dynamic_bitset<> is_sampled_flag (input_normals_->points.size ());
-  // maintaining flags to check if all points in the bin are sampled 
-  boost::dynamic_bitset<> bin_empty_flag (normals_hg.size ());
-  unsigned int i = 0;
-  while (i < sample_)
-  {
-    // iterating through every bin and picking one point at random, until the required number of points are sampled..
-    for (unsigned int j = 0; j < normals_hg.size (); j++)
-    {
-      unsigned int M = static_cast<unsigned int> (normals_hg[j].size ());
-      if (M == 0 || bin_empty_flag.test (j))// bin_empty_flag(i) is set if all points in that bin are sampled..
-      {
-        continue;
-      }
-  
-      unsigned int pos = 0;
-      unsigned int random_index = 0;
-      //picking up a sample at random from jth bin
-      do
-      {
-        random_index = std::rand () % M;
-        pos = start_index[j] + random_index;
-      } while (is_sampled_flag.test (pos));
+  output.is_dense = input_->is_dense;
 
-      is_sampled_flag.flip (start_index[j] + random_index);
-
-      // checking if all points in bin j are sampled..
-      if (isEntireBinSampled (is_sampled_flag, start_index[j], static_cast<unsigned int> (normals_hg[j].size ())))
-      {
-        bin_empty_flag.flip (j);
-      }
-
-      unsigned int index = *(random_access[j][random_index]);
-      output.points[i] = input_->points[index];
-      i++;
-      if (i == sample_)
-      {
-        break;
-      }
-    }
-  }
-  delete[] start_index;
-}
-
-///////////////////////////////////////////////////////////////////////////////
-template<typename PointT, typename NormalT> bool 
-pcl::NormalSpaceSampling<PointT, NormalT>::isEntireBinSampled (boost::dynamic_bitset<> &array, unsigned int start_index, unsigned int length)
-{
-  bool status = true;
-  for (unsigned int i = start_index; i < start_index + length; i++)
-  {
-    status = status & array.test (i);
-  }
-  return status;
+  const int threads = static_cast<int> (threads_);
+#pragma omp parallel for num_threads (threads) schedule (static, 4096)
+  for (int i = 0; i < nr_samples; ++i)
+    output.points[i] = input_->points[indices[i]];
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 template<typename PointT, typename NormalT> unsigned int 
-pcl::NormalSpaceSampling<PointT, NormalT>::findBin (float *normal, unsigned int)
+pcl::NormalSpaceSampling<PointT, NormalT>::findBin (const float *normal) const
 {
-  unsigned int bin_number = 0;
-  // holds the bin numbers for direction cosines in x,y,z directions
-  unsigned int t[3] = {0,0,0};
-  
-  // dcos is the direction cosine.
-  float dcos = 0.0;
-  float bin_size = 0.0;
-  // max_cos and min_cos are the maximum and minimum values of cos(theta) respectively
-  float max_cos = 1.0;
-  float min_cos = -1.0;
-
-  dcos = cosf (normal[0]);
-  bin_size = (max_cos - min_cos) / static_cast<float> (binsx_);
-
-  // finding bin number for direction cosine in x direction
-  unsigned int k = 0;
-  for (float i = min_cos; (i + bin_size) < (max_cos - bin_size); i += bin_size , k++)
+  // the components of a unit normal are its direction cosines, in [-1, 1]
+  const unsigned int bins[3] = {binsx_, binsy_, binsz_};
+  unsigned int t[3];
+  for (int d = 0; d < 3; ++d)
   {
-    if (dcos >= i && dcos <= (i+bin_size))
-    {
-      break;
-    }
+    const float bin = (normal[d] + 1.0f) * 0.5f * static_cast<float> (bins[d]);
+    t[d] = bin > 0.0f ? std::min (static_cast<unsigned int> (bin), bins[d] - 1) : 0;
   }
-  t[0] = k;
-
-  dcos = cosf (normal[1]);
-  bin_size = (max_cos - min_cos) / static_cast<float> (binsy_);
-
-  // finding bin number for direction cosine in y direction
-  k = 0;
-  for (float i = min_cos; (i + bin_size) < (max_cos - bin_size); i += bin_size , k++)
-  {
-    if (dcos >= i && dcos <= (i+bin_size))
-    {
-      break;
-    }
-  }
-  t[1] = k;
-    
-  dcos = cosf (normal[2]);
-  bin_size = (max_cos - min_cos) / static_cast<float> (binsz_);
-
-  // finding bin number for direction cosine in z direction
-  k = 0;
-  for (float i = min_cos; (i + bin_size) < (max_cos - bin_size); i += bin_size , k++)
-  {
-    if (dcos >= i && dcos <= (i+bin_size))
-    {
-      break;
-    }
-  }
-  t[2] = k;
-
-  bin_number = t[0] * (binsy_*binsz_) + t[1] * binsz_ + t[2];
-  return bin_number;
+  return (t[0] * (binsy_*binsz_) + t[1] * binsz_ + t[2]);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -223,97 +92,80 @@ pcl::NormalSpaceSampling<PointT, NormalT>::applyFilter (std::vector<int> &indice
 {
   // If sample size is 0 or if the sample size is greater then input cloud size
   //   then return all indices
-  if (sample_ >= input_->width * input_->height)
+  const int nr_points = static_cast<int> (indices_->size ());
+  if (sample_ >= static_cast<unsigned int> (nr_points))
   {
     indices = *indices_;
     return;
   }
 
-  // Resize output indices to sample size
-  indices.resize (sample_);
-  
-  // allocate memory for the histogram of normals.. Normals will then be sampled from each bin..
-  unsigned int n_bins = binsx_ * binsy_ * binsz_;
-  // list<int> holds the indices of points in that bin.. Using list to avoid repeated resizing of vectors.. Helps when the point cloud is
-  // large..
-  std::vector< std::list <int> > normals_hg;
-  normals_hg.reserve (n_bins);
-  for (unsigned int i = 0; i < n_bins; i++)
-    normals_hg.push_back (std::list<int> ());
-  
-  for (unsigned int i=0; i < input_normals_->points.size (); i++)
+  indices.clear ();
+  if (!input_normals_ || input_normals_->points.size () != input_->points.size ())
   {
-    unsigned int bin_number = findBin (input_normals_->points[i].normal, n_bins);
-    normals_hg[bin_number].push_back (i);
+    PCL_ERROR ("[pcl::%s::applyFilter] The normals do not match the input cloud!\n", getClassName ().c_str ());
+    return;
   }
-
-  // Setting up random access for the list created above.. Maintaining the iterators to individual elements of the list in a vector.. Using
-  // vector now as the size of the list is known..
-  std::vector< std::vector <std::list<int>::iterator> > random_access (normals_hg.size ());
-  for (unsigned int i = 0; i < normals_hg.size (); i++)
+  const unsigned int n_bins = binsx_ * binsy_ * binsz_;
+  if (n_bins == 0)
   {
-    random_access.push_back (std::vector<std::list<int>::iterator> ());
-    random_access[i].resize (normals_hg[i].size ());
+    PCL_ERROR ("[pcl::%s::applyFilter] The number of bins is not set!\n", getClassName ().c_str ());
+    return;
+  }
 
-    unsigned int j = 0;
-    for (std::list<int>::iterator itr = normals_hg[i].begin (); itr != normals_hg[i].end (); itr++, j++)
+  // Bin the points in contiguous blocks, one per thread, and count the points of every bin in every block. Points
+  // with invalid normals go to the extra bin n_bins.
+  const int threads = static_cast<int> (threads_);
+  const int nr_bins = static_cast<int> (n_bins) + 1;
+  std::vector<unsigned int> point_bins (nr_points);
+  std::vector<int> block_offsets (threads * nr_bins, 0);
+#pragma omp parallel for num_threads (threads) schedule (static, 1)
+  for (int b = 0; b < threads; ++b)
+  {
+    const int begin = static_cast<int> (static_cast<int64_t> (nr_points) * b / threads);
+    const int end = static_cast<int> (static_cast<int64_t> (nr_points) * (b + 1) / threads);
+    int *counts = &block_offsets[b * nr_bins];
+    for (int i = begin; i < end; ++i)
     {
-      random_access[i][j] = itr;
+      const NormalT &normal = input_normals_->points[(*indices_)[i]];
+      if (pcl_isfinite (normal.normal[0]) && pcl_isfinite (normal.normal[1]) && pcl_isfinite (normal.normal[2]))
+        point_bins[i] = findBin (normal.normal);
+      else
+        point_bins[i] = n_bins;
+      ++counts[point_bins[i]];
     }
   }
-  unsigned int* start_index = new unsigned int[normals_hg.size ()];
-  start_index[0] = 0;
-  unsigned int prev_index = start_index[0];
-  for (unsigned int i = 1; i < normals_hg.size (); i++)
-  {
-    start_index[i] = prev_index + static_cast<unsigned int> (normals_hg[i-1].size ());
-    prev_index = start_index[i];
-  }
 
-  // maintaining flags to check if a point is sampled
-  boost::dynamic_bitset<> is_sampled_flag (input_normals_->points.size ());
-  // maintaining flags to check if all points in the bin are sampled 
-  boost::dynamic_bitset<> bin_empty_flag (normals_hg.size ());
-  unsigned int i=0;
-  while (i < sample_)
+  // The bins hold the points in input order: the points of a bin are ordered by block
+  std::vector<int> bin_begin (nr_bins);
+  int offset = 0;
+  for (int bin = 0; bin < nr_bins; ++bin)
   {
-    // iterating through every bin and picking one point at random, until the required number of points are sampled..
-    for (unsigned int j = 0; j < normals_hg.size (); j++)
+    bin_begin[bin] = offset;
+    for (int b = 0; b < threads; ++b)
     {
-      unsigned int M = static_cast<unsigned int> (normals_hg[j].size ());
-      if (M==0 || bin_empty_flag.test (j)) // bin_empty_flag(i) is set if all points in that bin are sampled..
-      {
-        continue;
-      }
-
-      unsigned int pos = 0;
-      unsigned int random_index = 0;
-
-      //picking up a sample at random from jth bin
-      do
-      {
-        random_index = std::rand () % M;
-        pos = start_index[j] + random_index;
-      } while (is_sampled_flag.test (pos));
-
-      is_sampled_flag.flip (start_index[j] + random_index);
-
-      // checking if all points in bin j are sampled..
-      if (isEntireBinSampled (is_sampled_flag, start_index[j], static_cast<unsigned int> (normals_hg[j].size ()))) 
-      {
-	bin_empty_flag.flip (j);
-      }
-
-      unsigned int index = *(random_access[j][random_index]);
-      indices[i] = index;
-      i++;
-      if (i == sample_)
-      {
-        break;
-      }
+      const int count = block_offsets[b * nr_bins + bin];
+      block_offsets[b * nr_bins + bin] = offset;
+      offset += count;
     }
   }
-  delete[] start_index;
+
+  std::vector<int> binned_indices (nr_points);
+#pragma omp parallel for num_threads (threads) schedule (static, 1)
+  for (int b = 0; b < threads; ++b)
+  {
+    const int begin = static_cast<int> (static_cast<int64_t> (nr_points) * b / threads);
+    const int end = static_cast<int> (static_cast<int64_t> (nr_points) * (b + 1) / threads);
+    int *offsets = &block_offsets[b * nr_bins];
+    for (int i = begin; i < end; ++i)
+      binned_indices[offsets[point_bins[i]]++] = (*indices_)[i];
+  }
+
+  // Sample the bins of the valid normals, and sort the sampled points by index again
+  sampleStrata (bin_begin, static_cast<int> (sample_), seed_, indices, threads_);
+  const int nr_samples = static_cast<int> (indices.size ());
+  for (int i = 0; i < nr_samples; ++i)
+    indices[i] = binned_indices[indices[i]];
+  std::sort (indices.begin (), indices.end ());
 }
 
 #define PCL_INSTANTIATE_NormalSpaceSampling(T,NT) template class PCL_EXPORTS pcl::NormalSpaceSampling<T,NT>;
@@ -40,6 +40,21 @@
 
 #include <pcl/filters/radius_outlier_removal.h>
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::RadiusOutlierRemoval<PointT>::hasEnoughNeighbors (int cp, bool use_input_neighbors,
+                                                       std::vector<int> &nn_indices, std::vector<float> &nn_dists)
+{
+  if (use_input_neighbors && static_cast<int> ((*input_sqr_distances_)[cp].size ()) >= min_pts_radius_)
+  {
+    // The neighbors are sorted by distance, so enough of them are inside the radius if the last one needed is
+    if (min_pts_radius_ <= 0)
+      return (true);
+    return ((*input_sqr_distances_)[cp][min_pts_radius_ - 1] <= search_radius_ * search_radius_);
+  }
+  return (tree_->radiusSearch ((*indices_)[cp], search_radius_, nn_indices, nn_dists) >= min_pts_radius_);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::RadiusOutlierRemoval<PointT>::applyFilter (PointCloud &output)
@@ -51,17 +66,30 @@ pcl::RadiusOutlierRemoval<PointT>::applyFilter (PointCloud &output)
     output.points.clear ();
     return;
   }
-  // Initialize the spatial locator
-  if (!tree_)
+  // Use the precomputed neighbors if they are given for all the points
+  const bool use_input_neighbors = input_sqr_distances_ && input_sqr_distances_->size () == indices_->size ();
+  if (input_sqr_distances_ && !use_input_neighbors)
+    PCL_WARN ("[pcl::%s::applyFilter] The precomputed neighbors do not match the input indices, searching them again.\n", getClassName ().c_str ());
+
+  // The spatial locator is only needed for the points with too few precomputed neighbors
+  bool search_neighbors = !use_input_neighbors;
+  for (size_t cp = 0; cp < indices_->size () && !search_neighbors; ++cp)
+    search_neighbors = (static_cast<int> ((*input_sqr_distances_)[cp].size ()) < min_pts_radius_);
+
+  if (search_neighbors)
   {
-    if (input_->isOrganized ())
-      tree_.reset (new pcl::search::OrganizedNeighbor<PointT> ());
-    else
-      tree_.reset (new pcl::search::KdTree<PointT> (false));
-  }
+    // Initialize the spatial locator
+    if (!tree_)
+    {
+      if (input_->isOrganized ())
+        tree_.reset (new pcl::search::OrganizedNeighbor<PointT> ());
+      else
+        tree_.reset (new pcl::search::KdTree<PointT> (false));
+    }
 
-  // Send the input dataset to the spatial locator
-  tree_->setInputCloud (input_);
+    // Send the input dataset to the spatial locator
+    tree_->setInputCloud (input_);
+  }
 
   // Allocate enough space to hold the results
   std::vector<int> nn_indices (indices_->size ());
@@ -77,9 +105,8 @@ pcl::RadiusOutlierRemoval<PointT>::applyFilter (PointCloud &output)
   // Go over all the points and check which doesn't have enough neighbors
   for (int cp = 0; cp < static_cast<int>(indices_->size ()); ++cp)
   {
-    int k = tree_->radiusSearch ((*indices_)[cp], search_radius_, nn_indices, nn_dists);
     // Check if the number of neighbors is larger than the user imposed limit
-    if (k < min_pts_radius_)
+    if (!hasEnoughNeighbors (cp, use_input_neighbors, nn_indices, nn_dists))
     {
       if (extract_removed_indices_)
       {
@@ -39,56 +39,37 @@
 #define PCL_FILTERS_IMPL_RANDOM_SAMPLE_H_
 
 #include <pcl/filters/random_sample.h>
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/common/common.h>
+#include <algorithm>
+#include <limits>
 
 
 ///////////////////////////////////////////////////////////////////////////////
 template<typename PointT> void
 pcl::RandomSample<PointT>::applyFilter (PointCloud &output)
 {
-  unsigned N = static_cast<unsigned> (input_->size ());
-  float one_over_N = 1.0f / float (N);
+  std::vector<int> indices;
+  applyFilter (indices);
 
-  // If sample size is 0 or if the sample size is greater then input cloud size
-  //   then return entire copy of cloud
-  if (sample_ >= N)
+  // If all the points are sampled then return entire copy of cloud
+  if (indices.size () == input_->size () && indices.size () == indices_->size ())
   {
     output = *input_;
+    return;
   }
-  else
-  {
-    // Resize output cloud to sample size
-    output.points.resize (sample_);
-    output.width = sample_;
-    output.height = 1;
-
-    // Set random seed so derived indices are the same each time the filter runs
-    std::srand (seed_);
 
-    unsigned top = N - sample_;
-    unsigned i = 0;
-    unsigned index = 0;
-
-    // Algorithm A
-    for (size_t n = sample_; n >= 2; n--)
-    {
-      unsigned int V = unifRand ();
-      unsigned S = 0;
-      float quot = float (top) * one_over_N;
-      while (quot > V)
-      {
-        S++;
-        top--;
-        N--;
-        quot = quot * float (top) * one_over_N;
-      }
-      index += S;
-      output.points[i++] = input_->points[index++];
-      N--;
-    }
-
-    index += N * static_cast<unsigned> (unifRand ());
-    output.points[i++] = input_->points[index++];
-  }
+  // Resize output cloud to sample size
+  const int nr_samples = static_cast<int> (indices.size ());
+  output.points.resize (nr_samples);
+  output.width = nr_samples;
+  output.height = 1;
+  output.is_dense = input_->is_dense;
+
+  const int threads = static_cast<int> (threads_);
+#pragma omp parallel for num_threads (threads) schedule (static, 4096)
+  for (int i = 0; i < nr_samples; ++i)
+    output.points[i] = input_->points[indices[i]];
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -96,50 +77,91 @@ template<typename PointT>
 void
 pcl::RandomSample<PointT>::applyFilter (std::vector<int> &indices)
 {
-  unsigned N = static_cast<unsigned> (input_->size ());
-  float one_over_N = 1.0f / float (N);
+  const int N = static_cast<int> (indices_->size ());
 
   // If sample size is 0 or if the sample size is greater then input cloud size
   //   then return all indices
-  if (sample_ >= N)
+  if (sample_ >= static_cast<unsigned int> (N))
   {
     indices = *indices_;
+    return;
   }
-  else
-  {
-    // Resize output indices to sample size
-    indices.resize (sample_);
 
-    // Set random seed so derived indices are the same each time the filter runs
-    std::srand (seed_);
-
-    // Algorithm A
-    unsigned top = N - sample_;
-    unsigned i = 0;
-    unsigned index = 0;
+  // The positions of the sampled points in the indices; when the indices were not given they are the indices
+  sampleSortedPositions (N, static_cast<int> (sample_), seed_, indices, threads_);
+  if (!fake_indices_)
+  {
+    const int nr_samples = static_cast<int> (indices.size ());
+    for (int i = 0; i < nr_samples; ++i)
+      indices[i] = (*indices_)[indices[i]];
+  }
+}
 
-    for (size_t n = sample_; n >= 2; n--)
+///////////////////////////////////////////////////////////////////////////////
+template<typename PointT>
+void
+pcl::StratifiedRandomSample<PointT>::applyFilter (std::vector<int> &indices)
+{
+  indices.clear ();
+
+  Eigen::Vector4f min_p, max_p;
+  getMinMax3D<PointT> (*input_, *indices_, min_p, max_p);
+  if (min_p[0] > max_p[0])
+    return;
+
+  // Compute the grid bounds and check that the voxel indices fit in an integer
+  const Eigen::Array3f inverse_leaf_size = leaf_size_.array ().inverse ();
+  const Eigen::Array3f min_b = (min_p.head<3> ().array () * inverse_leaf_size).floor ();
+  const Eigen::Array3f max_b = (max_p.head<3> ().array () * inverse_leaf_size).floor ();
+  const Eigen::Array3f div_b = max_b - min_b + 1.0f;
+  if (!(div_b < static_cast<float> (std::numeric_limits<int>::max ())).all ())
+  {
+    PCL_WARN ("[pcl::%s::applyFilter] Leaf size is too small for the input dataset. Integer indices would overflow.\n",
+              getClassName ().c_str ());
+    return;
+  }
+  const uint64_t div_x = static_cast<uint64_t> (div_b[0]);
+  const uint64_t div_xy = div_x * static_cast<uint64_t> (div_b[1]);
+  const bool layered_keys = (div_xy > static_cast<uint64_t> (std::numeric_limits<int64_t>::max ()) / static_cast<uint64_t> (div_b[2]));
+
+  // Compute the voxel keys of the points, and group the points by voxel
+  const int nr_points = static_cast<int> (indices_->size ());
+  const uint64_t invalid_key = std::numeric_limits<uint64_t>::max ();
+  std::vector<uint64_t> keys (nr_points), layer_keys (layered_keys ? nr_points : 0);
+  std::vector<int> voxel_indices (*indices_);
+  const int threads = static_cast<int> (threads_);
+#pragma omp parallel for num_threads (threads) schedule (static, 4096)
+  for (int i = 0; i < nr_points; ++i)
+  {
+    const PointT &point = input_->points[voxel_indices[i]];
+    if (!pcl_isfinite (point.x) || !pcl_isfinite (point.y) || !pcl_isfinite (point.z))
     {
-      unsigned int V = unifRand ();
-      unsigned S = 0;
-      float quot = float (top) * one_over_N;
-      while (quot > V)
-      {
-        S++;
-        top--;
-        N--;
-        quot = quot * float (top) * one_over_N;
-      }
-      index += S;
-      indices[i++] = (*indices_)[index++];
-      N--;
+      keys[i] = invalid_key;
+      if (layered_keys)
+        layer_keys[i] = invalid_key;
+      continue;
     }
-
-    index += N * static_cast<unsigned> (unifRand ());
-    indices[i++] = (*indices_)[index++];
+    const uint64_t ijk0 = static_cast<uint64_t> (floorf (point.x * inverse_leaf_size[0]) - min_b[0]);
+    const uint64_t ijk1 = static_cast<uint64_t> (floorf (point.y * inverse_leaf_size[1]) - min_b[1]);
+    const uint64_t ijk2 = static_cast<uint64_t> (floorf (point.z * inverse_leaf_size[2]) - min_b[2]);
+    keys[i] = ijk0 + ijk1 * div_x;
+    if (layered_keys)
+      layer_keys[i] = ijk2;
+    else
+      keys[i] += ijk2 * div_xy;
   }
+  std::vector<int> voxel_begin;
+  sortVoxelGridKeys (keys, layer_keys, voxel_indices, voxel_begin, threads_);
+
+  // Sample the voxels, and sort the sampled points by index again
+  sampleStrata (voxel_begin, static_cast<int> (sample_), seed_, indices, threads_);
+  const int nr_samples = static_cast<int> (indices.size ());
+  for (int i = 0; i < nr_samples; ++i)
+    indices[i] = voxel_indices[indices[i]];
+  std::sort (indices.begin (), indices.end ());
 }
 
 #define PCL_INSTANTIATE_RandomSample(T) template class PCL_EXPORTS pcl::RandomSample<T>;
+#define PCL_INSTANTIATE_StratifiedRandomSample(T) template class PCL_EXPORTS pcl::StratifiedRandomSample<T>;
 
 #endif    // PCL_FILTERS_IMPL_RANDOM_SAMPLE_H_
@@ -60,51 +60,94 @@ pcl::StatisticalOutlierRemoval<PointT>::applyFilter (PointCloud &output)
     return;
   }
 
-  // Initialize the spatial locator
-  if (!tree_)
+  const int nr_points = static_cast<int> (indices_->size ());
+  const int threads = static_cast<int> (threads_);
+
+  // Use the precomputed neighbors if they are given for all the points
+  const bool use_input_neighbors = input_sqr_distances_ && static_cast<int> (input_sqr_distances_->size ()) == nr_points;
+  if (input_sqr_distances_ && !use_input_neighbors)
+    PCL_WARN ("[pcl::%s::applyFilter] The precomputed neighbors do not match the input indices, searching them again.\n", getClassName ().c_str ());
+
+  if (use_input_neighbors)
   {
-    if (input_->isOrganized ())
-      tree_.reset (new pcl::search::OrganizedNeighbor<PointT> ());
-    else
-      tree_.reset (new pcl::search::KdTree<PointT> (false));
+    neighbors_.reset ();
+    sqr_distances_.reset ();
   }
+  else
+  {
+    // Initialize the spatial locator
+    if (!tree_)
+    {
+      if (input_->isOrganized ())
+        tree_.reset (new pcl::search::OrganizedNeighbor<PointT> ());
+      else
+        tree_.reset (new pcl::search::KdTree<PointT> (false));
+    }
 
-  // Send the input dataset to the spatial locator
-  tree_->setInputCloud (input_);
+    // Send the input dataset to the spatial locator
+    tree_->setInputCloud (input_);
 
-  // Allocate enough space to hold the results
-  std::vector<int> nn_indices (mean_k_);
-  std::vector<float> nn_dists (mean_k_);
+    if (save_neighbors_)
+    {
+      neighbors_.reset (new Neighbors (nr_points));
+      sqr_distances_.reset (new Distances (nr_points));
+    }
+    else
+    {
+      neighbors_.reset ();
+      sqr_distances_.reset ();
+    }
+  }
 
-  std::vector<float> distances (indices_->size ());
+  mean_distances_.resize (nr_points);
   // Go over all the points and calculate the mean or smallest distance
-  for (size_t cp = 0; cp < indices_->size (); ++cp)
+#pragma omp parallel num_threads (threads)
   {
-    if (!pcl_isfinite (input_->points[(*indices_)[cp]].x) ||
-        !pcl_isfinite (input_->points[(*indices_)[cp]].y) ||
-        !pcl_isfinite (input_->points[(*indices_)[cp]].z))
-    {
-      distances[cp] = 0;
-      continue;
-    }
+    // Allocate enough space to hold the results
+    std::vector<int> nn_indices (mean_k_);
+    std::vector<float> nn_dists (mean_k_);
 
-    if (tree_->nearestKSearch ((*indices_)[cp], mean_k_, nn_indices, nn_dists) == 0)
+#pragma omp for schedule (dynamic, 256)
+    for (int cp = 0; cp < nr_points; ++cp)
     {
-      distances[cp] = 0;
-      PCL_WARN ("[pcl::%s::applyFilter] Searching for the closest %d neighbors failed.\n", getClassName ().c_str (), mean_k_);
-      continue;
-    }
+      mean_distances_[cp] = 0;
+      const std::vector<float> *sqr_dists = &nn_dists;
+      if (use_input_neighbors)
+        sqr_dists = &(*input_sqr_distances_)[cp];
+      else
+      {
+        if (!pcl_isfinite (input_->points[(*indices_)[cp]].x) ||
+            !pcl_isfinite (input_->points[(*indices_)[cp]].y) ||
+            !pcl_isfinite (input_->points[(*indices_)[cp]].z))
+          continue;
+
+        if (tree_->nearestKSearch ((*indices_)[cp], mean_k_, nn_indices, nn_dists) == 0)
+        {
+          PCL_WARN ("[pcl::%s::applyFilter] Searching for the closest %d neighbors failed.\n", getClassName ().c_str (), mean_k_);
+          continue;
+        }
 
-    // Minimum distance (if mean_k_ == 2) or mean distance
-    double dist_sum = 0;
-    for (int j = 1; j < mean_k_; ++j)
-      dist_sum += sqrt (nn_dists[j]);
-    distances[cp] = static_cast<float> (dist_sum / (mean_k_ - 1));
+        if (save_neighbors_)
+        {
+          (*neighbors_)[cp] = nn_indices;
+          (*sqr_distances_)[cp] = nn_dists;
+        }
+      }
+
+      // Minimum distance (if mean_k_ == 2) or mean distance
+      const int nr_neighbors = std::min (mean_k_, static_cast<int> (sqr_dists->size ()));
+      if (nr_neighbors < 2)
+        continue;
+      double dist_sum = 0;
+      for (int j = 1; j < nr_neighbors; ++j)
+        dist_sum += sqrt ((*sqr_dists)[j]);
+      mean_distances_[cp] = static_cast<float> (dist_sum / (nr_neighbors - 1));
+    }
   }
 
   // Estimate the mean and the standard deviation of the distance vector
   double mean, stddev;
-  getMeanStd (distances, mean, stddev);
+  getMeanStd (mean_distances_, mean, stddev);
   double distance_threshold = mean + std_mul_ * stddev; // a distance that is bigger than this signals an outlier
 
   output.points.resize (input_->points.size ());      // reserve enough space
@@ -118,7 +161,7 @@ pcl::StatisticalOutlierRemoval<PointT>::applyFilter (PointCloud &output)
   {
     if (negative_)
     {
-      if (distances[cp] <= distance_threshold)
+      if (mean_distances_[cp] <= distance_threshold)
       {
         if (extract_removed_indices_)
         {
@@ -130,7 +173,7 @@ pcl::StatisticalOutlierRemoval<PointT>::applyFilter (PointCloud &output)
     }
     else
     {
-      if (distances[cp] > distance_threshold)
+      if (mean_distances_[cp] > distance_threshold)
       {
         if (extract_removed_indices_)
         {
@@ -41,6 +41,8 @@
 #include <pcl/common/common.h>
 #include <pcl/filters/voxel_grid.h>
 
+#include <limits>
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::getMinMax3D (const typename pcl::PointCloud<PointT>::ConstPtr &cloud,
@@ -128,6 +130,53 @@ struct cloud_point_index_idx
   bool operator < (const cloud_point_index_idx &p) const { return (idx < p.idx); }
 };
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> inline bool
+pcl::VoxelGrid<PointT>::computeVoxelKey (int cp, int distance_offset, uint64_t div_xy, bool layered_keys,
+                                         uint64_t &key, uint64_t &layer_key) const
+{
+  const PointT &point = input_->points[cp];
+  if (!input_->is_dense)
+    // Check if the point is invalid
+    if (!pcl_isfinite (point.x) || 
+        !pcl_isfinite (point.y) || 
+        !pcl_isfinite (point.z))
+      return (false);
+
+  // If we don't want to process the entire cloud, but rather filter points far away from the viewpoint first...
+  if (distance_offset >= 0)
+  {
+    // Get the distance value
+    float distance_value = 0;
+    memcpy (&distance_value, reinterpret_cast<const uint8_t*> (&point) + distance_offset, sizeof (float));
+
+    if (filter_limit_negative_)
+    {
+      // Use a threshold for cutting out points which inside the interval
+      if ((distance_value < filter_limit_max_) && (distance_value > filter_limit_min_))
+        return (false);
+    }
+    else
+    {
+      // Use a threshold for cutting out points which are too close/far away
+      if ((distance_value > filter_limit_max_) || (distance_value < filter_limit_min_))
+        return (false);
+    }
+  }
+
+  uint64_t ijk0 = static_cast<uint64_t> (floor (point.x * inverse_leaf_size_[0]) - min_b_[0]);
+  uint64_t ijk1 = static_cast<uint64_t> (floor (point.y * inverse_leaf_size_[1]) - min_b_[1]);
+  uint64_t ijk2 = static_cast<uint64_t> (floor (point.z * inverse_leaf_size_[2]) - min_b_[2]);
+
+  // Compute the centroid leaf index
+  key = ijk0 + ijk1 * div_b_[0];
+  if (layered_keys)
+    layer_key = ijk2;
+  else
+    key += ijk2 * div_xy;
+  return (true);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
@@ -183,105 +232,167 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
     centroid_size += 3;
   }
 
-  std::vector<cloud_point_index_idx> index_vector;
-  index_vector.reserve(input_->points.size());
+  // Voxel keys are the linear voxel indices, computed with 64 bit integers. If the number of voxels exceeds the
+  // range of the keys, points are sorted by their index within an XY layer first and by their Z layer second.
+  const uint64_t div_xy = static_cast<uint64_t> (div_b_[0]) * static_cast<uint64_t> (div_b_[1]);
+  const bool layered_keys = (div_xy > static_cast<uint64_t> (std::numeric_limits<int64_t>::max ()) / static_cast<uint64_t> (div_b_[2]));
+  const uint64_t invalid_key = std::numeric_limits<uint64_t>::max ();
+  const int nr_points = static_cast<int> (input_->points.size ());
+  const int threads = static_cast<int> (threads_);
 
-  // If we don't want to process the entire cloud, but rather filter points far away from the viewpoint first...
+  // Get the distance field index
+  int distance_offset = -1;
   if (!filter_field_name_.empty ())
   {
-    // Get the distance field index
-    std::vector<sensor_msgs::PointField> fields;
     int distance_idx = pcl::getFieldIndex (*input_, filter_field_name_, fields);
     if (distance_idx == -1)
       PCL_WARN ("[pcl::%s::applyFilter] Invalid filter field name. Index is %d.\n", getClassName ().c_str (), distance_idx);
+    else
+      distance_offset = fields[distance_idx].offset;
+  }
 
-    // First pass: go over all points and insert them into the index_vector vector
-    // with calculated idx. Points with the same idx value will contribute to the
-    // same point of resulting CloudPoint
-    for (unsigned int cp = 0; cp < static_cast<unsigned int> (input_->points.size ()); ++cp)
-    {
-      if (!input_->is_dense)
-        // Check if the point is invalid
-        if (!pcl_isfinite (input_->points[cp].x) || 
-            !pcl_isfinite (input_->points[cp].y) || 
-            !pcl_isfinite (input_->points[cp].z))
-          continue;
+  // Accumulate the centroids in a hash table of the occupied voxels, without sorting the points
+  if (use_hash_table_ && !save_leaf_layout_)
+  {
+    const int chunk_size = (nr_points + threads - 1) / threads;
 
-      // Get the distance value
-      const uint8_t* pt_data = reinterpret_cast<const uint8_t*> (&input_->points[cp]);
-      float distance_value = 0;
-      memcpy (&distance_value, pt_data + fields[distance_idx].offset, sizeof (float));
+    // First pass: estimate the number of occupied voxels, to size the hash tables
+    std::vector<VoxelCountEstimator> estimators (threads);
+#pragma omp parallel for num_threads (threads) schedule (static, 1)
+    for (int t = 0; t < threads; ++t)
+    {
+      uint64_t key, layer_key = 0;
+      const int chunk_end = std::min (nr_points, (t + 1) * chunk_size);
+      for (int cp = t * chunk_size; cp < chunk_end; ++cp)
+        if (computeVoxelKey (cp, distance_offset, div_xy, layered_keys, key, layer_key))
+          estimators[t].add (key, layer_key);
+    }
+    for (int t = 1; t < threads; ++t)
+      estimators[0].merge (estimators[t]);
+    const size_t nr_voxels = estimators[0].getEstimate ();
+
+    // Second pass: every thread accumulates the sums of its part of the cloud in its own table
+    std::vector<VoxelCentroidHashTable> tables (threads, VoxelCentroidHashTable (centroid_size));
+#pragma omp parallel for num_threads (threads) schedule (static, 1)
+    for (int t = 0; t < threads; ++t)
+    {
+      const int chunk_end = std::min (nr_points, (t + 1) * chunk_size);
+      tables[t].reserve (std::min (nr_voxels, static_cast<size_t> (std::max (0, chunk_end - t * chunk_size))));
 
-      if (filter_limit_negative_)
+      Eigen::VectorXf temporary = Eigen::VectorXf::Zero (centroid_size);
+      uint64_t key, layer_key = 0;
+      for (int cp = t * chunk_size; cp < chunk_end; ++cp)
       {
-        // Use a threshold for cutting out points which inside the interval
-        if ((distance_value < filter_limit_max_) && (distance_value > filter_limit_min_))
+        if (!computeVoxelKey (cp, distance_offset, div_xy, layered_keys, key, layer_key))
           continue;
+
+        float *sum = tables[t].accumulate (key, layer_key);
+        if (!downsample_all_data_) 
+        {
+          sum[0] += input_->points[cp].x;
+          sum[1] += input_->points[cp].y;
+          sum[2] += input_->points[cp].z;
+        }
+        else 
+        {
+          // ---[ RGB special case
+          if (rgba_index >= 0)
+          {
+            // Fill r/g/b data, assuming that the order is BGRA
+            pcl::RGB rgb;
+            memcpy (&rgb, reinterpret_cast<const char*> (&input_->points[cp]) + rgba_index, sizeof (RGB));
+            temporary[centroid_size-3] = rgb.r;
+            temporary[centroid_size-2] = rgb.g;
+            temporary[centroid_size-1] = rgb.b;
+          }
+          pcl::for_each_type <FieldList> (NdCopyPointEigenFunctor <PointT> (input_->points[cp], temporary));
+          Eigen::Map<Eigen::VectorXf> (sum, centroid_size) += temporary;
+        }
       }
-      else
+    }
+
+    // Merge the tables of all threads into the first one
+    tables[0].reserve (nr_voxels);
+    for (int t = 1; t < threads; ++t)
+    {
+      tables[0].merge (tables[t]);
+      tables[t].clear ();
+    }
+
+    // Third pass: compute the centroids
+    const VoxelCentroidHashTable &table = tables[0];
+    const int total = static_cast<int> (table.size ());
+    output.points.resize (total);
+
+#pragma omp parallel num_threads (threads)
+    {
+      Eigen::VectorXf centroid = Eigen::VectorXf::Zero (centroid_size);
+
+#pragma omp for schedule (static, 1024)
+      for (int index = 0; index < total; ++index)
       {
-        // Use a threshold for cutting out points which are too close/far away
-        if ((distance_value > filter_limit_max_) || (distance_value < filter_limit_min_))
-          continue;
+        centroid = Eigen::Map<const Eigen::VectorXf> (table.getSum (index), centroid_size);
+        centroid /= static_cast<float> (table.getCount (index));
+
+        // store centroid
+        if (!downsample_all_data_) 
+        {
+          output.points[index].x = centroid[0];
+          output.points[index].y = centroid[1];
+          output.points[index].z = centroid[2];
+        }
+        else 
+        {
+          pcl::for_each_type<FieldList> (pcl::NdCopyEigenPointFunctor <PointT> (centroid, output.points[index]));
+          // ---[ RGB special case
+          if (rgba_index >= 0) 
+          {
+            // pack r/g/b into rgb
+            float r = centroid[centroid_size-3], g = centroid[centroid_size-2], b = centroid[centroid_size-1];
+            int rgb = (static_cast<int> (r) << 16) | (static_cast<int> (g) << 8) | static_cast<int> (b);
+            memcpy (reinterpret_cast<char*> (&output.points[index]) + rgba_index, &rgb, sizeof (float));
+          }
+        }
       }
-      
-      int ijk0 = static_cast<int> (floor (input_->points[cp].x * inverse_leaf_size_[0]) - min_b_[0]);
-      int ijk1 = static_cast<int> (floor (input_->points[cp].y * inverse_leaf_size_[1]) - min_b_[1]);
-      int ijk2 = static_cast<int> (floor (input_->points[cp].z * inverse_leaf_size_[2]) - min_b_[2]);
-
-      // Compute the centroid leaf index
-      int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
-      index_vector.push_back (cloud_point_index_idx (static_cast<unsigned int> (idx), cp));
     }
+    output.width = static_cast<uint32_t> (output.points.size ());
+    return;
   }
-  // No distance filtering, process all data
-  else
-  {
-    // First pass: go over all points and insert them into the index_vector vector
-    // with calculated idx. Points with the same idx value will contribute to the
-    // same point of resulting CloudPoint
-    for (unsigned int cp = 0; cp < static_cast<unsigned int> (input_->points.size ()); ++cp)
-    {
-      if (!input_->is_dense)
-        // Check if the point is invalid
-        if (!pcl_isfinite (input_->points[cp].x) || 
-            !pcl_isfinite (input_->points[cp].y) || 
-            !pcl_isfinite (input_->points[cp].z))
-          continue;
 
-      int ijk0 = static_cast<int> (floor (input_->points[cp].x * inverse_leaf_size_[0]) - min_b_[0]);
-      int ijk1 = static_cast<int> (floor (input_->points[cp].y * inverse_leaf_size_[1]) - min_b_[1]);
-      int ijk2 = static_cast<int> (floor (input_->points[cp].z * inverse_leaf_size_[2]) - min_b_[2]);
+  std::vector<uint64_t> keys (nr_points);
+  std::vector<uint64_t> layer_keys (layered_keys ? nr_points : 0);
+  std::vector<int> index_vector (nr_points);
 
-      // Compute the centroid leaf index
-      int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
-      index_vector.push_back (cloud_point_index_idx (static_cast<unsigned int> (idx), cp));
+  // First pass: go over all points and compute the key of their voxel. Points with the same key will contribute
+  // to the same point of resulting CloudPoint. Points which are filtered out are marked by an invalid key.
+#pragma omp parallel for num_threads (threads)
+  for (int cp = 0; cp < nr_points; ++cp)
+  {
+    index_vector[cp] = cp;
+    uint64_t layer_key = 0;
+    if (!computeVoxelKey (cp, distance_offset, div_xy, layered_keys, keys[cp], layer_key))
+    {
+      keys[cp] = invalid_key;
+      layer_key = invalid_key;
     }
+    if (layered_keys)
+      layer_keys[cp] = layer_key;
   }
 
   // Second pass: sort the index_vector vector using value representing target cell as index
   // in effect all points belonging to the same output cell will be next to each other
-  std::sort (index_vector.begin (), index_vector.end (), std::less<cloud_point_index_idx> ());
-
-  // Third pass: count output cells
-  // we need to skip all the same, adjacenent idx values
-  unsigned int total = 0;
-  unsigned int index = 0;
-  while (index < index_vector.size ()) 
-  {
-    unsigned int i = index + 1;
-    while (i < index_vector.size () && index_vector[i].idx == index_vector[index].idx) 
-      ++i;
-    ++total;
-    index = i;
-  }
+  std::vector<int> voxel_begin;
+  sortVoxelGridKeys (keys, layer_keys, index_vector, voxel_begin, threads_);
 
-  // Fourth pass: compute centroids, insert them into their final position
+  // Third pass: compute centroids, insert them into their final position
+  const int total = static_cast<int> (voxel_begin.size ()) - 1;
   output.points.resize (total);
   if (save_leaf_layout_)
   {
     try
     {
+      if (layered_keys || div_xy * div_b_[2] > static_cast<uint64_t> (std::numeric_limits<int>::max ()))
+        throw std::length_error ("VoxelGrid leaf layout");
       leaf_layout_.resize (div_b_[0]*div_b_[1]*div_b_[2], -1);
     }
     catch (std::bad_alloc&)
@@ -295,43 +406,23 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
         "voxel_grid.hpp", "applyFilter");	
     }
   }
-  
-  index = 0;
-  Eigen::VectorXf centroid = Eigen::VectorXf::Zero (centroid_size);
-  Eigen::VectorXf temporary = Eigen::VectorXf::Zero (centroid_size);
 
-  for (unsigned int cp = 0; cp < index_vector.size ();)
+#pragma omp parallel num_threads (threads)
   {
-    // calculate centroid - sum values from all input points, that have the same idx value in index_vector array
-    if (!downsample_all_data_) 
-    {
-      centroid[0] = input_->points[index_vector[cp].cloud_point_index].x;
-      centroid[1] = input_->points[index_vector[cp].cloud_point_index].y;
-      centroid[2] = input_->points[index_vector[cp].cloud_point_index].z;
-    }
-    else 
-    {
-      // ---[ RGB special case
-      if (rgba_index >= 0)
-      {
-        // Fill r/g/b data, assuming that the order is BGRA
-        pcl::RGB rgb;
-        memcpy (&rgb, reinterpret_cast<const char*> (&input_->points[index_vector[cp].cloud_point_index]) + rgba_index, sizeof (RGB));
-        centroid[centroid_size-3] = rgb.r;
-        centroid[centroid_size-2] = rgb.g;
-        centroid[centroid_size-1] = rgb.b;
-      }
-      pcl::for_each_type <FieldList> (NdCopyPointEigenFunctor <PointT> (input_->points[index_vector[cp].cloud_point_index], centroid));
-    }
+    Eigen::VectorXf centroid = Eigen::VectorXf::Zero (centroid_size);
+    Eigen::VectorXf temporary = Eigen::VectorXf::Zero (centroid_size);
 
-    unsigned int i = cp + 1;
-    while (i < index_vector.size () && index_vector[i].idx == index_vector[cp].idx) 
+#pragma omp for schedule (dynamic, 256)
+    for (int index = 0; index < total; ++index)
     {
+      const int cp = voxel_begin[index];
+
+      // calculate centroid - sum values from all input points, that have the same idx value in index_vector array
       if (!downsample_all_data_) 
       {
-        centroid[0] += input_->points[index_vector[i].cloud_point_index].x;
-        centroid[1] += input_->points[index_vector[i].cloud_point_index].y;
-        centroid[2] += input_->points[index_vector[i].cloud_point_index].z;
+        centroid[0] = input_->points[index_vector[cp]].x;
+        centroid[1] = input_->points[index_vector[cp]].y;
+        centroid[2] = input_->points[index_vector[cp]].z;
       }
       else 
       {
@@ -340,45 +431,67 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
         {
           // Fill r/g/b data, assuming that the order is BGRA
           pcl::RGB rgb;
-          memcpy (&rgb, reinterpret_cast<const char*> (&input_->points[index_vector[i].cloud_point_index]) + rgba_index, sizeof (RGB));
-          temporary[centroid_size-3] = rgb.r;
-          temporary[centroid_size-2] = rgb.g;
-          temporary[centroid_size-1] = rgb.b;
+          memcpy (&rgb, reinterpret_cast<const char*> (&input_->points[index_vector[cp]]) + rgba_index, sizeof (RGB));
+          centroid[centroid_size-3] = rgb.r;
+          centroid[centroid_size-2] = rgb.g;
+          centroid[centroid_size-1] = rgb.b;
         }
-        pcl::for_each_type <FieldList> (NdCopyPointEigenFunctor <PointT> (input_->points[index_vector[i].cloud_point_index], temporary));
-        centroid += temporary;
+        pcl::for_each_type <FieldList> (NdCopyPointEigenFunctor <PointT> (input_->points[index_vector[cp]], centroid));
       }
-      ++i;
-    }
 
-    // index is centroid final position in resulting PointCloud
-    if (save_leaf_layout_)
-      leaf_layout_[index_vector[cp].idx] = index;
+      int i = cp + 1;
+      for (; i < voxel_begin[index + 1]; ++i)
+      {
+        if (!downsample_all_data_) 
+        {
+          centroid[0] += input_->points[index_vector[i]].x;
+          centroid[1] += input_->points[index_vector[i]].y;
+          centroid[2] += input_->points[index_vector[i]].z;
+        }
+        else 
+        {
+          // ---[ RGB special case
+          if (rgba_index >= 0)
+          {
+            // Fill r/g/b data, assuming that the order is BGRA
+            pcl::RGB rgb;
+            memcpy (&rgb, reinterpret_cast<const char*> (&input_->points[index_vector[i]]) + rgba_index, sizeof (RGB));
+            temporary[centroid_size-3] = rgb.r;
+            temporary[centroid_size-2] = rgb.g;
+            temporary[centroid_size-1] = rgb.b;
+          }
+          pcl::for_each_type <FieldList> (NdCopyPointEigenFunctor <PointT> (input_->points[index_vector[i]], temporary));
+          centroid += temporary;
+        }
+      }
 
-    centroid /= static_cast<float> (i - cp);
+      // index is centroid final position in resulting PointCloud
+      if (save_leaf_layout_)
+        leaf_layout_[keys[cp]] = index;
 
-    // store centroid
-    // Do we need to process all the fields?
-    if (!downsample_all_data_) 
-    {
-      output.points[index].x = centroid[0];
-      output.points[index].y = centroid[1];
-      output.points[index].z = centroid[2];
-    }
-    else 
-    {
-      pcl::for_each_type<FieldList> (pcl::NdCopyEigenPointFunctor <PointT> (centroid, output.points[index]));
-      // ---[ RGB special case
-      if (rgba_index >= 0) 
+      centroid /= static_cast<float> (i - cp);
+
+      // store centroid
+      // Do we need to process all the fields?
+      if (!downsample_all_data_) 
+      {
+        output.points[index].x = centroid[0];
+        output.points[index].y = centroid[1];
+        output.points[index].z = centroid[2];
+      }
+      else 
       {
-        // pack r/g/b into rgb
-        float r = centroid[centroid_size-3], g = centroid[centroid_size-2], b = centroid[centroid_size-1];
-        int rgb = (static_cast<int> (r) << 16) | (static_cast<int> (g) << 8) | static_cast<int> (b);
-        memcpy (reinterpret_cast<char*> (&output.points[index]) + rgba_index, &rgb, sizeof (float));
+        pcl::for_each_type<FieldList> (pcl::NdCopyEigenPointFunctor <PointT> (centroid, output.points[index]));
+        // ---[ RGB special case
+        if (rgba_index >= 0) 
+        {
+          // pack r/g/b into rgb
+          float r = centroid[centroid_size-3], g = centroid[centroid_size-2], b = centroid[centroid_size-1];
+          int rgb = (static_cast<int> (r) << 16) | (static_cast<int> (g) << 8) | static_cast<int> (b);
+          memcpy (reinterpret_cast<char*> (&output.points[index]) + rgba_index, &rgb, sizeof (float));
+        }
       }
     }
-    cp = i;
-    ++index;
   }
   output.width = static_cast<uint32_t> (output.points.size ());
 }
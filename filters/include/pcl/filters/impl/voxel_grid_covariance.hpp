@@ -39,17 +39,25 @@
 #define PCL_VOXEL_GRID_COVARIANCE_IMPL_H_
 
 #include <pcl/common/common.h>
+#include <pcl/common/morton.h>
 #include <pcl/filters/voxel_grid_covariance.h>
 #include <Eigen/Dense>
 #include <Eigen/Cholesky>
 
 #include <boost/random.hpp>
 #include <boost/random/normal_distribution.hpp>
+#include <algorithm>
+#include <limits>
 
 template<typename PointT> void
 pcl::VoxelGridCovariance<PointT>::applyFilter (PointCloud &output)
 {
   voxel_centroids_leaf_indices_.clear ();
+  leaf_centroid_indices_.clear ();
+  leaves_.clear ();
+  leaf_coordinates_.clear ();
+  leaf_table_.clear ();
+  kdtree_valid_ = false;
 
   // Has the input dataset been set already?
   if (!input_)
@@ -60,11 +68,6 @@ pcl::VoxelGridCovariance<PointT>::applyFilter (PointCloud &output)
     return;
   }
 
-  // Copy the header (and thus the frame_id) + allocate enough space for points
-  output.height = 1;                          // downsampling breaks the organized structure
-  output.is_dense = true;                     // we filter out invalid points
-  output.points.clear ();
-
   Eigen::Vector4f min_p, max_p;
   // Get the minimum and maximum dimensions
   if (!filter_field_name_.empty ()) // If we don't want to process the entire cloud...
@@ -84,312 +87,533 @@ pcl::VoxelGridCovariance<PointT>::applyFilter (PointCloud &output)
   div_b_ = max_b_ - min_b_ + Eigen::Vector4i::Ones ();
   div_b_[3] = 0;
 
-  // Clear the leaves
-  leaves_.clear ();
-
   // Set up the division multiplier
   divb_mul_ = Eigen::Vector4i (1, div_b_[0], div_b_[0] * div_b_[1], 0);
 
-  int centroid_size = 4;
-
-  if (downsample_all_data_)
-    centroid_size = boost::mpl::size<FieldList>::value;
-
-  // ---[ RGB special case
-  std::vector<sensor_msgs::PointField> fields;
   int rgba_index = -1;
-  rgba_index = pcl::getFieldIndex (*input_, "rgb", fields);
-  if (rgba_index == -1)
-    rgba_index = pcl::getFieldIndex (*input_, "rgba", fields);
-  if (rgba_index >= 0)
-  {
-    rgba_index = fields[rgba_index].offset;
-    centroid_size += 3;
-  }
+  const int centroid_size = getCentroidSize (rgba_index);
 
-  // If we don't want to process the entire cloud, but rather filter points far away from the viewpoint first...
+  // Get the distance field index
+  int distance_offset = -1;
   if (!filter_field_name_.empty ())
   {
-    // Get the distance field index
     std::vector<sensor_msgs::PointField> fields;
     int distance_idx = pcl::getFieldIndex (*input_, filter_field_name_, fields);
     if (distance_idx == -1)
       PCL_WARN ("[pcl::%s::applyFilter] Invalid filter field name. Index is %d.\n", getClassName ().c_str (), distance_idx);
+    else
+      distance_offset = fields[distance_idx].offset;
+  }
 
-    // First pass: go over all points and insert them into the right leaf
-    for (size_t cp = 0; cp < input_->points.size (); ++cp)
+  // Voxel keys are the linear voxel indices, see VoxelGrid
+  const uint64_t div_xy = static_cast<uint64_t> (div_b_[0]) * static_cast<uint64_t> (div_b_[1]);
+  const bool layered_keys = (div_xy > static_cast<uint64_t> (std::numeric_limits<int64_t>::max ()) / static_cast<uint64_t> (div_b_[2]));
+  const uint64_t invalid_key = std::numeric_limits<uint64_t>::max ();
+  const int nr_points = static_cast<int> (input_->points.size ());
+  const int threads = static_cast<int> (threads_);
+
+  std::vector<uint64_t> keys (nr_points);
+  std::vector<uint64_t> layer_keys (layered_keys ? nr_points : 0);
+  std::vector<int> index_vector (nr_points);
+
+  // First pass: go over all points and compute the key of their voxel. Points which are filtered out are marked
+  // by an invalid key.
+#pragma omp parallel for num_threads (threads)
+  for (int cp = 0; cp < nr_points; ++cp)
+  {
+    index_vector[cp] = cp;
+    uint64_t layer_key = 0;
+    if (!computeVoxelKey (cp, distance_offset, div_xy, layered_keys, keys[cp], layer_key))
     {
-      if (!input_->is_dense)
-        // Check if the point is invalid
-        if (!pcl_isfinite (input_->points[cp].x) ||
-            !pcl_isfinite (input_->points[cp].y) ||
-            !pcl_isfinite (input_->points[cp].z))
-          continue;
-
-      // Get the distance value
-      const uint8_t* pt_data = reinterpret_cast<const uint8_t*> (&input_->points[cp]);
-      float distance_value = 0;
-      memcpy (&distance_value, pt_data + fields[distance_idx].offset, sizeof (float));
-
-      if (filter_limit_negative_)
-      {
-        // Use a threshold for cutting out points which inside the interval
-        if ((distance_value < filter_limit_max_) && (distance_value > filter_limit_min_))
-          continue;
-      }
-      else
-      {
-        // Use a threshold for cutting out points which are too close/far away
-        if ((distance_value > filter_limit_max_) || (distance_value < filter_limit_min_))
-          continue;
-      }
+      keys[cp] = invalid_key;
+      layer_key = invalid_key;
+    }
+    if (layered_keys)
+      layer_keys[cp] = layer_key;
+  }
 
-      int ijk0 = static_cast<int> (floor (input_->points[cp].x * inverse_leaf_size_[0]) - min_b_[0]);
-      int ijk1 = static_cast<int> (floor (input_->points[cp].y * inverse_leaf_size_[1]) - min_b_[1]);
-      int ijk2 = static_cast<int> (floor (input_->points[cp].z * inverse_leaf_size_[2]) - min_b_[2]);
+  // Second pass: sort the points by voxel, so that the points of a leaf are contiguous
+  std::vector<int> voxel_begin;
+  sortVoxelGridKeys (keys, layer_keys, index_vector, voxel_begin, threads_);
 
-      // Compute the centroid leaf index
-      int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
+  // Third pass: compute the centroids and covariance matrices of all leaves
+  const int nr_leaves = static_cast<int> (voxel_begin.size ()) - 1;
+  leaves_.resize (nr_leaves);
+  leaf_coordinates_.resize (nr_leaves);
+#pragma omp parallel num_threads (threads)
+  {
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigensolver;
 
-      Leaf& leaf = leaves_[idx];
-      if (leaf.nr_points == 0)
+#pragma omp for schedule (dynamic, 64)
+    for (int l = 0; l < nr_leaves; ++l)
+    {
+      Leaf &leaf = leaves_[l];
+      const int begin = voxel_begin[l];
+      const int end = voxel_begin[l + 1];
+      const PointT &first = input_->points[index_vector[begin]];
+      leaf_coordinates_[l] = getVoxelCoordinates (first.x, first.y, first.z);
+
+      leaf.centroid.setZero (centroid_size);
+      for (int i = begin; i < end; ++i)
       {
-        leaf.centroid.resize (centroid_size);
-        leaf.centroid.setZero ();
+        const PointT &point = input_->points[index_vector[i]];
+        leaf.mean_ += Eigen::Vector3d (point.x, point.y, point.z);
+        accumulateCentroid (point, rgba_index, leaf.centroid);
       }
+      leaf.nr_points = leaf.nr_accumulated_points_ = end - begin;
+      leaf.centroid /= static_cast<float> (leaf.nr_points);
+      leaf.mean_ /= leaf.nr_points;
 
-      Eigen::Vector3d pt3d (input_->points[cp].x, input_->points[cp].y, input_->points[cp].z);
-      // Accumulate point sum for centroid calculation
-      leaf.mean_ += pt3d;
-      // Accumulate x*xT for single pass covariance calculation
-      leaf.cov_ += pt3d * pt3d.transpose ();
-
-      // Do we need to process all the fields?
-      if (!downsample_all_data_)
+      // Second pass over the points of the leaf, for an accurate covariance
+      for (int i = begin; i < end; ++i)
       {
-        Eigen::Vector4f pt (input_->points[cp].x, input_->points[cp].y, input_->points[cp].z, 0);
-        leaf.centroid.template head<4> () += pt;
+        const PointT &point = input_->points[index_vector[i]];
+        const Eigen::Vector3d deviation = Eigen::Vector3d (point.x, point.y, point.z) - leaf.mean_;
+        leaf.scatter_ += deviation * deviation.transpose ();
       }
-      else
-      {
-        // Copy all the fields
-        Eigen::VectorXf centroid = Eigen::VectorXf::Zero (centroid_size);
-        // ---[ RGB special case
-        if (rgba_index >= 0)
-        {
-          // fill r/g/b data
-          int rgb;
-          memcpy (&rgb, reinterpret_cast<const char*> (&input_->points[cp]) + rgba_index, sizeof (int));
-          centroid[centroid_size - 3] = static_cast<float> ((rgb >> 16) & 0x0000ff);
-          centroid[centroid_size - 2] = static_cast<float> ((rgb >> 8) & 0x0000ff);
-          centroid[centroid_size - 1] = static_cast<float> ((rgb) & 0x0000ff);
-        }
-        pcl::for_each_type<FieldList> (NdCopyPointEigenFunctor<PointT> (input_->points[cp], centroid));
-        leaf.centroid += centroid;
-      }
-      ++leaf.nr_points;
+
+      // Points with less than the minimum points will have a can not be accuratly approximated using a normal distribution.
+      if (leaf.nr_points >= min_points_per_voxel_)
+        computeLeafCovariance (leaf, eigensolver);
     }
   }
-  // No distance filtering, process all data
-  else
+
+  // The leaves are found by their voxel coordinates
+  leaf_table_.reserve (nr_leaves);
+  for (int l = 0; l < nr_leaves; ++l)
+    leaf_table_.insert (getLeafKey (leaf_coordinates_[l]), static_cast<uint32_t> (leaf_coordinates_[l][2]));
+
+  updateCentroids (output);
+}
+
+//////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::VoxelGridCovariance<PointT>::addPoints (const PointCloud &cloud)
+{
+  int rgba_index = -1;
+  const int centroid_size = getCentroidSize (rgba_index);
+
+  // Get the distance field offset
+  int distance_offset = -1;
+  if (!filter_field_name_.empty ())
   {
-    // First pass: go over all points and insert them into the right leaf
-    for (size_t cp = 0; cp < input_->points.size (); ++cp)
+    std::vector<sensor_msgs::PointField> fields;
+    int distance_idx = pcl::getFieldIndex<PointT> (filter_field_name_, fields);
+    if (distance_idx == -1)
+      PCL_WARN ("[pcl::%s::addPoints] Invalid filter field name. Index is %d.\n", getClassName ().c_str (), distance_idx);
+    else
+      distance_offset = fields[distance_idx].offset;
+  }
+
+  // First pass: find the leaf of every point, creating the leaves of new voxels
+  const uint64_t invalid_key = std::numeric_limits<uint64_t>::max ();
+  const int nr_points = static_cast<int> (cloud.points.size ());
+  std::vector<uint64_t> keys (nr_points);
+  std::vector<int> index_vector (nr_points);
+  for (int cp = 0; cp < nr_points; ++cp)
+  {
+    index_vector[cp] = cp;
+    const PointT &point = cloud.points[cp];
+    if (!acceptPoint (point, !cloud.is_dense, distance_offset))
     {
-      if (!input_->is_dense)
-        // Check if the point is invalid
-        if (!pcl_isfinite (input_->points[cp].x) ||
-            !pcl_isfinite (input_->points[cp].y) ||
-            !pcl_isfinite (input_->points[cp].z))
-          continue;
-
-      int ijk0 = static_cast<int> (floor (input_->points[cp].x * inverse_leaf_size_[0]) - min_b_[0]);
-      int ijk1 = static_cast<int> (floor (input_->points[cp].y * inverse_leaf_size_[1]) - min_b_[1]);
-      int ijk2 = static_cast<int> (floor (input_->points[cp].z * inverse_leaf_size_[2]) - min_b_[2]);
-
-      // Compute the centroid leaf index
-      int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
-
-      //int idx = (((input_->points[cp].getArray4fMap () * inverse_leaf_size_).template cast<int> ()).matrix () - min_b_).dot (divb_mul_);
-      Leaf& leaf = leaves_[idx];
-      if (leaf.nr_points == 0)
-      {
-        leaf.centroid.resize (centroid_size);
-        leaf.centroid.setZero ();
-      }
+      keys[cp] = invalid_key;
+      continue;
+    }
 
-      Eigen::Vector3d pt3d (input_->points[cp].x, input_->points[cp].y, input_->points[cp].z);
-      // Accumulate point sum for centroid calculation
-      leaf.mean_ += pt3d;
-      // Accumulate x*xT for single pass covariance calculation
-      leaf.cov_ += pt3d * pt3d.transpose ();
+    const Eigen::Vector3i ijk = getVoxelCoordinates (point.x, point.y, point.z);
+    const int l = leaf_table_.insert (getLeafKey (ijk), static_cast<uint32_t> (ijk[2]));
+    if (l == static_cast<int> (leaves_.size ()))
+    {
+      leaves_.push_back (Leaf ());
+      leaves_.back ().centroid.setZero (centroid_size);
+      leaf_coordinates_.push_back (ijk);
+    }
+    keys[cp] = l;
+  }
 
-      // Do we need to process all the fields?
-      if (!downsample_all_data_)
+  // Second pass: sort the points by leaf
+  pcl::radixSortKeys (keys, index_vector, threads_);
+  std::vector<int> leaf_begin;
+  for (int i = 0; i < nr_points && keys[i] != invalid_key; ++i)
+    if (i == 0 || keys[i] != keys[i - 1])
+      leaf_begin.push_back (i);
+  leaf_begin.push_back (nr_points);
+  while (leaf_begin.size () > 1 && keys[leaf_begin.back () - 1] == invalid_key)
+    --leaf_begin.back ();
+
+  // Third pass: merge the statistics of the new points of every leaf with the old ones
+  const int nr_updated_leaves = static_cast<int> (leaf_begin.size ()) - 1;
+  const int threads = static_cast<int> (threads_);
+#pragma omp parallel num_threads (threads)
+  {
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigensolver;
+    Eigen::VectorXf centroid_sum (centroid_size);
+
+#pragma omp for schedule (dynamic, 64)
+    for (int u = 0; u < nr_updated_leaves; ++u)
+    {
+      const int begin = leaf_begin[u];
+      const int end = leaf_begin[u + 1];
+      Leaf &leaf = leaves_[keys[begin]];
+
+      Eigen::Vector3d mean = Eigen::Vector3d::Zero ();
+      centroid_sum.setZero ();
+      for (int i = begin; i < end; ++i)
       {
-        Eigen::Vector4f pt (input_->points[cp].x, input_->points[cp].y, input_->points[cp].z, 0);
-        leaf.centroid.template head<4> () += pt;
+        const PointT &point = cloud.points[index_vector[i]];
+        mean += Eigen::Vector3d (point.x, point.y, point.z);
+        accumulateCentroid (point, rgba_index, centroid_sum);
       }
-      else
+      const int nr_new_points = end - begin;
+      mean /= nr_new_points;
+      Eigen::Matrix3d scatter = Eigen::Matrix3d::Zero ();
+      for (int i = begin; i < end; ++i)
       {
-        // Copy all the fields
-        Eigen::VectorXf centroid = Eigen::VectorXf::Zero (centroid_size);
-        // ---[ RGB special case
-        if (rgba_index >= 0)
-        {
-          // Fill r/g/b data, assuming that the order is BGRA
-          int rgb;
-          memcpy (&rgb, reinterpret_cast<const char*> (&input_->points[cp]) + rgba_index, sizeof (int));
-          centroid[centroid_size - 3] = static_cast<float> ((rgb >> 16) & 0x0000ff);
-          centroid[centroid_size - 2] = static_cast<float> ((rgb >> 8) & 0x0000ff);
-          centroid[centroid_size - 1] = static_cast<float> ((rgb) & 0x0000ff);
-        }
-        pcl::for_each_type<FieldList> (NdCopyPointEigenFunctor<PointT> (input_->points[cp], centroid));
-        leaf.centroid += centroid;
+        const PointT &point = cloud.points[index_vector[i]];
+        const Eigen::Vector3d deviation = Eigen::Vector3d (point.x, point.y, point.z) - mean;
+        scatter += deviation * deviation.transpose ();
       }
-      ++leaf.nr_points;
+
+      // Combine the means and scatter matrices of both sets of points
+      const int nr_old_points = leaf.nr_accumulated_points_;
+      const int nr_total_points = nr_old_points + nr_new_points;
+      const Eigen::Vector3d delta = mean - leaf.mean_;
+      leaf.scatter_ += scatter + delta * delta.transpose () *
+                       (static_cast<double> (nr_old_points) * nr_new_points / nr_total_points);
+      leaf.mean_ += delta * (static_cast<double> (nr_new_points) / nr_total_points);
+      leaf.centroid = (leaf.centroid * static_cast<float> (nr_old_points) + centroid_sum) /
+                      static_cast<float> (nr_total_points);
+      leaf.nr_points = leaf.nr_accumulated_points_ = nr_total_points;
+
+      if (leaf.nr_points >= min_points_per_voxel_)
+        computeLeafCovariance (leaf, eigensolver);
     }
   }
 
-  // Second pass: go over all leaves and compute centroids and covariance matrices
-  output.points.reserve (leaves_.size ());
-  if (searchable_)
-    voxel_centroids_leaf_indices_.reserve (leaves_.size ());
-  int cp = 0;
-  if (save_leaf_layout_)
-    leaf_layout_.resize (div_b_[0] * div_b_[1] * div_b_[2], -1);
+  PointCloudPtr centroids (new PointCloud);
+  centroids->header = cloud.header;
+  updateCentroids (*centroids);
+  voxel_centroids_ = centroids;
+  kdtree_valid_ = false;
+}
 
-  // Eigen values and vectors calculated to prevent near singluar matrices
-  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigensolver;
-  Eigen::Matrix3d eigen_val;
-  Eigen::Vector3d pt_sum;
+//////////////////////////////////////////////////////////////////////////
+template<typename PointT> int
+pcl::VoxelGridCovariance<PointT>::getCentroidSize (int &rgba_index) const
+{
+  int centroid_size = 4;
 
-  // Eigen values less than a threshold of max eigen value are inflated to a set fraction of the max eigen value.
-  double min_covar_eigvalue;
+  if (downsample_all_data_)
+    centroid_size = boost::mpl::size<FieldList>::value;
 
-  for (typename boost::unordered_map<size_t, Leaf>::iterator it = leaves_.begin (); it != leaves_.end (); ++it)
+  // ---[ RGB special case
+  std::vector<sensor_msgs::PointField> fields;
+  rgba_index = pcl::getFieldIndex<PointT> ("rgb", fields);
+  if (rgba_index == -1)
+    rgba_index = pcl::getFieldIndex<PointT> ("rgba", fields);
+  if (rgba_index >= 0)
   {
+    rgba_index = fields[rgba_index].offset;
+    centroid_size += 3;
+  }
+  return (centroid_size);
+}
 
-    // Normalize the centroid
-    Leaf& leaf = it->second;
+//////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::VoxelGridCovariance<PointT>::accumulateCentroid (const PointT &point, int rgba_index,
+                                                      Eigen::VectorXf &centroid) const
+{
+  // Do we need to process all the fields?
+  if (!downsample_all_data_)
+  {
+    centroid[0] += point.x;
+    centroid[1] += point.y;
+    centroid[2] += point.z;
+    return;
+  }
 
-    // Normalize the centroid
-    leaf.centroid /= static_cast<float> (leaf.nr_points);
-    // Point sum used for single pass covariance calculation
-    pt_sum = leaf.mean_;
-    // Normalize mean
-    leaf.mean_ /= leaf.nr_points;
+  // Copy all the fields
+  const int centroid_size = static_cast<int> (centroid.size ());
+  Eigen::VectorXf values = Eigen::VectorXf::Zero (centroid_size);
+  // ---[ RGB special case
+  if (rgba_index >= 0)
+  {
+    // Fill r/g/b data, assuming that the order is BGRA
+    int rgb;
+    memcpy (&rgb, reinterpret_cast<const char*> (&point) + rgba_index, sizeof (int));
+    values[centroid_size - 3] = static_cast<float> ((rgb >> 16) & 0x0000ff);
+    values[centroid_size - 2] = static_cast<float> ((rgb >> 8) & 0x0000ff);
+    values[centroid_size - 1] = static_cast<float> ((rgb) & 0x0000ff);
+  }
+  pcl::for_each_type<FieldList> (NdCopyPointEigenFunctor<PointT> (point, values));
+  centroid += values;
+}
 
-    // If the voxel contains sufficient points, its covariance is calculated and is added to the voxel centroids and output clouds.
-    // Points with less than the minimum points will have a can not be accuratly approximated using a normal distribution.
-    if (leaf.nr_points >= min_points_per_voxel_)
-    {
-      if (save_leaf_layout_)
-        leaf_layout_[it->first] = cp++;
+//////////////////////////////////////////////////////////////////////////
+template<typename PointT> bool
+pcl::VoxelGridCovariance<PointT>::acceptPoint (const PointT &point, bool check_finite, int distance_offset) const
+{
+  // Check if the point is invalid
+  if (check_finite && (!pcl_isfinite (point.x) || !pcl_isfinite (point.y) || !pcl_isfinite (point.z)))
+    return (false);
 
-      output.push_back (PointT ());
+  if (distance_offset < 0)
+    return (true);
 
-      // Do we need to process all the fields?
-      if (!downsample_all_data_)
-      {
-        output.points.back ().x = leaf.centroid[0];
-        output.points.back ().y = leaf.centroid[1];
-        output.points.back ().z = leaf.centroid[2];
-      }
-      else
-      {
-        pcl::for_each_type<FieldList> (pcl::NdCopyEigenPointFunctor<PointT> (leaf.centroid, output.back ()));
-        // ---[ RGB special case
-        if (rgba_index >= 0)
-        {
-          // pack r/g/b into rgb
-          float r = leaf.centroid[centroid_size - 3], g = leaf.centroid[centroid_size - 2], b = leaf.centroid[centroid_size - 1];
-          int rgb = (static_cast<int> (r)) << 16 | (static_cast<int> (g)) << 8 | (static_cast<int> (b));
-          memcpy (reinterpret_cast<char*> (&output.points.back ()) + rgba_index, &rgb, sizeof (float));
-        }
-      }
+  // Get the distance value
+  float distance_value = 0;
+  memcpy (&distance_value, reinterpret_cast<const uint8_t*> (&point) + distance_offset, sizeof (float));
 
-      // Stores the voxel indice for fast access searching
-      if (searchable_)
-        voxel_centroids_leaf_indices_.push_back (static_cast<int> (it->first));
+  // Use a threshold for cutting out points which inside the interval, or which are too close/far away
+  if (filter_limit_negative_)
+    return (!((distance_value < filter_limit_max_) && (distance_value > filter_limit_min_)));
+  return (!((distance_value > filter_limit_max_) || (distance_value < filter_limit_min_)));
+}
 
-      // Single pass covariance calculation
-      leaf.cov_ = (leaf.cov_ - 2 * (pt_sum * leaf.mean_.transpose ())) / leaf.nr_points + leaf.mean_ * leaf.mean_.transpose ();
-      leaf.cov_ *= (leaf.nr_points - 1.0) / leaf.nr_points;
+//////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::VoxelGridCovariance<PointT>::computeLeafCovariance (Leaf &leaf, Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> &eigensolver) const
+{
+  const double nr_points = leaf.nr_accumulated_points_;
+  leaf.nr_points = leaf.nr_accumulated_points_;
+  leaf.cov_ = leaf.scatter_ / nr_points;
+  leaf.cov_ *= (nr_points - 1.0) / nr_points;
 
-      //Normalize Eigen Val such that max no more than 100x min.
-      eigensolver.compute (leaf.cov_);
-      eigen_val = eigensolver.eigenvalues ().asDiagonal ();
-      leaf.evecs_ = eigensolver.eigenvectors ();
+  //Normalize Eigen Val such that max no more than 100x min.
+  eigensolver.compute (leaf.cov_);
+  Eigen::Matrix3d eigen_val = eigensolver.eigenvalues ().asDiagonal ();
+  leaf.evecs_ = eigensolver.eigenvectors ();
 
-      if (eigen_val (0, 0) < 0 || eigen_val (1, 1) < 0 || eigen_val (2, 2) <= 0)
-      {
-        leaf.nr_points = -1;
-        continue;
-      }
+  if (eigen_val (0, 0) < 0 || eigen_val (1, 1) < 0 || eigen_val (2, 2) <= 0)
+  {
+    leaf.nr_points = -1;
+    return;
+  }
 
-      // Avoids matrices near singularities (eq 6.11)[Magnusson 2009]
+  // Avoids matrices near singularities (eq 6.11)[Magnusson 2009]
+  // Eigen values less than a threshold of max eigen value are inflated to a set fraction of the max eigen value.
+  const double min_covar_eigvalue = min_covar_eigvalue_mult_ * eigen_val (2, 2);
+  if (eigen_val (0, 0) < min_covar_eigvalue)
+  {
+    eigen_val (0, 0) = min_covar_eigvalue;
 
-      min_covar_eigvalue = min_covar_eigvalue_mult_ * eigen_val (2, 2);
-      if (eigen_val (0, 0) < min_covar_eigvalue)
-      {
-        eigen_val (0, 0) = min_covar_eigvalue;
+    if (eigen_val (1, 1) < min_covar_eigvalue)
+    {
+      eigen_val (1, 1) = min_covar_eigvalue;
+    }
 
-        if (eigen_val (1, 1) < min_covar_eigvalue)
-        {
-          eigen_val (1, 1) = min_covar_eigvalue;
-        }
+    leaf.cov_ = leaf.evecs_ * eigen_val * leaf.evecs_.inverse ();
+  }
+  leaf.evals_ = eigen_val.diagonal ();
 
-        leaf.cov_ = leaf.evecs_ * eigen_val * leaf.evecs_.inverse ();
-      }
-      leaf.evals_ = eigen_val.diagonal ();
+  leaf.icov_ = leaf.cov_.inverse ();
+  if (leaf.icov_.maxCoeff () == std::numeric_limits<float>::infinity ( )
+      || leaf.icov_.minCoeff () == -std::numeric_limits<float>::infinity ( ) )
+  {
+    leaf.nr_points = -1;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::VoxelGridCovariance<PointT>::updateCentroids (PointCloud &output)
+{
+  output.height = 1;                          // downsampling breaks the organized structure
+  output.is_dense = true;                     // we filter out invalid points
+  output.points.clear ();
+  voxel_centroids_leaf_indices_.clear ();
+  leaf_centroid_indices_.assign (leaves_.size (), -1);
+  leaf_map_.clear ();
+
+  // The grid bounds cover all the leaves
+  if (!leaves_.empty ())
+  {
+    Eigen::Vector3i min_ijk = leaf_coordinates_[0], max_ijk = leaf_coordinates_[0];
+    for (size_t l = 1; l < leaf_coordinates_.size (); ++l)
+    {
+      min_ijk = min_ijk.cwiseMin (leaf_coordinates_[l]);
+      max_ijk = max_ijk.cwiseMax (leaf_coordinates_[l]);
+    }
+    min_b_ = Eigen::Vector4i (min_ijk[0], min_ijk[1], min_ijk[2], 0);
+    max_b_ = Eigen::Vector4i (max_ijk[0], max_ijk[1], max_ijk[2], 0);
+    div_b_ = max_b_ - min_b_ + Eigen::Vector4i::Ones ();
+    div_b_[3] = 0;
+    divb_mul_ = Eigen::Vector4i (1, div_b_[0], div_b_[0] * div_b_[1], 0);
+  }
+  if (save_leaf_layout_)
+    leaf_layout_.assign (div_b_[0] * div_b_[1] * div_b_[2], -1);
 
-      leaf.icov_ = leaf.cov_.inverse ();
-      if (leaf.icov_.maxCoeff () == std::numeric_limits<float>::infinity ( )
-          || leaf.icov_.minCoeff () == -std::numeric_limits<float>::infinity ( ) )
+  int rgba_index = -1;
+  const int centroid_size = getCentroidSize (rgba_index);
+
+  // If the voxel contains sufficient points, it is added to the voxel centroids and output clouds.
+  output.points.reserve (leaves_.size ());
+  for (size_t l = 0; l < leaves_.size (); ++l)
+  {
+    const Leaf &leaf = leaves_[l];
+    if (leaf.nr_accumulated_points_ < min_points_per_voxel_)
+      continue;
+
+    const int cp = static_cast<int> (output.points.size ());
+    if (save_leaf_layout_)
+    {
+      const Eigen::Vector4i ijk (leaf_coordinates_[l][0], leaf_coordinates_[l][1], leaf_coordinates_[l][2], 0);
+      leaf_layout_[(ijk - min_b_).dot (divb_mul_)] = cp;
+    }
+
+    output.push_back (PointT ());
+
+    // Do we need to process all the fields?
+    if (!downsample_all_data_)
+    {
+      output.points.back ().x = leaf.centroid[0];
+      output.points.back ().y = leaf.centroid[1];
+      output.points.back ().z = leaf.centroid[2];
+    }
+    else
+    {
+      pcl::for_each_type<FieldList> (pcl::NdCopyEigenPointFunctor<PointT> (leaf.centroid, output.back ()));
+      // ---[ RGB special case
+      if (rgba_index >= 0)
       {
-        leaf.nr_points = -1;
+        // pack r/g/b into rgb
+        float r = leaf.centroid[centroid_size - 3], g = leaf.centroid[centroid_size - 2], b = leaf.centroid[centroid_size - 1];
+        int rgb = (static_cast<int> (r)) << 16 | (static_cast<int> (g)) << 8 | (static_cast<int> (b));
+        memcpy (reinterpret_cast<char*> (&output.points.back ()) + rgba_index, &rgb, sizeof (float));
       }
-
     }
+
+    // Stores the voxel indice for fast access searching
+    voxel_centroids_leaf_indices_.push_back (static_cast<int> (l));
+    leaf_centroid_indices_[l] = cp;
   }
 
   output.width = static_cast<uint32_t> (output.points.size ());
 }
 
+//////////////////////////////////////////////////////////////////////////
+template<typename PointT> const boost::unordered_map<size_t, typename pcl::VoxelGridCovariance<PointT>::Leaf>&
+pcl::VoxelGridCovariance<PointT>::getLeaves ()
+{
+  if (leaf_map_.empty ())
+  {
+    for (size_t l = 0; l < leaves_.size (); ++l)
+    {
+      const Eigen::Vector4i ijk (leaf_coordinates_[l][0], leaf_coordinates_[l][1], leaf_coordinates_[l][2], 0);
+      leaf_map_[(ijk - min_b_).dot (divb_mul_)] = leaves_[l];
+    }
+  }
+  return (leaf_map_);
+}
+
 //////////////////////////////////////////////////////////////////////////
 template<typename PointT> int
 pcl::VoxelGridCovariance<PointT>::getNeighborhoodAtPoint (const PointT& reference_point, std::vector<LeafConstPtr> &neighbors)
 {
-  neighbors.clear ();
+  // Check each neighbor to see if it is occupied and contains sufficient points
+  return (getNeighborhoodAtPoint (pcl::getAllNeighborCellIndices (), reference_point, neighbors));
+}
 
-  // Find displacement coordinates
-  Eigen::MatrixXi relative_coordinates = pcl::getAllNeighborCellIndices ();
-  Eigen::Vector4i ijk (static_cast<int> (floor (reference_point.x / leaf_size_[0])), 
-                       static_cast<int> (floor (reference_point.y / leaf_size_[1])), 
-                       static_cast<int> (floor (reference_point.z / leaf_size_[2])), 0);
-  Eigen::Array4i diff2min = min_b_ - ijk;
-  Eigen::Array4i diff2max = max_b_ - ijk;
+//////////////////////////////////////////////////////////////////////////
+template<typename PointT> int
+pcl::VoxelGridCovariance<PointT>::getNeighborhoodAtPoint (const Eigen::MatrixXi &relative_coordinates,
+                                                          const PointT& reference_point,
+                                                          std::vector<LeafConstPtr> &neighbors) const
+{
+  neighbors.clear ();
   neighbors.reserve (relative_coordinates.cols ());
 
-  // Check each neighbor to see if it is occupied and contains sufficient points
-  // Slower than radius search because needs to check 26 indices
+  const Eigen::Vector3i ijk = getVoxelCoordinates (reference_point.x, reference_point.y, reference_point.z);
   for (int ni = 0; ni < relative_coordinates.cols (); ni++)
   {
-    Eigen::Vector4i displacement = (Eigen::Vector4i () << relative_coordinates.col (ni), 0).finished ();
-    // Checking if the specified cell is in the grid
-    if ((diff2min <= displacement.array ()).all () && (diff2max >= displacement.array ()).all ())
+    const int l = findLeafIndex (ijk + Eigen::Vector3i (relative_coordinates.col (ni)));
+    if (l >= 0 && leaves_[l].nr_points >= min_points_per_voxel_)
+      neighbors.push_back (&leaves_[l]);
+  }
+
+  return (static_cast<int> (neighbors.size ()));
+}
+
+//////////////////////////////////////////////////////////////////////////
+template<typename PointT> int
+pcl::VoxelGridCovariance<PointT>::getNeighborhoodAtPoint7 (const PointT& reference_point, std::vector<LeafConstPtr> &neighbors) const
+{
+  Eigen::MatrixXi relative_coordinates = Eigen::MatrixXi::Zero (3, 7);
+  for (int d = 0; d < 3; ++d)
+  {
+    relative_coordinates (d, 1 + 2 * d) = -1;
+    relative_coordinates (d, 2 + 2 * d) = 1;
+  }
+  return (getNeighborhoodAtPoint (relative_coordinates, reference_point, neighbors));
+}
+
+//////////////////////////////////////////////////////////////////////////
+template<typename PointT> int
+pcl::VoxelGridCovariance<PointT>::getNeighborhoodAtPoint27 (const PointT& reference_point, std::vector<LeafConstPtr> &neighbors) const
+{
+  Eigen::MatrixXi relative_coordinates (3, 27);
+  relative_coordinates << Eigen::Vector3i::Zero (), pcl::getAllNeighborCellIndices ();
+  return (getNeighborhoodAtPoint (relative_coordinates, reference_point, neighbors));
+}
+
+//////////////////////////////////////////////////////////////////////////
+template<typename PointT> int
+pcl::VoxelGridCovariance<PointT>::radiusSearch (const PointT &point, double radius, std::vector<LeafConstPtr> &k_leaves,
+                                                std::vector<float> &k_sqr_distances, unsigned int max_nn) const
+{
+  k_leaves.clear ();
+  k_sqr_distances.clear ();
+  if (!voxel_centroids_ || voxel_centroids_->empty ())
+    return (0);
+
+  const float r = static_cast<float> (radius);
+  const float sqr_radius = r * r;
+  const Eigen::Vector3i low = getVoxelCoordinates (point.x - r, point.y - r, point.z - r);
+  const Eigen::Vector3i high = getVoxelCoordinates (point.x + r, point.y + r, point.z + r);
+  const Eigen::Array3d extent = (high - low).cast<double> ().array () + 1.0;
+
+  // The centroid of a leaf lies in its voxel, so only the voxels overlapping the bounding box of the sphere are
+  // checked, unless there are more of them than centroids
+  std::vector<std::pair<float, int> > found;
+  if (extent.prod () > static_cast<double> (voxel_centroids_->size ()))
+  {
+    for (size_t c = 0; c < voxel_centroids_->size (); ++c)
     {
-      typename boost::unordered_map<size_t, Leaf>::iterator leaf_iter = leaves_.find (((ijk + displacement - min_b_).dot (divb_mul_)));
-      if (leaf_iter != leaves_.end () && leaf_iter->second.nr_points >= min_points_per_voxel_)
-      {
-        LeafConstPtr leaf = &(leaf_iter->second);
-        neighbors.push_back (leaf);
-      }
+      const float sqr_distance = (voxel_centroids_->points[c].getVector3fMap () - point.getVector3fMap ()).squaredNorm ();
+      if (sqr_distance <= sqr_radius)
+        found.push_back (std::make_pair (sqr_distance, static_cast<int> (c)));
     }
   }
+  else
+  {
+    Eigen::Vector3i ijk;
+    for (ijk[2] = low[2]; ijk[2] <= high[2]; ++ijk[2])
+      for (ijk[1] = low[1]; ijk[1] <= high[1]; ++ijk[1])
+        for (ijk[0] = low[0]; ijk[0] <= high[0]; ++ijk[0])
+        {
+          const int l = findLeafIndex (ijk);
+          if (l < 0 || leaf_centroid_indices_[l] < 0)
+            continue;
+          const int c = leaf_centroid_indices_[l];
+          const float sqr_distance = (voxel_centroids_->points[c].getVector3fMap () - point.getVector3fMap ()).squaredNorm ();
+          if (sqr_distance <= sqr_radius)
+            found.push_back (std::make_pair (sqr_distance, c));
+        }
+  }
 
-  return (static_cast<int> (neighbors.size ()));
+  std::sort (found.begin (), found.end ());
+  if (max_nn > 0 && found.size () > max_nn)
+    found.resize (max_nn);
+
+  k_leaves.resize (found.size ());
+  k_sqr_distances.resize (found.size ());
+  for (size_t i = 0; i < found.size (); ++i)
+  {
+    k_leaves[i] = &leaves_[voxel_centroids_leaf_indices_[found[i].second]];
+    k_sqr_distances[i] = found[i].first;
+  }
+  return (static_cast<int> (found.size ()));
 }
 
 template<typename PointT> void
@@ -409,9 +633,9 @@ pcl::VoxelGridCovariance<PointT>::getDisplayCloud (pcl::PointCloud<PointXYZ>& ce
   Eigen::Vector3d dist_point;
 
   // Generate points for each occupied voxel with sufficient points.
-  for (typename boost::unordered_map<size_t, Leaf>::iterator it = leaves_.begin (); it != leaves_.end (); ++it)
+  for (size_t l = 0; l < leaves_.size (); ++l)
   {
-    Leaf& leaf = it->second;
+    Leaf& leaf = leaves_[l];
 
     if (leaf.nr_points >= min_points_per_voxel_)
     {
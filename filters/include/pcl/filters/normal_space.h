@@ -39,14 +39,17 @@
 #define PCL_FILTERS_NORMAL_SUBSAMPLE_H_
 
 #include <pcl/filters/filter_indices.h>
+#include <pcl/filters/sampling.h>
 #include <time.h>
 #include <limits.h>
 
-#include <boost/dynamic_bitset.hpp>
-
 namespace pcl
 {
   /** \brief @b NormalSpaceSampling samples the input point cloud in the space of normal directions computed at every point.
+    * The points are binned by the direction cosines of their normals, and the bins are visited in turns: every turn
+    * takes one more random point from every bin which has points left, until the sample is complete. Points with
+    * invalid normals are never sampled. The resulting indices are sorted, and only depend on the seed, not on the
+    * number of threads, see sampleStrata ().
     * \ingroup filters
     */
   template<typename PointT, typename NormalT>
@@ -65,7 +68,8 @@ namespace pcl
     public:
       /** \brief Empty constructor. */
       NormalSpaceSampling () : 
-        sample_ (UINT_MAX), seed_ (static_cast<unsigned int> (time (NULL))), binsx_ (), binsy_ (), binsz_ (), input_normals_ ()
+        sample_ (UINT_MAX), seed_ (static_cast<unsigned int> (time (NULL))), binsx_ (), binsy_ (), binsz_ (), input_normals_ (),
+        threads_ (1)
       {
         filter_name_ = "NormalSpaceSampling";
       }
@@ -138,6 +142,15 @@ namespace pcl
       inline NormalsPtr
       getNormals () const { return (input_normals_); }
 
+      /** \brief Initialize the scheduler and set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to 1)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 1)
+      {
+        threads_ = nr_threads == 0 ? 1 : nr_threads;
+      }
+
     protected:
       /** \brief Number of indices that will be returned. */
       unsigned int sample_;
@@ -154,6 +167,9 @@ namespace pcl
       /** \brief The normals computed at each point in the input cloud */
       NormalsPtr input_normals_; 
 
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
       /** \brief Sample of point indices into a separate PointCloud
         * \param[out] output the resultant point cloud
         */
@@ -168,20 +184,10 @@ namespace pcl
 
     private:
       /** \brief Finds the bin number of the input normal, returns the bin number
-        * \param[in] normal the input normal 
-        * \param[in] nbins total number of bins
+        * \param[in] normal the input normal
         */
-      unsigned int 
-      findBin (float *normal, unsigned int nbins);
-
-      /** \brief Checks of the entire bin is sampled, returns true or false
-        * \param[out] array flag which says whether a point is sampled or not
-        * \param[in] start_index the index to the first point of the bin in array.
-        * \param[in] length number of points in the bin
-        */
-      bool
-      isEntireBinSampled (boost::dynamic_bitset<> &array, unsigned int start_index, unsigned int length);
-
+      unsigned int
+      findBin (const float *normal) const;
   };
 }
 #endif  //#ifndef PCL_FILTERS_NORMAL_SPACE_SUBSAMPLE_H_
@@ -70,9 +70,15 @@ namespace pcl
     typedef typename PointCloud::ConstPtr PointCloudConstPtr;
 
     public:
+      typedef std::vector<std::vector<int> > Neighbors;
+      typedef boost::shared_ptr<const Neighbors> NeighborsConstPtr;
+      typedef std::vector<std::vector<float> > Distances;
+      typedef boost::shared_ptr<const Distances> DistancesConstPtr;
+
       /** \brief Empty constructor. */
       RadiusOutlierRemoval (bool extract_removed_indices = false) :
-        Filter<PointT>::Filter (extract_removed_indices), search_radius_ (0.0), min_pts_radius_ (1), tree_ ()
+        Filter<PointT>::Filter (extract_removed_indices), search_radius_ (0.0), min_pts_radius_ (1), tree_ (),
+        input_neighbors_ (), input_sqr_distances_ ()
       {
         filter_name_ = "RadiusOutlierRemoval";
       }
@@ -113,6 +119,21 @@ namespace pcl
         return (min_pts_radius_);
       }
 
+      /** \brief Provide a precomputed k nearest neighbor graph, e.g. from StatisticalOutlierRemoval::getNeighbors ().
+        * The graph has one entry per point of the input indices, in the same order, holding the neighbors as
+        * returned by nearestKSearch (): sorted by distance, starting with the point itself. A point with at least
+        * \a min_pts_radius_ precomputed neighbors is tested with them instead of a radius search. Set to null
+        * pointers to search all the neighbors again.
+        * \param[in] neighbors the indices of the neighbors of every point (not used, may be a null pointer)
+        * \param[in] sqr_distances the squared distances to the neighbors of every point
+        */
+      inline void
+      setNeighbors (const NeighborsConstPtr &neighbors, const DistancesConstPtr &sqr_distances)
+      {
+        input_neighbors_ = neighbors;
+        input_sqr_distances_ = sqr_distances;
+      }
+
     protected:
       /** \brief The nearest neighbors search radius for each point. */
       double search_radius_;
@@ -125,11 +146,26 @@ namespace pcl
       /** \brief A pointer to the spatial search object. */
       KdTreePtr tree_;
 
+      /** \brief The precomputed neighbor indices set by the user. */
+      NeighborsConstPtr input_neighbors_;
+
+      /** \brief The squared distances of the precomputed neighbors set by the user. */
+      DistancesConstPtr input_sqr_distances_;
+
       /** \brief Apply the filter
         * \param output the resultant point cloud message
         */
       void
       applyFilter (PointCloud &output);
+
+      /** \brief Check if a point has at least \a min_pts_radius_ neighbors inside the search radius.
+        * \param[in] cp the position of the point in the input indices
+        * \param[in] use_input_neighbors true if the precomputed neighbors should be used when there are enough
+        * \param[out] nn_indices buffer for the indices of the neighbors found by a radius search
+        * \param[out] nn_dists buffer for the squared distances of the neighbors found by a radius search
+        */
+      bool
+      hasEnoughNeighbors (int cp, bool use_input_neighbors, std::vector<int> &nn_indices, std::vector<float> &nn_dists);
   };
 
   //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -156,10 +192,15 @@ namespace pcl
     typedef PointCloud2::ConstPtr PointCloud2ConstPtr;
 
     public:
+      typedef std::vector<std::vector<int> > Neighbors;
+      typedef boost::shared_ptr<const Neighbors> NeighborsConstPtr;
+      typedef std::vector<std::vector<float> > Distances;
+      typedef boost::shared_ptr<const Distances> DistancesConstPtr;
+
       /** \brief Empty constructor. */
       RadiusOutlierRemoval (bool extract_removed_indices = false) :
         Filter<sensor_msgs::PointCloud2>::Filter (extract_removed_indices), 
-        search_radius_ (0.0), min_pts_radius_ (1), tree_ ()
+        search_radius_ (0.0), min_pts_radius_ (1), tree_ (), input_neighbors_ (), input_sqr_distances_ ()
       {
         filter_name_ = "RadiusOutlierRemoval";
       }
@@ -199,6 +240,21 @@ namespace pcl
         return (min_pts_radius_);
       }
 
+      /** \brief Provide a precomputed k nearest neighbor graph, e.g. from StatisticalOutlierRemoval::getNeighbors ().
+        * The graph has one entry per point of the input indices, in the same order, holding the neighbors as
+        * returned by nearestKSearch (): sorted by distance, starting with the point itself. A point with at least
+        * \a min_pts_radius_ precomputed neighbors is tested with them instead of a radius search. Set to null
+        * pointers to search all the neighbors again.
+        * \param[in] neighbors the indices of the neighbors of every point (not used, may be a null pointer)
+        * \param[in] sqr_distances the squared distances to the neighbors of every point
+        */
+      inline void
+      setNeighbors (const NeighborsConstPtr &neighbors, const DistancesConstPtr &sqr_distances)
+      {
+        input_neighbors_ = neighbors;
+        input_sqr_distances_ = sqr_distances;
+      }
+
     protected:
       /** \brief The nearest neighbors search radius for each point. */
       double search_radius_;
@@ -211,8 +267,23 @@ namespace pcl
       /** \brief A pointer to the spatial search object. */
       KdTreePtr tree_;
 
+      /** \brief The precomputed neighbor indices set by the user. */
+      NeighborsConstPtr input_neighbors_;
+
+      /** \brief The squared distances of the precomputed neighbors set by the user. */
+      DistancesConstPtr input_sqr_distances_;
+
       void
       applyFilter (PointCloud2 &output);
+
+      /** \brief Check if a point has at least \a min_pts_radius_ neighbors inside the search radius.
+        * \param[in] cp the position of the point in the input indices
+        * \param[in] use_input_neighbors true if the precomputed neighbors should be used when there are enough
+        * \param[out] nn_indices buffer for the indices of the neighbors found by a radius search
+        * \param[out] nn_dists buffer for the squared distances of the neighbors found by a radius search
+        */
+      bool
+      hasEnoughNeighbors (int cp, bool use_input_neighbors, std::vector<int> &nn_indices, std::vector<float> &nn_dists);
   };
 }
 
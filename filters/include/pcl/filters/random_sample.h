@@ -39,34 +39,38 @@
 #define PCL_FILTERS_RANDOM_SUBSAMPLE_H_
 
 #include <pcl/filters/filter_indices.h>
+#include <pcl/filters/sampling.h>
 #include <time.h>
 #include <limits.h>
 
 namespace pcl
 {
   /** \brief @b RandomSample applies a random sampling with uniform probability.
-    * Based off Algorithm A from the paper "Faster Methods for Random Sampling"
-    * by Jeffrey Scott Vitter. The algorithm runs in O(N) and results in sorted
-    * indices
-    * http://www.ittc.ku.edu/~jsv/Papers/Vit84.sampling.pdf
+    * Based off Algorithm D from the paper "An Efficient Algorithm for Sequential
+    * Random Sampling" by Jeffrey Scott Vitter, see sampleSortedPositions (). The
+    * algorithm runs in O(sample) and results in sorted indices. The sample only
+    * depends on the seed, not on the number of threads.
+    * http://www.ittc.ku.edu/~jsv/Papers/Vit87.RandomSampling.pdf
     * \author Justin Rosen
     * \ingroup filters
     */
   template<typename PointT>
   class RandomSample : public FilterIndices<PointT>
   {
-    using FilterIndices<PointT>::filter_name_;
-    using FilterIndices<PointT>::getClassName;
-    using FilterIndices<PointT>::indices_;
-    using FilterIndices<PointT>::input_;
+    protected:
+      using FilterIndices<PointT>::filter_name_;
+      using FilterIndices<PointT>::getClassName;
+      using FilterIndices<PointT>::indices_;
+      using FilterIndices<PointT>::input_;
+      using FilterIndices<PointT>::fake_indices_;
 
-    typedef typename FilterIndices<PointT>::PointCloud PointCloud;
-    typedef typename PointCloud::Ptr PointCloudPtr;
-    typedef typename PointCloud::ConstPtr PointCloudConstPtr;
+      typedef typename FilterIndices<PointT>::PointCloud PointCloud;
+      typedef typename PointCloud::Ptr PointCloudPtr;
+      typedef typename PointCloud::ConstPtr PointCloudConstPtr;
 
     public:
       /** \brief Empty constructor. */
-      RandomSample () : sample_ (UINT_MAX), seed_ (static_cast<unsigned int> (time (NULL)))
+      RandomSample () : sample_ (UINT_MAX), seed_ (static_cast<unsigned int> (time (NULL))), threads_ (1)
       {
         filter_name_ = "RandomSample";
       }
@@ -105,12 +109,23 @@ namespace pcl
         return (seed_);
       }
 
+      /** \brief Initialize the scheduler and set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to 1)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 1)
+      {
+        threads_ = nr_threads == 0 ? 1 : nr_threads;
+      }
+
     protected:
 
       /** \brief Number of indices that will be returned. */
       unsigned int sample_;
       /** \brief Random number seed. */
       unsigned int seed_;
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
 
       /** \brief Sample of point indices into a separate PointCloud
         * \param output the resultant point cloud
@@ -123,16 +138,62 @@ namespace pcl
         */
       void
       applyFilter (std::vector<int> &indices);
+  };
+
+  /** \brief @b StratifiedRandomSample applies a random sampling stratified over the voxels of a grid: the voxels
+    * are visited in turns, and every turn takes one more random point from every voxel which has points left,
+    * until the sample is complete. Sparse regions of the cloud are thus kept while dense regions are thinned out.
+    * Points with non-finite coordinates are never sampled. The resulting indices are sorted, and only depend on the
+    * seed, not on the number of threads, see sampleStrata ().
+    * \ingroup filters
+    */
+  template<typename PointT>
+  class StratifiedRandomSample : public RandomSample<PointT>
+  {
+    using RandomSample<PointT>::filter_name_;
+    using RandomSample<PointT>::getClassName;
+    using RandomSample<PointT>::indices_;
+    using RandomSample<PointT>::input_;
+    using RandomSample<PointT>::sample_;
+    using RandomSample<PointT>::seed_;
+    using RandomSample<PointT>::threads_;
+
+    typedef typename RandomSample<PointT>::PointCloud PointCloud;
+
+    public:
+      /** \brief Empty constructor. */
+      StratifiedRandomSample () : leaf_size_ (Eigen::Vector3f::Ones ())
+      {
+        filter_name_ = "StratifiedRandomSample";
+      }
 
-      /** \brief Return a random number fast using a LCG (Linear Congruential Generator) algorithm.
-        * See http://software.intel.com/en-us/articles/fast-random-number-generator-on-the-intel-pentiumr-4-processor/ for more information.
+      /** \brief Set the voxel grid leaf size.
+        * \param[in] lx the leaf size for X
+        * \param[in] ly the leaf size for Y
+        * \param[in] lz the leaf size for Z
         */
-      inline float
-      unifRand ()
+      inline void
+      setLeafSize (float lx, float ly, float lz)
       {
-        return (static_cast<float>(rand () / double (RAND_MAX)));
-        //return (((214013 * seed_ + 2531011) >> 16) & 0x7FFF);
+        leaf_size_ = Eigen::Vector3f (lx, ly, lz);
       }
+
+      /** \brief Get the voxel grid leaf size. */
+      inline Eigen::Vector3f
+      getLeafSize () const { return (leaf_size_); }
+
+    protected:
+      /** \brief The size of a leaf. */
+      Eigen::Vector3f leaf_size_;
+
+      /** \brief Sample of point indices
+        * \param indices the resultant point cloud indices
+        */
+      void
+      applyFilter (std::vector<int> &indices);
+
+    public:
+      EIGEN_MAKE_ALIGNED_OPERATOR_NEW
   };
 
   /** \brief @b RandomSample applies a random sampling with uniform probability.
@@ -144,6 +205,9 @@ namespace pcl
   {
     using FilterIndices<sensor_msgs::PointCloud2>::filter_name_;
     using FilterIndices<sensor_msgs::PointCloud2>::getClassName;
+    using FilterIndices<sensor_msgs::PointCloud2>::indices_;
+    using FilterIndices<sensor_msgs::PointCloud2>::input_;
+    using FilterIndices<sensor_msgs::PointCloud2>::fake_indices_;
 
     typedef sensor_msgs::PointCloud2 PointCloud2;
     typedef PointCloud2::Ptr PointCloud2Ptr;
@@ -151,7 +215,7 @@ namespace pcl
 
     public:
       /** \brief Empty constructor. */
-      RandomSample () : sample_ (UINT_MAX), seed_ (static_cast<unsigned int> (time (NULL)))
+      RandomSample () : sample_ (UINT_MAX), seed_ (static_cast<unsigned int> (time (NULL))), threads_ (1)
       {
         filter_name_ = "RandomSample";
       }
@@ -190,12 +254,23 @@ namespace pcl
         return (seed_);
       }
 
+      /** \brief Initialize the scheduler and set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to 1)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 1)
+      {
+        threads_ = nr_threads == 0 ? 1 : nr_threads;
+      }
+
     protected:
 
       /** \brief Number of indices that will be returned. */
       unsigned int sample_;
       /** \brief Random number seed. */
       unsigned int seed_;
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
 
       /** \brief Sample of point indices into a separate PointCloud
         * \param output the resultant point cloud
@@ -208,16 +283,6 @@ namespace pcl
         */
       void
       applyFilter (std::vector<int> &indices);
-
-      /** \brief Return a random number fast using a LCG (Linear Congruential Generator) algorithm.
-        * See http://software.intel.com/en-us/articles/fast-random-number-generator-on-the-intel-pentiumr-4-processor/ for more information.
-        */
-      inline float
-      unifRand ()
-      {
-        return (static_cast<float> (rand () / double (RAND_MAX)));
-        //return (((214013 * seed_ + 2531011) >> 16) & 0x7FFF);
-      }
    };
 }
 
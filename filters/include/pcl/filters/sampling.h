@@ -0,0 +1,127 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FILTERS_SAMPLING_H_
+#define PCL_FILTERS_SAMPLING_H_
+
+#include <pcl/pcl_macros.h>
+#include <vector>
+
+namespace pcl
+{
+  /** \brief Small, fast random number generator for the sampling filters, based on the SplitMix64 sequence.
+    * Every (seed, stream) pair gives an independent sequence, so that work split into streams is reproducible
+    * no matter which thread processes it.
+    * \ingroup filters
+    */
+  class SampleGenerator
+  {
+    public:
+      /** \brief Constructor.
+        * \param[in] seed the random seed
+        * \param[in] stream the index of the sequence
+        */
+      SampleGenerator (unsigned int seed, uint64_t stream = 0) :
+        state_ (mix (static_cast<uint64_t> (seed) * 0x9E3779B97F4A7C15ULL + stream))
+      {}
+
+      /** \brief Get the next 64 random bits. */
+      inline uint64_t
+      next ()
+      {
+        state_ += 0x9E3779B97F4A7C15ULL;
+        return (mix (state_));
+      }
+
+      /** \brief Get a random number uniformly distributed in the open interval (0, 1). */
+      inline double
+      nextUniform ()
+      {
+        return ((static_cast<double> (next () >> 11) + 0.5) * (1.0 / 9007199254740992.0));
+      }
+
+    private:
+      /** \brief The SplitMix64 finalizer. */
+      static inline uint64_t
+      mix (uint64_t z)
+      {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return (z ^ (z >> 31));
+      }
+
+      /** \brief The state of the sequence. */
+      uint64_t state_;
+  };
+
+  /** \brief Draw a uniform random sample of distinct positions from 0 .. nr_population - 1, in ascending order.
+    * The skips between consecutive positions are generated with Algorithm D from "An Efficient Algorithm for
+    * Sequential Random Sampling" by Jeffrey Scott Vitter, so the expected running time is O(nr_samples) and the
+    * population is never touched. Large samples are split into blocks of the population whose sample sizes are
+    * drawn from the hypergeometric distribution, and the blocks are sampled in parallel. The number of blocks only
+    * depends on the sample size, so the result only depends on the seed.
+    * \param[in] nr_population the size of the population
+    * \param[in] nr_samples the number of positions to draw, at most nr_population
+    * \param[in] seed the random seed
+    * \param[out] positions the sampled positions
+    * \param[in] nr_threads the number of threads to use
+    * \ingroup filters
+    */
+  PCL_EXPORTS void
+  sampleSortedPositions (int nr_population, int nr_samples, unsigned int seed, std::vector<int> &positions,
+                         unsigned int nr_threads = 1);
+
+  /** \brief Draw a stratified random sample: the strata are visited in turns, and every turn takes one more random
+    * position from every stratum which is not exhausted, until \a nr_samples positions are taken. The number of
+    * positions of every stratum is computed upfront, then the strata are sampled in parallel, each with a single
+    * pass of Vitter's Algorithm D as in one block of sampleSortedPositions (). Stratum s draws from its own
+    * sequence SampleGenerator (seed, s), so the result only depends on the seed.
+    * \param[in] stratum_begin the first position of every stratum, followed by the total number of positions
+    * \param[in] nr_samples the number of positions to draw
+    * \param[in] seed the random seed
+    * \param[out] positions the sampled positions, ascending within every stratum
+    * \param[in] nr_threads the number of threads to use
+    * \ingroup filters
+    */
+  PCL_EXPORTS void
+  sampleStrata (const std::vector<int> &stratum_begin, int nr_samples, unsigned int seed,
+                std::vector<int> &positions, unsigned int nr_threads = 1);
+}
+
+#endif  //#ifndef PCL_FILTERS_SAMPLING_H_
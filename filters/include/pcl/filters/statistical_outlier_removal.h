@@ -74,9 +74,18 @@ namespace pcl
     typedef typename PointCloud::ConstPtr PointCloudConstPtr;
 
     public:
+      typedef std::vector<std::vector<int> > Neighbors;
+      typedef boost::shared_ptr<Neighbors> NeighborsPtr;
+      typedef boost::shared_ptr<const Neighbors> NeighborsConstPtr;
+      typedef std::vector<std::vector<float> > Distances;
+      typedef boost::shared_ptr<Distances> DistancesPtr;
+      typedef boost::shared_ptr<const Distances> DistancesConstPtr;
+
       /** \brief Empty constructor. */
       StatisticalOutlierRemoval (bool extract_removed_indices = false) :
-        Filter<PointT>::Filter (extract_removed_indices), mean_k_ (2), std_mul_ (0.0), tree_ (), negative_ (false)
+        Filter<PointT>::Filter (extract_removed_indices), mean_k_ (2), std_mul_ (0.0), tree_ (), negative_ (false),
+        threads_ (1), input_neighbors_ (), input_sqr_distances_ (), save_neighbors_ (false), neighbors_ (),
+        sqr_distances_ (), mean_distances_ ()
       {
         filter_name_ = "StatisticalOutlierRemoval";
       }
@@ -134,6 +143,74 @@ namespace pcl
         return (negative_);
       }
 
+      /** \brief Initialize the scheduler and set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        threads_ = (nr_threads == 0) ? 1 : nr_threads;
+      }
+
+      /** \brief Provide a precomputed k nearest neighbor graph, which is used instead of searching the neighbors
+        * of the points. The graph has one entry per point of the input indices, in the same order, holding the
+        * neighbors as returned by nearestKSearch (): sorted by distance, starting with the point itself. Only the
+        * first \a mean_k_ neighbors of every point are used. Set to null pointers to search the neighbors again.
+        * \param[in] neighbors the indices of the neighbors of every point (not used, may be a null pointer)
+        * \param[in] sqr_distances the squared distances to the neighbors of every point
+        */
+      inline void
+      setNeighbors (const NeighborsConstPtr &neighbors, const DistancesConstPtr &sqr_distances)
+      {
+        input_neighbors_ = neighbors;
+        input_sqr_distances_ = sqr_distances;
+      }
+
+      /** \brief Set to true if the k nearest neighbor graph searched by filter () should be saved, so that it can
+        * be reused by other steps of a pipeline, e.g. by RadiusOutlierRemoval::setNeighbors (), or by normal
+        * estimation through NeighborhoodCache::setNeighborhoods ().
+        * \param[in] save_neighbors the new value (true/false)
+        */
+      inline void
+      setSaveNeighbors (bool save_neighbors)
+      {
+        save_neighbors_ = save_neighbors;
+      }
+
+      /** \brief Returns true if the k nearest neighbor graph searched by filter () is saved. */
+      inline bool
+      getSaveNeighbors ()
+      {
+        return (save_neighbors_);
+      }
+
+      /** \brief Get the indices of the k nearest neighbors of every input point, searched by the last call to
+        * filter () if setSaveNeighbors () is enabled.
+        */
+      inline NeighborsPtr
+      getNeighbors ()
+      {
+        return (neighbors_);
+      }
+
+      /** \brief Get the squared distances to the k nearest neighbors of every input point, searched by the last
+        * call to filter () if setSaveNeighbors () is enabled.
+        */
+      inline DistancesPtr
+      getNeighborSqrDistances ()
+      {
+        return (sqr_distances_);
+      }
+
+      /** \brief Get the mean distance of every input point to its k nearest neighbors, as computed by the last
+        * call to filter (). The distances are stored in the order of the input indices, with 0 for invalid points.
+        */
+      inline const std::vector<float>&
+      getMeanDistances ()
+      {
+        return (mean_distances_);
+      }
+
     protected:
       /** \brief The number of points to use for mean distance estimation. */
       int mean_k_;
@@ -148,6 +225,27 @@ namespace pcl
       /** \brief If true, the outliers will be returned instead of the inliers (default: false). */
       bool negative_;
 
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
+      /** \brief The precomputed neighbor indices set by the user. */
+      NeighborsConstPtr input_neighbors_;
+
+      /** \brief The squared distances of the precomputed neighbors set by the user. */
+      DistancesConstPtr input_sqr_distances_;
+
+      /** \brief Set to true if the searched neighbors are saved in \a neighbors_ and \a sqr_distances_. */
+      bool save_neighbors_;
+
+      /** \brief The neighbor indices searched by the last call to filter (). */
+      NeighborsPtr neighbors_;
+
+      /** \brief The squared distances of the neighbors searched by the last call to filter (). */
+      DistancesPtr sqr_distances_;
+
+      /** \brief The mean distance of every input point to its k nearest neighbors. */
+      std::vector<float> mean_distances_;
+
       /** \brief Apply the filter
         * \param output the resultant point cloud message
         */
@@ -182,10 +280,18 @@ namespace pcl
     typedef PointCloud2::ConstPtr PointCloud2ConstPtr;
 
     public:
+      typedef std::vector<std::vector<int> > Neighbors;
+      typedef boost::shared_ptr<Neighbors> NeighborsPtr;
+      typedef boost::shared_ptr<const Neighbors> NeighborsConstPtr;
+      typedef std::vector<std::vector<float> > Distances;
+      typedef boost::shared_ptr<Distances> DistancesPtr;
+      typedef boost::shared_ptr<const Distances> DistancesConstPtr;
+
       /** \brief Empty constructor. */
       StatisticalOutlierRemoval (bool extract_removed_indices = false) :
         Filter<sensor_msgs::PointCloud2>::Filter (extract_removed_indices), mean_k_ (2), 
-        std_mul_ (0.0), tree_ (), negative_ (false)
+        std_mul_ (0.0), tree_ (), negative_ (false), threads_ (1), input_neighbors_ (), input_sqr_distances_ (),
+        save_neighbors_ (false), neighbors_ (), sqr_distances_ (), mean_distances_ ()
       {
         filter_name_ = "StatisticalOutlierRemoval";
       }
@@ -244,6 +350,73 @@ namespace pcl
         return (negative_);
       }
 
+      /** \brief Initialize the scheduler and set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        threads_ = (nr_threads == 0) ? 1 : nr_threads;
+      }
+
+      /** \brief Provide a precomputed k nearest neighbor graph, which is used instead of searching the neighbors
+        * of the points. The graph has one entry per point of the input indices, in the same order, holding the
+        * neighbors as returned by nearestKSearch (): sorted by distance, starting with the point itself. Only the
+        * first \a mean_k_ neighbors of every point are used. Set to null pointers to search the neighbors again.
+        * \param[in] neighbors the indices of the neighbors of every point (not used, may be a null pointer)
+        * \param[in] sqr_distances the squared distances to the neighbors of every point
+        */
+      inline void
+      setNeighbors (const NeighborsConstPtr &neighbors, const DistancesConstPtr &sqr_distances)
+      {
+        input_neighbors_ = neighbors;
+        input_sqr_distances_ = sqr_distances;
+      }
+
+      /** \brief Set to true if the k nearest neighbor graph searched by filter () should be saved, so that it can
+        * be reused by other steps of a pipeline, e.g. by RadiusOutlierRemoval::setNeighbors ().
+        * \param[in] save_neighbors the new value (true/false)
+        */
+      inline void
+      setSaveNeighbors (bool save_neighbors)
+      {
+        save_neighbors_ = save_neighbors;
+      }
+
+      /** \brief Returns true if the k nearest neighbor graph searched by filter () is saved. */
+      inline bool
+      getSaveNeighbors ()
+      {
+        return (save_neighbors_);
+      }
+
+      /** \brief Get the indices of the k nearest neighbors of every input point, searched by the last call to
+        * filter () if setSaveNeighbors () is enabled.
+        */
+      inline NeighborsPtr
+      getNeighbors ()
+      {
+        return (neighbors_);
+      }
+
+      /** \brief Get the squared distances to the k nearest neighbors of every input point, searched by the last
+        * call to filter () if setSaveNeighbors () is enabled.
+        */
+      inline DistancesPtr
+      getNeighborSqrDistances ()
+      {
+        return (sqr_distances_);
+      }
+
+      /** \brief Get the mean distance of every input point to its k nearest neighbors, as computed by the last
+        * call to filter (). The distances are stored in the order of the input indices, with 0 for invalid points.
+        */
+      inline const std::vector<float>&
+      getMeanDistances ()
+      {
+        return (mean_distances_);
+      }
+
     protected:
       /** \brief The number of points to use for mean distance estimation. */
       int mean_k_;
@@ -259,6 +432,27 @@ namespace pcl
       /** \brief If true, the outliers will be returned instead of the inliers (default: false). */
       bool negative_;
 
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
+      /** \brief The precomputed neighbor indices set by the user. */
+      NeighborsConstPtr input_neighbors_;
+
+      /** \brief The squared distances of the precomputed neighbors set by the user. */
+      DistancesConstPtr input_sqr_distances_;
+
+      /** \brief Set to true if the searched neighbors are saved in \a neighbors_ and \a sqr_distances_. */
+      bool save_neighbors_;
+
+      /** \brief The neighbor indices searched by the last call to filter (). */
+      NeighborsPtr neighbors_;
+
+      /** \brief The squared distances of the neighbors searched by the last call to filter (). */
+      DistancesPtr sqr_distances_;
+
+      /** \brief The mean distance of every input point to its k nearest neighbors. */
+      std::vector<float> mean_distances_;
+
       void
       applyFilter (PointCloud2 &output);
   };
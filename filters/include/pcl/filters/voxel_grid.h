@@ -41,6 +41,7 @@
 #define PCL_FILTERS_VOXEL_GRID_MAP_H_
 
 #include <pcl/filters/filter.h>
+#include <pcl/filters/voxel_grid_hash_table.h>
 #include <map>
 #include <boost/unordered_map.hpp>
 #include <boost/fusion/sequence/intrinsic/at_key.hpp>
@@ -78,6 +79,21 @@ namespace pcl
                const std::string &distance_field_name, float min_distance, float max_distance, 
                Eigen::Vector4f &min_pt, Eigen::Vector4f &max_pt, bool limit_negative = false);
 
+  /** \brief Sort the voxel keys of the points of a cloud and find the points of every occupied voxel. The keys are
+    * sorted with a parallel stable radix sort, so that the points of a voxel keep their input order.
+    * \param[in,out] keys the linear voxel indices of the points, or their voxel indices within an XY layer if
+    * \a layer_keys is not empty. Points to be skipped are marked with std::numeric_limits<uint64_t>::max ().
+    * \param[in,out] layer_keys the Z layer of the voxels of the points, or empty if \a keys are linear voxel indices
+    * \param[in,out] indices the point indices, permuted together with the keys
+    * \param[out] voxel_begin the position of the first sorted point of every voxel, followed by the number of points
+    * which are not skipped
+    * \param[in] nr_threads the number of threads to use
+    * \ingroup filters
+    */
+  PCL_EXPORTS void
+  sortVoxelGridKeys (std::vector<uint64_t> &keys, std::vector<uint64_t> &layer_keys, std::vector<int> &indices,
+                     std::vector<int> &voxel_begin, unsigned int nr_threads = 1);
+
   /** \brief Get the relative cell indices of the "upper half" 13 neighbors.
     * \note Useful in combination with getNeighborCentroidIndices() from \ref VoxelGrid
     * \ingroup filters
@@ -177,6 +193,7 @@ namespace pcl
         inverse_leaf_size_ (Eigen::Array4f::Zero ()),
         downsample_all_data_ (true), 
         save_leaf_layout_ (false),
+        use_hash_table_ (false),
         leaf_layout_ (),
         min_b_ (Eigen::Vector4i::Zero ()),
         max_b_ (Eigen::Vector4i::Zero ()),
@@ -185,7 +202,8 @@ namespace pcl
         filter_field_name_ (""), 
         filter_limit_min_ (-FLT_MAX), 
         filter_limit_max_ (FLT_MAX),
-        filter_limit_negative_ (false)
+        filter_limit_negative_ (false),
+        threads_ (1)
       {
         filter_name_ = "VoxelGrid";
       }
@@ -251,6 +269,20 @@ namespace pcl
       inline bool 
       getSaveLeafLayout () { return (save_leaf_layout_); }
 
+      /** \brief Set to true if the centroids should be accumulated in a hash table of the occupied voxels instead
+        * of sorting the points by voxel. This runs in linear time and needs memory proportional to the number of
+        * occupied voxels instead of the number of points, but the output is not ordered by voxel index: the
+        * centroids appear in the order in which their voxels are first seen. Best suited to grids with many points
+        * per voxel. Ignored if the leaf layout is saved.
+        * \param[in] use_hash_table the new value (true/false)
+        */
+      inline void 
+      setUseHashTable (bool use_hash_table) { use_hash_table_ = use_hash_table; }
+
+      /** \brief Returns true if the centroids are accumulated in a hash table. */
+      inline bool 
+      getUseHashTable () { return (use_hash_table_); }
+
       /** \brief Get the minimum coordinates of the bounding box (after
         * filtering is performed). 
         */
@@ -420,6 +452,15 @@ namespace pcl
         return (filter_limit_negative_);
       }
 
+      /** \brief Initialize the scheduler and set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        threads_ = (nr_threads == 0) ? 1 : nr_threads;
+      }
+
     protected:
       /** \brief The size of a leaf. */
       Eigen::Vector4f leaf_size_;
@@ -433,6 +474,9 @@ namespace pcl
       /** \brief Set to true if leaf layout information needs to be saved in \a leaf_layout_. */
       bool save_leaf_layout_;
 
+      /** \brief Set to true if the centroids are accumulated in a hash table instead of sorting the points. */
+      bool use_hash_table_;
+
       /** \brief The leaf layout information for fast access to cells relative to current position **/
       std::vector<int> leaf_layout_;
 
@@ -451,8 +495,24 @@ namespace pcl
       /** \brief Set to true if we want to return the data outside (\a filter_limit_min_;\a filter_limit_max_). Default: false. */
       bool filter_limit_negative_;
 
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
       typedef typename pcl::traits::fieldList<PointT>::type FieldList;
 
+      /** \brief Compute the voxel key of a point of the input cloud, see sortVoxelGridKeys ().
+        * \param[in] cp the index of the point
+        * \param[in] distance_offset the byte offset of the filter field, or -1 if the points are not filtered
+        * \param[in] div_xy the number of voxels of an XY layer of the grid
+        * \param[in] layered_keys true if the keys are split into the index within an XY layer and the Z layer
+        * \param[out] key the voxel key
+        * \param[out] layer_key the Z layer of the voxel if \a layered_keys is true
+        * \return false if the point is invalid or filtered out
+        */
+      inline bool
+      computeVoxelKey (int cp, int distance_offset, uint64_t div_xy, bool layered_keys,
+                       uint64_t &key, uint64_t &layer_key) const;
+
       /** \brief Downsample a Point Cloud using a voxelized grid approach
         * \param[out] output the resultant point cloud message
         */
@@ -489,6 +549,7 @@ namespace pcl
         inverse_leaf_size_ (Eigen::Array4f::Zero ()),
         downsample_all_data_ (true), 
         save_leaf_layout_ (false),
+        use_hash_table_ (false),
         leaf_layout_ (),
         min_b_ (Eigen::Vector4i::Zero ()),
         max_b_ (Eigen::Vector4i::Zero ()),
@@ -497,7 +558,8 @@ namespace pcl
         filter_field_name_ (""), 
         filter_limit_min_ (-FLT_MAX), 
         filter_limit_max_ (FLT_MAX),
-        filter_limit_negative_ (false)
+        filter_limit_negative_ (false),
+        threads_ (1)
       {
         filter_name_ = "VoxelGrid";
       }
@@ -563,6 +625,20 @@ namespace pcl
       inline bool 
       getSaveLeafLayout () { return (save_leaf_layout_); }
 
+      /** \brief Set to true if the centroids should be accumulated in a hash table of the occupied voxels instead
+        * of sorting the points by voxel. This runs in linear time and needs memory proportional to the number of
+        * occupied voxels instead of the number of points, but the output is not ordered by voxel index: the
+        * centroids appear in the order in which their voxels are first seen. Best suited to grids with many points
+        * per voxel. Ignored if the leaf layout is saved.
+        * \param[in] use_hash_table the new value (true/false)
+        */
+      inline void 
+      setUseHashTable (bool use_hash_table) { use_hash_table_ = use_hash_table; }
+
+      /** \brief Returns true if the centroids are accumulated in a hash table. */
+      inline bool 
+      getUseHashTable () { return (use_hash_table_); }
+
       /** \brief Get the minimum coordinates of the bounding box (after
         * filtering is performed). 
         */
@@ -754,6 +830,15 @@ namespace pcl
         return (filter_limit_negative_);
       }
 
+      /** \brief Initialize the scheduler and set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        threads_ = (nr_threads == 0) ? 1 : nr_threads;
+      }
+
     protected:
       /** \brief The size of a leaf. */
       Eigen::Vector4f leaf_size_;
@@ -769,6 +854,9 @@ namespace pcl
         */
       bool save_leaf_layout_;
 
+      /** \brief Set to true if the centroids are accumulated in a hash table instead of sorting the points. */
+      bool use_hash_table_;
+
       /** \brief The leaf layout information for fast access to cells relative
         * to current position 
         */
@@ -791,11 +879,28 @@ namespace pcl
       /** \brief Set to true if we want to return the data outside (\a filter_limit_min_;\a filter_limit_max_). Default: false. */
       bool filter_limit_negative_;
 
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
       /** \brief Downsample a Point Cloud using a voxelized grid approach
         * \param[out] output the resultant point cloud
         */
       void 
       applyFilter (PointCloud2 &output);
+
+      /** \brief Compute the voxel key of a point of the input cloud, see sortVoxelGridKeys ().
+        * \param[in] cp the index of the point
+        * \param[in] xyz_offset the byte offsets of the x, y, z fields
+        * \param[in] distance_offset the byte offset of the filter field, or -1 if the points are not filtered
+        * \param[in] div_xy the number of voxels of an XY layer of the grid
+        * \param[in] layered_keys true if the keys are split into the index within an XY layer and the Z layer
+        * \param[out] key the voxel key
+        * \param[out] layer_key the Z layer of the voxel if \a layered_keys is true
+        * \return false if the point is invalid or filtered out
+        */
+      bool
+      computeVoxelKey (int cp, const Eigen::Array4i &xyz_offset, int distance_offset, uint64_t div_xy,
+                       bool layered_keys, uint64_t &key, uint64_t &layer_key) const;
   };
 }
 
@@ -39,16 +39,21 @@
 #define PCL_VOXEL_GRID_COVARIANCE_H_
 
 #include <pcl/filters/voxel_grid.h>
-#include <map>
+#include <pcl/filters/voxel_grid_hash_table.h>
 #include <boost/unordered_map.hpp>
 #include <boost/mpl/size.hpp>
 #include <boost/fusion/sequence/intrinsic/at_key.hpp>
 #include <pcl/point_types.h>
 #include <pcl/kdtree/kdtree_flann.h>
+#include <Eigen/Eigenvalues>
 
 namespace pcl
 {
   /** \brief A searchable voxel strucure containing the mean and covariance of the data.
+    * The points are grouped by voxel with a parallel sort, and the statistics of the voxels are computed in
+    * parallel. The leaves are stored contiguously and found through a hash table of their voxel coordinates, so
+    * looking up the leaf of a point, its neighborhood or the leaves within a radius does not need a search tree.
+    * The leaves can be updated with the points of new scans, see addPoints ().
     * \note For more information please see
     * <b>Magnusson, M. (2009). The Three-Dimensional Normal-Distributions Transform —
     * an Efﬁcient Representation for Registration, Surface Analysis, and Loop Detection.
@@ -77,7 +82,8 @@ namespace pcl
       using VoxelGrid<PointT>::inverse_leaf_size_;
       using VoxelGrid<PointT>::div_b_;
       using VoxelGrid<PointT>::divb_mul_;
-
+      using VoxelGrid<PointT>::threads_;
+      using VoxelGrid<PointT>::computeVoxelKey;
 
       typedef typename pcl::traits::fieldList<PointT>::type FieldList;
       typedef typename Filter<PointT>::PointCloud PointCloud;
@@ -99,7 +105,9 @@ namespace pcl
           cov_ (Eigen::Matrix3d::Identity ()),
           icov_ (Eigen::Matrix3d::Zero ()),
           evecs_ (Eigen::Matrix3d::Identity ()),
-          evals_ (Eigen::Vector3d::Zero ())
+          evals_ (Eigen::Vector3d::Zero ()),
+          nr_accumulated_points_ (0),
+          scatter_ (Eigen::Matrix3d::Zero ())
         {
         }
 
@@ -182,6 +190,11 @@ namespace pcl
         /** \brief Eigen values of voxel covariance matrix */
         Eigen::Vector3d evals_;
 
+        /** \brief Number of points accumulated in the voxel, kept when \ref nr_points is set to -1 */
+        int nr_accumulated_points_;
+
+        /** \brief Sum of the outer products of the deviations of the points from \ref mean_ (used for updates) */
+        Eigen::Matrix3d scatter_;
       };
 
       /** \brief Pointer to VoxelGridCovariance leaf structure */
@@ -200,9 +213,14 @@ namespace pcl
         min_points_per_voxel_ (6),
         min_covar_eigvalue_mult_ (0.01),
         leaves_ (),
+        leaf_coordinates_ (),
+        leaf_table_ (0),
+        leaf_centroid_indices_ (),
+        leaf_map_ (),
         voxel_centroids_ (),
         voxel_centroids_leaf_indices_ (),
-        kdtree_ ()
+        kdtree_ (),
+        kdtree_valid_ (false)
       {
         downsample_all_data_ = false;
         save_leaf_layout_ = false;
@@ -258,7 +276,8 @@ namespace pcl
 
       /** \brief Filter cloud and initializes voxel structure.
        * \param[out] output cloud containing centroids of voxels containing a sufficient number of points
-       * \param[in] searchable flag if voxel structure is searchable, if true then kdtree is built
+       * \param[in] searchable flag if voxel structure is searchable by nearestKSearch, if true then a kdtree is
+       * built on the first search
        */
       inline void
       filter (PointCloud &output, bool searchable = false)
@@ -267,16 +286,11 @@ namespace pcl
         applyFilter (output);
 
         voxel_centroids_ = PointCloudPtr (new PointCloud (output));
-
-        if (searchable_ && voxel_centroids_->size() > 0)
-        {
-          // Initiates kdtree of the centroids of voxels containing a sufficient number of points
-          kdtree_.setInputCloud (voxel_centroids_);
-        }
       }
 
       /** \brief Initializes voxel structure.
-       * \param[in] searchable flag if voxel structure is searchable, if true then kdtree is built
+       * \param[in] searchable flag if voxel structure is searchable by nearestKSearch, if true then a kdtree is
+       * built on the first search
        */
       inline void
       filter (bool searchable = false)
@@ -284,14 +298,17 @@ namespace pcl
         searchable_ = searchable;
         voxel_centroids_ = PointCloudPtr (new PointCloud);
         applyFilter (*voxel_centroids_);
-
-        if (searchable_ && voxel_centroids_->size() > 0)
-        {
-          // Initiates kdtree of the centroids of voxels containing a sufficient number of points
-          kdtree_.setInputCloud (voxel_centroids_);
-        }
       }
 
+      /** \brief Add the points of another cloud to the voxel structure, e.g. a new scan of a map, without
+        * rebuilding it. Only the leaves which receive points are recomputed, new leaves are appended and the grid
+        * bounds are extended as needed. The centroids returned by getCentroids () are updated.
+        * \note Pointers to leaves obtained before the update are invalidated.
+        * \param[in] cloud the points to add
+        */
+      void
+      addPoints (const PointCloud &cloud);
+
       /** \brief Get the voxel containing point p.
        * \param[in] index the index of the leaf structure node
        * \return const pointer to leaf structure
@@ -299,14 +316,12 @@ namespace pcl
       inline LeafConstPtr
       getLeaf (int index)
       {
-        typename boost::unordered_map<size_t, Leaf>::iterator leaf_iter = leaves_.find (index);
-        if (leaf_iter != leaves_.end ())
-        {
-          LeafConstPtr ret (&(leaf_iter->second));
-          return ret;
-        }
-        else
-          return NULL;
+        if (index < 0 || div_b_[0] <= 0 || div_b_[1] <= 0)
+          return (NULL);
+        const Eigen::Vector3i ijk (index % div_b_[0] + min_b_[0],
+                                   (index / div_b_[0]) % div_b_[1] + min_b_[1],
+                                   index / (div_b_[0] * div_b_[1]) + min_b_[2]);
+        return (findLeaf (ijk));
       }
 
       /** \brief Get the voxel containing point p.
@@ -316,24 +331,7 @@ namespace pcl
       inline LeafConstPtr
       getLeaf (PointT &p)
       {
-        // Generate index associated with p
-        int ijk0 = static_cast<int> (floor (p.x * inverse_leaf_size_[0]) - min_b_[0]);
-        int ijk1 = static_cast<int> (floor (p.y * inverse_leaf_size_[1]) - min_b_[1]);
-        int ijk2 = static_cast<int> (floor (p.z * inverse_leaf_size_[2]) - min_b_[2]);
-
-        // Compute the centroid leaf index
-        int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
-
-        // Find leaf associated with index
-        typename boost::unordered_map<size_t, Leaf>::iterator leaf_iter = leaves_.find (idx);
-        if (leaf_iter != leaves_.end ())
-        {
-          // If such a leaf exists return the pointer to the leaf structure
-          LeafConstPtr ret (&(leaf_iter->second));
-          return ret;
-        }
-        else
-          return NULL;
+        return (findLeaf (getVoxelCoordinates (p.x, p.y, p.z)));
       }
 
       /** \brief Get the voxel containing point p.
@@ -343,25 +341,7 @@ namespace pcl
       inline LeafConstPtr
       getLeaf (Eigen::Vector3f &p)
       {
-        // Generate index associated with p
-        int ijk0 = static_cast<int> (floor (p[0] * inverse_leaf_size_[0]) - min_b_[0]);
-        int ijk1 = static_cast<int> (floor (p[1] * inverse_leaf_size_[1]) - min_b_[1]);
-        int ijk2 = static_cast<int> (floor (p[2] * inverse_leaf_size_[2]) - min_b_[2]);
-
-        // Compute the centroid leaf index
-        int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
-
-        // Find leaf associated with index
-        typename boost::unordered_map<size_t, Leaf>::iterator leaf_iter = leaves_.find (idx);
-        if (leaf_iter != leaves_.end ())
-        {
-          // If such a leaf exists return the pointer to the leaf structure
-          LeafConstPtr ret (&(leaf_iter->second));
-          return ret;
-        }
-        else
-          return NULL;
-
+        return (findLeaf (getVoxelCoordinates (p[0], p[1], p[2])));
       }
 
       /** \brief Get the voxels surrounding point p, not including the voxel contating point p.
@@ -373,11 +353,48 @@ namespace pcl
       int
       getNeighborhoodAtPoint (const PointT& reference_point, std::vector<LeafConstPtr> &neighbors);
 
-      /** \brief Get the leaf structure map
+      /** \brief Get the voxels at the given displacements from the voxel containing point p.
+       * \note Only voxels containing a sufficient number of points are used.
+       * \param[in] relative_coordinates the displacements of the voxels, one per column
+       * \param[in] reference_point the point to get the leaf structure at
+       * \param[out] neighbors
+       * \return number of neighbors found
+       */
+      int
+      getNeighborhoodAtPoint (const Eigen::MatrixXi &relative_coordinates, const PointT& reference_point,
+                              std::vector<LeafConstPtr> &neighbors) const;
+
+      /** \brief Get the voxel containing point p and its 6 face neighbors.
+       * \note Only voxels containing a sufficient number of points are used.
+       * \param[in] reference_point the point to get the leaf structure at
+       * \param[out] neighbors
+       * \return number of neighbors found
+       */
+      int
+      getNeighborhoodAtPoint7 (const PointT& reference_point, std::vector<LeafConstPtr> &neighbors) const;
+
+      /** \brief Get the voxel containing point p and its 26 neighbors.
+       * \note Only voxels containing a sufficient number of points are used.
+       * \param[in] reference_point the point to get the leaf structure at
+       * \param[out] neighbors
+       * \return number of neighbors found
+       */
+      int
+      getNeighborhoodAtPoint27 (const PointT& reference_point, std::vector<LeafConstPtr> &neighbors) const;
+
+      /** \brief Get the leaf structure map, keyed by the index of the voxel in the grid, see getLeaf (int).
+       * \note The map holds copies of the leaves, made on the first call after filter () or addPoints ().
+       * getLeafVector () gives access to the leaves without copying them.
        * \return a map contataining all leaves
        */
-      inline const boost::unordered_map<size_t, Leaf>&
-      getLeaves ()
+      const boost::unordered_map<size_t, Leaf>&
+      getLeaves ();
+
+      /** \brief Get the leaf structures, in the order in which they were created
+       * \return a vector contataining all leaves
+       */
+      inline const std::vector<Leaf>&
+      getLeafVector () const
       {
         return leaves_;
       }
@@ -413,12 +430,23 @@ namespace pcl
       {
         k_leaves.clear ();
 
-        // Check if kdtree has been built
+        // Check if kdtree can be built
         if (!searchable_)
         {
           PCL_WARN ("%s: Not Searchable", this->getClassName ().c_str ());
           return 0;
         }
+        if (!voxel_centroids_ || voxel_centroids_->empty ())
+        {
+          k_sqr_distances.clear ();
+          return 0;
+        }
+        if (!kdtree_valid_)
+        {
+          // Initiates kdtree of the centroids of voxels containing a sufficient number of points
+          kdtree_.setInputCloud (voxel_centroids_);
+          kdtree_valid_ = true;
+        }
 
         // Find k-nearest neighbors in the occupied voxel centroid cloud
         std::vector<int> k_indices;
@@ -451,39 +479,19 @@ namespace pcl
       }
 
 
-      /** \brief Search for all the nearest occupied voxels of the query point in a given radius.
+      /** \brief Search for all the nearest occupied voxels of the query point in a given radius. The voxels
+       * overlapping the sphere are looked up in the grid, so no search tree is needed.
        * \note Only voxels containing a sufficient number of points are used.
        * \param[in] point the given query point
        * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
-       * \param[out] k_leaves the resultant leaves of the neighboring points
+       * \param[out] k_leaves the resultant leaves of the neighboring points, sorted by distance
        * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+       * \param[in] max_nn if greater than 0, only the max_nn nearest leaves are returned
        * \return number of neighbors found
        */
       int
       radiusSearch (const PointT &point, double radius, std::vector<LeafConstPtr> &k_leaves,
-                    std::vector<float> &k_sqr_distances, unsigned int max_nn = 0)
-      {
-        k_leaves.clear ();
-
-        // Check if kdtree has been built
-        if (!searchable_)
-        {
-          PCL_WARN ("%s: Not Searchable", this->getClassName ().c_str ());
-          return 0;
-        }
-
-        // Find neighbors within radius in the occupied voxel centroid cloud
-        std::vector<int> k_indices;
-        int k = kdtree_.radiusSearch (point, radius, k_indices, k_sqr_distances, max_nn);
-
-        // Find leaves corresponding to neighbors
-        k_leaves.reserve (k);
-        for (std::vector<int>::iterator iter = k_indices.begin (); iter != k_indices.end (); iter++)
-        {
-          k_leaves.push_back (&leaves_[voxel_centroids_leaf_indices_[*iter]]);
-        }
-        return k;
-      }
+                    std::vector<float> &k_sqr_distances, unsigned int max_nn = 0) const;
 
       /** \brief Search for all the nearest occupied voxels of the query point in a given radius.
        * \note Only voxels containing a sufficient number of points are used.
@@ -520,8 +528,98 @@ namespace pcl
       /** \brief Minimum allowable ratio between eigenvalues to prevent singular covariance matrices. */
       double min_covar_eigvalue_mult_;
 
+      /** \brief Get the coordinates of the voxel containing a point.
+        * \param[in] x the x coordinate of the point
+        * \param[in] y the y coordinate of the point
+        * \param[in] z the z coordinate of the point
+        */
+      inline Eigen::Vector3i
+      getVoxelCoordinates (float x, float y, float z) const
+      {
+        return (Eigen::Vector3i (static_cast<int> (floor (x * inverse_leaf_size_[0])),
+                                 static_cast<int> (floor (y * inverse_leaf_size_[1])),
+                                 static_cast<int> (floor (z * inverse_leaf_size_[2]))));
+      }
+
+      /** \brief Get the index of the leaf of a voxel in \ref leaves_, or -1 if the voxel is empty.
+        * \param[in] ijk the voxel coordinates
+        */
+      inline int
+      findLeafIndex (const Eigen::Vector3i &ijk) const
+      {
+        return (leaf_table_.find (getLeafKey (ijk), static_cast<uint32_t> (ijk[2])));
+      }
+
+      /** \brief Get the leaf of a voxel, or NULL if the voxel is empty.
+        * \param[in] ijk the voxel coordinates
+        */
+      inline LeafConstPtr
+      findLeaf (const Eigen::Vector3i &ijk) const
+      {
+        const int index = findLeafIndex (ijk);
+        return (index >= 0 ? &leaves_[index] : NULL);
+      }
+
+      /** \brief Get the hash table key of a voxel from its X and Y coordinates, the Z coordinate is the layer key.
+        * \param[in] ijk the voxel coordinates
+        */
+      static inline uint64_t
+      getLeafKey (const Eigen::Vector3i &ijk)
+      {
+        return (static_cast<uint64_t> (static_cast<uint32_t> (ijk[0])) |
+                static_cast<uint64_t> (static_cast<uint32_t> (ijk[1])) << 32);
+      }
+
+      /** \brief Get the number of values of the centroid of a leaf.
+        * \param[out] rgba_index the offset of the rgb or rgba field, or -1
+        */
+      int
+      getCentroidSize (int &rgba_index) const;
+
+      /** \brief Add the values of a point to the sum of the values of the points of a leaf.
+        * \param[in] point the point
+        * \param[in] rgba_index the offset of the rgb or rgba field, or -1
+        * \param[in,out] centroid the sum of the values
+        */
+      void
+      accumulateCentroid (const PointT &point, int rgba_index, Eigen::VectorXf &centroid) const;
+
+      /** \brief Check if a point is valid and passes the filter field limits.
+        * \param[in] point the point
+        * \param[in] check_finite true if the coordinates of the point need to be checked
+        * \param[in] distance_offset the byte offset of the filter field, or -1 if the points are not filtered
+        */
+      bool
+      acceptPoint (const PointT &point, bool check_finite, int distance_offset) const;
+
+      /** \brief Compute the mean, covariance, inverse covariance and eigen decomposition of a leaf from its
+        * accumulated mean and scatter matrix.
+        * \param[in,out] leaf the leaf
+        * \param[in,out] eigensolver the eigen solver to use
+        */
+      void
+      computeLeafCovariance (Leaf &leaf, Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> &eigensolver) const;
+
+      /** \brief Rebuild the grid bounds, the centroid cloud and the leaf layout from the leaves.
+        * \param[out] output cloud containing centroids of voxels containing a sufficient number of points
+        */
+      void
+      updateCentroids (PointCloud &output);
+
       /** \brief Voxel structure containing all leaf nodes (includes voxels with less than a sufficient number of points). */
-      boost::unordered_map<size_t, Leaf> leaves_;
+      std::vector<Leaf> leaves_;
+
+      /** \brief Voxel coordinates of the leaves. */
+      std::vector<Eigen::Vector3i> leaf_coordinates_;
+
+      /** \brief Hash table mapping voxel coordinates to the indices of the leaves in \ref leaves_. */
+      VoxelCentroidHashTable leaf_table_;
+
+      /** \brief Index of the centroid of every leaf in \ref voxel_centroids_, or -1. */
+      std::vector<int> leaf_centroid_indices_;
+
+      /** \brief Copies of the leaves keyed by their voxel index, built by getLeaves (). */
+      boost::unordered_map<size_t, Leaf> leaf_map_;
 
       /** \brief Point cloud containing centroids of voxels containing atleast minimum number of points. */
       PointCloudPtr voxel_centroids_;
@@ -531,6 +629,9 @@ namespace pcl
 
       /** \brief KdTree generated using \ref voxel_centroids_ (used for searching). */
       KdTreeFLANN<PointT> kdtree_;
+
+      /** \brief True if \ref kdtree_ has been built for the current \ref voxel_centroids_. */
+      bool kdtree_valid_;
   };
 }
 
@@ -0,0 +1,292 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef PCL_FILTERS_VOXEL_GRID_HASH_TABLE_H_
+#define PCL_FILTERS_VOXEL_GRID_HASH_TABLE_H_
+
+#include <pcl/pcl_macros.h>
+#include <vector>
+
+namespace pcl
+{
+  /** \brief Estimate the number of distinct voxels of a point cloud in a single pass with a HyperLogLog sketch of
+    * their keys. The estimate has a relative standard error of about 1.6% and needs 4 KB of memory, independent
+    * of the number of points.
+    * \ingroup filters
+    */
+  class PCL_EXPORTS VoxelCountEstimator
+  {
+    public:
+      /** \brief Empty constructor. */
+      VoxelCountEstimator () : registers_ (1 << precision_, 0) {}
+
+      /** \brief Add the voxel of a point to the sketch.
+        * \param[in] key the voxel key, see sortVoxelGridKeys ()
+        * \param[in] layer_key the Z layer of the voxel if the keys are layered, or 0
+        */
+      inline void
+      add (uint64_t key, uint64_t layer_key)
+      {
+        uint64_t hash = hashVoxelKey (key, layer_key);
+        size_t bucket = static_cast<size_t> (hash >> (64 - precision_));
+        hash <<= precision_;
+        uint8_t rank = 1;
+        while (rank <= 64 - precision_ && !(hash & 0x8000000000000000ULL))
+        {
+          ++rank;
+          hash <<= 1;
+        }
+        if (rank > registers_[bucket])
+          registers_[bucket] = rank;
+      }
+
+      /** \brief Combine the voxels of another sketch with the voxels of this one.
+        * \param[in] other the sketch to merge
+        */
+      void
+      merge (const VoxelCountEstimator &other);
+
+      /** \brief Get the estimated number of distinct voxels added to the sketch. */
+      size_t
+      getEstimate () const;
+
+      /** \brief Hash a voxel key.
+        * \param[in] key the voxel key
+        * \param[in] layer_key the Z layer of the voxel if the keys are layered, or 0
+        */
+      static inline uint64_t
+      hashVoxelKey (uint64_t key, uint64_t layer_key)
+      {
+        uint64_t hash = key ^ (layer_key * 0x9E3779B97F4A7C15ULL);
+        hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+        return (hash ^ (hash >> 31));
+      }
+
+    private:
+      /** \brief The number of bits of the hash which select a register. */
+      static const int precision_ = 12;
+
+      /** \brief The maximum rank observed in every bucket. */
+      std::vector<uint8_t> registers_;
+  };
+
+  /** \brief Open addressing hash table which accumulates the sums of the points of every voxel of a grid.
+    * The voxels are stored contiguously in the order in which they were first seen, so the memory needed is
+    * proportional to the number of occupied voxels, not to the number of points.
+    * \ingroup filters
+    */
+  class PCL_EXPORTS VoxelCentroidHashTable
+  {
+    public:
+      /** \brief Constructor.
+        * \param[in] centroid_size the number of values summed for every point
+        * \param[in] expected_size the expected number of voxels
+        */
+      VoxelCentroidHashTable (int centroid_size = 4, size_t expected_size = 0);
+
+      /** \brief Reserve memory for the given number of voxels.
+        * \param[in] expected_size the expected number of voxels
+        */
+      void
+      reserve (size_t expected_size);
+
+      /** \brief Remove all voxels and release their memory. */
+      void
+      clear ();
+
+      /** \brief Add a point to a voxel, inserting the voxel if it does not exist yet, and return the sums of the
+        * voxel. The caller adds the values of the point to them.
+        * \param[in] key the voxel key, see sortVoxelGridKeys ()
+        * \param[in] layer_key the Z layer of the voxel if the keys are layered, or 0
+        */
+      inline float*
+      accumulate (uint64_t key, uint64_t layer_key)
+      {
+        return (&sums_[findOrInsert (key, layer_key, 1) * centroid_size_]);
+      }
+
+      /** \brief Insert a voxel without adding points to it, if it does not exist yet, and return its index. A table
+        * with a centroid size of 0 can thus map voxel keys to the positions of the voxels in another container.
+        * \param[in] key the voxel key
+        * \param[in] layer_key the Z layer of the voxel if the keys are layered, or 0
+        */
+      inline int
+      insert (uint64_t key, uint64_t layer_key)
+      {
+        return (findOrInsert (key, layer_key, 0));
+      }
+
+      /** \brief Find a voxel and return its index in insertion order, or -1 if it does not exist.
+        * \param[in] key the voxel key
+        * \param[in] layer_key the Z layer of the voxel if the keys are layered, or 0
+        */
+      inline int
+      find (uint64_t key, uint64_t layer_key) const
+      {
+        const uint64_t hash = VoxelCountEstimator::hashVoxelKey (key, layer_key);
+        const uint32_t tag = static_cast<uint32_t> (hash >> 32);
+        const size_t mask = slots_.size () - 1;
+        size_t slot = static_cast<size_t> (hash) & mask;
+        while (slots_[slot].index != -1)
+        {
+          if (slots_[slot].tag == tag)
+          {
+            const Voxel &voxel = voxels_[slots_[slot].index];
+            if (voxel.key == key && voxel.layer_key == layer_key)
+              return (slots_[slot].index);
+          }
+          slot = (slot + 1) & mask;
+        }
+        return (-1);
+      }
+
+      /** \brief Add the sums and point counts of all the voxels of another table to this one.
+        * \param[in] other the table to merge
+        */
+      void
+      merge (const VoxelCentroidHashTable &other);
+
+      /** \brief Get the number of voxels. */
+      inline size_t
+      size () const { return (voxels_.size ()); }
+
+      /** \brief Get the number of points added to a voxel.
+        * \param[in] index the voxel index, in insertion order
+        */
+      inline unsigned int
+      getCount (size_t index) const { return (voxels_[index].count); }
+
+      /** \brief Get the key of a voxel.
+        * \param[in] index the voxel index, in insertion order
+        */
+      inline uint64_t
+      getKey (size_t index) const { return (voxels_[index].key); }
+
+      /** \brief Get the layer key of a voxel.
+        * \param[in] index the voxel index, in insertion order
+        */
+      inline uint64_t
+      getLayerKey (size_t index) const { return (voxels_[index].layer_key); }
+
+      /** \brief Get the sums of the values of the points of a voxel.
+        * \param[in] index the voxel index, in insertion order
+        */
+      inline const float*
+      getSum (size_t index) const { return (&sums_[index * centroid_size_]); }
+
+    private:
+      /** \brief A slot of the table: the index of a voxel, and the upper half of its hash to skip most of the
+        * voxels with a different key without reading them.
+        */
+      struct Slot
+      {
+        int index;
+        uint32_t tag;
+      };
+
+      /** \brief The key and the number of points of a voxel. */
+      struct Voxel
+      {
+        uint64_t key;
+        uint64_t layer_key;
+        unsigned int count;
+      };
+
+      /** \brief Find a voxel, or insert it with zero sums, add points to its count, and return its index.
+        * \param[in] key the voxel key
+        * \param[in] layer_key the Z layer of the voxel
+        * \param[in] nr_points the number of points added to the voxel
+        */
+      inline int
+      findOrInsert (uint64_t key, uint64_t layer_key, unsigned int nr_points)
+      {
+        if (2 * (voxels_.size () + 1) > slots_.size ())
+          rehash (2 * slots_.size ());
+
+        const uint64_t hash = VoxelCountEstimator::hashVoxelKey (key, layer_key);
+        const uint32_t tag = static_cast<uint32_t> (hash >> 32);
+        const size_t mask = slots_.size () - 1;
+        size_t slot = static_cast<size_t> (hash) & mask;
+        while (slots_[slot].index != -1)
+        {
+          if (slots_[slot].tag == tag)
+          {
+            Voxel &voxel = voxels_[slots_[slot].index];
+            if (voxel.key == key && voxel.layer_key == layer_key)
+            {
+              voxel.count += nr_points;
+              return (slots_[slot].index);
+            }
+          }
+          slot = (slot + 1) & mask;
+        }
+
+        slots_[slot].index = static_cast<int> (voxels_.size ());
+        slots_[slot].tag = tag;
+        Voxel voxel;
+        voxel.key = key;
+        voxel.layer_key = layer_key;
+        voxel.count = nr_points;
+        voxels_.push_back (voxel);
+        sums_.resize (sums_.size () + centroid_size_, 0.0f);
+        return (slots_[slot].index);
+      }
+
+      /** \brief Rebuild the slots with a new number of slots.
+        * \param[in] nr_slots the new number of slots, a power of two
+        */
+      void
+      rehash (size_t nr_slots);
+
+      /** \brief The number of values summed for every point. */
+      size_t centroid_size_;
+
+      /** \brief The slots of the table, with an index of -1 for empty slots. */
+      std::vector<Slot> slots_;
+
+      /** \brief The keys and point counts of the voxels, in insertion order. */
+      std::vector<Voxel> voxels_;
+
+      /** \brief The sums of the values of the points of the voxels, \a centroid_size_ values per voxel. */
+      std::vector<float> sums_;
+  };
+}
+
+#endif  //#ifndef PCL_FILTERS_VOXEL_GRID_HASH_TABLE_H_
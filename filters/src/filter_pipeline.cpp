@@ -0,0 +1,529 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <algorithm>
+
+#include <pcl/filters/filter_pipeline.h>
+#include <pcl/filters/voxel_grid_hash_table.h>
+#include <pcl/common/io.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/** \brief A predicate resolved against the fields of the input blob: the field offsets, datatypes and transforms
+  * it needs are looked up once per call of the filter, not once per point.
+  */
+struct pcl::FilterPipeline::Predicate
+{
+  typedef std::vector<Predicate, Eigen::aligned_allocator<Predicate> > Vector;
+
+  enum Type
+  {
+    FIELD_LIMITS, CROP_BOX, FIELD_COMPARISON
+  };
+
+  /** \brief Empty constructor. */
+  Predicate () :
+    type (FIELD_LIMITS), offset (0), datatype (0), limit_min (0), limit_max (0), negative (false),
+    compare_val (0), accept (0),
+    transform (Eigen::Affine3f::Identity ()), inverse_transform (Eigen::Affine3f::Identity ()),
+    translation (Eigen::Vector3f::Zero ()), min_pt (Eigen::Vector3f::Zero ()), max_pt (Eigen::Vector3f::Zero ()),
+    apply_transform (false), apply_translation (false), apply_inverse_transform (false)
+  {}
+
+  /** \brief Resolve the field limits of a PassThrough or VoxelGrid filter.
+    * \return false if the field does not exist or is not a float, true otherwise
+    */
+  bool
+  initFieldLimits (const sensor_msgs::PointCloud2 &cloud, const std::string &field_name,
+                   double filter_limit_min, double filter_limit_max, bool filter_limit_negative,
+                   const std::string &class_name)
+  {
+    const int distance_idx = pcl::getFieldIndex (cloud, field_name);
+    if (distance_idx == -1)
+    {
+      PCL_WARN ("[pcl::%s::applyFilter] Invalid filter field name %s.\n", class_name.c_str (), field_name.c_str ());
+      return (false);
+    }
+    if (cloud.fields[distance_idx].datatype != sensor_msgs::PointField::FLOAT32)
+    {
+      PCL_ERROR ("[pcl::%s::applyFilter] Distance filtering requested, but distances are not float in the dataset! Only FLOAT32 distances are supported right now.\n", class_name.c_str ());
+      return (false);
+    }
+    type = FIELD_LIMITS;
+    offset = cloud.fields[distance_idx].offset;
+    limit_min = filter_limit_min;
+    limit_max = filter_limit_max;
+    negative = filter_limit_negative;
+    return (true);
+  }
+
+  /** \brief Resolve the box and transforms of a CropBox filter. */
+  void
+  initCropBox (const CropBox<sensor_msgs::PointCloud2> &crop_box)
+  {
+    type = CROP_BOX;
+    min_pt = crop_box.getMin ().head<3> ();
+    max_pt = crop_box.getMax ().head<3> ();
+    transform = crop_box.getTransform ();
+    translation = crop_box.getTranslation ();
+    inverse_transform = Eigen::Affine3f::Identity ();
+    const Eigen::Vector3f rotation = crop_box.getRotation ();
+    if (rotation != Eigen::Vector3f::Zero ())
+    {
+      Eigen::Affine3f rotation_transform;
+      pcl::getTransformation (0, 0, 0, rotation (0), rotation (1), rotation (2), rotation_transform);
+      inverse_transform = rotation_transform.inverse ();
+    }
+    apply_transform = !transform.matrix ().isIdentity ();
+    apply_translation = translation != Eigen::Vector3f::Zero ();
+    apply_inverse_transform = !inverse_transform.matrix ().isIdentity ();
+  }
+
+  /** \brief Resolve a field comparison.
+    * \return false if the field does not exist, true otherwise
+    */
+  bool
+  initFieldComparison (const sensor_msgs::PointCloud2 &cloud, const std::string &field_name,
+                       ComparisonOps::CompareOp op, double value, const std::string &class_name)
+  {
+    const int idx = pcl::getFieldIndex (cloud, field_name);
+    if (idx == -1)
+    {
+      PCL_WARN ("[pcl::%s::applyFilter] Comparison field %s not found!\n", class_name.c_str (), field_name.c_str ());
+      return (false);
+    }
+    type = FIELD_COMPARISON;
+    offset = cloud.fields[idx].offset;
+    datatype = cloud.fields[idx].datatype;
+    compare_val = value;
+    // the compare results accepted by the operator: bit 0 for <, 1 for == and 2 for >
+    switch (op)
+    {
+      case ComparisonOps::GT : accept = 4; break;
+      case ComparisonOps::GE : accept = 6; break;
+      case ComparisonOps::LT : accept = 1; break;
+      case ComparisonOps::LE : accept = 3; break;
+      case ComparisonOps::EQ : accept = 2; break;
+      default : accept = 0;
+    }
+    return (true);
+  }
+
+  /** \brief Compare the field data to the value cast to the type of the field, as pcl::PointDataAtOffset does. */
+  template <typename T> inline int
+  compare (const uint8_t *data) const
+  {
+    T value;
+    memcpy (&value, data, sizeof (T));
+    const T val = static_cast<T> (compare_val);
+    return ((value > val) - (value < val));
+  }
+
+  /** \brief Test a point.
+    * \param[in] point the data of the point
+    * \param[in] xyz the (finite) coordinates of the point
+    */
+  inline bool
+  evaluate (const uint8_t *point, const Eigen::Vector3f &xyz) const
+  {
+    switch (type)
+    {
+      case FIELD_LIMITS:
+      {
+        float distance_value;
+        memcpy (&distance_value, point + offset, sizeof (float));
+        if (negative)
+          // Use a threshold for cutting out points which inside the interval
+          return (!(distance_value < limit_max && distance_value > limit_min));
+        // Use a threshold for cutting out points which are too close/far away
+        return (!(distance_value > limit_max || distance_value < limit_min));
+      }
+      case CROP_BOX:
+      {
+        // Transform the point to world space, then to the local space of the crop box
+        Eigen::Vector3f local_pt = xyz;
+        if (apply_transform)
+          local_pt = transform * local_pt;
+        if (apply_translation)
+          local_pt -= translation;
+        if (apply_inverse_transform)
+          local_pt = inverse_transform * local_pt;
+        return (!(local_pt.x () < min_pt[0] || local_pt.y () < min_pt[1] || local_pt.z () < min_pt[2] ||
+                  local_pt.x () > max_pt[0] || local_pt.y () > max_pt[1] || local_pt.z () > max_pt[2]));
+      }
+      case FIELD_COMPARISON:
+      {
+        int result = 0;
+        switch (datatype)
+        {
+          case sensor_msgs::PointField::INT8    : result = compare<int8_t> (point + offset); break;
+          case sensor_msgs::PointField::UINT8   : result = compare<uint8_t> (point + offset); break;
+          case sensor_msgs::PointField::INT16   : result = compare<int16_t> (point + offset); break;
+          case sensor_msgs::PointField::UINT16  : result = compare<uint16_t> (point + offset); break;
+          case sensor_msgs::PointField::INT32   : result = compare<int32_t> (point + offset); break;
+          case sensor_msgs::PointField::UINT32  : result = compare<uint32_t> (point + offset); break;
+          case sensor_msgs::PointField::FLOAT32 : result = compare<float> (point + offset); break;
+          case sensor_msgs::PointField::FLOAT64 : result = compare<double> (point + offset); break;
+        }
+        return (((accept >> (result + 1)) & 1) != 0);
+      }
+    }
+    return (false);
+  }
+
+  /** \brief Test a point against a list of predicates; points with invalid coordinates never pass.
+    * \param[in] predicates the predicates which all have to pass
+    * \param[in] point the data of the point
+    * \param[in] xyz_offset the offsets of the x, y and z fields
+    * \param[out] xyz the coordinates of the point
+    */
+  static inline bool
+  evaluate (const Vector &predicates, const uint8_t *point, const Eigen::Array4i &xyz_offset, Eigen::Vector3f &xyz)
+  {
+    // Unoptimized memcpys: assume fields x, y, z are in random order
+    memcpy (&xyz[0], point + xyz_offset[0], sizeof (float));
+    memcpy (&xyz[1], point + xyz_offset[1], sizeof (float));
+    memcpy (&xyz[2], point + xyz_offset[2], sizeof (float));
+    if (!pcl_isfinite (xyz[0]) || !pcl_isfinite (xyz[1]) || !pcl_isfinite (xyz[2]))
+      return (false);
+
+    for (size_t i = 0; i < predicates.size (); ++i)
+      if (!predicates[i].evaluate (point, xyz))
+        return (false);
+    return (true);
+  }
+
+  Type type;
+  int offset;
+  uint8_t datatype;
+  double limit_min, limit_max;
+  bool negative;
+  double compare_val;
+  unsigned int accept;
+  Eigen::Affine3f transform, inverse_transform;
+  Eigen::Vector3f translation, min_pt, max_pt;
+  bool apply_transform, apply_translation, apply_inverse_transform;
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+  /** \brief The grid coordinates of a voxel, used to output the voxels in the order of VoxelGrid. */
+  struct VoxelOrder
+  {
+    int iz, iy, ix, index;
+
+    inline bool
+    operator < (const VoxelOrder &other) const
+    {
+      if (iz != other.iz)
+        return (iz < other.iz);
+      if (iy != other.iy)
+        return (iy < other.iy);
+      return (ix < other.ix);
+    }
+  };
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::FilterPipeline::applyFilter (PointCloud2 &output)
+{
+  // If fields x/y/z are not present, we cannot filter
+  if (x_idx_ == -1 || y_idx_ == -1 || z_idx_ == -1)
+  {
+    PCL_ERROR ("[pcl::%s::applyFilter] Input dataset doesn't have x-y-z coordinates!\n", getClassName ().c_str ());
+    output.width = output.height = 0;
+    output.data.clear ();
+    return;
+  }
+
+  // Resolve the predicates of all filters against the fields of the input
+  Predicate::Vector predicates;
+  bool valid = true;
+  for (size_t i = 0; i < predicate_filters_.size () && valid; ++i)
+  {
+    const PredicateFilter &filter = predicate_filters_[i];
+    Predicate predicate;
+    if (filter.pass_through)
+    {
+      // without a field name, the PassThrough filter only removes invalid points
+      if (filter.pass_through->getFilterFieldName ().empty ())
+        continue;
+      double limit_min, limit_max;
+      filter.pass_through->getFilterLimits (limit_min, limit_max);
+      valid = predicate.initFieldLimits (*input_, filter.pass_through->getFilterFieldName (), limit_min, limit_max,
+                                         filter.pass_through->getFilterLimitsNegative (), getClassName ());
+    }
+    else if (filter.crop_box)
+      predicate.initCropBox (*filter.crop_box);
+    else
+      valid = predicate.initFieldComparison (*input_, filter.field_name, filter.op, filter.compare_val,
+                                             getClassName ());
+    predicates.push_back (predicate);
+  }
+  if (voxel_grid_ && valid && !voxel_grid_->getFilterFieldName ().empty ())
+  {
+    Predicate predicate;
+    double limit_min, limit_max;
+    voxel_grid_->getFilterLimits (limit_min, limit_max);
+    valid = predicate.initFieldLimits (*input_, voxel_grid_->getFilterFieldName (), limit_min, limit_max,
+                                       voxel_grid_->getFilterLimitsNegative (), getClassName ());
+    predicates.push_back (predicate);
+  }
+  if (!valid)
+  {
+    output.width = output.height = 0;
+    output.data.clear ();
+    return;
+  }
+
+  const Eigen::Array4i xyz_offset (input_->fields[x_idx_].offset,
+                                   input_->fields[y_idx_].offset,
+                                   input_->fields[z_idx_].offset,
+                                   0);
+  const int nr_points = static_cast<int> (indices_->size ());
+  const int threads = static_cast<int> (threads_);
+
+  output.height       = 1;                    // filtering breaks the organized structure
+  output.is_bigendian = input_->is_bigendian;
+  output.is_dense     = true;                 // we filter out invalid points
+
+  if (!voxel_grid_)
+  {
+    // First pass: test the points of every block, and count the ones which pass
+    const int block_size = 4096;
+    const int nr_blocks = (nr_points + block_size - 1) / block_size;
+    std::vector<unsigned char> mask (nr_points);
+    std::vector<int> block_passed (nr_blocks + 1, 0);
+#pragma omp parallel for num_threads (threads) schedule (dynamic, 1)
+    for (int block = 0; block < nr_blocks; ++block)
+    {
+      const int end = std::min (nr_points, (block + 1) * block_size);
+      Eigen::Vector3f xyz;
+      int nr_passed = 0;
+      for (int cp = block * block_size; cp < end; ++cp)
+      {
+        mask[cp] = Predicate::evaluate (predicates, &input_->data[(*indices_)[cp] * input_->point_step],
+                                        xyz_offset, xyz);
+        nr_passed += mask[cp];
+      }
+      block_passed[block + 1] = nr_passed;
+    }
+    for (int block = 0; block < nr_blocks; ++block)
+      block_passed[block + 1] += block_passed[block];
+
+    // Second pass: copy the points which pass, every block to its own part of the output
+    output.point_step = input_->point_step;
+    output.width = block_passed[nr_blocks];
+    output.row_step = output.point_step * output.width;
+    output.data.resize (output.width * output.point_step);
+#pragma omp parallel for num_threads (threads) schedule (dynamic, 1)
+    for (int block = 0; block < nr_blocks; ++block)
+    {
+      const int end = std::min (nr_points, (block + 1) * block_size);
+      int nr_p = block_passed[block];
+      for (int cp = block * block_size; cp < end; ++cp)
+        if (mask[cp])
+          memcpy (&output.data[(nr_p++) * output.point_step],
+                  &input_->data[(*indices_)[cp] * input_->point_step], output.point_step);
+    }
+    return;
+  }
+
+  const Eigen::Array3f inverse_leaf_size = Eigen::Array3f::Ones () / voxel_grid_->getLeafSize ().array ();
+  const bool downsample_all_data = voxel_grid_->getDownsampleAllData ();
+
+  int centroid_size = 4;
+  int rgba_index = -1;
+  if (downsample_all_data)
+  {
+    centroid_size = static_cast<int> (input_->fields.size ());
+    // ---[ RGB special case
+    // if the data contains "rgba" or "rgb", add an extra field for r/g/b in centroid
+    for (int d = 0; d < centroid_size; ++d)
+    {
+      if (input_->fields[d].name == std::string ("rgba") || input_->fields[d].name == std::string ("rgb"))
+      {
+        rgba_index = d;
+        centroid_size += 3;
+        break;
+      }
+    }
+  }
+
+  // Single pass: every thread tests the points of its part of the input, and accumulates the sums of the ones
+  // which pass into its own table of voxels, keyed by their grid coordinates
+  const int chunk_size = (nr_points + threads - 1) / threads;
+  std::vector<VoxelCentroidHashTable> tables (threads, VoxelCentroidHashTable (centroid_size));
+#pragma omp parallel for num_threads (threads) schedule (static, 1)
+  for (int t = 0; t < threads; ++t)
+  {
+    Eigen::VectorXf temporary = Eigen::VectorXf::Zero (centroid_size);
+    Eigen::Vector3f xyz;
+    const int chunk_end = std::min (nr_points, (t + 1) * chunk_size);
+    for (int cp = t * chunk_size; cp < chunk_end; ++cp)
+    {
+      const int point_offset = (*indices_)[cp] * input_->point_step;
+      if (!Predicate::evaluate (predicates, &input_->data[point_offset], xyz_offset, xyz))
+        continue;
+
+      const int ijk0 = static_cast<int> (floor (xyz[0] * inverse_leaf_size[0]));
+      const int ijk1 = static_cast<int> (floor (xyz[1] * inverse_leaf_size[1]));
+      const int ijk2 = static_cast<int> (floor (xyz[2] * inverse_leaf_size[2]));
+      float *sum = tables[t].accumulate (static_cast<uint64_t> (static_cast<uint32_t> (ijk0)) |
+                                         (static_cast<uint64_t> (static_cast<uint32_t> (ijk1)) << 32),
+                                         static_cast<uint32_t> (ijk2));
+      if (!downsample_all_data)
+      {
+        sum[0] += xyz[0];
+        sum[1] += xyz[1];
+        sum[2] += xyz[2];
+      }
+      else
+      {
+        // ---[ RGB special case
+        // fill extra r/g/b centroid field
+        if (rgba_index >= 0)
+        {
+          pcl::RGB rgb;
+          memcpy (&rgb, &input_->data[point_offset + input_->fields[rgba_index].offset], sizeof (RGB));
+          temporary[centroid_size-3] = rgb.r;
+          temporary[centroid_size-2] = rgb.g;
+          temporary[centroid_size-1] = rgb.b;
+        }
+        // Copy all the fields
+        for (unsigned int d = 0; d < input_->fields.size (); ++d)
+          memcpy (&temporary[d], &input_->data[point_offset + input_->fields[d].offset], field_sizes_[d]);
+        Eigen::Map<Eigen::VectorXf> (sum, centroid_size) += temporary;
+      }
+    }
+  }
+
+  // Merge the tables of all threads into the first one
+  for (int t = 1; t < threads; ++t)
+  {
+    tables[0].merge (tables[t]);
+    tables[t].clear ();
+  }
+  const VoxelCentroidHashTable &table = tables[0];
+
+  // Output the voxels in the order of their linear index in the grid, as VoxelGrid does
+  const int total = static_cast<int> (table.size ());
+  std::vector<VoxelOrder> order (total);
+  for (int index = 0; index < total; ++index)
+  {
+    order[index].ix = static_cast<int> (static_cast<uint32_t> (table.getKey (index)));
+    order[index].iy = static_cast<int> (static_cast<uint32_t> (table.getKey (index) >> 32));
+    order[index].iz = static_cast<int> (static_cast<uint32_t> (table.getLayerKey (index)));
+    order[index].index = index;
+  }
+  std::sort (order.begin (), order.end ());
+
+  Eigen::Array4i output_xyz_offset;
+  if (downsample_all_data)
+  {
+    output.fields       = input_->fields;
+    output.point_step   = input_->point_step;
+    // If we downsample each field, the {x,y,z}_idx_ offsets should correspond in input_ and output
+    output_xyz_offset = xyz_offset;
+  }
+  else
+  {
+    output.fields.resize (4);
+
+    output.fields[0] = input_->fields[x_idx_];
+    output.fields[0].offset = 0;
+
+    output.fields[1] = input_->fields[y_idx_];
+    output.fields[1].offset = 4;
+
+    output.fields[2] = input_->fields[z_idx_];
+    output.fields[2].offset = 8;
+
+    output.fields[3].name = "rgba";
+    output.fields[3].offset = 12;
+    output.fields[3].datatype = sensor_msgs::PointField::FLOAT32;
+
+    output.point_step = 16;
+    // If not, we must have created a new xyzw cloud
+    output_xyz_offset = Eigen::Array4i (0, 4, 8, 12);
+  }
+  output.width = total;
+  output.row_step = output.point_step * output.width;
+  output.data.clear ();
+  output.data.resize (output.width * output.point_step);
+
+#pragma omp parallel num_threads (threads)
+  {
+    Eigen::VectorXf centroid = Eigen::VectorXf::Zero (centroid_size);
+
+#pragma omp for schedule (static, 1024)
+    for (int index = 0; index < total; ++index)
+    {
+      const int voxel = order[index].index;
+      centroid = Eigen::Map<const Eigen::VectorXf> (table.getSum (voxel), centroid_size);
+      centroid /= static_cast<float> (table.getCount (voxel));
+
+      const int output_offset = index * output.point_step;
+      // Do we need to process all the fields?
+      if (!downsample_all_data)
+      {
+        // Copy the data
+        memcpy (&output.data[output_offset + output_xyz_offset[0]], &centroid[0], sizeof (float));
+        memcpy (&output.data[output_offset + output_xyz_offset[1]], &centroid[1], sizeof (float));
+        memcpy (&output.data[output_offset + output_xyz_offset[2]], &centroid[2], sizeof (float));
+      }
+      else
+      {
+        // Copy all the fields
+        for (size_t d = 0; d < output.fields.size (); ++d)
+          memcpy (&output.data[output_offset + output.fields[d].offset], &centroid[d], field_sizes_[d]);
+
+        // ---[ RGB special case
+        // full extra r/g/b centroid field
+        if (rgba_index >= 0)
+        {
+          float r = centroid[centroid_size-3], g = centroid[centroid_size-2], b = centroid[centroid_size-1];
+          int rgb = (static_cast<int> (r) << 16) | (static_cast<int> (g) << 8) | static_cast<int> (b);
+          memcpy (&output.data[output_offset + output.fields[rgba_index].offset], &rgb, sizeof (float));
+        }
+      }
+    }
+  }
+}
@@ -41,6 +41,21 @@
 #include <pcl/filters/impl/radius_outlier_removal.hpp>
 #include <pcl/ros/conversions.h>
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::RadiusOutlierRemoval<sensor_msgs::PointCloud2>::hasEnoughNeighbors (int cp, bool use_input_neighbors,
+                                                                         std::vector<int> &nn_indices, std::vector<float> &nn_dists)
+{
+  if (use_input_neighbors && static_cast<int> ((*input_sqr_distances_)[cp].size ()) >= min_pts_radius_)
+  {
+    // The neighbors are sorted by distance, so enough of them are inside the radius if the last one needed is
+    if (min_pts_radius_ <= 0)
+      return (true);
+    return ((*input_sqr_distances_)[cp][min_pts_radius_ - 1] <= search_radius_ * search_radius_);
+  }
+  return (tree_->radiusSearch ((*indices_)[cp], search_radius_, nn_indices, nn_dists) >= min_pts_radius_);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 void
 pcl::RadiusOutlierRemoval<sensor_msgs::PointCloud2>::applyFilter (PointCloud2 &output)
@@ -66,15 +81,28 @@ pcl::RadiusOutlierRemoval<sensor_msgs::PointCloud2>::applyFilter (PointCloud2 &o
   pcl::PointCloud<pcl::PointXYZ>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZ>);
   pcl::fromROSMsg (*input_, *cloud);
 
-  // Initialize the spatial locator
-  if (!tree_)
+  // Use the precomputed neighbors if they are given for all the points
+  const bool use_input_neighbors = input_sqr_distances_ && input_sqr_distances_->size () == indices_->size ();
+  if (input_sqr_distances_ && !use_input_neighbors)
+    PCL_WARN ("[pcl::%s::applyFilter] The precomputed neighbors do not match the input indices, searching them again.\n", getClassName ().c_str ());
+
+  // The spatial locator is only needed for the points with too few precomputed neighbors
+  bool search_neighbors = !use_input_neighbors;
+  for (size_t cp = 0; cp < indices_->size () && !search_neighbors; ++cp)
+    search_neighbors = (static_cast<int> ((*input_sqr_distances_)[cp].size ()) < min_pts_radius_);
+
+  if (search_neighbors)
   {
-    if (cloud->isOrganized ())
-      tree_.reset (new pcl::search::OrganizedNeighbor<pcl::PointXYZ> ());
-    else
-      tree_.reset (new pcl::search::KdTree<pcl::PointXYZ> (false));
+    // Initialize the spatial locator
+    if (!tree_)
+    {
+      if (cloud->isOrganized ())
+        tree_.reset (new pcl::search::OrganizedNeighbor<pcl::PointXYZ> ());
+      else
+        tree_.reset (new pcl::search::KdTree<pcl::PointXYZ> (false));
+    }
+    tree_->setInputCloud (cloud);
   }
-  tree_->setInputCloud (cloud);
 
   // Allocate enough space to hold the results
   std::vector<int> nn_indices (indices_->size ());
@@ -93,9 +121,8 @@ pcl::RadiusOutlierRemoval<sensor_msgs::PointCloud2>::applyFilter (PointCloud2 &o
   // Go over all the points and check which doesn't have enough neighbors
   for (int cp = 0; cp < static_cast<int> (indices_->size ()); ++cp)
   {
-    int k = tree_->radiusSearch ((*indices_)[cp], search_radius_, nn_indices, nn_dists);
     // Check if the number of neighbors is larger than the user imposed limit
-    if (k < min_pts_radius_)
+    if (!hasEnoughNeighbors (cp, use_input_neighbors, nn_indices, nn_dists))
     {
       if (extract_removed_indices_)
       {
@@ -44,102 +44,58 @@
 void
 pcl::RandomSample<sensor_msgs::PointCloud2>::applyFilter (PointCloud2 &output)
 {
-  unsigned N = input_->width * input_->height;
-  // If sample size is 0 or if the sample size is greater then input cloud size
-  //   then return entire copy of cloud
-  if (sample_ >= N)
+  std::vector<int> indices;
+  applyFilter (indices);
+
+  // If all the points are sampled then return entire copy of cloud
+  if (indices.size () == input_->width * input_->height && indices.size () == indices_->size ())
   {
     output = *input_;
+    return;
   }
-  else
-  {
-    // Resize output cloud to sample size
-    output.data.resize (sample_ * input_->point_step);
-
-    // Copy the common fields
-    output.fields = input_->fields;
-    output.is_bigendian = input_->is_bigendian;
-    output.row_step = input_->row_step;
-    output.point_step = input_->point_step;
-    output.height = 1;
 
-    // Set random seed so derived indices are the same each time the filter runs
-    std::srand (seed_);
+  // Copy the common fields
+  const int nr_samples = static_cast<int> (indices.size ());
+  output.fields = input_->fields;
+  output.is_bigendian = input_->is_bigendian;
+  output.point_step = input_->point_step;
+  output.height = 1;
+  output.width = nr_samples;
+  output.row_step = output.point_step * output.width;
+  output.is_dense = input_->is_dense;
 
-    unsigned top = N - sample_;
-    unsigned i = 0;
-    unsigned index = 0;
+  // Resize output cloud to sample size
+  output.data.resize (nr_samples * input_->point_step);
 
-    // Algorithm A
-    for (size_t n = sample_; n >= 2; n--)
-    {
-      float V = unifRand ();
-      unsigned S = 0;
-      float quot = float (top) / float (N);
-      while (quot > V)
-      {
-        S++;
-        top--;
-        N--;
-        quot = quot * float (top) / float (N);
-      }
-      index += S;
-      memcpy (&output.data[i++ * output.point_step], &input_->data[index++ * output.point_step], output.point_step);
-      N--;
-    }
-
-    index += N * static_cast<unsigned> (unifRand ());
-    memcpy (&output.data[i++ * output.point_step], &input_->data[index++ * output.point_step], output.point_step);
-
-    output.width = sample_;
-    output.row_step = output.point_step * output.width;
-  }
+  const int threads = static_cast<int> (threads_);
+#pragma omp parallel for num_threads (threads) schedule (static, 4096)
+  for (int i = 0; i < nr_samples; ++i)
+    memcpy (&output.data[i * output.point_step], &input_->data[indices[i] * output.point_step], output.point_step);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 void
 pcl::RandomSample<sensor_msgs::PointCloud2>::applyFilter (std::vector<int> &indices)
 {
-  unsigned N = input_->width * input_->height;
+  const int N = static_cast<int> (indices_->size ());
+
   // If sample size is 0 or if the sample size is greater then input cloud size
   //   then return all indices
-  if (sample_ >= N)
+  if (sample_ >= static_cast<unsigned int> (N))
   {
     indices = *indices_;
+    return;
   }
-  else
-  {
-    // Resize output indices to sample size
-    indices.resize (sample_);
-
-    // Set random seed so derived indices are the same each time the filter runs
-    std::srand (seed_);
 
-    unsigned top = N - sample_;
-    unsigned i = 0;
-    unsigned index = 0;
-
-    // Algorithm A
-    for (size_t n = sample_; n >= 2; n--)
-    {
-      float V = unifRand ();
-      unsigned S = 0;
-      float quot = float (top) / float (N);
-      while (quot > V)
-      {
-        S++;
-        top--;
-        N--;
-        quot = quot * float (top) / float (N);
-      }
-      index += S;
-      indices[i++] = (*indices_)[index++];
-      N--;
-    }
-
-    index += N * static_cast<unsigned> (unifRand ());
-    indices[i++] = (*indices_)[index++];
+  // The positions of the sampled points in the indices; when the indices were not given they are the indices
+  sampleSortedPositions (N, static_cast<int> (sample_), seed_, indices, threads_);
+  if (!fake_indices_)
+  {
+    const int nr_samples = static_cast<int> (indices.size ());
+    for (int i = 0; i < nr_samples; ++i)
+      indices[i] = (*indices_)[indices[i]];
   }
 }
 
 PCL_INSTANTIATE(RandomSample, PCL_POINT_TYPES)
+PCL_INSTANTIATE(StratifiedRandomSample, PCL_XYZ_POINT_TYPES)
@@ -0,0 +1,339 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <pcl/filters/sampling.h>
+#include <boost/math/special_functions/gamma.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  /** \brief Draw a sorted random sample of positions from a contiguous range with Floyd's algorithm, marking the
+    * sampled positions in a bit set. The bit set is scanned in order afterwards, which is cheap when the sample is
+    * a large part of the range.
+    * \param[in] nr_population the size of the range
+    * \param[in] nr_samples the number of positions to draw
+    * \param[in] generator the random sequence
+    * \param[in] begin the first position of the range
+    * \param[out] positions the sampled positions
+    */
+  void
+  sampleFloyd (int nr_population, int nr_samples, pcl::SampleGenerator &generator, int begin, int *positions)
+  {
+    std::vector<uint64_t> sampled ((nr_population + 63) / 64, 0);
+    for (int j = nr_population - nr_samples; j < nr_population; ++j)
+    {
+      int t = std::min (static_cast<int> (generator.nextUniform () * (j + 1)), j);
+      if (sampled[t >> 6] & (1ULL << (t & 63)))
+        t = j;
+      sampled[t >> 6] |= 1ULL << (t & 63);
+    }
+    for (int i = 0; i < nr_population; ++i)
+      if (sampled[i >> 6] & (1ULL << (i & 63)))
+        *positions++ = begin + i;
+  }
+
+  /** \brief Draw a sorted random sample of positions from a contiguous range with Vitter's Algorithm D, which
+    * generates every skip in constant expected time by rejection. It falls back to Algorithm A when the sample
+    * becomes a large part of the remaining range.
+    * \param[in] nr_population the size of the range
+    * \param[in] nr_samples the number of positions to draw
+    * \param[in] generator the random sequence
+    * \param[in] begin the first position of the range
+    * \param[out] positions the sampled positions
+    */
+  void
+  sampleVitterD (int nr_population, int nr_samples, pcl::SampleGenerator &generator, int begin, int *positions)
+  {
+    if (nr_samples <= 0)
+      return;
+    if (nr_samples >= nr_population)
+    {
+      for (int i = 0; i < nr_population; ++i)
+        positions[i] = begin + i;
+      return;
+    }
+
+    // Skipping is faster than marking the sampled positions while the population is larger than 13 times the sample
+    const double alpha_inverse = 13.0;
+    int n = nr_samples;
+    int N = nr_population;
+    int current = begin - 1;
+    double n_real = n;
+    double N_real = N;
+    double n_inverse = 1.0 / n_real;
+    double v_prime = exp (log (generator.nextUniform ()) * n_inverse);
+    int qu1 = N - n + 1;
+    double qu1_real = qu1;
+    double threshold = alpha_inverse * n_real;
+
+    while (n > 1 && threshold < N_real)
+    {
+      const double n_minus_1_inverse = 1.0 / (n_real - 1.0);
+      int skip;
+      for (;;)
+      {
+        // generate a candidate skip from the continuous approximation of its distribution
+        double x;
+        for (;;)
+        {
+          x = N_real * (1.0 - v_prime);
+          skip = static_cast<int> (x);
+          if (skip < qu1)
+            break;
+          v_prime = exp (log (generator.nextUniform ()) * n_inverse);
+        }
+        const double u = generator.nextUniform ();
+        const double y1 = exp (log (u * N_real / qu1_real) * n_minus_1_inverse);
+        v_prime = y1 * (1.0 - x / N_real) * (qu1_real / (qu1_real - skip));
+        // accept without evaluating the exact distribution
+        if (v_prime <= 1.0)
+          break;
+
+        // accept or reject against the exact distribution
+        double y2 = 1.0;
+        double top = N_real - 1.0;
+        double bottom;
+        int limit;
+        if (n - 1 > skip)
+        {
+          bottom = N_real - n_real;
+          limit = N - skip;
+        }
+        else
+        {
+          bottom = N_real - skip - 1.0;
+          limit = qu1;
+        }
+        for (int t = N - 1; t >= limit; --t)
+        {
+          y2 = (y2 * top) / bottom;
+          top -= 1.0;
+          bottom -= 1.0;
+        }
+        if (N_real / (N_real - x) >= y1 * exp (log (y2) * n_minus_1_inverse))
+        {
+          v_prime = exp (log (generator.nextUniform ()) * n_minus_1_inverse);
+          break;
+        }
+        v_prime = exp (log (generator.nextUniform ()) * n_inverse);
+      }
+
+      current += skip + 1;
+      *positions++ = current;
+      N -= skip + 1;
+      N_real = N;
+      --n;
+      n_real = n;
+      n_inverse = n_minus_1_inverse;
+      qu1 -= skip;
+      qu1_real = qu1;
+      threshold -= alpha_inverse;
+    }
+
+    if (n > 1)
+      sampleFloyd (N, n, generator, current + 1, positions);
+    else
+      *positions = current + std::min (static_cast<int> (N_real * v_prime), N - 1) + 1;
+  }
+
+  /** \brief Draw the number of marked items in a sample without replacement from the hypergeometric
+    * distribution, by inversion starting at the mode. The expected number of steps is proportional to the standard
+    * deviation of the distribution.
+    * \param[in] nr_population the size of the population
+    * \param[in] nr_marked the number of marked items in the population
+    * \param[in] nr_draws the size of the sample
+    * \param[in] generator the random sequence
+    */
+  int
+  sampleHypergeometric (int nr_population, int nr_marked, int nr_draws, pcl::SampleGenerator &generator)
+  {
+    const double N = nr_population;
+    const double K = nr_marked;
+    const double n = nr_draws;
+    const int low = std::max (0, nr_draws - (nr_population - nr_marked));
+    const int high = std::min (nr_draws, nr_marked);
+    if (low >= high)
+      return (low);
+
+    int mode = static_cast<int> (floor ((n + 1.0) * (K + 1.0) / (N + 2.0)));
+    mode = std::max (low, std::min (high, mode));
+    const double m = mode;
+    using boost::math::lgamma;
+    const double log_p = lgamma (K + 1.0) - lgamma (m + 1.0) - lgamma (K - m + 1.0) +
+                         lgamma (N - K + 1.0) - lgamma (n - m + 1.0) - lgamma (N - K - n + m + 1.0) -
+                         lgamma (N + 1.0) + lgamma (n + 1.0) + lgamma (N - n + 1.0);
+
+    double u = generator.nextUniform () - exp (log_p);
+    if (u <= 0.0)
+      return (mode);
+
+    // walk away from the mode on both sides, with the ratios of consecutive probabilities
+    int up = mode, down = mode;
+    double p_up = exp (log_p), p_down = p_up;
+    for (;;)
+    {
+      bool moved = false;
+      if (up < high)
+      {
+        p_up *= (K - up) * (n - up) / ((up + 1.0) * (N - K - n + up + 1.0));
+        ++up;
+        u -= p_up;
+        if (u <= 0.0)
+          return (up);
+        moved = true;
+      }
+      if (down > low)
+      {
+        p_down *= down * (N - K - n + down) / ((K - down + 1.0) * (n - down + 1.0));
+        --down;
+        u -= p_down;
+        if (u <= 0.0)
+          return (down);
+        moved = true;
+      }
+      // only reached through rounding errors of the probabilities
+      if (!moved)
+        return (mode);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::sampleSortedPositions (int nr_population, int nr_samples, unsigned int seed, std::vector<int> &positions,
+                            unsigned int nr_threads)
+{
+  nr_samples = std::max (0, std::min (nr_samples, nr_population));
+  positions.resize (nr_samples);
+  if (nr_samples == 0)
+    return;
+
+  // Split the population into blocks of about the same expected number of samples. The samples of the blocks are
+  // drawn one block after the other, from the hypergeometric distribution of the remaining samples.
+  const int samples_per_block = 8192;
+  const int nr_blocks = (nr_samples + samples_per_block - 1) / samples_per_block;
+  std::vector<int> block_begin (nr_blocks + 1), sample_begin (nr_blocks + 1);
+  SampleGenerator generator (seed, 0);
+  for (int b = 0; b <= nr_blocks; ++b)
+    block_begin[b] = static_cast<int> (static_cast<int64_t> (nr_population) * b / nr_blocks);
+  sample_begin[0] = 0;
+  for (int b = 0; b < nr_blocks; ++b)
+  {
+    const int nr_remaining = nr_population - block_begin[b];
+    const int nr_samples_remaining = nr_samples - sample_begin[b];
+    const int block_size = block_begin[b + 1] - block_begin[b];
+    sample_begin[b + 1] = sample_begin[b] + (b == nr_blocks - 1 ? nr_samples_remaining :
+                          sampleHypergeometric (nr_remaining, block_size, nr_samples_remaining, generator));
+  }
+
+  const int threads = static_cast<int> (std::min (nr_threads, static_cast<unsigned int> (nr_blocks)));
+#pragma omp parallel for num_threads (threads) schedule (dynamic, 1)
+  for (int b = 0; b < nr_blocks; ++b)
+  {
+    const int nr_block_samples = sample_begin[b + 1] - sample_begin[b];
+    if (nr_block_samples == 0)
+      continue;
+    SampleGenerator block_generator (seed, b + 1);
+    sampleVitterD (block_begin[b + 1] - block_begin[b], nr_block_samples, block_generator, block_begin[b],
+                   &positions[sample_begin[b]]);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::sampleStrata (const std::vector<int> &stratum_begin, int nr_samples, unsigned int seed,
+                   std::vector<int> &positions, unsigned int nr_threads)
+{
+  const int nr_strata = static_cast<int> (stratum_begin.size ()) - 1;
+  const int nr_positions = nr_strata > 0 ? stratum_begin[nr_strata] - stratum_begin[0] : 0;
+  nr_samples = std::max (0, std::min (nr_samples, nr_positions));
+  positions.resize (nr_samples);
+  if (nr_samples == nr_positions)
+  {
+    for (int i = 0; i < nr_samples; ++i)
+      positions[i] = stratum_begin[0] + i;
+    return;
+  }
+
+  // Find the number of full turns: the largest number of positions per stratum which does not exceed the sample
+  int max_size = 0;
+  for (int s = 0; s < nr_strata; ++s)
+    max_size = std::max (max_size, stratum_begin[s + 1] - stratum_begin[s]);
+  int turns = 0, nr_turn_samples = 0;
+  int low = 0, high = max_size;
+  while (low <= high)
+  {
+    const int middle = low + (high - low) / 2;
+    int64_t nr_taken = 0;
+    for (int s = 0; s < nr_strata; ++s)
+      nr_taken += std::min (stratum_begin[s + 1] - stratum_begin[s], middle);
+    if (nr_taken <= nr_samples)
+    {
+      turns = middle;
+      nr_turn_samples = static_cast<int> (nr_taken);
+      low = middle + 1;
+    }
+    else
+      high = middle - 1;
+  }
+
+  // The last, incomplete turn takes one more position from the first strata which are not exhausted
+  std::vector<int> sample_begin (nr_strata + 1);
+  int nr_extra_samples = nr_samples - nr_turn_samples;
+  sample_begin[0] = 0;
+  for (int s = 0; s < nr_strata; ++s)
+  {
+    const int size = stratum_begin[s + 1] - stratum_begin[s];
+    int nr_stratum_samples = std::min (size, turns);
+    if (nr_extra_samples > 0 && size > turns)
+    {
+      ++nr_stratum_samples;
+      --nr_extra_samples;
+    }
+    sample_begin[s + 1] = sample_begin[s] + nr_stratum_samples;
+  }
+
+  const int threads = static_cast<int> (nr_threads);
+#pragma omp parallel for num_threads (threads) schedule (dynamic, 64)
+  for (int s = 0; s < nr_strata; ++s)
+  {
+    SampleGenerator generator (seed, s);
+    sampleVitterD (stratum_begin[s + 1] - stratum_begin[s], sample_begin[s + 1] - sample_begin[s], generator,
+                   stratum_begin[s], &positions[sample_begin[s]]);
+  }
+}
@@ -39,6 +39,7 @@
 #include <pcl/impl/instantiate.hpp>
 #include <pcl/point_types.h>
 #include <pcl/common/io.h>
+#include <pcl/common/morton.h>
 #include <pcl/filters/voxel_grid.h>
 #include <pcl/filters/impl/voxel_grid.hpp>
 
@@ -170,6 +171,111 @@ pcl::getMinMax3D (const sensor_msgs::PointCloud2ConstPtr &cloud, int x_idx, int
   max_pt = max_p;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::sortVoxelGridKeys (std::vector<uint64_t> &keys, std::vector<uint64_t> &layer_keys, std::vector<int> &indices,
+                        std::vector<int> &voxel_begin, unsigned int nr_threads)
+{
+  const uint64_t invalid_key = std::numeric_limits<uint64_t>::max ();
+  const int nr_points = static_cast<int> (keys.size ());
+
+  if (layer_keys.empty ())
+    pcl::radixSortKeys (keys, indices, nr_threads);
+  else
+  {
+    // LSD order: sort by the index within the XY layer first, then (stable) by the Z layer
+    std::vector<int> order (nr_points);
+    for (int i = 0; i < nr_points; ++i)
+      order[i] = i;
+    pcl::radixSortKeys (keys, order, nr_threads);
+
+    std::vector<uint64_t> sorted_layer_keys (nr_points);
+    std::vector<int> position (nr_points);
+    for (int i = 0; i < nr_points; ++i)
+    {
+      sorted_layer_keys[i] = layer_keys[order[i]];
+      position[i] = i;
+    }
+    pcl::radixSortKeys (sorted_layer_keys, position, nr_threads);
+
+    std::vector<uint64_t> sorted_keys (nr_points);
+    std::vector<int> sorted_indices (nr_points);
+    for (int i = 0; i < nr_points; ++i)
+    {
+      sorted_keys[i] = keys[position[i]];
+      sorted_indices[i] = indices[order[position[i]]];
+    }
+    keys.swap (sorted_keys);
+    indices.swap (sorted_indices);
+    layer_keys.swap (sorted_layer_keys);
+  }
+
+  // skipped points are sorted to the end
+  int nr_valid = nr_points;
+  while (nr_valid > 0 && keys[nr_valid - 1] == invalid_key && (layer_keys.empty () || layer_keys[nr_valid - 1] == invalid_key))
+    --nr_valid;
+
+  // we need to skip all the same, adjacent key values
+  voxel_begin.clear ();
+  for (int i = 0; i < nr_valid; ++i)
+    if (i == 0 || keys[i] != keys[i - 1] || (!layer_keys.empty () && layer_keys[i] != layer_keys[i - 1]))
+      voxel_begin.push_back (i);
+  voxel_begin.push_back (nr_valid);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::VoxelGrid<sensor_msgs::PointCloud2>::computeVoxelKey (int cp, const Eigen::Array4i &xyz_offset, int distance_offset,
+                                                           uint64_t div_xy, bool layered_keys,
+                                                           uint64_t &key, uint64_t &layer_key) const
+{
+  const int point_offset = cp * input_->point_step;
+
+  if (distance_offset >= 0)
+  {
+    // Get the distance value
+    float distance_value = 0;
+    memcpy (&distance_value, &input_->data[point_offset + distance_offset], sizeof (float));
+
+    if (filter_limit_negative_)
+    {
+      // Use a threshold for cutting out points which inside the interval
+      if (distance_value < filter_limit_max_ && distance_value > filter_limit_min_)
+        return (false);
+    }
+    else
+    {
+      // Use a threshold for cutting out points which are too close/far away
+      if (distance_value > filter_limit_max_ || distance_value < filter_limit_min_)
+        return (false);
+    }
+  }
+
+  // Unoptimized memcpys: assume fields x, y, z are in random order
+  float pt[3];
+  memcpy (&pt[0], &input_->data[point_offset + xyz_offset[0]], sizeof (float));
+  memcpy (&pt[1], &input_->data[point_offset + xyz_offset[1]], sizeof (float));
+  memcpy (&pt[2], &input_->data[point_offset + xyz_offset[2]], sizeof (float));
+
+  // Check if the point is invalid
+  if (!pcl_isfinite (pt[0]) || 
+      !pcl_isfinite (pt[1]) || 
+      !pcl_isfinite (pt[2]))
+    return (false);
+
+  uint64_t ijk0 = static_cast<uint64_t> (floor (pt[0] * inverse_leaf_size_[0]) - min_b_[0]);
+  uint64_t ijk1 = static_cast<uint64_t> (floor (pt[1] * inverse_leaf_size_[1]) - min_b_[1]);
+  uint64_t ijk2 = static_cast<uint64_t> (floor (pt[2] * inverse_leaf_size_[2]) - min_b_[2]);
+
+  // Compute the centroid leaf index
+  key = ijk0 + ijk1 * div_b_[0];
+  if (layered_keys)
+    layer_key = ijk2;
+  else
+    key += ijk2 * div_xy;
+  return (true);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 void
 pcl::VoxelGrid<sensor_msgs::PointCloud2>::applyFilter (PointCloud2 &output)
@@ -235,16 +341,12 @@ pcl::VoxelGrid<sensor_msgs::PointCloud2>::applyFilter (PointCloud2 &output)
   div_b_ = max_b_ - min_b_ + Eigen::Vector4i::Ones ();
   div_b_[3] = 0;
 
-  std::vector<cloud_point_index_idx> index_vector;
-  index_vector.reserve (nr_points);
-
   // Create the first xyz_offset, and set up the division multiplier
   Eigen::Array4i xyz_offset (input_->fields[x_idx_].offset,
                              input_->fields[y_idx_].offset,
                              input_->fields[z_idx_].offset,
                              0);
   divb_mul_ = Eigen::Vector4i (1, div_b_[0], div_b_[0] * div_b_[1], 0);
-  Eigen::Vector4f pt  = Eigen::Vector4f::Zero ();
 
   int centroid_size = 4;
   if (downsample_all_data_)
@@ -265,10 +367,11 @@ pcl::VoxelGrid<sensor_msgs::PointCloud2>::applyFilter (PointCloud2 &output)
   }
 
   // If we don't want to process the entire cloud, but rather filter points far away from the viewpoint first...
+  int distance_idx = -1;
   if (!filter_field_name_.empty ())
   {
     // Get the distance field index
-    int distance_idx = pcl::getFieldIndex (*input_, filter_field_name_);
+    distance_idx = pcl::getFieldIndex (*input_, filter_field_name_);
 
     // @todo fixme
     if (input_->fields[distance_idx].datatype != sensor_msgs::PointField::FLOAT32)
@@ -278,108 +381,175 @@ pcl::VoxelGrid<sensor_msgs::PointCloud2>::applyFilter (PointCloud2 &output)
       output.data.clear ();
       return;
     }
+  }
 
-    // First pass: go over all points and insert them into the index_vector vector
-    // with calculated idx. Points with the same idx value will contribute to the
-    // same point of resulting CloudPoint
-    float distance_value = 0;
-    for (int cp = 0; cp < nr_points; ++cp)
+  // Voxel keys are the linear voxel indices, computed with 64 bit integers. If the number of voxels exceeds the
+  // range of the keys, points are sorted by their index within an XY layer first and by their Z layer second.
+  const uint64_t div_xy = static_cast<uint64_t> (div_b_[0]) * static_cast<uint64_t> (div_b_[1]);
+  const bool layered_keys = (div_xy > static_cast<uint64_t> (std::numeric_limits<int64_t>::max ()) / static_cast<uint64_t> (div_b_[2]));
+  const uint64_t invalid_key = std::numeric_limits<uint64_t>::max ();
+  const int threads = static_cast<int> (threads_);
+
+  const int distance_offset = (distance_idx >= 0) ? static_cast<int> (input_->fields[distance_idx].offset) : -1;
+
+  // Accumulate the centroids in a hash table of the occupied voxels, without sorting the points
+  if (use_hash_table_ && !save_leaf_layout_)
+  {
+    const int chunk_size = (nr_points + threads - 1) / threads;
+
+    // First pass: estimate the number of occupied voxels, to size the hash tables
+    std::vector<VoxelCountEstimator> estimators (threads);
+#pragma omp parallel for num_threads (threads) schedule (static, 1)
+    for (int t = 0; t < threads; ++t)
+    {
+      uint64_t key, layer_key = 0;
+      const int chunk_end = std::min (nr_points, (t + 1) * chunk_size);
+      for (int cp = t * chunk_size; cp < chunk_end; ++cp)
+        if (computeVoxelKey (cp, xyz_offset, distance_offset, div_xy, layered_keys, key, layer_key))
+          estimators[t].add (key, layer_key);
+    }
+    for (int t = 1; t < threads; ++t)
+      estimators[0].merge (estimators[t]);
+    const size_t nr_voxels = estimators[0].getEstimate ();
+
+    // Second pass: every thread accumulates the sums of its part of the cloud in its own table
+    std::vector<VoxelCentroidHashTable> tables (threads, VoxelCentroidHashTable (centroid_size));
+#pragma omp parallel for num_threads (threads) schedule (static, 1)
+    for (int t = 0; t < threads; ++t)
     {
-      int point_offset = cp * input_->point_step;
-      // Get the distance value
-      memcpy (&distance_value, &input_->data[point_offset + input_->fields[distance_idx].offset], sizeof (float));
+      const int chunk_end = std::min (nr_points, (t + 1) * chunk_size);
+      tables[t].reserve (std::min (nr_voxels, static_cast<size_t> (std::max (0, chunk_end - t * chunk_size))));
 
-      if (filter_limit_negative_)
+      Eigen::VectorXf temporary = Eigen::VectorXf::Zero (centroid_size);
+      float xyz[3];
+      uint64_t key, layer_key = 0;
+      for (int cp = t * chunk_size; cp < chunk_end; ++cp)
       {
-        // Use a threshold for cutting out points which inside the interval
-        if (distance_value < filter_limit_max_ && distance_value > filter_limit_min_)
-        {
-          xyz_offset += input_->point_step;
+        if (!computeVoxelKey (cp, xyz_offset, distance_offset, div_xy, layered_keys, key, layer_key))
           continue;
+
+        const int point_offset = cp * input_->point_step;
+        float *sum = tables[t].accumulate (key, layer_key);
+        if (!downsample_all_data_) 
+        {
+          memcpy (&xyz[0], &input_->data[point_offset + xyz_offset[0]], sizeof (float));
+          memcpy (&xyz[1], &input_->data[point_offset + xyz_offset[1]], sizeof (float));
+          memcpy (&xyz[2], &input_->data[point_offset + xyz_offset[2]], sizeof (float));
+          sum[0] += xyz[0];
+          sum[1] += xyz[1];
+          sum[2] += xyz[2];
         }
-      }
-      else
-      {
-        // Use a threshold for cutting out points which are too close/far away
-        if (distance_value > filter_limit_max_ || distance_value < filter_limit_min_)
+        else
         {
-          xyz_offset += input_->point_step;
-          continue;
+          // ---[ RGB special case
+          // fill extra r/g/b centroid field
+          if (rgba_index >= 0)
+          {
+            pcl::RGB rgb;
+            memcpy (&rgb, &input_->data[point_offset + input_->fields[rgba_index].offset], sizeof (RGB));
+            temporary[centroid_size-3] = rgb.r;
+            temporary[centroid_size-2] = rgb.g;
+            temporary[centroid_size-1] = rgb.b;
+          }
+          // Copy all the fields
+          for (unsigned int d = 0; d < input_->fields.size (); ++d)
+            memcpy (&temporary[d], &input_->data[point_offset + input_->fields[d].offset], field_sizes_[d]);
+          Eigen::Map<Eigen::VectorXf> (sum, centroid_size) += temporary;
         }
       }
+    }
 
-      // Unoptimized memcpys: assume fields x, y, z are in random order
-      memcpy (&pt[0], &input_->data[xyz_offset[0]], sizeof (float));
-      memcpy (&pt[1], &input_->data[xyz_offset[1]], sizeof (float));
-      memcpy (&pt[2], &input_->data[xyz_offset[2]], sizeof (float));
+    // Merge the tables of all threads into the first one
+    tables[0].reserve (nr_voxels);
+    for (int t = 1; t < threads; ++t)
+    {
+      tables[0].merge (tables[t]);
+      tables[t].clear ();
+    }
 
-      // Check if the point is invalid
-      if (!pcl_isfinite (pt[0]) || 
-          !pcl_isfinite (pt[1]) || 
-          !pcl_isfinite (pt[2]))
-      {
-        xyz_offset += input_->point_step;
-        continue;
-      }
+    // Third pass: compute the centroids
+    const VoxelCentroidHashTable &table = tables[0];
+    const int total = static_cast<int> (table.size ());
+    output.width = total;
+    output.row_step = output.point_step * output.width;
+    output.data.resize (output.width * output.point_step);
+
+    // If we downsample each field, the {x,y,z}_idx_ offsets should correspond in input_ and output
+    if (downsample_all_data_)
+      xyz_offset = Eigen::Array4i (output.fields[x_idx_].offset,
+                                   output.fields[y_idx_].offset,
+                                   output.fields[z_idx_].offset,
+                                   0);
+    else
+      // If not, we must have created a new xyzw cloud
+      xyz_offset = Eigen::Array4i (0, 4, 8, 12);
 
-      int ijk0 = static_cast<int> (floor (pt[0] * inverse_leaf_size_[0]) - min_b_[0]);
-      int ijk1 = static_cast<int> (floor (pt[1] * inverse_leaf_size_[1]) - min_b_[1]);
-      int ijk2 = static_cast<int> (floor (pt[2] * inverse_leaf_size_[2]) - min_b_[2]);
-      // Compute the centroid leaf index
-      int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
-      index_vector.push_back (cloud_point_index_idx (idx, cp));
+#pragma omp parallel num_threads (threads)
+    {
+      Eigen::VectorXf centroid = Eigen::VectorXf::Zero (centroid_size);
+
+#pragma omp for schedule (static, 1024)
+      for (int index = 0; index < total; ++index)
+      {
+        centroid = Eigen::Map<const Eigen::VectorXf> (table.getSum (index), centroid_size);
+        centroid /= static_cast<float> (table.getCount (index));
 
-      xyz_offset += input_->point_step;
+        int output_offset = index * output.point_step;
+        // Do we need to process all the fields?
+        if (!downsample_all_data_)
+        {
+          // Copy the data
+          memcpy (&output.data[output_offset + xyz_offset[0]], &centroid[0], sizeof (float));
+          memcpy (&output.data[output_offset + xyz_offset[1]], &centroid[1], sizeof (float));
+          memcpy (&output.data[output_offset + xyz_offset[2]], &centroid[2], sizeof (float));
+        }
+        else
+        {
+          // Copy all the fields
+          for (size_t d = 0; d < output.fields.size (); ++d)
+            memcpy (&output.data[output_offset + output.fields[d].offset], &centroid[d], field_sizes_[d]);
+
+          // ---[ RGB special case
+          // full extra r/g/b centroid field
+          if (rgba_index >= 0) 
+          {
+            float r = centroid[centroid_size-3], g = centroid[centroid_size-2], b = centroid[centroid_size-1];
+            int rgb = (static_cast<int> (r) << 16) | (static_cast<int> (g) << 8) | static_cast<int> (b);
+            memcpy (&output.data[output_offset + output.fields[rgba_index].offset], &rgb, sizeof (float));
+          }
+        }
+      }
     }
+    return;
   }
-  // No distance filtering, process all data
-  else
+
+  std::vector<uint64_t> keys (nr_points);
+  std::vector<uint64_t> layer_keys (layered_keys ? nr_points : 0);
+  std::vector<int> index_vector (nr_points);
+
+  // First pass: go over all points and compute the key of their voxel. Points with the same key will contribute
+  // to the same point of resulting CloudPoint. Points which are filtered out are marked by an invalid key.
+#pragma omp parallel for num_threads (threads)
+  for (int cp = 0; cp < nr_points; ++cp)
   {
-    // First pass: go over all points and insert them into the right leaf
-    for (int cp = 0; cp < nr_points; ++cp)
+    index_vector[cp] = cp;
+    uint64_t layer_key = 0;
+    if (!computeVoxelKey (cp, xyz_offset, distance_offset, div_xy, layered_keys, keys[cp], layer_key))
     {
-      // Unoptimized memcpys: assume fields x, y, z are in random order
-      memcpy (&pt[0], &input_->data[xyz_offset[0]], sizeof (float));
-      memcpy (&pt[1], &input_->data[xyz_offset[1]], sizeof (float));
-      memcpy (&pt[2], &input_->data[xyz_offset[2]], sizeof (float));
-
-      // Check if the point is invalid
-      if (!pcl_isfinite (pt[0]) || 
-          !pcl_isfinite (pt[1]) || 
-          !pcl_isfinite (pt[2]))
-      {
-        xyz_offset += input_->point_step;
-        continue;
-      }
-
-      int ijk0 = static_cast<int> (floor (pt[0] * inverse_leaf_size_[0]) - min_b_[0]);
-      int ijk1 = static_cast<int> (floor (pt[1] * inverse_leaf_size_[1]) - min_b_[1]);
-      int ijk2 = static_cast<int> (floor (pt[2] * inverse_leaf_size_[2]) - min_b_[2]);
-      // Compute the centroid leaf index
-      int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
-      index_vector.push_back (cloud_point_index_idx (idx, cp));
-      xyz_offset += input_->point_step;
+      keys[cp] = invalid_key;
+      layer_key = invalid_key;
     }
+    if (layered_keys)
+      layer_keys[cp] = layer_key;
   }
 
   // Second pass: sort the index_vector vector using value representing target cell as index
   // in effect all points belonging to the same output cell will be next to each other
-  std::sort (index_vector.begin (), index_vector.end (), std::less<cloud_point_index_idx> ());
-
-  // Third pass: count output cells
-  // we need to skip all the same, adjacenent idx values
-  unsigned int total=0;
-  unsigned int index=0;
-  while (index < index_vector.size ()) 
-  {
-    unsigned int i = index + 1;
-    while (i < index_vector.size () && index_vector[i].idx == index_vector[index].idx) 
-      ++i;
-    ++total;
-    index = i;
-  }
+  std::vector<int> voxel_begin;
+  sortVoxelGridKeys (keys, layer_keys, index_vector, voxel_begin, threads_);
 
-  // Fourth pass: compute centroids, insert them into their final position
+  // Third pass: compute centroids, insert them into their final position
+  const int total = static_cast<int> (voxel_begin.size ()) - 1;
   output.width = total;
   output.row_step = output.point_step * output.width;
   output.data.resize (output.width * output.point_step);
@@ -388,6 +558,8 @@ pcl::VoxelGrid<sensor_msgs::PointCloud2>::applyFilter (PointCloud2 &output)
   {
     try
     {
+      if (layered_keys || div_xy * div_b_[2] > static_cast<uint64_t> (std::numeric_limits<int>::max ()))
+        throw std::length_error ("VoxelGrid leaf layout");
       leaf_layout_.resize (div_b_[0]*div_b_[1]*div_b_[2], -1);
     }
     catch (std::bad_alloc&)
@@ -412,53 +584,27 @@ pcl::VoxelGrid<sensor_msgs::PointCloud2>::applyFilter (PointCloud2 &output)
     // If not, we must have created a new xyzw cloud
     xyz_offset = Eigen::Array4i (0, 4, 8, 12);
 
-  index=0;
-  Eigen::VectorXf centroid = Eigen::VectorXf::Zero (centroid_size);
-  Eigen::VectorXf temporary = Eigen::VectorXf::Zero (centroid_size);
-
-  for (unsigned int cp = 0; cp < index_vector.size ();)
+#pragma omp parallel num_threads (threads)
   {
-    int point_offset = index_vector[cp].cloud_point_index * input_->point_step;
-    // Do we need to process all the fields?
-    if (!downsample_all_data_) 
-    {
-      memcpy (&pt[0], &input_->data[point_offset+input_->fields[x_idx_].offset], sizeof (float));
-      memcpy (&pt[1], &input_->data[point_offset+input_->fields[y_idx_].offset], sizeof (float));
-      memcpy (&pt[2], &input_->data[point_offset+input_->fields[z_idx_].offset], sizeof (float));
-      centroid[0] = pt[0];
-      centroid[1] = pt[1];
-      centroid[2] = pt[2];
-      centroid[3] = 0;
-    }
-    else
-    {
-      // ---[ RGB special case
-      // fill extra r/g/b centroid field
-      if (rgba_index >= 0)
-      {
-        pcl::RGB rgb;
-        memcpy (&rgb, &input_->data[point_offset + input_->fields[rgba_index].offset], sizeof (RGB));
-        centroid[centroid_size-3] = rgb.r;
-        centroid[centroid_size-2] = rgb.g;
-        centroid[centroid_size-1] = rgb.b;
-      }
-      // Copy all the fields
-      for (unsigned int d = 0; d < input_->fields.size (); ++d)
-        memcpy (&centroid[d], &input_->data[point_offset + input_->fields[d].offset], field_sizes_[d]);
-    }
+    Eigen::VectorXf centroid = Eigen::VectorXf::Zero (centroid_size);
+    Eigen::VectorXf temporary = Eigen::VectorXf::Zero (centroid_size);
+    Eigen::Vector4f pt  = Eigen::Vector4f::Zero ();
 
-    unsigned int i = cp + 1;
-    while (i < index_vector.size () && index_vector[i].idx == index_vector[cp].idx) 
+#pragma omp for schedule (dynamic, 256)
+    for (int index = 0; index < total; ++index)
     {
-      int point_offset = index_vector[i].cloud_point_index * input_->point_step;
+      const int cp = voxel_begin[index];
+      int point_offset = index_vector[cp] * input_->point_step;
+      // Do we need to process all the fields?
       if (!downsample_all_data_) 
       {
         memcpy (&pt[0], &input_->data[point_offset+input_->fields[x_idx_].offset], sizeof (float));
         memcpy (&pt[1], &input_->data[point_offset+input_->fields[y_idx_].offset], sizeof (float));
         memcpy (&pt[2], &input_->data[point_offset+input_->fields[z_idx_].offset], sizeof (float));
-        centroid[0] += pt[0];
-        centroid[1] += pt[1];
-        centroid[2] += pt[2];
+        centroid[0] = pt[0];
+        centroid[1] = pt[1];
+        centroid[2] = pt[2];
+        centroid[3] = 0;
       }
       else
       {
@@ -468,52 +614,80 @@ pcl::VoxelGrid<sensor_msgs::PointCloud2>::applyFilter (PointCloud2 &output)
         {
           pcl::RGB rgb;
           memcpy (&rgb, &input_->data[point_offset + input_->fields[rgba_index].offset], sizeof (RGB));
-          temporary[centroid_size-3] = rgb.r;
-          temporary[centroid_size-2] = rgb.g;
-          temporary[centroid_size-1] = rgb.b;
+          centroid[centroid_size-3] = rgb.r;
+          centroid[centroid_size-2] = rgb.g;
+          centroid[centroid_size-1] = rgb.b;
         }
         // Copy all the fields
         for (unsigned int d = 0; d < input_->fields.size (); ++d)
-          memcpy (&temporary[d], &input_->data[point_offset + input_->fields[d].offset], field_sizes_[d]);
-        centroid+=temporary;
+          memcpy (&centroid[d], &input_->data[point_offset + input_->fields[d].offset], field_sizes_[d]);
+      }
+
+      int i = cp + 1;
+      for (; i < voxel_begin[index + 1]; ++i)
+      {
+        int point_offset = index_vector[i] * input_->point_step;
+        if (!downsample_all_data_) 
+        {
+          memcpy (&pt[0], &input_->data[point_offset+input_->fields[x_idx_].offset], sizeof (float));
+          memcpy (&pt[1], &input_->data[point_offset+input_->fields[y_idx_].offset], sizeof (float));
+          memcpy (&pt[2], &input_->data[point_offset+input_->fields[z_idx_].offset], sizeof (float));
+          centroid[0] += pt[0];
+          centroid[1] += pt[1];
+          centroid[2] += pt[2];
+        }
+        else
+        {
+          // ---[ RGB special case
+          // fill extra r/g/b centroid field
+          if (rgba_index >= 0)
+          {
+            pcl::RGB rgb;
+            memcpy (&rgb, &input_->data[point_offset + input_->fields[rgba_index].offset], sizeof (RGB));
+            temporary[centroid_size-3] = rgb.r;
+            temporary[centroid_size-2] = rgb.g;
+            temporary[centroid_size-1] = rgb.b;
+          }
+          // Copy all the fields
+          for (unsigned int d = 0; d < input_->fields.size (); ++d)
+            memcpy (&temporary[d], &input_->data[point_offset + input_->fields[d].offset], field_sizes_[d]);
+          centroid+=temporary;
+        }
       }
-      ++i;
-    }
 
-	  // Save leaf layout information for fast access to cells relative to current position
-    if (save_leaf_layout_)
-      leaf_layout_[index_vector[cp].idx] = index;
+      // Save leaf layout information for fast access to cells relative to current position
+      if (save_leaf_layout_)
+        leaf_layout_[keys[cp]] = index;
 
-    // Normalize the centroid
-    centroid /= static_cast<float> (i - cp);
+      // Normalize the centroid
+      centroid /= static_cast<float> (i - cp);
 
-    // Do we need to process all the fields?
-    if (!downsample_all_data_)
-    {
-      // Copy the data
-      memcpy (&output.data[xyz_offset[0]], &centroid[0], sizeof (float));
-      memcpy (&output.data[xyz_offset[1]], &centroid[1], sizeof (float));
-      memcpy (&output.data[xyz_offset[2]], &centroid[2], sizeof (float));
-      xyz_offset += output.point_step;
-    }
-    else
-    {
-      int point_offset = index * output.point_step;
-      // Copy all the fields
-      for (size_t d = 0; d < output.fields.size (); ++d)
-        memcpy (&output.data[point_offset + output.fields[d].offset], &centroid[d], field_sizes_[d]);
-
-      // ---[ RGB special case
-      // full extra r/g/b centroid field
-      if (rgba_index >= 0) 
+      // Do we need to process all the fields?
+      if (!downsample_all_data_)
       {
-        float r = centroid[centroid_size-3], g = centroid[centroid_size-2], b = centroid[centroid_size-1];
-        int rgb = (static_cast<int> (r) << 16) | (static_cast<int> (g) << 8) | static_cast<int> (b);
-        memcpy (&output.data[point_offset + output.fields[rgba_index].offset], &rgb, sizeof (float));
+        // Copy the data
+        int output_offset = index * output.point_step;
+        memcpy (&output.data[output_offset + xyz_offset[0]], &centroid[0], sizeof (float));
+        memcpy (&output.data[output_offset + xyz_offset[1]], &centroid[1], sizeof (float));
+        memcpy (&output.data[output_offset + xyz_offset[2]], &centroid[2], sizeof (float));
+      }
+      else
+      {
+        int output_offset = index * output.point_step;
+        // Copy all the fields
+        for (size_t d = 0; d < output.fields.size (); ++d)
+          memcpy (&output.data[output_offset + output.fields[d].offset], &centroid[d], field_sizes_[d]);
+
+        // ---[ RGB special case
+        // full extra r/g/b centroid field
+        if (rgba_index >= 0) 
+        {
+          float r = centroid[centroid_size-3], g = centroid[centroid_size-2], b = centroid[centroid_size-1];
+          int rgb = (static_cast<int> (r) << 16) | (static_cast<int> (g) << 8) | static_cast<int> (b);
+          memcpy (&output.data[output_offset + output.fields[rgba_index].offset], &rgb, sizeof (float));
+        }
       }
     }
-    cp = i;
-    ++index;
   }
 }
 
@@ -0,0 +1,140 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <pcl/filters/voxel_grid_hash_table.h>
+#include <cmath>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::VoxelCountEstimator::merge (const VoxelCountEstimator &other)
+{
+  for (size_t i = 0; i < registers_.size (); ++i)
+    if (other.registers_[i] > registers_[i])
+      registers_[i] = other.registers_[i];
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+size_t
+pcl::VoxelCountEstimator::getEstimate () const
+{
+  const double nr_registers = static_cast<double> (registers_.size ());
+  double sum = 0.0;
+  int nr_zero_registers = 0;
+  for (size_t i = 0; i < registers_.size (); ++i)
+  {
+    sum += std::ldexp (1.0, -static_cast<int> (registers_[i]));
+    if (registers_[i] == 0)
+      ++nr_zero_registers;
+  }
+
+  const double alpha = 0.7213 / (1.0 + 1.079 / nr_registers);
+  double estimate = alpha * nr_registers * nr_registers / sum;
+
+  // Small range correction: count the empty registers instead
+  if (estimate <= 2.5 * nr_registers && nr_zero_registers > 0)
+    estimate = nr_registers * std::log (nr_registers / static_cast<double> (nr_zero_registers));
+
+  return (static_cast<size_t> (estimate + 0.5));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::VoxelCentroidHashTable::VoxelCentroidHashTable (int centroid_size, size_t expected_size) :
+  centroid_size_ (centroid_size), slots_ (), voxels_ (), sums_ ()
+{
+  rehash (16);
+  reserve (expected_size);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::VoxelCentroidHashTable::reserve (size_t expected_size)
+{
+  voxels_.reserve (expected_size);
+  sums_.reserve (expected_size * centroid_size_);
+
+  size_t nr_slots = slots_.size ();
+  while (nr_slots < 2 * expected_size)
+    nr_slots *= 2;
+  if (nr_slots != slots_.size ())
+    rehash (nr_slots);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::VoxelCentroidHashTable::clear ()
+{
+  std::vector<Voxel> ().swap (voxels_);
+  std::vector<float> ().swap (sums_);
+  std::vector<Slot> ().swap (slots_);
+  rehash (16);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::VoxelCentroidHashTable::merge (const VoxelCentroidHashTable &other)
+{
+  reserve (size () + other.size () / 2);
+  for (size_t index = 0; index < other.size (); ++index)
+  {
+    const Voxel &voxel = other.voxels_[index];
+    float *sum = &sums_[findOrInsert (voxel.key, voxel.layer_key, voxel.count) * centroid_size_];
+    const float *other_sum = other.getSum (index);
+    for (size_t d = 0; d < centroid_size_; ++d)
+      sum[d] += other_sum[d];
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::VoxelCentroidHashTable::rehash (size_t nr_slots)
+{
+  Slot empty_slot;
+  empty_slot.index = -1;
+  empty_slot.tag = 0;
+  std::vector<Slot> (nr_slots, empty_slot).swap (slots_);
+
+  const size_t mask = nr_slots - 1;
+  for (size_t index = 0; index < voxels_.size (); ++index)
+  {
+    const uint64_t hash = VoxelCountEstimator::hashVoxelKey (voxels_[index].key, voxels_[index].layer_key);
+    size_t slot = static_cast<size_t> (hash) & mask;
+    while (slots_[slot].index != -1)
+      slot = (slot + 1) & mask;
+    slots_[slot].index = static_cast<int> (index);
+    slots_[slot].tag = static_cast<uint32_t> (hash >> 32);
+  }
+}
@@ -35,6 +35,7 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include <pcl/keypoints/narf_keypoint.h>
 #include <pcl/features/range_image_border_extractor.h>
 #include <pcl/pcl_macros.h>
@@ -309,8 +310,9 @@ NarfKeypoint::calculateCompleteInterestImage ()
     //for (int i=0; i<array_size; ++i)
       //interest_image[i] = -1.0f;
     
+    // The scratch buffers are firstprivate, so every thread works on its own copy
     const int angle_histogram_size = 18;
-    float* angle_histogram = new float[angle_histogram_size];
+    std::vector<float> angle_histogram (angle_histogram_size);
     
     std::vector<bool> was_touched;
     was_touched.resize (array_size, false);
@@ -353,7 +355,7 @@ NarfKeypoint::calculateCompleteInterestImage ()
       neighbors_to_check.push_back (index);
       was_touched[index] = true;
       
-      memset (angle_histogram, 0, angle_histogram_size*sizeof (float));
+      std::fill (angle_histogram.begin (), angle_histogram.end (), 0.0f);
       for (size_t neighbors_to_check_idx=0; neighbors_to_check_idx<neighbors_to_check.size (); ++neighbors_to_check_idx)
       {
         int index2 = neighbors_to_check[neighbors_to_check_idx];
@@ -440,7 +442,6 @@ NarfKeypoint::calculateCompleteInterestImage ()
       }
     }
     
-    delete[] angle_histogram;
     border_extractor.getParameters ().max_no_of_threads = original_max_no_of_threads;
   }
   
@@ -496,10 +497,19 @@ NarfKeypoint::calculateSparseInterestImage ()
     interest_image_[index] = 2.0f;
   }
   
+  // A point whose interest value is still above 1 has not been covered yet. Every uncovered point, in the
+  // order of the image, becomes a center: the points around it get their interest values from the surface changes
+  // around the center, or 0 if these cannot give a high enough value. Which points a center covers depends on the
+  // centers before it, so the centers are found serially, with the points they cover and their surface changes
+  // kept in flat buffers. The interest values, which take most of the time, are then calculated in parallel.
   const int angle_histogram_size = 18;
-  float* angle_histogram = new float[angle_histogram_size];
+  std::vector<float> angle_histogram (angle_histogram_size);
   std::vector<std::vector<std::pair<int, float> > > angle_elements (angle_histogram_size);
-  std::vector<bool> relevant_point_still_valid;
+  
+  std::vector<int> centers;
+  std::vector<int> covered_points, covered_begin (1, 0);
+  std::vector<std::pair<int, float> > relevant_points;
+  std::vector<int> relevant_begin (1, 0);
   
   std::vector<bool> was_touched;
   was_touched.resize (array_size, false);
@@ -507,9 +517,6 @@ NarfKeypoint::calculateSparseInterestImage ()
                    neighbors_within_radius_overhead;
   
   //double interest_value_calculation_start_time = getTime ();
-# pragma omp parallel for default (shared) num_threads (parameters_.max_no_of_threads) schedule (guided, 10) \
-                          firstprivate (was_touched, neighbors_to_check, angle_histogram, neighbors_within_radius_overhead, \
-                                        angle_elements, relevant_point_still_valid) 
   for (int index=0; index<array_size; ++index)
   {
     if (interest_image_[index] <= 1.0f)
@@ -620,107 +627,133 @@ NarfKeypoint::calculateSparseInterestImage ()
     // Every point in distance search_radius cannot have a higher value
     // Therefore: if too low, set all to zero. Else calculate properly
     if (maximum_interest_value < parameters_.min_interest_value)
+    {
       for (size_t neighbors_idx=0; neighbors_idx<neighbors_within_radius_overhead.size (); ++neighbors_idx)
         interest_image_[neighbors_within_radius_overhead[neighbors_idx]] = 0.0f;
-    else
+      continue;
+    }
+    
+    // The uncovered points are covered by this center, and marked with 1 until their values are calculated
+    centers.push_back (index);
+    for (size_t neighbors_idx=0; neighbors_idx<neighbors_within_radius_overhead.size (); ++neighbors_idx)
+    {
+      int index2 = neighbors_within_radius_overhead[neighbors_idx];
+      if (interest_image_[index2] <= 1.0f)
+        continue;
+      interest_image_[index2] = 1.0f;
+      covered_points.push_back (index2);
+    }
+    covered_begin.push_back (static_cast<int> (covered_points.size ()));
+    for (int angle_histogram_idx=0; angle_histogram_idx<angle_histogram_size; ++angle_histogram_idx)
+    {
+      relevant_points.insert (relevant_points.end (), angle_elements[angle_histogram_idx].begin (),
+                              angle_elements[angle_histogram_idx].end ());
+      relevant_begin.push_back (static_cast<int> (relevant_points.size ()));
+    }
+  }
+  
+  const int no_of_centers = static_cast<int> (centers.size ());
+  std::vector<int> relevant_end (angle_histogram_size);
+  std::vector<bool> relevant_point_still_valid;
+# pragma omp parallel for default (shared) num_threads (parameters_.max_no_of_threads) schedule (dynamic, 1) \
+                          firstprivate (angle_histogram, relevant_end, relevant_point_still_valid)
+  for (int center_idx=0; center_idx<no_of_centers; ++center_idx)
+  {
+    // Reduce number of neighbors to go through by filtering close by points with the same angle
+    float min_distance_between_relevant_points = 0.25f * search_radius,
+          min_distance_between_relevant_points_squared = powf(min_distance_between_relevant_points, 2);
+    for (int angle_histogram_idx=0; angle_histogram_idx<angle_histogram_size; ++angle_histogram_idx)
     {
-      // Reduce number of neighbors to go through by filtering close by points with the same angle
-      bool do_neighbor_size_reduction = true;
-      if (do_neighbor_size_reduction)
+      int relevant_idx = center_idx*angle_histogram_size + angle_histogram_idx,
+          no_of_relevant_points = relevant_begin[relevant_idx+1] - relevant_begin[relevant_idx];
+      relevant_end[angle_histogram_idx] = relevant_begin[relevant_idx];
+      if (no_of_relevant_points == 0)
+        continue;
+      std::pair<int,float>* relevent_point_indices = &relevant_points[relevant_begin[relevant_idx]];
+      std::sort(relevent_point_indices, relevent_point_indices + no_of_relevant_points, secondPairElementIsGreater);
+      relevant_point_still_valid.clear();
+      relevant_point_still_valid.resize(no_of_relevant_points, true);
+      for (int rpi_idx1=0; rpi_idx1<no_of_relevant_points-1; ++rpi_idx1)
       {
-        float min_distance_between_relevant_points = 0.25f * search_radius,
-              min_distance_between_relevant_points_squared = powf(min_distance_between_relevant_points, 2);
-        for (int angle_histogram_idx=0; angle_histogram_idx<angle_histogram_size; ++angle_histogram_idx)
+        if (!relevant_point_still_valid[rpi_idx1])
+          continue;
+        const PointWithRange& relevant_point1 = range_image.getPoint (relevent_point_indices[rpi_idx1].first);
+        for (int rpi_idx2=rpi_idx1+1; rpi_idx2<no_of_relevant_points; ++rpi_idx2)
         {
-          std::vector<std::pair<int,float> >& relevent_point_indices = angle_elements[angle_histogram_idx];
-          std::sort(relevent_point_indices.begin(), relevent_point_indices.end(), secondPairElementIsGreater);
-          relevant_point_still_valid.clear();
-          relevant_point_still_valid.resize(relevent_point_indices.size(), true);
-          for (int rpi_idx1=0; rpi_idx1<int(relevent_point_indices.size ())-1; ++rpi_idx1)
-          {
-            if (!relevant_point_still_valid[rpi_idx1])
-              continue;
-            const PointWithRange& relevant_point1 = range_image.getPoint (relevent_point_indices[rpi_idx1].first);
-            for (int rpi_idx2=rpi_idx1+1; rpi_idx2<int(relevent_point_indices.size ()); ++rpi_idx2)
-            {
-              if (!relevant_point_still_valid[rpi_idx2])
-                continue;
-              const PointWithRange& relevant_point2 = range_image.getPoint (relevent_point_indices[rpi_idx2].first);
-              float distance_squared = (relevant_point1.getVector3fMap ()-relevant_point2.getVector3fMap ()).norm ();
-              if (distance_squared > min_distance_between_relevant_points_squared)
-                continue;
-              relevant_point_still_valid[rpi_idx2] = false;
-            }
-          }
-          int newPointIdx=0;
-          for (int oldPointIdx=0; oldPointIdx<int(relevant_point_still_valid.size()); ++oldPointIdx) {
-            if (relevant_point_still_valid[oldPointIdx])
-              relevent_point_indices[newPointIdx++] = relevent_point_indices[oldPointIdx];
-          }
-          relevent_point_indices.resize(newPointIdx);
+          if (!relevant_point_still_valid[rpi_idx2])
+            continue;
+          const PointWithRange& relevant_point2 = range_image.getPoint (relevent_point_indices[rpi_idx2].first);
+          float distance_squared = (relevant_point1.getVector3fMap ()-relevant_point2.getVector3fMap ()).norm ();
+          if (distance_squared > min_distance_between_relevant_points_squared)
+            continue;
+          relevant_point_still_valid[rpi_idx2] = false;
         }
       }
-      
-      // Caclulate interest values for neighbors
-      for (size_t neighbors_idx=0; neighbors_idx<neighbors_within_radius_overhead.size (); ++neighbors_idx)
-      {
-        int index2 = neighbors_within_radius_overhead[neighbors_idx];
-        int y2 = index2/range_image.width,
-            x2 = index2 - y2*range_image.width;
-        const PointWithRange& point2 = range_image.getPoint (index2);
-        float& interest_value = interest_image_[index2];
-        if (interest_value <= 1.0f)
-          continue;
-        float negative_score = 1.0;
+      int newPointIdx=0;
+      for (int oldPointIdx=0; oldPointIdx<no_of_relevant_points; ++oldPointIdx) {
+        if (relevant_point_still_valid[oldPointIdx])
+          relevent_point_indices[newPointIdx++] = relevent_point_indices[oldPointIdx];
+      }
+      relevant_end[angle_histogram_idx] += newPointIdx;
+    }
+    
+    // Caclulate interest values for the covered points
+    for (int covered_idx=covered_begin[center_idx]; covered_idx<covered_begin[center_idx+1]; ++covered_idx)
+    {
+      int index2 = covered_points[covered_idx];
+      float& interest_value = interest_image_[index2];
+      if (interest_value == 0.0f)  // Set to 0 by a later center
+        continue;
+      int y2 = index2/range_image.width,
+          x2 = index2 - y2*range_image.width;
+      const PointWithRange& point2 = range_image.getPoint (index2);
+      float negative_score = 1.0;
 
-        for (int angle_histogram_idx=0; angle_histogram_idx<angle_histogram_size; ++angle_histogram_idx)
+      for (int angle_histogram_idx=0; angle_histogram_idx<angle_histogram_size; ++angle_histogram_idx)
+      {
+        float& histogram_value = angle_histogram[angle_histogram_idx];
+        histogram_value = 0;
+        for (int rpi_idx=relevant_begin[center_idx*angle_histogram_size + angle_histogram_idx];
+             rpi_idx<relevant_end[angle_histogram_idx]; ++rpi_idx)
         {
-          float& histogram_value = angle_histogram[angle_histogram_idx];
-          histogram_value = 0;
-          const std::vector<std::pair<int,float> >& relevent_point_indices = angle_elements[angle_histogram_idx];
-          for (size_t rpi_idx=0; rpi_idx<relevent_point_indices.size (); ++rpi_idx)
-          {
-            int index3 = relevent_point_indices[rpi_idx].first;
-            int y3 = index3/range_image.width,
-                x3 = index3 - y3*range_image.width;
-            const PointWithRange& point3 = range_image.getPoint (index3);
-            float surface_change_score = relevent_point_indices[rpi_idx].second;
-            
-            float pixelDistance = static_cast<float> (std::max (abs (x3-x2), abs (y3-y2)));
-            float distance = (point3.getVector3fMap ()-point2.getVector3fMap ()).norm ();
-            float distance_factor = radius_reciprocal*distance;
-            float positive_score, current_negative_score;
-            nkdGetScores (distance_factor, surface_change_score, pixelDistance,
-                         parameters_.optimal_distance_to_high_surface_change,
-                         current_negative_score, positive_score);
-            histogram_value = (std::max) (histogram_value, positive_score);
-            negative_score  = (std::min) (negative_score, current_negative_score);
-          }
+          int index3 = relevant_points[rpi_idx].first;
+          int y3 = index3/range_image.width,
+              x3 = index3 - y3*range_image.width;
+          const PointWithRange& point3 = range_image.getPoint (index3);
+          float surface_change_score = relevant_points[rpi_idx].second;
+          
+          float pixelDistance = static_cast<float> (std::max (abs (x3-x2), abs (y3-y2)));
+          float distance = (point3.getVector3fMap ()-point2.getVector3fMap ()).norm ();
+          float distance_factor = radius_reciprocal*distance;
+          float positive_score, current_negative_score;
+          nkdGetScores (distance_factor, surface_change_score, pixelDistance,
+                       parameters_.optimal_distance_to_high_surface_change,
+                       current_negative_score, positive_score);
+          histogram_value = (std::max) (histogram_value, positive_score);
+          negative_score  = (std::min) (negative_score, current_negative_score);
         }
-        float angle_change_value = 0.0f;
-        for (int histogram_cell1=0; histogram_cell1<angle_histogram_size-1; ++histogram_cell1)
+      }
+      float angle_change_value = 0.0f;
+      for (int histogram_cell1=0; histogram_cell1<angle_histogram_size-1; ++histogram_cell1)
+      {
+        if (angle_histogram[histogram_cell1]==0.0f)
+          continue;
+        for (int histogram_cell2=histogram_cell1+1; histogram_cell2<angle_histogram_size; ++histogram_cell2)
         {
-          if (angle_histogram[histogram_cell1]==0.0f)
+          if (angle_histogram[histogram_cell2]==0.0f)
             continue;
-          for (int histogram_cell2=histogram_cell1+1; histogram_cell2<angle_histogram_size; ++histogram_cell2)
-          {
-            if (angle_histogram[histogram_cell2]==0.0f)
-              continue;
-            // TODO: lookup table for the following:
-            float normalized_angle_diff = 2.0f*float (histogram_cell2-histogram_cell1)/float (angle_histogram_size);
-            normalized_angle_diff = (normalized_angle_diff <= 1.0f ? normalized_angle_diff : 2.0f-normalized_angle_diff);
-            angle_change_value = std::max (angle_change_value, angle_histogram[histogram_cell1] *
-                                                               angle_histogram[histogram_cell2] *
-                                                               normalized_angle_diff);
-          }
+          // TODO: lookup table for the following:
+          float normalized_angle_diff = 2.0f*float (histogram_cell2-histogram_cell1)/float (angle_histogram_size);
+          normalized_angle_diff = (normalized_angle_diff <= 1.0f ? normalized_angle_diff : 2.0f-normalized_angle_diff);
+          angle_change_value = std::max (angle_change_value, angle_histogram[histogram_cell1] *
+                                                             angle_histogram[histogram_cell2] *
+                                                             normalized_angle_diff);
         }
-        angle_change_value = sqrtf (angle_change_value);
-        interest_value = negative_score * angle_change_value;
       }
+      angle_change_value = sqrtf (angle_change_value);
+      interest_value = negative_score * angle_change_value;
     }
   }
-  delete[] angle_histogram;
-  
   border_extractor.getParameters ().max_no_of_threads = original_max_no_of_threads;
 }
 
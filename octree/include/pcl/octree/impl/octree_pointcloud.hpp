@@ -91,6 +91,8 @@ pcl::octree::OctreePointCloud<PointT, LeafT, OctreeT>::addPointsFromInputCloud (
       }
     }
   }
+
+  finalizeLeafData (static_cast<OctreeT&> (*this));
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,690 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#ifndef OCTREE_OCCUPANCY_MAP_HPP_
+#define OCTREE_OCCUPANCY_MAP_HPP_
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <assert.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <pcl/octree/octree_pointcloud_occupancy_map.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::insertScan (
+    const PointCloud& cloud_arg, const Eigen::Vector3f& origin_arg)
+{
+  const int nr_points = static_cast<int> (cloud_arg.points.size ());
+
+  // ray end points after range limitation; flag indicates if the end point voxel is occupied
+  std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f> > endPoints (nr_points);
+  std::vector<char> endPointState (nr_points, 0);
+
+  enum { INVALID_RAY = 0, FREE_RAY = 1, HIT_RAY = 2 };
+
+  Eigen::Vector3f minPt = origin_arg;
+  Eigen::Vector3f maxPt = origin_arg;
+
+  for (int i = 0; i < nr_points; ++i)
+  {
+    const PointT& point = cloud_arg.points[i];
+    if (!isFinite (point))
+      continue;
+
+    Eigen::Vector3f end (point.x, point.y, point.z);
+    endPointState[i] = HIT_RAY;
+
+    // limit ray to maximum sensor range - the end point does not indicate an obstacle anymore
+    if (maxRange_ > 0.0)
+    {
+      Eigen::Vector3f direction = end - origin_arg;
+      float length = direction.norm ();
+      if (length > maxRange_)
+      {
+        end = origin_arg + direction * static_cast<float> (maxRange_ / length);
+        endPointState[i] = FREE_RAY;
+      }
+    }
+
+    endPoints[i] = end;
+    minPt = minPt.cwiseMin (end);
+    maxPt = maxPt.cwiseMax (end);
+  }
+
+  // make sure bounding box is big enough for all rays
+  if (this->leafCount_ == 0)
+  {
+    const float minValue = std::numeric_limits<float>::epsilon () * 512.0f;
+    double minX = minPt.x (), minY = minPt.y (), minZ = minPt.z ();
+    double maxX = maxPt.x () + minValue, maxY = maxPt.y () + minValue, maxZ = maxPt.z () + minValue;
+
+    if (this->boundingBoxDefined_)
+    {
+      minX = std::min (minX, this->minX_);
+      minY = std::min (minY, this->minY_);
+      minZ = std::min (minZ, this->minZ_);
+      maxX = std::max (maxX, this->maxX_);
+      maxY = std::max (maxY, this->maxY_);
+      maxZ = std::max (maxZ, this->maxZ_);
+    }
+
+    this->defineBoundingBox (minX, minY, minZ, maxX, maxY, maxZ);
+  }
+  else
+  {
+    PointT point;
+    point.x = minPt.x (); point.y = minPt.y (); point.z = minPt.z ();
+    this->adoptBoundingBoxToPoint (point);
+    point.x = maxPt.x (); point.y = maxPt.y (); point.z = maxPt.z ();
+    this->adoptBoundingBoxToPoint (point);
+  }
+
+  // traverse rays in parallel - each thread collects keys in its own buffers
+  const int threads = static_cast<int> (threads_);
+  std::vector<std::vector<OctreeKey> > freeKeys (threads);
+  std::vector<std::vector<OctreeKey> > occupiedKeys (threads);
+
+  const Eigen::Vector3d origin = origin_arg.cast<double> ();
+  const size_t maxBufferSize = 1 << 20;
+
+#pragma omp parallel for schedule (dynamic, 64) num_threads (threads)
+  for (int i = 0; i < nr_points; ++i)
+  {
+#ifdef _OPENMP
+    int tid = omp_get_thread_num ();
+#else
+    int tid = 0;
+#endif
+    if (endPointState[i] == INVALID_RAY)
+      continue;
+
+    const Eigen::Vector3d end = endPoints[i].cast<double> ();
+
+    computeRayKeys (origin, end, freeKeys[tid]);
+
+    if (endPointState[i] == HIT_RAY)
+    {
+      OctreeKey key;
+      genOctreeKeyforPoint (end, key);
+      occupiedKeys[tid].push_back (key);
+    }
+
+    // bound the memory used by the key buffers of long scans
+    if (freeKeys[tid].size () > maxBufferSize)
+      sortAndRemoveDuplicates (freeKeys[tid]);
+  }
+
+#pragma omp parallel for num_threads (threads)
+  for (int t = 0; t < threads; ++t)
+  {
+    sortAndRemoveDuplicates (freeKeys[t]);
+    sortAndRemoveDuplicates (occupiedKeys[t]);
+  }
+
+  // merge thread buffers
+  for (int t = 1; t < threads; ++t)
+  {
+    freeKeys[0].insert (freeKeys[0].end (), freeKeys[t].begin (), freeKeys[t].end ());
+    std::vector<OctreeKey> ().swap (freeKeys[t]);
+    occupiedKeys[0].insert (occupiedKeys[0].end (), occupiedKeys[t].begin (), occupiedKeys[t].end ());
+    std::vector<OctreeKey> ().swap (occupiedKeys[t]);
+  }
+  if (threads > 1)
+  {
+    sortAndRemoveDuplicates (freeKeys[0]);
+    sortAndRemoveDuplicates (occupiedKeys[0]);
+  }
+
+  // voxels that contain an end point are only updated as occupied
+  std::vector<OctreeKey> freeOnlyKeys;
+  freeOnlyKeys.reserve (freeKeys[0].size ());
+  std::set_difference (freeKeys[0].begin (), freeKeys[0].end (),
+                       occupiedKeys[0].begin (), occupiedKeys[0].end (),
+                       std::back_inserter (freeOnlyKeys), OctreeKeyLess ());
+
+  // integrate measurements - keys are in depth-first order of the octree
+  for (std::vector<OctreeKey>::const_iterator it = freeOnlyKeys.begin (); it != freeOnlyKeys.end (); ++it)
+    updateVoxel (*it, logOddsMiss_);
+
+  for (std::vector<OctreeKey>::const_iterator it = occupiedKeys[0].begin (); it != occupiedKeys[0].end (); ++it)
+    updateVoxel (*it, logOddsHit_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::updateVoxelAtPoint (const PointT& point_arg,
+                                                                                     bool occupied_arg)
+{
+  OctreeKey key;
+
+  // make sure bounding box is big enough
+  this->adoptBoundingBoxToPoint (point_arg);
+
+  // generate key
+  this->genOctreeKeyforPoint (point_arg, key);
+
+  updateVoxel (key, occupied_arg ? logOddsHit_ : logOddsMiss_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::addPointsFromInputCloud ()
+{
+  if (this->indices_)
+  {
+    for (std::vector<int>::const_iterator current = this->indices_->begin (); current != this->indices_->end (); ++current)
+    {
+      if (isFinite (this->input_->points[*current]))
+        updateVoxelAtPoint (this->input_->points[*current], true);
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < this->input_->points.size (); i++)
+    {
+      if (isFinite (this->input_->points[i]))
+        updateVoxelAtPoint (this->input_->points[i], true);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> bool
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::getOccupancyAtPoint (const PointT& point_arg,
+                                                                                      double& probability_arg) const
+{
+  OctreeKey key;
+
+  if (!this->isPointWithinBoundingBox (point_arg))
+    return (false);
+
+  this->genOctreeKeyforPoint (point_arg, key);
+
+  const LeafT* leaf = findOccupancyLeaf (key);
+  if (!leaf)
+    return (false);
+
+  probability_arg = leaf->getOccupancy ();
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> bool
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::isVoxelOccupiedAtPoint (const PointT& point_arg) const
+{
+  OctreeKey key;
+
+  if (!this->isPointWithinBoundingBox (point_arg))
+    return (false);
+
+  this->genOctreeKeyforPoint (point_arg, key);
+
+  const LeafT* leaf = findOccupancyLeaf (key);
+  return ((leaf != 0) && (leaf->getLogOdds () > occupancyThres_));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> bool
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::isVoxelOccupiedAtPoint (
+    const double pointX_arg, const double pointY_arg, const double pointZ_arg) const
+{
+  PointT point;
+  point.x = static_cast<float> (pointX_arg);
+  point.y = static_cast<float> (pointY_arg);
+  point.z = static_cast<float> (pointZ_arg);
+
+  return (isVoxelOccupiedAtPoint (point));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> bool
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::isVoxelFreeAtPoint (const PointT& point_arg) const
+{
+  OctreeKey key;
+
+  if (!this->isPointWithinBoundingBox (point_arg))
+    return (false);
+
+  this->genOctreeKeyforPoint (point_arg, key);
+
+  const LeafT* leaf = findOccupancyLeaf (key);
+  return ((leaf != 0) && (leaf->getLogOdds () <= occupancyThres_));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::deleteVoxelAtPoint (const PointT& point_arg)
+{
+  OctreeKey key;
+
+  if (!this->isPointWithinBoundingBox (point_arg))
+    return;
+
+  this->genOctreeKeyforPoint (point_arg, key);
+
+  // leaf nodes can only be removed at maximum tree depth
+  expandPath (key);
+  this->removeLeaf (key);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> int
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::getOccupiedVoxelCenters (
+    AlignedPointTVector &voxelCenterList_arg) const
+{
+  OctreeKey key;
+  voxelCenterList_arg.clear ();
+  return (getVoxelCentersRecursive (*this->rootNode_, key, 0, true, voxelCenterList_arg));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> int
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::getFreeVoxelCenters (
+    AlignedPointTVector &voxelCenterList_arg) const
+{
+  OctreeKey key;
+  voxelCenterList_arg.clear ();
+  return (getVoxelCentersRecursive (*this->rootNode_, key, 0, false, voxelCenterList_arg));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::prune ()
+{
+  pruneRecursive (*this->rootNode_);
+
+  // release memory of merged nodes
+  this->poolCleanUp ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::expand ()
+{
+  expandRecursive (*this->rootNode_, this->depthMask_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::sortAndRemoveDuplicates (
+    std::vector<OctreeKey>& keys_arg)
+{
+  std::sort (keys_arg.begin (), keys_arg.end (), OctreeKeyLess ());
+  keys_arg.erase (std::unique (keys_arg.begin (), keys_arg.end ()), keys_arg.end ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::computeRayKeys (
+    const Eigen::Vector3d& origin_arg, const Eigen::Vector3d& end_arg, std::vector<OctreeKey>& keys_arg) const
+{
+  OctreeKey key;
+  OctreeKey endKey;
+
+  genOctreeKeyforPoint (origin_arg, key);
+  genOctreeKeyforPoint (end_arg, endKey);
+
+  if (key == endKey)
+    return;
+
+  Eigen::Vector3d direction = end_arg - origin_arg;
+  const double length = direction.norm ();
+  direction /= length;
+
+  unsigned int* keyIdx[3] = { &key.x, &key.y, &key.z };
+  const double minCoord[3] = { this->minX_, this->minY_, this->minZ_ };
+
+  int step[3];
+  double tMax[3];
+  double tDelta[3];
+
+  // initialize 3D-DDA: distance along the ray to the first voxel border and between voxel borders for each axis
+  for (int i = 0; i < 3; ++i)
+  {
+    if (direction[i] > 0.0)
+    {
+      step[i] = 1;
+      tMax[i] = ((*keyIdx[i] + 1) * this->resolution_ + minCoord[i] - origin_arg[i]) / direction[i];
+      tDelta[i] = this->resolution_ / direction[i];
+    }
+    else if (direction[i] < 0.0)
+    {
+      step[i] = -1;
+      tMax[i] = ((*keyIdx[i]) * this->resolution_ + minCoord[i] - origin_arg[i]) / direction[i];
+      tDelta[i] = -this->resolution_ / direction[i];
+    }
+    else
+    {
+      step[i] = 0;
+      tMax[i] = std::numeric_limits<double>::max ();
+      tDelta[i] = std::numeric_limits<double>::max ();
+    }
+  }
+
+  while (true)
+  {
+    keys_arg.push_back (key);
+
+    // step into the neighboring voxel with the closest border
+    int dim = (tMax[0] < tMax[1]) ? ((tMax[0] < tMax[2]) ? 0 : 2) : ((tMax[1] < tMax[2]) ? 1 : 2);
+
+    // end of ray reached (can happen due to limited numerical precision)
+    if (tMax[dim] > length)
+      break;
+
+    *keyIdx[dim] += step[dim];
+    tMax[dim] += tDelta[dim];
+
+    if ((key == endKey) || !(key <= this->maxKey_))
+      break;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::updateVoxel (const OctreeKey& key_arg,
+                                                                              float logOdds_arg)
+{
+  OctreeBranch* branch = this->rootNode_;
+  unsigned int depthMask = this->depthMask_;
+  unsigned char childIdx;
+
+  // walk down the tree, create missing branches and expand pruned leaf nodes
+  while (depthMask > 1)
+  {
+    childIdx = key_arg.getChildIdxWithDepthMask (depthMask);
+    OctreeNode* childNode = this->getBranchChild (*branch, childIdx);
+
+    if (!childNode)
+    {
+      OctreeBranch* newBranch;
+      this->createBranchChild (*branch, childIdx, newBranch);
+      this->branchCount_++;
+      branch = newBranch;
+    }
+    else if (childNode->getNodeType () == LEAF_NODE)
+    {
+      const float logOdds = static_cast<LeafT*> (childNode)->getLogOdds ();
+
+      // pruned subtree is already saturated - the update does not change it
+      if (((logOdds_arg >= 0.0f) && (logOdds >= clampingMax_)) || ((logOdds_arg < 0.0f) && (logOdds <= clampingMin_)))
+        return;
+
+      branch = expandLeafChild (*branch, childIdx);
+    }
+    else
+    {
+      branch = static_cast<OctreeBranch*> (childNode);
+    }
+
+    depthMask >>= 1;
+  }
+
+  // we reached leaf node level
+  childIdx = key_arg.getChildIdxWithDepthMask (1);
+
+  LeafT* leaf;
+  if (!this->branchHasChild (*branch, childIdx))
+  {
+    this->createLeafChild (*branch, childIdx, leaf);
+    this->leafCount_++;
+  }
+  else
+  {
+    leaf = static_cast<LeafT*> (this->getBranchChild (*branch, childIdx));
+  }
+
+  leaf->updateLogOdds (logOdds_arg, clampingMin_, clampingMax_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> const LeafT*
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::findOccupancyLeaf (const OctreeKey& key_arg) const
+{
+  if (!(key_arg <= this->maxKey_))
+    return (0);
+
+  const OctreeBranch* branch = this->rootNode_;
+  unsigned int depthMask = this->depthMask_;
+
+  while (depthMask > 1)
+  {
+    const OctreeNode* childNode = this->getBranchChild (*branch, key_arg.getChildIdxWithDepthMask (depthMask));
+
+    if (!childNode)
+      return (0);
+
+    // pruned leaf node covers the voxel
+    if (childNode->getNodeType () == LEAF_NODE)
+      return (static_cast<const LeafT*> (childNode));
+
+    branch = static_cast<const OctreeBranch*> (childNode);
+    depthMask >>= 1;
+  }
+
+  return (static_cast<const LeafT*> (this->getBranchChild (*branch, key_arg.getChildIdxWithDepthMask (1))));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::expandPath (const OctreeKey& key_arg)
+{
+  if (!(key_arg <= this->maxKey_))
+    return;
+
+  OctreeBranch* branch = this->rootNode_;
+  unsigned int depthMask = this->depthMask_;
+
+  while (depthMask > 1)
+  {
+    unsigned char childIdx = key_arg.getChildIdxWithDepthMask (depthMask);
+    OctreeNode* childNode = this->getBranchChild (*branch, childIdx);
+
+    if (!childNode)
+      return;
+
+    if (childNode->getNodeType () == LEAF_NODE)
+      branch = expandLeafChild (*branch, childIdx);
+    else
+      branch = static_cast<OctreeBranch*> (childNode);
+
+    depthMask >>= 1;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> typename pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::OctreeBranch*
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::expandLeafChild (OctreeBranch& branch_arg,
+                                                                                  unsigned char childIdx_arg)
+{
+  const float logOdds = static_cast<LeafT*> (this->getBranchChild (branch_arg, childIdx_arg))->getLogOdds ();
+
+  // replace pruned leaf node by a branch node
+  this->deleteBranchChild (branch_arg, childIdx_arg);
+  this->leafCount_--;
+
+  OctreeBranch* newBranch;
+  this->createBranchChild (branch_arg, childIdx_arg, newBranch);
+  this->branchCount_++;
+
+  // children inherit the occupancy of the pruned leaf node
+  for (unsigned char childIdx = 0; childIdx < 8; childIdx++)
+  {
+    LeafT* childLeaf;
+    this->createLeafChild (*newBranch, childIdx, childLeaf);
+    childLeaf->setLogOdds (logOdds);
+    this->leafCount_++;
+  }
+
+  return (newBranch);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::pruneRecursive (OctreeBranch& branch_arg)
+{
+  for (unsigned char childIdx = 0; childIdx < 8; childIdx++)
+  {
+    OctreeNode* childNode = this->getBranchChild (branch_arg, childIdx);
+
+    if (!childNode || (childNode->getNodeType () != BRANCH_NODE))
+      continue;
+
+    OctreeBranch* childBranch = static_cast<OctreeBranch*> (childNode);
+
+    // prune bottom-up
+    pruneRecursive (*childBranch);
+
+    // check if all eight children are leaf nodes of identical occupancy
+    bool bHomogeneous = true;
+    float logOdds = 0.0f;
+    for (unsigned char i = 0; (i < 8) && bHomogeneous; i++)
+    {
+      const OctreeNode* leafNode = this->getBranchChild (*childBranch, i);
+
+      if (!leafNode || (leafNode->getNodeType () != LEAF_NODE))
+      {
+        bHomogeneous = false;
+        break;
+      }
+
+      const float leafLogOdds = static_cast<const LeafT*> (leafNode)->getLogOdds ();
+      if (i == 0)
+        logOdds = leafLogOdds;
+      else
+        bHomogeneous = (leafLogOdds == logOdds);
+    }
+
+    if (bHomogeneous)
+    {
+      // merge child branch into a single leaf node
+      this->deleteBranchChild (branch_arg, childIdx);
+      this->leafCount_ -= 8;
+      this->branchCount_--;
+
+      LeafT* newLeaf;
+      this->createLeafChild (branch_arg, childIdx, newLeaf);
+      newLeaf->setLogOdds (logOdds);
+      this->leafCount_++;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::expandRecursive (OctreeBranch& branch_arg,
+                                                                                  unsigned int depthMask_arg)
+{
+  // children at maximum tree depth are never pruned
+  if (depthMask_arg <= 1)
+    return;
+
+  for (unsigned char childIdx = 0; childIdx < 8; childIdx++)
+  {
+    OctreeNode* childNode = this->getBranchChild (branch_arg, childIdx);
+
+    if (!childNode)
+      continue;
+
+    OctreeBranch* childBranch;
+    if (childNode->getNodeType () == LEAF_NODE)
+      childBranch = expandLeafChild (branch_arg, childIdx);
+    else
+      childBranch = static_cast<OctreeBranch*> (childNode);
+
+    expandRecursive (*childBranch, depthMask_arg >> 1);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> int
+pcl::octree::OctreePointCloudOccupancyMap<PointT, LeafT, OctreeT>::getVoxelCentersRecursive (
+    const OctreeBranch& branch_arg, const OctreeKey& key_arg, unsigned int treeDepth_arg,
+    bool occupied_arg, AlignedPointTVector &voxelCenterList_arg) const
+{
+  int voxelCount = 0;
+
+  for (unsigned char childIdx = 0; childIdx < 8; childIdx++)
+  {
+    const OctreeNode* childNode = this->getBranchChild (branch_arg, childIdx);
+
+    if (!childNode)
+      continue;
+
+    // generate new key for current branch voxel
+    OctreeKey childKey (key_arg);
+    childKey.pushBranch (childIdx);
+
+    if (childNode->getNodeType () == BRANCH_NODE)
+    {
+      voxelCount += getVoxelCentersRecursive (*static_cast<const OctreeBranch*> (childNode), childKey,
+                                              treeDepth_arg + 1, occupied_arg, voxelCenterList_arg);
+      continue;
+    }
+
+    const LeafT* leaf = static_cast<const LeafT*> (childNode);
+    if ((leaf->getLogOdds () > occupancyThres_) != occupied_arg)
+      continue;
+
+    // pruned leaf nodes cover 2^shift voxels along each axis
+    const unsigned int shift = this->octreeDepth_ - (treeDepth_arg + 1);
+    const unsigned int span = 1u << shift;
+
+    for (unsigned int x = 0; x < span; ++x)
+      for (unsigned int y = 0; y < span; ++y)
+        for (unsigned int z = 0; z < span; ++z)
+        {
+          PointT newPoint;
+          this->genLeafNodeCenterFromOctreeKey (OctreeKey ((childKey.x << shift) + x,
+                                                           (childKey.y << shift) + y,
+                                                           (childKey.z << shift) + z), newPoint);
+          voxelCenterList_arg.push_back (newPoint);
+          voxelCount++;
+        }
+  }
+
+  return (voxelCount);
+}
+
+#endif /* OCTREE_OCCUPANCY_MAP_HPP_ */
@@ -0,0 +1,472 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#ifndef OCTREE_STREAMING_CHANGEDETECTOR_HPP_
+#define OCTREE_STREAMING_CHANGEDETECTOR_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <assert.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <pcl/octree/octree_pointcloud_streaming_changedetector.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> const uint64_t
+pcl::octree::OctreePointCloudStreamingChangeDetector<PointT>::EMPTY_CODE;
+
+template<typename PointT> const unsigned int
+pcl::octree::OctreePointCloudStreamingChangeDetector<PointT>::KEY_BITS;
+
+template<typename PointT> const std::size_t
+pcl::octree::OctreePointCloudStreamingChangeDetector<PointT>::MIN_SHARD_SIZE;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT>
+pcl::octree::OctreePointCloudStreamingChangeDetector<PointT>::OctreePointCloudStreamingChangeDetector (
+    const double resolution_arg, std::size_t maxPointsPerFrame_arg, std::size_t maxVoxelsPerFrame_arg) :
+  resolution_ (resolution_arg),
+  input_ (),
+  indices_ (),
+  maxPoints_ (maxPointsPerFrame_arg),
+  tableSize_ (MIN_SHARD_SIZE),
+  selector_ (0),
+  pointCodes_ (maxPointsPerFrame_arg, EMPTY_CODE),
+  pointCount_ (0),
+  shardCodes_ (maxPointsPerFrame_arg, EMPTY_CODE),
+  shardOffsets_ (),
+  shardBounds_ (),
+  pointFlags_ (maxPointsPerFrame_arg, 0),
+  droppedPoints_ (0),
+  threads_ (1)
+{
+  assert (resolution_arg > 0.0);
+
+  // keep the load factor of the voxel tables below 0.5
+  while (tableSize_ < 2 * maxVoxelsPerFrame_arg)
+    tableSize_ <<= 1;
+
+  for (unsigned char b = 0; b < 2; ++b)
+  {
+    buffers_[b].codes.resize (tableSize_, EMPTY_CODE);
+    buffers_[b].counts.resize (tableSize_, 0);
+    buffers_[b].shardFill.resize (tableSize_ / MIN_SHARD_SIZE, 0);
+    buffers_[b].shardBits = 0;
+    buffers_[b].voxelCount = 0;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::octree::OctreePointCloudStreamingChangeDetector<PointT>::addPointsFromInputCloud ()
+{
+  assert (input_);
+
+  VoxelTable& table = buffers_[selector_];
+
+  const std::size_t inputSize = indices_ ? indices_->size () : input_->points.size ();
+  const std::size_t nr_points = std::min (inputSize, maxPoints_);
+  droppedPoints_ += inputSize - nr_points;
+  pointCount_ = nr_points;
+
+  // the shard layout can only be chosen while the table is empty
+  if (table.voxelCount == 0)
+  {
+    table.shardBits = 0;
+    while ((1u << (table.shardBits + 1)) <= threads_ && (tableSize_ >> (table.shardBits + 1)) >= MIN_SHARD_SIZE)
+      ++table.shardBits;
+  }
+
+  const int threads = static_cast<int> (threads_);
+  const long nr_points_l = static_cast<long> (nr_points);
+
+#pragma omp parallel for num_threads (threads)
+  for (long i = 0; i < nr_points_l; ++i)
+  {
+    const PointT& point = indices_ ? input_->points[(*indices_)[i]] : input_->points[i];
+    pointCodes_[i] = genMortonCodeForPoint (point);
+  }
+
+  const int shards = 1 << table.shardBits;
+  long dropped = 0;
+
+  if (shards == 1)
+  {
+    if (nr_points > 0)
+      dropped = static_cast<long> (insertShard (0, &pointCodes_[0], nr_points));
+  }
+  else
+  {
+    partitionPointCodes (nr_points);
+
+#pragma omp parallel for schedule (static, 1) num_threads (threads) reduction (+:dropped)
+    for (int shard = 0; shard < shards; ++shard)
+    {
+      const std::size_t count = shardBounds_[shard + 1] - shardBounds_[shard];
+      if (count > 0)
+        dropped += static_cast<long> (insertShard (static_cast<unsigned int> (shard),
+                                                   &shardCodes_[shardBounds_[shard]], count));
+    }
+  }
+
+  droppedPoints_ += static_cast<std::size_t> (dropped);
+
+  table.voxelCount = 0;
+  for (int shard = 0; shard < shards; ++shard)
+    table.voxelCount += table.shardFill[shard];
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::octree::OctreePointCloudStreamingChangeDetector<PointT>::partitionPointCodes (std::size_t pointCount_arg)
+{
+  const unsigned int shardBits = buffers_[selector_].shardBits;
+  const std::size_t shards = static_cast<std::size_t> (1) << shardBits;
+  const int blocks = static_cast<int> (threads_);
+
+  // one row of counters per block of points, padded by a cache line so that no two threads write to the same line.
+  // The rows only grow when the number of threads does.
+  const std::size_t stride = shards + 8;
+  if (shardOffsets_.size () < blocks * stride)
+    shardOffsets_.resize (blocks * stride);
+  if (shardBounds_.size () < shards + 1)
+    shardBounds_.resize (shards + 1);
+  std::fill (shardOffsets_.begin (), shardOffsets_.end (), 0);
+
+#pragma omp parallel for schedule (static, 1) num_threads (blocks)
+  for (int block = 0; block < blocks; ++block)
+  {
+    std::size_t* counts = &shardOffsets_[block * stride];
+    const std::size_t end = pointCount_arg * (block + 1) / blocks;
+    for (std::size_t i = pointCount_arg * block / blocks; i < end; ++i)
+    {
+      const uint64_t code = pointCodes_[i];
+      if (code != EMPTY_CODE)
+        ++counts[hashCode (code) >> (64 - shardBits)];
+    }
+  }
+
+  // exclusive prefix sum in shard-major order: every shard becomes one contiguous slice, within which the blocks
+  // and thus the points keep their order
+  std::size_t offset = 0;
+  for (std::size_t shard = 0; shard < shards; ++shard)
+  {
+    shardBounds_[shard] = offset;
+    for (int block = 0; block < blocks; ++block)
+    {
+      const std::size_t count = shardOffsets_[block * stride + shard];
+      shardOffsets_[block * stride + shard] = offset;
+      offset += count;
+    }
+  }
+  shardBounds_[shards] = offset;
+
+#pragma omp parallel for schedule (static, 1) num_threads (blocks)
+  for (int block = 0; block < blocks; ++block)
+  {
+    std::size_t* positions = &shardOffsets_[block * stride];
+    const std::size_t end = pointCount_arg * (block + 1) / blocks;
+    for (std::size_t i = pointCount_arg * block / blocks; i < end; ++i)
+    {
+      const uint64_t code = pointCodes_[i];
+      if (code != EMPTY_CODE)
+        shardCodes_[positions[hashCode (code) >> (64 - shardBits)]++] = code;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> std::size_t
+pcl::octree::OctreePointCloudStreamingChangeDetector<PointT>::insertShard (unsigned int shard_arg,
+                                                                            const uint64_t* codes_arg,
+                                                                            std::size_t count_arg)
+{
+  VoxelTable& table = buffers_[selector_];
+
+  const std::size_t shardSize = tableSize_ >> table.shardBits;
+  const std::size_t shardMask = shardSize - 1;
+  const std::size_t shardOffset = shard_arg * shardSize;
+  std::size_t& fill = table.shardFill[shard_arg];
+
+  std::size_t dropped = 0;
+
+  for (std::size_t i = 0; i < count_arg; ++i)
+  {
+    const uint64_t code = codes_arg[i];
+    if (code == EMPTY_CODE)
+      continue;
+
+    const uint64_t hash = hashCode (code);
+    std::size_t slot = static_cast<std::size_t> (hash) & shardMask;
+    while (true)
+    {
+      const std::size_t idx = shardOffset + slot;
+      const uint64_t slotCode = table.codes[idx];
+
+      if (slotCode == code)
+      {
+        ++table.counts[idx];
+        break;
+      }
+
+      if (slotCode == EMPTY_CODE)
+      {
+        // keep at least one empty slot per shard - probing terminates
+        if (fill + 1 >= shardSize)
+        {
+          ++dropped;
+          break;
+        }
+
+        table.codes[idx] = code;
+        table.counts[idx] = 1;
+        ++fill;
+        break;
+      }
+
+      slot = (slot + 1) & shardMask;
+    }
+  }
+
+  return (dropped);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::octree::OctreePointCloudStreamingChangeDetector<PointT>::switchBuffers ()
+{
+  selector_ ^= 1;
+
+  VoxelTable& table = buffers_[selector_];
+
+  if (table.voxelCount > 0)
+  {
+    std::fill (table.codes.begin (), table.codes.end (), EMPTY_CODE);
+    std::fill (table.shardFill.begin (), table.shardFill.end (), 0);
+    table.voxelCount = 0;
+  }
+
+  pointCount_ = 0;
+  droppedPoints_ = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> int
+pcl::octree::OctreePointCloudStreamingChangeDetector<PointT>::getPointIndicesFromNewVoxels (
+    std::vector<int> &indicesVector_arg, const int minPointsPerLeaf_arg)
+{
+  const VoxelTable& current = buffers_[selector_];
+  const VoxelTable& previous = buffers_[selector_ ^ 1];
+
+  const unsigned int minPoints = static_cast<unsigned int> (std::max (minPointsPerLeaf_arg, 0));
+  const int threads = static_cast<int> (threads_);
+  const long nr_points = static_cast<long> (pointCount_);
+
+#pragma omp parallel for num_threads (threads)
+  for (long i = 0; i < nr_points; ++i)
+  {
+    const uint64_t code = pointCodes_[i];
+    char isNew = 0;
+
+    if (code != EMPTY_CODE)
+    {
+      const long slot = findSlot (current, code);
+      if ((slot >= 0) && (current.counts[slot] >= minPoints) && (findSlot (previous, code) < 0))
+        isNew = 1;
+    }
+
+    pointFlags_[i] = isNew;
+  }
+
+  indicesVector_arg.clear ();
+  for (long i = 0; i < nr_points; ++i)
+    if (pointFlags_[i])
+      indicesVector_arg.push_back (indices_ ? (*indices_)[i] : static_cast<int> (i));
+
+  return (static_cast<int> (indicesVector_arg.size ()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> int
+pcl::octree::OctreePointCloudStreamingChangeDetector<PointT>::getNewVoxelCenters (
+    AlignedPointTVector &voxelCenterList_arg, const int minPointsPerLeaf_arg) const
+{
+  const VoxelTable& current = buffers_[selector_];
+  const VoxelTable& previous = buffers_[selector_ ^ 1];
+
+  const unsigned int minPoints = static_cast<unsigned int> (std::max (minPointsPerLeaf_arg, 0));
+
+  voxelCenterList_arg.clear ();
+  if (current.voxelCount == 0)
+    return (0);
+
+  PointT center;
+  for (std::size_t idx = 0; idx < tableSize_; ++idx)
+  {
+    const uint64_t code = current.codes[idx];
+    if ((code != EMPTY_CODE) && (current.counts[idx] >= minPoints) && (findSlot (previous, code) < 0))
+    {
+      genVoxelCenterFromMortonCode (code, center);
+      voxelCenterList_arg.push_back (center);
+    }
+  }
+
+  return (static_cast<int> (voxelCenterList_arg.size ()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> int
+pcl::octree::OctreePointCloudStreamingChangeDetector<PointT>::getRemovedVoxelCenters (
+    AlignedPointTVector &voxelCenterList_arg) const
+{
+  const VoxelTable& current = buffers_[selector_];
+  const VoxelTable& previous = buffers_[selector_ ^ 1];
+
+  voxelCenterList_arg.clear ();
+  if (previous.voxelCount == 0)
+    return (0);
+
+  PointT center;
+  for (std::size_t idx = 0; idx < tableSize_; ++idx)
+  {
+    const uint64_t code = previous.codes[idx];
+    if ((code != EMPTY_CODE) && (findSlot (current, code) < 0))
+    {
+      genVoxelCenterFromMortonCode (code, center);
+      voxelCenterList_arg.push_back (center);
+    }
+  }
+
+  return (static_cast<int> (voxelCenterList_arg.size ()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> long
+pcl::octree::OctreePointCloudStreamingChangeDetector<PointT>::findSlot (const VoxelTable& table_arg,
+                                                                        uint64_t code_arg) const
+{
+  if (table_arg.voxelCount == 0)
+    return (-1);
+
+  const uint64_t hash = hashCode (code_arg);
+  const std::size_t shardSize = tableSize_ >> table_arg.shardBits;
+  const std::size_t shardMask = shardSize - 1;
+  const std::size_t shardOffset =
+      table_arg.shardBits ? static_cast<std::size_t> (hash >> (64 - table_arg.shardBits)) * shardSize : 0;
+
+  std::size_t slot = static_cast<std::size_t> (hash) & shardMask;
+  while (true)
+  {
+    const std::size_t idx = shardOffset + slot;
+    const uint64_t slotCode = table_arg.codes[idx];
+
+    if (slotCode == code_arg)
+      return (static_cast<long> (idx));
+    if (slotCode == EMPTY_CODE)
+      return (-1);
+
+    slot = (slot + 1) & shardMask;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> uint64_t
+pcl::octree::OctreePointCloudStreamingChangeDetector<PointT>::genMortonCodeForPoint (const PointT& point_arg) const
+{
+  if (!pcl_isfinite (point_arg.x) || !pcl_isfinite (point_arg.y) || !pcl_isfinite (point_arg.z))
+    return (EMPTY_CODE);
+
+  const double offset = static_cast<double> (1 << (KEY_BITS - 1));
+  const double maxKey = static_cast<double> (1 << KEY_BITS);
+
+  const double x = std::floor (static_cast<double> (point_arg.x) / resolution_) + offset;
+  const double y = std::floor (static_cast<double> (point_arg.y) / resolution_) + offset;
+  const double z = std::floor (static_cast<double> (point_arg.z) / resolution_) + offset;
+
+  if ((x < 0.0) || (y < 0.0) || (z < 0.0) || (x >= maxKey) || (y >= maxKey) || (z >= maxKey))
+    return (EMPTY_CODE);
+
+  // child index order of the octree: x is the most significant bit
+  return ((spreadBits (static_cast<uint64_t> (x)) << 2) |
+          (spreadBits (static_cast<uint64_t> (y)) << 1) |
+           spreadBits (static_cast<uint64_t> (z)));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::octree::OctreePointCloudStreamingChangeDetector<PointT>::genVoxelCenterFromMortonCode (uint64_t code_arg,
+                                                                                          PointT& point_arg) const
+{
+  const double offset = static_cast<double> (1 << (KEY_BITS - 1));
+
+  point_arg.x = static_cast<float> ((static_cast<double> (compactBits (code_arg >> 2)) - offset + 0.5) * resolution_);
+  point_arg.y = static_cast<float> ((static_cast<double> (compactBits (code_arg >> 1)) - offset + 0.5) * resolution_);
+  point_arg.z = static_cast<float> ((static_cast<double> (compactBits (code_arg)) - offset + 0.5) * resolution_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> uint64_t
+pcl::octree::OctreePointCloudStreamingChangeDetector<PointT>::spreadBits (uint64_t value_arg)
+{
+  uint64_t x = value_arg & 0x1FFFFFULL;
+  x = (x | (x << 32)) & 0x1F00000000FFFFULL;
+  x = (x | (x << 16)) & 0x1F0000FF0000FFULL;
+  x = (x | (x << 8))  & 0x100F00F00F00F00FULL;
+  x = (x | (x << 4))  & 0x10C30C30C30C30C3ULL;
+  x = (x | (x << 2))  & 0x1249249249249249ULL;
+  return (x);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> uint64_t
+pcl::octree::OctreePointCloudStreamingChangeDetector<PointT>::compactBits (uint64_t value_arg)
+{
+  uint64_t x = value_arg & 0x1249249249249249ULL;
+  x = (x | (x >> 2))  & 0x10C30C30C30C30C3ULL;
+  x = (x | (x >> 4))  & 0x100F00F00F00F00FULL;
+  x = (x | (x >> 8))  & 0x1F0000FF0000FFULL;
+  x = (x | (x >> 16)) & 0x1F00000000FFFFULL;
+  x = (x | (x >> 32)) & 0x1FFFFFULL;
+  return (x);
+}
+
+#endif
+
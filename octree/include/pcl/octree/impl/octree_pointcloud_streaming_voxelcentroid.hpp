@@ -0,0 +1,471 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#ifndef OCTREE_STREAMING_VOXELCENTROID_HPP_
+#define OCTREE_STREAMING_VOXELCENTROID_HPP_
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+
+#include <pcl/common/io.h>
+#include <pcl/common/morton.h>
+#include <pcl/octree/octree_pointcloud_streaming_voxelcentroid.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT>
+pcl::octree::OctreePointCloudStreamingVoxelCentroid<PointT, LeafT, OctreeT>::OctreePointCloudStreamingVoxelCentroid (
+    const double resolution_arg) :
+  OctreePointCloud<PointT, LeafT, OctreeT> (resolution_arg),
+  pointCount_ (0),
+  threads_ (1),
+  rgbOffset_ (-1),
+  normalOffset_ (-1),
+  accumulateColor_ (false),
+  accumulateNormals_ (false),
+  mutex_ ()
+{
+  originVoxel_[0] = originVoxel_[1] = originVoxel_[2] = 0;
+
+  // look up optional point attributes
+  std::vector<sensor_msgs::PointField> fields;
+  int fieldIdx = pcl::getFieldIndex<PointT> ("rgb", fields);
+  if (fieldIdx == -1)
+    fieldIdx = pcl::getFieldIndex<PointT> ("rgba", fields);
+  if (fieldIdx >= 0)
+    rgbOffset_ = fields[fieldIdx].offset;
+
+  fieldIdx = pcl::getFieldIndex<PointT> ("normal_x", fields);
+  if (fieldIdx >= 0)
+    normalOffset_ = fields[fieldIdx].offset;
+
+  accumulateColor_ = (rgbOffset_ >= 0);
+  accumulateNormals_ = (normalOffset_ >= 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudStreamingVoxelCentroid<PointT, LeafT, OctreeT>::addPointsFromInputCloud ()
+{
+  assert (this->input_);
+  addPointBatch (*this->input_, this->indices_ ? &*this->indices_ : 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudStreamingVoxelCentroid<PointT, LeafT, OctreeT>::addPoints (const PointCloud& cloud_arg)
+{
+  addPointBatch (cloud_arg, 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudStreamingVoxelCentroid<PointT, LeafT, OctreeT>::addPoints (
+    const PointCloud& cloud_arg, const std::vector<int>& indices_arg)
+{
+  addPointBatch (cloud_arg, &indices_arg);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudStreamingVoxelCentroid<PointT, LeafT, OctreeT>::addPointBatch (
+    const PointCloud& cloud_arg, const std::vector<int>* indices_arg)
+{
+  const int nr_points = static_cast<int> (indices_arg ? indices_arg->size () : cloud_arg.points.size ());
+  if (nr_points == 0)
+    return;
+
+  const int threads = static_cast<int> (threads_);
+  const uint64_t invalidKey = std::numeric_limits<uint64_t>::max ();
+
+  std::vector<int> pointIdx (nr_points);
+  for (int i = 0; i < nr_points; ++i)
+    pointIdx[i] = indices_arg ? (*indices_arg)[i] : i;
+
+  // voxel bounding box of the finite points - reduced over contiguous blocks
+  std::vector<int64_t> blockBounds (threads * 6);
+
+#pragma omp parallel for schedule (static, 1) num_threads (threads)
+  for (int b = 0; b < threads; ++b)
+  {
+    int64_t* minVoxel = &blockBounds[b * 6];
+    int64_t* maxVoxel = minVoxel + 3;
+    std::fill (minVoxel, minVoxel + 3, std::numeric_limits<int64_t>::max ());
+    std::fill (maxVoxel, maxVoxel + 3, std::numeric_limits<int64_t>::min ());
+
+    const int end = static_cast<int> ((static_cast<int64_t> (nr_points) * (b + 1)) / threads);
+    for (int i = static_cast<int> ((static_cast<int64_t> (nr_points) * b) / threads); i < end; ++i)
+    {
+      const PointT& point = cloud_arg.points[pointIdx[i]];
+      if (!pcl_isfinite (point.x) || !pcl_isfinite (point.y) || !pcl_isfinite (point.z))
+        continue;
+
+      int64_t voxel[3];
+      genVoxelCoordinates (point, voxel);
+      for (int d = 0; d < 3; ++d)
+      {
+        minVoxel[d] = std::min (minVoxel[d], voxel[d]);
+        maxVoxel[d] = std::max (maxVoxel[d], voxel[d]);
+      }
+    }
+  }
+
+  int64_t minVoxel[3], maxVoxel[3];
+  std::copy (&blockBounds[0], &blockBounds[3], minVoxel);
+  std::copy (&blockBounds[3], &blockBounds[6], maxVoxel);
+  for (int b = 1; b < threads; ++b)
+    for (int d = 0; d < 3; ++d)
+    {
+      minVoxel[d] = std::min (minVoxel[d], blockBounds[b * 6 + d]);
+      maxVoxel[d] = std::max (maxVoxel[d], blockBounds[b * 6 + 3 + d]);
+    }
+
+  // no finite points in batch
+  if (minVoxel[0] > maxVoxel[0])
+    return;
+
+  // sort points by the Morton code of their voxel - batches spanning more than 2^21 voxels are sorted in two passes,
+  // the low 21 bits of every coordinate first, then the high bits. The radix sort is stable, so the second pass keeps
+  // the points with equal high bits in the order of their low bits and the result is ordered by the full code. The
+  // keys of the last pass only contain the high bits, equal keys are thus told apart by the voxel coordinates below.
+  const int64_t extent = std::max (std::max (maxVoxel[0] - minVoxel[0], maxVoxel[1] - minVoxel[1]),
+                                   maxVoxel[2] - minVoxel[2]);
+  const int passes = (extent >> 21) ? 2 : 1;
+
+  std::vector<uint64_t> keys (nr_points);
+  for (int pass = 0; pass < passes; ++pass)
+  {
+    const int shift = pass * 21;
+
+#pragma omp parallel for num_threads (threads)
+    for (int i = 0; i < nr_points; ++i)
+    {
+      const PointT& point = cloud_arg.points[pointIdx[i]];
+      if (!pcl_isfinite (point.x) || !pcl_isfinite (point.y) || !pcl_isfinite (point.z))
+      {
+        keys[i] = invalidKey;
+        continue;
+      }
+
+      int64_t voxel[3];
+      genVoxelCoordinates (point, voxel);
+      keys[i] = pcl::encodeMorton3D (static_cast<uint32_t> ((voxel[0] - minVoxel[0]) >> shift),
+                                     static_cast<uint32_t> ((voxel[1] - minVoxel[1]) >> shift),
+                                     static_cast<uint32_t> ((voxel[2] - minVoxel[2]) >> shift));
+    }
+
+    pcl::radixSortKeys (keys, pointIdx, threads_);
+  }
+
+  // non-finite points are sorted to the end
+  int nr_valid = nr_points;
+  while (nr_valid > 0 && keys[nr_valid - 1] == invalidKey)
+    --nr_valid;
+
+  // find the first point of every voxel
+  std::vector<char> voxelBegin (nr_valid, 0);
+
+#pragma omp parallel for num_threads (threads)
+  for (int i = 1; i < nr_valid; ++i)
+  {
+    if (keys[i] != keys[i - 1])
+    {
+      voxelBegin[i] = 1;
+      continue;
+    }
+
+    int64_t voxelA[3], voxelB[3];
+    genVoxelCoordinates (cloud_arg.points[pointIdx[i]], voxelA);
+    genVoxelCoordinates (cloud_arg.points[pointIdx[i - 1]], voxelB);
+    voxelBegin[i] = (voxelA[0] != voxelB[0]) || (voxelA[1] != voxelB[1]) || (voxelA[2] != voxelB[2]);
+  }
+
+  std::vector<int> voxelStart;
+  voxelStart.reserve (nr_valid / 4 + 1);
+  for (int i = 0; i < nr_valid; ++i)
+    if (i == 0 || voxelBegin[i])
+      voxelStart.push_back (i);
+  voxelStart.push_back (nr_valid);
+
+  // accumulate the points of every voxel
+  const int nr_voxels = static_cast<int> (voxelStart.size ()) - 1;
+  std::vector<LeafT> voxelLeafs (nr_voxels);
+
+#pragma omp parallel for schedule (dynamic, 256) num_threads (threads)
+  for (int v = 0; v < nr_voxels; ++v)
+    for (int i = voxelStart[v]; i < voxelStart[v + 1]; ++i)
+      accumulatePoint (cloud_arg.points[pointIdx[i]], voxelLeafs[v]);
+
+  // merge voxel sums into octree
+  boost::mutex::scoped_lock lock (mutex_);
+
+  if (!adoptBoundingBoxToVoxels (minVoxel, maxVoxel))
+    return;
+
+  for (int v = 0; v < nr_voxels; ++v)
+  {
+    int64_t voxel[3];
+    genVoxelCoordinates (cloud_arg.points[pointIdx[voxelStart[v]]], voxel);
+
+    OctreeKey key (static_cast<unsigned int> (voxel[0] - originVoxel_[0]),
+                   static_cast<unsigned int> (voxel[1] - originVoxel_[1]),
+                   static_cast<unsigned int> (voxel[2] - originVoxel_[2]));
+
+    LeafT* leaf = this->createLeaf (key);
+    leaf->merge (voxelLeafs[v]);
+  }
+
+  this->objectCount_ += nr_valid;
+  pointCount_ += nr_valid;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> bool
+pcl::octree::OctreePointCloudStreamingVoxelCentroid<PointT, LeafT, OctreeT>::adoptBoundingBoxToVoxels (
+    const int64_t minVoxel_arg[3], const int64_t maxVoxel_arg[3])
+{
+  const unsigned int maxDepth = static_cast<unsigned int> (OCT_MAXTREEDEPTH) - 1;
+
+  if (this->leafCount_ == 0)
+  {
+    // octree is empty - create an octree covering the voxels
+    const int64_t extent = std::max (std::max (maxVoxel_arg[0] - minVoxel_arg[0], maxVoxel_arg[1] - minVoxel_arg[1]),
+                                     maxVoxel_arg[2] - minVoxel_arg[2]);
+    unsigned int depth = 1;
+    while (depth <= maxDepth && (static_cast<int64_t> (1) << depth) <= extent)
+      depth++;
+
+    if (depth > maxDepth)
+    {
+      PCL_ERROR ("[pcl::octree::OctreePointCloudStreamingVoxelCentroid::addPoints] Bounding box of batch exceeds the maximum octree size.\n");
+      return (false);
+    }
+
+    std::copy (minVoxel_arg, minVoxel_arg + 3, originVoxel_);
+    this->octreeDepth_ = depth;
+    this->setTreeDepth (this->octreeDepth_);
+  }
+
+  // increase octree size until all voxels fit into bounding box
+  while (true)
+  {
+    const int64_t octreeSideLen = static_cast<int64_t> (1) << this->octreeDepth_;
+
+    bool bLowerBoundViolation[3];
+    bool bUpperBoundViolation[3];
+    bool bViolation = false;
+    for (int d = 0; d < 3; ++d)
+    {
+      bLowerBoundViolation[d] = (minVoxel_arg[d] < originVoxel_[d]);
+      bUpperBoundViolation[d] = (maxVoxel_arg[d] >= originVoxel_[d] + octreeSideLen);
+      bViolation = bViolation || bLowerBoundViolation[d] || bUpperBoundViolation[d];
+    }
+
+    if (!bViolation)
+      break;
+
+    if (this->octreeDepth_ >= maxDepth)
+    {
+      PCL_ERROR ("[pcl::octree::OctreePointCloudStreamingVoxelCentroid::addPoints] Bounding box exceeds the maximum octree size.\n");
+      return (false);
+    }
+
+    // we add another tree level and thus increase its size by a factor of 2*2*2 - the current octree is moved to
+    // the upper half of every axis with a lower bound violation
+    unsigned char childIdx = static_cast<unsigned char> ((bLowerBoundViolation[0] << 2) |
+                                                         (bLowerBoundViolation[1] << 1) |
+                                                         (bLowerBoundViolation[2]));
+
+    OctreeBranch* newRootBranch;
+
+    this->createBranch (newRootBranch);
+    this->branchCount_++;
+
+    this->setBranchChild (*newRootBranch, childIdx, this->rootNode_);
+
+    this->rootNode_ = newRootBranch;
+
+    for (int d = 0; d < 3; ++d)
+      if (bLowerBoundViolation[d])
+        originVoxel_[d] -= octreeSideLen;
+
+    // configure tree depth of octree
+    this->octreeDepth_++;
+    this->setTreeDepth (this->octreeDepth_);
+  }
+
+  // update metric bounding box
+  const float minValue = std::numeric_limits<float>::epsilon ();
+  const double octreeSideLen = static_cast<double> (static_cast<int64_t> (1) << this->octreeDepth_) * this->resolution_;
+
+  this->minX_ = static_cast<double> (originVoxel_[0]) * this->resolution_;
+  this->minY_ = static_cast<double> (originVoxel_[1]) * this->resolution_;
+  this->minZ_ = static_cast<double> (originVoxel_[2]) * this->resolution_;
+
+  this->maxX_ = this->minX_ + octreeSideLen - minValue;
+  this->maxY_ = this->minY_ + octreeSideLen - minValue;
+  this->maxZ_ = this->minZ_ + octreeSideLen - minValue;
+
+  this->boundingBoxDefined_ = true;
+
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudStreamingVoxelCentroid<PointT, LeafT, OctreeT>::accumulatePoint (
+    const PointT& point_arg, LeafT& leaf_arg) const
+{
+  leaf_arg.addPoint (point_arg.x, point_arg.y, point_arg.z);
+
+  if (accumulateColor_)
+  {
+    pcl::RGB rgb;
+    memcpy (&rgb, reinterpret_cast<const char*> (&point_arg) + rgbOffset_, sizeof (RGB));
+    leaf_arg.addColor (rgb.r, rgb.g, rgb.b);
+  }
+
+  if (accumulateNormals_)
+  {
+    float normal[3];
+    memcpy (normal, reinterpret_cast<const char*> (&point_arg) + normalOffset_, sizeof (normal));
+    if (pcl_isfinite (normal[0]) && pcl_isfinite (normal[1]) && pcl_isfinite (normal[2]))
+      leaf_arg.addNormal (normal[0], normal[1], normal[2]);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudStreamingVoxelCentroid<PointT, LeafT, OctreeT>::genCentroidFromLeaf (
+    const LeafT& leaf_arg, PointT& point_arg) const
+{
+  leaf_arg.getCentroid (point_arg.x, point_arg.y, point_arg.z);
+
+  if (accumulateColor_)
+  {
+    pcl::RGB rgb;
+    memcpy (&rgb, reinterpret_cast<const char*> (&point_arg) + rgbOffset_, sizeof (RGB));
+    leaf_arg.getMeanColor (rgb.r, rgb.g, rgb.b);
+    memcpy (reinterpret_cast<char*> (&point_arg) + rgbOffset_, &rgb, sizeof (RGB));
+  }
+
+  if (accumulateNormals_)
+  {
+    float normal[3];
+    if (!leaf_arg.getMeanNormal (normal[0], normal[1], normal[2]))
+      normal[0] = normal[1] = normal[2] = std::numeric_limits<float>::quiet_NaN ();
+    memcpy (reinterpret_cast<char*> (&point_arg) + normalOffset_, normal, sizeof (normal));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> unsigned int
+pcl::octree::OctreePointCloudStreamingVoxelCentroid<PointT, LeafT, OctreeT>::getVoxelCentroids (
+    AlignedPointTVector &voxelCentroidList_arg) const
+{
+  voxelCentroidList_arg.clear ();
+  voxelCentroidList_arg.reserve (this->leafCount_);
+
+  typename OctreeT::LeafNodeIterator it (*this);
+  while (*++it)
+  {
+    PointT centroid;
+    genCentroidFromLeaf (**it, centroid);
+    voxelCentroidList_arg.push_back (centroid);
+  }
+
+  return (static_cast<unsigned int> (voxelCentroidList_arg.size ()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> unsigned int
+pcl::octree::OctreePointCloudStreamingVoxelCentroid<PointT, LeafT, OctreeT>::getVoxelCentroids (
+    PointCloud &cloud_arg) const
+{
+  getVoxelCentroids (cloud_arg.points);
+
+  cloud_arg.width = static_cast<uint32_t> (cloud_arg.points.size ());
+  cloud_arg.height = 1;
+  cloud_arg.is_dense = true;
+
+  return (cloud_arg.width);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> bool
+pcl::octree::OctreePointCloudStreamingVoxelCentroid<PointT, LeafT, OctreeT>::getVoxelCentroidAtPoint (
+    const PointT& point_arg, PointT& voxelCentroid_arg) const
+{
+  if (this->leafCount_ == 0)
+    return (false);
+
+  int64_t voxel[3];
+  genVoxelCoordinates (point_arg, voxel);
+
+  const int64_t octreeSideLen = static_cast<int64_t> (1) << this->octreeDepth_;
+  for (int d = 0; d < 3; ++d)
+    if (voxel[d] < originVoxel_[d] || voxel[d] >= originVoxel_[d] + octreeSideLen)
+      return (false);
+
+  OctreeKey key (static_cast<unsigned int> (voxel[0] - originVoxel_[0]),
+                 static_cast<unsigned int> (voxel[1] - originVoxel_[1]),
+                 static_cast<unsigned int> (voxel[2] - originVoxel_[2]));
+
+  const LeafT* leaf = this->findLeaf (key);
+  if (!leaf)
+    return (false);
+
+  genCentroidFromLeaf (*leaf, voxelCentroid_arg);
+
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT, typename LeafT, typename OctreeT> void
+pcl::octree::OctreePointCloudStreamingVoxelCentroid<PointT, LeafT, OctreeT>::deleteTree ()
+{
+  boost::mutex::scoped_lock lock (mutex_);
+
+  originVoxel_[0] = originVoxel_[1] = originVoxel_[2] = 0;
+  pointCount_ = 0;
+
+  OctreePointCloud<PointT, LeafT, OctreeT>::deleteTree ();
+}
+
+#endif /* OCTREE_STREAMING_VOXELCENTROID_HPP_ */
@@ -0,0 +1,150 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#ifndef OCTREE_RANGE_BASE_HPP
+#define OCTREE_RANGE_BASE_HPP
+
+#include <vector>
+
+#include <pcl/octree/octree_range_base.h>
+
+namespace pcl
+{
+  namespace octree
+  {
+    //////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename DataT, typename LeafT, typename BranchT> void
+    OctreeRangeBase<DataT, LeafT, BranchT>::deleteTree (bool freeMemory_arg)
+    {
+      BaseT::deleteTree (freeMemory_arg);
+
+      if (freeMemory_arg)
+      {
+        std::vector<DataT> ().swap (storage_.data);
+        std::vector<typename Storage::Chunk> ().swap (storage_.chunks);
+      }
+      else
+        storage_.clear ();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename DataT, typename LeafT, typename BranchT> void
+    OctreeRangeBase<DataT, LeafT, BranchT>::compactLeafData ()
+    {
+      if (storage_.chunks.empty ())
+        // all DataT elements are stored in leaf ranges already
+        return;
+
+      std::vector<DataT> dataVector;
+      dataVector.reserve (this->objectCount_);
+
+      compactRecursive (this->rootNode_, dataVector);
+
+      storage_.data.swap (dataVector);
+      std::vector<typename Storage::Chunk> ().swap (storage_.chunks);
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename DataT, typename LeafT, typename BranchT> void
+    OctreeRangeBase<DataT, LeafT, BranchT>::compactRecursive (OctreeBranch* branch_arg,
+                                                              std::vector<DataT>& dataVector_arg)
+    {
+      // iterate over all children in depth-first order
+      for (unsigned char childIdx = 0; childIdx < 8; childIdx++)
+      {
+        if (!this->branchHasChild (*branch_arg, childIdx))
+          continue;
+
+        OctreeNode* childNode = this->getBranchChild (*branch_arg, childIdx);
+
+        switch (childNode->getNodeType ())
+        {
+          case BRANCH_NODE:
+            compactRecursive (static_cast<OctreeBranch*> (childNode), dataVector_arg);
+            break;
+
+          case LEAF_NODE:
+          {
+            LeafT* childLeaf = static_cast<LeafT*> (childNode);
+
+            const std::size_t begin = dataVector_arg.size ();
+            childLeaf->getData (dataVector_arg);
+            childLeaf->setRange (static_cast<unsigned int> (begin),
+                                 static_cast<unsigned int> (dataVector_arg.size () - begin));
+            break;
+          }
+
+          default:
+            break;
+        }
+      }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename DataT, typename LeafT, typename BranchT> void
+    OctreeRangeBase<DataT, LeafT, BranchT>::bindStorageRecursive (OctreeBranch* branch_arg)
+    {
+      for (unsigned char childIdx = 0; childIdx < 8; childIdx++)
+      {
+        if (!this->branchHasChild (*branch_arg, childIdx))
+          continue;
+
+        OctreeNode* childNode = this->getBranchChild (*branch_arg, childIdx);
+
+        switch (childNode->getNodeType ())
+        {
+          case BRANCH_NODE:
+            bindStorageRecursive (static_cast<OctreeBranch*> (childNode));
+            break;
+
+          case LEAF_NODE:
+            static_cast<LeafT*> (childNode)->setStorage (&storage_);
+            break;
+
+          default:
+            break;
+        }
+      }
+    }
+  }
+}
+
+#define PCL_INSTANTIATE_OctreeRangeBase(T) template class PCL_EXPORTS pcl::octree::OctreeRangeBase<T>;
+
+#endif
+
@@ -43,6 +43,7 @@
 #include <pcl/octree/octree_base.h>
 #include <pcl/octree/octree2buf_base.h>
 #include <pcl/octree/octree_lowmemory_base.h>
+#include <pcl/octree/octree_range_base.h>
 
 #include <pcl/octree/octree_iterator.h>
 
@@ -50,10 +51,13 @@
 
 #include <pcl/octree/octree_pointcloud_density.h>
 #include <pcl/octree/octree_pointcloud_occupancy.h>
+#include <pcl/octree/octree_pointcloud_occupancy_map.h>
 #include <pcl/octree/octree_pointcloud_singlepoint.h>
 #include <pcl/octree/octree_pointcloud_pointvector.h>
 #include <pcl/octree/octree_pointcloud_changedetector.h>
+#include <pcl/octree/octree_pointcloud_streaming_changedetector.h>
 #include <pcl/octree/octree_pointcloud_voxelcentroid.h>
+#include <pcl/octree/octree_pointcloud_streaming_voxelcentroid.h>
 
 #include <pcl/octree/octree_search.h>
 
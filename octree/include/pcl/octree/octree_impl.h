@@ -44,8 +44,12 @@
 #include <pcl/octree/impl/octree_base.hpp>
 #include <pcl/octree/impl/octree2buf_base.hpp>
 #include <pcl/octree/impl/octree_lowmemory_base.hpp>
+#include <pcl/octree/impl/octree_range_base.hpp>
 
 #include <pcl/octree/impl/octree_pointcloud.hpp>
+#include <pcl/octree/impl/octree_pointcloud_occupancy_map.hpp>
+#include <pcl/octree/impl/octree_pointcloud_streaming_changedetector.hpp>
+#include <pcl/octree/impl/octree_pointcloud_streaming_voxelcentroid.hpp>
 
 #include <pcl/octree/impl/octree_iterator.hpp>
 
@@ -43,6 +43,9 @@
 #define OCT_MAXTREEDEPTH ( sizeof(unsigned int) * 8  )
 
 #include <string.h>
+#include <assert.h>
+
+#include <vector>
 
 #include <pcl/pcl_macros.h>
 
@@ -329,6 +332,200 @@ namespace pcl
         std::vector<DataT> leafDataTVector_;
     };
 
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** \brief @b Shared DataT storage of OctreeLeafDataTRange leaf nodes.
+      * \note DataT elements of all leaf nodes are stored in a single contiguous vector in which every leaf node owns a
+      * \note range. Elements added to a leaf node afterwards are stored in a linked list of fixed size chunks.
+      */
+    template<typename DataT>
+    class OctreeLeafDataTRangeStorage
+    {
+      public:
+        /** \brief Number of DataT elements per overflow chunk. */
+        static const unsigned int CHUNK_SIZE = 6;
+
+        /** \brief Overflow chunk storing DataT elements added after the leaf ranges were assigned. */
+        struct Chunk
+        {
+          /** \brief DataT elements of chunk. */
+          DataT data[CHUNK_SIZE];
+
+          /** \brief Number of used DataT elements. */
+          unsigned int size;
+
+          /** \brief Index of the next chunk of the leaf node or -1. */
+          int next;
+        };
+
+        /** \brief Release all DataT elements and chunks. */
+        void
+        clear ()
+        {
+          data.clear ();
+          chunks.clear ();
+        }
+
+        /** \brief Contiguous DataT vector. Leaf nodes store ranges within this vector. */
+        std::vector<DataT> data;
+
+        /** \brief Overflow chunk pool. */
+        std::vector<Chunk> chunks;
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** \brief @b Octree leaf class that stores a range of DataT elements within a shared storage vector.
+      * \note Compared to OctreeLeafDataTVector, no heap memory is allocated per leaf node. The leaf node stores a
+      * \note (begin, count) range into OctreeLeafDataTRangeStorage::data and the first and last index of its overflow
+      * \note chunk list. Leaf nodes have to be bound to a storage object before DataT elements can be added (see
+      * \note OctreeRangeBase).
+      */
+    template<typename DataT>
+    class OctreeLeafDataTRange : public OctreeLeafAbstract<DataT>
+    {
+      public:
+        typedef OctreeLeafDataTRangeStorage<DataT> Storage;
+
+        /** \brief Empty constructor. */
+        OctreeLeafDataTRange () : storage_ (0), begin_ (0), count_ (0), firstChunk_ (-1), lastChunk_ (-1)
+        {
+        }
+
+        /** \brief Empty deconstructor. */
+        ~OctreeLeafDataTRange ()
+        {
+        }
+
+        /** \brief Octree deep copy method. The copy refers to the same storage object. */
+        virtual OctreeNode *
+        deepCopy () const
+        {
+          return (static_cast<OctreeNode*> (new OctreeLeafDataTRange (*this)));
+        }
+
+        /** \brief Bind leaf node to a storage object.
+          * \param[in] storage_arg pointer to storage object
+          */
+        inline void
+        setStorage (Storage* storage_arg)
+        {
+          storage_ = storage_arg;
+        }
+
+        /** \brief Assign a range of the contiguous storage vector to the leaf node and drop its overflow chunks.
+          * \param[in] begin_arg index of first DataT element
+          * \param[in] count_arg number of DataT elements
+          */
+        inline void
+        setRange (unsigned int begin_arg, unsigned int count_arg)
+        {
+          begin_ = begin_arg;
+          count_ = count_arg;
+          firstChunk_ = lastChunk_ = -1;
+        }
+
+        /** \brief Append a DataT element to the overflow chunk list of the leaf node.
+          * \param[in] data_arg reference to DataT element to be stored within leaf node.
+          */
+        virtual void
+        setData (const DataT& data_arg)
+        {
+          assert (storage_);
+
+          std::vector<typename Storage::Chunk>& chunks = storage_->chunks;
+
+          if ((lastChunk_ < 0) || (chunks[lastChunk_].size == Storage::CHUNK_SIZE))
+          {
+            typename Storage::Chunk chunk;
+            chunk.size = 0;
+            chunk.next = -1;
+
+            const int chunkIdx = static_cast<int> (chunks.size ());
+            chunks.push_back (chunk);
+
+            if (lastChunk_ < 0)
+              firstChunk_ = chunkIdx;
+            else
+              chunks[lastChunk_].next = chunkIdx;
+            lastChunk_ = chunkIdx;
+          }
+
+          typename Storage::Chunk& chunk = chunks[lastChunk_];
+          chunk.data[chunk.size++] = data_arg;
+        }
+
+        /** \brief Receive the most recent DataT element that was added to the leaf node.
+          * \param[in] data_arg reference to return pointer of most recently added leaf node DataT element.
+          */
+        virtual void
+        getData (const DataT*& data_arg) const
+        {
+          const DataT* result = 0;
+
+          if (lastChunk_ >= 0)
+          {
+            const typename Storage::Chunk& chunk = storage_->chunks[lastChunk_];
+            result = &chunk.data[chunk.size - 1];
+          }
+          else if (count_ > 0)
+            result = &storage_->data[begin_ + count_ - 1];
+
+          data_arg = result;
+        }
+
+        /** \brief Concatenate the DataT elements of the leaf node to vector argument dataVector_arg.
+          * \param[in] dataVector_arg: reference to DataT vector that is to be extended with leaf node DataT elements.
+          */
+        virtual void
+        getData (std::vector<DataT>& dataVector_arg) const
+        {
+          if (count_ > 0)
+            dataVector_arg.insert (dataVector_arg.end (), storage_->data.begin () + begin_,
+                                   storage_->data.begin () + begin_ + count_);
+
+          for (int chunkIdx = firstChunk_; chunkIdx >= 0; chunkIdx = storage_->chunks[chunkIdx].next)
+          {
+            const typename Storage::Chunk& chunk = storage_->chunks[chunkIdx];
+            dataVector_arg.insert (dataVector_arg.end (), chunk.data, chunk.data + chunk.size);
+          }
+        }
+
+        /** \brief Get the number of DataT elements stored within the leaf node.
+          * \return number of DataT elements
+          */
+        inline std::size_t
+        getSize () const
+        {
+          std::size_t size = count_;
+          for (int chunkIdx = firstChunk_; chunkIdx >= 0; chunkIdx = storage_->chunks[chunkIdx].next)
+            size += storage_->chunks[chunkIdx].size;
+          return (size);
+        }
+
+        /** \brief Reset leaf node. Memory within the storage object is released on its next compaction. */
+        virtual void
+        reset ()
+        {
+          begin_ = count_ = 0;
+          firstChunk_ = lastChunk_ = -1;
+        }
+
+      protected:
+        /** \brief Storage object. */
+        Storage* storage_;
+
+        /** \brief Index of first DataT element within the contiguous storage vector. */
+        unsigned int begin_;
+
+        /** \brief Number of DataT elements within the contiguous storage vector. */
+        unsigned int count_;
+
+        /** \brief Index of first overflow chunk or -1. */
+        int firstChunk_;
+
+        /** \brief Index of last overflow chunk or -1. */
+        int lastChunk_;
+    };
+
     //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     /**\brief @b Octree branch class.
      * \note It stores 8 pointers to its child nodes.
@@ -42,6 +42,7 @@
 #include "octree_base.h"
 #include "octree2buf_base.h"
 #include "octree_lowmemory_base.h"
+#include "octree_range_base.h"
 
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
@@ -408,6 +409,24 @@ namespace pcl
         void
         addPointIdx (const int pointIdx_arg);
 
+        /** \brief Finalize the leaf data after adding the points of the input cloud. Nothing to do for octrees storing
+          * DataT elements within their leaf nodes.
+          */
+        template<typename OctreeBaseT> static inline void
+        finalizeLeafData (OctreeBaseT&)
+        {
+        }
+
+        /** \brief Finalize the leaf data after adding the points of the input cloud. Point indices are reordered into
+          * a contiguous vector of leaf ranges.
+          * \param[in] octree_arg octree storing DataT ranges
+          */
+        template<typename DataT, typename RangeLeafT, typename BranchT> static inline void
+        finalizeLeafData (OctreeRangeBase<DataT, RangeLeafT, BranchT>& octree_arg)
+        {
+          octree_arg.compactLeafData ();
+        }
+
         /** \brief Get point at index from input pointcloud dataset
           * \param[in] index_arg index representing the point in the dataset given by \a setInputCloud
           * \return PointT from input pointcloud dataset
@@ -0,0 +1,561 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#ifndef OCTREE_OCCUPANCY_MAP_H
+#define OCTREE_OCCUPANCY_MAP_H
+
+#include "octree_pointcloud.h"
+
+#include "octree_base.h"
+#include "octree2buf_base.h"
+
+#include <cmath>
+
+namespace pcl
+{
+  namespace octree
+  {
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** \brief @b Octree occupancy leaf node class
+      * \note This leaf node stores the occupancy probability of its voxel in log-odds notation. DataT elements are not stored.
+      * \note Leaf nodes of this type may also be located above the maximum tree depth. In this case they represent a
+      * \note pruned subtree in which all voxels share the same occupancy value.
+      */
+    template<typename DataT>
+    class OctreeOccupancyLeaf : public OctreeLeafAbstract<DataT>
+    {
+      public:
+        /** \brief Class initialization. */
+        OctreeOccupancyLeaf () : logOdds_ (0.0f)
+        {
+        }
+
+        /** \brief Empty class deconstructor. */
+        ~OctreeOccupancyLeaf ()
+        {
+        }
+
+        /** \brief deep copy function */
+        virtual OctreeNode *
+        deepCopy () const
+        {
+          return (static_cast<OctreeNode*> (new OctreeOccupancyLeaf (*this)));
+        }
+
+        /** \brief Empty setData data implementation. This leaf node only stores an occupancy value.
+          */
+        virtual void
+        setData (const DataT&)
+        {
+        }
+
+        /** \brief Returns a null pointer as this leaf node does not store any data.
+          * \param[out] data_arg: reference to return pointer of leaf node DataT element (will be set to 0).
+          */
+        virtual void
+        getData (const DataT*& data_arg) const
+        {
+          data_arg = 0;
+        }
+
+        /** \brief Empty getData data vector implementation as this leaf node does not store any data. \
+          */
+        virtual void
+        getData (std::vector<DataT>&) const
+        {
+        }
+
+        /** \brief Get the occupancy value of the voxel.
+          * \return occupancy in log-odds notation
+          */
+        inline float
+        getLogOdds () const
+        {
+          return (logOdds_);
+        }
+
+        /** \brief Set the occupancy value of the voxel.
+          * \param[in] logOdds_arg occupancy in log-odds notation
+          */
+        inline void
+        setLogOdds (float logOdds_arg)
+        {
+          logOdds_ = logOdds_arg;
+        }
+
+        /** \brief Integrate a measurement into the occupancy value and clamp the result.
+          * \param[in] update_arg measurement in log-odds notation
+          * \param[in] min_arg lower clamping threshold in log-odds notation
+          * \param[in] max_arg upper clamping threshold in log-odds notation
+          */
+        inline void
+        updateLogOdds (float update_arg, float min_arg, float max_arg)
+        {
+          logOdds_ = std::min (std::max (logOdds_ + update_arg, min_arg), max_arg);
+        }
+
+        /** \brief Get the occupancy probability of the voxel.
+          * \return occupancy probability [0..1]
+          */
+        inline double
+        getOccupancy () const
+        {
+          return (1.0 - 1.0 / (1.0 + std::exp (static_cast<double> (logOdds_))));
+        }
+
+        /** \brief Reset leaf node to an unknown occupancy state (p = 0.5). */
+        virtual void
+        reset ()
+        {
+          logOdds_ = 0.0f;
+        }
+
+      private:
+        /** \brief Occupancy value in log-odds notation. */
+        float logOdds_;
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** \brief @b Octree pointcloud occupancy map class
+     *  \note This class builds a probabilistic occupancy map from range scans. Each leaf node holds the occupancy of its
+     *  \note voxel in log-odds notation. Inserting a scan updates the voxels containing the scan end points as occupied
+     *  \note and all voxels traversed by the sensor rays as free. Each voxel is updated at most once per scan.
+     *  \note Log-odds values are clamped so that subtrees converging to the same value can be pruned by \a prune ().
+     *  \note Pruned subtrees are represented by a single leaf node above the maximum tree depth, which is visited as
+     *  \note such by the octree iterators. Call \a expand () before serializing a pruned octree.
+     *  \note
+     *  \note typename: PointT: type of point used in pointcloud
+     *  \ingroup octree
+     */
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename PointT, typename LeafT = OctreeOccupancyLeaf<int> , typename OctreeT = OctreeBase<int, LeafT> >
+    class OctreePointCloudOccupancyMap : public OctreePointCloud<PointT, LeafT, OctreeT>
+    {
+      public:
+        // public typedefs for single/double buffering
+        typedef OctreePointCloudOccupancyMap<PointT, LeafT, OctreeBase<int, LeafT> > SingleBuffer;
+
+        // public point cloud typedefs
+        typedef typename OctreePointCloud<PointT, LeafT, OctreeT>::PointCloud PointCloud;
+        typedef typename OctreePointCloud<PointT, LeafT, OctreeT>::PointCloudPtr PointCloudPtr;
+        typedef typename OctreePointCloud<PointT, LeafT, OctreeT>::PointCloudConstPtr PointCloudConstPtr;
+
+        // Eigen aligned allocator
+        typedef typename OctreePointCloud<PointT, LeafT, OctreeT>::AlignedPointTVector AlignedPointTVector;
+
+        /** \brief Constructor.
+         *  \param resolution_arg:  octree resolution at lowest octree level
+         * */
+        OctreePointCloudOccupancyMap (const double resolution_arg) :
+          OctreePointCloud<PointT, LeafT, OctreeT> (resolution_arg),
+          logOddsHit_ (static_cast<float> (probabilityToLogOdds (0.7))),
+          logOddsMiss_ (static_cast<float> (probabilityToLogOdds (0.4))),
+          clampingMin_ (static_cast<float> (probabilityToLogOdds (0.1192))),
+          clampingMax_ (static_cast<float> (probabilityToLogOdds (0.971))),
+          occupancyThres_ (0.0f),
+          maxRange_ (-1.0),
+          threads_ (1)
+        {
+        }
+
+        /** \brief Empty class deconstructor. */
+        virtual
+        ~OctreePointCloudOccupancyMap ()
+        {
+        }
+
+        /** \brief Convert a probability into log-odds notation.
+          * \param[in] probability_arg probability [0..1]
+          */
+        static inline double
+        probabilityToLogOdds (double probability_arg)
+        {
+          return (std::log (probability_arg / (1.0 - probability_arg)));
+        }
+
+        /** \brief Convert a log-odds value into a probability.
+          * \param[in] logOdds_arg value in log-odds notation
+          */
+        static inline double
+        logOddsToProbability (double logOdds_arg)
+        {
+          return (1.0 - 1.0 / (1.0 + std::exp (logOdds_arg)));
+        }
+
+        /** \brief Set the probability that a voxel containing a scan end point is occupied (default: 0.7). */
+        inline void
+        setProbHit (double probability_arg)
+        {
+          assert (probability_arg > 0.5);
+          logOddsHit_ = static_cast<float> (probabilityToLogOdds (probability_arg));
+        }
+
+        /** \brief Get the probability that a voxel containing a scan end point is occupied. */
+        inline double
+        getProbHit () const
+        {
+          return (logOddsToProbability (logOddsHit_));
+        }
+
+        /** \brief Set the probability that a voxel traversed by a sensor ray is occupied (default: 0.4). */
+        inline void
+        setProbMiss (double probability_arg)
+        {
+          assert (probability_arg < 0.5);
+          logOddsMiss_ = static_cast<float> (probabilityToLogOdds (probability_arg));
+        }
+
+        /** \brief Get the probability that a voxel traversed by a sensor ray is occupied. */
+        inline double
+        getProbMiss () const
+        {
+          return (logOddsToProbability (logOddsMiss_));
+        }
+
+        /** \brief Set the lower and upper clamping thresholds for voxel occupancy probabilities (default: 0.1192, 0.971).
+          * \note Clamping bounds the confidence of a voxel so that the map adapts to changes and homogeneous regions can be pruned.
+          * \param[in] min_arg lower probability bound
+          * \param[in] max_arg upper probability bound
+          */
+        inline void
+        setClampingThresholds (double min_arg, double max_arg)
+        {
+          assert (min_arg < max_arg);
+          clampingMin_ = static_cast<float> (probabilityToLogOdds (min_arg));
+          clampingMax_ = static_cast<float> (probabilityToLogOdds (max_arg));
+        }
+
+        /** \brief Get the lower and upper clamping thresholds for voxel occupancy probabilities. */
+        inline void
+        getClampingThresholds (double& min_arg, double& max_arg) const
+        {
+          min_arg = logOddsToProbability (clampingMin_);
+          max_arg = logOddsToProbability (clampingMax_);
+        }
+
+        /** \brief Set the probability above which a voxel is considered occupied (default: 0.5). */
+        inline void
+        setOccupancyThreshold (double probability_arg)
+        {
+          occupancyThres_ = static_cast<float> (probabilityToLogOdds (probability_arg));
+        }
+
+        /** \brief Get the probability above which a voxel is considered occupied. */
+        inline double
+        getOccupancyThreshold () const
+        {
+          return (logOddsToProbability (occupancyThres_));
+        }
+
+        /** \brief Set the maximum sensor range. Scan end points beyond this range only update free space up to the
+          * maximum range. A negative value disables the range limitation (default).
+          * \param[in] maxRange_arg maximum sensor range
+          */
+        inline void
+        setMaxRange (double maxRange_arg)
+        {
+          maxRange_ = maxRange_arg;
+        }
+
+        /** \brief Get the maximum sensor range. */
+        inline double
+        getMaxRange () const
+        {
+          return (maxRange_);
+        }
+
+        /** \brief Set the number of threads used for ray casting.
+          * \param[in] nr_threads the number of hardware threads to use
+          */
+        inline void
+        setNumberOfThreads (unsigned int nr_threads)
+        {
+          if (nr_threads == 0)
+            nr_threads = 1;
+          threads_ = nr_threads;
+        }
+
+        /** \brief Integrate a range scan into the occupancy map.
+          * \note All rays are traversed in parallel. Updates are collected in octree key space, so a voxel traversed by
+          * \note several rays is updated only once. Voxels containing an end point are updated as occupied only.
+          * \param[in] cloud_arg scan end points
+          * \param[in] origin_arg sensor origin of the scan
+          */
+        void
+        insertScan (const PointCloud& cloud_arg, const Eigen::Vector3f& origin_arg);
+
+        /** \brief Integrate a single occupancy measurement into the voxel at a given point.
+          * \param[in] point_arg point addressing the voxel
+          * \param[in] occupied_arg "true" for a hit; "false" for a miss
+          */
+        void
+        updateVoxelAtPoint (const PointT& point_arg, bool occupied_arg);
+
+        /** \brief Add the points from the input point cloud as occupied voxel measurements (no ray casting). */
+        void
+        addPointsFromInputCloud ();
+
+        /** \brief Get the occupancy probability of the voxel at a given point.
+          * \param[in] point_arg point addressing the voxel
+          * \param[out] probability_arg occupancy probability of the voxel
+          * \return "true" if the voxel is known; "false" otherwise
+          */
+        bool
+        getOccupancyAtPoint (const PointT& point_arg, double& probability_arg) const;
+
+        /** \brief Check if the voxel at a given point is occupied.
+          * \param[in] point_arg point to be checked
+          * \return "true" if voxel is known and its occupancy probability is above the occupancy threshold
+          */
+        bool
+        isVoxelOccupiedAtPoint (const PointT& point_arg) const;
+
+        /** \brief Check if the voxel at given point coordinates is occupied.
+          * \param[in] pointX_arg X coordinate of point to be checked
+          * \param[in] pointY_arg Y coordinate of point to be checked
+          * \param[in] pointZ_arg Z coordinate of point to be checked
+          * \return "true" if voxel is known and its occupancy probability is above the occupancy threshold
+          */
+        bool
+        isVoxelOccupiedAtPoint (const double pointX_arg, const double pointY_arg, const double pointZ_arg) const;
+
+        /** \brief Check if the voxel at a given point is free.
+          * \param[in] point_arg point to be checked
+          * \return "true" if voxel is known and its occupancy probability is not above the occupancy threshold
+          */
+        bool
+        isVoxelFreeAtPoint (const PointT& point_arg) const;
+
+        /** \brief Check if the voxel at given point from input cloud is occupied.
+          * \param[in] pointIdx_arg index of point to be checked
+          * \return "true" if voxel is known and its occupancy probability is above the occupancy threshold
+          */
+        inline bool
+        isVoxelOccupiedAtPoint (const int& pointIdx_arg) const
+        {
+          return (isVoxelOccupiedAtPoint (this->input_->points[pointIdx_arg]));
+        }
+
+        /** \brief Delete the voxel at a given point. Pruned subtrees containing the voxel are expanded first.
+          * \param[in] point_arg point addressing the voxel to be deleted.
+          */
+        void
+        deleteVoxelAtPoint (const PointT& point_arg);
+
+        /** \brief Delete the voxel at given point from input cloud.
+          * \param[in] pointIdx_arg index of point addressing the voxel to be deleted.
+          */
+        inline void
+        deleteVoxelAtPoint (const int& pointIdx_arg)
+        {
+          deleteVoxelAtPoint (this->input_->points[pointIdx_arg]);
+        }
+
+        /** \brief Get a PointT vector of centers of all occupied voxels at leaf resolution.
+          * \param[out] voxelCenterList_arg results are written to this vector of PointT elements
+          * \return number of occupied voxels
+          */
+        int
+        getOccupiedVoxelCenters (AlignedPointTVector &voxelCenterList_arg) const;
+
+        /** \brief Get a PointT vector of centers of all known free voxels at leaf resolution.
+          * \param[out] voxelCenterList_arg results are written to this vector of PointT elements
+          * \return number of free voxels
+          */
+        int
+        getFreeVoxelCenters (AlignedPointTVector &voxelCenterList_arg) const;
+
+        /** \brief Merge all subtrees whose eight children are leaf nodes of identical occupancy into a single leaf node.
+          * \note Freed octree nodes are released from the node pools.
+          */
+        void
+        prune ();
+
+        /** \brief Expand all pruned subtrees down to the maximum tree depth. */
+        void
+        expand ();
+
+      protected:
+        typedef typename OctreePointCloud<PointT, LeafT, OctreeT>::OctreeBranch OctreeBranch;
+
+        /** \brief Octree key comparison following the depth-first order of the octree (Morton order). */
+        struct OctreeKeyLess
+        {
+          /** \brief Check if the most significant bit of a is below the most significant bit of b. */
+          static inline bool
+          lessMSB (unsigned int a, unsigned int b)
+          {
+            return ((a < b) && (a < (a ^ b)));
+          }
+
+          inline bool
+          operator () (const OctreeKey& a, const OctreeKey& b) const
+          {
+            // the highest differing bit defines the octree level at which both keys diverge - child indices
+            // are ordered by x, y and z bits
+            unsigned int diff = a.x ^ b.x;
+            int axis = 0;
+            if (lessMSB (diff, a.y ^ b.y))
+            {
+              diff = a.y ^ b.y;
+              axis = 1;
+            }
+            if (lessMSB (diff, a.z ^ b.z))
+              axis = 2;
+
+            switch (axis)
+            {
+              case 0:
+                return (a.x < b.x);
+              case 1:
+                return (a.y < b.y);
+              default:
+                return (a.z < b.z);
+            }
+          }
+        };
+
+        /** \brief Sort octree keys and remove duplicates.
+          * \param[in,out] keys_arg vector of octree keys
+          */
+        static void
+        sortAndRemoveDuplicates (std::vector<OctreeKey>& keys_arg);
+
+        /** \brief Generate octree key for arbitrary point coordinates within the bounding box.
+          * \param[in] point_arg point coordinates
+          * \param[out] key_arg write octree key to this reference
+          */
+        inline void
+        genOctreeKeyforPoint (const Eigen::Vector3d& point_arg, OctreeKey& key_arg) const
+        {
+          key_arg.x = static_cast<unsigned int> ((point_arg.x () - this->minX_) / this->resolution_);
+          key_arg.y = static_cast<unsigned int> ((point_arg.y () - this->minY_) / this->resolution_);
+          key_arg.z = static_cast<unsigned int> ((point_arg.z () - this->minZ_) / this->resolution_);
+        }
+
+        using OctreePointCloud<PointT, LeafT, OctreeT>::genOctreeKeyforPoint;
+
+        /** \brief Walk along a ray in octree key space (3D-DDA) and collect all traversed voxels.
+          * \param[in] origin_arg origin of the ray
+          * \param[in] end_arg end point of the ray
+          * \param[out] keys_arg keys of all traversed voxels excluding the end point voxel are appended to this vector
+          */
+        void
+        computeRayKeys (const Eigen::Vector3d& origin_arg, const Eigen::Vector3d& end_arg,
+                        std::vector<OctreeKey>& keys_arg) const;
+
+        /** \brief Integrate an occupancy measurement into the voxel at a given key. Pruned subtrees on the path are expanded.
+          * \param[in] key_arg octree key addressing a leaf node
+          * \param[in] logOdds_arg measurement in log-odds notation
+          */
+        void
+        updateVoxel (const OctreeKey& key_arg, float logOdds_arg);
+
+        /** \brief Find the leaf node covering the voxel at a given key. This can be a pruned leaf node above maximum tree depth.
+          * \param[in] key_arg octree key addressing a leaf node
+          * \return pointer to leaf node or 0 if voxel is unknown
+          */
+        const LeafT*
+        findOccupancyLeaf (const OctreeKey& key_arg) const;
+
+        /** \brief Expand the pruned subtrees along the path to a given key.
+          * \param[in] key_arg octree key addressing a leaf node
+          */
+        void
+        expandPath (const OctreeKey& key_arg);
+
+        /** \brief Replace a pruned leaf node by a branch node with eight leaf children of identical occupancy.
+          * \param[in] branch_arg parent branch of the pruned leaf node
+          * \param[in] childIdx_arg index of the pruned leaf node
+          * \return pointer to the new branch node
+          */
+        OctreeBranch*
+        expandLeafChild (OctreeBranch& branch_arg, unsigned char childIdx_arg);
+
+        /** \brief Recursively prune the subtree below a branch node.
+          * \param[in] branch_arg current branch node
+          */
+        void
+        pruneRecursive (OctreeBranch& branch_arg);
+
+        /** \brief Recursively expand all pruned leaf nodes below a branch node.
+          * \param[in] branch_arg current branch node
+          * \param[in] depthMask_arg depth mask of the current branch node
+          */
+        void
+        expandRecursive (OctreeBranch& branch_arg, unsigned int depthMask_arg);
+
+        /** \brief Recursively collect centers of occupied or free voxels at leaf resolution.
+          * \param[in] branch_arg current branch node
+          * \param[in] key_arg octree key of current branch node
+          * \param[in] treeDepth_arg tree depth of current branch node
+          * \param[in] occupied_arg collect occupied voxels if "true"; free voxels otherwise
+          * \param[out] voxelCenterList_arg results are written to this vector of PointT elements
+          * \return number of voxels found
+          */
+        int
+        getVoxelCentersRecursive (const OctreeBranch& branch_arg, const OctreeKey& key_arg, unsigned int treeDepth_arg,
+                                  bool occupied_arg, AlignedPointTVector &voxelCenterList_arg) const;
+
+        /** \brief Log-odds update for voxels containing an end point. */
+        float logOddsHit_;
+
+        /** \brief Log-odds update for voxels traversed by a ray. */
+        float logOddsMiss_;
+
+        /** \brief Lower clamping threshold in log-odds notation. */
+        float clampingMin_;
+
+        /** \brief Upper clamping threshold in log-odds notation. */
+        float clampingMax_;
+
+        /** \brief Occupancy threshold in log-odds notation. */
+        float occupancyThres_;
+
+        /** \brief Maximum sensor range. Disabled if negative. */
+        double maxRange_;
+
+        /** \brief The number of threads used for ray casting. */
+        unsigned int threads_;
+    };
+  }
+}
+
+#define PCL_INSTANTIATE_OctreePointCloudOccupancyMap(T) template class PCL_EXPORTS pcl::octree::OctreePointCloudOccupancyMap<T>;
+
+#endif
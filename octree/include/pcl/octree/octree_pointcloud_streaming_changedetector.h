@@ -0,0 +1,323 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#ifndef OCTREE_STREAMING_CHANGEDETECTOR_H
+#define OCTREE_STREAMING_CHANGEDETECTOR_H
+
+#include <pcl/pcl_macros.h>
+#include <pcl/point_cloud.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+namespace pcl
+{
+  namespace octree
+  {
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** \brief @b Streaming spatial change detector based on double-buffered voxel sets
+      * \note This class detects spatial changes between consecutive frames of a point cloud stream, such as the frames
+      * \note delivered by an OpenNI grabber. Voxels are addressed by the Morton code of their key on the lowest octree
+      * \note level and stored in two flat open-addressing hash tables, one for the current and one for the previous
+      * \note frame. All buffers are allocated once by the constructor, so that processing a frame does not allocate
+      * \note memory after the output vectors of the caller have reached their working size.
+      * \note Voxel keys span 2^21 voxels per axis, centered at the origin. Points outside of this range and points
+      * \note with non-finite coordinates are ignored.
+      * \note typename: PointT: type of point used in point cloud
+      */
+    template<typename PointT>
+    class OctreePointCloudStreamingChangeDetector
+    {
+      public:
+        typedef pcl::PointCloud<PointT> PointCloud;
+        typedef boost::shared_ptr<PointCloud> PointCloudPtr;
+        typedef boost::shared_ptr<const PointCloud> PointCloudConstPtr;
+
+        typedef boost::shared_ptr<std::vector<int> > IndicesPtr;
+        typedef boost::shared_ptr<const std::vector<int> > IndicesConstPtr;
+
+        // public typedefs for single/double buffering
+        typedef std::vector<PointT, Eigen::aligned_allocator<PointT> > AlignedPointTVector;
+
+        /** \brief Constructor.
+          * \param[in] resolution_arg edge length of a voxel
+          * \param[in] maxPointsPerFrame_arg maximum number of points processed per frame
+          * \param[in] maxVoxelsPerFrame_arg maximum number of occupied voxels per frame
+          */
+        OctreePointCloudStreamingChangeDetector (const double resolution_arg,
+                                                 std::size_t maxPointsPerFrame_arg,
+                                                 std::size_t maxVoxelsPerFrame_arg);
+
+        /** \brief Empty class deconstructor. */
+        virtual
+        ~OctreePointCloudStreamingChangeDetector ()
+        {
+        }
+
+        /** \brief Provide a pointer to the input data set.
+          * \param[in] cloud_arg the const boost shared pointer to a PointCloud message
+          * \param[in] indices_arg the point indices subset that is to be used from \a cloud - if 0 the whole point cloud is used
+          */
+        inline void
+        setInputCloud (const PointCloudConstPtr &cloud_arg,
+                       const IndicesConstPtr &indices_arg = IndicesConstPtr ())
+        {
+          input_ = cloud_arg;
+          indices_ = indices_arg;
+        }
+
+        /** \brief Get a pointer to the input point cloud dataset.
+          * \return pointer to pointcloud input class.
+          */
+        inline PointCloudConstPtr
+        getInputCloud () const
+        {
+          return (input_);
+        }
+
+        /** \brief Get the voxel edge length.
+          * \return voxel resolution
+          */
+        inline double
+        getResolution () const
+        {
+          return (resolution_);
+        }
+
+        /** \brief Set the number of threads used for inserting points.
+          * \param[in] nr_threads the number of hardware threads to use
+          */
+        inline void
+        setNumberOfThreads (unsigned int nr_threads)
+        {
+          if (nr_threads == 0)
+            nr_threads = 1;
+          threads_ = nr_threads;
+        }
+
+        /** \brief Insert the points of the input cloud into the voxel set of the current frame.
+          * \note Points exceeding the per-frame point budget and points which cannot be stored since the voxel table
+          * \note is full are skipped (see getNumberOfDroppedPoints). Voxels are inserted in parallel, each thread
+          * \note filling a separate shard of the voxel table.
+          */
+        void
+        addPointsFromInputCloud ();
+
+        /** \brief Make the current frame the previous frame and start a new, empty frame. */
+        void
+        switchBuffers ();
+
+        /** \brief Get a vector of point indices of the current input cloud whose voxels did not exist in the previous frame.
+          * \param[out] indicesVector_arg results are written to this vector of int indices
+          * \param[in] minPointsPerLeaf_arg minimum amount of points required within a new voxel
+          * \return number of point indices
+          */
+        int
+        getPointIndicesFromNewVoxels (std::vector<int> &indicesVector_arg, const int minPointsPerLeaf_arg = 0);
+
+        /** \brief Get the centers of all voxels of the current frame which did not exist in the previous frame.
+          * \param[out] voxelCenterList_arg results are written to this vector of points
+          * \param[in] minPointsPerLeaf_arg minimum amount of points required within a new voxel
+          * \return number of voxel centers
+          */
+        int
+        getNewVoxelCenters (AlignedPointTVector &voxelCenterList_arg, const int minPointsPerLeaf_arg = 0) const;
+
+        /** \brief Get the centers of all voxels of the previous frame which are not occupied in the current frame.
+          * \param[out] voxelCenterList_arg results are written to this vector of points
+          * \return number of voxel centers
+          */
+        int
+        getRemovedVoxelCenters (AlignedPointTVector &voxelCenterList_arg) const;
+
+        /** \brief Get the number of occupied voxels in the current frame.
+          * \return voxel count
+          */
+        inline std::size_t
+        getVoxelCount () const
+        {
+          return (buffers_[selector_].voxelCount);
+        }
+
+        /** \brief Get the number of points which were skipped while inserting points into the current frame.
+          * \return number of dropped points
+          */
+        inline std::size_t
+        getNumberOfDroppedPoints () const
+        {
+          return (droppedPoints_);
+        }
+
+      protected:
+
+        /** \brief Voxel hash table of a single frame. */
+        struct VoxelTable
+        {
+          /** \brief Morton codes of the stored voxels. Empty slots contain EMPTY_CODE. */
+          std::vector<uint64_t> codes;
+
+          /** \brief Number of points within the stored voxels. */
+          std::vector<unsigned int> counts;
+
+          /** \brief Table is split into 2^shardBits shards of equal size, each filled by a single thread. */
+          unsigned int shardBits;
+
+          /** \brief Number of occupied slots per shard. */
+          std::vector<std::size_t> shardFill;
+
+          /** \brief Number of occupied slots. */
+          std::size_t voxelCount;
+        };
+
+        /** \brief Marks empty table slots and invalid points. Valid codes use 63 bits only. */
+        static const uint64_t EMPTY_CODE = ~static_cast<uint64_t> (0);
+
+        /** \brief Number of bits per axis of a voxel key. */
+        static const unsigned int KEY_BITS = 21;
+
+        /** \brief Minimum number of slots of a table shard. */
+        static const std::size_t MIN_SHARD_SIZE = 4096;
+
+        /** \brief Calculate the Morton code of the voxel containing a point.
+          * \param[in] point_arg query point
+          * \return Morton code or EMPTY_CODE if the point is not finite or outside the addressable range
+          */
+        inline uint64_t
+        genMortonCodeForPoint (const PointT& point_arg) const;
+
+        /** \brief Calculate the voxel center from a Morton code.
+          * \param[in] code_arg Morton code of voxel
+          * \param[out] point_arg voxel center
+          */
+        inline void
+        genVoxelCenterFromMortonCode (uint64_t code_arg, PointT& point_arg) const;
+
+        /** \brief Spread the lower 21 bits of a value to every third bit. */
+        static inline uint64_t
+        spreadBits (uint64_t value_arg);
+
+        /** \brief Inverse of spreadBits. */
+        static inline uint64_t
+        compactBits (uint64_t value_arg);
+
+        /** \brief Mix the bits of a Morton code. */
+        static inline uint64_t
+        hashCode (uint64_t code_arg)
+        {
+          uint64_t hash = code_arg * 0x9E3779B97F4A7C15ULL;
+          return (hash ^ (hash >> 32));
+        }
+
+        /** \brief Find the table slot of a Morton code.
+          * \param[in] table_arg voxel table
+          * \param[in] code_arg Morton code
+          * \return slot index or -1 if the code is not stored in the table
+          */
+        inline long
+        findSlot (const VoxelTable& table_arg, uint64_t code_arg) const;
+
+        /** \brief Group the point codes by the shard of the current table they belong to, keeping the order of the
+          * points within every shard. The codes of shard i are written to shardCodes_, from shardBounds_[i] to
+          * shardBounds_[i+1]. Invalid codes are skipped.
+          * \param[in] pointCount_arg number of valid entries in pointCodes_
+          */
+        void
+        partitionPointCodes (std::size_t pointCount_arg);
+
+        /** \brief Insert point codes into a single shard of the current table.
+          * \param[in] shard_arg shard index
+          * \param[in] codes_arg the point codes, which must all belong to the shard
+          * \param[in] count_arg number of point codes
+          * \return number of points which could not be stored
+          */
+        std::size_t
+        insertShard (unsigned int shard_arg, const uint64_t* codes_arg, std::size_t count_arg);
+
+        /** \brief Edge length of a voxel. */
+        double resolution_;
+
+        /** \brief Pointer to input point cloud dataset. */
+        PointCloudConstPtr input_;
+
+        /** \brief A pointer to the vector of point indices to use. */
+        IndicesConstPtr indices_;
+
+        /** \brief Maximum number of points processed per frame. */
+        std::size_t maxPoints_;
+
+        /** \brief Number of slots of each voxel table - a power of two. */
+        std::size_t tableSize_;
+
+        /** \brief Voxel tables of the current and the previous frame. */
+        VoxelTable buffers_[2];
+
+        /** \brief Index of the voxel table of the current frame. */
+        unsigned char selector_;
+
+        /** \brief Morton codes of the points of the current input cloud. */
+        std::vector<uint64_t> pointCodes_;
+
+        /** \brief Number of valid entries in pointCodes_. */
+        std::size_t pointCount_;
+
+        /** \brief Point codes grouped by table shard, see partitionPointCodes. */
+        std::vector<uint64_t> shardCodes_;
+
+        /** \brief Per point block and shard counters and write positions used by partitionPointCodes. */
+        std::vector<std::size_t> shardOffsets_;
+
+        /** \brief Start of the codes of every shard within shardCodes_, followed by their total number. */
+        std::vector<std::size_t> shardBounds_;
+
+        /** \brief Per-point flags used for extracting new point indices in parallel. */
+        std::vector<char> pointFlags_;
+
+        /** \brief Number of points skipped while inserting points into the current frame. */
+        std::size_t droppedPoints_;
+
+        /** \brief The number of threads used for inserting points. */
+        unsigned int threads_;
+    };
+  }
+}
+
+#define PCL_INSTANTIATE_OctreePointCloudStreamingChangeDetector(T) template class PCL_EXPORTS pcl::octree::OctreePointCloudStreamingChangeDetector<T>;
+
+#endif
+
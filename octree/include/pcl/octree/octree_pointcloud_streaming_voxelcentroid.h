@@ -0,0 +1,473 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#ifndef OCTREE_STREAMING_VOXELCENTROID_H
+#define OCTREE_STREAMING_VOXELCENTROID_H
+
+#include "octree_pointcloud.h"
+
+#include "octree_base.h"
+
+#include <boost/thread/mutex.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace pcl
+{
+  namespace octree
+  {
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** \brief @b Octree centroid leaf node class
+      * \note This leaf node accumulates the points falling into its voxel. It only stores the sums of the point
+      * \note coordinates, colors and normals together with the number of points. DataT elements are not stored.
+      */
+    template<typename DataT>
+    class OctreeCentroidLeaf : public OctreeLeafAbstract<DataT>
+    {
+      public:
+        /** \brief Class initialization. */
+        OctreeCentroidLeaf ()
+        {
+          reset ();
+        }
+
+        /** \brief Empty class deconstructor. */
+        ~OctreeCentroidLeaf ()
+        {
+        }
+
+        /** \brief deep copy function */
+        virtual OctreeNode *
+        deepCopy () const
+        {
+          return (static_cast<OctreeNode*> (new OctreeCentroidLeaf (*this)));
+        }
+
+        /** \brief Empty setData data implementation. This leaf node only stores accumulated point attributes.
+          */
+        virtual void
+        setData (const DataT&)
+        {
+        }
+
+        /** \brief Returns a null pointer as this leaf node does not store any data.
+          * \param[out] data_arg: reference to return pointer of leaf node DataT element (will be set to 0).
+          */
+        virtual void
+        getData (const DataT*& data_arg) const
+        {
+          data_arg = 0;
+        }
+
+        /** \brief Empty getData data vector implementation as this leaf node does not store any data. \
+          */
+        virtual void
+        getData (std::vector<DataT>&) const
+        {
+        }
+
+        /** \brief Add the coordinates of a point to the voxel.
+          * \param[in] x_arg X coordinate of the point
+          * \param[in] y_arg Y coordinate of the point
+          * \param[in] z_arg Z coordinate of the point
+          */
+        inline void
+        addPoint (double x_arg, double y_arg, double z_arg)
+        {
+          xyzSum_[0] += x_arg;
+          xyzSum_[1] += y_arg;
+          xyzSum_[2] += z_arg;
+          pointCount_++;
+        }
+
+        /** \brief Add the color of a point to the voxel.
+          * \param[in] r_arg red color component
+          * \param[in] g_arg green color component
+          * \param[in] b_arg blue color component
+          */
+        inline void
+        addColor (unsigned int r_arg, unsigned int g_arg, unsigned int b_arg)
+        {
+          rgbSum_[0] += r_arg;
+          rgbSum_[1] += g_arg;
+          rgbSum_[2] += b_arg;
+          colorCount_++;
+        }
+
+        /** \brief Add the normal of a point to the voxel.
+          * \param[in] normalX_arg X component of the normal
+          * \param[in] normalY_arg Y component of the normal
+          * \param[in] normalZ_arg Z component of the normal
+          */
+        inline void
+        addNormal (double normalX_arg, double normalY_arg, double normalZ_arg)
+        {
+          normalSum_[0] += normalX_arg;
+          normalSum_[1] += normalY_arg;
+          normalSum_[2] += normalZ_arg;
+          normalCount_++;
+        }
+
+        /** \brief Add all points accumulated by another leaf node to the voxel.
+          * \param[in] leaf_arg leaf node to be merged
+          */
+        inline void
+        merge (const OctreeCentroidLeaf& leaf_arg)
+        {
+          for (int i = 0; i < 3; ++i)
+          {
+            xyzSum_[i] += leaf_arg.xyzSum_[i];
+            rgbSum_[i] += leaf_arg.rgbSum_[i];
+            normalSum_[i] += leaf_arg.normalSum_[i];
+          }
+          pointCount_ += leaf_arg.pointCount_;
+          colorCount_ += leaf_arg.colorCount_;
+          normalCount_ += leaf_arg.normalCount_;
+        }
+
+        /** \brief Get the number of points accumulated in the voxel. */
+        inline unsigned int
+        getPointCount () const
+        {
+          return (pointCount_);
+        }
+
+        /** \brief Get the number of points with color accumulated in the voxel. */
+        inline unsigned int
+        getColorCount () const
+        {
+          return (colorCount_);
+        }
+
+        /** \brief Get the number of points with a finite normal accumulated in the voxel. */
+        inline unsigned int
+        getNormalCount () const
+        {
+          return (normalCount_);
+        }
+
+        /** \brief Get the centroid of all points in the voxel.
+          * \param[out] x_arg X coordinate of the centroid
+          * \param[out] y_arg Y coordinate of the centroid
+          * \param[out] z_arg Z coordinate of the centroid
+          */
+        inline void
+        getCentroid (float& x_arg, float& y_arg, float& z_arg) const
+        {
+          const double norm = 1.0 / static_cast<double> (std::max (pointCount_, 1u));
+          x_arg = static_cast<float> (xyzSum_[0] * norm);
+          y_arg = static_cast<float> (xyzSum_[1] * norm);
+          z_arg = static_cast<float> (xyzSum_[2] * norm);
+        }
+
+        /** \brief Get the mean color of all points in the voxel.
+          * \param[out] r_arg red color component
+          * \param[out] g_arg green color component
+          * \param[out] b_arg blue color component
+          */
+        inline void
+        getMeanColor (unsigned char& r_arg, unsigned char& g_arg, unsigned char& b_arg) const
+        {
+          const double norm = 1.0 / static_cast<double> (std::max (colorCount_, 1u));
+          r_arg = static_cast<unsigned char> (rgbSum_[0] * norm + 0.5);
+          g_arg = static_cast<unsigned char> (rgbSum_[1] * norm + 0.5);
+          b_arg = static_cast<unsigned char> (rgbSum_[2] * norm + 0.5);
+        }
+
+        /** \brief Get the normalized mean normal of all points in the voxel.
+          * \param[out] normalX_arg X component of the mean normal
+          * \param[out] normalY_arg Y component of the mean normal
+          * \param[out] normalZ_arg Z component of the mean normal
+          * \return "false" if the voxel contains no finite normals or the normals cancel out; "true" otherwise
+          */
+        inline bool
+        getMeanNormal (float& normalX_arg, float& normalY_arg, float& normalZ_arg) const
+        {
+          const double length = std::sqrt (normalSum_[0] * normalSum_[0] + normalSum_[1] * normalSum_[1] +
+                                            normalSum_[2] * normalSum_[2]);
+          if (normalCount_ == 0 || length <= 0.0)
+            return (false);
+
+          normalX_arg = static_cast<float> (normalSum_[0] / length);
+          normalY_arg = static_cast<float> (normalSum_[1] / length);
+          normalZ_arg = static_cast<float> (normalSum_[2] / length);
+          return (true);
+        }
+
+        /** \brief Reset leaf node to an empty voxel. */
+        virtual void
+        reset ()
+        {
+          for (int i = 0; i < 3; ++i)
+            xyzSum_[i] = rgbSum_[i] = normalSum_[i] = 0.0;
+          pointCount_ = colorCount_ = normalCount_ = 0;
+        }
+
+      private:
+        /** \brief Sum of point coordinates. */
+        double xyzSum_[3];
+
+        /** \brief Sum of point colors. */
+        double rgbSum_[3];
+
+        /** \brief Sum of point normals. */
+        double normalSum_[3];
+
+        /** \brief Number of accumulated points. */
+        unsigned int pointCount_;
+
+        /** \brief Number of accumulated colors. */
+        unsigned int colorCount_;
+
+        /** \brief Number of accumulated finite normals. */
+        unsigned int normalCount_;
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** \brief @b Octree pointcloud streaming voxel centroid class
+     *  \note This class downsamples point clouds of arbitrary size to the centroids of their occupied voxels. In
+     *  \note contrast to OctreePointCloudVoxelCentroid, point indices are not stored. Each leaf node keeps running sums
+     *  \note of the coordinates and (optionally) colors and normals of its points, so that memory usage is
+     *  \note proportional to the number of occupied voxels and independent of the number of inserted points.
+     *  \note Points are inserted in batches, e.g. chunks read from a file. \a addPoints may be called concurrently from
+     *  \note several threads: voxel sums of a batch are computed without locking in Morton order and merged into the
+     *  \note octree under a mutex. The voxel grid is aligned to the origin, so that the result does not depend on the
+     *  \note insertion order. The bounding box grows automatically.
+     *  \note Color and normal accumulation is enabled if PointT provides "rgb"/"rgba" or "normal_x" fields.
+     *  \note
+     *  \note typename: PointT: type of point used in pointcloud
+     *  \ingroup octree
+     */
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    template<typename PointT, typename LeafT = OctreeCentroidLeaf<int> , typename OctreeT = OctreeBase<int, LeafT> >
+    class OctreePointCloudStreamingVoxelCentroid : public OctreePointCloud<PointT, LeafT, OctreeT>
+    {
+      public:
+        // public typedefs for single buffering
+        typedef OctreePointCloudStreamingVoxelCentroid<PointT, LeafT, OctreeBase<int, LeafT> > SingleBuffer;
+
+        // public point cloud typedefs
+        typedef typename OctreePointCloud<PointT, LeafT, OctreeT>::PointCloud PointCloud;
+        typedef typename OctreePointCloud<PointT, LeafT, OctreeT>::PointCloudPtr PointCloudPtr;
+        typedef typename OctreePointCloud<PointT, LeafT, OctreeT>::PointCloudConstPtr PointCloudConstPtr;
+
+        // Eigen aligned allocator
+        typedef typename OctreePointCloud<PointT, LeafT, OctreeT>::AlignedPointTVector AlignedPointTVector;
+
+        /** \brief Constructor.
+         *  \param resolution_arg:  octree resolution at lowest octree level
+         * */
+        OctreePointCloudStreamingVoxelCentroid (const double resolution_arg);
+
+        /** \brief Empty class deconstructor. */
+        virtual
+        ~OctreePointCloudStreamingVoxelCentroid ()
+        {
+        }
+
+        /** \brief Set the number of threads used for processing a single batch of points.
+          * \param[in] nr_threads the number of hardware threads to use
+          */
+        inline void
+        setNumberOfThreads (unsigned int nr_threads)
+        {
+          if (nr_threads == 0)
+            nr_threads = 1;
+          threads_ = nr_threads;
+        }
+
+        /** \brief Enable or disable the accumulation of point colors (default: enabled if PointT has a color field).
+          * \param[in] enable_arg "true" to average point colors
+          */
+        inline void
+        setAccumulateColor (bool enable_arg)
+        {
+          accumulateColor_ = enable_arg && (rgbOffset_ >= 0);
+        }
+
+        /** \brief Check if point colors are accumulated. */
+        inline bool
+        getAccumulateColor () const
+        {
+          return (accumulateColor_);
+        }
+
+        /** \brief Enable or disable the accumulation of point normals (default: enabled if PointT has normal fields).
+          * \param[in] enable_arg "true" to average point normals
+          */
+        inline void
+        setAccumulateNormals (bool enable_arg)
+        {
+          accumulateNormals_ = enable_arg && (normalOffset_ >= 0);
+        }
+
+        /** \brief Check if point normals are accumulated. */
+        inline bool
+        getAccumulateNormals () const
+        {
+          return (accumulateNormals_);
+        }
+
+        /** \brief Add the points from the input point cloud (see setInputCloud) as a single batch. */
+        void
+        addPointsFromInputCloud ();
+
+        /** \brief Add a batch of points. This method may be called concurrently from several threads.
+          * \param[in] cloud_arg points to be added. Points with non-finite coordinates are ignored.
+          */
+        void
+        addPoints (const PointCloud& cloud_arg);
+
+        /** \brief Add a batch of points given by an indices subset of a point cloud. This method may be called
+          * concurrently from several threads.
+          * \param[in] cloud_arg point cloud
+          * \param[in] indices_arg indices of the points to be added
+          */
+        void
+        addPoints (const PointCloud& cloud_arg, const std::vector<int>& indices_arg);
+
+        /** \brief Get the total number of points accumulated in the octree.
+          * \return number of points
+          */
+        inline uint64_t
+        getPointCount () const
+        {
+          return (pointCount_);
+        }
+
+        /** \brief Get PointT vector of centroids for all occupied voxels. Colors and normals are averaged if enabled.
+          * \param[out] voxelCentroidList_arg results are written to this vector of PointT elements
+          * \return number of occupied voxels
+          */
+        unsigned int
+        getVoxelCentroids (AlignedPointTVector &voxelCentroidList_arg) const;
+
+        /** \brief Get a point cloud of centroids for all occupied voxels. Colors and normals are averaged if enabled.
+          * \param[out] cloud_arg unorganized point cloud receiving the voxel centroids
+          * \return number of occupied voxels
+          */
+        unsigned int
+        getVoxelCentroids (PointCloud &cloud_arg) const;
+
+        /** \brief Get centroid for a single voxel addressed by a PointT point.
+          * \param[in] point_arg point addressing a voxel in octree
+          * \param[out] voxelCentroid_arg centroid is written to this PointT reference
+          * \return "true" if voxel is found; "false" otherwise
+          */
+        bool
+        getVoxelCentroidAtPoint (const PointT& point_arg, PointT& voxelCentroid_arg) const;
+
+        /** \brief Delete the octree structure and all accumulated points. */
+        void
+        deleteTree ();
+
+      protected:
+        typedef typename OctreePointCloud<PointT, LeafT, OctreeT>::OctreeBranch OctreeBranch;
+
+        /** \brief Compute the integer coordinates of the voxel containing a point on the origin-aligned voxel grid.
+          * \param[in] point_arg point
+          * \param[out] voxel_arg voxel coordinates
+          */
+        inline void
+        genVoxelCoordinates (const PointT& point_arg, int64_t voxel_arg[3]) const
+        {
+          voxel_arg[0] = static_cast<int64_t> (std::floor (point_arg.x / this->resolution_));
+          voxel_arg[1] = static_cast<int64_t> (std::floor (point_arg.y / this->resolution_));
+          voxel_arg[2] = static_cast<int64_t> (std::floor (point_arg.z / this->resolution_));
+        }
+
+        /** \brief Add a batch of points.
+          * \param[in] cloud_arg point cloud
+          * \param[in] indices_arg indices of the points to be added, or 0 to add all points
+          */
+        void
+        addPointBatch (const PointCloud& cloud_arg, const std::vector<int>* indices_arg);
+
+        /** \brief Grow the octree until it contains all voxels of a bounding box. The caller must hold the mutex.
+          * \param[in] minVoxel_arg minimum voxel coordinates of the bounding box
+          * \param[in] maxVoxel_arg maximum voxel coordinates of the bounding box
+          * \return "false" if the octree can not be grown to the requested size; "true" otherwise
+          */
+        bool
+        adoptBoundingBoxToVoxels (const int64_t minVoxel_arg[3], const int64_t maxVoxel_arg[3]);
+
+        /** \brief Add a point to a leaf node.
+          * \param[in] point_arg point
+          * \param[out] leaf_arg leaf node accumulating the point
+          */
+        void
+        accumulatePoint (const PointT& point_arg, LeafT& leaf_arg) const;
+
+        /** \brief Write the centroid of a leaf node to a point.
+          * \param[in] leaf_arg leaf node
+          * \param[out] point_arg centroid point
+          */
+        void
+        genCentroidFromLeaf (const LeafT& leaf_arg, PointT& point_arg) const;
+
+        /** \brief Voxel coordinates of the voxel at octree key (0, 0, 0). */
+        int64_t originVoxel_[3];
+
+        /** \brief Total number of accumulated points. */
+        uint64_t pointCount_;
+
+        /** \brief The number of threads used for processing a single batch of points. */
+        unsigned int threads_;
+
+        /** \brief Byte offset of the color field in PointT, or -1 if not available. */
+        int rgbOffset_;
+
+        /** \brief Byte offset of the normal_x field in PointT, or -1 if not available. */
+        int normalOffset_;
+
+        /** \brief Accumulate point colors. */
+        bool accumulateColor_;
+
+        /** \brief Accumulate point normals. */
+        bool accumulateNormals_;
+
+        /** \brief Mutex guarding the octree structure during concurrent insertion. */
+        boost::mutex mutex_;
+    };
+  }
+}
+
+#define PCL_INSTANTIATE_OctreePointCloudStreamingVoxelCentroid(T) template class PCL_EXPORTS pcl::octree::OctreePointCloudStreamingVoxelCentroid<T>;
+
+#endif
@@ -0,0 +1,219 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#ifndef OCTREE_RANGE_BASE_H
+#define OCTREE_RANGE_BASE_H
+
+#include <cstddef>
+#include <vector>
+
+#include "octree_nodes.h"
+#include "octree_key.h"
+#include "octree_base.h"
+
+namespace pcl
+{
+  namespace octree
+  {
+    /** \brief Octree class storing the DataT elements of all leaf nodes in a single contiguous vector
+      * \note Leaf nodes of type OctreeLeafDataTRange only store a (begin, count) range into a shared DataT vector,
+      * \note thus no heap memory is allocated per leaf node. DataT elements added to the octree are first appended to
+      * \note compact overflow chunk lists. compactLeafData() reorders all DataT elements by the depth-first order of
+      * \note the octree and assigns contiguous ranges to the leaf nodes. OctreePointCloud calls it after
+      * \note addPointsFromInputCloud(), points added afterwards are stored in overflow chunks again.
+      * \note This octree can be used as OctreeT argument of OctreePointCloudPointVector and OctreePointCloudSearch:
+      * \note typedef OctreeLeafDataTRange<int> LeafT;
+      * \note OctreePointCloudSearch<PointT, LeafT, OctreeRangeBase<int, LeafT> > octree (resolution);
+      * \ingroup octree
+      */
+    template<typename DataT, typename LeafT = OctreeLeafDataTRange<DataT>, typename OctreeBranchT = OctreeBranch>
+    class OctreeRangeBase : public OctreeBase<DataT, LeafT, OctreeBranchT>
+    {
+      public:
+        typedef OctreeBase<DataT, LeafT, OctreeBranchT> BaseT;
+        typedef typename BaseT::OctreeBranch OctreeBranch;
+        typedef typename LeafT::Storage Storage;
+
+        /** \brief Empty constructor. */
+        OctreeRangeBase () :
+          BaseT (),
+          storage_ ()
+        {
+        }
+
+        /** \brief Empty deconstructor. */
+        virtual
+        ~OctreeRangeBase ()
+        {
+        }
+
+        /** \brief Copy constructor. */
+        OctreeRangeBase (const OctreeRangeBase& source) :
+          BaseT (source),
+          storage_ (source.storage_)
+        {
+          bindStorageRecursive (this->rootNode_);
+        }
+
+        /** \brief Copy operator. */
+        inline OctreeRangeBase&
+        operator = (const OctreeRangeBase &source)
+        {
+          BaseT::operator= (source);
+          storage_ = source.storage_;
+          bindStorageRecursive (this->rootNode_);
+          return (*this);
+        }
+
+        /** \brief Add a const DataT element to leaf node at (idxX, idxY, idxZ). If leaf node does not exist, it is created and added to the octree.
+          * \param[in] idxX_arg index of leaf node in the X axis.
+          * \param[in] idxY_arg index of leaf node in the Y axis.
+          * \param[in] idxZ_arg index of leaf node in the Z axis.
+          * \param[in] data_arg const reference to DataT object to be added.
+          */
+        inline void
+        add (unsigned int idxX_arg, unsigned int idxY_arg, unsigned int idxZ_arg, const DataT& data_arg)
+        {
+          add (OctreeKey (idxX_arg, idxY_arg, idxZ_arg), data_arg);
+        }
+
+        /** \brief Delete the octree structure and its leaf nodes.
+          * \param[in] freeMemory_arg: if "true", allocated octree nodes and DataT storage are deleted, otherwise they
+          * are pushed to the octree node pool and the DataT storage keeps its capacity.
+          */
+        void
+        deleteTree (bool freeMemory_arg = true);
+
+        /** \brief Reorder the DataT elements of all leaf nodes by the depth-first order of the octree into a single
+          * contiguous vector and release all overflow chunks.
+          */
+        void
+        compactLeafData ();
+
+        /** \brief Get the number of overflow chunks in use.
+          * \return number of overflow chunks
+          */
+        inline std::size_t
+        getOverflowChunkCount () const
+        {
+          return (storage_.chunks.size ());
+        }
+
+      protected:
+
+        typedef typename BaseT::OctreeLeaf OctreeLeaf;
+
+        /** \brief Add DataT object to leaf node at octree key.
+          * \param[in] key_arg octree key addressing a leaf node.
+          * \param[in] data_arg DataT object to be added.
+          */
+        inline void
+        add (const OctreeKey& key_arg, const DataT& data_arg)
+        {
+          // request a (new) leaf from tree
+          LeafT* leaf = this->createLeaf (key_arg);
+
+          // assign data to leaf
+          if (leaf)
+          {
+            leaf->setStorage (&storage_);
+            leaf->setData (data_arg);
+            this->objectCount_++;
+          }
+        }
+
+        /** \brief Bind leaf node to storage and initialize it with genDataTByOctreeKey.
+          * \param[in] leaf_arg reference to new leaf node
+          * \param[in] key_arg octree key of new leaf node
+          */
+        virtual void
+        deserializeLeafCallback (OctreeLeaf& leaf_arg, const OctreeKey& key_arg)
+        {
+          leaf_arg.setStorage (&storage_);
+          BaseT::deserializeLeafCallback (leaf_arg, key_arg);
+        }
+
+        /** \brief Bind leaf node to storage and initialize it with DataT elements from vector.
+          * \param[in] leaf_arg reference to new leaf node
+          * \param[in] key_arg octree key of new leaf node
+          * \param[in] dataVectorIterator_arg iterator used to obtain DataT elements
+          * \param[in] dataVectorEndIterator_arg iterator pointing to last object in input DataT vector
+          */
+        virtual void
+        deserializeLeafCallback (OctreeLeaf& leaf_arg, const OctreeKey& key_arg,
+                                 typename std::vector<DataT>::const_iterator& dataVectorIterator_arg,
+                                 typename std::vector<DataT>::const_iterator& dataVectorEndIterator_arg)
+        {
+          leaf_arg.setStorage (&storage_);
+          BaseT::deserializeLeafCallback (leaf_arg, key_arg, dataVectorIterator_arg, dataVectorEndIterator_arg);
+        }
+
+        /** \brief Bind leaf node to storage, initialize it with genDataTByOctreeKey and copy the DataT element to vector.
+          * \param[in] leaf_arg reference to new leaf node
+          * \param[in] key_arg octree key of new leaf node
+          * \param[out] dataVector_arg vector of DataT elements
+          */
+        virtual void
+        deserializeTreeAndSerializeLeafCallback (OctreeLeaf& leaf_arg, const OctreeKey & key_arg,
+                                                 std::vector<DataT>& dataVector_arg)
+        {
+          leaf_arg.setStorage (&storage_);
+          BaseT::deserializeTreeAndSerializeLeafCallback (leaf_arg, key_arg, dataVector_arg);
+        }
+
+        /** \brief Recursively copy the DataT elements of all leaf nodes to a vector and assign the resulting ranges.
+          * \param[in] branch_arg current branch node
+          * \param[out] dataVector_arg reordered DataT vector
+          */
+        void
+        compactRecursive (OctreeBranch* branch_arg, std::vector<DataT>& dataVector_arg);
+
+        /** \brief Recursively bind all leaf nodes to the storage of this octree.
+          * \param[in] branch_arg current branch node
+          */
+        void
+        bindStorageRecursive (OctreeBranch* branch_arg);
+
+        /** \brief Shared DataT storage of all leaf nodes. */
+        Storage storage_;
+    };
+  }
+}
+
+#endif
+
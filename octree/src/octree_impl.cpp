@@ -48,6 +48,7 @@
 template class PCL_EXPORTS pcl::octree::OctreeBase<int>;
 template class PCL_EXPORTS pcl::octree::Octree2BufBase<int>;
 template class PCL_EXPORTS pcl::octree::OctreeLowMemBase<int>;
+template class PCL_EXPORTS pcl::octree::OctreeRangeBase<int>;
 
 
 template class PCL_EXPORTS pcl::octree::OctreeBase<int, pcl::octree::OctreeLeafDataTVector<int> >;
@@ -58,6 +59,7 @@ PCL_INSTANTIATE(OctreePointCloudSearch, PCL_XYZ_POINT_TYPES)
 
 PCL_INSTANTIATE(OctreePointCloudSingleBufferWithLeafDataTVector, PCL_XYZ_POINT_TYPES)
 PCL_INSTANTIATE(OctreePointCloudDoubleBufferWithLeafDataTVector, PCL_XYZ_POINT_TYPES)
+PCL_INSTANTIATE(OctreePointCloudStreamingChangeDetector, PCL_XYZ_POINT_TYPES)
 //PCL_INSTANTIATE(OctreePointCloudLowMemWithLeafDataTVector, PCL_XYZ_POINT_TYPES);
 
 // PCL_INSTANTIATE(OctreePointCloudSingleBufferWithLeafDataT, PCL_XYZ_POINT_TYPES);
@@ -71,9 +73,11 @@ PCL_INSTANTIATE(OctreePointCloudDoubleBufferWithLeafDataTVector, PCL_XYZ_POINT_T
 // PCL_INSTANTIATE(OctreePointCloudDoubleBufferWithDensityLeaf, PCL_XYZ_POINT_TYPES);
 
 // PCL_INSTANTIATE(OctreePointCloudOccupancy, PCL_XYZ_POINT_TYPES);
+// PCL_INSTANTIATE(OctreePointCloudOccupancyMap, PCL_XYZ_POINT_TYPES);
 // PCL_INSTANTIATE(OctreePointCloudSinglePoint, PCL_XYZ_POINT_TYPES);
 // PCL_INSTANTIATE(OctreePointCloudPointVector, PCL_XYZ_POINT_TYPES);
 // PCL_INSTANTIATE(OctreePointCloudChangeDetector, PCL_XYZ_POINT_TYPES);
 // PCL_INSTANTIATE(OctreePointCloudVoxelCentroid, PCL_XYZ_POINT_TYPES);
+// PCL_INSTANTIATE(OctreePointCloudStreamingVoxelCentroid, PCL_XYZ_POINT_TYPES);
 
 
@@ -36,6 +36,7 @@
 #include <gtest/gtest.h>
 
 #include <vector>
+#include <map>
 
 #include <stdio.h>
 
@@ -1082,6 +1083,93 @@ TEST(PCL, Octree_Pointcloud_Occupancy_Test)
 
 }
 
+TEST (PCL, Octree_Pointcloud_Occupancy_Map_Test)
+{
+  // instantiate point cloud
+  PointCloud<PointXYZ> cloudIn;
+
+  const float resolution = 0.1f;
+
+  // scan of a wall at distance 2.0 in front of the sensor
+  for (float y = -0.5f; y <= 0.5f; y += 0.02f)
+    for (float z = -0.5f; z <= 0.5f; z += 0.02f)
+      cloudIn.points.push_back (PointXYZ (2.05f, y, z));
+  cloudIn.width = static_cast<uint32_t> (cloudIn.points.size ());
+  cloudIn.height = 1;
+
+  const Eigen::Vector3f origin (0.05f, 0.05f, 0.05f);
+
+  OctreePointCloudOccupancyMap<PointXYZ> octree (resolution);
+  OctreePointCloudOccupancyMap<PointXYZ> octreeMT (resolution);
+  octreeMT.setNumberOfThreads (4);
+
+  for (unsigned int i = 0; i < 5; i++)
+  {
+    octree.insertScan (cloudIn, origin);
+    octreeMT.insertScan (cloudIn, origin);
+  }
+
+  // wall voxels are occupied
+  for (size_t i = 0; i < cloudIn.points.size (); i++)
+    ASSERT_EQ (octree.isVoxelOccupiedAtPoint (cloudIn.points[i]), true);
+
+  // voxels between sensor and wall are free; voxels behind the wall are unknown
+  double probability;
+  ASSERT_EQ (octree.isVoxelFreeAtPoint (PointXYZ (1.0f, 0.05f, 0.05f)), true);
+  ASSERT_EQ (octree.getOccupancyAtPoint (PointXYZ (1.0f, 0.05f, 0.05f), probability), true);
+  EXPECT_LT (probability, 0.5);
+  ASSERT_EQ (octree.getOccupancyAtPoint (PointXYZ (2.5f, 0.05f, 0.05f), probability), false);
+
+  // probabilities are clamped
+  ASSERT_EQ (octree.getOccupancyAtPoint (PointXYZ (2.05f, 0.05f, 0.05f), probability), true);
+  double clampingMin, clampingMax;
+  octree.getClampingThresholds (clampingMin, clampingMax);
+  EXPECT_NEAR (probability, clampingMax, 1e-4);
+
+  // multithreaded scan integration leads to the same map
+  OctreePointCloudOccupancyMap<PointXYZ>::AlignedPointTVector occupied, occupiedMT, freeVoxels, freeVoxelsMT;
+  ASSERT_EQ (octree.getOccupiedVoxelCenters (occupied), octreeMT.getOccupiedVoxelCenters (occupiedMT));
+  ASSERT_EQ (octree.getFreeVoxelCenters (freeVoxels), octreeMT.getFreeVoxelCenters (freeVoxelsMT));
+  ASSERT_EQ (octree.getLeafCount (), octreeMT.getLeafCount ());
+  ASSERT_GT (occupied.size (), static_cast<std::size_t> (0));
+
+  // pruning merges homogeneous subtrees without changing the map
+  std::size_t leafCount = octree.getLeafCount ();
+  octree.prune ();
+  ASSERT_LT (octree.getLeafCount (), leafCount);
+
+  OctreePointCloudOccupancyMap<PointXYZ>::AlignedPointTVector voxelCenters;
+  ASSERT_EQ (octree.getOccupiedVoxelCenters (voxelCenters), static_cast<int> (occupied.size ()));
+  ASSERT_EQ (octree.getFreeVoxelCenters (voxelCenters), static_cast<int> (freeVoxels.size ()));
+  for (size_t i = 0; i < freeVoxels.size (); i++)
+    ASSERT_EQ (octree.isVoxelFreeAtPoint (freeVoxels[i]), true);
+  for (size_t i = 0; i < occupied.size (); i++)
+    ASSERT_EQ (octree.isVoxelOccupiedAtPoint (occupied[i]), true);
+
+  // leaf node iterator visits pruned leaf nodes
+  std::size_t iteratedLeafs = 0;
+  OctreePointCloudOccupancyMap<PointXYZ>::LeafNodeIterator it (octree);
+  while (*++it)
+    iteratedLeafs++;
+  ASSERT_EQ (iteratedLeafs, octree.getLeafCount ());
+
+  // updating a pruned voxel expands its subtree
+  octree.insertScan (cloudIn, origin + Eigen::Vector3f (0.0f, 0.0f, 0.3f));
+  for (size_t i = 0; i < cloudIn.points.size (); i++)
+    ASSERT_EQ (octree.isVoxelOccupiedAtPoint (cloudIn.points[i]), true);
+
+  octree.expand ();
+  octree.deleteVoxelAtPoint (PointXYZ (1.0f, 0.05f, 0.05f));
+  ASSERT_EQ (octree.getOccupancyAtPoint (PointXYZ (1.0f, 0.05f, 0.05f), probability), false);
+
+  // end points beyond the maximum range only update free space
+  OctreePointCloudOccupancyMap<PointXYZ> octreeRange (resolution);
+  octreeRange.setMaxRange (1.5);
+  octreeRange.insertScan (cloudIn, origin);
+  ASSERT_EQ (octreeRange.isVoxelFreeAtPoint (PointXYZ (1.0f, 0.05f, 0.05f)), true);
+  ASSERT_EQ (octreeRange.getOccupiedVoxelCenters (voxelCenters), 0);
+}
+
 TEST (PCL, Octree_Pointcloud_Change_Detector_Test)
 {
   // instantiate point cloud
@@ -1144,6 +1232,107 @@ TEST (PCL, Octree_Pointcloud_Change_Detector_Test)
 
 }
 
+TEST (PCL, Octree_Pointcloud_Streaming_Change_Detector_Test)
+{
+  // instantiate point clouds
+
+  PointCloud<PointXYZ>::Ptr cloudA (new PointCloud<PointXYZ> ());
+  PointCloud<PointXYZ>::Ptr cloudB (new PointCloud<PointXYZ> ());
+
+  size_t i;
+
+  srand (static_cast<unsigned int> (time (NULL)));
+
+  // generate point data for point cloud
+  for (i = 0; i < 1000; i++)
+  {
+    cloudA->push_back (PointXYZ (static_cast<float> (5.0  * rand () / RAND_MAX),
+                                 static_cast<float> (10.0 * rand () / RAND_MAX),
+                                 static_cast<float> (10.0 * rand () / RAND_MAX)));
+  }
+
+  // second frame: first frame and 1000 additional points in a distant region
+  *cloudB = *cloudA;
+  for (i = 0; i < 1000; i++)
+  {
+    cloudB->push_back (PointXYZ (static_cast<float> (-100.0 + 5.0  * rand () / RAND_MAX),
+                                 static_cast<float> (100.0 + 10.0 * rand () / RAND_MAX),
+                                 static_cast<float> (100.0 + 10.0 * rand () / RAND_MAX)));
+  }
+  cloudB->push_back (PointXYZ (std::numeric_limits<float>::quiet_NaN (), 0.0f, 0.0f));
+
+  for (unsigned int threads = 1; threads <= 4; threads *= 4)
+  {
+    OctreePointCloudStreamingChangeDetector<PointXYZ> detector (0.01f, 4000, 4000);
+    detector.setNumberOfThreads (threads);
+
+    detector.setInputCloud (cloudA);
+    detector.addPointsFromInputCloud ();
+
+    const std::size_t voxelsA = detector.getVoxelCount ();
+    ASSERT_GT (voxelsA, static_cast<std::size_t> (0));
+
+    detector.switchBuffers ();
+
+    detector.setInputCloud (cloudB);
+    detector.addPointsFromInputCloud ();
+
+    ASSERT_EQ (detector.getNumberOfDroppedPoints (), static_cast<std::size_t> (0));
+
+    vector<int> newPointIdxVector;
+
+    // get a vector of new points, which did not exist in previous buffer
+    detector.getPointIndicesFromNewVoxels (newPointIdxVector);
+
+    // should be 1000 in ascending order
+    ASSERT_EQ (newPointIdxVector.size (), static_cast<std::size_t> (1000));
+    for (i = 0; i < 1000; i++)
+    {
+      ASSERT_EQ (newPointIdxVector[i], static_cast<int> (1000 + i));
+    }
+
+    OctreePointCloudStreamingChangeDetector<PointXYZ>::AlignedPointTVector newVoxelCenters;
+    detector.getNewVoxelCenters (newVoxelCenters);
+    ASSERT_EQ (newVoxelCenters.size (), detector.getVoxelCount () - voxelsA);
+
+    // every new voxel center lies within the distant region
+    for (i = 0; i < newVoxelCenters.size (); i++)
+    {
+      ASSERT_LE (newVoxelCenters[i].x, -95.0f + 0.01f);
+      ASSERT_GE (newVoxelCenters[i].y, 100.0f - 0.01f);
+      ASSERT_GE (newVoxelCenters[i].z, 100.0f - 0.01f);
+    }
+
+    // no voxel disappeared
+    OctreePointCloudStreamingChangeDetector<PointXYZ>::AlignedPointTVector removedVoxelCenters;
+    ASSERT_EQ (detector.getRemovedVoxelCenters (removedVoxelCenters), 0);
+
+    const std::size_t voxelsB = detector.getVoxelCount ();
+
+    detector.switchBuffers ();
+
+    // third frame: the distant region disappears
+    detector.setInputCloud (cloudA);
+    detector.addPointsFromInputCloud ();
+
+    ASSERT_EQ (detector.getPointIndicesFromNewVoxels (newPointIdxVector), 0);
+    ASSERT_EQ (detector.getNewVoxelCenters (newVoxelCenters), 0);
+    ASSERT_EQ (detector.getRemovedVoxelCenters (removedVoxelCenters), static_cast<int> (voxelsB - voxelsA));
+    for (i = 0; i < removedVoxelCenters.size (); i++)
+    {
+      ASSERT_LE (removedVoxelCenters[i].x, -95.0f + 0.01f);
+    }
+  }
+
+  // point budget exceeded - surplus points are dropped
+  OctreePointCloudStreamingChangeDetector<PointXYZ> smallDetector (0.001f, 1500, 1500);
+  smallDetector.setInputCloud (cloudB);
+  smallDetector.addPointsFromInputCloud ();
+
+  ASSERT_EQ (smallDetector.getNumberOfDroppedPoints (), static_cast<std::size_t> (501));
+  ASSERT_LE (smallDetector.getVoxelCount (), static_cast<std::size_t> (1500));
+}
+
 TEST (PCL, Octree_Pointcloud_Voxel_Centroid_Test)
 {
 
@@ -1193,6 +1382,130 @@ TEST (PCL, Octree_Pointcloud_Voxel_Centroid_Test)
 
 }
 
+TEST (PCL, Octree_Pointcloud_Streaming_Voxel_Centroid_Test)
+{
+  const double resolution = 0.5;
+  const int batches = 8;
+
+  PointCloud<PointXYZ> cloudIn;
+
+  OctreePointCloudStreamingVoxelCentroid<PointXYZ> octree (resolution);
+  octree.setNumberOfThreads (2);
+
+  srand (static_cast<unsigned int> (time (NULL)));
+
+  cloudIn.width = 10000;
+  cloudIn.height = 1;
+  cloudIn.points.resize (cloudIn.width * cloudIn.height);
+
+  // generate point data for point cloud
+  for (size_t i = 0; i < cloudIn.points.size (); i++)
+  {
+    cloudIn.points[i] = PointXYZ (static_cast<float> (10.0 * rand () / RAND_MAX - 5.0),
+                                  static_cast<float> (10.0 * rand () / RAND_MAX - 5.0),
+                                  static_cast<float> (10.0 * rand () / RAND_MAX - 5.0));
+  }
+  cloudIn.points[42].x = std::numeric_limits<float>::quiet_NaN ();
+
+  // compute reference centroids
+  std::map<std::vector<int>, std::pair<Eigen::Vector3d, int> > voxelMap;
+  for (size_t i = 0; i < cloudIn.points.size (); i++)
+  {
+    const PointXYZ& point = cloudIn.points[i];
+    if (!pcl_isfinite (point.x))
+      continue;
+
+    std::vector<int> voxel (3);
+    voxel[0] = static_cast<int> (floor (point.x / resolution));
+    voxel[1] = static_cast<int> (floor (point.y / resolution));
+    voxel[2] = static_cast<int> (floor (point.z / resolution));
+
+    std::pair<Eigen::Vector3d, int>& entry = voxelMap.insert (
+        std::make_pair (voxel, std::make_pair (Eigen::Vector3d::Zero ().eval (), 0))).first->second;
+    entry.first += point.getVector3fMap ().cast<double> ();
+    entry.second++;
+  }
+
+  // add interleaved point batches concurrently
+  #pragma omp parallel for num_threads (4)
+  for (int b = 0; b < batches; b++)
+  {
+    std::vector<int> indices;
+    for (int i = b; i < static_cast<int> (cloudIn.points.size ()); i += batches)
+      indices.push_back (i);
+    octree.addPoints (cloudIn, indices);
+  }
+
+  ASSERT_EQ (octree.getPointCount (), cloudIn.points.size () - 1);
+  ASSERT_EQ (octree.getLeafCount (), voxelMap.size ());
+
+  pcl::PointCloud<PointXYZ> voxelCentroids;
+  ASSERT_EQ (octree.getVoxelCentroids (voxelCentroids), voxelMap.size ());
+
+  // check centroid calculation
+  for (size_t i = 0; i < voxelCentroids.points.size (); i++)
+  {
+    const PointXYZ& centroid = voxelCentroids.points[i];
+
+    std::vector<int> voxel (3);
+    voxel[0] = static_cast<int> (floor (centroid.x / resolution));
+    voxel[1] = static_cast<int> (floor (centroid.y / resolution));
+    voxel[2] = static_cast<int> (floor (centroid.z / resolution));
+
+    ASSERT_TRUE (voxelMap.find (voxel) != voxelMap.end ());
+    const Eigen::Vector3d expected = voxelMap[voxel].first / voxelMap[voxel].second;
+    EXPECT_NEAR (centroid.x, expected.x (), 1e-4);
+    EXPECT_NEAR (centroid.y, expected.y (), 1e-4);
+    EXPECT_NEAR (centroid.z, expected.z (), 1e-4);
+
+    PointXYZ voxelCentroid;
+    ASSERT_TRUE (octree.getVoxelCentroidAtPoint (centroid, voxelCentroid));
+    EXPECT_NEAR (voxelCentroid.x, centroid.x, 1e-6);
+  }
+
+  // growing the bounding box keeps accumulated voxels
+  PointCloud<PointXYZ> farCloud;
+  farCloud.points.push_back (PointXYZ (100.2f, -250.2f, 3.2f));
+  farCloud.points.push_back (PointXYZ (100.4f, -250.4f, 3.4f));
+  octree.addPoints (farCloud);
+
+  ASSERT_EQ (octree.getLeafCount (), voxelMap.size () + 1);
+
+  PointXYZ voxelCentroid;
+  ASSERT_TRUE (octree.getVoxelCentroidAtPoint (farCloud.points[0], voxelCentroid));
+  EXPECT_NEAR (voxelCentroid.x, 100.3f, 1e-4);
+  EXPECT_NEAR (voxelCentroid.y, -250.3f, 1e-4);
+  ASSERT_TRUE (octree.getVoxelCentroidAtPoint (voxelCentroids.points[0], voxelCentroid));
+  EXPECT_NEAR (voxelCentroid.x, voxelCentroids.points[0].x, 1e-6);
+  ASSERT_FALSE (octree.getVoxelCentroidAtPoint (PointXYZ (50.0f, 50.0f, 50.0f), voxelCentroid));
+
+  // colors and normals are averaged
+  OctreePointCloudStreamingVoxelCentroid<PointXYZRGBNormal> octreeRGBNormal (resolution);
+  ASSERT_TRUE (octreeRGBNormal.getAccumulateColor ());
+  ASSERT_TRUE (octreeRGBNormal.getAccumulateNormals ());
+
+  PointCloud<PointXYZRGBNormal> cloudRGBNormal;
+  cloudRGBNormal.points.resize (2);
+  cloudRGBNormal.points[0].x = cloudRGBNormal.points[0].y = cloudRGBNormal.points[0].z = 0.1f;
+  cloudRGBNormal.points[1].x = cloudRGBNormal.points[1].y = cloudRGBNormal.points[1].z = 0.3f;
+  cloudRGBNormal.points[0].r = 10; cloudRGBNormal.points[0].g = 20; cloudRGBNormal.points[0].b = 30;
+  cloudRGBNormal.points[1].r = 30; cloudRGBNormal.points[1].g = 40; cloudRGBNormal.points[1].b = 50;
+  cloudRGBNormal.points[0].normal_x = 1.0f; cloudRGBNormal.points[0].normal_y = 0.0f; cloudRGBNormal.points[0].normal_z = 0.0f;
+  cloudRGBNormal.points[1].normal_x = 0.0f; cloudRGBNormal.points[1].normal_y = 1.0f; cloudRGBNormal.points[1].normal_z = 0.0f;
+  octreeRGBNormal.addPoints (cloudRGBNormal);
+
+  PointCloud<PointXYZRGBNormal> centroidsRGBNormal;
+  ASSERT_EQ (octreeRGBNormal.getVoxelCentroids (centroidsRGBNormal), 1u);
+  const PointXYZRGBNormal& centroidRGBNormal = centroidsRGBNormal.points[0];
+  EXPECT_NEAR (centroidRGBNormal.x, 0.2f, 1e-6);
+  EXPECT_EQ (centroidRGBNormal.r, 20);
+  EXPECT_EQ (centroidRGBNormal.g, 30);
+  EXPECT_EQ (centroidRGBNormal.b, 40);
+  EXPECT_NEAR (centroidRGBNormal.normal_x, sqrt (0.5), 1e-6);
+  EXPECT_NEAR (centroidRGBNormal.normal_y, sqrt (0.5), 1e-6);
+  EXPECT_NEAR (centroidRGBNormal.normal_z, 0.0, 1e-6);
+}
+
 // helper class for priority queue
 class prioPointQueueEntry
 {
@@ -1571,6 +1884,107 @@ TEST (PCL, Octree_Pointcloud_Neighbours_Within_Radius_Search)
 
 }
 
+TEST (PCL, Octree_Pointcloud_Range_Leaf_Search)
+{
+  typedef OctreeLeafDataTRange<int> RangeLeaf;
+  typedef OctreePointCloudSearch<PointXYZ, RangeLeaf, OctreeRangeBase<int, RangeLeaf> > RangeOctree;
+
+  const unsigned int test_runs = 10;
+  unsigned int test_id;
+
+  // instantiate point clouds
+  PointCloud<PointXYZ>::Ptr cloudIn (new PointCloud<PointXYZ> ());
+
+  size_t i;
+
+  srand (static_cast<unsigned int> (time (NULL)));
+
+  for (i = 0; i < 1000; i++)
+  {
+    cloudIn->push_back (PointXYZ (static_cast<float> (10.0 * rand () / RAND_MAX),
+                                  static_cast<float> (10.0 * rand () / RAND_MAX),
+                                  static_cast<float> (5.0  * rand () / RAND_MAX)));
+  }
+
+  OctreePointCloudSearch<PointXYZ> octree (0.5);
+  RangeOctree octreeRange (0.5);
+
+  // build octrees
+  octree.setInputCloud (cloudIn);
+  octree.addPointsFromInputCloud ();
+
+  octreeRange.setInputCloud (cloudIn);
+  octreeRange.addPointsFromInputCloud ();
+
+  ASSERT_EQ (octreeRange.getLeafCount (), octree.getLeafCount ());
+
+  // point indices are stored in leaf ranges only
+  ASSERT_EQ (octreeRange.getOverflowChunkCount (), static_cast<std::size_t> (0));
+
+  for (int pass = 0; pass < 3; pass++)
+  {
+    if (pass == 1)
+    {
+      // points added after the initial build are stored in overflow chunks
+      for (i = 0; i < 200; i++)
+      {
+        PointXYZ newPoint (static_cast<float> (10.0 * rand () / RAND_MAX),
+                           static_cast<float> (10.0 * rand () / RAND_MAX),
+                           static_cast<float> (5.0  * rand () / RAND_MAX));
+        cloudIn->push_back (newPoint);
+        octree.addPointFromCloud (static_cast<int> (cloudIn->points.size ()) - 1, boost::shared_ptr<std::vector<int> > ());
+        octreeRange.addPointFromCloud (static_cast<int> (cloudIn->points.size ()) - 1, boost::shared_ptr<std::vector<int> > ());
+      }
+
+      ASSERT_GT (octreeRange.getOverflowChunkCount (), static_cast<std::size_t> (0));
+    }
+    else if (pass == 2)
+    {
+      octreeRange.compactLeafData ();
+      ASSERT_EQ (octreeRange.getOverflowChunkCount (), static_cast<std::size_t> (0));
+    }
+
+    for (test_id = 0; test_id < test_runs; test_id++)
+    {
+      PointXYZ searchPoint (static_cast<float> (10.0 * rand () / RAND_MAX),
+                            static_cast<float> (10.0 * rand () / RAND_MAX),
+                            static_cast<float> (5.0  * rand () / RAND_MAX));
+
+      // voxel search returns point indices in insertion order
+      vector<int> voxelIndices;
+      vector<int> voxelIndicesRange;
+      octree.voxelSearch (searchPoint, voxelIndices);
+      octreeRange.voxelSearch (searchPoint, voxelIndicesRange);
+      ASSERT_EQ (voxelIndicesRange, voxelIndices);
+
+      double searchRadius = 2.0 * rand () / RAND_MAX;
+
+      vector<int> radiusIndices;
+      vector<int> radiusIndicesRange;
+      vector<float> radiusDistances;
+      octree.radiusSearch (searchPoint, searchRadius, radiusIndices, radiusDistances);
+      octreeRange.radiusSearch (searchPoint, searchRadius, radiusIndicesRange, radiusDistances);
+
+      std::sort (radiusIndices.begin (), radiusIndices.end ());
+      std::sort (radiusIndicesRange.begin (), radiusIndicesRange.end ());
+      ASSERT_EQ (radiusIndicesRange, radiusIndices);
+
+      vector<int> knnIndices;
+      vector<int> knnIndicesRange;
+      vector<float> knnDistances;
+      vector<float> knnDistancesRange;
+      octree.nearestKSearch (searchPoint, 10, knnIndices, knnDistances);
+      octreeRange.nearestKSearch (searchPoint, 10, knnIndicesRange, knnDistancesRange);
+      ASSERT_EQ (knnDistancesRange, knnDistances);
+    }
+  }
+
+  // deleting the tree releases the point index storage
+  octreeRange.deleteTree ();
+  ASSERT_EQ (octreeRange.getLeafCount (), static_cast<std::size_t> (0));
+  ASSERT_EQ (octreeRange.getOverflowChunkCount (), static_cast<std::size_t> (0));
+}
+
 TEST (PCL, Octree_Pointcloud_Ray_Traversal)
 {
 
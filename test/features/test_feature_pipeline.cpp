@@ -0,0 +1,290 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <pcl/point_cloud.h>
+#include <pcl/features/feature_pipeline.h>
+#include <pcl/features/normal_3d_omp.h>
+#include <pcl/features/fpfh_omp.h>
+#include <pcl/features/shot_omp.h>
+#include <pcl/features/principal_curvatures.h>
+#include <pcl/io/pcd_io.h>
+
+using namespace pcl;
+using namespace pcl::io;
+using namespace std;
+
+typedef search::KdTree<PointXYZ>::Ptr KdTreePtr;
+
+PointCloud<PointXYZ> cloud;
+vector<int> indices;
+KdTreePtr tree;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, NeighborhoodCache)
+{
+  NeighborhoodCache<PointXYZ> cache (tree);
+  PointCloud<PointXYZ>::ConstPtr input = cloud.makeShared ();
+  tree->setInputCloud (input);
+  cache.compute (input, indices, 0.03, 4);
+  EXPECT_EQ (cache.getRadius (), 0.03);
+  EXPECT_EQ (cache.getInputCloud (), input);
+
+  // Smaller radii get the subset of the stored neighbors, the same as a new search
+  vector<int> nn_indices, cached_indices;
+  vector<float> nn_dists, cached_dists;
+  for (size_t i = 0; i < indices.size (); i += 7)
+  {
+    for (double radius = 0.01; radius <= 0.03; radius += 0.01)
+    {
+      int nr_neighbors = tree->radiusSearch (*input, indices[i], radius, nn_indices, nn_dists);
+      EXPECT_EQ (cache.radiusSearch (*input, indices[i], radius, cached_indices, cached_dists), nr_neighbors);
+      sort (nn_indices.begin (), nn_indices.end ());
+      sort (cached_indices.begin (), cached_indices.end ());
+      EXPECT_TRUE (nn_indices == cached_indices);
+    }
+
+    // Larger radii and other clouds are searched again
+    int nr_neighbors = tree->radiusSearch (*input, indices[i], 0.04, nn_indices, nn_dists);
+    EXPECT_EQ (cache.radiusSearch (*input, indices[i], 0.04, cached_indices, cached_dists), nr_neighbors);
+    PointCloud<PointXYZ> copy (*input);
+    EXPECT_EQ (cache.radiusSearch (copy, indices[i], 0.04, cached_indices, cached_dists), nr_neighbors);
+
+    EXPECT_EQ (cache.radiusSearch (*input, indices[i], 0.03, cached_indices, cached_dists, 5), min (5, int (cached_indices.size ())));
+    EXPECT_LE (cached_indices.size (), 5);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, NeighborhoodCacheGraph)
+{
+  // A k nearest neighbor graph as saved by StatisticalOutlierRemoval
+  PointCloud<PointXYZ>::ConstPtr input = cloud.makeShared ();
+  tree->setInputCloud (input);
+  vector<vector<int> > neighbors (indices.size ());
+  vector<vector<float> > sqr_distances (indices.size ());
+  for (size_t i = 0; i < indices.size (); ++i)
+    tree->nearestKSearch (*input, indices[i], 12, neighbors[i], sqr_distances[i]);
+
+  NeighborhoodCache<PointXYZ>::Ptr cache (new NeighborhoodCache<PointXYZ> (tree));
+  cache->setNeighborhoods (input, indices, neighbors, sqr_distances);
+  EXPECT_EQ (cache->getInputCloud (), input);
+
+  // Shorter lists are prefixes of the stored ones, longer ones are searched again
+  vector<int> nn_indices;
+  vector<float> nn_dists;
+  EXPECT_EQ (cache->nearestKSearch (*input, indices[5], 8, nn_indices, nn_dists), 8);
+  EXPECT_TRUE (nn_indices == vector<int> (neighbors[5].begin (), neighbors[5].begin () + 8));
+  EXPECT_EQ (cache->nearestKSearch (*input, indices[5], 20, nn_indices, nn_dists), 20);
+
+  // Normal estimation on the graph gives the same normals as with its own searches
+  boost::shared_ptr<vector<int> > indicesptr (new vector<int> (indices));
+  PointCloud<Normal> normals, cached_normals;
+  NormalEstimationOMP<PointXYZ, Normal> ne (4);
+  ne.setInputCloud (input);
+  ne.setIndices (indicesptr);
+  ne.setKSearch (10);
+  ne.setSearchMethod (tree);
+  ne.compute (normals);
+  ne.setSearchMethod (cache);
+  ne.compute (cached_normals);
+
+  ASSERT_EQ (cached_normals.points.size (), normals.points.size ());
+  for (size_t i = 0; i < normals.points.size (); ++i)
+  {
+    for (int d = 0; d < 3; ++d)
+      EXPECT_EQ (cached_normals.points[i].normal[d], normals.points[i].normal[d]);
+    EXPECT_EQ (cached_normals.points[i].curvature, normals.points[i].curvature);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, FeatureStage)
+{
+  typedef NormalEstimationOMP<PointXYZ, Normal> NormalEstimation;
+  PointCloud<PointXYZ>::ConstPtr input = cloud.makeShared ();
+  boost::shared_ptr<vector<int> > indicesptr (new vector<int> (indices));
+
+  boost::shared_ptr<NormalEstimation> ne (new NormalEstimation (2));
+  ne->setRadiusSearch (0.02);
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal>);
+  FeatureStageImpl<PointXYZ, Normal> stage (ne, normals);
+  EXPECT_EQ (stage.getRadiusSearch (), 0.02);
+  stage.compute (input, indicesptr, PointCloud<PointXYZ>::ConstPtr (), tree);
+  EXPECT_EQ (normals->points.size (), indices.size ());
+  EXPECT_EQ (ne->getSearchMethod (), KdTreePtr ());
+
+  // The copy has its own estimator and output cloud, and computes the same features
+  FeatureStage<PointXYZ>::Ptr copy = stage.clone ();
+  ne->setRadiusSearch (0.03);
+  EXPECT_EQ (copy->getRadiusSearch (), 0.02);
+  copy->compute (input, indicesptr, PointCloud<PointXYZ>::ConstPtr (), tree);
+  const PointCloud<Normal> &copy_normals = *boost::static_pointer_cast<FeatureStageImpl<PointXYZ, Normal> > (copy)->getOutput ();
+  EXPECT_NE (&copy_normals, normals.get ());
+  ASSERT_EQ (copy_normals.points.size (), normals->points.size ());
+  for (size_t i = 0; i < normals->points.size (); ++i)
+    for (int d = 0; d < 3; ++d)
+      EXPECT_EQ (copy_normals.points[i].normal[d], normals->points[i].normal[d]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, FeaturePipeline)
+{
+  typedef NormalEstimationOMP<PointXYZ, Normal> NormalEstimation;
+  typedef FPFHEstimationOMP<PointXYZ, Normal, FPFHSignature33> FPFHEstimation;
+  typedef SHOTEstimationOMP<PointXYZ, Normal, SHOT> SHOTEstimation;
+  typedef PrincipalCurvaturesEstimation<PointXYZ, Normal, PrincipalCurvatures> CurvaturesEstimation;
+
+  PointCloud<PointXYZ>::ConstPtr input = cloud.makeShared ();
+  boost::shared_ptr<vector<int> > indicesptr (new vector<int> (indices));
+
+  // Each estimator on its own
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal>);
+  NormalEstimation ne (4);
+  ne.setInputCloud (input);
+  ne.setIndices (indicesptr);
+  ne.setSearchMethod (tree);
+  ne.setRadiusSearch (0.02);
+  ne.compute (*normals);
+
+  PointCloud<FPFHSignature33> fpfhs;
+  FPFHEstimation fpfh (4);
+  fpfh.setInputCloud (input);
+  fpfh.setInputNormals (normals);
+  fpfh.setIndices (indicesptr);
+  fpfh.setSearchMethod (tree);
+  fpfh.setRadiusSearch (0.025);
+  fpfh.compute (fpfhs);
+
+  PointCloud<SHOT> shots;
+  SHOTEstimation shot (4);
+  shot.setInputCloud (input);
+  shot.setInputNormals (normals);
+  shot.setIndices (indicesptr);
+  shot.setSearchMethod (tree);
+  shot.setRadiusSearch (0.03);
+  shot.compute (shots);
+
+  PointCloud<PrincipalCurvatures> curvatures;
+  CurvaturesEstimation pc;
+  pc.setInputCloud (input);
+  pc.setInputNormals (normals);
+  pc.setIndices (indicesptr);
+  pc.setSearchMethod (tree);
+  pc.setKSearch (10);
+  pc.compute (curvatures);
+
+  // All estimators with one neighborhood search per point
+  PointCloud<Normal>::Ptr pipeline_normals (new PointCloud<Normal>);
+  PointCloud<FPFHSignature33>::Ptr pipeline_fpfhs (new PointCloud<FPFHSignature33>);
+  PointCloud<SHOT>::Ptr pipeline_shots (new PointCloud<SHOT>);
+  PointCloud<PrincipalCurvatures>::Ptr pipeline_curvatures (new PointCloud<PrincipalCurvatures>);
+
+  boost::shared_ptr<NormalEstimation> pipeline_ne (new NormalEstimation (4));
+  pipeline_ne->setRadiusSearch (0.02);
+  boost::shared_ptr<FPFHEstimation> pipeline_fpfh (new FPFHEstimation (4));
+  pipeline_fpfh->setInputNormals (pipeline_normals);
+  pipeline_fpfh->setRadiusSearch (0.025);
+  boost::shared_ptr<SHOTEstimation> pipeline_shot (new SHOTEstimation (4));
+  pipeline_shot->setInputNormals (pipeline_normals);
+  pipeline_shot->setRadiusSearch (0.03);
+  boost::shared_ptr<CurvaturesEstimation> pipeline_pc (new CurvaturesEstimation);
+  pipeline_pc->setInputNormals (pipeline_normals);
+  pipeline_pc->setKSearch (10);
+
+  FeaturePipeline<PointXYZ> pipeline;
+  pipeline.setInputCloud (input);
+  pipeline.setIndices (indicesptr);
+  pipeline.setSearchMethod (tree);
+  pipeline.setNumberOfThreads (4);
+  pipeline.addFeature (pipeline_ne, pipeline_normals);
+  pipeline.addFeature (pipeline_fpfh, pipeline_fpfhs);
+  pipeline.addFeature (pipeline_shot, pipeline_shots);
+  pipeline.addFeature (pipeline_pc, pipeline_curvatures);
+  EXPECT_EQ (pipeline.getNumberOfFeatures (), 4);
+  pipeline.compute ();
+
+  // The estimators get their own search method back
+  EXPECT_EQ (pipeline_ne->getSearchMethod (), KdTreePtr ());
+
+  ASSERT_EQ (pipeline_normals->points.size (), normals->points.size ());
+  ASSERT_EQ (pipeline_fpfhs->points.size (), fpfhs.points.size ());
+  ASSERT_EQ (pipeline_shots->points.size (), shots.points.size ());
+  ASSERT_EQ (pipeline_curvatures->points.size (), curvatures.points.size ());
+  for (size_t i = 0; i < normals->points.size (); ++i)
+  {
+    for (int d = 0; d < 3; ++d)
+      EXPECT_NEAR (pipeline_normals->points[i].normal[d], normals->points[i].normal[d], 1e-4);
+    EXPECT_NEAR (pipeline_normals->points[i].curvature, normals->points[i].curvature, 1e-4);
+    for (int d = 0; d < 33; ++d)
+      EXPECT_NEAR (pipeline_fpfhs->points[i].histogram[d], fpfhs.points[i].histogram[d], 1e-2);
+    for (size_t d = 0; d < shots.points[i].descriptor.size (); ++d)
+      EXPECT_NEAR (pipeline_shots->points[i].descriptor[d], shots.points[i].descriptor[d], 1e-4);
+    EXPECT_NEAR (pipeline_curvatures->points[i].pc1, curvatures.points[i].pc1, 1e-4);
+    EXPECT_NEAR (pipeline_curvatures->points[i].pc2, curvatures.points[i].pc2, 1e-4);
+  }
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cerr << "No test file given. Please download `bun0.pcd` and pass its path to the test." << std::endl;
+    return (-1);
+  }
+
+  if (loadPCDFile<PointXYZ> (argv[1], cloud) < 0)
+  {
+    std::cerr << "Failed to read test file. Please download `bun0.pcd` and pass its path to the test." << std::endl;
+    return (-1);
+  }
+
+  indices.resize (cloud.points.size ());
+  for (size_t i = 0; i < indices.size (); ++i)
+    indices[i] = static_cast<int> (i);
+
+  tree.reset (new search::KdTree<PointXYZ> (false));
+  tree->setInputCloud (cloud.makeShared ());
+
+  testing::InitGoogleTest (&argc, argv);
+  return (RUN_ALL_TESTS ());
+}
+/* ]--- */
@@ -0,0 +1,313 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <pcl/point_cloud.h>
+#include <pcl/features/global_feature_batch.h>
+#include <pcl/features/normal_3d.h>
+#include <pcl/features/vfh.h>
+#include <pcl/features/cvfh.h>
+#include <pcl/features/esf.h>
+#include <pcl/features/crh.h>
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/io/pcd_io.h>
+
+using namespace pcl;
+using namespace pcl::io;
+using namespace std;
+
+typedef VFHEstimation<PointXYZ, Normal, VFHSignature308> VFHEstimator;
+typedef CVFHEstimation<PointXYZ, Normal, VFHSignature308> CVFHEstimator;
+typedef ESFEstimation<PointXYZ, ESFSignature640> ESFEstimator;
+typedef CRHEstimation<PointXYZ, Normal, Histogram<90> > CRHEstimator;
+
+PointCloud<PointXYZ>::Ptr cloud (new PointCloud<PointXYZ>);
+PointCloud<Normal>::Ptr normals (new PointCloud<Normal>);
+PointCloud<PointXYZ>::Ptr cloud_milk (new PointCloud<PointXYZ>);
+PointCloud<Normal>::Ptr normals_milk (new PointCloud<Normal>);
+vector<PointIndices> clusters;
+
+/** \brief Expect two histograms of N bins to be equal. */
+template <typename PointT, int N> void
+expectEqualHistograms (const PointT &a, const PointT &b)
+{
+  for (int d = 0; d < N; ++d)
+    EXPECT_EQ (a.histogram[d], b.histogram[d]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, GlobalFeatureBatchVFH)
+{
+  boost::shared_ptr<VFHEstimator> vfh (new VFHEstimator);
+  vfh->setNormalizeBins (true);
+  vfh->setNormalizeDistance (true);
+
+  GlobalFeatureBatch<PointXYZ, VFHSignature308> batch;
+  batch.setFeatureEstimator (vfh);
+  batch.setInputCloud (cloud);
+  batch.setInputNormals (normals);
+  batch.setClusters (clusters);
+  EXPECT_EQ (batch.getNumberOfClusters (), clusters.size ());
+
+  for (unsigned int threads = 1; threads <= 4; threads += 3)
+  {
+    batch.setNumberOfThreads (threads);
+    PointCloud<VFHSignature308>::CloudVectorType output;
+    batch.compute (output);
+    ASSERT_EQ (output.size (), clusters.size ());
+    ASSERT_EQ (batch.getCentroids ().size (), clusters.size ());
+
+    // Every cluster is described as if it was given alone
+    for (size_t i = 0; i < clusters.size (); ++i)
+    {
+      PointCloud<PointXYZ>::Ptr cluster (new PointCloud<PointXYZ>);
+      PointCloud<Normal>::Ptr cluster_normals (new PointCloud<Normal>);
+      copyPointCloud (*cloud, clusters[i].indices, *cluster);
+      copyPointCloud (*normals, clusters[i].indices, *cluster_normals);
+
+      VFHEstimator single;
+      single.setNormalizeBins (true);
+      single.setNormalizeDistance (true);
+      single.setInputCloud (cluster);
+      single.setInputNormals (cluster_normals);
+      PointCloud<VFHSignature308> expected;
+      single.compute (expected);
+
+      ASSERT_EQ (output[i].points.size (), 1);
+      expectEqualHistograms<VFHSignature308, 308> (output[i].points[0], expected.points[0]);
+
+      Eigen::Vector4f centroid;
+      compute3DCentroid (*cluster, centroid);
+      ASSERT_EQ (batch.getCentroids ()[i].size (), 1);
+      EXPECT_NEAR (batch.getCentroids ()[i][0][0], centroid[0], 1e-6);
+      EXPECT_NEAR (batch.getCentroids ()[i][0][1], centroid[1], 1e-6);
+      EXPECT_NEAR (batch.getCentroids ()[i][0][2], centroid[2], 1e-6);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, GlobalFeatureBatchCVFH)
+{
+  boost::shared_ptr<CVFHEstimator> cvfh (new CVFHEstimator);
+  cvfh->setClusterTolerance (0.015f);
+  cvfh->setEPSAngleThreshold (0.13f);
+  cvfh->setCurvatureThreshold (0.025f);
+  cvfh->setRadiusNormals (0.02f);
+
+  CVFHEstimator single (*cvfh);
+  single.setInputCloud (cloud_milk);
+  single.setInputNormals (normals_milk);
+  PointCloud<VFHSignature308> expected;
+  single.compute (expected);
+  vector<Eigen::Vector3f> expected_centroids;
+  single.getCentroidClusters (expected_centroids);
+  EXPECT_EQ (expected.points.size (), 2);
+
+  // The same view twice, and the bunny
+  vector<PointCloud<PointXYZ>::ConstPtr> clouds;
+  vector<PointCloud<Normal>::ConstPtr> clouds_normals;
+  clouds.push_back (cloud_milk); clouds_normals.push_back (normals_milk);
+  clouds.push_back (cloud); clouds_normals.push_back (normals);
+  clouds.push_back (cloud_milk); clouds_normals.push_back (normals_milk);
+
+  GlobalFeatureBatch<PointXYZ, VFHSignature308> batch;
+  batch.setFeatureEstimator (cvfh);
+  batch.setInputClouds (clouds);
+  batch.setInputNormals (clouds_normals);
+  batch.setNumberOfThreads (3);
+  PointCloud<VFHSignature308>::CloudVectorType output;
+  batch.compute (output);
+  ASSERT_EQ (output.size (), 3);
+
+  for (size_t v = 0; v < 3; v += 2)
+  {
+    ASSERT_EQ (output[v].points.size (), expected.points.size ());
+    ASSERT_EQ (batch.getCentroids ()[v].size (), expected_centroids.size ());
+    for (size_t i = 0; i < expected.points.size (); ++i)
+    {
+      expectEqualHistograms<VFHSignature308, 308> (output[v].points[i], expected.points[i]);
+      EXPECT_EQ (batch.getCentroids ()[v][i], expected_centroids[i]);
+    }
+  }
+  EXPECT_EQ (batch.getCentroids ()[1].size (), output[1].points.size ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, ESFEstimationThreads)
+{
+  ESFEstimator esf;
+  esf.setInputCloud (cloud);
+  esf.setRandomSeed (7);
+  PointCloud<ESFSignature640> serial, threaded, again, other_seed;
+  esf.compute (serial);
+  ASSERT_EQ (serial.points.size (), 1);
+
+  // The samples do not depend on the thread which draws them
+  esf.setNumberOfThreads (4);
+  esf.compute (threaded);
+  expectEqualHistograms<ESFSignature640, 640> (serial.points[0], threaded.points[0]);
+  esf.compute (again);
+  expectEqualHistograms<ESFSignature640, 640> (serial.points[0], again.points[0]);
+
+  float sum = 0;
+  for (int d = 0; d < 640; ++d)
+    sum += serial.points[0].histogram[d];
+  EXPECT_NEAR (sum, 1.0f, 1e-4);
+
+  esf.setRandomSeed (8);
+  esf.compute (other_seed);
+  bool differ = false;
+  for (int d = 0; d < 640; ++d)
+    differ |= (other_seed.points[0].histogram[d] != serial.points[0].histogram[d]);
+  EXPECT_TRUE (differ);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, GlobalFeatureBatchESF)
+{
+  boost::shared_ptr<ESFEstimator> esf (new ESFEstimator);
+  GlobalFeatureBatch<PointXYZ, ESFSignature640> batch;
+  batch.setFeatureEstimator (esf);
+  batch.setInputCloud (cloud);
+  batch.setClusters (clusters);
+  batch.setNumberOfThreads (4);
+  PointCloud<ESFSignature640>::CloudVectorType output;
+  batch.compute (output);
+  ASSERT_EQ (output.size (), clusters.size ());
+
+  for (size_t i = 0; i < clusters.size (); ++i)
+  {
+    PointCloud<PointXYZ>::Ptr cluster (new PointCloud<PointXYZ>);
+    copyPointCloud (*cloud, clusters[i].indices, *cluster);
+    ESFEstimator single;
+    single.setInputCloud (cluster);
+    PointCloud<ESFSignature640> expected;
+    single.compute (expected);
+    ASSERT_EQ (output[i].points.size (), 1);
+    expectEqualHistograms<ESFSignature640, 640> (output[i].points[0], expected.points[0]);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, GlobalFeatureBatchCRH)
+{
+  boost::shared_ptr<CRHEstimator> crh (new CRHEstimator);
+  GlobalFeatureBatch<PointXYZ, Histogram<90> > batch;
+  batch.setFeatureEstimator (crh);
+  batch.setInputCloud (cloud);
+  batch.setInputNormals (normals);
+  batch.setClusters (clusters);
+  batch.setNumberOfThreads (2);
+  PointCloud<Histogram<90> >::CloudVectorType output;
+  batch.compute (output);
+  ASSERT_EQ (output.size (), clusters.size ());
+
+  // Without a given centroid, CRH turns around the centroid of the cluster
+  for (size_t i = 0; i < clusters.size (); ++i)
+  {
+    PointCloud<PointXYZ>::Ptr cluster (new PointCloud<PointXYZ>);
+    PointCloud<Normal>::Ptr cluster_normals (new PointCloud<Normal>);
+    copyPointCloud (*cloud, clusters[i].indices, *cluster);
+    copyPointCloud (*normals, clusters[i].indices, *cluster_normals);
+    Eigen::Vector4f centroid;
+    compute3DCentroid (*cluster, centroid);
+
+    CRHEstimator single;
+    single.setInputCloud (cluster);
+    single.setInputNormals (cluster_normals);
+    single.setCentroid (centroid);
+    PointCloud<Histogram<90> > expected;
+    single.compute (expected);
+    ASSERT_EQ (output[i].points.size (), 1);
+    expectEqualHistograms<Histogram<90>, 90> (output[i].points[0], expected.points[0]);
+  }
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  if (argc < 3)
+  {
+    std::cerr << "No test file given. Please download `bun0.pcd` and `milk.pcd` pass its path to the test." << std::endl;
+    return (-1);
+  }
+
+  if (loadPCDFile<PointXYZ> (argv[1], *cloud) < 0)
+  {
+    std::cerr << "Failed to read test file. Please download `bun0.pcd` and pass its path to the test." << std::endl;
+    return (-1);
+  }
+
+  PointCloud<PointXYZ>::Ptr milk_loaded (new PointCloud<PointXYZ>);
+  if (loadPCDFile<PointXYZ> (argv[2], *milk_loaded) < 0)
+  {
+    std::cerr << "Failed to read test file. Please download `milk.pcd` and pass its path to the test." << std::endl;
+    return (-1);
+  }
+
+  NormalEstimation<PointXYZ, Normal> ne;
+  ne.setInputCloud (cloud);
+  ne.setKSearch (10);
+  ne.compute (*normals);
+
+  VoxelGrid<PointXYZ> grid;
+  grid.setInputCloud (milk_loaded);
+  grid.setLeafSize (0.005f, 0.005f, 0.005f);
+  grid.filter (*cloud_milk);
+  ne.setInputCloud (cloud_milk);
+  ne.setKSearch (0);
+  ne.setRadiusSearch (0.02);
+  ne.compute (*normals_milk);
+
+  // Four slices of the bunny along x
+  Eigen::Vector4f min_pt, max_pt;
+  getMinMax3D (*cloud, min_pt, max_pt);
+  clusters.resize (4);
+  for (size_t i = 0; i < cloud->points.size (); ++i)
+  {
+    int slice = static_cast<int> ((cloud->points[i].x - min_pt[0]) / (max_pt[0] - min_pt[0]) * 4.0f);
+    clusters[std::min (slice, 3)].indices.push_back (static_cast<int> (i));
+  }
+
+  testing::InitGoogleTest (&argc, argv);
+  return (RUN_ALL_TESTS ());
+}
+/* ]--- */
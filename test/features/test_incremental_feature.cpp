@@ -0,0 +1,190 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <pcl/point_cloud.h>
+#include <pcl/features/incremental_feature.h>
+#include <pcl/features/normal_3d.h>
+#include <pcl/features/fpfh_omp.h>
+#include <pcl/io/pcd_io.h>
+
+using namespace pcl;
+using namespace pcl::io;
+using namespace std;
+
+typedef NormalEstimation<PointXYZ, Normal> NormalEstimator;
+typedef FPFHEstimationOMP<PointXYZ, Normal, FPFHSignature33> FPFHEstimator;
+
+PointCloud<PointXYZ>::Ptr cloud (new PointCloud<PointXYZ>);
+
+/** \brief Estimate the normals and FPFH features of all points of a cloud. */
+void
+computeFeatures (const PointCloud<PointXYZ>::ConstPtr &input, PointCloud<Normal>::Ptr &normals,
+                 PointCloud<FPFHSignature33>::Ptr &fpfhs)
+{
+  normals.reset (new PointCloud<Normal>);
+  fpfhs.reset (new PointCloud<FPFHSignature33>);
+  NormalEstimator ne;
+  ne.setInputCloud (input);
+  ne.setRadiusSearch (0.01);
+  ne.compute (*normals);
+
+  FPFHEstimator fpfh (2);
+  fpfh.setInputCloud (input);
+  fpfh.setInputNormals (normals);
+  fpfh.setRadiusSearch (0.015);
+  fpfh.compute (*fpfhs);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, IncrementalFeatureEstimation)
+{
+  PointCloud<Normal>::Ptr previous_normals, normals;
+  PointCloud<FPFHSignature33>::Ptr previous_fpfhs, fpfhs;
+  computeFeatures (cloud, previous_normals, previous_fpfhs);
+
+  // Remove ten points, move one point and add two points
+  PointCloud<PointXYZ>::Ptr changed (new PointCloud<PointXYZ>);
+  vector<int> previous_indices;
+  for (int i = 0; i < static_cast<int> (cloud->points.size ()); ++i)
+  {
+    if (i >= 10 && i < 20)
+      continue;
+    changed->points.push_back (cloud->points[i]);
+    previous_indices.push_back (i);
+  }
+  changed->points[100].x += 0.002f;
+  for (int i = 0; i < 2; ++i)
+  {
+    PointXYZ point = cloud->points[200 + i];
+    point.y += 0.001f;
+    changed->points.push_back (point);
+    previous_indices.push_back (-1);
+  }
+  changed->width = static_cast<uint32_t> (changed->points.size ());
+  changed->height = 1;
+  computeFeatures (changed, normals, fpfhs);
+
+  // The normals of the affected points
+  boost::shared_ptr<NormalEstimator> ne (new NormalEstimator);
+  ne->setRadiusSearch (0.01);
+  PointCloud<Normal>::Ptr incremental_normals (new PointCloud<Normal>);
+  IncrementalFeatureEstimation<PointXYZ, Normal> normal_update;
+  normal_update.setFeatureEstimator (ne);
+  normal_update.setInputCloud (changed);
+  normal_update.setPreviousCloud (cloud);
+  normal_update.setPreviousFeatures (previous_normals);
+  normal_update.setPreviousIndices (previous_indices);
+  normal_update.setNumberOfThreads (2);
+  normal_update.compute (*incremental_normals);
+
+  ASSERT_EQ (incremental_normals->points.size (), changed->points.size ());
+  EXPECT_EQ (incremental_normals->width, changed->width);
+  EXPECT_EQ (incremental_normals->height, changed->height);
+  const vector<int> &updated_normals = normal_update.getUpdatedIndices ();
+  EXPECT_GT (updated_normals.size (), 3);
+  EXPECT_LT (updated_normals.size (), changed->points.size () / 2);
+  EXPECT_TRUE (binary_search (updated_normals.begin (), updated_normals.end (), 100));
+  for (size_t i = 0; i < changed->points.size (); ++i)
+  {
+    for (int d = 0; d < 3; ++d)
+      EXPECT_FLOAT_EQ (incremental_normals->points[i].normal[d], normals->points[i].normal[d]);
+    EXPECT_FLOAT_EQ (incremental_normals->points[i].curvature, normals->points[i].curvature);
+  }
+
+  // The FPFH features of the affected points and of the points with new normals, through their SPFH
+  boost::shared_ptr<FPFHEstimator> fpfh (new FPFHEstimator (2));
+  fpfh->setInputNormals (incremental_normals);
+  fpfh->setRadiusSearch (0.015);
+  PointCloud<FPFHSignature33> incremental_fpfhs;
+  IncrementalFeatureEstimation<PointXYZ, FPFHSignature33> fpfh_update;
+  fpfh_update.setFeatureEstimator (fpfh);
+  fpfh_update.setInputCloud (changed);
+  fpfh_update.setPreviousCloud (cloud);
+  fpfh_update.setPreviousFeatures (previous_fpfhs);
+  fpfh_update.setPreviousIndices (previous_indices);
+  fpfh_update.setChangedIndices (updated_normals);
+  fpfh_update.compute (incremental_fpfhs);
+
+  ASSERT_EQ (incremental_fpfhs.points.size (), changed->points.size ());
+  EXPECT_GT (fpfh_update.getUpdatedIndices ().size (), updated_normals.size ());
+  EXPECT_LT (fpfh_update.getUpdatedIndices ().size (), changed->points.size ());
+  for (size_t i = 0; i < changed->points.size (); ++i)
+    for (int d = 0; d < 33; ++d)
+      EXPECT_FLOAT_EQ (incremental_fpfhs.points[i].histogram[d], fpfhs->points[i].histogram[d]);
+
+  // Nothing changed, nothing is recomputed
+  PointCloud<Normal> same_normals;
+  normal_update.setInputCloud (cloud);
+  normal_update.setPreviousIndices (vector<int> ());
+  normal_update.compute (same_normals);
+  EXPECT_EQ (normal_update.getUpdatedIndices ().size (), 0);
+  ASSERT_EQ (same_normals.points.size (), cloud->points.size ());
+  for (size_t i = 0; i < cloud->points.size (); ++i)
+    EXPECT_EQ (same_normals.points[i].normal[2], previous_normals->points[i].normal[2]);
+
+  // The neighborhoods of a k nearest neighbor search are not bounded
+  ne->setRadiusSearch (0);
+  ne->setKSearch (10);
+  normal_update.setInputCloud (changed);
+  normal_update.setPreviousIndices (previous_indices);
+  normal_update.compute (same_normals);
+  EXPECT_EQ (normal_update.getUpdatedIndices ().size (), changed->points.size ());
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cerr << "No test file given. Please download `bun0.pcd` and pass its path to the test." << std::endl;
+    return (-1);
+  }
+
+  if (loadPCDFile<PointXYZ> (argv[1], *cloud) < 0)
+  {
+    std::cerr << "Failed to read test file. Please download `bun0.pcd` and pass its path to the test." << std::endl;
+    return (-1);
+  }
+
+  testing::InitGoogleTest (&argc, argv);
+  return (RUN_ALL_TESTS ());
+}
+/* ]--- */
@@ -0,0 +1,191 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <pcl/point_cloud.h>
+#include <pcl/range_image/range_image.h>
+#include <pcl/features/range_image_border_extractor.h>
+#include <pcl/features/narf.h>
+#include <pcl/features/narf_descriptor.h>
+#include <pcl/keypoints/narf_keypoint.h>
+#include <pcl/io/pcd_io.h>
+
+using namespace pcl;
+using namespace pcl::io;
+using namespace std;
+
+PointCloud<PointXYZ> cloud;
+PointCloud<PointXYZ> cloud_milk;
+
+/** \brief The borders, keypoints and descriptors of a range image. */
+struct NarfResults
+{
+  PointCloud<BorderDescription> border_descriptions;
+  PointCloud<int> keypoint_indices;
+  PointCloud<Narf36> descriptors;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+createRangeImage (const PointCloud<PointXYZ> &input, float angular_resolution, RangeImage &range_image)
+{
+  // The same range image as in pcl_narf_benchmark, seen from the sensor pose stored in the file
+  Eigen::Affine3f sensor_pose = Eigen::Affine3f (Eigen::Translation3f (input.sensor_origin_[0],
+                                                                       input.sensor_origin_[1],
+                                                                       input.sensor_origin_[2])) *
+                                Eigen::Affine3f (input.sensor_orientation_);
+  range_image.createFromPointCloud (input, deg2rad (angular_resolution), deg2rad (360.0f), deg2rad (180.0f),
+                                    sensor_pose, RangeImage::CAMERA_FRAME, 0.0f, 0.0f, 1);
+  range_image.setUnseenToMaxRange ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+computeNarf (const RangeImage &range_image, int threads, float support_size, NarfResults &results)
+{
+  Narf::max_no_of_threads = threads;
+
+  RangeImageBorderExtractor border_extractor (&range_image);
+  border_extractor.getParameters ().max_no_of_threads = threads;
+  border_extractor.compute (results.border_descriptions);
+
+  NarfKeypoint narf_keypoint (&border_extractor);
+  narf_keypoint.getParameters ().support_size = support_size;
+  narf_keypoint.getParameters ().max_no_of_threads = threads;
+  narf_keypoint.compute (results.keypoint_indices);
+
+  vector<int> keypoint_indices (results.keypoint_indices.points.begin (), results.keypoint_indices.points.end ());
+  NarfDescriptor narf_descriptor (&range_image, &keypoint_indices);
+  narf_descriptor.getParameters ().support_size = support_size;
+  narf_descriptor.getParameters ().rotation_invariant = true;
+  narf_descriptor.compute (results.descriptors);
+
+  Narf::max_no_of_threads = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+checkNarfResults (const NarfResults &threaded, const NarfResults &serial)
+{
+  ASSERT_EQ (threaded.border_descriptions.points.size (), serial.border_descriptions.points.size ());
+  for (size_t i = 0; i < serial.border_descriptions.points.size (); ++i)
+  {
+    EXPECT_EQ (threaded.border_descriptions.points[i].x, serial.border_descriptions.points[i].x);
+    EXPECT_EQ (threaded.border_descriptions.points[i].y, serial.border_descriptions.points[i].y);
+    EXPECT_EQ (threaded.border_descriptions.points[i].traits, serial.border_descriptions.points[i].traits);
+  }
+
+  ASSERT_EQ (threaded.keypoint_indices.points.size (), serial.keypoint_indices.points.size ());
+  for (size_t i = 0; i < serial.keypoint_indices.points.size (); ++i)
+    EXPECT_EQ (threaded.keypoint_indices.points[i], serial.keypoint_indices.points[i]);
+
+  ASSERT_EQ (threaded.descriptors.points.size (), serial.descriptors.points.size ());
+  for (size_t i = 0; i < serial.descriptors.points.size (); ++i)
+  {
+    const Narf36 &p = threaded.descriptors.points[i], &q = serial.descriptors.points[i];
+    EXPECT_EQ (p.x, q.x);
+    EXPECT_EQ (p.y, q.y);
+    EXPECT_EQ (p.z, q.z);
+    EXPECT_EQ (p.roll, q.roll);
+    EXPECT_EQ (p.pitch, q.pitch);
+    EXPECT_EQ (p.yaw, q.yaw);
+    for (int d = 0; d < 36; ++d)
+      EXPECT_EQ (p.descriptor[d], q.descriptor[d]);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+checkNarfThreads (const PointCloud<PointXYZ> &input, float angular_resolution, float support_size)
+{
+  RangeImage range_image;
+  createRangeImage (input, angular_resolution, range_image);
+
+  NarfResults serial;
+  computeNarf (range_image, 1, support_size, serial);
+  EXPECT_GT (serial.keypoint_indices.points.size (), 0);
+  EXPECT_GT (serial.descriptors.points.size (), 0);
+
+  // The threads give the same results, in the same order, every time
+  for (int run = 0; run < 3; ++run)
+  {
+    NarfResults threaded;
+    computeNarf (range_image, 4, support_size, threaded);
+    checkNarfResults (threaded, serial);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, NarfThreadsBunny)
+{
+  checkNarfThreads (cloud, 0.5f, 0.02f);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, NarfThreadsMilk)
+{
+  checkNarfThreads (cloud_milk, 0.2f, 0.05f);
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  if (argc < 3)
+  {
+    std::cerr << "No test file given. Please download `bun0.pcd` and `milk.pcd` pass its path to the test." << std::endl;
+    return (-1);
+  }
+
+  if (loadPCDFile<PointXYZ> (argv[1], cloud) < 0)
+  {
+    std::cerr << "Failed to read test file. Please download `bun0.pcd` and pass its path to the test." << std::endl;
+    return (-1);
+  }
+
+  if (loadPCDFile<PointXYZ> (argv[2], cloud_milk) < 0)
+  {
+    std::cerr << "Failed to read test file. Please download `milk.pcd` and pass its path to the test." << std::endl;
+    return (-1);
+  }
+
+  testing::InitGoogleTest (&argc, argv);
+  return (RUN_ALL_TESTS ());
+}
+/* ]--- */
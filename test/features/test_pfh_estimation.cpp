@@ -41,6 +41,9 @@
 #include <pcl/point_cloud.h>
 #include <pcl/features/normal_3d.h>
 #include <pcl/features/pfh.h>
+#include <pcl/features/pfh_omp.h>
+#include <pcl/features/pfhrgb.h>
+#include <pcl/features/pfhrgb_omp.h>
 #include <pcl/features/fpfh.h>
 #include <pcl/features/fpfh_omp.h>
 #include <pcl/features/vfh.h>
@@ -497,6 +500,162 @@ TEST (PCL, FPFHEstimationOpenMP)
 
   testIndicesAndSearchSurface<FPFHEstimationOMP<PointXYZ, Normal, FPFHSignature33>, PointXYZ, Normal, FPFHSignature33>
   (cloud.makeShared (), normals, test_indices, 33);
+
+  // Compare with the serial estimation, on all the points and on a subset of them with a search surface
+  for (int subset = 0; subset < 2; ++subset)
+  {
+    FPFHEstimation<PointXYZ, Normal, FPFHSignature33> fpfh_serial;
+    FPFHEstimationOMP<PointXYZ, Normal, FPFHSignature33> fpfh_omp (4);
+    PointCloud<FPFHSignature33> fpfhs_serial, fpfhs_omp;
+
+    fpfh_serial.setInputCloud (cloud.makeShared ());
+    fpfh_serial.setInputNormals (normals);
+    fpfh_serial.setSearchMethod (tree);
+    fpfh_serial.setKSearch (30);
+    fpfh_omp.setInputCloud (cloud.makeShared ());
+    fpfh_omp.setInputNormals (normals);
+    fpfh_omp.setSearchMethod (tree);
+    fpfh_omp.setKSearch (30);
+    if (subset)
+    {
+      fpfh_serial.setIndices (test_indices);
+      fpfh_serial.setSearchSurface (cloud.makeShared ());
+      fpfh_omp.setIndices (test_indices);
+      fpfh_omp.setSearchSurface (cloud.makeShared ());
+    }
+    fpfh_serial.compute (fpfhs_serial);
+    fpfh_omp.compute (fpfhs_omp);
+
+    ASSERT_EQ (fpfhs_omp.points.size (), fpfhs_serial.points.size ());
+    for (size_t i = 0; i < fpfhs_serial.points.size (); ++i)
+      for (int d = 0; d < 33; ++d)
+        EXPECT_NEAR (fpfhs_omp.points[i].histogram[d], fpfhs_serial.points[i].histogram[d], 1e-4);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, PairFeatureCache)
+{
+  PairFeatureCache cache;
+  Eigen::Vector4f features (1.0f, 2.0f, 3.0f, 4.0f), cached_features;
+
+  // The capacity is rounded down to a power of two
+  cache.resize (100);
+  EXPECT_EQ (cache.capacity (), 64);
+  cache.insert (3, 7, features);
+  EXPECT_TRUE (cache.find (3, 7, cached_features));
+  EXPECT_EQ (cached_features, features);
+  EXPECT_FALSE (cache.find (7, 3, cached_features));
+
+  // Too small a capacity disables the cache
+  for (size_t capacity = 0; capacity < 4; ++capacity)
+  {
+    cache.resize (capacity);
+    EXPECT_EQ (cache.capacity (), 0);
+    cache.insert (3, 7, features);
+    EXPECT_FALSE (cache.find (3, 7, cached_features));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, PFHEstimationOpenMP)
+{
+  // Estimate normals first
+  NormalEstimation<PointXYZ, Normal> n;
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal> ());
+  n.setInputCloud (cloud.makeShared ());
+  n.setSearchMethod (tree);
+  n.setKSearch (10);
+  n.compute (*normals);
+
+  // Serial reference, with a cache small enough to replace pairs
+  PFHEstimation<PointXYZ, Normal, PFHSignature125> pfh;
+  pfh.setInputCloud (cloud.makeShared ());
+  pfh.setInputNormals (normals);
+  pfh.setSearchMethod (tree);
+  pfh.setKSearch (30);
+  pfh.setUseInternalCache (true);
+  pfh.setMaximumCacheSize (4096);
+  PointCloud<PFHSignature125> pfhs;
+  pfh.compute (pfhs);
+
+  PFHEstimationOMP<PointXYZ, Normal, PFHSignature125> pfh_omp (4); // instantiate 4 threads
+  pfh_omp.setInputCloud (cloud.makeShared ());
+  pfh_omp.setInputNormals (normals);
+  pfh_omp.setSearchMethod (tree);
+  pfh_omp.setKSearch (30);
+  for (int use_cache = 0; use_cache < 2; ++use_cache)
+  {
+    pfh_omp.setUseInternalCache (use_cache != 0);
+    pfh_omp.setMaximumCacheSize (4096);
+    PointCloud<PFHSignature125> pfhs_omp;
+    pfh_omp.compute (pfhs_omp);
+
+    ASSERT_EQ (pfhs_omp.points.size (), pfhs.points.size ());
+    EXPECT_EQ (pfhs_omp.is_dense, pfhs.is_dense);
+    for (size_t i = 0; i < pfhs.points.size (); ++i)
+      for (int d = 0; d < 125; ++d)
+        EXPECT_EQ (pfhs_omp.points[i].histogram[d], pfhs.points[i].histogram[d]);
+  }
+
+  // Test results when setIndices and/or setSearchSurface are used
+
+  boost::shared_ptr<vector<int> > test_indices (new vector<int> (0));
+  for (size_t i = 0; i < cloud.size (); i+=3)
+    test_indices->push_back (static_cast<int> (i));
+
+  testIndicesAndSearchSurface<PFHEstimationOMP<PointXYZ, Normal, PFHSignature125>, PointXYZ, Normal, PFHSignature125>
+  (cloud.makeShared (), normals, test_indices, 125);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, PFHRGBEstimationOpenMP)
+{
+  // Color the points by their position
+  PointCloud<PointXYZRGB>::Ptr cloud_rgb (new PointCloud<PointXYZRGB> ());
+  copyPointCloud (cloud, *cloud_rgb);
+  for (size_t i = 0; i < cloud_rgb->points.size (); ++i)
+  {
+    cloud_rgb->points[i].r = static_cast<uint8_t> (i % 256);
+    cloud_rgb->points[i].g = static_cast<uint8_t> ((i * 7) % 256);
+    cloud_rgb->points[i].b = static_cast<uint8_t> ((i * 13) % 256);
+  }
+
+  NormalEstimation<PointXYZRGB, Normal> n;
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal> ());
+  n.setInputCloud (cloud_rgb);
+  n.setSearchMethod (search::KdTree<PointXYZRGB>::Ptr (new search::KdTree<PointXYZRGB> (false)));
+  n.setKSearch (10);
+  n.compute (*normals);
+
+  PFHRGBEstimation<PointXYZRGB, Normal, PFHRGBSignature250> pfhrgb;
+  pfhrgb.setInputCloud (cloud_rgb);
+  pfhrgb.setInputNormals (normals);
+  pfhrgb.setSearchMethod (search::KdTree<PointXYZRGB>::Ptr (new search::KdTree<PointXYZRGB> (false)));
+  pfhrgb.setKSearch (20);
+  PointCloud<PFHRGBSignature250> pfhrgbs;
+  pfhrgb.compute (pfhrgbs);
+
+  PFHRGBEstimationOMP<PointXYZRGB, Normal, PFHRGBSignature250> pfhrgb_omp (4); // instantiate 4 threads
+  pfhrgb_omp.setInputCloud (cloud_rgb);
+  pfhrgb_omp.setInputNormals (normals);
+  pfhrgb_omp.setSearchMethod (search::KdTree<PointXYZRGB>::Ptr (new search::KdTree<PointXYZRGB> (false)));
+  pfhrgb_omp.setKSearch (20);
+  PointCloud<PFHRGBSignature250> pfhrgbs_omp;
+  pfhrgb_omp.compute (pfhrgbs_omp);
+
+  ASSERT_EQ (pfhrgbs_omp.points.size (), pfhrgbs.points.size ());
+  for (size_t i = 0; i < pfhrgbs.points.size (); ++i)
+  {
+    float sum = 0.0f;
+    for (int d = 0; d < 250; ++d)
+    {
+      EXPECT_EQ (pfhrgbs_omp.points[i].histogram[d], pfhrgbs.points[i].histogram[d]);
+      sum += pfhrgbs_omp.points[i].histogram[d];
+    }
+    // Every pair is counted once in the angular and once in the color half
+    EXPECT_NEAR (sum, 200.0f * 20.0f * 19.0f / (20.0f * 20.0f - 1.0f), 1e-2);
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
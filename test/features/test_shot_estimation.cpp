@@ -45,7 +45,9 @@
 #include <pcl/features/shot_omp.h>
 #include "pcl/features/shot_lrf.h"
 #include <pcl/features/3dsc.h>
+#include <pcl/features/3dsc_omp.h>
 #include <pcl/features/usc.h>
+#include <pcl/features/usc_omp.h>
 
 using namespace pcl;
 using namespace pcl::io;
@@ -637,6 +639,101 @@ TEST (PCL,SHOTShapeAndColorEstimationOpenMP)
   testSHOTLocalReferenceFrame<SHOTEstimationOMP<PointXYZRGBA, Normal, SHOT>, PointXYZRGBA, Normal, SHOT> (cloudWithColors.makeShared (), normals, test_indices);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, SHOTDefaultReferenceFramesReuse)
+{
+  double mr = 0.002;
+  // Estimate normals first
+  NormalEstimation<PointXYZ, Normal> n;
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal> ());
+  n.setInputCloud (cloud.makeShared ());
+  n.setSearchMethod (tree);
+  n.setRadiusSearch (20 * mr);
+  n.compute (*normals);
+
+  boost::shared_ptr<vector<int> > test_indices (new vector<int> (0));
+  for (size_t i = 0; i < cloud.size (); i+=3)
+    test_indices->push_back (static_cast<int> (i));
+
+  PointCloud<PointXYZ>::Ptr input = cloud.makeShared ();
+  SHOTEstimation<PointXYZ, Normal, SHOT> shot;
+  shot.setInputCloud (input);
+  shot.setInputNormals (normals);
+  shot.setIndices (test_indices);
+  shot.setSearchMethod (tree);
+  shot.setRadiusSearch (20 * mr);
+
+  // The frames estimated by default are kept as long as the data does not change
+  PointCloud<SHOT> shots, shots_again;
+  shot.compute (shots);
+  PointCloud<ReferenceFrame>::ConstPtr frames = shot.getInputReferenceFrames ();
+  ASSERT_TRUE (frames);
+  EXPECT_EQ (frames->points.size (), test_indices->size ());
+  shot.compute (shots_again);
+  EXPECT_EQ (shot.getInputReferenceFrames (), frames);
+  for (size_t i = 0; i < shots.points.size (); ++i)
+    for (size_t j = 0; j < shots.points[i].descriptor.size (); ++j)
+    {
+      if (pcl_isnan (shots.points[i].descriptor[j]))
+        EXPECT_TRUE (pcl_isnan (shots_again.points[i].descriptor[j]));
+      else
+        EXPECT_EQ (shots.points[i].descriptor[j], shots_again.points[i].descriptor[j]);
+    }
+
+  // Other indices, or a cloud modified in place, need new frames
+  boost::shared_ptr<vector<int> > other_indices (new vector<int> (test_indices->begin (), test_indices->begin () + test_indices->size () / 2));
+  shot.setIndices (other_indices);
+  shot.compute (shots_again);
+  EXPECT_NE (shot.getInputReferenceFrames (), frames);
+  EXPECT_EQ (shot.getInputReferenceFrames ()->points.size (), other_indices->size ());
+
+  frames = shot.getInputReferenceFrames ();
+  input->points[(*other_indices)[0]].x += static_cast<float> (mr);
+  tree->setInputCloud (input);
+  shot.compute (shots_again);
+  EXPECT_NE (shot.getInputReferenceFrames (), frames);
+  tree->setInputCloud (cloud.makeShared ());
+
+  // The frames of the shape descriptor can be shared with the color descriptor
+  PointCloud<PointXYZRGBA>::Ptr cloudWithColors (new PointCloud<PointXYZRGBA>);
+  for (int i = 0; i < static_cast<int> (cloud.points.size ()); ++i)
+  {
+    PointXYZRGBA p;
+    p.x = cloud.points[i].x;
+    p.y = cloud.points[i].y;
+    p.z = cloud.points[i].z;
+
+    p.rgba = ( (i%255) << 16 ) + ( ( (255 - i ) %255) << 8) + ( ( i*37 ) %255);
+    cloudWithColors->push_back(p);
+  }
+  search::KdTree<PointXYZRGBA>::Ptr rgbaTree (new search::KdTree<PointXYZRGBA> (false));
+
+  shot.setInputCloud (cloud.makeShared ());
+  shot.setIndices (test_indices);
+  shot.compute (shots);
+
+  SHOTEstimation<PointXYZRGBA, Normal, SHOT> color_shot (true, true);
+  color_shot.setInputCloud (cloudWithColors);
+  color_shot.setInputNormals (normals);
+  color_shot.setIndices (test_indices);
+  color_shot.setSearchMethod (rgbaTree);
+  color_shot.setRadiusSearch (20 * mr);
+  PointCloud<SHOT> color_shots, shared_color_shots;
+  color_shot.compute (color_shots);
+
+  color_shot.setInputReferenceFrames (shot.getInputReferenceFrames ());
+  color_shot.compute (shared_color_shots);
+  ASSERT_EQ (color_shots.points.size (), shared_color_shots.points.size ());
+  for (size_t i = 0; i < color_shots.points.size (); ++i)
+    for (size_t j = 0; j < color_shots.points[i].descriptor.size (); ++j)
+    {
+      if (pcl_isnan (color_shots.points[i].descriptor[j]))
+        EXPECT_TRUE (pcl_isnan (shared_color_shots.points[i].descriptor[j]));
+      else
+        EXPECT_NEAR (color_shots.points[i].descriptor[j], shared_color_shots.points[i].descriptor[j], 1e-5);
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL,3DSCEstimation)
 {
@@ -787,6 +884,119 @@ TEST (PCL, USCEstimation)
   testSHOTLocalReferenceFrame<UniqueShapeContext<PointXYZ, SHOT>, PointXYZ, Normal, SHOT> (cloud.makeShared (), normals, test_indices);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, 3DSCEstimationOpenMP)
+{
+  float meshRes = 0.002f;
+  float radius = 20.0f * meshRes;
+
+  PointCloud<PointXYZ>::Ptr cloudptr = cloud.makeShared ();
+
+  NormalEstimation<PointXYZ, Normal> ne;
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal> ());
+  ne.setInputCloud (cloudptr);
+  ne.setSearchMethod (tree);
+  ne.setRadiusSearch (radius);
+  ne.compute (*normals);
+
+  // Describe every other point, with the whole cloud as search surface
+  boost::shared_ptr<vector<int> > test_indices (new vector<int> (0));
+  for (size_t i = 0; i < cloud.size (); i += 2)
+    test_indices->push_back (static_cast<int> (i));
+
+  ShapeContext3DEstimation<PointXYZ, Normal, SHOT> sc3d;
+  ShapeContext3DEstimationOMP<PointXYZ, Normal, SHOT> sc3d_omp (false, 4);
+  PointCloud<SHOT> sc3ds, sc3ds_omp;
+  for (int run = 0; run < 2; ++run)
+  {
+    ShapeContext3DEstimation<PointXYZ, Normal, SHOT> &est = run == 0 ? sc3d : sc3d_omp;
+    est.setInputCloud (cloudptr);
+    est.setIndices (test_indices);
+    est.setInputNormals (normals);
+    est.setSearchMethod (tree);
+    est.setRadiusSearch (radius);
+    est.setAzimuthBins (12);
+    est.setElevationBins (11);
+    est.setRadiusBins (4);
+    est.setMinimalRadius (radius / 10.0f);
+    est.setPointDensityRadius (radius / 5.0f);
+    est.compute (run == 0 ? sc3ds : sc3ds_omp);
+  }
+
+  // Both draw the same X axes
+  ASSERT_EQ (sc3ds.size (), sc3ds_omp.size ());
+  EXPECT_EQ (sc3ds.is_dense, sc3ds_omp.is_dense);
+  for (size_t i = 0; i < sc3ds.size (); ++i)
+  {
+    ASSERT_EQ (sc3ds[i].descriptor.size (), sc3ds_omp[i].descriptor.size ());
+    for (size_t j = 0; j < sc3ds[i].descriptor.size (); ++j)
+      ASSERT_NEAR (sc3ds[i].descriptor[j], sc3ds_omp[i].descriptor[j], 1e-3);
+    for (int d = 0; d < 9; ++d)
+      EXPECT_EQ (sc3ds_omp[i].rf[d], 0.0f);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, USCEstimationOpenMP)
+{
+  float meshRes = 0.002f;
+  float radius = 20.0f * meshRes;
+
+  boost::shared_ptr<vector<int> > test_indices (new vector<int> (0));
+  for (size_t i = 0; i < cloud.size (); i += 3)
+    test_indices->push_back (static_cast<int> (i));
+
+  UniqueShapeContext<PointXYZ, SHOT> uscd;
+  UniqueShapeContextOMP<PointXYZ, SHOT> uscd_omp (4);
+  PointCloud<SHOT> uscds, uscds_omp, uscds_shared;
+  for (int run = 0; run < 2; ++run)
+  {
+    UniqueShapeContext<PointXYZ, SHOT> &est = run == 0 ? uscd : uscd_omp;
+    est.setInputCloud (cloud.makeShared ());
+    est.setIndices (test_indices);
+    est.setSearchMethod (tree);
+    est.setRadiusSearch (radius);
+    est.setAzimuthBins (12);
+    est.setElevationBins (11);
+    est.setRadiusBins (4);
+    est.setMinimalRadius (radius / 10.0f);
+    est.setPointDensityRadius (radius / 5.0f);
+    est.setLocalRadius (radius);
+    est.compute (run == 0 ? uscds : uscds_omp);
+  }
+
+  // The frames estimated by the serial version are shared with a second parallel one
+  UniqueShapeContextOMP<PointXYZ, SHOT> uscd_shared (2);
+  uscd_shared.setInputCloud (cloud.makeShared ());
+  uscd_shared.setIndices (test_indices);
+  uscd_shared.setSearchMethod (tree);
+  uscd_shared.setRadiusSearch (radius);
+  uscd_shared.setAzimuthBins (12);
+  uscd_shared.setElevationBins (11);
+  uscd_shared.setRadiusBins (4);
+  uscd_shared.setMinimalRadius (radius / 10.0f);
+  uscd_shared.setPointDensityRadius (radius / 5.0f);
+  uscd_shared.setInputReferenceFrames (uscd.getInputReferenceFrames ());
+  uscd_shared.compute (uscds_shared);
+
+  ASSERT_EQ (uscds.size (), uscds_omp.size ());
+  ASSERT_EQ (uscds.size (), uscds_shared.size ());
+  for (size_t i = 0; i < uscds.size (); ++i)
+  {
+    for (int d = 0; d < 9; ++d)
+    {
+      EXPECT_EQ (uscds[i].rf[d], uscds_omp[i].rf[d]);
+      EXPECT_EQ (uscds[i].rf[d], uscds_shared[i].rf[d]);
+    }
+    ASSERT_EQ (uscds[i].descriptor.size (), uscds_omp[i].descriptor.size ());
+    for (size_t j = 0; j < uscds[i].descriptor.size (); ++j)
+    {
+      ASSERT_NEAR (uscds[i].descriptor[j], uscds_omp[i].descriptor[j], 1e-3);
+      ASSERT_EQ (uscds_omp[i].descriptor[j], uscds_shared[i].descriptor[j]);
+    }
+  }
+}
+
 #ifndef PCL_ONLY_CORE_POINT_TYPES
   ///////////////////////////////////////////////////////////////////////////////////
   template <> UniqueShapeContext<PointXYZ, Eigen::MatrixXf>
@@ -50,7 +50,13 @@
 #include <pcl/filters/statistical_outlier_removal.h>
 #include <pcl/filters/conditional_removal.h>
 #include <pcl/filters/random_sample.h>
+#include <pcl/filters/normal_space.h>
 #include <pcl/filters/crop_box.h>
+#include <pcl/filters/crop_hull.h>
+#include <pcl/filters/filter_pipeline.h>
+#include <pcl/filters/bilateral.h>
+#include <pcl/filters/convolution.h>
+#include <pcl/search/brute_force.h>
 
 #include <pcl/common/transforms.h>
 #include <pcl/common/eigen.h>
@@ -233,6 +239,40 @@ TEST (ExtractIndices, Filters)
   */
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (RemoveNaNFromPointCloud, Filters)
+{
+  // An organized cloud without NaNs keeps its layout, whether it is marked dense or not
+  PointCloud<PointXYZ> organized (4, 3), output;
+  for (size_t i = 0; i < organized.points.size (); ++i)
+    organized.points[i] = PointXYZ (float (i % 4), float (i / 4), 1.0f);
+  vector<int> index;
+  for (int dense = 0; dense < 2; ++dense)
+  {
+    organized.is_dense = (dense != 0);
+    output = PointCloud<PointXYZ> ();
+    removeNaNFromPointCloud (organized, output, index);
+    EXPECT_EQ (output.width, 4);
+    EXPECT_EQ (output.height, 3);
+    EXPECT_EQ (bool (output.is_dense), true);
+    ASSERT_EQ (output.points.size (), organized.points.size ());
+    ASSERT_EQ (index.size (), organized.points.size ());
+    for (size_t i = 0; i < index.size (); ++i)
+      EXPECT_EQ (index[i], int (i));
+  }
+
+  // Removing a point breaks the organized structure
+  organized.is_dense = false;
+  organized.points[5].x = numeric_limits<float>::quiet_NaN ();
+  removeNaNFromPointCloud (organized, output, index);
+  EXPECT_EQ (output.width, 11);
+  EXPECT_EQ (output.height, 1);
+  EXPECT_EQ (bool (output.is_dense), true);
+  ASSERT_EQ (index.size (), 11);
+  EXPECT_EQ (index[4], 4);
+  EXPECT_EQ (index[5], 6);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PassThrough, Filters)
 {
@@ -682,6 +722,150 @@ TEST (VoxelGrid, Filters)
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (VoxelGrid_Parallel, Filters)
+{
+  // The multi-threaded grid has to produce exactly the same cloud as the single-threaded one
+  PointCloud<PointXYZ> output, output_mt;
+  VoxelGrid<PointXYZ> grid;
+  grid.setLeafSize (0.02f, 0.02f, 0.02f);
+  grid.setInputCloud (cloud);
+  grid.setFilterFieldName ("z");
+  grid.setFilterLimits (0.05, 0.1);
+  grid.setFilterLimitsNegative (true);
+  grid.filter (output);
+
+  grid.setNumberOfThreads (4);
+  grid.filter (output_mt);
+
+  ASSERT_EQ (output.points.size (), output_mt.points.size ());
+  for (size_t i = 0; i < output.points.size (); ++i)
+  {
+    EXPECT_EQ (output.points[i].x, output_mt.points[i].x);
+    EXPECT_EQ (output.points[i].y, output_mt.points[i].y);
+    EXPECT_EQ (output.points[i].z, output_mt.points[i].z);
+  }
+
+  PointCloud2 output_blob, output_blob_mt;
+  VoxelGrid<PointCloud2> grid2;
+  grid2.setLeafSize (0.02f, 0.02f, 0.02f);
+  grid2.setInputCloud (cloud_blob);
+  grid2.filter (output_blob);
+
+  grid2.setNumberOfThreads (4);
+  grid2.filter (output_blob_mt);
+
+  EXPECT_EQ (output_blob.width, 103);
+  EXPECT_EQ (output_blob.width, output_blob_mt.width);
+  EXPECT_TRUE (output_blob.data == output_blob_mt.data);
+
+  // The number of voxels of this grid (~3e19) does not fit in 64 bit linear voxel indices
+  PointCloud<PointXYZ>::Ptr far_cloud (new PointCloud<PointXYZ>);
+  for (int k = 0; k < 8; ++k)
+  {
+    float x = (k & 1) ? 1536.0f : -1536.0f;
+    float y = (k & 2) ? 1536.0f : -1536.0f;
+    float z = (k & 4) ? 1536.0f : -1536.0f;
+    far_cloud->points.push_back (PointXYZ (x, y, z));
+    far_cloud->points.push_back (PointXYZ (x + 0.00025f, y, z));
+  }
+  far_cloud->width = static_cast<uint32_t> (far_cloud->points.size ());
+  far_cloud->height = 1;
+
+  VoxelGrid<PointXYZ> far_grid;
+  far_grid.setLeafSize (0.0009765625f, 0.0009765625f, 0.0009765625f);
+  far_grid.setInputCloud (far_cloud);
+  far_grid.setNumberOfThreads (2);
+  far_grid.filter (output);
+
+  ASSERT_EQ (int (output.points.size ()), 8);
+  // centroids are ordered by z, then y, then x
+  for (int k = 0; k < 8; ++k)
+  {
+    EXPECT_NEAR (output.points[k].x, ((k & 1) ? 1536.0f : -1536.0f), 1e-3);
+    EXPECT_NEAR (output.points[k].y, ((k & 2) ? 1536.0f : -1536.0f), 1e-3);
+    EXPECT_NEAR (output.points[k].z, ((k & 4) ? 1536.0f : -1536.0f), 1e-3);
+  }
+
+  // such a grid can not be stored as a leaf layout
+  far_grid.setSaveLeafLayout (true);
+  EXPECT_THROW (far_grid.filter (output), PCLException);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (VoxelGrid_HashTable, Filters)
+{
+  // The sorted grid, with its leaf layout to look up the centroid of a voxel
+  PointCloud<PointXYZ> output, output_hashed;
+  VoxelGrid<PointXYZ> grid;
+  grid.setLeafSize (0.02f, 0.02f, 0.02f);
+  grid.setInputCloud (cloud);
+  grid.setSaveLeafLayout (true);
+  grid.filter (output);
+
+  VoxelGrid<PointXYZ> grid_hashed;
+  grid_hashed.setLeafSize (0.02f, 0.02f, 0.02f);
+  grid_hashed.setInputCloud (cloud);
+  grid_hashed.setUseHashTable (true);
+  EXPECT_TRUE (grid_hashed.getUseHashTable ());
+
+  for (unsigned int threads = 1; threads <= 4; threads *= 2)
+  {
+    grid_hashed.setNumberOfThreads (threads);
+    grid_hashed.filter (output_hashed);
+
+    // Every voxel has to appear exactly once, with the same centroid
+    ASSERT_EQ (output_hashed.points.size (), output.points.size ());
+    EXPECT_EQ (output_hashed.width, output.width);
+    EXPECT_EQ (int (output_hashed.height), 1);
+    std::vector<bool> found (output.points.size (), false);
+    for (size_t i = 0; i < output_hashed.points.size (); ++i)
+    {
+      int index = grid.getCentroidIndex (output_hashed.points[i]);
+      ASSERT_NE (index, -1);
+      EXPECT_FALSE (found[index]);
+      found[index] = true;
+      EXPECT_NEAR (output_hashed.points[i].x, output.points[index].x, 1e-5);
+      EXPECT_NEAR (output_hashed.points[i].y, output.points[index].y, 1e-5);
+      EXPECT_NEAR (output_hashed.points[i].z, output.points[index].z, 1e-5);
+    }
+  }
+
+  // Filtering by a field
+  grid.setFilterFieldName ("z");
+  grid.setFilterLimits (0.05, 0.1);
+  grid.filter (output);
+  grid_hashed.setFilterFieldName ("z");
+  grid_hashed.setFilterLimits (0.05, 0.1);
+  grid_hashed.filter (output_hashed);
+  EXPECT_EQ (int (output_hashed.points.size ()), 14);
+
+  // The hash table is not used if the leaf layout has to be saved
+  grid_hashed.setSaveLeafLayout (true);
+  grid_hashed.filter (output_hashed);
+  ASSERT_EQ (output_hashed.points.size (), output.points.size ());
+  for (size_t i = 0; i < output.points.size (); ++i)
+  {
+    EXPECT_EQ (output_hashed.points[i].x, output.points[i].x);
+    EXPECT_EQ (output_hashed.points[i].y, output.points[i].y);
+    EXPECT_EQ (output_hashed.points[i].z, output.points[i].z);
+  }
+
+  // Test the sensor_msgs::PointCloud2 method
+  PointCloud2 output_blob;
+  VoxelGrid<PointCloud2> grid2;
+  grid2.setLeafSize (0.02f, 0.02f, 0.02f);
+  grid2.setInputCloud (cloud_blob);
+  grid2.setUseHashTable (true);
+  grid2.setNumberOfThreads (2);
+  grid2.filter (output_blob);
+
+  fromROSMsg (output_blob, output_hashed);
+  EXPECT_EQ (int (output_hashed.points.size ()), 103);
+  EXPECT_EQ (int (output_hashed.width), 103);
+  EXPECT_EQ (int (output_hashed.height), 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
 TEST (VoxelGrid_RGB, Filters)
 {
   PointCloud2 cloud_rgb_blob_;
@@ -788,13 +972,24 @@ TEST (VoxelGridCovariance, Filters)
   EXPECT_EQ (bool (output.is_dense), true);
 
 
-  EXPECT_NEAR (output.points[0].x, -0.0692412, 1e-4);
-  EXPECT_NEAR (output.points[0].y, 0.114566, 1e-4);
-  EXPECT_NEAR (output.points[0].z, 0.0475084, 1e-4);
-
-  EXPECT_NEAR (output.points[13].x, -0.0857542, 1e-4);
-  EXPECT_NEAR (output.points[13].y, 0.149493, 1e-4);
-  EXPECT_NEAR (output.points[13].z, 0.0286718, 1e-4);
+  // the centroids are looked up by coordinate, as their order is not specified
+  const float expected_centroids[2][3] = { { -0.0692412f, 0.114566f, 0.0475084f },
+                                           { -0.0857542f, 0.149493f, 0.0286718f } };
+  for (int c = 0; c < 2; ++c)
+  {
+    Eigen::Vector3f centroid (expected_centroids[c][0], expected_centroids[c][1], expected_centroids[c][2]);
+    VoxelGridCovariance<PointXYZ>::LeafConstPtr leaf = grid.getLeaf (centroid);
+    ASSERT_TRUE (leaf != NULL);
+    EXPECT_NEAR (leaf->getMean ()[0], expected_centroids[c][0], 1e-4);
+    EXPECT_NEAR (leaf->getMean ()[1], expected_centroids[c][1], 1e-4);
+    EXPECT_NEAR (leaf->getMean ()[2], expected_centroids[c][2], 1e-4);
+
+    int nr_matches = 0;
+    for (size_t i = 0; i < output.points.size (); ++i)
+      if ((output.points[i].getVector3fMap () - centroid).norm () < 1e-4)
+        ++nr_matches;
+    EXPECT_EQ (nr_matches, 1);
+  }
 
   grid.setSaveLeafLayout (true);
   grid.filter (output);
@@ -853,6 +1048,69 @@ TEST (VoxelGridCovariance, Filters)
   EXPECT_NEAR (leaves[2]->getMean ()[0], -0.00936106, 1e-4);
   EXPECT_NEAR (leaves[2]->getMean ()[1], 0.0516725, 1e-4);
   EXPECT_NEAR (leaves[2]->getMean ()[2], 0.0508024, 1e-4);
+
+  // the leaf of a point and its neighborhoods
+  VoxelGridCovariance<PointXYZ>::LeafConstPtr leaf = grid.getLeaf (cloud->points[38]);
+  ASSERT_TRUE (leaf != NULL);
+  EXPECT_LE ((leaf->getMean ().cast<float> () - cloud->points[38].getVector3fMap ()).cwiseAbs ().maxCoeff (), 0.02);
+  vector<VoxelGridCovariance<PointXYZ>::LeafConstPtr> neighbors7, neighbors26, neighbors27;
+  grid.getNeighborhoodAtPoint7 (cloud->points[38], neighbors7);
+  grid.getNeighborhoodAtPoint (cloud->points[38], neighbors26);
+  grid.getNeighborhoodAtPoint27 (cloud->points[38], neighbors27);
+  EXPECT_GE (neighbors7.size (), 1);
+  EXPECT_LE (neighbors7.size (), neighbors27.size ());
+  EXPECT_EQ (neighbors27.size (), neighbors26.size () + (leaf->getPointCount () >= 6 ? 1 : 0));
+
+  // the leaves do not depend on the number of threads
+  VoxelGridCovariance<PointXYZ> grid_mt;
+  grid_mt.setLeafSize (0.02f, 0.02f, 0.02f);
+  grid_mt.setNumberOfThreads (4);
+  grid_mt.setInputCloud (cloud);
+  grid_mt.filter (output);
+  grid.filter (output);
+  ASSERT_EQ (grid_mt.getLeafVector ().size (), grid.getLeafVector ().size ());
+  for (size_t i = 0; i < grid.getLeafVector ().size (); ++i)
+  {
+    EXPECT_EQ (grid_mt.getLeafVector ()[i].getPointCount (), grid.getLeafVector ()[i].getPointCount ());
+    EXPECT_LE ((grid_mt.getLeafVector ()[i].getMean () - grid.getLeafVector ()[i].getMean ()).norm (), 1e-9);
+  }
+
+  // the leaf map is keyed by voxel index
+  const boost::unordered_map<size_t, VoxelGridCovariance<PointXYZ>::Leaf> &leaf_map = grid.getLeaves ();
+  EXPECT_EQ (leaf_map.size (), grid.getLeafVector ().size ());
+  for (boost::unordered_map<size_t, VoxelGridCovariance<PointXYZ>::Leaf>::const_iterator it = leaf_map.begin ();
+       it != leaf_map.end (); ++it)
+  {
+    leaf = grid.getLeaf (static_cast<int> (it->first));
+    ASSERT_TRUE (leaf != NULL);
+    EXPECT_EQ (it->second.getPointCount (), leaf->getPointCount ());
+    EXPECT_EQ (it->second.getMean (), leaf->getMean ());
+  }
+
+  // adding the points in two halves gives the same leaves as filtering them at once
+  PointCloud<PointXYZ> first_half, second_half;
+  first_half.points.assign (cloud->points.begin (), cloud->points.begin () + cloud->points.size () / 2);
+  second_half.points.assign (cloud->points.begin () + cloud->points.size () / 2, cloud->points.end ());
+  first_half.width = static_cast<uint32_t> (first_half.points.size ());
+  second_half.width = static_cast<uint32_t> (second_half.points.size ());
+  first_half.height = second_half.height = 1;
+  VoxelGridCovariance<PointXYZ> grid_inc;
+  grid_inc.setLeafSize (0.02f, 0.02f, 0.02f);
+  grid_inc.setInputCloud (first_half.makeShared ());
+  grid_inc.filter ();
+  grid_inc.addPoints (second_half);
+
+  EXPECT_EQ (grid_inc.getLeafVector ().size (), grid.getLeafVector ().size ());
+  EXPECT_EQ (grid_inc.getCentroids ()->size (), output.size ());
+  for (size_t i = 0; i < cloud->points.size (); i += 10)
+  {
+    VoxelGridCovariance<PointXYZ>::LeafConstPtr leaf_inc = grid_inc.getLeaf (cloud->points[i]);
+    leaf = grid.getLeaf (cloud->points[i]);
+    ASSERT_TRUE (leaf_inc != NULL && leaf != NULL);
+    EXPECT_EQ (leaf_inc->getPointCount (), leaf->getPointCount ());
+    EXPECT_LE ((leaf_inc->getMean () - leaf->getMean ()).norm (), 1e-6);
+    EXPECT_LE ((leaf_inc->getCov () - leaf->getCov ()).norm (), 1e-8);
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1026,6 +1284,151 @@ TEST (RandomSample, Filters)
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (RandomSample_Parallel, Filters)
+{
+  // Large samples are drawn in blocks, which must not depend on the number of threads
+  vector<int> positions, positions_parallel;
+  sampleSortedPositions (1000000, 100000, 7, positions, 1);
+  sampleSortedPositions (1000000, 100000, 7, positions_parallel, 4);
+  EXPECT_EQ (int (positions.size ()), 100000);
+  EXPECT_TRUE (positions == positions_parallel);
+  for (size_t i = 1; i < positions.size (); ++i)
+    EXPECT_LT (positions[i - 1], positions[i]);
+  EXPECT_GE (positions.front (), 0);
+  EXPECT_LT (positions.back (), 1000000);
+
+  // Sample from the given indices only
+  IndicesPtr even_indices (new vector<int>);
+  for (int i = 0; i < int (cloud->points.size ()); i += 2)
+    even_indices->push_back (i);
+  RandomSample<PointXYZ> sample;
+  sample.setInputCloud (cloud);
+  sample.setIndices (even_indices);
+  sample.setSample (50);
+  sample.setSeed (3);
+  vector<int> indices;
+  sample.filter (indices);
+  EXPECT_EQ (int (indices.size ()), 50);
+  for (size_t i = 0; i < indices.size (); ++i)
+    EXPECT_EQ (indices[i] % 2, 0);
+
+  sample.setNumberOfThreads (4);
+  vector<int> indices_parallel;
+  sample.filter (indices_parallel);
+  EXPECT_TRUE (indices == indices_parallel);
+
+  PointCloud<PointXYZ> cloud_out;
+  sample.filter (cloud_out);
+  ASSERT_EQ (int (cloud_out.size ()), 50);
+  for (size_t i = 0; i < indices.size (); ++i)
+    EXPECT_EQ (cloud->points[indices[i]].x, cloud_out.points[i].x);
+
+  // Stratified sampling over voxels takes one point per voxel first
+  const float leaf_size = 0.01f, inverse_leaf_size = 1.0f / leaf_size;
+  StratifiedRandomSample<PointXYZ> stratified;
+  stratified.setInputCloud (cloud);
+  stratified.setLeafSize (leaf_size, leaf_size, leaf_size);
+  stratified.setSeed (5);
+
+  map<vector<int>, int> voxels;
+  for (size_t i = 0; i < cloud->points.size (); ++i)
+  {
+    vector<int> voxel (3);
+    voxel[0] = int (floor (cloud->points[i].x * inverse_leaf_size));
+    voxel[1] = int (floor (cloud->points[i].y * inverse_leaf_size));
+    voxel[2] = int (floor (cloud->points[i].z * inverse_leaf_size));
+    ++voxels[voxel];
+  }
+  ASSERT_LT (voxels.size (), cloud->points.size ());
+  stratified.setSample (static_cast<unsigned int> (voxels.size ()));
+  stratified.filter (indices);
+  EXPECT_EQ (indices.size (), voxels.size ());
+
+  map<vector<int>, int> sampled_voxels;
+  for (size_t i = 0; i < indices.size (); ++i)
+  {
+    if (i > 0)
+      EXPECT_LT (indices[i - 1], indices[i]);
+    vector<int> voxel (3);
+    voxel[0] = int (floor (cloud->points[indices[i]].x * inverse_leaf_size));
+    voxel[1] = int (floor (cloud->points[indices[i]].y * inverse_leaf_size));
+    voxel[2] = int (floor (cloud->points[indices[i]].z * inverse_leaf_size));
+    EXPECT_EQ (++sampled_voxels[voxel], 1);
+  }
+
+  stratified.setNumberOfThreads (4);
+  stratified.filter (indices_parallel);
+  EXPECT_TRUE (indices == indices_parallel);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (NormalSpaceSampling, Filters)
+{
+  // 900 points with normals along Z, 100 along X and 10 invalid ones
+  PointCloud<PointXYZ>::Ptr input (new PointCloud<PointXYZ>);
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal>);
+  for (int i = 0; i < 1010; ++i)
+  {
+    input->points.push_back (PointXYZ (float (i), 0.0f, 0.0f));
+    if (i % 101 == 100)
+      normals->points.push_back (Normal (numeric_limits<float>::quiet_NaN (), 0.0f, 0.0f));
+    else if (i % 10 == 3)
+      normals->points.push_back (Normal (1.0f, 0.0f, 0.0f));
+    else
+      normals->points.push_back (Normal (0.0f, 0.0f, 1.0f));
+  }
+  input->width = normals->width = 1010;
+  input->height = normals->height = 1;
+
+  NormalSpaceSampling<PointXYZ, Normal> sample;
+  sample.setInputCloud (input);
+  sample.setNormals (normals);
+  sample.setBins (3, 3, 3);
+  sample.setSeed (11);
+
+  // Both bins give the same number of points
+  sample.setSample (160);
+  vector<int> indices;
+  sample.filter (indices);
+  ASSERT_EQ (int (indices.size ()), 160);
+  int nr_x = 0;
+  for (size_t i = 0; i < indices.size (); ++i)
+  {
+    if (i > 0)
+      EXPECT_LT (indices[i - 1], indices[i]);
+    EXPECT_TRUE (pcl_isfinite (normals->points[indices[i]].normal_x));
+    if (normals->points[indices[i]].normal_x == 1.0f)
+      ++nr_x;
+  }
+  EXPECT_EQ (nr_x, 80);
+
+  // Once the small bin is exhausted the sample comes from the large one
+  int nr_valid_x = 0;
+  for (size_t i = 0; i < normals->points.size (); ++i)
+    if (normals->points[i].normal_x == 1.0f)
+      ++nr_valid_x;
+  sample.setSample (500);
+  sample.filter (indices);
+  ASSERT_EQ (int (indices.size ()), 500);
+  nr_x = 0;
+  for (size_t i = 0; i < indices.size (); ++i)
+    if (normals->points[indices[i]].normal_x == 1.0f)
+      ++nr_x;
+  EXPECT_EQ (nr_x, nr_valid_x);
+
+  sample.setNumberOfThreads (4);
+  vector<int> indices_parallel;
+  sample.filter (indices_parallel);
+  EXPECT_TRUE (indices == indices_parallel);
+
+  PointCloud<PointXYZ> cloud_out;
+  sample.filter (cloud_out);
+  ASSERT_EQ (int (cloud_out.size ()), 500);
+  for (size_t i = 0; i < indices.size (); ++i)
+    EXPECT_EQ (input->points[indices[i]].x, cloud_out.points[i].x);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (CropBox, Filters)
 {
@@ -1186,6 +1589,404 @@ TEST (CropBox, Filters)
   EXPECT_EQ (int (cloud_out2.width * cloud_out2.height), 0);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (CropHull, Filters)
+{
+  // 3D hull: the surface of the cube [-1, 1]^3, each face split into 8x8 quads
+  const int n = 8;
+  PointCloud<PointXYZ>::Ptr hull_cloud (new PointCloud<PointXYZ> ());
+  std::vector<Vertices> hull_polygons;
+  for (int axis = 0; axis < 3; ++axis)
+    for (int side = -1; side <= 1; side += 2)
+    {
+      const int first = static_cast<int> (hull_cloud->points.size ());
+      for (int i = 0; i <= n; ++i)
+        for (int j = 0; j <= n; ++j)
+        {
+          Eigen::Vector3f p;
+          p[axis] = static_cast<float> (side);
+          p[(axis + 1) % 3] = -1.0f + 2.0f * static_cast<float> (i) / n;
+          p[(axis + 2) % 3] = -1.0f + 2.0f * static_cast<float> (j) / n;
+          hull_cloud->push_back (PointXYZ (p[0], p[1], p[2]));
+        }
+      for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+        {
+          const uint32_t a = first + i * (n + 1) + j, b = a + 1, c = a + n + 1, d = c + 1;
+          Vertices t1, t2;
+          t1.vertices.push_back (a); t1.vertices.push_back (b); t1.vertices.push_back (d);
+          t2.vertices.push_back (a); t2.vertices.push_back (d); t2.vertices.push_back (c);
+          hull_polygons.push_back (t1);
+          hull_polygons.push_back (t2);
+        }
+    }
+
+  // lattice of 16^3 points in [-2, 2]^3, 8^3 of them inside the cube
+  PointCloud<PointXYZ>::Ptr input (new PointCloud<PointXYZ> ());
+  for (int i = 0; i < 16; ++i)
+    for (int j = 0; j < 16; ++j)
+      for (int k = 0; k < 16; ++k)
+        input->push_back (PointXYZ (-1.875f + 0.25f * i, -1.875f + 0.25f * j, -1.875f + 0.25f * k));
+
+  CropHull<PointXYZ> crop_hull;
+  crop_hull.setInputCloud (input);
+  crop_hull.setHullCloud (hull_cloud);
+  crop_hull.setHullIndices (hull_polygons);
+  crop_hull.setDim (3);
+
+  PointCloud<PointXYZ> output;
+  crop_hull.filter (output);
+  EXPECT_EQ (int (output.points.size ()), 512);
+  for (size_t i = 0; i < output.points.size (); ++i)
+    EXPECT_LT (output.points[i].getVector3fMap ().cwiseAbs ().maxCoeff (), 1.0f);
+
+  std::vector<int> indices, indices_mt;
+  crop_hull.filter (indices);
+  crop_hull.setNumberOfThreads (4);
+  crop_hull.filter (indices_mt);
+  EXPECT_EQ (int (indices.size ()), 512);
+  EXPECT_TRUE (indices == indices_mt);
+
+  // removing the inside keeps the complement
+  crop_hull.setCropOutside (false);
+  crop_hull.filter (indices);
+  EXPECT_EQ (int (indices.size ()), 4096 - 512);
+  for (size_t i = 0; i < indices.size (); ++i)
+    EXPECT_GT (input->points[indices[i]].getVector3fMap ().cwiseAbs ().maxCoeff (), 1.0f);
+
+  // 2D hull: the square [-1, 1]^2 and a triangle next to it, in the z = 0 plane
+  PointCloud<PointXYZ>::Ptr polygon_cloud (new PointCloud<PointXYZ> ());
+  polygon_cloud->push_back (PointXYZ (-1.0f, -1.0f, 0.0f));
+  polygon_cloud->push_back (PointXYZ ( 1.0f, -1.0f, 0.0f));
+  polygon_cloud->push_back (PointXYZ ( 1.0f,  1.0f, 0.0f));
+  polygon_cloud->push_back (PointXYZ (-1.0f,  1.0f, 0.0f));
+  polygon_cloud->push_back (PointXYZ ( 1.5f,  1.5f, 0.0f));
+  polygon_cloud->push_back (PointXYZ ( 2.5f,  1.5f, 0.0f));
+  polygon_cloud->push_back (PointXYZ ( 1.5f,  2.5f, 0.0f));
+  std::vector<Vertices> polygons (2);
+  for (uint32_t i = 0; i < 4; ++i)
+    polygons[0].vertices.push_back (i);
+  for (uint32_t i = 4; i < 7; ++i)
+    polygons[1].vertices.push_back (i);
+
+  PointCloud<PointXYZ>::Ptr plane (new PointCloud<PointXYZ> ());
+  for (int i = 0; i < 16; ++i)
+    for (int j = 0; j < 16; ++j)
+      plane->push_back (PointXYZ (-1.875f + 0.25f * i, -1.875f + 0.25f * j, 0.0f));
+
+  CropHull<PointXYZ> crop_polygon;
+  crop_polygon.setInputCloud (plane);
+  crop_polygon.setHullCloud (polygon_cloud);
+  crop_polygon.setHullIndices (polygons);
+  crop_polygon.setDim (2);
+  crop_polygon.filter (indices);
+  EXPECT_EQ (int (indices.size ()), 64 + 4);
+  crop_polygon.setNumberOfThreads (4);
+  crop_polygon.filter (indices_mt);
+  EXPECT_TRUE (indices == indices_mt);
+
+  crop_polygon.setCropOutside (false);
+  crop_polygon.filter (output);
+  EXPECT_EQ (int (output.points.size ()), 256 - 64 - 4);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (FilterPipeline, Filters)
+{
+  // The chained filters
+  PassThrough<PointCloud2> pass_through;
+  pass_through.setFilterFieldName ("z");
+  pass_through.setFilterLimits (0.0, 0.05);
+
+  CropBox<PointCloud2> crop_box;
+  crop_box.setMin (Eigen::Vector4f (-0.1f, 0.05f, -1.0f, 1.0f));
+  crop_box.setMax (Eigen::Vector4f (0.0f, 0.2f, 1.0f, 1.0f));
+  crop_box.setRotation (Eigen::Vector3f (0.0f, 0.0f, 0.1f));
+
+  VoxelGrid<PointCloud2> grid;
+  grid.setLeafSize (0.01f, 0.01f, 0.01f);
+
+  PointCloud2 pass_through_blob, crop_box_blob, grid_blob;
+  pass_through.setInputCloud (cloud_blob);
+  pass_through.filter (pass_through_blob);
+  crop_box.setInputCloud (PointCloud2::Ptr (new PointCloud2 (pass_through_blob)));
+  crop_box.filter (crop_box_blob);
+  grid.setInputCloud (PointCloud2::Ptr (new PointCloud2 (crop_box_blob)));
+  grid.filter (grid_blob);
+  EXPECT_EQ (int (crop_box_blob.width), 184);
+
+  // The same filters in a single pass
+  FilterPipeline pipeline;
+  pipeline.addPassThrough (FilterPipeline::PassThroughPtr (new PassThrough<PointCloud2> (pass_through)));
+  pipeline.addCropBox (FilterPipeline::CropBoxPtr (new CropBox<PointCloud2> (crop_box)));
+  pipeline.setInputCloud (cloud_blob);
+
+  // Without a reducer, the points which pass are copied
+  PointCloud2 output_blob;
+  pipeline.filter (output_blob);
+  EXPECT_EQ (output_blob.width, crop_box_blob.width);
+  EXPECT_EQ (output_blob.height, 1);
+  EXPECT_EQ (output_blob.point_step, cloud_blob->point_step);
+  EXPECT_TRUE (output_blob.data == crop_box_blob.data);
+
+  // With a reducer, the points which pass are downsampled
+  pipeline.setVoxelGrid (FilterPipeline::VoxelGridPtr (new VoxelGrid<PointCloud2> (grid)));
+  pipeline.filter (output_blob);
+  PointCloud<PointXYZ> grid_cloud, output_cloud;
+  fromROSMsg (grid_blob, grid_cloud);
+  fromROSMsg (output_blob, output_cloud);
+  EXPECT_GT (int (grid_cloud.size ()), 0);
+  EXPECT_EQ (output_cloud.size (), grid_cloud.size ());
+  EXPECT_EQ (output_blob.point_step, grid_blob.point_step);
+  for (size_t i = 0; i < grid_cloud.size () && i < output_cloud.size (); ++i)
+  {
+    EXPECT_NEAR (output_cloud.points[i].x, grid_cloud.points[i].x, 1e-5);
+    EXPECT_NEAR (output_cloud.points[i].y, grid_cloud.points[i].y, 1e-5);
+    EXPECT_NEAR (output_cloud.points[i].z, grid_cloud.points[i].z, 1e-5);
+  }
+
+  // A field comparison equal to the pass through filter doesn't change the output
+  pipeline.addFieldComparison ("z", ComparisonOps::GE, 0.0);
+  pipeline.addFieldComparison ("z", ComparisonOps::LE, 0.05);
+  PointCloud2 output_blob2;
+  pipeline.filter (output_blob2);
+  EXPECT_TRUE (output_blob2.data == output_blob.data);
+
+  // The output doesn't depend on the number of threads
+  pipeline.setNumberOfThreads (4);
+  pipeline.filter (output_blob2);
+  fromROSMsg (output_blob2, output_cloud);
+  EXPECT_EQ (output_cloud.size (), grid_cloud.size ());
+  for (size_t i = 0; i < grid_cloud.size () && i < output_cloud.size (); ++i)
+  {
+    EXPECT_NEAR (output_cloud.points[i].x, grid_cloud.points[i].x, 1e-5);
+    EXPECT_NEAR (output_cloud.points[i].y, grid_cloud.points[i].y, 1e-5);
+    EXPECT_NEAR (output_cloud.points[i].z, grid_cloud.points[i].z, 1e-5);
+  }
+  pipeline.setVoxelGrid (FilterPipeline::VoxelGridPtr ());
+  pipeline.filter (output_blob2);
+  EXPECT_TRUE (output_blob2.data == crop_box_blob.data);
+
+  // An unknown field gives an empty output
+  pipeline.addFieldComparison ("unknown", ComparisonOps::GT, 0.0);
+  pipeline.filter (output_blob2);
+  EXPECT_EQ (int (output_blob2.width), 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (BilateralFilter, Filters)
+{
+  // An unorganized cloud with noisy intensities
+  PointCloud<PointXYZI>::Ptr cloud_i (new PointCloud<PointXYZI>);
+  for (size_t i = 0; i < cloud->points.size (); ++i)
+  {
+    PointXYZI point;
+    point.x = cloud->points[i].x;
+    point.y = cloud->points[i].y;
+    point.z = cloud->points[i].z;
+    point.intensity = (point.x > 0 ? 10.0f : 0.0f) + static_cast<float> ((i * 7919) % 100) / 100.0f;
+    cloud_i->points.push_back (point);
+  }
+  cloud_i->width = static_cast<uint32_t> (cloud_i->points.size ());
+  cloud_i->height = 1;
+
+  BilateralFilter<PointXYZI> bilateral;
+  bilateral.setInputCloud (cloud_i);
+  bilateral.setHalfSize (0.01);
+  bilateral.setStdDev (2.0);
+  bilateral.setSearchMethod (search::Search<PointXYZI>::Ptr (new search::BruteForce<PointXYZI>));
+  PointCloud<PointXYZI> exact, approximate;
+  bilateral.filter (exact);
+
+  bilateral.setApproximate (true);
+  bilateral.filter (approximate);
+  ASSERT_EQ (approximate.points.size (), exact.points.size ());
+  int nr_changed = 0;
+  for (size_t i = 0; i < exact.points.size (); ++i)
+  {
+    EXPECT_NEAR (approximate.points[i].intensity, exact.points[i].intensity, 1e-4);
+    if (fabs (exact.points[i].intensity - cloud_i->points[i].intensity) > 1e-3)
+      ++nr_changed;
+  }
+  EXPECT_GT (nr_changed, 0);
+
+  // The output doesn't depend on the number of threads
+  PointCloud<PointXYZI> approximate2;
+  bilateral.setNumberOfThreads (4);
+  bilateral.filter (approximate2);
+  for (size_t i = 0; i < exact.points.size (); ++i)
+    EXPECT_EQ (approximate2.points[i].intensity, approximate.points[i].intensity);
+
+  // A planar strip narrower than two search radii: its two rows of cells must not be searched twice
+  PointCloud<PointXYZI>::Ptr strip (new PointCloud<PointXYZI>);
+  for (int r = 0; r < 4; ++r)
+  {
+    for (int c = 0; c < 50; ++c)
+    {
+      PointXYZI point;
+      point.x = static_cast<float> (c) * 0.005f;
+      point.y = static_cast<float> (r) * 0.01f;
+      point.z = 1.0f;
+      point.intensity = (c < 25 ? 0.0f : 5.0f) + static_cast<float> ((r * 50 + c) % 7) * 0.1f;
+      strip->points.push_back (point);
+    }
+  }
+  strip->width = static_cast<uint32_t> (strip->points.size ());
+  strip->height = 1;
+
+  bilateral.setInputCloud (strip);
+  bilateral.setApproximate (false);
+  bilateral.filter (exact);
+  bilateral.setApproximate (true);
+  bilateral.filter (approximate);
+  ASSERT_EQ (approximate.points.size (), exact.points.size ());
+  for (size_t i = 0; i < exact.points.size (); ++i)
+    EXPECT_NEAR (approximate.points[i].intensity, exact.points[i].intensity, 1e-4);
+
+  // An organized cloud with a step edge in the intensities, and a few invalid points
+  PointCloud<PointXYZI>::Ptr organized (new PointCloud<PointXYZI> (40, 30));
+  for (int r = 0; r < 30; ++r)
+  {
+    for (int c = 0; c < 40; ++c)
+    {
+      PointXYZI &point = organized->at (c, r);
+      point.x = static_cast<float> (c) * 0.01f;
+      point.y = static_cast<float> (r) * 0.01f;
+      point.z = 1.0f + 0.02f * sinf (static_cast<float> (c + r) * 0.3f);
+      point.intensity = (c < 20 ? 0.0f : 5.0f) + static_cast<float> ((r * 40 + c) % 7) * 0.1f;
+      if ((r * 40 + c) % 97 == 0)
+        point.x = point.y = point.z = std::numeric_limits<float>::quiet_NaN ();
+    }
+  }
+  organized->is_dense = false;
+  // The exact filter can't search the neighbors of invalid points
+  IndicesPtr valid (new vector<int>);
+  for (int i = 0; i < int (organized->points.size ()); ++i)
+    if (isFinite (organized->points[i]))
+      valid->push_back (i);
+
+  BilateralFilter<PointXYZI> organized_bilateral;
+  organized_bilateral.setInputCloud (organized);
+  organized_bilateral.setIndices (valid);
+  organized_bilateral.setHalfSize (0.01);
+  organized_bilateral.setStdDev (1.0);
+  organized_bilateral.setSearchMethod (search::Search<PointXYZI>::Ptr (new search::BruteForce<PointXYZI>));
+  organized_bilateral.filter (exact);
+
+  // The window covers the search radius of 2 pixels
+  organized_bilateral.setApproximate (true);
+  organized_bilateral.setOrganizedWindowSize (3);
+  organized_bilateral.filter (approximate);
+  EXPECT_EQ (approximate.width, organized->width);
+  EXPECT_EQ (approximate.height, organized->height);
+  EXPECT_LT (valid->size (), organized->points.size ());
+  for (size_t i = 0; i < exact.points.size (); ++i)
+    EXPECT_NEAR (approximate.points[i].intensity, exact.points[i].intensity, 1e-4);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+expectEqualClouds (const PointCloud<PointXYZI> &a, const PointCloud<PointXYZI> &b)
+{
+  ASSERT_EQ (a.width, b.width);
+  ASSERT_EQ (a.height, b.height);
+  for (size_t i = 0; i < a.points.size (); ++i)
+  {
+    EXPECT_EQ (isFinite (a.points[i]), isFinite (b.points[i]));
+    if (isFinite (a.points[i]) && isFinite (b.points[i]))
+    {
+      EXPECT_EQ (a.points[i].x, b.points[i].x);
+      EXPECT_EQ (a.points[i].y, b.points[i].y);
+      EXPECT_EQ (a.points[i].z, b.points[i].z);
+    }
+    EXPECT_EQ (a.points[i].intensity, b.points[i].intensity);
+  }
+}
+
+TEST (Convolution, Filters)
+{
+  // An organized cloud whose width is not a multiple of the SSE width
+  PointCloud<PointXYZI>::Ptr organized (new PointCloud<PointXYZI> (67, 45));
+  for (int r = 0; r < 45; ++r)
+  {
+    for (int c = 0; c < 67; ++c)
+    {
+      PointXYZI &point = organized->at (c, r);
+      point.x = static_cast<float> (c) * 0.01f;
+      point.y = static_cast<float> (r) * 0.01f;
+      point.z = 1.0f + 0.05f * sinf (static_cast<float> (c) * 0.2f) + (c > 40 ? 0.2f : 0.0f);
+      point.intensity = static_cast<float> ((r * 67 + c) % 13);
+    }
+  }
+  // The same cloud with invalid points
+  PointCloud<PointXYZI>::Ptr sparse (new PointCloud<PointXYZI> (*organized));
+  for (size_t i = 0; i < sparse->points.size (); i += 29)
+    sparse->points[i].x = sparse->points[i].y = sparse->points[i].z = std::numeric_limits<float>::quiet_NaN ();
+  sparse->is_dense = false;
+
+  Eigen::ArrayXf h_kernel (5), v_kernel (3);
+  h_kernel << 0.1f, 0.2f, 0.4f, 0.2f, 0.1f;
+  v_kernel << 0.25f, 0.5f, 0.25f;
+
+  filters::Convolution<PointXYZI, PointXYZI> convolution;
+  convolution.setDistanceThreshold (0.05f);
+  const int policies[] = {filters::Convolution<PointXYZI, PointXYZI>::BORDERS_POLICY_IGNORE,
+                          filters::Convolution<PointXYZI, PointXYZI>::BORDERS_POLICY_MIRROR,
+                          filters::Convolution<PointXYZI, PointXYZI>::BORDERS_POLICY_DUPLICATE};
+  for (int dense = 0; dense < 2; ++dense)
+  {
+    PointCloud<PointXYZI>::Ptr input = dense ? organized : sparse;
+    for (int p = 0; p < 3; ++p)
+    {
+      convolution.setBordersPolicy (policies[p]);
+      // The channel planes give the same output as the point by point convolution
+      for (int planes = 0; planes < 2; ++planes)
+      {
+        PointCloud<PointXYZI> rows, cols, separate;
+        convolution.setUseChannelPlanes (planes != 0);
+        convolution.setInputCloud (input);
+        convolution.setKernel (h_kernel);
+        convolution.convolveRows (rows);
+        convolution.setKernel (v_kernel);
+        convolution.convolveCols (cols);
+        convolution.convolve (h_kernel, v_kernel, separate);
+
+        static PointCloud<PointXYZI> points_rows, points_cols, points_separate;
+        if (!planes)
+        {
+          points_rows = rows;
+          points_cols = cols;
+          points_separate = separate;
+          continue;
+        }
+        expectEqualClouds (rows, points_rows);
+        expectEqualClouds (cols, points_cols);
+        expectEqualClouds (separate, points_separate);
+      }
+    }
+  }
+
+  // Mirroring reflects the convolved rows around the border
+  PointCloud<PointXYZI> output;
+  convolution.setUseChannelPlanes (true);
+  convolution.setBordersPolicy (filters::Convolution<PointXYZI, PointXYZI>::BORDERS_POLICY_MIRROR);
+  convolution.setInputCloud (organized);
+  convolution.setKernel (h_kernel);
+  convolution.convolveRows (output);
+  EXPECT_EQ (output (0, 10).intensity, output (3, 10).intensity);
+  EXPECT_EQ (output (1, 10).intensity, output (2, 10).intensity);
+  EXPECT_EQ (output (66, 10).intensity, output (63, 10).intensity);
+  EXPECT_EQ (output (65, 10).intensity, output (64, 10).intensity);
+
+  // The output doesn't depend on the number of threads
+  PointCloud<PointXYZI> output2;
+  convolution.setNumberOfThreads (4);
+  convolution.convolve (h_kernel, v_kernel, output2);
+  convolution.setNumberOfThreads (1);
+  convolution.convolve (h_kernel, v_kernel, output);
+  expectEqualClouds (output, output2);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (StatisticalOutlierRemoval, Filters)
 {
@@ -1301,6 +2102,99 @@ TEST (StatisticalOutlierRemoval, Filters)
   EXPECT_NEAR (output.points[output.points.size () - 1].z, -0.0444, 1e-4);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (StatisticalOutlierRemoval_Parallel, Filters)
+{
+  PointCloud<PointXYZ> output, output_mt;
+  StatisticalOutlierRemoval<PointXYZ> outrem;
+  outrem.setInputCloud (cloud);
+  outrem.setMeanK (50);
+  outrem.setStddevMulThresh (1.0);
+  outrem.filter (output);
+  EXPECT_EQ (int (output.points.size ()), 352);
+
+  // The multi-threaded filter has to keep the same points, and can save the neighbors it searched
+  StatisticalOutlierRemoval<PointXYZ> outrem_mt;
+  outrem_mt.setInputCloud (cloud);
+  outrem_mt.setMeanK (50);
+  outrem_mt.setStddevMulThresh (1.0);
+  outrem_mt.setNumberOfThreads (4);
+  outrem_mt.setSaveNeighbors (true);
+  outrem_mt.filter (output_mt);
+
+  ASSERT_EQ (output_mt.points.size (), output.points.size ());
+  for (size_t i = 0; i < output.points.size (); ++i)
+    EXPECT_EQ (output_mt.points[i].getVector3fMap (), output.points[i].getVector3fMap ());
+
+  StatisticalOutlierRemoval<PointXYZ>::NeighborsPtr neighbors = outrem_mt.getNeighbors ();
+  StatisticalOutlierRemoval<PointXYZ>::DistancesPtr sqr_distances = outrem_mt.getNeighborSqrDistances ();
+  ASSERT_TRUE (neighbors);
+  ASSERT_TRUE (sqr_distances);
+  EXPECT_EQ (neighbors->size (), cloud->points.size ());
+  EXPECT_EQ (sqr_distances->size (), cloud->points.size ());
+  EXPECT_EQ ((*neighbors)[0].size (), size_t (50));
+  EXPECT_EQ ((*neighbors)[0][0], 0);
+
+  const std::vector<float> &mean_distances = outrem_mt.getMeanDistances ();
+  ASSERT_EQ (mean_distances.size (), cloud->points.size ());
+  double dist_sum = 0;
+  for (int j = 1; j < 50; ++j)
+    dist_sum += sqrt ((*sqr_distances)[0][j]);
+  EXPECT_NEAR (mean_distances[0], dist_sum / 49, 1e-6);
+
+  // Reuse the neighbors in a second filter
+  StatisticalOutlierRemoval<PointXYZ> outrem_reuse;
+  outrem_reuse.setInputCloud (cloud);
+  outrem_reuse.setMeanK (50);
+  outrem_reuse.setStddevMulThresh (1.0);
+  outrem_reuse.setNeighbors (neighbors, sqr_distances);
+  outrem_reuse.filter (output_mt);
+
+  ASSERT_EQ (output_mt.points.size (), output.points.size ());
+  for (size_t i = 0; i < output.points.size (); ++i)
+    EXPECT_EQ (output_mt.points[i].getVector3fMap (), output.points[i].getVector3fMap ());
+
+  // RadiusOutlierRemoval can test the points with the k nearest neighbors
+  PointCloud<PointXYZ> cloud_out, cloud_out_reuse;
+  RadiusOutlierRemoval<PointXYZ> radius_outrem;
+  radius_outrem.setInputCloud (cloud);
+  radius_outrem.setRadiusSearch (0.02);
+  radius_outrem.setMinNeighborsInRadius (15);
+  radius_outrem.filter (cloud_out);
+
+  radius_outrem.setNeighbors (neighbors, sqr_distances);
+  radius_outrem.filter (cloud_out_reuse);
+
+  EXPECT_EQ (int (cloud_out_reuse.points.size ()), 307);
+  ASSERT_EQ (cloud_out_reuse.points.size (), cloud_out.points.size ());
+  for (size_t i = 0; i < cloud_out.points.size (); ++i)
+    EXPECT_EQ (cloud_out_reuse.points[i].getVector3fMap (), cloud_out.points[i].getVector3fMap ());
+
+  // Test the sensor_msgs::PointCloud2 method
+  PointCloud2 output2;
+  StatisticalOutlierRemoval<PointCloud2> outrem2;
+  outrem2.setInputCloud (cloud_blob);
+  outrem2.setMeanK (50);
+  outrem2.setStddevMulThresh (1.0);
+  outrem2.setNumberOfThreads (4);
+  outrem2.setSaveNeighbors (true);
+  outrem2.filter (output2);
+
+  fromROSMsg (output2, output_mt);
+  EXPECT_EQ (int (output_mt.points.size ()), 352);
+  ASSERT_TRUE (outrem2.getNeighbors ());
+
+  RadiusOutlierRemoval<PointCloud2> radius_outrem2;
+  radius_outrem2.setInputCloud (cloud_blob);
+  radius_outrem2.setRadiusSearch (0.02);
+  radius_outrem2.setMinNeighborsInRadius (15);
+  radius_outrem2.setNeighbors (outrem2.getNeighbors (), outrem2.getNeighborSqrDistances ());
+  radius_outrem2.filter (output2);
+
+  fromROSMsg (output2, cloud_out_reuse);
+  EXPECT_EQ (int (cloud_out_reuse.points.size ()), 307);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 TEST (ConditionalRemoval, Filters)
 {
@@ -1502,6 +2396,84 @@ TEST (ConditionalRemovalSetIndices, Filters)
   EXPECT_EQ (num_not_nan, int (indices->size ()) - int (condrem2_.getRemovedIndices ()->size ()));
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (ConditionalRemovalBlocks, Filters)
+{
+  // random colored and labeled points, a few of them invalid
+  PointCloud<PointXYZRGBL>::Ptr input (new PointCloud<PointXYZRGBL> ());
+  srand (42);
+  for (int i = 0; i < 10000; ++i)
+  {
+    PointXYZRGBL p;
+    p.x = static_cast<float> (rand ()) / RAND_MAX;
+    p.y = static_cast<float> (rand ()) / RAND_MAX;
+    p.z = (i % 97 == 0) ? std::numeric_limits<float>::quiet_NaN () : static_cast<float> (rand ()) / RAND_MAX;
+    p.r = static_cast<uint8_t> (rand () % 256);
+    p.g = static_cast<uint8_t> (rand () % 256);
+    p.b = static_cast<uint8_t> (rand () % 256);
+    p.label = rand () % 8;
+    input->push_back (p);
+  }
+
+  // (0.2 < x <= 0.8 && label != 3 && (r > 128 || i < 100)) || z == 0.5 || label == 5
+  typedef ConditionBase<PointXYZRGBL>::ComparisonBaseConstPtr ComparisonPtr;
+  ConditionOr<PointXYZRGBL>::Ptr color_cond (new ConditionOr<PointXYZRGBL> ());
+  color_cond->addComparison (ComparisonPtr (new PackedRGBComparison<PointXYZRGBL> ("r", ComparisonOps::GT, 128)));
+  color_cond->addComparison (ComparisonPtr (new PackedHSIComparison<PointXYZRGBL> ("i", ComparisonOps::LT, 100)));
+  ConditionOr<PointXYZRGBL>::Ptr label_cond (new ConditionOr<PointXYZRGBL> ());
+  label_cond->addComparison (ComparisonPtr (new FieldComparison<PointXYZRGBL> ("label", ComparisonOps::LT, 3)));
+  label_cond->addComparison (ComparisonPtr (new FieldComparison<PointXYZRGBL> ("label", ComparisonOps::GT, 3)));
+  ConditionAnd<PointXYZRGBL>::Ptr range_cond (new ConditionAnd<PointXYZRGBL> ());
+  range_cond->addComparison (ComparisonPtr (new FieldComparison<PointXYZRGBL> ("x", ComparisonOps::GT, 0.2)));
+  range_cond->addComparison (ComparisonPtr (new FieldComparison<PointXYZRGBL> ("x", ComparisonOps::LE, 0.8)));
+  range_cond->addCondition (label_cond);
+  range_cond->addCondition (color_cond);
+  ConditionOr<PointXYZRGBL>::Ptr cond (new ConditionOr<PointXYZRGBL> ());
+  cond->addCondition (range_cond);
+  cond->addComparison (ComparisonPtr (new FieldComparison<PointXYZRGBL> ("z", ComparisonOps::EQ, 0.5)));
+  cond->addComparison (ComparisonPtr (new FieldComparison<PointXYZRGBL> ("label", ComparisonOps::EQ, 5)));
+
+  // reference: the condition evaluated point by point
+  std::vector<int> expected;
+  for (int i = 0; i < static_cast<int> (input->points.size ()); ++i)
+    if (pcl_isfinite (input->points[i].z) && cond->evaluate (input->points[i]))
+      expected.push_back (i);
+  ASSERT_GT (int (expected.size ()), 0);
+
+  for (unsigned int threads = 1; threads <= 4; threads += 3)
+  {
+    ConditionalRemoval<PointXYZRGBL> condrem (cond, true);
+    condrem.setInputCloud (input);
+    condrem.setNumberOfThreads (threads);
+
+    PointCloud<PointXYZRGBL> output;
+    condrem.filter (output);
+    ASSERT_EQ (expected.size (), output.points.size ());
+    for (size_t i = 0; i < expected.size (); ++i)
+    {
+      EXPECT_EQ (input->points[expected[i]].x, output.points[i].x);
+      EXPECT_EQ (input->points[expected[i]].label, output.points[i].label);
+    }
+    EXPECT_EQ (input->points.size () - expected.size (), condrem.getRemovedIndices ()->size ());
+
+    condrem.setKeepOrganized (true);
+    condrem.filter (output);
+    ASSERT_EQ (input->points.size (), output.points.size ());
+    size_t nr_valid = 0;
+    for (size_t i = 0; i < output.points.size (); ++i)
+    {
+      if (!pcl_isfinite (output.points[i].x))
+        continue;
+      EXPECT_EQ (input->points[i].y, output.points[i].y);
+      EXPECT_TRUE (cond->evaluate (input->points[i]));
+      nr_valid++;
+    }
+    // NaN points are only removed when not keeping the structure organized
+    EXPECT_GE (nr_valid, expected.size ());
+    EXPECT_EQ (input->points.size () - nr_valid, condrem.getRemovedIndices ()->size ());
+  }
+}
+
 TEST (ConditionalRemovalTfQuadraticXYZComparison, Filters)
 {
   // Test the PointCloud<PointT> method
@@ -342,6 +342,61 @@ TEST(PCL, IntegralImage3D)
   delete[] data;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, IntegralImageThreads)
+{
+  const unsigned width = 64;
+  const unsigned height = 37;
+  std::vector<float> data (width * height * 3);
+  for (unsigned idx = 0; idx < width * height; ++idx)
+  {
+    data[idx * 3    ] = static_cast<float> (idx % width);
+    data[idx * 3 + 1] = static_cast<float> (idx / width);
+    data[idx * 3 + 2] = (idx % 7 == 0) ? std::numeric_limits<float>::quiet_NaN () : static_cast<float> (idx % 5);
+  }
+
+  // The threaded image first computes a larger input, so its buffers are reused for the smaller one
+  std::vector<float> large_data (640 * 480 * 3, 1.0f);
+  IntegralImage2D<float, 3> serial (true);
+  IntegralImage2D<float, 3> threaded (true);
+  threaded.setNumberOfThreads (4);
+  threaded.setInput (&large_data[0], 640, 480, 3, 640 * 3);
+  threaded.setInput (&data[0], width, height, 3, width * 3);
+  serial.setInput (&data[0], width, height, 3, width * 3);
+
+  for (unsigned yIdx = 0; yIdx < height; yIdx += 3)
+  {
+    for (unsigned xIdx = 0; xIdx < width; xIdx += 5)
+    {
+      const unsigned window_width = width - xIdx;
+      const unsigned window_height = height - yIdx;
+      EXPECT_EQ (serial.getFiniteElementsCount (xIdx, yIdx, window_width, window_height),
+                 threaded.getFiniteElementsCount (xIdx, yIdx, window_width, window_height));
+      IntegralImage2D<float, 3>::ElementType sum = serial.getFirstOrderSum (xIdx, yIdx, window_width, window_height);
+      IntegralImage2D<float, 3>::ElementType threaded_sum = threaded.getFirstOrderSum (xIdx, yIdx, window_width, window_height);
+      IntegralImage2D<float, 3>::SecondOrderType sum_sqr = serial.getSecondOrderSum (xIdx, yIdx, window_width, window_height);
+      IntegralImage2D<float, 3>::SecondOrderType threaded_sum_sqr = threaded.getSecondOrderSum (xIdx, yIdx, window_width, window_height);
+      for (int i = 0; i < 3; ++i)
+        EXPECT_EQ (sum[i], threaded_sum[i]);
+      for (int i = 0; i < 6; ++i)
+        EXPECT_EQ (sum_sqr[i], threaded_sum_sqr[i]);
+    }
+  }
+
+  // Ground truth for the whole image
+  unsigned count = 0;
+  double sum_x = 0;
+  for (unsigned idx = 0; idx < width * height; ++idx)
+  {
+    if (idx % 7 == 0)
+      continue;
+    ++count;
+    sum_x += data[idx * 3];
+  }
+  EXPECT_EQ (count, threaded.getFiniteElementsCount (0, 0, width, height));
+  EXPECT_EQ (sum_x, threaded.getFirstOrderSum (0, 0, width, height)[0]);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, NormalEstimation)
 {
@@ -490,6 +545,113 @@ TEST (PCL, IINormalEstimationSimple3DGradient)
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/** \brief Create a curved surface with a depth step and holes, seen from the origin.
+  * \param[in] curvature the curvature of the surface along the rows
+  */
+PointCloud<PointXYZ>::Ptr
+createCurvedSurface (float curvature)
+{
+  PointCloud<PointXYZ>::Ptr surface (new PointCloud<PointXYZ> (160, 120));
+  for (size_t v = 0; v < surface->height; ++v)
+  {
+    for (size_t u = 0; u < surface->width; ++u)
+    {
+      PointXYZ &point = (*surface) (u, v);
+      const float du = static_cast<float> (u) - 80.0f;
+      point.z = 2.0f + curvature * du * du + (u > 100 ? 0.5f : 0.0f);
+      point.x = du * point.z / 525.0f;
+      point.y = (static_cast<float> (v) - 60.0f) * point.z / 525.0f;
+      if ((u + 3 * v) % 41 == 0)
+        point.x = point.y = point.z = std::numeric_limits<float>::quiet_NaN ();
+    }
+  }
+  surface->is_dense = false;
+  return (surface);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, IINormalEstimationThreads)
+{
+  PointCloud<PointXYZ>::Ptr surface = createCurvedSurface (0.002f);
+  PointCloud<PointXYZ>::Ptr previous_frame = createCurvedSurface (0.004f);
+
+  const IntegralImageNormalEstimation<PointXYZ, Normal>::NormalEstimationMethod methods[] =
+    { ne.COVARIANCE_MATRIX, ne.AVERAGE_3D_GRADIENT, ne.AVERAGE_DEPTH_CHANGE, ne.SIMPLE_3D_GRADIENT };
+  for (int m = 0; m < 4; ++m)
+  {
+    IntegralImageNormalEstimation<PointXYZ, Normal> serial, threaded;
+    serial.setNormalEstimationMethod (methods[m]);
+    threaded.setNormalEstimationMethod (methods[m]);
+    threaded.setNumberOfThreads (4);
+    serial.setNormalSmoothingSize (5.0f);
+    threaded.setNormalSmoothingSize (5.0f);
+    serial.setInputCloud (surface);
+
+    PointCloud<Normal> output, threaded_output;
+    serial.compute (output);
+    // The second frame reuses the buffers of the first one
+    threaded.setInputCloud (previous_frame);
+    threaded.compute (threaded_output);
+    threaded.setInputCloud (surface);
+    threaded.compute (threaded_output);
+    ASSERT_EQ (output.points.size (), threaded_output.points.size ());
+
+    int nr_valid = 0;
+    for (size_t i = 0; i < output.points.size (); ++i)
+    {
+      EXPECT_EQ (pcl_isfinite (output.points[i].normal_x), pcl_isfinite (threaded_output.points[i].normal_x));
+      if (!pcl_isfinite (output.points[i].normal_x) || !pcl_isfinite (threaded_output.points[i].normal_x))
+        continue;
+      ++nr_valid;
+      EXPECT_NEAR (output.points[i].normal_x, threaded_output.points[i].normal_x, 1e-4);
+      EXPECT_NEAR (output.points[i].normal_y, threaded_output.points[i].normal_y, 1e-4);
+      EXPECT_NEAR (output.points[i].normal_z, threaded_output.points[i].normal_z, 1e-4);
+    }
+    EXPECT_GT (nr_valid, 0);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, IINormalEstimationCovarianceEigen33)
+{
+  // The covariance matrices of a frame are decomposed in batches; eigen33 () decomposes one at a time
+  PointCloud<PointXYZ>::Ptr surface = createCurvedSurface (0.002f);
+  IntegralImageNormalEstimation<PointXYZ, Normal> batched;
+  batched.setNormalEstimationMethod (batched.COVARIANCE_MATRIX);
+  batched.setNormalSmoothingSize (5.0f);
+  batched.setInputCloud (surface);
+  PointCloud<Normal> output;
+  batched.compute (output);
+
+  // The same rectangles as compute (), without depth dependent smoothing
+  const float *distance_map = batched.getDistanceMap ();
+  ASSERT_TRUE (distance_map != NULL);
+  int nr_valid = 0;
+  for (int v = 0; v < static_cast<int> (surface->height); ++v)
+  {
+    for (int u = 0; u < static_cast<int> (surface->width); ++u)
+    {
+      const int index = v * static_cast<int> (surface->width) + u;
+      if (!pcl_isfinite (output.points[index].normal_x))
+        continue;
+      const int rect_size = static_cast<int> (std::min (distance_map[index], 5.0f));
+      batched.setRectSize (rect_size, rect_size);
+      Normal reference;
+      batched.computePointNormal (u, v, index, reference);
+      ASSERT_TRUE (pcl_isfinite (reference.normal_x));
+      ++nr_valid;
+
+      // The normals agree within 1e-3 per component and the curvatures within 1e-4
+      EXPECT_NEAR (output.points[index].normal_x, reference.normal_x, 1e-3);
+      EXPECT_NEAR (output.points[index].normal_y, reference.normal_y, 1e-3);
+      EXPECT_NEAR (output.points[index].normal_z, reference.normal_z, 1e-3);
+      EXPECT_NEAR (output.points[index].curvature, reference.curvature, 1e-4);
+    }
+  }
+  EXPECT_GT (nr_valid, 0);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, IINormalEstimationSimple3DGradientUnorganized)
 {
@@ -0,0 +1,181 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <pcl/point_types.h>
+#include <pcl/filters/convolution.h>
+#include <pcl/console/print.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+
+#include <limits>
+
+using namespace pcl;
+using namespace pcl::console;
+
+typedef PointXYZI PointT;
+typedef PointCloud<PointT> Cloud;
+typedef filters::Convolution<PointT, PointT> Convolution;
+
+enum Operation { CONVOLVE_ROWS, CONVOLVE_COLS, CONVOLVE_SEPARATE };
+
+int default_kernel_size = 5;
+int default_runs = 5;
+int default_threads = 1;
+
+void
+printHelp (int, char **argv)
+{
+  print_error ("Syntax is: %s <options>\n", argv[0]);
+  print_info ("  where options are:\n");
+  print_info ("                     -kernel X     = size of the Gaussian kernel, odd (default: ");
+  print_value ("%d", default_kernel_size); print_info (")\n");
+  print_info ("                     -runs X       = number of timed runs, the fastest one is reported (default: ");
+  print_value ("%d", default_runs); print_info (")\n");
+  print_info ("                     -threads X    = number of threads used for convolving (default: ");
+  print_value ("%d", default_threads); print_info (")\n");
+  print_info ("                     -sparse       = invalidate some points and use a distance threshold (non dense path)\n");
+}
+
+/** \brief Create an organized cloud of a wavy surface. */
+Cloud::Ptr
+createCloud (int width, int height, bool sparse)
+{
+  Cloud::Ptr cloud (new Cloud (width, height));
+  for (int r = 0; r < height; ++r)
+  {
+    for (int c = 0; c < width; ++c)
+    {
+      PointT &point = cloud->at (c, r);
+      point.x = static_cast<float> (c - width / 2) * 0.002f;
+      point.y = static_cast<float> (r - height / 2) * 0.002f;
+      point.z = 1.0f + 0.02f * sinf (static_cast<float> (c) * 0.05f) * cosf (static_cast<float> (r) * 0.05f);
+      point.intensity = static_cast<float> ((r * 31 + c * 17) % 255);
+      if (sparse && (r * width + c) % 53 == 0)
+        point.x = point.y = point.z = std::numeric_limits<float>::quiet_NaN ();
+    }
+  }
+  cloud->is_dense = !sparse;
+  return (cloud);
+}
+
+/** \brief Run a convolution on a cloud.
+  * \return the time of the fastest run in ms
+  */
+double
+timeConvolution (Operation operation, const Cloud::ConstPtr &cloud, const Eigen::ArrayXf &kernel,
+                 bool use_channel_planes, bool sparse, int threads, int runs)
+{
+  double best = std::numeric_limits<double>::max ();
+  TicToc tt;
+  for (int run = 0; run < runs; ++run)
+  {
+    Convolution convolution;
+    convolution.setInputCloud (cloud);
+    convolution.setKernel (kernel);
+    convolution.setUseChannelPlanes (use_channel_planes);
+    convolution.setNumberOfThreads (threads);
+    if (sparse)
+      convolution.setDistanceThreshold (0.01f);
+    Cloud output;
+    tt.tic ();
+    switch (operation)
+    {
+      case CONVOLVE_ROWS : convolution.convolveRows (output); break;
+      case CONVOLVE_COLS : convolution.convolveCols (output); break;
+      case CONVOLVE_SEPARATE : convolution.convolve (kernel, kernel, output); break;
+    }
+    best = std::min (best, tt.toc ());
+  }
+  return (best);
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  print_info ("Benchmark the convolution of organized clouds point by point and on channel planes. For more information, use: %s -h\n", argv[0]);
+
+  if (find_switch (argc, argv, "-h"))
+  {
+    printHelp (argc, argv);
+    return (-1);
+  }
+
+  int kernel_size = default_kernel_size;
+  int runs = default_runs;
+  int threads = default_threads;
+  parse_argument (argc, argv, "-kernel", kernel_size);
+  parse_argument (argc, argv, "-runs", runs);
+  parse_argument (argc, argv, "-threads", threads);
+  const bool sparse = find_switch (argc, argv, "-sparse");
+  if (kernel_size % 2 == 0)
+  {
+    print_error ("The kernel size must be odd.\n");
+    return (-1);
+  }
+
+  // Gaussian kernel with a standard deviation of a sixth of its size
+  Eigen::ArrayXf kernel (kernel_size);
+  const float sigma = static_cast<float> (kernel_size) / 6.0f;
+  for (int k = 0; k < kernel_size; ++k)
+  {
+    const float d = static_cast<float> (k - kernel_size / 2);
+    kernel[k] = expf (-d * d / (2.0f * sigma * sigma));
+  }
+  kernel /= kernel.sum ();
+
+  const int sizes[][2] = {{640, 480}, {1280, 960}};
+  const char* operation_names[] = {"convolveRows", "convolveCols", "convolve"};
+
+  print_info ("%-10s %-14s %12s %12s %12s\n", "size", "operation", "points", "planes", "speedup");
+  for (int s = 0; s < 2; ++s)
+  {
+    Cloud::ConstPtr cloud = createCloud (sizes[s][0], sizes[s][1], sparse);
+    for (int o = CONVOLVE_ROWS; o <= CONVOLVE_SEPARATE; ++o)
+    {
+      const double points_time = timeConvolution (static_cast<Operation> (o), cloud, kernel, false, sparse, threads, runs);
+      const double planes_time = timeConvolution (static_cast<Operation> (o), cloud, kernel, true, sparse, threads, runs);
+      print_info ("%4dx%-5d %-14s %9.1f ms %9.1f ms ", sizes[s][0], sizes[s][1], operation_names[o], points_time, planes_time);
+      print_value ("%11.2fx\n", points_time / planes_time);
+    }
+  }
+
+  return (0);
+}
+/* ]--- */
@@ -0,0 +1,184 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <pcl/point_types.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/features/integral_image_normal.h>
+#include <pcl/console/print.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace pcl;
+using namespace pcl::io;
+using namespace pcl::console;
+
+typedef IntegralImageNormalEstimation<PointXYZ, Normal> NormalEstimator;
+
+int default_runs = 10;
+int default_threads = 4;
+float default_smoothing = 10.0f;
+
+void
+printHelp (int, char **argv)
+{
+  print_error ("Syntax is: %s [input.pcd] <options>\n", argv[0]);
+  print_info ("  where the organized input cloud is optional, synthetic QVGA and VGA frames are used without it, and options are:\n");
+  print_info ("                     -runs X       = number of timed frames, the fastest one is reported (default: ");
+  print_value ("%d", default_runs); print_info (")\n");
+  print_info ("                     -threads X    = number of threads of the threaded estimator (default: ");
+  print_value ("%d", default_threads); print_info (")\n");
+  print_info ("                     -smoothing X  = normal smoothing size (default: ");
+  print_value ("%f", default_smoothing); print_info (")\n");
+}
+
+/** \brief Create a frame of a depth camera looking at a wavy surface in front of a wall. */
+PointCloud<PointXYZ>::Ptr
+createFrame (uint32_t width, uint32_t height)
+{
+  PointCloud<PointXYZ>::Ptr cloud (new PointCloud<PointXYZ> (width, height));
+  const float focal_length = 525.0f * static_cast<float> (width) / 640.0f;
+  for (uint32_t v = 0; v < height; ++v)
+  {
+    for (uint32_t u = 0; u < width; ++u)
+    {
+      const float x = (static_cast<float> (u) - 0.5f * static_cast<float> (width)) / focal_length;
+      const float y = (static_cast<float> (v) - 0.5f * static_cast<float> (height)) / focal_length;
+      float z = 3.0f;
+      if (fabsf (x) < 0.4f && fabsf (y) < 0.3f)
+        z = 1.5f + 0.05f * sinf (20.0f * x) * cosf (15.0f * y);
+      PointXYZ &point = (*cloud) (u, v);
+      point.x = x * z;
+      point.y = y * z;
+      point.z = z;
+    }
+  }
+  cloud->is_dense = true;
+  return (cloud);
+}
+
+/** \brief Run a normal estimation method on the same frame several times with one estimator, so that the
+  * buffers of the first frame are reused.
+  * \return the time of the fastest run in ms
+  */
+double
+timeNormals (const PointCloud<PointXYZ>::ConstPtr &cloud, NormalEstimator::NormalEstimationMethod method,
+             unsigned int threads, float smoothing, int runs)
+{
+  NormalEstimator ne;
+  ne.setNormalEstimationMethod (method);
+  ne.setNormalSmoothingSize (smoothing);
+  ne.setNumberOfThreads (threads);
+
+  PointCloud<Normal> normals;
+  double best = std::numeric_limits<double>::max ();
+  TicToc tt;
+  for (int run = 0; run < runs; ++run)
+  {
+    tt.tic ();
+    ne.setInputCloud (cloud);
+    ne.compute (normals);
+    best = std::min (best, tt.toc ());
+  }
+  return (best);
+}
+
+/** \brief Print the timings of all methods for one frame. */
+void
+benchmarkFrame (const char *name, const PointCloud<PointXYZ>::ConstPtr &cloud, int threads, float smoothing, int runs)
+{
+  const char *method_names[] = { "COVARIANCE_MATRIX", "AVERAGE_3D_GRADIENT", "AVERAGE_DEPTH_CHANGE", "SIMPLE_3D_GRADIENT" };
+  const NormalEstimator::NormalEstimationMethod methods[] = { NormalEstimator::COVARIANCE_MATRIX,
+    NormalEstimator::AVERAGE_3D_GRADIENT, NormalEstimator::AVERAGE_DEPTH_CHANGE, NormalEstimator::SIMPLE_3D_GRADIENT };
+
+  print_info ("%s (", name); print_value ("%d x %d", cloud->width, cloud->height); print_info (")\n");
+  print_info ("%-22s %12s %12s %12s\n", "method", "1 thread", "threaded", "speedup");
+  for (int m = 0; m < 4; ++m)
+  {
+    const double serial_time = timeNormals (cloud, methods[m], 1, smoothing, runs);
+    const double threaded_time = timeNormals (cloud, methods[m], threads, smoothing, runs);
+    print_info ("%-22s %9.2f ms %9.2f ms ", method_names[m], serial_time, threaded_time);
+    print_value ("%11.2fx\n", serial_time / threaded_time);
+  }
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  print_info ("Benchmark integral image normal estimation on organized frames. For more information, use: %s -h\n", argv[0]);
+
+  if (find_switch (argc, argv, "-h"))
+  {
+    printHelp (argc, argv);
+    return (-1);
+  }
+
+  int runs = default_runs;
+  int threads = default_threads;
+  float smoothing = default_smoothing;
+  parse_argument (argc, argv, "-runs", runs);
+  parse_argument (argc, argv, "-threads", threads);
+  parse_argument (argc, argv, "-smoothing", smoothing);
+  runs = std::max (runs, 1);
+  threads = std::max (threads, 1);
+
+  std::vector<int> p_file_indices = parse_file_extension_argument (argc, argv, ".pcd");
+  if (!p_file_indices.empty ())
+  {
+    PointCloud<PointXYZ>::Ptr cloud (new PointCloud<PointXYZ>);
+    if (loadPCDFile (argv[p_file_indices[0]], *cloud) < 0)
+      return (-1);
+    if (!cloud->isOrganized ())
+    {
+      print_error ("The input cloud is not organized.\n");
+      return (-1);
+    }
+    benchmarkFrame (argv[p_file_indices[0]], cloud, threads, smoothing, runs);
+    return (0);
+  }
+
+  benchmarkFrame ("QVGA", createFrame (320, 240), threads, smoothing, runs);
+  benchmarkFrame ("VGA", createFrame (640, 480), threads, smoothing, runs);
+  return (0);
+}
+/* ]--- */
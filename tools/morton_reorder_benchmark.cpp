@@ -0,0 +1,258 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <pcl/point_types.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/common/morton.h>
+#include <pcl/filters/filter.h>
+#include <pcl/features/normal_3d.h>
+#include <pcl/features/fpfh.h>
+#include <pcl/surface/mls.h>
+#include <pcl/search/kdtree.h>
+#include <pcl/search/octree.h>
+#include <pcl/console/print.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+
+#include <algorithm>
+#include <limits>
+
+using namespace pcl;
+using namespace pcl::io;
+using namespace pcl::console;
+
+typedef PointXYZ PointT;
+typedef PointCloud<PointT> Cloud;
+
+enum SearchType { KDTREE_SEARCH, OCTREE_SEARCH };
+enum Estimator { NORMAL_ESTIMATION, FPFH_ESTIMATION, MLS_SMOOTHING };
+
+double default_radius = 0.02;
+int default_runs = 3;
+int default_threads = 1;
+
+void
+printHelp (int, char **argv)
+{
+  print_error ("Syntax is: %s input.pcd <options>\n", argv[0]);
+  print_info ("  where options are:\n");
+  print_info ("                     -radius X     = neighborhood radius of all estimators (default: ");
+  print_value ("%f", default_radius); print_info (")\n");
+  print_info ("                     -runs X       = number of timed runs, the fastest one is reported (default: ");
+  print_value ("%d", default_runs); print_info (")\n");
+  print_info ("                     -threads X    = number of threads used for reordering (default: ");
+  print_value ("%d", default_threads); print_info (")\n");
+  print_info ("                     -hilbert      = reorder along the Hilbert curve instead of the Morton curve\n");
+  print_info ("                     -shuffle      = randomly shuffle the input points first (unordered input)\n");
+}
+
+search::Search<PointT>::Ptr
+createSearch (SearchType type, double radius)
+{
+  if (type == OCTREE_SEARCH)
+    return (search::Search<PointT>::Ptr (new search::Octree<PointT> (radius)));
+  return (search::Search<PointT>::Ptr (new search::KdTree<PointT>));
+}
+
+void
+estimateNormals (const Cloud::ConstPtr &cloud, SearchType type, double radius, PointCloud<Normal> &normals)
+{
+  NormalEstimation<PointT, Normal> ne;
+  ne.setInputCloud (cloud);
+  ne.setSearchMethod (createSearch (type, radius));
+  ne.setRadiusSearch (radius);
+  ne.compute (normals);
+}
+
+/** \brief Run an estimator on a cloud, including the construction of the search structure.
+  * \return the time of the fastest run in ms
+  */
+double
+timeEstimator (Estimator estimator, const Cloud::ConstPtr &cloud, SearchType type, double radius, int runs)
+{
+  // FPFH requires normals - their computation is not timed
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal>);
+  if (estimator == FPFH_ESTIMATION)
+    estimateNormals (cloud, type, radius, *normals);
+
+  double best = std::numeric_limits<double>::max ();
+  TicToc tt;
+  for (int run = 0; run < runs; ++run)
+  {
+    tt.tic ();
+    switch (estimator)
+    {
+      case NORMAL_ESTIMATION:
+      {
+        PointCloud<Normal> output;
+        estimateNormals (cloud, type, radius, output);
+        break;
+      }
+      case FPFH_ESTIMATION:
+      {
+        FPFHEstimation<PointT, Normal, FPFHSignature33> fpfh;
+        fpfh.setInputCloud (cloud);
+        fpfh.setInputNormals (normals);
+        fpfh.setSearchMethod (createSearch (type, radius));
+        fpfh.setRadiusSearch (radius);
+        PointCloud<FPFHSignature33> output;
+        fpfh.compute (output);
+        break;
+      }
+      case MLS_SMOOTHING:
+      {
+        MovingLeastSquares<PointT, PointT> mls;
+        mls.setInputCloud (cloud);
+        mls.setSearchMethod (createSearch (type, radius));
+        mls.setSearchRadius (radius);
+        Cloud output;
+        mls.process (output);
+        break;
+      }
+    }
+    best = std::min (best, tt.toc ());
+  }
+  return (best);
+}
+
+/** \brief Compare the normals of the original cloud with the normals of the reordered cloud mapped back. */
+double
+maxNormalDeviation (const Cloud::ConstPtr &cloud, const Cloud::ConstPtr &reordered,
+                    const std::vector<int> &indices_map, double radius)
+{
+  PointCloud<Normal> normals, normals_reordered, normals_restored;
+  estimateNormals (cloud, KDTREE_SEARCH, radius, normals);
+  estimateNormals (reordered, KDTREE_SEARCH, radius, normals_reordered);
+  restoreOriginalOrder (normals_reordered, indices_map, normals_restored);
+
+  double max_deviation = 0.0;
+  for (size_t i = 0; i < normals.points.size (); ++i)
+  {
+    if (!pcl_isfinite (normals.points[i].normal_x) || !pcl_isfinite (normals_restored.points[i].normal_x))
+      continue;
+    // normals may be flipped, compare their orientation
+    const double cos_angle = fabs (normals.points[i].getNormalVector3fMap ().dot (
+                                   normals_restored.points[i].getNormalVector3fMap ()));
+    max_deviation = std::max (max_deviation, 1.0 - cos_angle);
+  }
+  return (max_deviation);
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  print_info ("Benchmark feature estimation on Morton/Hilbert reordered point clouds. For more information, use: %s -h\n", argv[0]);
+
+  if (argc < 2 || find_switch (argc, argv, "-h"))
+  {
+    printHelp (argc, argv);
+    return (-1);
+  }
+
+  std::vector<int> p_file_indices = parse_file_extension_argument (argc, argv, ".pcd");
+  if (p_file_indices.size () != 1)
+  {
+    print_error ("Need one input PCD file to continue.\n");
+    return (-1);
+  }
+
+  double radius = default_radius;
+  int runs = default_runs;
+  int threads = default_threads;
+  parse_argument (argc, argv, "-radius", radius);
+  parse_argument (argc, argv, "-runs", runs);
+  parse_argument (argc, argv, "-threads", threads);
+  const bool hilbert = find_switch (argc, argv, "-hilbert");
+  const bool shuffle = find_switch (argc, argv, "-shuffle");
+
+  // Load the input file
+  Cloud::Ptr input (new Cloud);
+  if (loadPCDFile (argv[p_file_indices[0]], *input) < 0)
+    return (-1);
+
+  Cloud::Ptr cloud (new Cloud);
+  std::vector<int> valid;
+  removeNaNFromPointCloud (*input, *cloud, valid);
+
+  if (shuffle)
+    std::random_shuffle (cloud->points.begin (), cloud->points.end ());
+
+  print_info ("Loaded "); print_value ("%d", static_cast<int> (cloud->points.size ())); print_info (" finite points\n");
+
+  // Reorder the cloud, reporting the fastest run
+  Cloud::Ptr reordered (new Cloud);
+  std::vector<int> indices_map;
+  double reorder_time = std::numeric_limits<double>::max ();
+  TicToc tt;
+  for (int run = 0; run < runs; ++run)
+  {
+    tt.tic ();
+    if (hilbert)
+      reorderHilbert (*cloud, *reordered, indices_map, threads);
+    else
+      reorderMorton (*cloud, *reordered, indices_map, threads);
+    reorder_time = std::min (reorder_time, tt.toc ());
+  }
+  print_info ("Reordering along the %s curve: ", hilbert ? "Hilbert" : "Morton");
+  print_value ("%g", reorder_time); print_info (" ms\n");
+
+  print_info ("Max. normal deviation after mapping back: ");
+  print_value ("%g\n", maxNormalDeviation (cloud, reordered, indices_map, radius));
+
+  const char* estimator_names[] = {"NormalEstimation", "FPFHEstimation", "MovingLeastSquares"};
+  const char* search_names[] = {"KdTree", "Octree"};
+
+  print_info ("%-20s %-8s %12s %12s %12s\n", "estimator", "search", "original", "reordered", "speedup");
+  for (int e = NORMAL_ESTIMATION; e <= MLS_SMOOTHING; ++e)
+  {
+    for (int s = KDTREE_SEARCH; s <= OCTREE_SEARCH; ++s)
+    {
+      const double original_time = timeEstimator (static_cast<Estimator> (e), cloud, static_cast<SearchType> (s), radius, runs);
+      const double reordered_time = timeEstimator (static_cast<Estimator> (e), reordered, static_cast<SearchType> (s), radius, runs);
+
+      // the end-to-end speedup includes the reordering
+      print_info ("%-20s %-8s %9.1f ms %9.1f ms ", estimator_names[e], search_names[s], original_time, reordered_time);
+      print_value ("%11.2fx\n", original_time / (reordered_time + reorder_time));
+    }
+  }
+
+  return (0);
+}
+/* ]--- */
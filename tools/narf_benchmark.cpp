@@ -0,0 +1,185 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <pcl/point_types.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/range_image/range_image.h>
+#include <pcl/features/range_image_border_extractor.h>
+#include <pcl/features/narf.h>
+#include <pcl/features/narf_descriptor.h>
+#include <pcl/keypoints/narf_keypoint.h>
+#include <pcl/console/print.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+
+#include <algorithm>
+#include <limits>
+
+using namespace pcl;
+using namespace pcl::io;
+using namespace pcl::console;
+
+int default_runs = 5;
+int default_threads = 4;
+float default_angular_resolution = 0.5f;
+float default_support_size = 0.2f;
+
+void
+printHelp (int, char **argv)
+{
+  print_error ("Syntax is: %s input.pcd <options>\n", argv[0]);
+  print_info ("  where options are:\n");
+  print_info ("                     -runs X       = number of timed runs, the fastest one is reported (default: ");
+  print_value ("%d", default_runs); print_info (")\n");
+  print_info ("                     -threads X    = number of threads of the threaded runs (default: ");
+  print_value ("%d", default_threads); print_info (")\n");
+  print_info ("                     -res X        = angular resolution of the range image in degrees (default: ");
+  print_value ("%f", default_angular_resolution); print_info (")\n");
+  print_info ("                     -support X    = support size of the keypoints and descriptors in meters (default: ");
+  print_value ("%f", default_support_size); print_info (")\n");
+}
+
+/** \brief The times of the stages of NARF extraction in ms, and the sizes of their results. */
+struct StageTimes
+{
+  StageTimes () : borders (std::numeric_limits<double>::max ()), keypoints (std::numeric_limits<double>::max ()),
+                  descriptors (std::numeric_limits<double>::max ()), nr_keypoints (0), nr_descriptors (0) {}
+  double borders, keypoints, descriptors;
+  size_t nr_keypoints, nr_descriptors;
+};
+
+/** \brief Extract borders, keypoints and descriptors from a range image several times, each run with fresh objects
+  * as for a new frame, and keep the fastest time of every stage.
+  */
+StageTimes
+timeNarf (const RangeImage &range_image, int threads, float support_size, int runs)
+{
+  StageTimes times;
+  TicToc tt;
+  Narf::max_no_of_threads = threads;
+  for (int run = 0; run < runs; ++run)
+  {
+    RangeImageBorderExtractor border_extractor (&range_image);
+    border_extractor.getParameters ().max_no_of_threads = threads;
+    PointCloud<BorderDescription> border_descriptions;
+    tt.tic ();
+    border_extractor.compute (border_descriptions);
+    border_extractor.getSurfaceChangeScores ();
+    times.borders = std::min (times.borders, tt.toc ());
+
+    NarfKeypoint narf_keypoint (&border_extractor);
+    narf_keypoint.getParameters ().support_size = support_size;
+    narf_keypoint.getParameters ().max_no_of_threads = threads;
+    PointCloud<int> keypoint_indices;
+    tt.tic ();
+    narf_keypoint.compute (keypoint_indices);
+    times.keypoints = std::min (times.keypoints, tt.toc ());
+    times.nr_keypoints = keypoint_indices.points.size ();
+
+    std::vector<int> keypoint_indices2 (keypoint_indices.points.begin (), keypoint_indices.points.end ());
+    NarfDescriptor narf_descriptor (&range_image, &keypoint_indices2);
+    narf_descriptor.getParameters ().support_size = support_size;
+    narf_descriptor.getParameters ().rotation_invariant = true;
+    PointCloud<Narf36> descriptors;
+    tt.tic ();
+    narf_descriptor.compute (descriptors);
+    times.descriptors = std::min (times.descriptors, tt.toc ());
+    times.nr_descriptors = descriptors.points.size ();
+  }
+  Narf::max_no_of_threads = 1;
+  return (times);
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  print_info ("Benchmark NARF border, keypoint and descriptor extraction on a range image. For more information, use: %s -h\n", argv[0]);
+
+  std::vector<int> p_file_indices = parse_file_extension_argument (argc, argv, ".pcd");
+  if (find_switch (argc, argv, "-h") || p_file_indices.empty ())
+  {
+    printHelp (argc, argv);
+    return (-1);
+  }
+
+  int runs = default_runs;
+  int threads = default_threads;
+  float angular_resolution = default_angular_resolution;
+  float support_size = default_support_size;
+  parse_argument (argc, argv, "-runs", runs);
+  parse_argument (argc, argv, "-threads", threads);
+  parse_argument (argc, argv, "-res", angular_resolution);
+  parse_argument (argc, argv, "-support", support_size);
+  runs = std::max (runs, 1);
+  threads = std::max (threads, 1);
+
+  PointCloud<PointXYZ> cloud;
+  if (loadPCDFile (argv[p_file_indices[0]], cloud) < 0)
+    return (-1);
+
+  // Look at the cloud from the sensor pose stored in the file, as the range image would have been recorded
+  Eigen::Affine3f sensor_pose = Eigen::Affine3f (Eigen::Translation3f (cloud.sensor_origin_[0],
+                                                                       cloud.sensor_origin_[1],
+                                                                       cloud.sensor_origin_[2])) *
+                                Eigen::Affine3f (cloud.sensor_orientation_);
+  RangeImage range_image;
+  range_image.createFromPointCloud (cloud, deg2rad (angular_resolution), deg2rad (360.0f), deg2rad (180.0f),
+                                    sensor_pose, RangeImage::CAMERA_FRAME, 0.0f, 0.0f, 1);
+  range_image.setUnseenToMaxRange ();
+
+  print_info ("%s: ", argv[p_file_indices[0]]);
+  print_value ("%d", static_cast<int> (cloud.points.size ())); print_info (" points, range image of ");
+  print_value ("%d x %d", range_image.width, range_image.height); print_info (" pixels\n");
+
+  const StageTimes serial_times = timeNarf (range_image, 1, support_size, runs);
+  const StageTimes threaded_times = timeNarf (range_image, threads, support_size, runs);
+
+  print_info ("%-12s %12s %12s %12s\n", "stage", "1 thread", "threaded", "speedup");
+  print_info ("%-12s %9.2f ms %9.2f ms ", "borders", serial_times.borders, threaded_times.borders);
+  print_value ("%11.2fx\n", serial_times.borders / threaded_times.borders);
+  print_info ("%-12s %9.2f ms %9.2f ms ", "keypoints", serial_times.keypoints, threaded_times.keypoints);
+  print_value ("%11.2fx\n", serial_times.keypoints / threaded_times.keypoints);
+  print_info ("%-12s %9.2f ms %9.2f ms ", "descriptors", serial_times.descriptors, threaded_times.descriptors);
+  print_value ("%11.2fx\n", serial_times.descriptors / threaded_times.descriptors);
+  print_info ("Found "); print_value ("%d", static_cast<int> (threaded_times.nr_keypoints)); print_info (" keypoints and ");
+  print_value ("%d", static_cast<int> (threaded_times.nr_descriptors)); print_info (" descriptors\n");
+  return (0);
+}
+/* ]--- */
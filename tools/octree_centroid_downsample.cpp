@@ -0,0 +1,193 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <sensor_msgs/PointCloud2.h>
+#include <pcl/point_types.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/common/io.h>
+#include <pcl/octree/octree.h>
+#include <pcl/octree/octree_impl.h>
+#include <pcl/console/print.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+
+using namespace pcl;
+using namespace pcl::io;
+using namespace pcl::console;
+
+typedef PointXYZRGBNormal PointT;
+typedef octree::OctreePointCloudStreamingVoxelCentroid<PointT> Octree;
+
+double default_resolution = 0.01;
+int    default_threads = 1;
+int    default_batch_size = 1000000;
+
+void
+printHelp (int, char **argv)
+{
+  print_error ("Syntax is: %s input1.pcd [input2.pcd ...] output.pcd <options>\n", argv[0]);
+  print_info ("  where options are:\n");
+  print_info ("                     -resolution X = the voxel edge length (default: ");
+  print_value ("%f", default_resolution); print_info (")\n");
+  print_info ("                     -threads X    = the number of input files processed in parallel (default: ");
+  print_value ("%d", default_threads); print_info (")\n");
+  print_info ("                     -batch X      = the number of points inserted into the octree at once (default: ");
+  print_value ("%d", default_batch_size); print_info (")\n");
+}
+
+bool
+loadCloud (const std::string &filename, PointCloud<PointT> &cloud, bool &has_rgb, bool &has_normals)
+{
+  sensor_msgs::PointCloud2 blob;
+  if (loadPCDFile (filename, blob) < 0)
+    return (false);
+
+  has_rgb = (getFieldIndex (blob, "rgb") >= 0) || (getFieldIndex (blob, "rgba") >= 0);
+  has_normals = (getFieldIndex (blob, "normal_x") >= 0);
+  fromROSMsg (blob, cloud);
+
+  return (true);
+}
+
+template <typename OutPointT> void
+saveCloud (const std::string &filename, const PointCloud<PointT> &centroids)
+{
+  PointCloud<OutPointT> output;
+  copyPointCloud (centroids, output);
+  savePCDFile (filename, output, true);
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  print_info ("Downsample large clouds to voxel centroids using pcl::octree::OctreePointCloudStreamingVoxelCentroid. For more information, use: %s -h\n", argv[0]);
+
+  if (argc < 3)
+  {
+    printHelp (argc, argv);
+    return (-1);
+  }
+
+  // Parse the command line arguments for .pcd files
+  std::vector<int> p_file_indices;
+  p_file_indices = parse_file_extension_argument (argc, argv, ".pcd");
+  if (p_file_indices.size () < 2)
+  {
+    print_error ("Need at least one input PCD file and one output PCD file to continue.\n");
+    return (-1);
+  }
+
+  // Command line parsing
+  double resolution = default_resolution;
+  int threads = default_threads;
+  int batch_size = default_batch_size;
+  parse_argument (argc, argv, "-resolution", resolution);
+  parse_argument (argc, argv, "-threads", threads);
+  parse_argument (argc, argv, "-batch", batch_size);
+  threads = std::max (threads, 1);
+  batch_size = std::max (batch_size, 1);
+  print_info ("Using a voxel resolution of: "); print_value ("%f\n", resolution);
+
+  Octree octree (resolution);
+
+  const int nr_files = static_cast<int> (p_file_indices.size ()) - 1;
+  std::vector<char> file_rgb (nr_files, 0), file_normals (nr_files, 0), file_ok (nr_files, 0);
+
+  TicToc tt;
+  tt.tic ();
+
+  // every thread streams its own input files into the octree in batches - only one input file per thread is held
+  // in memory at a time
+#pragma omp parallel for schedule (dynamic, 1) num_threads (threads)
+  for (int f = 0; f < nr_files; ++f)
+  {
+    PointCloud<PointT> cloud;
+    bool has_rgb, has_normals;
+    if (!loadCloud (argv[p_file_indices[f]], cloud, has_rgb, has_normals))
+      continue;
+
+    file_ok[f] = 1;
+    file_rgb[f] = has_rgb;
+    file_normals[f] = has_normals;
+
+    std::vector<int> batch;
+    batch.reserve (batch_size);
+    for (int begin = 0; begin < static_cast<int> (cloud.points.size ()); begin += batch_size)
+    {
+      const int end = std::min (begin + batch_size, static_cast<int> (cloud.points.size ()));
+      batch.resize (end - begin);
+      for (int i = begin; i < end; ++i)
+        batch[i - begin] = i;
+      octree.addPoints (cloud, batch);
+    }
+  }
+
+  bool has_rgb = true, has_normals = true;
+  for (int f = 0; f < nr_files; ++f)
+  {
+    if (!file_ok[f])
+    {
+      print_error ("Could not load file %s.\n", argv[p_file_indices[f]]);
+      return (-1);
+    }
+    has_rgb = has_rgb && file_rgb[f];
+    has_normals = has_normals && file_normals[f];
+  }
+
+  PointCloud<PointT> centroids;
+  octree.getVoxelCentroids (centroids);
+
+  print_info ("[done, "); print_value ("%g", tt.toc ()); print_info (" ms : "); print_value ("%lu", static_cast<unsigned long> (octree.getPointCount ()));
+  print_info (" points -> "); print_value ("%d", centroids.width); print_info (" voxels]\n");
+
+  // Save only the fields available in all input files
+  const std::string output_file = argv[p_file_indices[nr_files]];
+  print_highlight ("Saving "); print_value ("%s\n", output_file.c_str ());
+  if (has_rgb && has_normals)
+    saveCloud<PointXYZRGBNormal> (output_file, centroids);
+  else if (has_rgb)
+    saveCloud<PointXYZRGB> (output_file, centroids);
+  else if (has_normals)
+    saveCloud<PointNormal> (output_file, centroids);
+  else
+    saveCloud<PointXYZ> (output_file, centroids);
+
+  return (0);
+}
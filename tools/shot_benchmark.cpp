@@ -0,0 +1,223 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2012, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+
+#include <pcl/point_types.h>
+#include <pcl/common/io.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/filters/filter.h>
+#include <pcl/features/normal_3d_omp.h>
+#include <pcl/features/shot_lrf.h>
+#include <pcl/features/shot_omp.h>
+#include <pcl/search/kdtree.h>
+#include <pcl/console/print.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/time.h>
+
+#include <algorithm>
+#include <limits>
+
+using namespace pcl;
+using namespace pcl::io;
+using namespace pcl::console;
+
+typedef PointCloud<ReferenceFrame> Frames;
+
+double default_radius = 0.03;
+int default_step = 10;
+int default_runs = 3;
+int default_threads = 1;
+
+void
+printHelp (int, char **argv)
+{
+  print_error ("Syntax is: %s input.pcd <options>\n", argv[0]);
+  print_info ("  where options are:\n");
+  print_info ("                     -radius X     = radius of the descriptors and of the local reference frames (default: ");
+  print_value ("%f", default_radius); print_info (")\n");
+  print_info ("                     -step X       = describe every X-th point of the cloud (default: ");
+  print_value ("%d", default_step); print_info (")\n");
+  print_info ("                     -runs X       = number of timed runs, the fastest one is reported (default: ");
+  print_value ("%d", default_runs); print_info (")\n");
+  print_info ("                     -threads X    = number of threads of the OpenMP estimators (default: ");
+  print_value ("%d", default_threads); print_info (")\n");
+}
+
+/** \brief Estimate the local reference frames of the keypoints once, to be shared by the descriptors. */
+template <typename PointT> typename Frames::Ptr
+estimateFrames (const typename PointCloud<PointT>::ConstPtr &cloud, const IndicesPtr &keypoints, double radius, double &time)
+{
+  typename Frames::Ptr frames (new Frames);
+  SHOTLocalReferenceFrameEstimation<PointT, ReferenceFrame> lrf;
+  lrf.setInputCloud (cloud);
+  lrf.setIndices (keypoints);
+  lrf.setRadiusSearch (radius);
+  TicToc tt;
+  tt.tic ();
+  lrf.compute (*frames);
+  time = tt.toc ();
+  return (frames);
+}
+
+/** \brief Run a SHOT estimator on the keypoints of a cloud, with a fresh copy of the estimator for every run.
+  * \param[in] frames the local reference frames to share, or null to let the estimator compute its own
+  * \return the time of the fastest run in ms
+  */
+template <typename Estimator, typename PointT> double
+timeSHOT (const Estimator &prototype, const typename PointCloud<PointT>::ConstPtr &cloud,
+          const PointCloud<Normal>::ConstPtr &normals, const IndicesPtr &keypoints,
+          const Frames::ConstPtr &frames, double radius, int runs)
+{
+  double best = std::numeric_limits<double>::max ();
+  TicToc tt;
+  for (int run = 0; run < runs; ++run)
+  {
+    Estimator shot (prototype);
+    shot.setInputCloud (cloud);
+    shot.setInputNormals (normals);
+    shot.setIndices (keypoints);
+    shot.setSearchMethod (typename search::KdTree<PointT>::Ptr (new search::KdTree<PointT>));
+    shot.setRadiusSearch (radius);
+    if (frames)
+      shot.setInputReferenceFrames (frames);
+    PointCloud<SHOT> descriptors;
+    tt.tic ();
+    shot.compute (descriptors);
+    best = std::min (best, tt.toc ());
+  }
+  return (best);
+}
+
+/** \brief Print one row of the results table. */
+void
+printRow (const char *name, double default_time, double shared_time)
+{
+  print_info ("%-26s %9.1f ms %9.1f ms ", name, default_time, shared_time);
+  print_value ("%11.2fx\n", default_time / shared_time);
+}
+
+/* ---[ */
+int
+main (int argc, char** argv)
+{
+  print_info ("Benchmark SHOT estimation with default and with shared local reference frames. For more information, use: %s -h\n", argv[0]);
+
+  if (argc < 2 || find_switch (argc, argv, "-h"))
+  {
+    printHelp (argc, argv);
+    return (-1);
+  }
+
+  std::vector<int> p_file_indices = parse_file_extension_argument (argc, argv, ".pcd");
+  if (p_file_indices.size () != 1)
+  {
+    print_error ("Need one input PCD file to continue.\n");
+    return (-1);
+  }
+
+  double radius = default_radius;
+  int step = default_step;
+  int runs = default_runs;
+  int threads = default_threads;
+  parse_argument (argc, argv, "-radius", radius);
+  parse_argument (argc, argv, "-step", step);
+  parse_argument (argc, argv, "-runs", runs);
+  parse_argument (argc, argv, "-threads", threads);
+  step = std::max (step, 1);
+
+  // Load the input file, the color is optional
+  PointCloud<PointXYZRGBA>::Ptr input (new PointCloud<PointXYZRGBA>);
+  if (loadPCDFile (argv[p_file_indices[0]], *input) < 0)
+    return (-1);
+
+  PointCloud<PointXYZRGBA>::Ptr cloud_rgba (new PointCloud<PointXYZRGBA>);
+  std::vector<int> valid;
+  removeNaNFromPointCloud (*input, *cloud_rgba, valid);
+  PointCloud<PointXYZ>::Ptr cloud (new PointCloud<PointXYZ>);
+  copyPointCloud (*cloud_rgba, *cloud);
+
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal>);
+  NormalEstimationOMP<PointXYZ, Normal> ne (threads);
+  ne.setInputCloud (cloud);
+  ne.setRadiusSearch (radius);
+  ne.compute (*normals);
+
+  IndicesPtr keypoints (new std::vector<int>);
+  for (int i = 0; i < static_cast<int> (cloud->points.size ()); i += step)
+    keypoints->push_back (i);
+
+  print_info ("Loaded "); print_value ("%d", static_cast<int> (cloud->points.size ()));
+  print_info (" finite points, describing "); print_value ("%d", static_cast<int> (keypoints->size ()));
+  print_info (" of them\n");
+
+  double frames_time, frames_rgba_time;
+  Frames::ConstPtr frames = estimateFrames<PointXYZ> (cloud, keypoints, radius, frames_time);
+  Frames::ConstPtr frames_rgba = estimateFrames<PointXYZRGBA> (cloud_rgba, keypoints, radius, frames_rgba_time);
+  print_info ("Local reference frames estimated once in "); print_value ("%g", frames_time); print_info (" ms\n");
+
+  typedef SHOTEstimation<PointXYZ, Normal, SHOT> ShapeSHOT;
+  typedef SHOTEstimationOMP<PointXYZ, Normal, SHOT> ShapeSHOTOMP;
+  typedef SHOTEstimation<PointXYZRGBA, Normal, SHOT> ColorSHOT;
+  typedef SHOTEstimationOMP<PointXYZRGBA, Normal, SHOT> ColorSHOTOMP;
+  const Frames::ConstPtr no_frames;
+
+  print_info ("%-26s %12s %12s %12s\n", "estimator", "default LRF", "shared LRF", "speedup");
+
+  const ShapeSHOT shape_shot;
+  printRow ("SHOTEstimation",
+            timeSHOT<ShapeSHOT, PointXYZ> (shape_shot, cloud, normals, keypoints, no_frames, radius, runs),
+            timeSHOT<ShapeSHOT, PointXYZ> (shape_shot, cloud, normals, keypoints, frames, radius, runs));
+
+  const ShapeSHOTOMP shape_shot_omp (threads);
+  printRow ("SHOTEstimationOMP",
+            timeSHOT<ShapeSHOTOMP, PointXYZ> (shape_shot_omp, cloud, normals, keypoints, no_frames, radius, runs),
+            timeSHOT<ShapeSHOTOMP, PointXYZ> (shape_shot_omp, cloud, normals, keypoints, frames, radius, runs));
+
+  const ColorSHOT color_shot (true, true);
+  printRow ("SHOTEstimation (color)",
+            timeSHOT<ColorSHOT, PointXYZRGBA> (color_shot, cloud_rgba, normals, keypoints, no_frames, radius, runs),
+            timeSHOT<ColorSHOT, PointXYZRGBA> (color_shot, cloud_rgba, normals, keypoints, frames_rgba, radius, runs));
+
+  const ColorSHOTOMP color_shot_omp (true, true, threads);
+  printRow ("SHOTEstimationOMP (color)",
+            timeSHOT<ColorSHOTOMP, PointXYZRGBA> (color_shot_omp, cloud_rgba, normals, keypoints, no_frames, radius, runs),
+            timeSHOT<ColorSHOTOMP, PointXYZRGBA> (color_shot_omp, cloud_rgba, normals, keypoints, frames_rgba, radius, runs));
+
+  return (0);
+}
+/* ]--- */